@@ -0,0 +1,106 @@
+/**
+  ******************************************************************************
+  * @file           : dlog.h
+  * @version        : V1.0
+  * @brief          : dlog.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __DLOG_H__
+#define __DLOG_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "stdint.h"
+#include "stddef.h"
+#include "stdarg.h"
+
+/* 延迟格式化日志开关，关闭后DLOG()不产生任何代码 */
+#define DLOG_ENABLED				1U
+/* 单条记录的参数个数上限 */
+#define DLOG_ARG_MAX				4U
+/* DLOG_VPrint单条文本的长度上限，格式化缓冲在调用者的栈上 */
+#define DLOG_TEXT_MAX				128U
+
+/*******************************************************************************/
+/* 记录格式，小端，写入CDC复用器的LOG通道，与usb_printf的文本混合传输          */
+/*-----------------------------------------------------------------------------*/
+/* Offset | Field    | Size | Description                                      */
+/* 0      | Head     |  1   | DLOG_HEAD | 参数个数，不会出现在UTF-8文本中       */
+/* 1      | Id       |  4   | 格式字符串在Flash中的地址                        */
+/* 5      | Tick     |  4   | HAL_GetTick，ms                                  */
+/* 9      | Args     | 4*n  | 参数原值，每个参数4字节                          */
+/*-----------------------------------------------------------------------------*/
+/* 格式字符串只保存在固件中，不上传。主机工具Tools/dlog.py从ELF文件中按符号     */
+/* DLOG_Fmt列出全部格式字符串，并按地址取出字符串渲染文本。                     */
+/* 支持的转换：%d %i %u %x %X %c %f %e %g %s %p %%，可带宽度与精度；           */
+/* %f等浮点参数须用DLOG_FLOAT()传入，%s只能是Flash中的常量字符串。             */
+/*******************************************************************************/
+#define DLOG_HEAD					0xF8U
+#define DLOG_HEAD_MASK				0xF8U
+#define DLOG_HEADER_SIZE			9U
+#define DLOG_RECORD_MAX				(DLOG_HEADER_SIZE + 4U * DLOG_ARG_MAX)
+
+typedef struct
+{
+	uint32_t Records;				/**< 写入的记录数 */
+	uint32_t Dropped;				/**< 队列空间不足丢弃的记录数 */
+}DLOG_StatsTypeDef;
+
+void DLOG_Write(uint32_t id, const uint32_t *args, uint32_t argc);
+uint8_t DLOG_VPrint(const char *format, va_list args);
+void DLOG_GetStats(DLOG_StatsTypeDef *stats);
+
+/**
+  * @brief  DLOG_FloatBits 浮点参数按位转为32位整数，由主机还原
+  */
+static inline uint32_t DLOG_FloatBits(float value)
+{
+	union
+	{
+		float f;
+		uint32_t u;
+	}v;
+
+	v.f = value;
+	return v.u;
+}
+
+#define DLOG_FLOAT(x)				DLOG_FloatBits((float)(x))
+#define DLOG_ARG(x)					((uint32_t)(x))
+
+#if (DLOG_ENABLED == 1U)
+/* 每个调用点定义一个常量格式字符串，其地址即为格式ID，编译期确定 */
+#define DLOG_ID(fmt)				__extension__({ static const char DLOG_Fmt[] = fmt; (uint32_t)(uintptr_t)DLOG_Fmt; })
+
+#define DLOG_0(fmt)					DLOG_Write(DLOG_ID(fmt), NULL, 0U)
+#define DLOG_1(fmt, a)				DLOG_Write(DLOG_ID(fmt), (const uint32_t[]){DLOG_ARG(a)}, 1U)
+#define DLOG_2(fmt, a, b)			DLOG_Write(DLOG_ID(fmt), (const uint32_t[]){DLOG_ARG(a), DLOG_ARG(b)}, 2U)
+#define DLOG_3(fmt, a, b, c)		DLOG_Write(DLOG_ID(fmt), (const uint32_t[]){DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c)}, 3U)
+#define DLOG_4(fmt, a, b, c, d)		DLOG_Write(DLOG_ID(fmt), (const uint32_t[]){DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c), DLOG_ARG(d)}, 4U)
+#define DLOG_SELECT(_0, _1, _2, _3, _4, NAME, ...)	NAME
+
+/* DLOG("格式字符串", 参数...)，格式字符串必须是字面量，参数0~4个 */
+#define DLOG(...)					DLOG_SELECT(__VA_ARGS__, DLOG_4, DLOG_3, DLOG_2, DLOG_1, DLOG_0, 0)(__VA_ARGS__)
+#else
+#define DLOG(...)					((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DLOG_H__ */
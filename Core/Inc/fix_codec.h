@@ -0,0 +1,96 @@
+/**
+  ******************************************************************************
+  * @file           : fix_codec.h
+  * @version        : V1.0
+  * @brief          : fix_codec.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FIX_CODEC_H__
+#define __FIX_CODEC_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "stdint.h"
+
+/* 关键帧间隔，每FIX_KEY_INTERVAL个定位结果以一个关键帧开始 */
+#define FIX_KEY_INTERVAL			16U
+/* 单个定位结果编码后的最大长度：头2字节，8个字段各至多5字节 */
+#define FIX_ENCODED_MAX				42U
+
+/*******************************************************************************/
+/* 编码格式，所有整数为LEB128变长编码，有符号数先做zig-zag变换                 */
+/*-----------------------------------------------------------------------------*/
+/* Header   | bit0为1表示关键帧；bit1~8为差分帧中各字段是否出现的掩码          */
+/* Fields   | 按FIX_FIELD_xxx顺序排列                                          */
+/*-----------------------------------------------------------------------------*/
+/* 关键帧    | 全部字段为原值                                                  */
+/* 差分帧    | 字段为与预测值之差，差为0的字段不出现                            */
+/*             Time、Latitude、Longitude、Altitude按线性外推预测：             */
+/*             上一值 + 上一次的变化量；其余字段预测值为上一值                 */
+/*******************************************************************************/
+#define FIX_FIELD_TIME				0U
+#define FIX_FIELD_LATITUDE			1U
+#define FIX_FIELD_LONGITUDE			2U
+#define FIX_FIELD_ALTITUDE			3U
+#define FIX_FIELD_SPEED				4U
+#define FIX_FIELD_COURSE			5U
+#define FIX_FIELD_HDOP				6U
+#define FIX_FIELD_STATUS			7U		/**< Quality << 8 | Satellites */
+#define FIX_FIELD_NUM				8U
+/* 按线性外推预测的字段数，即前FIX_FIELD_LINEAR个字段 */
+#define FIX_FIELD_LINEAR			4U
+
+#define FIX_HEADER_KEY				0x01U
+
+/* 没有同一历元的RMC时，Speed与Course取此值 */
+#define FIX_INVALID					0xFFFFFFFFUL
+
+/* 一个历元的定位结果，单位与nmea.h的定点数约定相同 */
+typedef struct
+{
+	uint32_t Time;					/**< 当日毫秒数 */
+	int32_t  Latitude;				/**< 1e-7度 */
+	int32_t  Longitude;				/**< 1e-7度 */
+	int32_t  Altitude;				/**< 毫米 */
+	uint32_t Speed;					/**< 0.001节 */
+	uint32_t Course;				/**< 0.01度 */
+	uint16_t Hdop;					/**< 0.01 */
+	uint8_t  Quality;				/**< GGA定位质量 */
+	uint8_t  Satellites;			/**< 参与解算的卫星数 */
+}FIX_RecordTypeDef;
+
+/* 编解码状态，编码端与解码端各持有一份，成员仅供fix_codec.c使用 */
+typedef struct
+{
+	uint32_t Last[FIX_FIELD_NUM];			/**< 上一个定位结果的各字段 */
+	uint32_t Step[FIX_FIELD_LINEAR];		/**< 上一次的变化量 */
+	uint32_t Count;							/**< 自上一个关键帧起的定位结果数 */
+	uint8_t  Synced;						/**< 解码端已收到关键帧 */
+}FIX_CodecTypeDef;
+
+/* 下一个定位结果将编码为关键帧 */
+#define FIX_KEY_DUE(h)				(((h)->Count % FIX_KEY_INTERVAL) == 0U)
+
+void FIX_Reset(FIX_CodecTypeDef *h);
+uint32_t FIX_Encode(FIX_CodecTypeDef *h, const FIX_RecordTypeDef *fix, uint8_t *out);
+uint32_t FIX_Decode(FIX_CodecTypeDef *h, const uint8_t *in, uint32_t len, FIX_RecordTypeDef *fix);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIX_CODEC_H__ */
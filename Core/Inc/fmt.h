@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * @file           : fmt.h
+  * @version        : V1.0
+  * @brief          : fmt.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FMT_H__
+#define __FMT_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "stdint.h"
+#include "stdarg.h"
+
+/*******************************************************************************/
+/* FMT_Print支持的格式说明符，是printf的子集                                   */
+/*-----------------------------------------------------------------------------*/
+/* 转换     | %d %i %u %x %X %c %s %p %%                                       */
+/* 标志     | '-' 左对齐，'0' 补0                                              */
+/* 宽度     | 数字或'*'                                                        */
+/* 精度     | 数字或'*'；整数为最少位数，%s为最多字符数                        */
+/* 长度     | h hh l z 接受并忽略(参数均为32位)                                */
+/*-----------------------------------------------------------------------------*/
+/* 参数类型由FMT_PRINTF_CHECK在编译期按printf规则检查。不支持的转换(%f %e %g  */
+/* %o %ll等)原样输出说明符并取走对应参数，不会错位；定点小数用FMT_Fixed输出。   */
+/*******************************************************************************/
+#if defined(__GNUC__) || defined(__clang__) || defined(__ARMCC_VERSION)
+#define FMT_PRINTF_CHECK(f, a)		__attribute__((format(printf, f, a)))
+#else
+#define FMT_PRINTF_CHECK(f, a)
+#endif
+
+/* 输出位置，可以是线性缓冲，也可以是2的幂大小的环形队列中的一段 */
+typedef struct
+{
+	uint8_t *Buffer;				/**< 存储区 */
+	uint32_t Mask;					/**< 环形队列大小减一，线性缓冲为0xFFFFFFFF */
+	uint32_t Start;					/**< 起始位置，环形队列中为未取模的写位置 */
+	uint32_t Size;					/**< 可写入的字节数 */
+	uint32_t Length;				/**< 已输出的字节数，可超过Size，超出部分未写入 */
+}FMT_WriterTypeDef;
+
+/* 输出超出了可写入的字节数 */
+#define FMT_OVERFLOW(w)				((w)->Length > (w)->Size)
+
+void FMT_Init(FMT_WriterTypeDef *w, uint8_t *buf, uint32_t size);
+void FMT_InitRing(FMT_WriterTypeDef *w, uint8_t *buf, uint32_t mask, uint32_t start, uint32_t size);
+void FMT_Bytes(FMT_WriterTypeDef *w, const void *data, uint32_t len);
+void FMT_Char(FMT_WriterTypeDef *w, char c);
+void FMT_String(FMT_WriterTypeDef *w, const char *s);
+void FMT_Unsigned(FMT_WriterTypeDef *w, uint32_t value);
+void FMT_Signed(FMT_WriterTypeDef *w, int32_t value);
+void FMT_Hex(FMT_WriterTypeDef *w, uint32_t value, uint8_t digits);
+void FMT_Fixed(FMT_WriterTypeDef *w, int32_t value, uint8_t decimals);
+void FMT_VPrint(FMT_WriterTypeDef *w, const char *format, va_list args);
+void FMT_Print(FMT_WriterTypeDef *w, const char *format, ...) FMT_PRINTF_CHECK(2, 3);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FMT_H__ */
@@ -0,0 +1,87 @@
+/**
+  ******************************************************************************
+  * @file           : gnss.h
+  * @version        : V1.0
+  * @brief          : gnss.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __GNSS_H__
+#define __GNSS_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "stdint.h"
+
+/* 帧缓冲大小，必须能容纳最长的一帧 */
+#define GNSS_BUFFER_SIZE			0x800U
+/* NMEA语句长度上限(含'$'与行尾) */
+#define GNSS_NMEA_MAX_LENGTH		120U
+/* UBX负载长度上限，超过的长度字段视为误同步 */
+#define GNSS_UBX_MAX_PAYLOAD		0x400U
+/* RTCM3负载长度由10位字段给出，最大1023 */
+#define GNSS_RTCM_MAX_PAYLOAD		0x3FFU
+
+#define GNSS_UBX_SYNC1				0xB5U
+#define GNSS_UBX_SYNC2				0x62U
+#define GNSS_RTCM_PREAMBLE			0xD3U
+
+/* 协议编号，用于统计 */
+#define GNSS_PROTOCOL_NMEA			0U
+#define GNSS_PROTOCOL_UBX			1U
+#define GNSS_PROTOCOL_RTCM			2U
+#define GNSS_PROTOCOL_NUM			3U
+
+#if ((8U + GNSS_UBX_MAX_PAYLOAD) > GNSS_BUFFER_SIZE) || ((6U + GNSS_RTCM_MAX_PAYLOAD) > GNSS_BUFFER_SIZE)
+#error "GNSS_BUFFER_SIZE must hold the longest UBX and RTCM3 frame"
+#endif
+
+/* 各协议的帧消费者，回调中的指针指向解复用器内部缓冲，回调返回后失效 */
+typedef struct
+{
+	void (* Nmea)(const uint8_t *frame, uint32_t len);								/**< 完整语句，含'$'与行尾 */
+	void (* Ubx)(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len);	/**< UBX负载，不含帧头与校验 */
+	void (* Rtcm)(uint16_t type, const uint8_t *frame, uint32_t len);				/**< 完整RTCM3帧，含帧头与CRC */
+}GNSS_ItfTypeDef;
+
+typedef struct
+{
+	uint32_t Frames[GNSS_PROTOCOL_NUM];			/**< 校验通过并分发的帧数 */
+	uint32_t Errors[GNSS_PROTOCOL_NUM];			/**< 校验错误或格式错误 */
+	uint32_t Garbage;							/**< 不属于任何帧而被跳过的字节数 */
+}GNSS_StatsTypeDef;
+
+/* 解复用器状态，成员仅供gnss.c使用 */
+typedef struct
+{
+	const GNSS_ItfTypeDef *Itf;
+	uint8_t  Buffer[GNSS_BUFFER_SIZE];
+	uint32_t Start;								/**< 当前候选帧的起点 */
+	uint32_t Length;							/**< 缓冲中的有效数据量 */
+	uint32_t Scan;								/**< NMEA语句已检查到的位置，相对Start */
+	GNSS_StatsTypeDef Stats;
+}GNSS_DemuxTypeDef;
+
+void GNSS_Init(GNSS_DemuxTypeDef *h, const GNSS_ItfTypeDef *itf);
+void GNSS_Input(GNSS_DemuxTypeDef *h, const uint8_t *buf, uint32_t len);
+void GNSS_GetStats(const GNSS_DemuxTypeDef *h, GNSS_StatsTypeDef *stats);
+uint32_t GNSS_Crc24q(const uint8_t *buf, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __GNSS_H__ */
@@ -0,0 +1,155 @@
+/**
+  ******************************************************************************
+  * @file           : logger.h
+  * @version        : V1.0
+  * @brief          : logger.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LOGGER_H__
+#define __LOGGER_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "stdint.h"
+
+/* 记录队列大小，必须为2的幂 */
+#define LOGGER_QUEUE_SIZE			0x4000U
+/* 单次f_write的数据量，取簇大小的整数倍，必须为扇区大小的整数倍 */
+#define LOGGER_WRITE_SIZE			0x8000U
+/* 每个文件预分配的空间，写满后切换到下一个文件 */
+#define LOGGER_FILE_SIZE			(64UL * 1024UL * 1024UL)
+/* 预分配失败时逐次减半，不小于此值 */
+#define LOGGER_FILE_SIZE_MIN		(1UL * 1024UL * 1024UL)
+/* 文件最长记录时间，ms，0表示只按大小切换 */
+#define LOGGER_ROTATE_MS			(60UL * 60UL * 1000UL)
+/* 两次f_sync的最大间隔，ms，即掉电时最多丢失的数据时长 */
+#define LOGGER_SYNC_MS				1000UL
+/* 同步或按时切换文件前等待生产者交出暂存数据的最长时间，ms */
+#define LOGGER_FLUSH_WAIT_MS		20UL
+/* 卡不存在或挂载失败时的重试间隔，ms */
+#define LOGGER_RETRY_MS				1000UL
+/* 快速定位使用的簇链映射表大小(DWORD)，预分配的文件只需4项 */
+#define LOGGER_LINKMAP_SIZE			32U
+/* 区间查询的读缓冲，必须能容纳最长的记录 */
+#define LOGGER_QUERY_BUF_SIZE		0x800U
+/* 区间查询每轮任务循环最多读取的次数，与记录写入交替进行 */
+#define LOGGER_QUERY_BURST			4U
+/* 卡交给MSC期间记录任务检查收回请求的间隔，ms */
+#define LOGGER_RELEASE_POLL_MS		10UL
+
+/* 单条记录负载长度上限，能容纳最长的RTCM3帧(1029字节)与UBX负载加Class、ID */
+#define LOGGER_RECORD_MAX			0x408U
+#define LOGGER_HEADER_SIZE			8U
+
+#if (LOGGER_QUEUE_SIZE & (LOGGER_QUEUE_SIZE - 1U)) != 0U
+#error "LOGGER_QUEUE_SIZE must be a power of 2"
+#endif
+#if (LOGGER_QUERY_BUF_SIZE < (LOGGER_HEADER_SIZE + LOGGER_RECORD_MAX))
+#error "LOGGER_QUERY_BUF_SIZE must hold the longest record"
+#endif
+#if (LOGGER_WRITE_SIZE % 512U) != 0U
+#error "LOGGER_WRITE_SIZE must be a multiple of the sector size"
+#endif
+
+/*******************************************************************************/
+/* 文件中的记录格式，小端                                                      */
+/*-----------------------------------------------------------------------------*/
+/* Offset | Field    | Size | Description                                      */
+/* 0      | Sync     |  1   | LOGGER_SYNC                                      */
+/* 1      | Type     |  1   | LOGGER_TYPE_xxx                                  */
+/* 2      | Length   |  2   | 负载长度                                         */
+/* 4      | Tick     |  4   | 写入队列时的系统节拍，ms                         */
+/* 8      | Payload  |  N   |                                                  */
+/*-----------------------------------------------------------------------------*/
+/* 记录不跨越LOGGER_WRITE_SIZE块，放不下时用0x00补齐到块尾；同步时用0x00      */
+/* 补齐到扇区边界。读取时跳过记录之间的0x00。                                  */
+/* 每个有数据的块都以INDEX记录开始，其Tick为块内第一条记录的Tick，按块二分     */
+/* 查找即可定位时间点。文件预分配，掉电后文件长度为预分配大小，文件序号或块号  */
+/* 与位置不符的INDEX记录、以及非0x00非Sync的字节处即为数据结尾。              */
+/*******************************************************************************/
+#define LOGGER_SYNC					0xA5U
+
+#define LOGGER_TYPE_NMEA			0x01U		/**< NMEA语句原文 */
+#define LOGGER_TYPE_UBX				0x02U		/**< UBX负载，前两字节为Class与ID */
+#define LOGGER_TYPE_RTCM			0x03U		/**< 完整RTCM3帧 */
+#define LOGGER_TYPE_FIX				0x04U		/**< 定位结果编码块，以关键帧开始，格式见fix_codec.h */
+#define LOGGER_TYPE_END				0x7EU		/**< 查询结束，只出现在查询输出中 */
+#define LOGGER_TYPE_INDEX			0x7FU		/**< 块索引 */
+
+/* INDEX记录负载：File LE32 文件序号，Block LE32 块号(文件偏移/LOGGER_WRITE_SIZE) */
+#define LOGGER_INDEX_SIZE			8U
+
+/*******************************************************************************/
+/* 区间查询命令，经CDC0的SEND_ENCAPSULATED_COMMAND下发，小端                   */
+/* 操作码与nmea_filter.h中的过滤器命令共用编号空间                             */
+/*-----------------------------------------------------------------------------*/
+/* Offset | Field    | Size | Description                                      */
+/* 0      | Op       |  1   | LOGGER_OP_xxx                                    */
+/* 1      | File     |  4   | 文件序号，0表示当前正在记录的文件                */
+/* 5      | Start    |  4   | 起始Tick，含                                     */
+/* 9      | Stop     |  4   | 结束Tick，含                                     */
+/*-----------------------------------------------------------------------------*/
+/* 结果按文件中的记录格式经输出函数送出，不含INDEX记录，最后是一条END记录：    */
+/* Status(1) Reserved(3) Records LE32 查询到的记录数                           */
+/*******************************************************************************/
+#define LOGGER_OP_QUERY				0x10U		/**< 开始查询，进行中的查询被中止 */
+#define LOGGER_OP_ABORT				0x11U		/**< 中止查询 */
+#define LOGGER_CMD_SIZE				13U
+
+#define LOGGER_QUERY_OK				0x00U
+#define LOGGER_QUERY_NO_FILE		0x01U		/**< 文件不存在或卡未挂载 */
+#define LOGGER_QUERY_ERROR			0x02U		/**< 读取出错 */
+#define LOGGER_QUERY_ABORTED		0x03U
+#define LOGGER_END_SIZE				8U
+
+/* 查询结果的输出函数，全部写入返回0，空间不足返回非0，稍后以相同数据重试 */
+typedef uint8_t (* LOGGER_OutputTypeDef)(const uint8_t *buf, uint32_t len);
+
+typedef struct
+{
+	uint32_t Records;				/**< 写入队列的记录数 */
+	uint32_t Dropped;				/**< 队列满而丢弃的记录数 */
+	uint32_t QueueDepth;			/**< 当前队列中的字节数 */
+	uint32_t QueuePeak;				/**< 队列深度的最大值 */
+	uint32_t BytesWritten;			/**< 写入卡的总字节数，含填充 */
+	uint32_t Throughput;			/**< 最近一个同步周期的写入速度，B/s */
+	uint32_t WriteTime;				/**< f_write与f_sync累计耗时，ms */
+	uint32_t WriteErrors;			/**< FatFs返回错误的次数 */
+	uint32_t Files;					/**< 已创建的文件数 */
+	uint32_t FileIndex;				/**< 当前文件序号 */
+	uint32_t Queries;				/**< 完成的查询数 */
+	uint32_t QueryRecords;			/**< 查询送出的记录数 */
+}LOGGER_StatsTypeDef;
+
+void Logger_Init(LOGGER_OutputTypeDef output);
+uint8_t Logger_Write(uint8_t type, const void *data, uint16_t len);
+uint8_t Logger_WritePrefix(uint8_t type, const void *prefix, uint16_t plen, const void *data, uint16_t len);
+uint32_t Logger_FlushRequest(void);
+void Logger_FlushDone(uint32_t request);
+void Logger_Task(void);
+void Logger_GetStats(LOGGER_StatsTypeDef *stats);
+uint8_t Logger_Command(const uint8_t *buf, uint16_t len);
+void Logger_Release(uint8_t release);
+uint8_t Logger_CardFree(void);
+uint8_t Logger_CardBegin(void);
+void Logger_CardEnd(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LOGGER_H__ */
@@ -46,7 +46,15 @@ extern "C" {
 
 /* Exported macro ------------------------------------------------------------*/
 /* USER CODE BEGIN EM */
-
+/* DMA缓冲的位置检查
+ * ITCM与DTCM只连接到CPU，SDMMC1的IDMA、DMA1/2与OTG_HS的内部DMA都访问不到，放在其中的
+ * 缓冲传输时不报错，只是读写了别处的内存。工程没有为DMA缓冲单独划分链接区域，RW区被
+ * 分配到DTCM时就会出现这种情况，因此直接交给DMA的缓冲在初始化或启动传输前用此宏检查。 */
+#define DMA_ITCM_END				0x00010000UL
+#define DMA_DTCM_BASE				0x20000000UL
+#define DMA_DTCM_END				0x20020000UL
+#define DMA_BUFFER_OK(p)			(((uint32_t)(p) >= DMA_ITCM_END) && \
+									 (((uint32_t)(p) < DMA_DTCM_BASE) || ((uint32_t)(p) >= DMA_DTCM_END)))
 /* USER CODE END EM */
 
 /* Exported functions prototypes ---------------------------------------------*/
@@ -0,0 +1,159 @@
+/**
+  ******************************************************************************
+  * @file           : nmea.h
+  * @version        : V1.0
+  * @brief          : nmea.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __NMEA_H__
+#define __NMEA_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "stdint.h"
+
+/* 单条语句长度上限(含'$'与校验)，标准为82，留出部分接收机的扩展余量 */
+#define NMEA_MAX_LENGTH				120U
+/* 每条GSV语句最多携带的卫星数 */
+#define NMEA_GSV_SAT_MAX			4U
+
+/* 语句类型 */
+#define NMEA_TYPE_UNKNOWN			0U
+#define NMEA_TYPE_GGA				1U
+#define NMEA_TYPE_RMC				2U
+#define NMEA_TYPE_GSV				3U
+#define NMEA_TYPE_VTG				4U
+
+/*******************************************************************************/
+/* 定点数约定，全部为整数，不使用浮点                                          */
+/*-----------------------------------------------------------------------------*/
+/* Time        | 当日毫秒数                                                    */
+/* Latitude    | 1e-7度，北正南负                                              */
+/* Longitude   | 1e-7度，东正西负                                              */
+/* Altitude    | 毫米                                                          */
+/* Speed       | 0.001节；SpeedKmh为0.001千米每小时                            */
+/* Course      | 0.01度                                                        */
+/* Hdop        | 0.01                                                          */
+/*******************************************************************************/
+
+typedef struct
+{
+	uint32_t Time;
+	int32_t  Latitude;
+	int32_t  Longitude;
+	uint8_t  Quality;			/**< 定位质量，0为无效 */
+	uint8_t  Satellites;		/**< 参与解算的卫星数 */
+	uint16_t Hdop;
+	int32_t  Altitude;			/**< 海拔高度 */
+	int32_t  GeoidSep;			/**< 大地水准面差距 */
+}NMEA_GGATypeDef;
+
+typedef struct
+{
+	uint32_t Time;
+	uint8_t  Valid;				/**< 状态为'A'时为1 */
+	uint8_t  Day;
+	uint8_t  Month;
+	uint8_t  Year;				/**< 两位年份 */
+	int32_t  Latitude;
+	int32_t  Longitude;
+	uint32_t Speed;
+	uint32_t Course;
+	uint8_t  Mode;				/**< 模式指示字符，无此字段时为0 */
+}NMEA_RMCTypeDef;
+
+typedef struct
+{
+	uint8_t  Prn;
+	int8_t   Elevation;			/**< 仰角，度 */
+	uint16_t Azimuth;			/**< 方位角，度 */
+	uint8_t  Snr;				/**< 载噪比dB-Hz，未跟踪时为0 */
+}NMEA_SatelliteTypeDef;
+
+typedef struct
+{
+	uint8_t  Total;				/**< 本组语句总数 */
+	uint8_t  Index;				/**< 本条语句序号，从1开始 */
+	uint8_t  InView;			/**< 可见卫星总数 */
+	uint8_t  Count;				/**< 本条语句携带的卫星数 */
+	uint8_t  SignalId;			/**< NMEA 4.10信号编号，无此字段时为0 */
+	NMEA_SatelliteTypeDef Sat[NMEA_GSV_SAT_MAX];
+}NMEA_GSVTypeDef;
+
+typedef struct
+{
+	uint32_t Course;			/**< 真北航向 */
+	uint32_t Speed;
+	uint32_t SpeedKmh;
+	uint8_t  Mode;
+}NMEA_VTGTypeDef;
+
+/* 解码得到的语句 */
+typedef struct
+{
+	uint8_t  Type;				/**< NMEA_TYPE_xxx */
+	char     Talker[2];			/**< 发送者标识，如"GP"、"GN" */
+	uint8_t  Fields;			/**< 地址之后的字段数 */
+	uint32_t Present;			/**< 第n位为1表示第n个字段非空 */
+	union
+	{
+		NMEA_GGATypeDef Gga;
+		NMEA_RMCTypeDef Rmc;
+		NMEA_GSVTypeDef Gsv;
+		NMEA_VTGTypeDef Vtg;
+	};
+}NMEA_SentenceTypeDef;
+
+typedef struct
+{
+	uint32_t Sentences;			/**< 校验通过的语句数 */
+	uint32_t Unknown;			/**< 其中未识别类型的语句数 */
+	uint32_t ChecksumErrors;	/**< 校验错误 */
+	uint32_t FormatErrors;		/**< 非法字符、超长或语句被截断 */
+}NMEA_StatsTypeDef;
+
+/* 语句回调，在NMEA_Input的调用者上下文中执行 */
+typedef void (* NMEA_CallbackTypeDef)(const NMEA_SentenceTypeDef *sentence);
+
+/* 解码器状态，成员仅供nmea.c使用 */
+typedef struct
+{
+	NMEA_CallbackTypeDef Callback;
+	NMEA_SentenceTypeDef Sentence;		/**< 正在解码的语句 */
+	uint32_t Value;						/**< 当前字段的数字，不含小数点 */
+	uint8_t  State;
+	uint8_t  Checksum;					/**< 逐字节累计的异或校验 */
+	uint8_t  Expected;					/**< '*'之后收到的校验值 */
+	uint8_t  Length;					/**< 已收到的语句长度 */
+	uint8_t  Field;						/**< 当前字段序号，0为地址字段 */
+	uint8_t  FieldLength;
+	uint8_t  FracDigits;				/**< 小数位数 */
+	uint8_t  Flags;
+	uint8_t  First;						/**< 字段首字符 */
+	char     Address[5];
+	NMEA_StatsTypeDef Stats;
+}NMEA_DecoderTypeDef;
+
+void NMEA_Init(NMEA_DecoderTypeDef *h, NMEA_CallbackTypeDef callback);
+uint32_t NMEA_Input(NMEA_DecoderTypeDef *h, const uint8_t *buf, uint32_t len);
+void NMEA_GetStats(const NMEA_DecoderTypeDef *h, NMEA_StatsTypeDef *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __NMEA_H__ */
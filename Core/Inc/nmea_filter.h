@@ -0,0 +1,113 @@
+/**
+  ******************************************************************************
+  * @file           : nmea_filter.h
+  * @version        : V1.0
+  * @brief          : nmea_filter.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __NMEA_FILTER_H__
+#define __NMEA_FILTER_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "stdint.h"
+
+/* 规则数量上限与散列索引大小，索引大小必须为2的幂且不小于规则数的两倍 */
+#define NMEA_FILTER_RULE_MAX		16U
+#define NMEA_FILTER_HASH_BITS		5U
+#define NMEA_FILTER_HASH_SIZE		(1U << NMEA_FILTER_HASH_BITS)
+/* 等待任务应用的配置命令数 */
+#define NMEA_FILTER_CMD_QUEUE		4U
+
+/* 规则中的通配字符，"**"匹配任意发送者，"***"匹配任意语句类型 */
+#define NMEA_FILTER_WILDCARD		'*'
+
+#define NMEA_FILTER_ALLOW			0U
+#define NMEA_FILTER_DENY			1U
+
+#define NMEA_FILTER_FLAG_ON_CHANGE	0x01U		/**< 语句内容与上一条相同则不转发 */
+
+/*******************************************************************************/
+/* 配置命令，经CDC0的SEND_ENCAPSULATED_COMMAND下发                              */
+/*-----------------------------------------------------------------------------*/
+/* Offset | Field    | Size | Description                                      */
+/* 0      | Op       |  1   | NMEA_FILTER_OP_xxx                               */
+/* 1      | Talker   |  2   | 发送者标识，SET/DELETE使用                        */
+/* 3      | Type     |  3   | 语句类型，SET/DELETE使用                          */
+/* 6      | Action   |  1   | ALLOW/DENY，SET与DEFAULT使用                      */
+/* 7      | Flags    |  1   | NMEA_FILTER_FLAG_xxx，SET使用                     */
+/* 8      | Decimate |  2   | 每N条转发1条，0与1表示不抽取，小端，SET使用       */
+/* 1      | Index    |  1   | SELECT使用，0xFF表示汇总                          */
+/*******************************************************************************/
+#define NMEA_FILTER_OP_SET			0x01U		/**< 新增或修改规则 */
+#define NMEA_FILTER_OP_DELETE		0x02U		/**< 删除规则 */
+#define NMEA_FILTER_OP_CLEAR		0x03U		/**< 删除全部规则 */
+#define NMEA_FILTER_OP_DEFAULT		0x04U		/**< 设置无规则匹配时的动作 */
+#define NMEA_FILTER_OP_RESET		0x05U		/**< 清零计数 */
+#define NMEA_FILTER_OP_SELECT		0x06U		/**< 选择GET_ENCAPSULATED_RESPONSE返回的规则 */
+/* 0x10及以上的操作码为SD卡记录查询命令，见logger.h */
+
+#define NMEA_FILTER_SELECT_TOTAL	0xFFU
+
+/*******************************************************************************/
+/* GET_ENCAPSULATED_RESPONSE返回内容，共NMEA_FILTER_RESPONSE_SIZE字节，小端    */
+/*-----------------------------------------------------------------------------*/
+/* Offset | Field     | Size | Description                                     */
+/* 0      | Rules     |  1   | 当前规则数                                      */
+/* 1      | Select    |  1   | 所选规则序号，0xFF为汇总                        */
+/* 2      | Default   |  1   | 无规则匹配时的动作                              */
+/* 3      | Reserved  |  1   |                                                 */
+/* 4      | Passed    |  4   | 转发的语句数                                    */
+/* 8      | Denied    |  4   | 被拒绝的语句数                                  */
+/* 12     | Decimated |  4   | 被抽取丢弃的语句数                              */
+/* 16     | Unchanged |  4   | 内容未变化被丢弃的语句数                        */
+/* 20     | Rule      |  9   | 所选规则，格式同命令的1~9字节，汇总时为0        */
+/*******************************************************************************/
+#define NMEA_FILTER_RESPONSE_SIZE	29U
+
+typedef struct
+{
+	char     Talker[2];
+	char     Type[3];
+	uint8_t  Action;
+	uint8_t  Flags;
+	uint16_t Decimate;
+}NMEA_FilterRuleTypeDef;
+
+typedef struct
+{
+	uint32_t Passed;
+	uint32_t Denied;
+	uint32_t Decimated;
+	uint32_t Unchanged;
+}NMEA_FilterCountTypeDef;
+
+void NMEA_Filter_Init(void);
+uint8_t NMEA_Filter_Check(const uint8_t *frame, uint32_t len);
+uint8_t NMEA_Filter_SetRule(const NMEA_FilterRuleTypeDef *rule);
+uint8_t NMEA_Filter_DeleteRule(const char *talker, const char *type);
+void NMEA_Filter_Clear(void);
+void NMEA_Filter_SetDefault(uint8_t action);
+void NMEA_Filter_GetCount(NMEA_FilterCountTypeDef *count);
+uint8_t NMEA_Filter_Command(const uint8_t *buf, uint16_t len);
+void NMEA_Filter_Response(uint8_t *buf, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __NMEA_FILTER_H__ */
@@ -0,0 +1,43 @@
+/**
+  ******************************************************************************
+  * @file           : scan.h
+  * @version        : V1.0
+  * @brief          : scan.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SCAN_H__
+#define __SCAN_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "stdint.h"
+
+/* 可打印ASCII的范围，SCAN_Text在此范围之外停止 */
+#define SCAN_TEXT_MIN				0x20U
+#define SCAN_TEXT_MAX				0x7EU
+
+uint32_t SCAN_Byte(const uint8_t *buf, uint32_t len, uint8_t c);
+uint32_t SCAN_Byte3(const uint8_t *buf, uint32_t len, uint8_t a, uint8_t b, uint8_t c);
+uint32_t SCAN_Text(const uint8_t *buf, uint32_t len, uint8_t stop);
+uint8_t SCAN_Xor(const uint8_t *buf, uint32_t len);
+uint16_t SCAN_Fletcher(const uint8_t *buf, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SCAN_H__ */
@@ -0,0 +1,136 @@
+/**
+  ******************************************************************************
+  * @file           : dlog.c
+  * @version        : V1.0
+  * @brief          : 延迟格式化日志
+  *                   - 调用点只写入格式ID与参数原值，文本由主机端渲染
+  *                   - 不使用RTOS接口，可在USB中断等任意上下文调用
+  *                   - 记录经CDC复用器的LOG通道发送
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                设计说明
+  *          ===================================================================
+  *           usb_printf要在设备端格式化，且发送的是冗长的ASCII文本。
+  *           DLOG()只拷贝至多25字节的记录，
+  *           格式字符串留在Flash中，主机用固件的ELF文件还原文本。
+  *
+  *           LOG通道的发送队列由CDC复用器在USB中断中消费，本身无锁；写入端
+  *           有任务与USB中断等多个生产者，而USB中断优先级高于
+  *           configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY，不能用RTOS的
+  *           互斥量，因此写入一条记录时短暂关中断，保证记录完整且不交错。
+  *           usb_printf的文本也经DLOG_VPrint()写入，LOG通道只有这一个写入点。
+  *
+  *           队列满时整条记录丢弃并计数，调用者从不等待。
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "dlog.h"
+#include "fmt.h"
+#include "usbd_cdc_mux.h"
+#include "usbd_composite_if.h"
+#include "main.h"
+#include "string.h"
+
+/* Variables -----------------------------------------------------------------*/
+static DLOG_StatsTypeDef DLOG_Stats;
+
+/* ------------------------------------ DLOG Funtion ------------------------------------ */
+
+/**
+  * @brief  DLOG_Write 写入一条日志记录，通常经DLOG()宏调用
+  * @param  id: 格式ID
+  * @param  args: 参数
+  * @param  argc: 参数个数，不超过DLOG_ARG_MAX
+  */
+void DLOG_Write(uint32_t id, const uint32_t *args, uint32_t argc)
+{
+#if (CDC_MUX_ENABLED == 1U)
+	uint8_t record[DLOG_RECORD_MAX];
+	uint32_t tick = HAL_GetTick();
+	uint32_t primask;
+	uint8_t result;
+
+	if(argc > DLOG_ARG_MAX)
+		argc = DLOG_ARG_MAX;
+	record[0] = (uint8_t)(DLOG_HEAD | argc);
+	memcpy(&record[1], &id, 4U);
+	memcpy(&record[5], &tick, 4U);
+	if(argc != 0U)
+		memcpy(&record[DLOG_HEADER_SIZE], args, 4U * argc);
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	result = CDC_MUX_Write(CDC_MUX_CH_LOG, record, DLOG_HEADER_SIZE + 4U * argc);
+	if(result == USBD_OK)
+		DLOG_Stats.Records++;
+	else
+		DLOG_Stats.Dropped++;
+	__set_PRIMASK(primask);
+#else
+	/* 没有复用帧时二进制记录会与其他数据混在一起，主机无法区分，直接丢弃 */
+	UNUSED(id);
+	UNUSED(args);
+	UNUSED(argc);
+	DLOG_Stats.Dropped++;
+#endif
+}
+
+/**
+  * @brief  DLOG_VPrint 格式化文本写入LOG通道，供usb_printf使用
+  * @note   先在开中断时格式化到栈上的缓冲，再与DLOG_Write一样关中断写入，
+  *         关中断时间只有一次拷贝。超过DLOG_TEXT_MAX或队列放不下整条文本时
+  *         丢弃，不会输出半行。
+  * @param  format: 格式字符串，支持的说明符见fmt.h
+  * @param  args: 参数
+  * @retval USBD_OK，队列空间不足返回USBD_BUSY，文本过长返回USBD_FAIL
+  */
+uint8_t DLOG_VPrint(const char *format, va_list args)
+{
+#if (CDC_MUX_ENABLED == 1U)
+	uint8_t text[DLOG_TEXT_MAX];
+	FMT_WriterTypeDef writer;
+	uint32_t primask;
+	uint8_t result;
+
+	FMT_Init(&writer, text, sizeof(text));
+	FMT_VPrint(&writer, format, args);
+
+	if(FMT_OVERFLOW(&writer))
+		return USBD_FAIL;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	result = CDC_MUX_Write(CDC_MUX_CH_LOG, text, writer.Length);
+	__set_PRIMASK(primask);
+
+	return result;
+#else
+	UNUSED(format);
+	UNUSED(args);
+	return USBD_FAIL;
+#endif
+}
+
+/**
+  * @brief  DLOG_GetStats 获取日志统计
+  */
+void DLOG_GetStats(DLOG_StatsTypeDef *stats)
+{
+	*stats = DLOG_Stats;
+}
@@ -0,0 +1,246 @@
+/**
+  ******************************************************************************
+  * @file           : fix_codec.c
+  * @version        : V1.0
+  * @brief          : 定位结果的差分变长编码
+  *                   - 相邻历元的字段做差分或线性外推，残差用zig-zag变长编码
+  *                   - 周期性插入关键帧，从任一关键帧开始都能独立解码
+  *                   - 不依赖HAL与RTOS，同一文件可在主机端编译用于解码
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                压缩效果
+  *          ===================================================================
+  *           静止或匀速运动时，时间与经纬度的线性外推残差为0或个位数，差分帧
+  *           通常只有2~6字节；一个历元的GGA与RMC语句约150字节。
+  *           所有字段都按32位无符号数运算，差值溢出时按模2^32回绕，编码与
+  *           解码结果一致。
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "fix_codec.h"
+#include "string.h"
+
+/* ------------------------------------ Varint Funtion ------------------------------------ */
+
+/**
+  * @brief  FIX_PutVarint 写入LEB128变长整数
+  * @retval 写入的字节数
+  */
+static uint32_t FIX_PutVarint(uint8_t *out, uint32_t value)
+{
+	uint32_t n = 0U;
+
+	while(value >= 0x80U)
+	{
+		out[n++] = (uint8_t)(value | 0x80U);
+		value >>= 7;
+	}
+	out[n++] = (uint8_t)value;
+
+	return n;
+}
+
+/**
+  * @brief  FIX_GetVarint 读取LEB128变长整数
+  * @retval 读取的字节数，数据不完整或超过5字节返回0
+  */
+static uint32_t FIX_GetVarint(const uint8_t *in, uint32_t len, uint32_t *value)
+{
+	uint32_t n, v = 0U;
+
+	for(n = 0U; (n < len) && (n < 5U); n++)
+	{
+		v |= (uint32_t)(in[n] & 0x7FU) << (7U * n);
+		if((in[n] & 0x80U) == 0U)
+		{
+			*value = v;
+			return n + 1U;
+		}
+	}
+
+	return 0U;
+}
+
+/**
+  * @brief  FIX_ZigZag 有符号差值映射为无符号数，绝对值小的差值编码短
+  */
+static uint32_t FIX_ZigZag(uint32_t value)
+{
+	return (value << 1) ^ (0U - (value >> 31));
+}
+
+/**
+  * @brief  FIX_UnZigZag FIX_ZigZag的逆变换
+  */
+static uint32_t FIX_UnZigZag(uint32_t value)
+{
+	return (value >> 1) ^ (0U - (value & 1U));
+}
+
+/* ------------------------------------ Codec Funtion ------------------------------------ */
+
+/**
+  * @brief  FIX_Split 定位结果拆成字段数组
+  */
+static void FIX_Split(const FIX_RecordTypeDef *fix, uint32_t *field)
+{
+	field[FIX_FIELD_TIME] = fix->Time;
+	field[FIX_FIELD_LATITUDE] = (uint32_t)fix->Latitude;
+	field[FIX_FIELD_LONGITUDE] = (uint32_t)fix->Longitude;
+	field[FIX_FIELD_ALTITUDE] = (uint32_t)fix->Altitude;
+	field[FIX_FIELD_SPEED] = fix->Speed;
+	field[FIX_FIELD_COURSE] = fix->Course;
+	field[FIX_FIELD_HDOP] = fix->Hdop;
+	field[FIX_FIELD_STATUS] = ((uint32_t)fix->Quality << 8) | fix->Satellites;
+}
+
+/**
+  * @brief  FIX_Merge 字段数组合成定位结果
+  */
+static void FIX_Merge(const uint32_t *field, FIX_RecordTypeDef *fix)
+{
+	fix->Time = field[FIX_FIELD_TIME];
+	fix->Latitude = (int32_t)field[FIX_FIELD_LATITUDE];
+	fix->Longitude = (int32_t)field[FIX_FIELD_LONGITUDE];
+	fix->Altitude = (int32_t)field[FIX_FIELD_ALTITUDE];
+	fix->Speed = field[FIX_FIELD_SPEED];
+	fix->Course = field[FIX_FIELD_COURSE];
+	fix->Hdop = (uint16_t)field[FIX_FIELD_HDOP];
+	fix->Quality = (uint8_t)(field[FIX_FIELD_STATUS] >> 8);
+	fix->Satellites = (uint8_t)field[FIX_FIELD_STATUS];
+}
+
+/**
+  * @brief  FIX_Predict 字段的预测值
+  */
+static uint32_t FIX_Predict(const FIX_CodecTypeDef *h, uint32_t i)
+{
+	if(i < FIX_FIELD_LINEAR)
+		return h->Last[i] + h->Step[i];
+	return h->Last[i];
+}
+
+/**
+  * @brief  FIX_Update 以新的字段值更新预测状态
+  */
+static void FIX_Update(FIX_CodecTypeDef *h, const uint32_t *field, uint8_t key)
+{
+	uint32_t i;
+
+	for(i = 0U; i < FIX_FIELD_LINEAR; i++)
+		h->Step[i] = (key != 0U) ? 0U : field[i] - h->Last[i];
+	memcpy(h->Last, field, sizeof(h->Last));
+	h->Count++;
+}
+
+/**
+  * @brief  FIX_Reset 复位编解码状态，编码端的下一个定位结果为关键帧
+  */
+void FIX_Reset(FIX_CodecTypeDef *h)
+{
+	memset(h, 0, sizeof(FIX_CodecTypeDef));
+}
+
+/**
+  * @brief  FIX_Encode 编码一个定位结果
+  * @param  h: 编码状态
+  * @param  fix: 定位结果
+  * @param  out: 输出，至少FIX_ENCODED_MAX字节
+  * @retval 编码长度
+  */
+uint32_t FIX_Encode(FIX_CodecTypeDef *h, const FIX_RecordTypeDef *fix, uint8_t *out)
+{
+	uint32_t field[FIX_FIELD_NUM];
+	uint32_t residual[FIX_FIELD_NUM];
+	uint32_t i, n, mask = 0U;
+	uint8_t key = FIX_KEY_DUE(h) ? 1U : 0U;
+
+	FIX_Split(fix, field);
+
+	if(key != 0U)
+	{
+		n = FIX_PutVarint(out, FIX_HEADER_KEY);
+		for(i = 0U; i < FIX_FIELD_NUM; i++)
+			n += FIX_PutVarint(&out[n], FIX_ZigZag(field[i]));
+	}
+	else
+	{
+		for(i = 0U; i < FIX_FIELD_NUM; i++)
+		{
+			residual[i] = FIX_ZigZag(field[i] - FIX_Predict(h, i));
+			if(residual[i] != 0U)
+				mask |= 1UL << i;
+		}
+		n = FIX_PutVarint(out, mask << 1);
+		for(i = 0U; i < FIX_FIELD_NUM; i++)
+		{
+			if(residual[i] != 0U)
+				n += FIX_PutVarint(&out[n], residual[i]);
+		}
+	}
+
+	FIX_Update(h, field, key);
+
+	return n;
+}
+
+/**
+  * @brief  FIX_Decode 解码一个定位结果
+  * @note   收到第一个关键帧之前的差分帧无法解码，返回0。
+  * @param  h: 解码状态
+  * @param  in: 编码数据
+  * @param  len: 可用数据长度
+  * @param  fix: 输出的定位结果
+  * @retval 消耗的字节数，数据不完整或无法解码返回0
+  */
+uint32_t FIX_Decode(FIX_CodecTypeDef *h, const uint8_t *in, uint32_t len, FIX_RecordTypeDef *fix)
+{
+	uint32_t field[FIX_FIELD_NUM];
+	uint32_t header, value, i, n, used;
+	uint8_t key;
+
+	n = FIX_GetVarint(in, len, &header);
+	if((n == 0U) || (header > 0x1FFU))
+		return 0U;
+	key = (uint8_t)(header & FIX_HEADER_KEY);
+	if((key == 0U) && (h->Synced == 0U))
+		return 0U;
+
+	for(i = 0U; i < FIX_FIELD_NUM; i++)
+	{
+		value = 0U;
+		if((key != 0U) || ((header & (2UL << i)) != 0U))
+		{
+			used = FIX_GetVarint(&in[n], len - n, &value);
+			if(used == 0U)
+				return 0U;
+			n += used;
+			value = FIX_UnZigZag(value);
+		}
+		field[i] = (key != 0U) ? value : FIX_Predict(h, i) + value;
+	}
+
+	if(key != 0U)
+		h->Count = 0U;
+	h->Synced = 1U;
+	FIX_Update(h, field, key);
+	FIX_Merge(field, fix);
+
+	return n;
+}
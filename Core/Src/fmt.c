@@ -0,0 +1,527 @@
+/**
+  ******************************************************************************
+  * @file           : fmt.c
+  * @version        : V1.0
+  * @brief          : 轻量格式化输出
+  *                   - 整数、定点小数与十六进制转换，十进制每次查表输出两位
+  *                   - printf子集，参数类型在编译期检查
+  *                   - 直接写入环形发送队列，不需要中间缓冲
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                设计说明
+  *          ===================================================================
+  *           newlib的vsnprintf会链接浮点格式化，占用较多栈，数字转换逐位
+  *           做除法。这里只实现输出NMEA风格文本需要的部分：十进制转换每次
+  *           除以100并从两位数字表中取出两个字符，除法次数减半；定点小数
+  *           按整数与小数两部分输出，不经过浮点。
+  *
+  *           输出不做截断：放不下时只写入能写下的部分，Length仍按完整长度
+  *           累计，调用者据此放弃整条消息。不依赖HAL与RTOS，可在主机编译。
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "fmt.h"
+#include "string.h"
+
+/* Define --------------------------------------------------------------------*/
+#define FMT_FLAG_LEFT				0x01U		/**< '-' 左对齐 */
+#define FMT_FLAG_ZERO				0x02U		/**< '0' 补0 */
+
+/* 32位整数的最大十进制位数 */
+#define FMT_DIGITS_MAX				10U
+/* 定点小数的最大长度：符号、小数点与至多10位数字 */
+#define FMT_FIXED_MAX				(FMT_DIGITS_MAX + 2U)
+
+/* 不超过此长度的数据逐字节写入，省去memcpy调用 */
+#define FMT_SHORT_MAX				16U
+
+#define FMT_MIN(a, b)				(((a) < (b)) ? (a) : (b))
+
+/* Variables -----------------------------------------------------------------*/
+static const char FMT_DigitPairs[200] =
+{
+	'0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+	'1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+	'2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+	'3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+	'4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+	'5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+	'6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+	'7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+	'8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+	'9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9',
+};
+
+static const char FMT_HexLower[16] = {'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'};
+static const char FMT_HexUpper[16] = {'0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F'};
+
+static const uint32_t FMT_Pow10[FMT_DIGITS_MAX] =
+{
+	1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL,
+};
+
+static const char FMT_Spaces[16] = {' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' '};
+static const char FMT_Zeros[16] = {'0','0','0','0','0','0','0','0','0','0','0','0','0','0','0','0'};
+
+/* ------------------------------------ Writer Funtion ------------------------------------ */
+
+/**
+  * @brief  FMT_Init 以线性缓冲初始化输出
+  * @param  w: 输出
+  * @param  buf: 缓冲
+  * @param  size: 缓冲大小
+  */
+void FMT_Init(FMT_WriterTypeDef *w, uint8_t *buf, uint32_t size)
+{
+	w->Buffer = buf;
+	w->Mask = 0xFFFFFFFFUL;
+	w->Start = 0U;
+	w->Size = size;
+	w->Length = 0U;
+}
+
+/**
+  * @brief  FMT_InitRing 以环形队列中的一段初始化输出
+  * @param  w: 输出
+  * @param  buf: 队列存储区
+  * @param  mask: 队列大小减一，队列大小必须为2的幂
+  * @param  start: 写位置，可以未取模
+  * @param  size: 可写入的字节数，不超过队列剩余空间
+  */
+void FMT_InitRing(FMT_WriterTypeDef *w, uint8_t *buf, uint32_t mask, uint32_t start, uint32_t size)
+{
+	w->Buffer = buf;
+	w->Mask = mask;
+	w->Start = start;
+	w->Size = size;
+	w->Length = 0U;
+}
+
+/**
+  * @brief  FMT_Bytes 输出一段数据
+  */
+void FMT_Bytes(FMT_WriterTypeDef *w, const void *data, uint32_t len)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	uint32_t room, pos, first, i;
+
+	if((len != 0U) && (w->Length < w->Size))
+	{
+		room = FMT_MIN(w->Size - w->Length, len);
+		pos = w->Start + w->Length;
+		if(room <= FMT_SHORT_MAX)
+		{
+			for(i = 0U; i < room; i++)
+				w->Buffer[(pos + i) & w->Mask] = p[i];
+		}
+		else
+		{
+			pos &= w->Mask;
+			/* 到队列末尾的空间，线性缓冲时Mask - pos不会回绕 */
+			first = (room - 1U <= w->Mask - pos) ? room : w->Mask - pos + 1U;
+			memcpy(&w->Buffer[pos], p, first);
+			memcpy(w->Buffer, p + first, room - first);
+		}
+	}
+	w->Length += len;
+}
+
+/**
+  * @brief  FMT_Char 输出一个字符
+  */
+void FMT_Char(FMT_WriterTypeDef *w, char c)
+{
+	if(w->Length < w->Size)
+		w->Buffer[(w->Start + w->Length) & w->Mask] = (uint8_t)c;
+	w->Length++;
+}
+
+/**
+  * @brief  FMT_String 输出以0结尾的字符串
+  */
+void FMT_String(FMT_WriterTypeDef *w, const char *s)
+{
+	FMT_Bytes(w, s, strlen(s));
+}
+
+/**
+  * @brief  FMT_Fill 输出n个相同的填充字符
+  * @param  pad: FMT_Spaces或FMT_Zeros
+  */
+static void FMT_Fill(FMT_WriterTypeDef *w, const char *pad, uint32_t n)
+{
+	while(n > sizeof(FMT_Spaces))
+	{
+		FMT_Bytes(w, pad, sizeof(FMT_Spaces));
+		n -= sizeof(FMT_Spaces);
+	}
+	FMT_Bytes(w, pad, n);
+}
+
+/* ------------------------------------ Convert Funtion ------------------------------------ */
+
+/**
+  * @brief  FMT_Decimal 无符号数转为十进制，从end向前写入
+  * @retval 位数
+  */
+static uint32_t FMT_Decimal(char *end, uint32_t value)
+{
+	char *p = end;
+	uint32_t q;
+
+	while(value >= 100U)
+	{
+		q = value / 100U;
+		p -= 2;
+		memcpy(p, &FMT_DigitPairs[2U * (value - q * 100U)], 2U);
+		value = q;
+	}
+	if(value >= 10U)
+	{
+		p -= 2;
+		memcpy(p, &FMT_DigitPairs[2U * value], 2U);
+	}
+	else
+		*--p = (char)('0' + value);
+
+	return (uint32_t)(end - p);
+}
+
+/**
+  * @brief  FMT_HexDigits 无符号数转为十六进制，从end向前写入
+  * @retval 位数，value为0时为1
+  */
+static uint32_t FMT_HexDigits(char *end, uint32_t value, const char *table)
+{
+	char *p = end;
+
+	do
+	{
+		*--p = table[value & 0x0FU];
+		value >>= 4;
+	}while(value != 0U);
+
+	return (uint32_t)(end - p);
+}
+
+/**
+  * @brief  FMT_Unsigned 输出无符号十进制数
+  */
+void FMT_Unsigned(FMT_WriterTypeDef *w, uint32_t value)
+{
+	char tmp[FMT_DIGITS_MAX];
+	uint32_t n = FMT_Decimal(&tmp[FMT_DIGITS_MAX], value);
+
+	FMT_Bytes(w, &tmp[FMT_DIGITS_MAX - n], n);
+}
+
+/**
+  * @brief  FMT_Signed 输出有符号十进制数
+  */
+void FMT_Signed(FMT_WriterTypeDef *w, int32_t value)
+{
+	char tmp[FMT_DIGITS_MAX + 1U];
+	char *end = &tmp[sizeof(tmp)];
+	char *p;
+
+	if(value < 0)
+	{
+		p = end - FMT_Decimal(end, 0U - (uint32_t)value);
+		*--p = '-';
+	}
+	else
+		p = end - FMT_Decimal(end, (uint32_t)value);
+	FMT_Bytes(w, p, (uint32_t)(end - p));
+}
+
+/**
+  * @brief  FMT_Hex 输出大写十六进制数
+  * @param  digits: 最少位数，不足补0，0表示不补
+  */
+void FMT_Hex(FMT_WriterTypeDef *w, uint32_t value, uint8_t digits)
+{
+	char tmp[8];
+	uint32_t n = FMT_HexDigits(&tmp[8], value, FMT_HexUpper);
+
+	if(digits > n)
+		FMT_Fill(w, FMT_Zeros, digits - n);
+	FMT_Bytes(w, &tmp[8U - n], n);
+}
+
+/**
+  * @brief  FMT_Fixed 输出定点小数
+  * @note   例如纬度1e-7度的定点值-123456789，decimals为7时输出-12.3456789。
+  * @param  value: 定点值
+  * @param  decimals: 小数位数，0~9
+  */
+void FMT_Fixed(FMT_WriterTypeDef *w, int32_t value, uint8_t decimals)
+{
+	char tmp[FMT_FIXED_MAX];
+	char *end = &tmp[sizeof(tmp)];
+	char *p = end;
+	uint32_t magnitude, scale, integer;
+
+	if(decimals >= FMT_DIGITS_MAX)
+		decimals = FMT_DIGITS_MAX - 1U;
+	magnitude = (value < 0) ? 0U - (uint32_t)value : (uint32_t)value;
+	scale = FMT_Pow10[decimals];
+	integer = magnitude / scale;
+
+	if(decimals != 0U)
+	{
+		p -= FMT_Decimal(p, magnitude - integer * scale);
+		while(p > end - decimals)
+			*--p = '0';
+		*--p = '.';
+	}
+	p -= FMT_Decimal(p, integer);
+	if(value < 0)
+		*--p = '-';
+	FMT_Bytes(w, p, (uint32_t)(end - p));
+}
+
+/* ------------------------------------ Print Funtion ------------------------------------ */
+
+/**
+  * @brief  FMT_Field 按宽度与对齐输出一个转换结果
+  * @param  prefix: 符号，放在补0之前，没有为0
+  * @param  body: 转换结果
+  * @param  len: 转换结果长度
+  * @param  zeros: 精度要求的前导0个数
+  */
+static void FMT_Field(FMT_WriterTypeDef *w, uint8_t flags, uint32_t width,
+					  char prefix, const char *body, uint32_t len, uint32_t zeros)
+{
+	uint32_t total = len + zeros + ((prefix != 0) ? 1U : 0U);
+	uint32_t pad = (width > total) ? width - total : 0U;
+
+	if((pad == 0U) && (total == len))
+	{
+		FMT_Bytes(w, body, len);
+		return;
+	}
+	if((flags & FMT_FLAG_LEFT) == 0U)
+	{
+		if((flags & FMT_FLAG_ZERO) != 0U)
+			zeros += pad;
+		else
+			FMT_Fill(w, FMT_Spaces, pad);
+		pad = 0U;
+	}
+	if(prefix != 0)
+		FMT_Char(w, prefix);
+	if(zeros != 0U)
+		FMT_Fill(w, FMT_Zeros, zeros);
+	FMT_Bytes(w, body, len);
+	if(pad != 0U)
+		FMT_Fill(w, FMT_Spaces, pad);
+}
+
+/**
+  * @brief  FMT_VPrint 按格式输出，支持的说明符见fmt.h
+  * @param  w: 输出
+  * @param  format: 格式字符串
+  * @param  args: 参数
+  */
+void FMT_VPrint(FMT_WriterTypeDef *w, const char *format, va_list args)
+{
+	char tmp[FMT_DIGITS_MAX + 2U];
+	char *end = &tmp[sizeof(tmp)];
+	const char *p = format;
+	const char *run;
+	const char *s;
+	uint32_t width, precision, n, value;
+	uint8_t flags, longlong, hasprec;
+	char prefix;
+	int arg;
+
+	for(;;)
+	{
+		/* 普通字符整段输出 */
+		run = p;
+		while((*p != '\0') && (*p != '%'))
+			p++;
+		if(p != run)
+			FMT_Bytes(w, run, (uint32_t)(p - run));
+		if(*p == '\0')
+			return;
+		run = p++;
+
+		flags = 0U;
+		for(;; p++)
+		{
+			if(*p == '-')
+				flags |= FMT_FLAG_LEFT;
+			else if(*p == '0')
+				flags |= FMT_FLAG_ZERO;
+			else if((*p != ' ') && (*p != '+') && (*p != '#'))
+				break;
+		}
+
+		width = 0U;
+		if(*p == '*')
+		{
+			arg = va_arg(args, int);
+			if(arg < 0)
+			{
+				flags |= FMT_FLAG_LEFT;
+				arg = -arg;
+			}
+			width = (uint32_t)arg;
+			p++;
+		}
+		else
+		{
+			while((*p >= '0') && (*p <= '9'))
+				width = width * 10U + (uint32_t)(*p++ - '0');
+		}
+
+		precision = 0U;
+		hasprec = 0U;
+		if(*p == '.')
+		{
+			hasprec = 1U;
+			p++;
+			if(*p == '*')
+			{
+				arg = va_arg(args, int);
+				if(arg < 0)
+					hasprec = 0U;
+				else
+					precision = (uint32_t)arg;
+				p++;
+			}
+			else
+			{
+				while((*p >= '0') && (*p <= '9'))
+					precision = precision * 10U + (uint32_t)(*p++ - '0');
+			}
+		}
+
+		longlong = 0U;
+		while((*p == 'h') || (*p == 'l') || (*p == 'z') || (*p == 'j') || (*p == 't'))
+		{
+			if((*p == 'l') && (p[1] == 'l'))
+				longlong = 1U;
+			p++;
+		}
+
+		prefix = 0;
+		switch(*p)
+		{
+			case 'd':
+			case 'i':
+			case 'u':
+			case 'x':
+			case 'X':
+			case 'p':
+				if(longlong != 0U)
+				{
+					/* 64位参数不支持，取走参数保持后续参数对齐 */
+					(void)va_arg(args, long long);
+					FMT_Bytes(w, run, (uint32_t)(p + 1 - run));
+					break;
+				}
+				if(*p == 'p')
+				{
+					value = (uint32_t)(uintptr_t)va_arg(args, void *);
+					FMT_Bytes(w, "0x", 2U);
+					n = FMT_HexDigits(end, value, FMT_HexLower);
+					FMT_Field(w, flags, width, 0, end - n, n, 0U);
+					break;
+				}
+				if((*p == 'd') || (*p == 'i'))
+				{
+					arg = va_arg(args, int);
+					if(arg < 0)
+						prefix = '-';
+					value = (arg < 0) ? 0U - (uint32_t)arg : (uint32_t)arg;
+				}
+				else
+					value = va_arg(args, unsigned int);
+
+				if(*p == 'x')
+					n = FMT_HexDigits(end, value, FMT_HexLower);
+				else if(*p == 'X')
+					n = FMT_HexDigits(end, value, FMT_HexUpper);
+				else
+					n = FMT_Decimal(end, value);
+
+				/* 有精度时忽略'0'标志，精度0且值为0时不输出数字 */
+				if(hasprec != 0U)
+				{
+					flags &= (uint8_t)~FMT_FLAG_ZERO;
+					if((precision == 0U) && (value == 0U))
+						n = 0U;
+				}
+				FMT_Field(w, flags, width, prefix, end - n, n, (precision > n) ? precision - n : 0U);
+				break;
+
+			case 'c':
+				tmp[0] = (char)va_arg(args, int);
+				FMT_Field(w, flags & FMT_FLAG_LEFT, width, 0, tmp, 1U, 0U);
+				break;
+
+			case 's':
+				s = va_arg(args, const char *);
+				if(s == NULL)
+					s = "(null)";
+				if(hasprec != 0U)
+				{
+					for(n = 0U; (n < precision) && (s[n] != '\0'); n++)
+						;
+				}
+				else
+					n = strlen(s);
+				FMT_Field(w, flags & FMT_FLAG_LEFT, width, 0, s, n, 0U);
+				break;
+
+			case '%':
+				FMT_Char(w, '%');
+				break;
+
+			case '\0':
+				FMT_Bytes(w, run, (uint32_t)(p - run));
+				return;
+
+			default:
+				/* 不支持的转换原样输出，浮点取走double参数，其余按32位参数取走 */
+				if((*p == 'f') || (*p == 'F') || (*p == 'e') || (*p == 'E') ||
+				   (*p == 'g') || (*p == 'G') || (*p == 'a') || (*p == 'A'))
+					(void)va_arg(args, double);
+				else
+					(void)va_arg(args, unsigned int);
+				FMT_Bytes(w, run, (uint32_t)(p + 1 - run));
+				break;
+		}
+		p++;
+	}
+}
+
+/**
+  * @brief  FMT_Print 按格式输出，支持的说明符见fmt.h
+  */
+void FMT_Print(FMT_WriterTypeDef *w, const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	FMT_VPrint(w, format, args);
+	va_end(args);
+}
@@ -30,6 +30,14 @@
 #include "sdmmc.h"
 #include "usbd_composite_if.h"
 #include "tim.h"
+#include "nmea.h"
+#include "gnss.h"
+#include "nmea_filter.h"
+#include "usbd_cdc_mux.h"
+#include "logger.h"
+#include "fix_codec.h"
+#include "usbd_cdc_xfer.h"
+#include "usb_device.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -39,6 +47,12 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+/* GGA与RMC编码为FIX记录写入SD卡，不再记录语句原文 */
+#define GNSS_FIX_COMPRESS			1U
+
+#if (CDC_MUX_ENABLED == 1U) && (CDC_MUX_CMD_QUEUE_SIZE < (LOGGER_HEADER_SIZE + LOGGER_RECORD_MAX))
+#error "CDC_MUX_CMD_QUEUE_SIZE must hold the longest query record"
+#endif
 
 /* USER CODE END PD */
 
@@ -49,13 +63,24 @@
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN Variables */
-
+static NMEA_DecoderTypeDef NMEA_Decoder;	/**< CDC0上的NMEA解码器 */
+static GNSS_DemuxTypeDef GNSS_Demux;		/**< CDC0上的GNSS数据流解复用器 */
+static NMEA_GGATypeDef GNSS_LastGga;		/**< 最近一条GGA */
+static NMEA_RMCTypeDef GNSS_LastRmc;		/**< 最近一条RMC */
+static uint8_t GNSS_GgaPending;				/**< GNSS_LastGga还在等待同一历元的RMC */
+static uint8_t GNSS_NmeaType;				/**< 正在处理的语句类型 */
+#if (GNSS_FIX_COMPRESS == 1U)
+static FIX_CodecTypeDef GNSS_FixCodec;		/**< 定位结果编码状态 */
+static uint8_t GNSS_FixBlock[FIX_KEY_INTERVAL * FIX_ENCODED_MAX];	/**< 从关键帧开始的编码块 */
+static uint32_t GNSS_FixLength;
+static uint32_t GNSS_FixFlushed;			/**< 已完成的Logger_FlushRequest序号 */
+#endif
 /* USER CODE END Variables */
 /* Definitions for Empty_Task */
 osThreadId_t Empty_TaskHandle;
 const osThreadAttr_t Empty_Task_attributes = {
   .name = "Empty_Task",
-  .stack_size = 128 * 4,
+  .stack_size = 512 * 4,
   .priority = (osPriority_t) osPriorityLow,
 };
 /* Definitions for FatFs_Task */
@@ -94,6 +119,23 @@ const osMessageQueueAttr_t USB_CDC_Reciver_Parameter_attributes = {
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN FunctionPrototypes */
+static void NMEA_Sentence(const NMEA_SentenceTypeDef *sentence);
+static void GNSS_NmeaFrame(const uint8_t *frame, uint32_t len);
+static void GNSS_UbxFrame(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len);
+static void GNSS_RtcmFrame(uint16_t type, const uint8_t *frame, uint32_t len);
+static uint8_t Logger_QueryOutput(const uint8_t *buf, uint32_t len);
+#if (GNSS_FIX_COMPRESS == 1U)
+static void GNSS_FixPush(uint8_t matched);
+static void GNSS_FixFlush(void);
+#endif
+
+/* 三种帧都写入SD卡记录，NMEA语句另外交给解码器 */
+static const GNSS_ItfTypeDef GNSS_Consumer =
+{
+  GNSS_NmeaFrame,
+  GNSS_UbxFrame,
+  GNSS_RtcmFrame
+};
 
 /* USER CODE END FunctionPrototypes */
 
@@ -113,6 +155,7 @@ void MX_FREERTOS_Init(void); /* (MISRA C 2004 rule 8.1) */
   */
 void MX_FREERTOS_Init(void) {
   /* USER CODE BEGIN Init */
+  Logger_Init(Logger_QueryOutput);
 
   /* USER CODE END Init */
 
@@ -174,6 +217,10 @@ void StartTask01(void *argument)
   /* init code for USB_DEVICE */
   MX_USB_DEVICE_Init();
   /* USER CODE BEGIN StartTask01 */
+#if (CDC_XFER_ENABLED == 1U)
+  /* 文件传输服务在本任务中运行，不返回 */
+  CDC_Xfer_Task();
+#endif
   /* Infinite loop */
   for(;;)
   {
@@ -192,11 +239,8 @@ void StartTask01(void *argument)
 void StartTask02(void *argument)
 {
   /* USER CODE BEGIN StartTask02 */
-  /* Infinite loop */
-  for(;;)
-  {
-    osDelay(1);
-  }
+  /* 挂载SD卡并持续写入记录，不返回 */
+  Logger_Task();
   /* USER CODE END StartTask02 */
 }
 
@@ -255,9 +299,14 @@ void StartTask04(void *argument)
       osDelay(100);
       if(!HAL_GPIO_ReadPin(KEY2_GPIO_Port, KEY2_Pin))
       {
-        
+        /* 在复合设备与MSC单独模式之间切换，松开按键后才再次响应 */
+        USB_Device_RequestMode((USBD_COMPOSITE_GetMode() == COM_MODE_COMPOSITE) ? COM_MODE_MSC_ONLY : COM_MODE_COMPOSITE);
+        while(!HAL_GPIO_ReadPin(KEY2_GPIO_Port, KEY2_Pin))
+          osDelay(10);
       }
     }
+    /* 模式切换要重新初始化协议栈，不能在USB回调中进行，统一在此执行 */
+    USB_Device_Poll();
     osDelay(100);
   }
   /* USER CODE END StartTask04 */
@@ -273,29 +322,175 @@ void StartTask04(void *argument)
 void StartTask05(void *argument)
 {
   /* USER CODE BEGIN StartTask05 */
-  char c;
-  float i;
+  uint8_t chunk[COM_CDC_DATA_MAX_PACK_SIZE];
+  uint32_t len;
 //  HAL_SD_CardInfoTypeDef info;
 //  if(HAL_SD_GetCardState(&hsd1) == HAL_SD_CARD_TRANSFER)
 //    HAL_SD_GetCardInfo(&hsd1, &info);
+  NMEA_Init(&NMEA_Decoder, NMEA_Sentence);
+#if (GNSS_FIX_COMPRESS == 1U)
+  FIX_Reset(&GNSS_FixCodec);
+#endif
+  GNSS_Init(&GNSS_Demux, &GNSS_Consumer);
+  NMEA_Filter_Init();
   /* Infinite loop */
   for(;;)
   {
-    usb_scanf("$GPGSV,3,1,10,04,55,226,28,07,21,318,42,08,80,217,18,09,43,285,43,0*6D%f", &i);
-    usb_printf("$GPGSV,3,1,10,04,55,226,28,07,21,318,42,08,80,217,18,09,43,285,43,0*6D%f", i);
-    // if((Recive_Finish == Recive_State) && (New_Package == Tag))
-    // {
-    //   CDC_Transmit_FS(UserRxBufferFS, Length);
-    //   Recive_State = Recive_UnFinish;
-    //   Length = 0U;
-    // }
-    osDelay(1);
+    /* 读空字节流后再让出，全速下1ms内最多到达约1.2KB */
+    len = CDC_Port_Read(0U, chunk, sizeof(chunk));
+    if(len != 0U)
+      GNSS_Input(&GNSS_Demux, chunk, len);
+    else
+      osDelay(1);
+#if (GNSS_FIX_COMPRESS == 1U)
+    GNSS_FixFlush();
+#endif
   }
   /* USER CODE END StartTask05 */
 }
 
 /* Private application code --------------------------------------------------*/
 /* USER CODE BEGIN Application */
+/**
+  * @brief  GNSS_NmeaFrame 解复用器分发的NMEA语句，解码后经过滤器回传
+  * @param  frame: 完整语句
+  * @param  len: 语句长度
+  */
+static void GNSS_NmeaFrame(const uint8_t *frame, uint32_t len)
+{
+  GNSS_NmeaType = NMEA_TYPE_UNKNOWN;
+  NMEA_Input(&NMEA_Decoder, frame, len);
+#if (GNSS_FIX_COMPRESS == 1U)
+  if((GNSS_NmeaType != NMEA_TYPE_GGA) && (GNSS_NmeaType != NMEA_TYPE_RMC))
+#endif
+    (void)Logger_Write(LOGGER_TYPE_NMEA, frame, (uint16_t)len);
+
+  /* 只把过滤后的原始语句回传主机 */
+  if(NMEA_Filter_Check(frame, len) != 0U)
+  {
+#if (CDC_MUX_ENABLED == 1U)
+    (void)CDC_MUX_Write(CDC_MUX_CH_TELEMETRY, frame, len);
+#else
+    (void)CDC_Transmit_FS((uint8_t *)frame, (uint16_t)len);
+#endif
+  }
+}
+
+/**
+  * @brief  GNSS_UbxFrame 解复用器分发的UBX帧，记录Class、ID与负载
+  */
+static void GNSS_UbxFrame(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len)
+{
+  uint8_t prefix[2] = {cls, id};
+
+  (void)Logger_WritePrefix(LOGGER_TYPE_UBX, prefix, sizeof(prefix), payload, len);
+}
+
+/**
+  * @brief  GNSS_RtcmFrame 解复用器分发的RTCM3帧，原样记录
+  */
+static void GNSS_RtcmFrame(uint16_t type, const uint8_t *frame, uint32_t len)
+{
+  (void)Logger_Write(LOGGER_TYPE_RTCM, frame, (uint16_t)len);
+}
+
+/**
+  * @brief  Logger_QueryOutput 记录查询结果作为命令应答送回主机，在FatFs_Task中执行
+  * @retval 0:已写入 非0:发送队列已满
+  */
+static uint8_t Logger_QueryOutput(const uint8_t *buf, uint32_t len)
+{
+#if (CDC_MUX_ENABLED == 1U)
+  return CDC_MUX_Write(CDC_MUX_CH_CMD, buf, len);
+#else
+  return CDC_Transmit_FS((uint8_t *)buf, (uint16_t)len);
+#endif
+}
+
+/**
+  * @brief  NMEA_Sentence NMEA语句回调，在SDCrad_Task中执行，保存最近的定位结果
+  * @param  sentence: 解码得到的语句
+  */
+static void NMEA_Sentence(const NMEA_SentenceTypeDef *sentence)
+{
+  GNSS_NmeaType = sentence->Type;
+  switch(sentence->Type)
+  {
+    case NMEA_TYPE_GGA:
+#if (GNSS_FIX_COMPRESS == 1U)
+      /* 上一历元始终没有等到RMC */
+      if(GNSS_GgaPending != 0U)
+        GNSS_FixPush(0U);
+#endif
+      GNSS_LastGga = sentence->Gga;
+      GNSS_GgaPending = 1U;
+      break;
+
+    case NMEA_TYPE_RMC:
+      GNSS_LastRmc = sentence->Rmc;
+      break;
+
+    default:
+      break;
+  }
+
+#if (GNSS_FIX_COMPRESS == 1U)
+  /* 接收机输出GGA与RMC的先后不定，同一历元的两条都到齐后编码 */
+  if((GNSS_GgaPending != 0U) && (GNSS_LastRmc.Valid != 0U) && (GNSS_LastRmc.Time == GNSS_LastGga.Time))
+    GNSS_FixPush(1U);
+#endif
+}
 
+#if (GNSS_FIX_COMPRESS == 1U)
+/**
+  * @brief  GNSS_FixPush 编码GNSS_LastGga对应的定位结果
+  * @note   编码块以关键帧开始，下一个关键帧到来或记录任务请求时整块写入SD卡，
+  *         因此每条FIX记录都能独立解码。
+  * @param  matched: 1表示GNSS_LastRmc属于同一历元；0时速度与航向记为FIX_INVALID
+  */
+static void GNSS_FixPush(uint8_t matched)
+{
+  FIX_RecordTypeDef fix;
+
+  GNSS_GgaPending = 0U;
+  fix.Time = GNSS_LastGga.Time;
+  fix.Latitude = GNSS_LastGga.Latitude;
+  fix.Longitude = GNSS_LastGga.Longitude;
+  fix.Altitude = GNSS_LastGga.Altitude;
+  fix.Speed = (matched != 0U) ? GNSS_LastRmc.Speed : FIX_INVALID;
+  fix.Course = (matched != 0U) ? GNSS_LastRmc.Course : FIX_INVALID;
+  fix.Hdop = GNSS_LastGga.Hdop;
+  fix.Quality = GNSS_LastGga.Quality;
+  fix.Satellites = GNSS_LastGga.Satellites;
+
+  if(FIX_KEY_DUE(&GNSS_FixCodec) && (GNSS_FixLength != 0U))
+  {
+    (void)Logger_Write(LOGGER_TYPE_FIX, GNSS_FixBlock, (uint16_t)GNSS_FixLength);
+    GNSS_FixLength = 0U;
+  }
+  GNSS_FixLength += FIX_Encode(&GNSS_FixCodec, &fix, &GNSS_FixBlock[GNSS_FixLength]);
+}
+
+/**
+  * @brief  GNSS_FixFlush 记录任务同步前交出未满的编码块
+  * @note   否则同步后仍有最多FIX_KEY_INTERVAL-1个定位结果只在内存中。
+  *         之后的定位结果从关键帧重新开始。
+  */
+static void GNSS_FixFlush(void)
+{
+  uint32_t request = Logger_FlushRequest();
+
+  if(request == GNSS_FixFlushed)
+    return;
+  if(GNSS_FixLength != 0U)
+  {
+    (void)Logger_Write(LOGGER_TYPE_FIX, GNSS_FixBlock, (uint16_t)GNSS_FixLength);
+    GNSS_FixLength = 0U;
+    FIX_Reset(&GNSS_FixCodec);
+  }
+  GNSS_FixFlushed = request;
+  Logger_FlushDone(request);
+}
+#endif
 /* USER CODE END Application */
 
@@ -0,0 +1,366 @@
+/**
+  ******************************************************************************
+  * @file           : gnss.c
+  * @version        : V1.0
+  * @brief          : GNSS数据流解复用器
+  *                   - 同一字节流中识别NMEA、UBX、RTCM3三种帧
+  *                   - 按各自规则校验：NMEA异或、UBX Fletcher、RTCM3 CRC-24Q
+  *                   - 完整帧以指针形式直接交给对应协议的消费者
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                重同步策略
+  *          ===================================================================
+  *           每个同步字节都只是候选帧起点。帧不完整时保留数据等待后续输入；
+  *           校验失败或长度字段不合理时只丢弃这一个同步字节，从下一字节重新
+  *           寻找起点，因此被截断的帧不会吞掉紧随其后的正确帧。帧长度都有
+  *           上限，缓冲不会被一个错误的长度字段占满而停止解析。
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "gnss.h"
+#include "scan.h"
+#include "string.h"
+
+/* Define --------------------------------------------------------------------*/
+#define GNSS_FRAME_MORE				0		/**< 数据不足，等待后续输入 */
+#define GNSS_FRAME_INVALID			(-1)	/**< 不是合法帧，丢弃同步字节 */
+
+/* Variables -----------------------------------------------------------------*/
+/* CRC-24Q多项式0x1864CFB的按字节查表 */
+static const uint32_t GNSS_Crc24qTable[256] =
+{
+	0x000000U, 0x864CFBU, 0x8AD50DU, 0x0C99F6U, 0x93E6E1U, 0x15AA1AU, 0x1933ECU, 0x9F7F17U,
+	0xA18139U, 0x27CDC2U, 0x2B5434U, 0xAD18CFU, 0x3267D8U, 0xB42B23U, 0xB8B2D5U, 0x3EFE2EU,
+	0xC54E89U, 0x430272U, 0x4F9B84U, 0xC9D77FU, 0x56A868U, 0xD0E493U, 0xDC7D65U, 0x5A319EU,
+	0x64CFB0U, 0xE2834BU, 0xEE1ABDU, 0x685646U, 0xF72951U, 0x7165AAU, 0x7DFC5CU, 0xFBB0A7U,
+	0x0CD1E9U, 0x8A9D12U, 0x8604E4U, 0x00481FU, 0x9F3708U, 0x197BF3U, 0x15E205U, 0x93AEFEU,
+	0xAD50D0U, 0x2B1C2BU, 0x2785DDU, 0xA1C926U, 0x3EB631U, 0xB8FACAU, 0xB4633CU, 0x322FC7U,
+	0xC99F60U, 0x4FD39BU, 0x434A6DU, 0xC50696U, 0x5A7981U, 0xDC357AU, 0xD0AC8CU, 0x56E077U,
+	0x681E59U, 0xEE52A2U, 0xE2CB54U, 0x6487AFU, 0xFBF8B8U, 0x7DB443U, 0x712DB5U, 0xF7614EU,
+	0x19A3D2U, 0x9FEF29U, 0x9376DFU, 0x153A24U, 0x8A4533U, 0x0C09C8U, 0x00903EU, 0x86DCC5U,
+	0xB822EBU, 0x3E6E10U, 0x32F7E6U, 0xB4BB1DU, 0x2BC40AU, 0xAD88F1U, 0xA11107U, 0x275DFCU,
+	0xDCED5BU, 0x5AA1A0U, 0x563856U, 0xD074ADU, 0x4F0BBAU, 0xC94741U, 0xC5DEB7U, 0x43924CU,
+	0x7D6C62U, 0xFB2099U, 0xF7B96FU, 0x71F594U, 0xEE8A83U, 0x68C678U, 0x645F8EU, 0xE21375U,
+	0x15723BU, 0x933EC0U, 0x9FA736U, 0x19EBCDU, 0x8694DAU, 0x00D821U, 0x0C41D7U, 0x8A0D2CU,
+	0xB4F302U, 0x32BFF9U, 0x3E260FU, 0xB86AF4U, 0x2715E3U, 0xA15918U, 0xADC0EEU, 0x2B8C15U,
+	0xD03CB2U, 0x567049U, 0x5AE9BFU, 0xDCA544U, 0x43DA53U, 0xC596A8U, 0xC90F5EU, 0x4F43A5U,
+	0x71BD8BU, 0xF7F170U, 0xFB6886U, 0x7D247DU, 0xE25B6AU, 0x641791U, 0x688E67U, 0xEEC29CU,
+	0x3347A4U, 0xB50B5FU, 0xB992A9U, 0x3FDE52U, 0xA0A145U, 0x26EDBEU, 0x2A7448U, 0xAC38B3U,
+	0x92C69DU, 0x148A66U, 0x181390U, 0x9E5F6BU, 0x01207CU, 0x876C87U, 0x8BF571U, 0x0DB98AU,
+	0xF6092DU, 0x7045D6U, 0x7CDC20U, 0xFA90DBU, 0x65EFCCU, 0xE3A337U, 0xEF3AC1U, 0x69763AU,
+	0x578814U, 0xD1C4EFU, 0xDD5D19U, 0x5B11E2U, 0xC46EF5U, 0x42220EU, 0x4EBBF8U, 0xC8F703U,
+	0x3F964DU, 0xB9DAB6U, 0xB54340U, 0x330FBBU, 0xAC70ACU, 0x2A3C57U, 0x26A5A1U, 0xA0E95AU,
+	0x9E1774U, 0x185B8FU, 0x14C279U, 0x928E82U, 0x0DF195U, 0x8BBD6EU, 0x872498U, 0x016863U,
+	0xFAD8C4U, 0x7C943FU, 0x700DC9U, 0xF64132U, 0x693E25U, 0xEF72DEU, 0xE3EB28U, 0x65A7D3U,
+	0x5B59FDU, 0xDD1506U, 0xD18CF0U, 0x57C00BU, 0xC8BF1CU, 0x4EF3E7U, 0x426A11U, 0xC426EAU,
+	0x2AE476U, 0xACA88DU, 0xA0317BU, 0x267D80U, 0xB90297U, 0x3F4E6CU, 0x33D79AU, 0xB59B61U,
+	0x8B654FU, 0x0D29B4U, 0x01B042U, 0x87FCB9U, 0x1883AEU, 0x9ECF55U, 0x9256A3U, 0x141A58U,
+	0xEFAAFFU, 0x69E604U, 0x657FF2U, 0xE33309U, 0x7C4C1EU, 0xFA00E5U, 0xF69913U, 0x70D5E8U,
+	0x4E2BC6U, 0xC8673DU, 0xC4FECBU, 0x42B230U, 0xDDCD27U, 0x5B81DCU, 0x57182AU, 0xD154D1U,
+	0x26359FU, 0xA07964U, 0xACE092U, 0x2AAC69U, 0xB5D37EU, 0x339F85U, 0x3F0673U, 0xB94A88U,
+	0x87B4A6U, 0x01F85DU, 0x0D61ABU, 0x8B2D50U, 0x145247U, 0x921EBCU, 0x9E874AU, 0x18CBB1U,
+	0xE37B16U, 0x6537EDU, 0x69AE1BU, 0xEFE2E0U, 0x709DF7U, 0xF6D10CU, 0xFA48FAU, 0x7C0401U,
+	0x42FA2FU, 0xC4B6D4U, 0xC82F22U, 0x4E63D9U, 0xD11CCEU, 0x575035U, 0x5BC9C3U, 0xDD8538U
+};
+
+/* ------------------------------------ Frame Funtion ------------------------------------ */
+
+/**
+  * @brief  GNSS_Crc24q 计算RTCM3使用的CRC-24Q
+  * @param  buf: 数据
+  * @param  len: 数据长度
+  * @retval 24位CRC
+  */
+uint32_t GNSS_Crc24q(const uint8_t *buf, uint32_t len)
+{
+	uint32_t crc = 0U;
+
+	while(len-- != 0U)
+		crc = ((crc << 8) ^ GNSS_Crc24qTable[((crc >> 16) ^ *buf++) & 0xFFU]) & 0xFFFFFFU;
+
+	return crc;
+}
+
+/**
+  * @brief  GNSS_Hex 十六进制字符转数值
+  * @retval 非十六进制字符返回0xFF
+  */
+static uint8_t GNSS_Hex(uint8_t c)
+{
+	if((c >= '0') && (c <= '9'))
+		return (uint8_t)(c - '0');
+	if((c >= 'A') && (c <= 'F'))
+		return (uint8_t)(c - 'A' + 10U);
+	if((c >= 'a') && (c <= 'f'))
+		return (uint8_t)(c - 'a' + 10U);
+	return 0xFFU;
+}
+
+/**
+  * @brief  GNSS_NmeaFrame 检查以'$'开始的候选语句
+  * @note   已检查过的部分记录在Scan中，数据分多次到达时不重复扫描。
+  * @param  h: 解复用器
+  * @param  p: 候选帧起点
+  * @param  avail: 可用数据量
+  * @retval 帧长度，GNSS_FRAME_MORE或GNSS_FRAME_INVALID
+  */
+static int32_t GNSS_NmeaFrame(GNSS_DemuxTypeDef *h, const uint8_t *p, uint32_t avail)
+{
+	uint32_t i, end, star, limit;
+	uint8_t hi, lo;
+
+	if(h->Scan == 0U)
+		h->Scan = 1U;
+
+	/* 按字跳过可打印字符，只在控制字符、非ASCII字节或'$'处停下逐个判断 */
+	limit = (avail < GNSS_NMEA_MAX_LENGTH) ? avail : GNSS_NMEA_MAX_LENGTH;
+	for(i = h->Scan; i < limit; i++)
+	{
+		i += SCAN_Text(&p[i], limit - i, '$');
+		if((i >= limit) || (p[i] != '\r'))
+			break;
+	}
+	if(i >= avail)
+	{
+		h->Scan = i;
+		return GNSS_FRAME_MORE;
+	}
+	/* 语句内出现新的起始符或二进制数据，说明本条语句已被截断 */
+	if(p[i] != '\n')
+		return GNSS_FRAME_INVALID;
+
+	/* 行尾为"*hh\r\n"或"*hh\n" */
+	end = (p[i - 1U] == '\r') ? i - 1U : i;
+	if(end < 4U)
+		return GNSS_FRAME_INVALID;
+	star = end - 3U;
+	if(p[star] != '*')
+		return GNSS_FRAME_INVALID;
+	hi = GNSS_Hex(p[star + 1U]);
+	lo = GNSS_Hex(p[star + 2U]);
+	if((hi == 0xFFU) || (lo == 0xFFU))
+		return GNSS_FRAME_INVALID;
+
+	if(SCAN_Xor(&p[1], star - 1U) != (uint8_t)((hi << 4) | lo))
+		return GNSS_FRAME_INVALID;
+
+	return (int32_t)(i + 1U);
+}
+
+/**
+  * @brief  GNSS_UbxFrame 检查以0xB5 0x62开始的候选帧
+  * @note   帧结构：同步2字节、类别、编号、负载长度2字节(小端)、负载、Fletcher校验2字节。
+  * @retval 帧长度，GNSS_FRAME_MORE或GNSS_FRAME_INVALID
+  */
+static int32_t GNSS_UbxFrame(const uint8_t *p, uint32_t avail)
+{
+	uint32_t len, total;
+
+	if(avail < 2U)
+		return GNSS_FRAME_MORE;
+	if(p[1] != GNSS_UBX_SYNC2)
+		return GNSS_FRAME_INVALID;
+	if(avail < 6U)
+		return GNSS_FRAME_MORE;
+
+	len = (uint32_t)p[4] | ((uint32_t)p[5] << 8);
+	if(len > GNSS_UBX_MAX_PAYLOAD)
+		return GNSS_FRAME_INVALID;
+	total = 8U + len;
+	if(avail < total)
+		return GNSS_FRAME_MORE;
+
+	if(SCAN_Fletcher(&p[2], total - 4U) != ((uint16_t)p[total - 2U] | ((uint16_t)p[total - 1U] << 8)))
+		return GNSS_FRAME_INVALID;
+
+	return (int32_t)total;
+}
+
+/**
+  * @brief  GNSS_RtcmFrame 检查以0xD3开始的候选帧
+  * @note   帧结构：前导0xD3、6位保留(为0)与10位负载长度、负载、CRC-24Q 3字节(大端)。
+  * @retval 帧长度，GNSS_FRAME_MORE或GNSS_FRAME_INVALID
+  */
+static int32_t GNSS_RtcmFrame(const uint8_t *p, uint32_t avail)
+{
+	uint32_t len, total, crc;
+
+	if(avail < 3U)
+		return GNSS_FRAME_MORE;
+	if((p[1] & 0xFCU) != 0U)
+		return GNSS_FRAME_INVALID;
+
+	len = ((uint32_t)(p[1] & 0x03U) << 8) | p[2];
+	total = 6U + len;
+	if(avail < total)
+		return GNSS_FRAME_MORE;
+
+	crc = ((uint32_t)p[total - 3U] << 16) | ((uint32_t)p[total - 2U] << 8) | p[total - 1U];
+	if(GNSS_Crc24q(p, total - 3U) != crc)
+		return GNSS_FRAME_INVALID;
+
+	return (int32_t)total;
+}
+
+/**
+  * @brief  GNSS_Dispatch 把校验通过的帧交给消费者
+  * @param  h: 解复用器
+  * @param  protocol: 协议编号
+  * @param  p: 帧起点
+  * @param  total: 帧长度
+  */
+static void GNSS_Dispatch(GNSS_DemuxTypeDef *h, uint8_t protocol, const uint8_t *p, uint32_t total)
+{
+	const GNSS_ItfTypeDef *itf = h->Itf;
+
+	h->Stats.Frames[protocol]++;
+	if(itf == NULL)
+		return;
+
+	switch(protocol)
+	{
+		case GNSS_PROTOCOL_NMEA:
+			if(itf->Nmea != NULL)
+				itf->Nmea(p, total);
+			break;
+
+		case GNSS_PROTOCOL_UBX:
+			if(itf->Ubx != NULL)
+				itf->Ubx(p[2], p[3], &p[6], (uint16_t)(total - 8U));
+			break;
+
+		default:
+			/* 消息类型为负载的前12位，空负载时为0 */
+			if(itf->Rtcm != NULL)
+				itf->Rtcm((total >= 8U) ? (uint16_t)(((uint16_t)p[3] << 4) | (p[4] >> 4)) : 0U, p, total);
+			break;
+	}
+}
+
+/**
+  * @brief  GNSS_Process 解析缓冲中的数据，直到数据不足一帧
+  * @param  h: 解复用器
+  */
+static void GNSS_Process(GNSS_DemuxTypeDef *h)
+{
+	const uint8_t *p;
+	uint32_t avail;
+	int32_t result;
+	uint8_t protocol;
+
+	while(h->Start < h->Length)
+	{
+		p = &h->Buffer[h->Start];
+		avail = h->Length - h->Start;
+
+		switch(p[0])
+		{
+			case '$':
+				protocol = GNSS_PROTOCOL_NMEA;
+				result = GNSS_NmeaFrame(h, p, avail);
+				break;
+
+			case GNSS_UBX_SYNC1:
+				protocol = GNSS_PROTOCOL_UBX;
+				result = GNSS_UbxFrame(p, avail);
+				break;
+
+			case GNSS_RTCM_PREAMBLE:
+				protocol = GNSS_PROTOCOL_RTCM;
+				result = GNSS_RtcmFrame(p, avail);
+				break;
+
+			default:
+				/* 跳过到下一个可能的同步字节 */
+				avail = 1U + SCAN_Byte3(&p[1], avail - 1U, '$', GNSS_UBX_SYNC1, GNSS_RTCM_PREAMBLE);
+				h->Start += avail;
+				h->Stats.Garbage += avail;
+				continue;
+		}
+
+		if(result == GNSS_FRAME_MORE)
+			break;
+
+		h->Scan = 0U;
+		if(result == GNSS_FRAME_INVALID)
+		{
+			h->Stats.Errors[protocol]++;
+			h->Start++;
+			continue;
+		}
+
+		GNSS_Dispatch(h, protocol, p, (uint32_t)result);
+		h->Start += (uint32_t)result;
+	}
+}
+
+/* ------------------------------------ GNSS Funtion ------------------------------------ */
+
+/**
+  * @brief  GNSS_Init 初始化解复用器
+  * @param  h: 解复用器
+  * @param  itf: 帧消费者，可为NULL
+  */
+void GNSS_Init(GNSS_DemuxTypeDef *h, const GNSS_ItfTypeDef *itf)
+{
+	(void)memset(h, 0, sizeof(GNSS_DemuxTypeDef));
+	h->Itf = itf;
+}
+
+/**
+  * @brief  GNSS_Input 输入一段数据
+  * @note   数据先追加到帧缓冲再解析；处理后把剩余的不完整帧移到缓冲起点。
+  * @param  h: 解复用器
+  * @param  buf: 数据
+  * @param  len: 数据长度
+  */
+void GNSS_Input(GNSS_DemuxTypeDef *h, const uint8_t *buf, uint32_t len)
+{
+	uint32_t n;
+
+	while(len != 0U)
+	{
+		n = GNSS_BUFFER_SIZE - h->Length;
+		if(n > len)
+			n = len;
+		memcpy(&h->Buffer[h->Length], buf, n);
+		h->Length += n;
+		buf += n;
+		len -= n;
+
+		GNSS_Process(h);
+
+		if(h->Start != 0U)
+		{
+			h->Length -= h->Start;
+			memmove(h->Buffer, &h->Buffer[h->Start], h->Length);
+			h->Start = 0U;
+		}
+	}
+}
+
+/**
+  * @brief  GNSS_GetStats 读取解复用统计
+  * @param  h: 解复用器
+  * @param  stats: 输出的统计数据
+  */
+void GNSS_GetStats(const GNSS_DemuxTypeDef *h, GNSS_StatsTypeDef *stats)
+{
+	*stats = h->Stats;
+}
@@ -0,0 +1,1122 @@
+/**
+  ******************************************************************************
+  * @file           : logger.c
+  * @version        : V1.0
+  * @brief          : SD卡数据记录
+  *                   - 其他任务把记录写入无锁队列，不等待SD卡
+  *                   - FatFs_Task把记录拼接成簇大小、扇区对齐的整块写入
+  *                   - 文件用f_expand预分配连续空间，写入过程中不扩展FAT链
+  *                   - 按大小或时间切换文件，按固定周期同步
+  *                   - 每块开头放置时间索引，按时间区间查询只读取结果所在的块
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                写入策略
+  *          ===================================================================
+  *           文件指针始终停在扇区边界，每次f_write写到下一个LOGGER_WRITE_SIZE
+  *           边界为止，FatFs直接把整扇区交给sd_diskio做多块DMA传输，不经过
+  *           扇区窗口拷贝。文件预分配后簇号连续，写入时只查表不修改FAT，
+  *           卡上看到的是长的顺序写。
+  *           记录不跨块，块内放不下下一条记录时补0到块尾。到达同步周期时
+  *           把不足一块的数据补0到扇区边界后写入并f_sync，之后的写入重新
+  *           对齐到块边界。关闭文件前f_truncate释放未用空间。
+  *           预分配成功的文件开启快速定位(_USE_FASTSEEK)，写入跨簇时从
+  *           簇链映射表取下一簇，不再读FAT。
+  *
+  *          ===================================================================
+  *                                队列
+  *          ===================================================================
+  *           单生产者单消费者环形队列，头尾为自由增长的计数，不关中断不加锁。
+  *           Logger_Write只能在同一个任务中调用(目前为SDCrad_Task)，多个任务
+  *           写入时需要在外部加锁。队列满时整条记录丢弃并计数。
+  *           生产者自己暂存、凑满一块才写入的数据(如FIX编码块)，在同步前经
+  *           Logger_FlushRequest/Logger_FlushDone交出，同步间隔对它同样有效。
+  *
+  *          ===================================================================
+  *                                区间查询
+  *          ===================================================================
+  *           每个块以INDEX记录开头，记录该块第一条数据的Tick。查询时借助簇链
+  *           映射表直接定位到各块开头，对块号二分查找不晚于起始Tick的最后
+  *           一块，此后顺序读取直到Tick超过结束值。读取量与结果大小成正比，
+  *           与文件大小只有对数关系。
+  *           查询在FatFs_Task中分段执行，每轮循环最多读LOGGER_QUERY_BURST次，
+  *           不影响记录写入。查询当前文件时先同步，通过写入用的文件对象读取，
+  *           只能读到已写入卡的记录。
+  *
+  *          ===================================================================
+  *                                注意
+  *          ===================================================================
+  *           1. 写缓冲与查询缓冲由SDMMC1的IDMA直接访问，Logger_Init检查其地址
+  *           2. MSC与记录共用SDMMC1上的同一张卡。卡平时由Logger_Task(在
+  *              StartTask02中调用)挂载，MSC的STORAGE_xxx回调报告介质未就绪。
+  *              Logger_Release(1)后记录任务结束查询、关闭文件并卸载卡，之后
+  *              MSC才能访问；MSC每次访问卡都在Logger_CardBegin/Logger_CardEnd
+  *              之间。Logger_Release(0)后记录任务等MSC的访问结束再重新挂载。
+  *              卡交出期间队列照常接收，满后丢弃并计数
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "logger.h"
+#include "dlog.h"
+#include "main.h"
+#include "cmsis_os.h"
+#include "fatfs.h"
+#include "string.h"
+
+/* Define --------------------------------------------------------------------*/
+#define LOGGER_QUEUE_MASK			(LOGGER_QUEUE_SIZE - 1U)
+#define LOGGER_SECTOR_SIZE			512U
+
+#define LOGGER_STATE_IDLE			0U		/**< 卡未挂载 */
+#define LOGGER_STATE_READY			1U		/**< 已挂载，未打开文件 */
+#define LOGGER_STATE_OPEN			2U		/**< 正在记录 */
+
+#define LOGGER_QUERY_IDLE			0U
+#define LOGGER_QUERY_RUN			1U		/**< 正在读取 */
+#define LOGGER_QUERY_END			2U		/**< 等待送出END记录 */
+
+/* 文件名LOGnnnnn.BIN */
+#define LOGGER_NAME_DIGITS			5U
+#define LOGGER_INDEX_MAX			99999UL
+
+/* Typedef -------------------------------------------------------------------*/
+typedef struct
+{
+	FIL *Fp;						/**< 正在读取的文件，查询当前文件时指向Logger_File */
+	uint32_t File;					/**< 文件序号 */
+	uint32_t Start;					/**< 起始Tick */
+	uint32_t Stop;					/**< 结束Tick */
+	uint32_t Offset;				/**< 下一次读取的文件偏移 */
+	uint32_t Len;					/**< 读缓冲中的数据量 */
+	uint32_t Pos;					/**< 读缓冲中的解析位置 */
+	uint32_t Records;				/**< 已送出的记录数 */
+	uint8_t  State;
+	uint8_t  Status;				/**< LOGGER_QUERY_xxx，END记录中返回 */
+}LOGGER_QueryTypeDef;
+
+/* Variables -----------------------------------------------------------------*/
+static uint8_t Logger_Queue[LOGGER_QUEUE_SIZE];
+static volatile uint32_t Logger_Head;				/**< 生产者写入位置 */
+static volatile uint32_t Logger_Tail;				/**< 消费者读取位置 */
+
+static uint8_t Logger_Buffer[LOGGER_WRITE_SIZE] __attribute__((aligned(32)));
+static uint32_t Logger_Fill;						/**< 写缓冲中的数据量 */
+
+static FIL Logger_File;
+static DWORD Logger_FileMap[LOGGER_LINKMAP_SIZE];	/**< 当前文件的簇链映射表 */
+static uint8_t Logger_State;
+static uint32_t Logger_FileSize;					/**< 当前文件的大小上限 */
+static uint32_t Logger_OpenTick;					/**< 当前文件的创建时间 */
+static uint32_t Logger_SyncTick;					/**< 上一次同步的时间 */
+static uint32_t Logger_SyncBytes;					/**< 上一次同步以来写入的字节数 */
+static uint8_t Logger_Dirty;						/**< 上一次同步以来有写入 */
+static volatile uint32_t Logger_FlushReq;			/**< 交出暂存数据的请求序号，只由记录任务修改 */
+static volatile uint32_t Logger_FlushAck;			/**< 生产者已完成的请求序号，只由生产者修改 */
+static uint8_t Logger_FlushWait;					/**< 已发出请求，等待应答 */
+static uint32_t Logger_FlushTick;					/**< 发出请求的时间 */
+
+static LOGGER_OutputTypeDef Logger_Output;
+static uint8_t Logger_Cmd[LOGGER_CMD_SIZE];
+static volatile uint8_t Logger_CmdPending;			/**< USB中断收到命令，等待任务处理 */
+static LOGGER_QueryTypeDef Logger_Query;
+static FIL Logger_QueryFile;
+static DWORD Logger_QueryMap[LOGGER_LINKMAP_SIZE];
+static uint8_t Logger_QueryBuf[LOGGER_QUERY_BUF_SIZE] __attribute__((aligned(32)));
+
+static volatile uint8_t Logger_ReleaseReq;			/**< 要求把卡交给MSC */
+static volatile uint8_t Logger_Released;			/**< 卡已卸载，MSC可以访问，只由记录任务修改 */
+static volatile uint8_t Logger_CardBusy;			/**< MSC正在访问卡 */
+
+static LOGGER_StatsTypeDef Logger_Stats;
+
+/* ------------------------------------ Queue Funtion ------------------------------------ */
+
+/**
+  * @brief  Logger_Init 清空队列与统计，需在任何任务调用Logger_Write之前执行
+  * @param  output: 查询结果的输出函数，为NULL时不接受查询命令
+  */
+void Logger_Init(LOGGER_OutputTypeDef output)
+{
+	Logger_Head = 0U;
+	Logger_Tail = 0U;
+	Logger_Fill = 0U;
+	Logger_State = LOGGER_STATE_IDLE;
+	Logger_Output = output;
+	Logger_CmdPending = 0U;
+	Logger_FlushReq = 0U;
+	Logger_FlushAck = 0U;
+	Logger_FlushWait = 0U;
+	Logger_ReleaseReq = 0U;
+	Logger_Released = 0U;
+	Logger_CardBusy = 0U;
+	if(!DMA_BUFFER_OK(Logger_Buffer) || !DMA_BUFFER_OK(Logger_QueryBuf))
+		Error_Handler();
+	memset(&Logger_Query, 0, sizeof(Logger_Query));
+	memset(&Logger_Stats, 0, sizeof(Logger_Stats));
+}
+
+/**
+  * @brief  Logger_Get32 读取小端32位数
+  */
+static uint32_t Logger_Get32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+  * @brief  Logger_Set32 写入小端32位数
+  */
+static void Logger_Set32(uint8_t *p, uint32_t value)
+{
+	p[0] = (uint8_t)value;
+	p[1] = (uint8_t)(value >> 8);
+	p[2] = (uint8_t)(value >> 16);
+	p[3] = (uint8_t)(value >> 24);
+}
+
+/**
+  * @brief  Logger_Header 填写记录头
+  */
+static void Logger_Header(uint8_t *p, uint8_t type, uint16_t len, uint32_t tick)
+{
+	p[0] = LOGGER_SYNC;
+	p[1] = type;
+	p[2] = (uint8_t)len;
+	p[3] = (uint8_t)(len >> 8);
+	Logger_Set32(&p[4], tick);
+}
+
+/**
+  * @brief  Logger_Put 从pos开始向队列写入数据，处理回绕
+  */
+static void Logger_Put(uint32_t pos, const uint8_t *data, uint32_t len)
+{
+	uint32_t index = pos & LOGGER_QUEUE_MASK;
+	uint32_t first = LOGGER_QUEUE_SIZE - index;
+
+	if(len == 0U)
+		return;
+	if(first > len)
+		first = len;
+	memcpy(&Logger_Queue[index], data, first);
+	memcpy(Logger_Queue, data + first, len - first);
+}
+
+/**
+  * @brief  Logger_WritePrefix 写入一条由两段数据拼成的记录
+  * @param  type: LOGGER_TYPE_xxx
+  * @param  prefix: 负载的第一段，可为NULL
+  * @param  plen: 第一段长度
+  * @param  data: 负载的第二段
+  * @param  len: 第二段长度
+  * @retval 0:成功 1:记录过长或队列已满，记录被丢弃
+  */
+uint8_t Logger_WritePrefix(uint8_t type, const void *prefix, uint16_t plen, const void *data, uint16_t len)
+{
+	uint8_t header[LOGGER_HEADER_SIZE];
+	uint32_t head = Logger_Head;
+	uint32_t total = LOGGER_HEADER_SIZE + (uint32_t)plen + len;
+	uint32_t depth = head - Logger_Tail;
+
+	if(((uint32_t)plen + len > LOGGER_RECORD_MAX) || (LOGGER_QUEUE_SIZE - depth < total))
+	{
+		Logger_Stats.Dropped++;
+		return 1U;
+	}
+
+	Logger_Header(header, type, (uint16_t)(plen + len), osKernelGetTickCount());
+	Logger_Put(head, header, LOGGER_HEADER_SIZE);
+	Logger_Put(head + LOGGER_HEADER_SIZE, (const uint8_t *)prefix, plen);
+	Logger_Put(head + LOGGER_HEADER_SIZE + plen, (const uint8_t *)data, len);
+
+	/* 数据写完后才发布新的头位置 */
+	__DMB();
+	Logger_Head = head + total;
+
+	depth += total;
+	if(depth > Logger_Stats.QueuePeak)
+		Logger_Stats.QueuePeak = depth;
+	Logger_Stats.Records++;
+
+	return 0U;
+}
+
+/**
+  * @brief  Logger_Write 写入一条记录，不等待SD卡
+  * @param  type: LOGGER_TYPE_xxx
+  * @param  data: 负载
+  * @param  len: 负载长度，不超过LOGGER_RECORD_MAX
+  * @retval 0:成功 1:记录过长或队列已满，记录被丢弃
+  */
+uint8_t Logger_Write(uint8_t type, const void *data, uint16_t len)
+{
+	return Logger_WritePrefix(type, NULL, 0U, data, len);
+}
+
+/**
+  * @brief  Logger_FlushRequest 读取记录任务最近一次请求的序号
+  * @note   与生产者上次完成的序号不同时，生产者应把暂存的数据写入队列，
+  *         再以该序号调用Logger_FlushDone。
+  * @retval 请求序号
+  */
+uint32_t Logger_FlushRequest(void)
+{
+	return Logger_FlushReq;
+}
+
+/**
+  * @brief  Logger_FlushDone 暂存的数据已写入队列
+  * @param  request: Logger_FlushRequest返回的序号
+  */
+void Logger_FlushDone(uint32_t request)
+{
+	/* 队列中的记录先于应答可见 */
+	__DMB();
+	Logger_FlushAck = request;
+}
+
+/**
+  * @brief  Logger_Drain 把队列中的整条记录移入写缓冲，最多填到limit
+  * @note   块的第一条记录之前插入INDEX记录，其Tick取该记录的Tick。
+  * @param  limit: 缓冲填充上限，即到下一个块边界的距离
+  * @retval 1:下一条记录放不下 0:队列已空
+  */
+static uint8_t Logger_Drain(uint32_t limit)
+{
+	uint32_t tail = Logger_Tail;
+	uint32_t head = Logger_Head;
+	uint32_t offset = (uint32_t)f_tell(&Logger_File);
+	uint32_t size, index, first;
+	uint8_t blocked = 0U;
+
+	/* 读到头位置后再读数据 */
+	__DMB();
+	while(tail != head)
+	{
+		size = LOGGER_HEADER_SIZE + ((uint32_t)Logger_Queue[(tail + 2U) & LOGGER_QUEUE_MASK]
+				| ((uint32_t)Logger_Queue[(tail + 3U) & LOGGER_QUEUE_MASK] << 8));
+
+		if((Logger_Fill == 0U) && ((offset % LOGGER_WRITE_SIZE) == 0U))
+		{
+			Logger_Header(Logger_Buffer, LOGGER_TYPE_INDEX, LOGGER_INDEX_SIZE,
+					(uint32_t)Logger_Queue[(tail + 4U) & LOGGER_QUEUE_MASK]
+					| ((uint32_t)Logger_Queue[(tail + 5U) & LOGGER_QUEUE_MASK] << 8)
+					| ((uint32_t)Logger_Queue[(tail + 6U) & LOGGER_QUEUE_MASK] << 16)
+					| ((uint32_t)Logger_Queue[(tail + 7U) & LOGGER_QUEUE_MASK] << 24));
+			Logger_Set32(&Logger_Buffer[LOGGER_HEADER_SIZE], Logger_Stats.FileIndex);
+			Logger_Set32(&Logger_Buffer[LOGGER_HEADER_SIZE + 4U], offset / LOGGER_WRITE_SIZE);
+			Logger_Fill = LOGGER_HEADER_SIZE + LOGGER_INDEX_SIZE;
+		}
+
+		if(size > limit - Logger_Fill)
+		{
+			blocked = 1U;
+			break;
+		}
+
+		index = tail & LOGGER_QUEUE_MASK;
+		first = LOGGER_QUEUE_SIZE - index;
+		if(first > size)
+			first = size;
+		memcpy(&Logger_Buffer[Logger_Fill], &Logger_Queue[index], first);
+		memcpy(&Logger_Buffer[Logger_Fill + first], Logger_Queue, size - first);
+
+		Logger_Fill += size;
+		tail += size;
+	}
+
+	/* 数据取走后才释放空间 */
+	__DMB();
+	Logger_Tail = tail;
+
+	return blocked;
+}
+
+/* ------------------------------------ File Funtion ------------------------------------ */
+
+/**
+  * @brief  Logger_Name 生成文件路径，如"0:/LOG00001.BIN"
+  */
+static void Logger_Name(char *path, uint32_t index)
+{
+	uint32_t i;
+
+	strcpy(path, SDPath);
+	path += strlen(path);
+	*path++ = 'L';
+	*path++ = 'O';
+	*path++ = 'G';
+	for(i = LOGGER_NAME_DIGITS; i != 0U; i--)
+	{
+		path[i - 1U] = (char)('0' + index % 10U);
+		index /= 10U;
+	}
+	strcpy(path + LOGGER_NAME_DIGITS, ".BIN");
+}
+
+/**
+  * @brief  Logger_LastIndex 查找根目录中已有记录文件的最大序号
+  * @retval 没有记录文件时为0
+  */
+static uint32_t Logger_LastIndex(void)
+{
+	DIR dir;
+	FILINFO info;
+	uint32_t last = 0U, index, i;
+
+	if(f_opendir(&dir, SDPath) != FR_OK)
+		return 0U;
+
+	while((f_readdir(&dir, &info) == FR_OK) && (info.fname[0] != '\0'))
+	{
+		if((strlen(info.fname) != 3U + LOGGER_NAME_DIGITS + 4U) || (strncmp(info.fname, "LOG", 3U) != 0) || (strcmp(&info.fname[3U + LOGGER_NAME_DIGITS], ".BIN") != 0))
+			continue;
+		index = 0U;
+		for(i = 3U; i < 3U + LOGGER_NAME_DIGITS; i++)
+		{
+			if((info.fname[i] < '0') || (info.fname[i] > '9'))
+				break;
+			index = index * 10U + (uint32_t)(info.fname[i] - '0');
+		}
+		if((i == 3U + LOGGER_NAME_DIGITS) && (index > last))
+			last = index;
+	}
+	f_closedir(&dir);
+
+	return last;
+}
+
+/**
+  * @brief  Logger_FastSeek 为文件建立簇链映射表，开启快速定位
+  * @note   映射表放不下时关闭快速定位，文件仍可正常读写。
+  */
+static void Logger_FastSeek(FIL *fp, DWORD *map)
+{
+	map[0] = LOGGER_LINKMAP_SIZE;
+	fp->cltbl = map;
+	if(f_lseek(fp, CREATE_LINKMAP) != FR_OK)
+		fp->cltbl = NULL;
+}
+
+static void Logger_QueryFinish(uint8_t status);
+static void Logger_QueryDetach(void);
+
+/**
+  * @brief  Logger_Error FatFs出错，放弃当前文件并重新挂载
+  */
+static void Logger_Error(void)
+{
+	Logger_Stats.WriteErrors++;
+	DLOG("logger: error in file %u, %u errors", Logger_Stats.FileIndex, Logger_Stats.WriteErrors);
+	if(Logger_Query.State == LOGGER_QUERY_RUN)
+		Logger_QueryFinish(LOGGER_QUERY_ERROR);
+	f_close(&Logger_File);
+	f_mount(NULL, SDPath, 0U);
+	Logger_Fill = 0U;
+	Logger_State = LOGGER_STATE_IDLE;
+}
+
+/**
+  * @brief  Logger_Open 创建下一个记录文件并预分配连续空间
+  * @note   找不到足够大的连续空间时逐次减半，都失败时不预分配，
+  *         文件仍按LOGGER_FILE_SIZE_MIN切换。
+  * @retval FatFs返回值
+  */
+static FRESULT Logger_Open(void)
+{
+	char path[16];
+	FRESULT res;
+	uint32_t size;
+
+	if(Logger_Stats.FileIndex >= LOGGER_INDEX_MAX)
+		return FR_DENIED;
+	Logger_Name(path, Logger_Stats.FileIndex + 1U);
+
+	/* 查询当前文件时经同一个文件对象读取 */
+	res = f_open(&Logger_File, path, FA_CREATE_ALWAYS | FA_WRITE | FA_READ);
+	if(res != FR_OK)
+		return res;
+
+	for(size = LOGGER_FILE_SIZE; size >= LOGGER_FILE_SIZE_MIN; size >>= 1)
+	{
+		res = f_expand(&Logger_File, size, 1U);
+		if(res == FR_OK)
+			break;
+		if(res != FR_DENIED)
+		{
+			f_close(&Logger_File);
+			return res;
+		}
+	}
+	if(res == FR_OK)
+	{
+		Logger_FileSize = size;
+		/* 快速定位模式下文件不能变长，只在预分配成功时开启 */
+		Logger_FastSeek(&Logger_File, Logger_FileMap);
+	}
+	else
+		Logger_FileSize = LOGGER_FILE_SIZE_MIN;
+
+	Logger_Stats.FileIndex++;
+	Logger_Stats.Files++;
+	Logger_OpenTick = osKernelGetTickCount();
+	Logger_State = LOGGER_STATE_OPEN;
+
+	return FR_OK;
+}
+
+/**
+  * @brief  Logger_Limit 填到下一个块边界所需的缓冲数据量
+  */
+static uint32_t Logger_Limit(void)
+{
+	return LOGGER_WRITE_SIZE - (uint32_t)(f_tell(&Logger_File) % LOGGER_WRITE_SIZE);
+}
+
+/**
+  * @brief  Logger_Flush 写出缓冲中的全部数据
+  * @param  size: 补0后的写入长度，为扇区大小的整数倍且不超过到块边界的距离，
+  *         缓冲为空时也写入，用于把块尾整体补0
+  * @retval FatFs返回值
+  */
+static FRESULT Logger_Flush(uint32_t size)
+{
+	FRESULT res;
+	UINT written;
+	uint32_t start;
+
+	if(size == 0U)
+		return FR_OK;
+
+	memset(&Logger_Buffer[Logger_Fill], 0, size - Logger_Fill);
+
+	start = osKernelGetTickCount();
+	res = f_write(&Logger_File, Logger_Buffer, size, &written);
+	Logger_Stats.WriteTime += osKernelGetTickCount() - start;
+	if((res == FR_OK) && (written != size))
+		res = FR_DENIED;
+
+	Logger_Stats.BytesWritten += written;
+	Logger_SyncBytes += written;
+	Logger_Fill = 0U;
+	Logger_Dirty = 1U;
+
+	return res;
+}
+
+/**
+  * @brief  Logger_Sync 补0到扇区边界写出缓冲，并同步目录项与FAT
+  * @retval FatFs返回值
+  */
+static FRESULT Logger_Sync(void)
+{
+	FRESULT res;
+	uint32_t now, start;
+
+	res = Logger_Flush((Logger_Fill + LOGGER_SECTOR_SIZE - 1U) & ~(LOGGER_SECTOR_SIZE - 1U));
+	if((res == FR_OK) && (Logger_Dirty != 0U))
+	{
+		start = osKernelGetTickCount();
+		res = f_sync(&Logger_File);
+		Logger_Stats.WriteTime += osKernelGetTickCount() - start;
+		Logger_Dirty = 0U;
+	}
+
+	now = osKernelGetTickCount();
+	if(now != Logger_SyncTick)
+		Logger_Stats.Throughput = (uint32_t)(((uint64_t)Logger_SyncBytes * 1000U) / (now - Logger_SyncTick));
+	Logger_SyncBytes = 0U;
+	Logger_SyncTick = now;
+
+	return res;
+}
+
+/**
+  * @brief  Logger_FlushReady 按时同步之前让生产者交出暂存的数据
+  * @note   第一次调用只发出请求；生产者应答或超过LOGGER_FLUSH_WAIT_MS后，把队列中的记录
+  *         移入写缓冲再返回1。下一条记录放不下时返回0，由主循环先写出整块。
+  * @param  now: 当前时间
+  * @retval 1:可以同步 0:继续等待
+  */
+static uint8_t Logger_FlushReady(uint32_t now)
+{
+	uint32_t limit;
+
+	if(Logger_FlushWait == 0U)
+	{
+		Logger_FlushReq++;
+		Logger_FlushTick = now;
+		Logger_FlushWait = 1U;
+		return 0U;
+	}
+	if((Logger_FlushAck != Logger_FlushReq) && (now - Logger_FlushTick < LOGGER_FLUSH_WAIT_MS))
+		return 0U;
+
+	limit = Logger_Limit();
+	if((Logger_Drain(limit) != 0U) || (Logger_Fill == limit))
+		return 0U;
+	Logger_FlushWait = 0U;
+
+	return 1U;
+}
+
+/**
+  * @brief  Logger_Close 同步后截掉预分配中未使用的部分并关闭文件
+  * @retval FatFs返回值
+  */
+static FRESULT Logger_Close(void)
+{
+	FRESULT res;
+
+	res = Logger_Sync();
+	if(res == FR_OK)
+		res = f_truncate(&Logger_File);
+	if(res == FR_OK)
+		res = f_close(&Logger_File);
+	Logger_State = LOGGER_STATE_READY;
+
+	/* 正在查询的是这个文件，改为单独打开继续读取 */
+	if((res == FR_OK) && (Logger_Query.Fp == &Logger_File))
+		Logger_QueryDetach();
+
+	return res;
+}
+
+/* ------------------------------------ Query Funtion ------------------------------------ */
+
+/**
+  * @brief  Logger_Command 收到区间查询命令，在USB中断中调用
+  * @note   命令由FatFs_Task处理，上一条命令未处理完时拒绝新命令。
+  * @param  buf: 命令数据，格式见logger.h
+  * @param  len: 命令长度
+  * @retval 0成功，格式错误或忙返回1
+  */
+uint8_t Logger_Command(const uint8_t *buf, uint16_t len)
+{
+	if((Logger_Output == NULL) || (Logger_CmdPending != 0U) || (len == 0U))
+		return 1U;
+	if((buf[0] == LOGGER_OP_QUERY) && (len < LOGGER_CMD_SIZE))
+		return 1U;
+	if((buf[0] != LOGGER_OP_QUERY) && (buf[0] != LOGGER_OP_ABORT))
+		return 1U;
+
+	memset(Logger_Cmd, 0, sizeof(Logger_Cmd));
+	memcpy(Logger_Cmd, buf, (len < LOGGER_CMD_SIZE) ? len : LOGGER_CMD_SIZE);
+	__DMB();
+	Logger_CmdPending = 1U;
+
+	return 0U;
+}
+
+/**
+  * @brief  Logger_ReadAt 从指定偏移读取，读当前文件时恢复写入位置
+  */
+static FRESULT Logger_ReadAt(FIL *fp, uint32_t offset, uint8_t *buf, uint32_t len, UINT *read)
+{
+	FSIZE_t pos = f_tell(fp);
+	FRESULT res, ret;
+
+	*read = 0U;
+	res = f_lseek(fp, offset);
+	if(res == FR_OK)
+		res = f_read(fp, buf, len, read);
+	if(fp == &Logger_File)
+	{
+		ret = f_lseek(fp, pos);
+		if(res == FR_OK)
+			res = ret;
+	}
+
+	return res;
+}
+
+/**
+  * @brief  Logger_QueryLimit 查询可读取的数据量
+  * @note   当前文件只读到已写入卡的位置，其余文件读到文件结尾。
+  */
+static uint32_t Logger_QueryLimit(void)
+{
+	if(Logger_Query.Fp == &Logger_File)
+		return (uint32_t)f_tell(&Logger_File);
+	return (uint32_t)f_size(Logger_Query.Fp);
+}
+
+/**
+  * @brief  Logger_QueryOpen 以只读方式打开记录文件并开启快速定位
+  */
+static FRESULT Logger_QueryOpen(uint32_t file)
+{
+	char path[16];
+	FRESULT res;
+
+	Logger_Name(path, file);
+	res = f_open(&Logger_QueryFile, path, FA_READ | FA_OPEN_EXISTING);
+	if(res == FR_OK)
+	{
+		Logger_FastSeek(&Logger_QueryFile, Logger_QueryMap);
+		Logger_Query.Fp = &Logger_QueryFile;
+	}
+
+	return res;
+}
+
+/**
+  * @brief  Logger_QueryDetach 正在查询的当前文件被关闭，单独打开后继续
+  */
+static void Logger_QueryDetach(void)
+{
+	Logger_Query.Fp = NULL;
+	if(Logger_QueryOpen(Logger_Query.File) != FR_OK)
+		Logger_QueryFinish(LOGGER_QUERY_ERROR);
+}
+
+/**
+  * @brief  Logger_QueryFinish 结束查询，等待送出END记录
+  */
+static void Logger_QueryFinish(uint8_t status)
+{
+	if(Logger_Query.Fp == &Logger_QueryFile)
+		f_close(&Logger_QueryFile);
+	Logger_Query.Fp = NULL;
+	Logger_Query.Status = status;
+	Logger_Query.State = LOGGER_QUERY_END;
+}
+
+/**
+  * @brief  Logger_QueryProbe 读取块开头的INDEX记录
+  * @param  block: 块号
+  * @param  tick: 块内第一条记录的Tick
+  * @retval 0:有效 1:不是本文件的索引或读取失败
+  */
+static uint8_t Logger_QueryProbe(uint32_t block, uint32_t *tick)
+{
+	uint8_t rec[LOGGER_HEADER_SIZE + LOGGER_INDEX_SIZE];
+	UINT read;
+
+	if((Logger_ReadAt(Logger_Query.Fp, block * LOGGER_WRITE_SIZE, rec, sizeof(rec), &read) != FR_OK)
+		|| (read != sizeof(rec)) || (rec[0] != LOGGER_SYNC) || (rec[1] != LOGGER_TYPE_INDEX)
+		|| (Logger_Get32(&rec[LOGGER_HEADER_SIZE]) != Logger_Query.File)
+		|| (Logger_Get32(&rec[LOGGER_HEADER_SIZE + 4U]) != block))
+		return 1U;
+
+	*tick = Logger_Get32(&rec[4]);
+	return 0U;
+}
+
+/**
+  * @brief  Logger_QueryBegin 打开文件，二分查找起始块
+  */
+static void Logger_QueryBegin(void)
+{
+	LOGGER_QueryTypeDef *q = &Logger_Query;
+	uint32_t file = Logger_Get32(&Logger_Cmd[1]);
+	uint32_t lo, hi, mid, tick, limit;
+
+	q->Start = Logger_Get32(&Logger_Cmd[5]);
+	q->Stop = Logger_Get32(&Logger_Cmd[9]);
+	q->Records = 0U;
+	q->Len = 0U;
+	q->Pos = 0U;
+	q->Fp = NULL;
+	q->State = LOGGER_QUERY_RUN;
+
+	if(Logger_State == LOGGER_STATE_IDLE)
+	{
+		Logger_QueryFinish(LOGGER_QUERY_NO_FILE);
+		return;
+	}
+
+	if((file == 0U) && (Logger_State != LOGGER_STATE_OPEN))
+	{
+		Logger_QueryFinish(LOGGER_QUERY_NO_FILE);
+		return;
+	}
+
+	if((file == 0U) || ((file == Logger_Stats.FileIndex) && (Logger_State == LOGGER_STATE_OPEN)))
+	{
+		/* 先写出缓冲，使查询能读到最新的记录 */
+		if(Logger_Sync() != FR_OK)
+		{
+			Logger_Error();
+			return;
+		}
+		q->File = Logger_Stats.FileIndex;
+		q->Fp = &Logger_File;
+	}
+	else
+	{
+		q->File = file;
+		if(Logger_QueryOpen(file) != FR_OK)
+		{
+			Logger_QueryFinish(LOGGER_QUERY_NO_FILE);
+			return;
+		}
+	}
+
+	/* 找到INDEX的Tick不晚于Start的最后一块，无效块视为在Start之后 */
+	limit = Logger_QueryLimit();
+	lo = 0U;
+	hi = (limit != 0U) ? (limit - 1U) / LOGGER_WRITE_SIZE : 0U;
+	while(lo < hi)
+	{
+		mid = lo + (hi - lo + 1U) / 2U;
+		if((Logger_QueryProbe(mid, &tick) == 0U) && (tick <= q->Start))
+			lo = mid;
+		else
+			hi = mid - 1U;
+	}
+	q->Offset = lo * LOGGER_WRITE_SIZE;
+}
+
+/**
+  * @brief  Logger_QueryStep 顺序读取并送出区间内的记录
+  * @note   输出空间不足时保留当前记录，下一轮重试。
+  * @retval 1:有进展 0:等待输出
+  */
+static uint8_t Logger_QueryStep(void)
+{
+	LOGGER_QueryTypeDef *q = &Logger_Query;
+	const uint8_t *p;
+	uint32_t avail, size, tick, limit, n, reads = 0U;
+	UINT read;
+
+	for(;;)
+	{
+		avail = q->Len - q->Pos;
+		p = &Logger_QueryBuf[q->Pos];
+
+		/* 跳过记录之间的填充，其他字节说明已到数据结尾 */
+		if((avail != 0U) && (p[0] != LOGGER_SYNC))
+		{
+			if(p[0] != 0U)
+			{
+				Logger_QueryFinish(LOGGER_QUERY_OK);
+				return 1U;
+			}
+			q->Pos++;
+			continue;
+		}
+
+		size = 0U;
+		if(avail >= LOGGER_HEADER_SIZE)
+		{
+			size = LOGGER_HEADER_SIZE + ((uint32_t)p[2] | ((uint32_t)p[3] << 8));
+			if(size > LOGGER_HEADER_SIZE + LOGGER_RECORD_MAX)
+			{
+				Logger_QueryFinish(LOGGER_QUERY_OK);
+				return 1U;
+			}
+		}
+
+		/* 缓冲中没有完整的记录，读入更多数据 */
+		if((size == 0U) || (avail < size))
+		{
+			if(reads == LOGGER_QUERY_BURST)
+				return 1U;
+			reads++;
+
+			memmove(Logger_QueryBuf, p, avail);
+			q->Len = avail;
+			q->Pos = 0U;
+
+			limit = Logger_QueryLimit();
+			n = LOGGER_QUERY_BUF_SIZE - avail;
+			if(q->Offset >= limit)
+				n = 0U;
+			else if(n > limit - q->Offset)
+				n = limit - q->Offset;
+			if(n == 0U)
+			{
+				Logger_QueryFinish(LOGGER_QUERY_OK);
+				return 1U;
+			}
+
+			if(Logger_ReadAt(q->Fp, q->Offset, &Logger_QueryBuf[avail], n, &read) != FR_OK)
+			{
+				Logger_QueryFinish(LOGGER_QUERY_ERROR);
+				return 1U;
+			}
+			if(read == 0U)
+			{
+				Logger_QueryFinish(LOGGER_QUERY_OK);
+				return 1U;
+			}
+			q->Offset += read;
+			q->Len += read;
+			continue;
+		}
+
+		tick = Logger_Get32(&p[4]);
+		if(p[1] == LOGGER_TYPE_INDEX)
+		{
+			/* 不属于本文件的索引是掉电后预分配空间中的旧数据 */
+			if(Logger_Get32(&p[LOGGER_HEADER_SIZE]) != q->File)
+			{
+				Logger_QueryFinish(LOGGER_QUERY_OK);
+				return 1U;
+			}
+		}
+		else if(tick > q->Stop)
+		{
+			Logger_QueryFinish(LOGGER_QUERY_OK);
+			return 1U;
+		}
+		else if(tick >= q->Start)
+		{
+			if(Logger_Output(p, size) != 0U)
+				return (reads != 0U) ? 1U : 0U;
+			q->Records++;
+			Logger_Stats.QueryRecords++;
+		}
+		q->Pos += size;
+	}
+}
+
+/**
+  * @brief  Logger_QueryPoll 处理查询命令并推进正在进行的查询
+  * @retval 1:有进展 0:空闲或等待输出
+  */
+static uint8_t Logger_QueryPoll(void)
+{
+	LOGGER_QueryTypeDef *q = &Logger_Query;
+	uint8_t end[LOGGER_HEADER_SIZE + LOGGER_END_SIZE];
+
+	if(Logger_CmdPending != 0U)
+	{
+		/* 新命令先中止进行中的查询，送出END后再执行 */
+		if(q->State == LOGGER_QUERY_RUN)
+			Logger_QueryFinish(LOGGER_QUERY_ABORTED);
+		else if(q->State == LOGGER_QUERY_IDLE)
+		{
+			if(Logger_Cmd[0] == LOGGER_OP_QUERY)
+				Logger_QueryBegin();
+			Logger_CmdPending = 0U;
+		}
+	}
+
+	switch(q->State)
+	{
+		case LOGGER_QUERY_RUN:
+			return Logger_QueryStep();
+
+		case LOGGER_QUERY_END:
+			Logger_Header(end, LOGGER_TYPE_END, LOGGER_END_SIZE, osKernelGetTickCount());
+			end[LOGGER_HEADER_SIZE] = q->Status;
+			end[LOGGER_HEADER_SIZE + 1U] = 0U;
+			end[LOGGER_HEADER_SIZE + 2U] = 0U;
+			end[LOGGER_HEADER_SIZE + 3U] = 0U;
+			Logger_Set32(&end[LOGGER_HEADER_SIZE + 4U], q->Records);
+			if(Logger_Output(end, sizeof(end)) != 0U)
+				return 0U;
+			q->State = LOGGER_QUERY_IDLE;
+			Logger_Stats.Queries++;
+			return 1U;
+
+		default:
+			return 0U;
+	}
+}
+
+/* ------------------------------------ Card Funtion ------------------------------------ */
+
+/**
+  * @brief  Logger_Release 把卡交给MSC或收回，在任务中调用
+  * @note   只登记请求，由记录任务执行，用Logger_CardFree查询卡是否已交出。
+  * @param  release: 1:交给MSC 0:收回继续记录
+  */
+void Logger_Release(uint8_t release)
+{
+	Logger_ReleaseReq = release;
+}
+
+/**
+  * @brief  Logger_CardFree 查询卡是否已交出
+  * @retval 1:记录任务已卸载卡，MSC可以访问 0:卡由记录任务使用
+  */
+uint8_t Logger_CardFree(void)
+{
+	return Logger_Released;
+}
+
+/**
+  * @brief  Logger_CardBegin MSC访问卡之前调用，在USB中断或任务中调用
+  * @retval 0:可以访问，结束后调用Logger_CardEnd 1:卡由记录任务使用
+  */
+uint8_t Logger_CardBegin(void)
+{
+	uint32_t primask;
+	uint8_t ret = 1U;
+
+	/* 与记录任务收回卡互斥，检查与登记之间不能被收回 */
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if(Logger_Released != 0U)
+	{
+		Logger_CardBusy = 1U;
+		ret = 0U;
+	}
+	__set_PRIMASK(primask);
+
+	return ret;
+}
+
+/**
+  * @brief  Logger_CardEnd MSC访问卡结束
+  */
+void Logger_CardEnd(void)
+{
+	__DMB();
+	Logger_CardBusy = 0U;
+}
+
+/**
+  * @brief  Logger_Unmount 结束查询，关闭文件并卸载卡，准备交给MSC
+  */
+static void Logger_Unmount(void)
+{
+	if(Logger_Query.State == LOGGER_QUERY_RUN)
+		Logger_QueryFinish(LOGGER_QUERY_NO_FILE);
+
+	if((Logger_State == LOGGER_STATE_OPEN) && (Logger_Close() != FR_OK))
+		Logger_Error();
+	else
+	{
+		f_mount(NULL, SDPath, 0U);
+		Logger_Fill = 0U;
+		Logger_State = LOGGER_STATE_IDLE;
+	}
+	Logger_FlushWait = 0U;
+	DLOG("logger: card released, file %u", Logger_Stats.FileIndex);
+}
+
+/**
+  * @brief  Logger_Reclaim 收回交给MSC的卡
+  * @retval 0:已收回 1:MSC正在访问，稍后重试
+  */
+static uint8_t Logger_Reclaim(void)
+{
+	uint32_t primask;
+	uint8_t ret = 1U;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if(Logger_CardBusy == 0U)
+	{
+		Logger_Released = 0U;
+		ret = 0U;
+	}
+	__set_PRIMASK(primask);
+
+	return ret;
+}
+
+/* ------------------------------------ Task Funtion ------------------------------------ */
+
+/**
+  * @brief  Logger_Task 记录任务主循环，在FatFs_Task中调用，不返回
+  */
+void Logger_Task(void)
+{
+	FRESULT res;
+	uint32_t limit, now;
+	uint8_t busy, rotate;
+
+	Logger_SyncTick = osKernelGetTickCount();
+
+	for(;;)
+	{
+		/* 区间查询与记录写入交替进行 */
+		busy = Logger_QueryPoll();
+
+		/* 卡交给MSC期间不挂载，新的查询返回NO_FILE */
+		if(Logger_ReleaseReq != 0U)
+		{
+			if(Logger_Released == 0U)
+			{
+				Logger_Unmount();
+				__DMB();
+				Logger_Released = 1U;
+			}
+			if(busy == 0U)
+				osDelay(LOGGER_RELEASE_POLL_MS);
+			continue;
+		}
+		if((Logger_Released != 0U) && (Logger_Reclaim() != 0U))
+		{
+			osDelay(1);
+			continue;
+		}
+
+		if(Logger_State == LOGGER_STATE_IDLE)
+		{
+			if(f_mount(&SDFatFS, SDPath, 1U) != FR_OK)
+			{
+				osDelay(LOGGER_RETRY_MS);
+				continue;
+			}
+			Logger_Stats.FileIndex = Logger_LastIndex();
+			Logger_State = LOGGER_STATE_READY;
+		}
+
+		if(Logger_State == LOGGER_STATE_READY)
+		{
+			if(Logger_Open() != FR_OK)
+			{
+				Logger_Error();
+				osDelay(LOGGER_RETRY_MS);
+				continue;
+			}
+		}
+
+		/* 块内放不下下一条记录时写出：文件最后一块则切换文件，否则补0到块尾 */
+		limit = Logger_Limit();
+		if((Logger_Drain(limit) != 0U) || (Logger_Fill == limit))
+		{
+			busy = 1U;
+			if(f_tell(&Logger_File) + limit >= Logger_FileSize)
+				res = Logger_Close();
+			else
+				res = Logger_Flush(limit);
+			if(res != FR_OK)
+				Logger_Error();
+			if(Logger_State != LOGGER_STATE_OPEN)
+				continue;
+		}
+
+		/* 持续满速写入时也按时切换与同步，之前先等生产者交出暂存的数据 */
+		now = osKernelGetTickCount();
+		rotate = (uint8_t)((LOGGER_ROTATE_MS != 0U) && (now - Logger_OpenTick >= LOGGER_ROTATE_MS));
+		if(((rotate != 0U) || (now - Logger_SyncTick >= LOGGER_SYNC_MS)) && (Logger_FlushReady(now) != 0U))
+		{
+			res = (rotate != 0U) ? Logger_Close() : Logger_Sync();
+			if(res != FR_OK)
+				Logger_Error();
+		}
+		else if(busy == 0U)
+			osDelay(1);
+	}
+}
+
+/**
+  * @brief  Logger_GetStats 读取统计
+  */
+void Logger_GetStats(LOGGER_StatsTypeDef *stats)
+{
+	*stats = Logger_Stats;
+	stats->QueueDepth = Logger_Head - Logger_Tail;
+}
@@ -19,9 +19,11 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
 #include "cmsis_os.h"
+#include "dma.h"
 #include "fatfs.h"
 #include "rtc.h"
 #include "sdmmc.h"
+#include "usart.h"
 #include "usb_device.h"
 #include "gpio.h"
 #include "tim.h"
@@ -96,7 +98,11 @@ int main(void)
   MX_RTC_Init();
   MX_TIM6_Init();
   /* USER CODE BEGIN 2 */
-  
+#if (CDC_BRIDGE_ENABLED == 1U)
+  /* USART2与DMA1只服务于串口桥接，.ioc中设为不生成调用，在此按开关初始化 */
+  MX_DMA_Init();
+  MX_USART2_UART_Init();
+#endif
   /* USER CODE END 2 */
 
   /* Init scheduler */
@@ -0,0 +1,520 @@
+/**
+  ******************************************************************************
+  * @file           : nmea.c
+  * @version        : V1.0
+  * @brief          : 流式NMEA 0183解码器
+  *                   - 逐字节输入，数据可在任意位置分段，不需要先拼出整行
+  *                   - 校验和与字段解析在同一遍扫描中完成
+  *                   - 数值字段直接累计为定点整数，不使用浮点与堆
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                解码流程
+  *          ===================================================================
+  *           '$'开始一条语句，此后每个字节参与异或校验并累计到当前字段；
+  *           遇到','时按语句类型与字段序号把字段写入暂存结构；遇到'*'后
+  *           读取两位十六进制校验，行尾校验一致才调用回调。任何位置收到
+  *           '$'都会丢弃当前语句重新开始，用于从断流中恢复同步。
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "nmea.h"
+#include "string.h"
+
+/* Define --------------------------------------------------------------------*/
+#define NMEA_STATE_IDLE				0U		/**< 等待'$' */
+#define NMEA_STATE_FIELD			1U		/**< 接收字段 */
+#define NMEA_STATE_CHECKSUM_HI		2U		/**< 校验高4位 */
+#define NMEA_STATE_CHECKSUM_LO		3U		/**< 校验低4位 */
+#define NMEA_STATE_END				4U		/**< 等待行尾 */
+
+#define NMEA_FLAG_NEGATIVE			0x01U	/**< 字段带负号 */
+#define NMEA_FLAG_DOT				0x02U	/**< 已收到小数点 */
+#define NMEA_FLAG_INVALID			0x04U	/**< 字段不是合法数字或整数部分溢出 */
+
+/* 再乘10仍不会溢出uint32_t的上限 */
+#define NMEA_VALUE_LIMIT			429496729U
+/* NMEA_Pow10的最大下标，更多的小数位与超过NMEA_VALUE_LIMIT的小数位一样舍去 */
+#define NMEA_FRAC_DIGITS_MAX		9U
+
+/* 语句类型由地址字段后三个字符组成 */
+#define NMEA_ID(a, b, c)			(((uint32_t)(a) << 16) | ((uint32_t)(b) << 8) | (uint32_t)(c))
+
+/* Variables -----------------------------------------------------------------*/
+static const uint32_t NMEA_Pow10[10] =
+{
+	1U, 10U, 100U, 1000U, 10000U, 100000U, 1000000U, 10000000U, 100000000U, 1000000000U
+};
+
+/* ------------------------------------ Field Funtion ------------------------------------ */
+
+/**
+  * @brief  NMEA_IsNumber 当前字段是否为非空的合法数字
+  */
+static uint8_t NMEA_IsNumber(const NMEA_DecoderTypeDef *h)
+{
+	return (uint8_t)((h->FieldLength != 0U) && ((h->Flags & NMEA_FLAG_INVALID) == 0U));
+}
+
+/**
+  * @brief  NMEA_Unsigned 把当前字段换算为指定小数位数的定点数
+  * @param  digits: 结果的小数位数
+  */
+static uint32_t NMEA_Unsigned(const NMEA_DecoderTypeDef *h, uint8_t digits)
+{
+	if(h->FracDigits > digits)
+		return h->Value / NMEA_Pow10[h->FracDigits - digits];
+	return h->Value * NMEA_Pow10[digits - h->FracDigits];
+}
+
+/**
+  * @brief  NMEA_Signed 带符号的定点数
+  * @param  digits: 结果的小数位数
+  */
+static int32_t NMEA_Signed(const NMEA_DecoderTypeDef *h, uint8_t digits)
+{
+	int32_t value = (int32_t)NMEA_Unsigned(h, digits);
+
+	return ((h->Flags & NMEA_FLAG_NEGATIVE) != 0U) ? -value : value;
+}
+
+/**
+  * @brief  NMEA_Coordinate 把(d)ddmm.mmmm格式换算为1e-7度
+  */
+static int32_t NMEA_Coordinate(const NMEA_DecoderTypeDef *h)
+{
+	uint32_t scale = NMEA_Pow10[h->FracDigits];
+	uint32_t whole = h->Value / scale;
+	uint64_t minutes = (uint64_t)(whole % 100U) * scale + (h->Value % scale);
+
+	return (int32_t)((whole / 100U) * 10000000U + (uint32_t)((minutes * 10000000U) / (60U * (uint64_t)scale)));
+}
+
+/**
+  * @brief  NMEA_Time 把hhmmss.sss格式换算为当日毫秒数
+  */
+static uint32_t NMEA_Time(const NMEA_DecoderTypeDef *h)
+{
+	uint32_t scale = NMEA_Pow10[h->FracDigits];
+	uint32_t whole = h->Value / scale;
+	uint32_t ms = h->Value % scale;
+
+	if(h->FracDigits > 3U)
+		ms /= NMEA_Pow10[h->FracDigits - 3U];
+	else
+		ms *= NMEA_Pow10[3U - h->FracDigits];
+
+	return ((whole / 10000U) * 3600U + ((whole / 100U) % 100U) * 60U + (whole % 100U)) * 1000U + ms;
+}
+
+/**
+  * @brief  NMEA_Address 识别地址字段
+  */
+static void NMEA_Address(NMEA_DecoderTypeDef *h)
+{
+	NMEA_SentenceTypeDef *s = &h->Sentence;
+
+	s->Type = NMEA_TYPE_UNKNOWN;
+	if((h->FieldLength != 5U) || (h->Address[0] == 'P'))
+		return;
+
+	s->Talker[0] = h->Address[0];
+	s->Talker[1] = h->Address[1];
+	switch(NMEA_ID(h->Address[2], h->Address[3], h->Address[4]))
+	{
+		case NMEA_ID('G', 'G', 'A'):
+			s->Type = NMEA_TYPE_GGA;
+			break;
+
+		case NMEA_ID('R', 'M', 'C'):
+			s->Type = NMEA_TYPE_RMC;
+			break;
+
+		case NMEA_ID('G', 'S', 'V'):
+			s->Type = NMEA_TYPE_GSV;
+			break;
+
+		case NMEA_ID('V', 'T', 'G'):
+			s->Type = NMEA_TYPE_VTG;
+			break;
+
+		default:
+			break;
+	}
+}
+
+/**
+  * @brief  NMEA_GGAField GGA语句字段
+  */
+static void NMEA_GGAField(NMEA_DecoderTypeDef *h, NMEA_GGATypeDef *gga)
+{
+	switch(h->Field)
+	{
+		case 1U:	gga->Time = NMEA_Time(h);								break;
+		case 2U:	gga->Latitude = NMEA_Coordinate(h);					break;
+		case 3U:	if(h->First == 'S') gga->Latitude = -gga->Latitude;	break;
+		case 4U:	gga->Longitude = NMEA_Coordinate(h);					break;
+		case 5U:	if(h->First == 'W') gga->Longitude = -gga->Longitude;	break;
+		case 6U:	gga->Quality = (uint8_t)h->Value;						break;
+		case 7U:	gga->Satellites = (uint8_t)h->Value;					break;
+		case 8U:	gga->Hdop = (uint16_t)NMEA_Unsigned(h, 2U);				break;
+		case 9U:	gga->Altitude = NMEA_Signed(h, 3U);						break;
+		case 11U:	gga->GeoidSep = NMEA_Signed(h, 3U);						break;
+		default:															break;
+	}
+}
+
+/**
+  * @brief  NMEA_RMCField RMC语句字段
+  */
+static void NMEA_RMCField(NMEA_DecoderTypeDef *h, NMEA_RMCTypeDef *rmc)
+{
+	uint32_t date;
+
+	switch(h->Field)
+	{
+		case 1U:	rmc->Time = NMEA_Time(h);								break;
+		case 2U:	rmc->Valid = (uint8_t)(h->First == 'A');				break;
+		case 3U:	rmc->Latitude = NMEA_Coordinate(h);					break;
+		case 4U:	if(h->First == 'S') rmc->Latitude = -rmc->Latitude;	break;
+		case 5U:	rmc->Longitude = NMEA_Coordinate(h);					break;
+		case 6U:	if(h->First == 'W') rmc->Longitude = -rmc->Longitude;	break;
+		case 7U:	rmc->Speed = NMEA_Unsigned(h, 3U);						break;
+		case 8U:	rmc->Course = NMEA_Unsigned(h, 2U);						break;
+		case 9U:
+			date = NMEA_Unsigned(h, 0U);
+			rmc->Day = (uint8_t)(date / 10000U);
+			rmc->Month = (uint8_t)((date / 100U) % 100U);
+			rmc->Year = (uint8_t)(date % 100U);
+			break;
+		case 12U:	rmc->Mode = h->First;									break;
+		default:															break;
+	}
+}
+
+/**
+  * @brief  NMEA_GSVField GSV语句字段
+  * @note   第4个字段起每4个字段描述一颗卫星；末尾多出的一个字段是信号编号，在语句结束时处理。
+  */
+static void NMEA_GSVField(NMEA_DecoderTypeDef *h, NMEA_GSVTypeDef *gsv)
+{
+	NMEA_SatelliteTypeDef *sat;
+	uint32_t index;
+
+	switch(h->Field)
+	{
+		case 1U:	gsv->Total = (uint8_t)h->Value;							break;
+		case 2U:	gsv->Index = (uint8_t)h->Value;							break;
+		case 3U:	gsv->InView = (uint8_t)h->Value;						break;
+		default:
+			index = h->Field - 4U;
+			if((index >> 2) >= NMEA_GSV_SAT_MAX)
+			{
+				gsv->SignalId = (uint8_t)h->Value;
+				break;
+			}
+			sat = &gsv->Sat[index >> 2];
+			switch(index & 3U)
+			{
+				case 0U:	sat->Prn = (uint8_t)h->Value;					break;
+				case 1U:	sat->Elevation = (int8_t)NMEA_Signed(h, 0U);	break;
+				case 2U:	sat->Azimuth = (uint16_t)h->Value;				break;
+				default:	sat->Snr = (uint8_t)h->Value;					break;
+			}
+			break;
+	}
+}
+
+/**
+  * @brief  NMEA_VTGField VTG语句字段
+  */
+static void NMEA_VTGField(NMEA_DecoderTypeDef *h, NMEA_VTGTypeDef *vtg)
+{
+	switch(h->Field)
+	{
+		case 1U:	vtg->Course = NMEA_Unsigned(h, 2U);						break;
+		case 5U:	vtg->Speed = NMEA_Unsigned(h, 3U);						break;
+		case 7U:	vtg->SpeedKmh = NMEA_Unsigned(h, 3U);					break;
+		case 9U:	vtg->Mode = h->First;									break;
+		default:															break;
+	}
+}
+
+/**
+  * @brief  NMEA_FieldEnd 一个字段接收完毕
+  * @note   空字段保持暂存结构中的0值，由Present区分；数字字段无效时同样跳过。
+  */
+static void NMEA_FieldEnd(NMEA_DecoderTypeDef *h)
+{
+	NMEA_SentenceTypeDef *s = &h->Sentence;
+
+	if(h->Field == 0U)
+	{
+		NMEA_Address(h);
+		return;
+	}
+
+	s->Fields = h->Field;
+	if(h->FieldLength == 0U)
+		return;
+	if(h->Field < 32U)
+		s->Present |= 1UL << h->Field;
+
+	/* 单字符字段不检查数字格式 */
+	if((NMEA_IsNumber(h) == 0U) && (h->FieldLength != 1U))
+		return;
+
+	switch(s->Type)
+	{
+		case NMEA_TYPE_GGA:
+			NMEA_GGAField(h, &s->Gga);
+			break;
+
+		case NMEA_TYPE_RMC:
+			NMEA_RMCField(h, &s->Rmc);
+			break;
+
+		case NMEA_TYPE_GSV:
+			NMEA_GSVField(h, &s->Gsv);
+			break;
+
+		case NMEA_TYPE_VTG:
+			NMEA_VTGField(h, &s->Vtg);
+			break;
+
+		default:
+			break;
+	}
+}
+
+/**
+  * @brief  NMEA_FieldStart 开始一个新字段
+  */
+static void NMEA_FieldStart(NMEA_DecoderTypeDef *h)
+{
+	h->Value = 0U;
+	h->FieldLength = 0U;
+	h->FracDigits = 0U;
+	h->Flags = 0U;
+	h->First = 0U;
+}
+
+/**
+  * @brief  NMEA_Start 收到'$'，开始一条语句
+  */
+static void NMEA_Start(NMEA_DecoderTypeDef *h)
+{
+	(void)memset(&h->Sentence, 0, sizeof(NMEA_SentenceTypeDef));
+	h->State = NMEA_STATE_FIELD;
+	h->Checksum = 0U;
+	h->Length = 1U;
+	h->Field = 0U;
+	NMEA_FieldStart(h);
+}
+
+/**
+  * @brief  NMEA_Finish 语句结束，校验通过后补全并回调
+  * @retval 产生语句返回1
+  */
+static uint32_t NMEA_Finish(NMEA_DecoderTypeDef *h)
+{
+	NMEA_SentenceTypeDef *s = &h->Sentence;
+	uint32_t sats;
+
+	if(h->Checksum != h->Expected)
+	{
+		h->Stats.ChecksumErrors++;
+		return 0U;
+	}
+
+	if(s->Type == NMEA_TYPE_GSV)
+	{
+		/* 字段数为3+4n+1时最后一个字段是信号编号 */
+		sats = (s->Fields > 3U) ? (uint32_t)(s->Fields - 3U) / 4U : 0U;
+		if((sats < NMEA_GSV_SAT_MAX) && (s->Fields > 3U) && (((s->Fields - 3U) & 3U) == 1U))
+		{
+			s->Gsv.SignalId = s->Gsv.Sat[sats].Prn;
+			s->Gsv.Sat[sats].Prn = 0U;
+		}
+		s->Gsv.Count = (uint8_t)((sats < NMEA_GSV_SAT_MAX) ? sats : NMEA_GSV_SAT_MAX);
+	}
+
+	h->Stats.Sentences++;
+	if(s->Type == NMEA_TYPE_UNKNOWN)
+		h->Stats.Unknown++;
+	if(h->Callback != NULL)
+		h->Callback(s);
+
+	return 1U;
+}
+
+/**
+  * @brief  NMEA_Hex 十六进制字符转数值
+  * @retval 非十六进制字符返回0xFF
+  */
+static uint8_t NMEA_Hex(uint8_t c)
+{
+	if((c >= '0') && (c <= '9'))
+		return (uint8_t)(c - '0');
+	if((c >= 'A') && (c <= 'F'))
+		return (uint8_t)(c - 'A' + 10U);
+	if((c >= 'a') && (c <= 'f'))
+		return (uint8_t)(c - 'a' + 10U);
+	return 0xFFU;
+}
+
+/* ------------------------------------ NMEA Funtion ------------------------------------ */
+
+/**
+  * @brief  NMEA_Init 初始化解码器
+  * @param  h: 解码器
+  * @param  callback: 语句回调，可为NULL
+  */
+void NMEA_Init(NMEA_DecoderTypeDef *h, NMEA_CallbackTypeDef callback)
+{
+	(void)memset(h, 0, sizeof(NMEA_DecoderTypeDef));
+	h->Callback = callback;
+	h->State = NMEA_STATE_IDLE;
+}
+
+/**
+  * @brief  NMEA_Input 输入一段数据
+  * @note   数据可以从任意位置截断，下一次调用接着解码；每条校验通过的语句调用一次回调。
+  * @param  h: 解码器
+  * @param  buf: 数据
+  * @param  len: 数据长度
+  * @retval 本次产生的语句数
+  */
+uint32_t NMEA_Input(NMEA_DecoderTypeDef *h, const uint8_t *buf, uint32_t len)
+{
+	uint32_t count = 0U;
+	uint8_t c, hex;
+
+	while(len-- != 0U)
+	{
+		c = *buf++;
+
+		if(c == '$')
+		{
+			if(h->State != NMEA_STATE_IDLE)
+				h->Stats.FormatErrors++;
+			NMEA_Start(h);
+			continue;
+		}
+
+		switch(h->State)
+		{
+			case NMEA_STATE_FIELD:
+				/* 数字是最常见的字符，最先判断 */
+				if((uint8_t)(c - '0') <= 9U)
+				{
+					if((h->Value < NMEA_VALUE_LIMIT) && (h->FracDigits < NMEA_FRAC_DIGITS_MAX))
+					{
+						h->Value = h->Value * 10U + (uint32_t)(c - '0');
+						if((h->Flags & NMEA_FLAG_DOT) != 0U)
+							h->FracDigits++;
+					}
+					else if((h->Flags & NMEA_FLAG_DOT) == 0U)
+						h->Flags |= NMEA_FLAG_INVALID;
+				}
+				else if(c == ',')
+				{
+					h->Checksum ^= c;
+					NMEA_FieldEnd(h);
+					h->Field++;
+					NMEA_FieldStart(h);
+					h->Length++;
+					break;
+				}
+				else if(c == '*')
+				{
+					NMEA_FieldEnd(h);
+					h->State = NMEA_STATE_CHECKSUM_HI;
+					break;
+				}
+				else if((c < 0x20U) || (c > 0x7EU))
+				{
+					h->Stats.FormatErrors++;
+					h->State = NMEA_STATE_IDLE;
+					break;
+				}
+				else if((c == '.') && ((h->Flags & NMEA_FLAG_DOT) == 0U))
+					h->Flags |= NMEA_FLAG_DOT;
+				else if((c == '-') && (h->FieldLength == 0U))
+					h->Flags |= NMEA_FLAG_NEGATIVE;
+				else
+					h->Flags |= NMEA_FLAG_INVALID;
+
+				if(h->FieldLength == 0U)
+					h->First = c;
+				if((h->Field == 0U) && (h->FieldLength < sizeof(h->Address)))
+					h->Address[h->FieldLength] = (char)c;
+				h->FieldLength++;
+				h->Checksum ^= c;
+				if(++h->Length > NMEA_MAX_LENGTH)
+				{
+					h->Stats.FormatErrors++;
+					h->State = NMEA_STATE_IDLE;
+				}
+				break;
+
+			case NMEA_STATE_CHECKSUM_HI:
+			case NMEA_STATE_CHECKSUM_LO:
+				hex = NMEA_Hex(c);
+				if(hex == 0xFFU)
+				{
+					h->Stats.FormatErrors++;
+					h->State = NMEA_STATE_IDLE;
+				}
+				else if(h->State == NMEA_STATE_CHECKSUM_HI)
+				{
+					h->Expected = (uint8_t)(hex << 4);
+					h->State = NMEA_STATE_CHECKSUM_LO;
+				}
+				else
+				{
+					h->Expected |= hex;
+					h->State = NMEA_STATE_END;
+				}
+				break;
+
+			case NMEA_STATE_END:
+				if((c == '\r') || (c == '\n'))
+					count += NMEA_Finish(h);
+				else
+					h->Stats.FormatErrors++;
+				h->State = NMEA_STATE_IDLE;
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	return count;
+}
+
+/**
+  * @brief  NMEA_GetStats 读取解码统计
+  * @param  h: 解码器
+  * @param  stats: 输出的统计数据
+  */
+void NMEA_GetStats(const NMEA_DecoderTypeDef *h, NMEA_StatsTypeDef *stats)
+{
+	*stats = h->Stats;
+}
@@ -0,0 +1,458 @@
+/**
+  ******************************************************************************
+  * @file           : nmea_filter.c
+  * @version        : V1.0
+  * @brief          : NMEA语句过滤与降频
+  *                   - 按发送者与语句类型允许或拒绝
+  *                   - 按类型抽取，每N条转发1条
+  *                   - 可选仅在内容变化时转发
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                规则匹配
+  *          ===================================================================
+  *           规则以(发送者, 类型)为键存放在开放寻址的散列索引中，每条语句
+  *           依次查找(发送者, 类型)、(任意, 类型)、(发送者, 任意)、(任意, 任意)，
+  *           最多4次查找，与规则数量无关。都未命中时执行默认动作。
+  *
+  *           配置命令在USB中断中收到，先放入命令队列，由调用NMEA_Filter_Check
+  *           的任务在处理下一条语句前应用，规则表只在任务上下文中修改。
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "nmea_filter.h"
+#include "string.h"
+
+/* Define --------------------------------------------------------------------*/
+#define NMEA_FILTER_EMPTY			0xFFU		/**< 散列索引空位 */
+#define NMEA_FILTER_CMD_SIZE		10U			/**< 配置命令长度 */
+
+#define NMEA_FILTER_TALKER_ANY		(((uint32_t)NMEA_FILTER_WILDCARD << 8) | NMEA_FILTER_WILDCARD)
+#define NMEA_FILTER_TYPE_ANY		(((uint32_t)NMEA_FILTER_WILDCARD << 16) | ((uint32_t)NMEA_FILTER_WILDCARD << 8) | NMEA_FILTER_WILDCARD)
+
+/* Typedef -------------------------------------------------------------------*/
+typedef struct
+{
+	uint32_t Type;								/**< 3个字符组成的类型键 */
+	uint16_t Talker;							/**< 2个字符组成的发送者键 */
+	uint8_t  Action;
+	uint8_t  Flags;
+	uint16_t Decimate;
+	uint16_t Phase;								/**< 抽取计数 */
+	uint8_t  HasLast;							/**< LastHash有效 */
+	uint32_t LastHash;							/**< 上一条转发语句的内容散列 */
+	NMEA_FilterCountTypeDef Count;
+}NMEA_FilterEntryTypeDef;
+
+typedef struct
+{
+	NMEA_FilterEntryTypeDef Rule[NMEA_FILTER_RULE_MAX];
+	uint8_t  Index[NMEA_FILTER_HASH_SIZE];		/**< 散列索引，存放规则序号 */
+	uint8_t  Rules;								/**< 规则数 */
+	uint8_t  Default;							/**< 无规则匹配时的动作 */
+	NMEA_FilterCountTypeDef Unmatched;			/**< 默认动作的计数 */
+	uint8_t  Cmd[NMEA_FILTER_CMD_QUEUE][NMEA_FILTER_CMD_SIZE];
+	volatile uint32_t CmdHead;				/**< 写位置，仅由USB中断修改 */
+	volatile uint32_t CmdTail;				/**< 读位置，仅由过滤任务修改 */
+	volatile uint8_t Select;				/**< 应答所选规则 */
+}NMEA_FilterTypeDef;
+
+/* Variables -----------------------------------------------------------------*/
+static NMEA_FilterTypeDef NMEA_Filter;
+
+/* ------------------------------------ Rule Funtion ------------------------------------ */
+
+/**
+  * @brief  NMEA_Filter_Hash 计算散列索引位置
+  */
+static uint32_t NMEA_Filter_Hash(uint16_t talker, uint32_t type)
+{
+	return ((type * 0x9E3779B1U) ^ ((uint32_t)talker * 0x85EBCA6BU)) >> (32U - NMEA_FILTER_HASH_BITS);
+}
+
+/**
+  * @brief  NMEA_Filter_Find 查找规则
+  * @retval 规则，未找到返回NULL
+  */
+static NMEA_FilterEntryTypeDef *NMEA_Filter_Find(uint16_t talker, uint32_t type)
+{
+	NMEA_FilterTypeDef *f = &NMEA_Filter;
+	NMEA_FilterEntryTypeDef *rule;
+	uint32_t slot = NMEA_Filter_Hash(talker, type);
+	uint8_t index;
+
+	while((index = f->Index[slot]) != NMEA_FILTER_EMPTY)
+	{
+		rule = &f->Rule[index];
+		if((rule->Type == type) && (rule->Talker == talker))
+			return rule;
+		slot = (slot + 1U) & (NMEA_FILTER_HASH_SIZE - 1U);
+	}
+
+	return NULL;
+}
+
+/**
+  * @brief  NMEA_Filter_Rebuild 规则增删后重建散列索引
+  */
+static void NMEA_Filter_Rebuild(void)
+{
+	NMEA_FilterTypeDef *f = &NMEA_Filter;
+	uint32_t i, slot;
+
+	(void)memset(f->Index, NMEA_FILTER_EMPTY, sizeof(f->Index));
+	for(i = 0U; i < f->Rules; i++)
+	{
+		slot = NMEA_Filter_Hash(f->Rule[i].Talker, f->Rule[i].Type);
+		while(f->Index[slot] != NMEA_FILTER_EMPTY)
+			slot = (slot + 1U) & (NMEA_FILTER_HASH_SIZE - 1U);
+		f->Index[slot] = (uint8_t)i;
+	}
+}
+
+/**
+  * @brief  NMEA_Filter_Key 由字符生成键
+  */
+static uint16_t NMEA_Filter_TalkerKey(const char *talker)
+{
+	return (uint16_t)(((uint16_t)(uint8_t)talker[0] << 8) | (uint8_t)talker[1]);
+}
+
+static uint32_t NMEA_Filter_TypeKey(const char *type)
+{
+	return ((uint32_t)(uint8_t)type[0] << 16) | ((uint32_t)(uint8_t)type[1] << 8) | (uint8_t)type[2];
+}
+
+/**
+  * @brief  NMEA_Filter_Apply 应用一条已排队的配置命令
+  * @param  cmd: 命令，格式见nmea_filter.h
+  */
+static void NMEA_Filter_Apply(const uint8_t *cmd)
+{
+	NMEA_FilterRuleTypeDef rule;
+	uint32_t i;
+
+	switch(cmd[0])
+	{
+		case NMEA_FILTER_OP_SET:
+			memcpy(rule.Talker, &cmd[1], sizeof(rule.Talker));
+			memcpy(rule.Type, &cmd[3], sizeof(rule.Type));
+			rule.Action = cmd[6];
+			rule.Flags = cmd[7];
+			rule.Decimate = (uint16_t)(cmd[8] | ((uint16_t)cmd[9] << 8));
+			(void)NMEA_Filter_SetRule(&rule);
+			break;
+
+		case NMEA_FILTER_OP_DELETE:
+			(void)NMEA_Filter_DeleteRule((const char *)&cmd[1], (const char *)&cmd[3]);
+			break;
+
+		case NMEA_FILTER_OP_CLEAR:
+			NMEA_Filter_Clear();
+			break;
+
+		case NMEA_FILTER_OP_DEFAULT:
+			NMEA_Filter_SetDefault(cmd[6]);
+			break;
+
+		case NMEA_FILTER_OP_RESET:
+			for(i = 0U; i < NMEA_Filter.Rules; i++)
+				(void)memset(&NMEA_Filter.Rule[i].Count, 0, sizeof(NMEA_FilterCountTypeDef));
+			(void)memset(&NMEA_Filter.Unmatched, 0, sizeof(NMEA_FilterCountTypeDef));
+			break;
+
+		default:
+			break;
+	}
+}
+
+/* ------------------------------------ Filter Funtion ------------------------------------ */
+
+/**
+  * @brief  NMEA_Filter_Init 初始化过滤器，无规则，默认全部转发
+  */
+void NMEA_Filter_Init(void)
+{
+	(void)memset(&NMEA_Filter, 0, sizeof(NMEA_FilterTypeDef));
+	NMEA_Filter.Default = NMEA_FILTER_ALLOW;
+	NMEA_Filter.Select = NMEA_FILTER_SELECT_TOTAL;
+	NMEA_Filter_Rebuild();
+}
+
+/**
+  * @brief  NMEA_Filter_Check 判断一条语句是否转发
+  * @note   在过滤任务中调用；内容比较只对设置了NMEA_FILTER_FLAG_ON_CHANGE的规则计算。
+  * @param  frame: 完整语句，以'$'开始
+  * @param  len: 语句长度
+  * @retval 1为转发，0为丢弃
+  */
+uint8_t NMEA_Filter_Check(const uint8_t *frame, uint32_t len)
+{
+	NMEA_FilterTypeDef *f = &NMEA_Filter;
+	NMEA_FilterEntryTypeDef *rule;
+	NMEA_FilterCountTypeDef *count;
+	uint16_t talker;
+	uint32_t type, hash, i;
+
+	while(f->CmdTail != f->CmdHead)
+	{
+		NMEA_Filter_Apply(f->Cmd[f->CmdTail % NMEA_FILTER_CMD_QUEUE]);
+		f->CmdTail++;
+	}
+
+	if(len < 6U)
+		return 0U;
+
+	talker = NMEA_Filter_TalkerKey((const char *)&frame[1]);
+	type = NMEA_Filter_TypeKey((const char *)&frame[3]);
+	rule = NMEA_Filter_Find(talker, type);
+	if(rule == NULL)
+		rule = NMEA_Filter_Find(NMEA_FILTER_TALKER_ANY, type);
+	if(rule == NULL)
+		rule = NMEA_Filter_Find(talker, NMEA_FILTER_TYPE_ANY);
+	if(rule == NULL)
+		rule = NMEA_Filter_Find(NMEA_FILTER_TALKER_ANY, NMEA_FILTER_TYPE_ANY);
+
+	if(rule == NULL)
+	{
+		if(f->Default == NMEA_FILTER_DENY)
+		{
+			f->Unmatched.Denied++;
+			return 0U;
+		}
+		f->Unmatched.Passed++;
+		return 1U;
+	}
+
+	count = &rule->Count;
+	if(rule->Action == NMEA_FILTER_DENY)
+	{
+		count->Denied++;
+		return 0U;
+	}
+
+	if(rule->Decimate > 1U)
+	{
+		i = rule->Phase;
+		rule->Phase = (uint16_t)((i + 1U >= rule->Decimate) ? 0U : i + 1U);
+		if(i != 0U)
+		{
+			count->Decimated++;
+			return 0U;
+		}
+	}
+
+	if((rule->Flags & NMEA_FILTER_FLAG_ON_CHANGE) != 0U)
+	{
+		/* 地址之后的全部内容参与FNV-1a散列，校验和随内容变化，一并计入 */
+		hash = 2166136261U;
+		for(i = 6U; i < len; i++)
+			hash = (hash ^ frame[i]) * 16777619U;
+		if((rule->HasLast != 0U) && (rule->LastHash == hash))
+		{
+			count->Unchanged++;
+			return 0U;
+		}
+		rule->LastHash = hash;
+		rule->HasLast = 1U;
+	}
+
+	count->Passed++;
+	return 1U;
+}
+
+/**
+  * @brief  NMEA_Filter_SetRule 新增或修改规则
+  * @note   修改已有规则时保留其计数。
+  * @param  rule: 规则
+  * @retval 0成功，规则表已满返回1
+  */
+uint8_t NMEA_Filter_SetRule(const NMEA_FilterRuleTypeDef *rule)
+{
+	NMEA_FilterTypeDef *f = &NMEA_Filter;
+	NMEA_FilterEntryTypeDef *entry;
+	uint16_t talker = NMEA_Filter_TalkerKey(rule->Talker);
+	uint32_t type = NMEA_Filter_TypeKey(rule->Type);
+
+	entry = NMEA_Filter_Find(talker, type);
+	if(entry == NULL)
+	{
+		if(f->Rules >= NMEA_FILTER_RULE_MAX)
+			return 1U;
+		entry = &f->Rule[f->Rules++];
+		(void)memset(entry, 0, sizeof(NMEA_FilterEntryTypeDef));
+		entry->Talker = talker;
+		entry->Type = type;
+		NMEA_Filter_Rebuild();
+	}
+
+	entry->Action = rule->Action;
+	entry->Flags = rule->Flags;
+	entry->Decimate = rule->Decimate;
+	entry->Phase = 0U;
+	entry->HasLast = 0U;
+
+	return 0U;
+}
+
+/**
+  * @brief  NMEA_Filter_DeleteRule 删除规则
+  * @param  talker: 2个字符的发送者
+  * @param  type: 3个字符的类型
+  * @retval 0成功，规则不存在返回1
+  */
+uint8_t NMEA_Filter_DeleteRule(const char *talker, const char *type)
+{
+	NMEA_FilterTypeDef *f = &NMEA_Filter;
+	NMEA_FilterEntryTypeDef *entry;
+
+	entry = NMEA_Filter_Find(NMEA_Filter_TalkerKey(talker), NMEA_Filter_TypeKey(type));
+	if(entry == NULL)
+		return 1U;
+
+	/* 用最后一条规则填补空位 */
+	*entry = f->Rule[--f->Rules];
+	NMEA_Filter_Rebuild();
+
+	return 0U;
+}
+
+/**
+  * @brief  NMEA_Filter_Clear 删除全部规则
+  */
+void NMEA_Filter_Clear(void)
+{
+	NMEA_Filter.Rules = 0U;
+	NMEA_Filter_Rebuild();
+}
+
+/**
+  * @brief  NMEA_Filter_SetDefault 设置无规则匹配时的动作
+  * @param  action: NMEA_FILTER_ALLOW或NMEA_FILTER_DENY
+  */
+void NMEA_Filter_SetDefault(uint8_t action)
+{
+	NMEA_Filter.Default = (action == NMEA_FILTER_DENY) ? NMEA_FILTER_DENY : NMEA_FILTER_ALLOW;
+}
+
+/**
+  * @brief  NMEA_Filter_GetCount 读取全部规则与默认动作的计数之和
+  * @param  count: 输出的计数
+  */
+void NMEA_Filter_GetCount(NMEA_FilterCountTypeDef *count)
+{
+	NMEA_FilterTypeDef *f = &NMEA_Filter;
+	uint32_t i;
+
+	*count = f->Unmatched;
+	for(i = 0U; i < f->Rules; i++)
+	{
+		count->Passed += f->Rule[i].Count.Passed;
+		count->Denied += f->Rule[i].Count.Denied;
+		count->Decimated += f->Rule[i].Count.Decimated;
+		count->Unchanged += f->Rule[i].Count.Unchanged;
+	}
+}
+
+/**
+  * @brief  NMEA_Filter_Command 收到配置命令，在USB中断中调用
+  * @note   SELECT立即生效，其余命令排队等待过滤任务应用。
+  * @param  buf: 命令数据
+  * @param  len: 命令长度
+  * @retval 0成功，格式错误或队列满返回1
+  */
+uint8_t NMEA_Filter_Command(const uint8_t *buf, uint16_t len)
+{
+	NMEA_FilterTypeDef *f = &NMEA_Filter;
+	uint8_t *cmd;
+
+	if((len == 0U) || (buf[0] < NMEA_FILTER_OP_SET) || (buf[0] > NMEA_FILTER_OP_SELECT))
+		return 1U;
+
+	if(buf[0] == NMEA_FILTER_OP_SELECT)
+	{
+		if(len < 2U)
+			return 1U;
+		f->Select = buf[1];
+		return 0U;
+	}
+
+	if(f->CmdHead - f->CmdTail >= NMEA_FILTER_CMD_QUEUE)
+		return 1U;
+
+	cmd = f->Cmd[f->CmdHead % NMEA_FILTER_CMD_QUEUE];
+	(void)memset(cmd, 0, NMEA_FILTER_CMD_SIZE);
+	memcpy(cmd, buf, (len < NMEA_FILTER_CMD_SIZE) ? len : NMEA_FILTER_CMD_SIZE);
+	f->CmdHead++;
+
+	return 0U;
+}
+
+/**
+  * @brief  NMEA_Filter_Response 填写GET_ENCAPSULATED_RESPONSE应答，在USB中断中调用
+  * @note   整个len字节都会发给主机，超出应答长度的部分填0。
+  * @param  buf: 应答缓冲
+  * @param  len: 数据阶段的长度
+  */
+void NMEA_Filter_Response(uint8_t *buf, uint16_t len)
+{
+	NMEA_FilterTypeDef *f = &NMEA_Filter;
+	uint8_t out[NMEA_FILTER_RESPONSE_SIZE] = {0};
+	NMEA_FilterCountTypeDef count;
+	const NMEA_FilterEntryTypeDef *rule = NULL;
+	uint8_t select = f->Select;
+
+	if(select < f->Rules)
+	{
+		rule = &f->Rule[select];
+		count = rule->Count;
+	}
+	else
+	{
+		select = NMEA_FILTER_SELECT_TOTAL;
+		NMEA_Filter_GetCount(&count);
+	}
+
+	out[0] = f->Rules;
+	out[1] = select;
+	out[2] = f->Default;
+	memcpy(&out[4], &count.Passed, 4U);
+	memcpy(&out[8], &count.Denied, 4U);
+	memcpy(&out[12], &count.Decimated, 4U);
+	memcpy(&out[16], &count.Unchanged, 4U);
+	if(rule != NULL)
+	{
+		out[20] = (uint8_t)(rule->Talker >> 8);
+		out[21] = (uint8_t)rule->Talker;
+		out[22] = (uint8_t)(rule->Type >> 16);
+		out[23] = (uint8_t)(rule->Type >> 8);
+		out[24] = (uint8_t)rule->Type;
+		out[25] = rule->Action;
+		out[26] = rule->Flags;
+		out[27] = (uint8_t)rule->Decimate;
+		out[28] = (uint8_t)(rule->Decimate >> 8);
+	}
+
+	if(len > NMEA_FILTER_RESPONSE_SIZE)
+	{
+		memcpy(buf, out, NMEA_FILTER_RESPONSE_SIZE);
+		(void)memset(&buf[NMEA_FILTER_RESPONSE_SIZE], 0, len - NMEA_FILTER_RESPONSE_SIZE);
+	}
+	else
+		memcpy(buf, out, len);
+}
@@ -0,0 +1,296 @@
+/**
+  ******************************************************************************
+  * @file           : scan.c
+  * @version        : V1.0
+  * @brief          : 字节流扫描
+  *                   - 查找分隔符或同步字节、检查可打印文本
+  *                   - 计算NMEA异或校验与UBX Fletcher校验
+  *                   - 每步处理4或8字节，Cortex-M7上使用DSP的SIMD指令
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                实现说明
+  *          ===================================================================
+  *           每次读取一个32位字，同时比较其中4个字节，得到逐字节的匹配掩码，
+  *           掩码非0时再定位第一个匹配的字节；循环体一次处理两个字。
+  *
+  *           有DSP扩展时用__UADD8/__USUB8按字节比较并设置GE标志，再用__SEL
+  *           得到每字节0x00或0xFF的掩码，__CLZ(__RBIT())给出第一个匹配的位置；
+  *           其余内核用SWAR位运算得到每字节最高位的掩码，结果与逐字节实现
+  *           完全一致，没有跨字节进位造成的误报。
+  *
+  *           读取经memcpy完成，缓冲不要求字对齐，Cortex-M7上编译为LDR。
+  *           不足一个字的尾部逐字节处理，不会读取len之外的内存。
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "scan.h"
+#include "stm32h7xx.h"
+#include "string.h"
+
+/* Define --------------------------------------------------------------------*/
+#if (defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)) || (defined(__ARM_ARCH_7EM__) && (__ARM_ARCH_7EM__ == 1))
+#define SCAN_DSP					1U
+#else
+#define SCAN_DSP					0U
+#endif
+
+#define SCAN_ONES					0x01010101UL
+#define SCAN_LOWS					0x7F7F7F7FUL
+#define SCAN_HIGHS					0x80808080UL
+
+/* ---------------------------------------- Word Funtion ---------------------------------------- */
+
+static inline uint32_t SCAN_Load(const uint8_t *p)
+{
+	uint32_t w;
+
+	memcpy(&w, p, 4U);
+	return w;
+}
+
+#if (SCAN_DSP == 1U)
+
+/**
+  * @brief  SCAN_Zero 为0的字节对应0xFF，其余为0x00
+  */
+static inline uint32_t SCAN_Zero(uint32_t w)
+{
+	/* 非0字节加0xFF产生进位，置位对应的GE */
+	(void)__UADD8(w, 0xFFFFFFFFUL);
+	return __SEL(0U, 0xFFFFFFFFUL);
+}
+
+/**
+  * @brief  SCAN_Outside 不在[lo, hi]范围内或等于stop的字节对应0xFF
+  * @param  lo: 下限重复4次
+  * @param  hi: 上限重复4次
+  * @param  stop: 停止字节重复4次
+  */
+static inline uint32_t SCAN_Outside(uint32_t w, uint32_t lo, uint32_t hi, uint32_t stop)
+{
+	uint32_t inside;
+
+	(void)__USUB8(w, lo);
+	inside = __SEL(0xFFFFFFFFUL, 0U);
+	(void)__USUB8(hi, w);
+	inside = __SEL(inside, 0U);
+	(void)__UADD8(w ^ stop, 0xFFFFFFFFUL);
+	inside = __SEL(inside, 0U);
+
+	return ~inside;
+}
+
+/**
+  * @brief  SCAN_First 掩码中第一个非0字节的序号
+  */
+static inline uint32_t SCAN_First(uint32_t mask)
+{
+	return __CLZ(__RBIT(mask)) >> 3;
+}
+
+#else
+
+/**
+  * @brief  SCAN_Zero 为0的字节对应0x80，其余为0x00
+  * @note   低7位先加0x7F，不会向相邻字节进位，结果是精确的。
+  */
+static inline uint32_t SCAN_Zero(uint32_t w)
+{
+	return ~(((w & SCAN_LOWS) + SCAN_LOWS) | w | SCAN_LOWS);
+}
+
+/**
+  * @brief  SCAN_Outside 不在[lo, hi]范围内或等于stop的字节对应0x80
+  * @note   只用于lo与hi都小于0x80的情况，最高位为1的字节总在范围之外。
+  */
+static inline uint32_t SCAN_Outside(uint32_t w, uint32_t lo, uint32_t hi, uint32_t stop)
+{
+	uint32_t low = w & SCAN_LOWS;
+	/* 低7位加(0x80 - lo)不产生最高位，说明小于lo */
+	uint32_t below = ~(low + (SCAN_HIGHS - lo)) & SCAN_HIGHS;
+	/* 低7位加(0x7F - hi)产生最高位，说明大于hi */
+	uint32_t above = (low + (SCAN_LOWS - hi)) & SCAN_HIGHS;
+
+	return (w & SCAN_HIGHS) | below | above | SCAN_Zero(w ^ stop);
+}
+
+/**
+  * @brief  SCAN_First 掩码中第一个非0字节的序号，小端
+  */
+static inline uint32_t SCAN_First(uint32_t mask)
+{
+	mask &= 0U - mask;
+	if(mask <= 0x80UL)
+		return 0U;
+	if(mask <= 0x8000UL)
+		return 1U;
+	return (mask <= 0x800000UL) ? 2U : 3U;
+}
+
+#endif /* SCAN_DSP */
+
+/* ---------------------------------------- Scan Funtion ---------------------------------------- */
+
+/**
+  * @brief  SCAN_Byte 查找第一个等于c的字节
+  * @param  buf: 数据
+  * @param  len: 数据长度
+  * @param  c: 要查找的字节
+  * @retval 字节的位置，没有找到返回len
+  */
+uint32_t SCAN_Byte(const uint8_t *buf, uint32_t len, uint8_t c)
+{
+	uint32_t pattern = SCAN_ONES * c;
+	uint32_t i = 0U;
+	uint32_t m0, m1;
+
+	for(; i + 8U <= len; i += 8U)
+	{
+		m0 = SCAN_Zero(SCAN_Load(&buf[i]) ^ pattern);
+		m1 = SCAN_Zero(SCAN_Load(&buf[i + 4U]) ^ pattern);
+		if((m0 | m1) != 0U)
+			return (m0 != 0U) ? i + SCAN_First(m0) : i + 4U + SCAN_First(m1);
+	}
+	for(; i < len; i++)
+	{
+		if(buf[i] == c)
+			break;
+	}
+
+	return i;
+}
+
+/**
+  * @brief  SCAN_Byte3 查找第一个等于a、b或c的字节，用于寻找多种帧的同步字节
+  * @retval 字节的位置，没有找到返回len
+  */
+uint32_t SCAN_Byte3(const uint8_t *buf, uint32_t len, uint8_t a, uint8_t b, uint8_t c)
+{
+	uint32_t pa = SCAN_ONES * a, pb = SCAN_ONES * b, pc = SCAN_ONES * c;
+	uint32_t i = 0U;
+	uint32_t w, mask;
+
+	for(; i + 4U <= len; i += 4U)
+	{
+		w = SCAN_Load(&buf[i]);
+		mask = SCAN_Zero(w ^ pa) | SCAN_Zero(w ^ pb) | SCAN_Zero(w ^ pc);
+		if(mask != 0U)
+			return i + SCAN_First(mask);
+	}
+	for(; i < len; i++)
+	{
+		if((buf[i] == a) || (buf[i] == b) || (buf[i] == c))
+			break;
+	}
+
+	return i;
+}
+
+/**
+  * @brief  SCAN_Text 可打印ASCII的长度，遇到控制字符、非ASCII字节或stop停止
+  * @param  buf: 数据
+  * @param  len: 数据长度
+  * @param  stop: 同样视为停止的可打印字符，如NMEA的'$'
+  * @retval 第一个停止字节的位置，全部可打印返回len
+  */
+uint32_t SCAN_Text(const uint8_t *buf, uint32_t len, uint8_t stop)
+{
+	const uint32_t lo = SCAN_ONES * SCAN_TEXT_MIN;
+	const uint32_t hi = SCAN_ONES * SCAN_TEXT_MAX;
+	uint32_t pattern = SCAN_ONES * stop;
+	uint32_t i = 0U;
+	uint32_t m0, m1;
+	uint8_t c;
+
+	for(; i + 8U <= len; i += 8U)
+	{
+		m0 = SCAN_Outside(SCAN_Load(&buf[i]), lo, hi, pattern);
+		m1 = SCAN_Outside(SCAN_Load(&buf[i + 4U]), lo, hi, pattern);
+		if((m0 | m1) != 0U)
+			return (m0 != 0U) ? i + SCAN_First(m0) : i + 4U + SCAN_First(m1);
+	}
+	for(; i < len; i++)
+	{
+		c = buf[i];
+		if((c < SCAN_TEXT_MIN) || (c > SCAN_TEXT_MAX) || (c == stop))
+			break;
+	}
+
+	return i;
+}
+
+/**
+  * @brief  SCAN_Xor 全部字节的异或，NMEA语句的校验
+  */
+uint8_t SCAN_Xor(const uint8_t *buf, uint32_t len)
+{
+	uint32_t x0 = 0U, x1 = 0U;
+	uint32_t i = 0U;
+	uint8_t sum;
+
+	for(; i + 8U <= len; i += 8U)
+	{
+		x0 ^= SCAN_Load(&buf[i]);
+		x1 ^= SCAN_Load(&buf[i + 4U]);
+	}
+	x0 ^= x1;
+	x0 ^= x0 >> 16;
+	sum = (uint8_t)(x0 ^ (x0 >> 8));
+	for(; i < len; i++)
+		sum ^= buf[i];
+
+	return sum;
+}
+
+/**
+  * @brief  SCAN_Fletcher 8位Fletcher校验，UBX帧的CK_A与CK_B
+  * @note   按4字节展开：CK_B += 4*CK_A + 4*b0 + 3*b1 + 2*b2 + b3，CK_A += b0 + b1 + b2 + b3；
+  *         累加在32位中进行，最后取低8位，与逐字节取模的结果相同。
+  * @retval CK_A在低8位，CK_B在高8位
+  */
+uint16_t SCAN_Fletcher(const uint8_t *buf, uint32_t len)
+{
+	uint32_t ck_a = 0U, ck_b = 0U;
+	uint32_t i = 0U;
+	uint32_t w, sum, weighted;
+
+	for(; i + 4U <= len; i += 4U)
+	{
+		w = SCAN_Load(&buf[i]);
+#if (SCAN_DSP == 1U)
+		sum = __USAD8(w, 0U);
+		weighted = __SMUAD(__UXTB16(w), 0x00020004UL);
+		weighted = __SMLAD(__UXTB16(__ROR(w, 8U)), 0x00010003UL, weighted);
+#else
+		/* 偶数字节(b0, b2)与奇数字节(b1, b3)分别放在两个半字中，乘法的高半字即加权和 */
+		sum = (w & 0x00FF00FFUL) + ((w >> 8) & 0x00FF00FFUL);
+		sum = (sum + (sum >> 16)) & 0xFFFFU;
+		weighted = (((w & 0x00FF00FFUL) * 0x00040002UL) >> 16) + ((((w >> 8) & 0x00FF00FFUL) * 0x00030001UL) >> 16);
+#endif
+		ck_b += 4U * ck_a + weighted;
+		ck_a += sum;
+	}
+	for(; i < len; i++)
+	{
+		ck_a += buf[i];
+		ck_b += ck_a;
+	}
+
+	return (uint16_t)((ck_a & 0xFFU) | ((ck_b & 0xFFU) << 8));
+}
@@ -0,0 +1,23 @@
+/**
+  ******************************************************************************
+  * @file    cmsis_os.h
+  * @brief   主机测试用的CMSIS-RTOS2替身，只提供被测代码用到的定义
+  ******************************************************************************
+  */
+
+#ifndef __CMSIS_OS_H
+#define __CMSIS_OS_H
+
+#include <stdint.h>
+
+typedef enum
+{
+	osOK = 0,
+	osError = -1
+}osStatus_t;
+
+/* 由测试程序实现，测试以osDelay推进时间并驱动其他任务 */
+uint32_t osKernelGetTickCount(void);
+osStatus_t osDelay(uint32_t ticks);
+
+#endif /* __CMSIS_OS_H */
@@ -0,0 +1,133 @@
+/**
+  ******************************************************************************
+  * @file    fatfs.h
+  * @brief   主机测试用的FatFs替身，由fatfs_ram.c在内存中实现
+  *           - 类型与接口同ff.h(R0.12c，_FS_EXFAT=0，_USE_LFN=0)
+  *           - 只实现被测代码用到的函数，另外提供检查与注入错误的接口
+  ******************************************************************************
+  */
+
+#ifndef __FATFS_H
+#define __FATFS_H
+
+#include <stdint.h>
+
+typedef unsigned int	UINT;
+typedef uint8_t			BYTE;
+typedef uint16_t		WORD;
+typedef uint32_t		DWORD;
+typedef DWORD			FSIZE_t;
+
+typedef enum
+{
+	FR_OK = 0,
+	FR_DISK_ERR,
+	FR_INT_ERR,
+	FR_NOT_READY,
+	FR_NO_FILE,
+	FR_NO_PATH,
+	FR_INVALID_NAME,
+	FR_DENIED,
+	FR_EXIST,
+	FR_INVALID_OBJECT,
+	FR_WRITE_PROTECTED,
+	FR_INVALID_DRIVE,
+	FR_NOT_ENABLED,
+	FR_NO_FILESYSTEM,
+	FR_MKFS_ABORTED,
+	FR_TIMEOUT,
+	FR_LOCKED,
+	FR_NOT_ENOUGH_CORE,
+	FR_TOO_MANY_OPEN_FILES,
+	FR_INVALID_PARAMETER
+}FRESULT;
+
+typedef struct
+{
+	BYTE fs_type;					/**< 0表示未挂载 */
+}FATFS;
+
+typedef struct
+{
+	FATFS *fs;
+	FSIZE_t objsize;
+}FFOBJID;
+
+typedef struct
+{
+	FFOBJID obj;
+	BYTE flag;
+	FSIZE_t fptr;
+	DWORD *cltbl;					/**< 快速定位的簇链映射表 */
+	int id;							/**< 内存文件序号 */
+}FIL;
+
+typedef struct
+{
+	FFOBJID obj;
+	UINT index;
+}DIR;
+
+typedef struct
+{
+	FSIZE_t fsize;
+	WORD fdate;
+	WORD ftime;
+	BYTE fattrib;
+	char fname[13];
+}FILINFO;
+
+#define FA_READ				0x01U
+#define FA_WRITE			0x02U
+#define FA_OPEN_EXISTING	0x00U
+#define FA_CREATE_NEW		0x04U
+#define FA_CREATE_ALWAYS	0x08U
+#define FA_OPEN_ALWAYS		0x10U
+
+#define CREATE_LINKMAP		((FSIZE_t)0 - 1)
+
+#define f_tell(fp)			((fp)->fptr)
+#define f_size(fp)			((fp)->obj.objsize)
+
+FRESULT f_mount(FATFS *fs, const char *path, BYTE opt);
+FRESULT f_open(FIL *fp, const char *path, BYTE mode);
+FRESULT f_close(FIL *fp);
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br);
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw);
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs);
+FRESULT f_expand(FIL *fp, FSIZE_t fsz, BYTE opt);
+FRESULT f_sync(FIL *fp);
+FRESULT f_truncate(FIL *fp);
+FRESULT f_opendir(DIR *dp, const char *path);
+FRESULT f_readdir(DIR *dp, FILINFO *fno);
+FRESULT f_closedir(DIR *dp);
+
+extern FATFS SDFatFS;
+extern char SDPath[4];
+
+/* ------------------------------ 测试接口 ------------------------------ */
+
+typedef struct
+{
+	uint32_t Mounts;				/**< 成功挂载的次数 */
+	uint32_t Unmounts;
+	uint32_t Opens;
+	uint32_t Closes;
+	uint32_t Syncs;
+	uint32_t Truncates;
+	uint32_t Writes;
+	uint32_t Unaligned;				/**< 位置或长度不是扇区整数倍的写入 */
+	uint32_t Overruns;				/**< 快速定位模式下写到文件结尾之外 */
+	uint32_t ReadBytes;
+	uint32_t FastSeeks;				/**< 建立簇链映射表的次数 */
+	uint32_t Expands;				/**< f_expand调用次数 */
+	FSIZE_t ExpandSize[8];			/**< 前8次f_expand请求的大小 */
+}RAM_StatsTypeDef;
+
+extern RAM_StatsTypeDef RAM_Stats;
+
+void RAM_Reset(uint32_t contiguous);
+const uint8_t *RAM_File(const char *name, uint32_t *size);
+void RAM_FailReads(uint8_t fail);
+
+#endif /* __FATFS_H */
@@ -0,0 +1,164 @@
+/**
+  ******************************************************************************
+  * @file    bench_fix_codec.c
+  * @brief   fix_codec.c在模拟行驶数据上的压缩率与编解码耗时
+  *           - 按GNSS_FixPush的方式分块编码，每块从关键帧开始
+  *           - 对照同一历元的GGA与RMC语句原文(u-blox默认精度)的长度
+  * @note    目标板上的耗时需用DWT->CYCCNT另行测量，这里只用于比较改动前后的差异。
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "fix_codec.h"
+#include "fix_sim.h"
+
+#define BENCH_FIXES			200000U
+#define BENCH_ROUNDS		20U
+
+static FIX_RecordTypeDef Fixes[BENCH_FIXES];
+static FIX_RecordTypeDef Decoded[BENCH_FIXES];
+static uint8_t Stream[BENCH_FIXES * FIX_ENCODED_MAX];
+static volatile uint32_t Sink;
+
+#define BENCH_BARRIER()		__asm__ volatile("" : : "r"(Stream), "r"(Fixes) : "memory")
+
+static double Now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+}
+
+/**
+  * @brief  Sentence 补上校验和与换行，返回语句长度
+  */
+static uint32_t Sentence(char *buf, int len)
+{
+	uint8_t sum = 0U;
+	int i;
+
+	for(i = 1; i < len; i++)
+		sum ^= (uint8_t)buf[i];
+	return (uint32_t)(len + snprintf(&buf[len], 8, "*%02X\r\n", sum));
+}
+
+/**
+  * @brief  Degrees 1e-7度转为NMEA的度分格式，分保留5位小数
+  */
+static void Degrees(int32_t value, uint32_t width, char *buf, size_t size)
+{
+	double deg = fabs((double)value / 1e7);
+	uint32_t d = (uint32_t)deg;
+
+	snprintf(buf, size, "%0*u%08.5f", (int)width, d, (deg - d) * 60.0);
+}
+
+/**
+  * @brief  TextLength 同一历元GGA与RMC语句原文的长度
+  */
+static uint32_t TextLength(const FIX_RecordTypeDef *fix)
+{
+	char buf[160], lat[24], lon[24], speed[16], course[16];
+	uint32_t h = fix->Time / 3600000U, m = fix->Time / 60000U % 60U, s = fix->Time / 1000U % 60U;
+	uint32_t cs = fix->Time / 10U % 100U, n;
+	int len;
+
+	Degrees(fix->Latitude, 2U, lat, sizeof(lat));
+	Degrees(fix->Longitude, 3U, lon, sizeof(lon));
+	len = snprintf(buf, sizeof(buf), "$GNGGA,%02u%02u%02u.%02u,%s,%c,%s,%c,%u,%02u,%u.%02u,%.1f,M,8.2,M,1.0,0000",
+			h, m, s, cs, lat, (fix->Latitude < 0) ? 'S' : 'N', lon, (fix->Longitude < 0) ? 'W' : 'E',
+			fix->Quality, fix->Satellites, fix->Hdop / 100U, fix->Hdop % 100U, fix->Altitude / 1000.0);
+	n = Sentence(buf, len);
+
+	speed[0] = '\0';
+	course[0] = '\0';
+	if(fix->Speed != FIX_INVALID)
+	{
+		snprintf(speed, sizeof(speed), "%.3f", fix->Speed / 1000.0);
+		snprintf(course, sizeof(course), "%.2f", fix->Course / 100.0);
+	}
+	len = snprintf(buf, sizeof(buf), "$GNRMC,%02u%02u%02u.%02u,A,%s,%c,%s,%c,%s,%s,191026,,,R,V",
+			h, m, s, cs, lat, (fix->Latitude < 0) ? 'S' : 'N', lon, (fix->Longitude < 0) ? 'W' : 'E', speed, course);
+	return n + Sentence(buf, len);
+}
+
+/**
+  * @brief  Encode 编码全部定位结果，返回编码总长
+  */
+static uint32_t Encode(void)
+{
+	FIX_CodecTypeDef codec;
+	uint32_t i, n = 0U;
+
+	FIX_Reset(&codec);
+	for(i = 0U; i < BENCH_FIXES; i++)
+		n += FIX_Encode(&codec, &Fixes[i], &Stream[n]);
+	return n;
+}
+
+/**
+  * @brief  Decode 按块解码，每块用新的解码状态，返回解码的定位结果数
+  */
+static uint32_t Decode(uint32_t size)
+{
+	FIX_CodecTypeDef codec;
+	uint32_t i, pos = 0U, n;
+
+	for(i = 0U; i < BENCH_FIXES; i++)
+	{
+		if((i % FIX_KEY_INTERVAL) == 0U)
+			FIX_Reset(&codec);
+		n = FIX_Decode(&codec, &Stream[pos], size - pos, &Decoded[i]);
+		if(n == 0U)
+			break;
+		pos += n;
+	}
+	return i;
+}
+
+int main(void)
+{
+	SIM_DriveTypeDef sim;
+	uint64_t text = 0U;
+	uint32_t i, size = 0U, count = 0U;
+	double t0, t1, t2;
+
+	SIM_Init(&sim, 1U);
+	for(i = 0U; i < BENCH_FIXES; i++)
+	{
+		(void)SIM_Next(&sim, &Fixes[i]);
+		text += TextLength(&Fixes[i]);
+	}
+
+	t0 = Now();
+	for(i = 0U; i < BENCH_ROUNDS; i++)
+	{
+		size = Encode();
+		BENCH_BARRIER();
+	}
+	t1 = Now();
+	for(i = 0U; i < BENCH_ROUNDS; i++)
+	{
+		count = Decode(size);
+		BENCH_BARRIER();
+	}
+	t2 = Now();
+	Sink = count;
+
+	if((count != BENCH_FIXES) || (memcmp(Fixes, Decoded, sizeof(Fixes)) != 0))
+	{
+		printf("bench_fix_codec: round trip mismatch after %u fixes\n", count);
+		return 1;
+	}
+
+	printf("%u fixes, %.2f bytes/fix encoded, %.1f bytes/fix GGA+RMC text, ratio %.1fx\n",
+			BENCH_FIXES, (double)size / BENCH_FIXES, (double)text / BENCH_FIXES, (double)text / size);
+	printf("encode %6.1f ns/fix\n", (t1 - t0) / ((double)BENCH_ROUNDS * BENCH_FIXES));
+	printf("decode %6.1f ns/fix\n", (t2 - t1) / ((double)BENCH_ROUNDS * BENCH_FIXES));
+
+	return 0;
+}
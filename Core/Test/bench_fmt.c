@@ -0,0 +1,99 @@
+/**
+  ******************************************************************************
+  * @file    bench_fmt.c
+  * @brief   fmt.c与C库vsnprintf的主机端对比基准，输出每次调用的耗时
+  * @note    主机上对比的是glibc，目标板上的newlib更慢，这里只用于比较改动前后的差异。
+  ******************************************************************************
+  */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+#include "fmt.h"
+
+#define BENCH_ROUNDS		2000000U
+#define TEXT_SIZE			256U
+
+static char Text[TEXT_SIZE];
+static volatile uint32_t Sink;
+
+static double Now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+}
+
+/* 与原usb_printf相同的调用方式 */
+static int LibcPrint(const char *format, ...)
+{
+	va_list args;
+	int len;
+
+	va_start(args, format);
+	len = vsnprintf(Text, sizeof(Text), format, args);
+	va_end(args);
+	return len;
+}
+
+static void Report(const char *name, double libc, double fmt)
+{
+	printf("bench_fmt: %-10s vsnprintf %6.1f ns, FMT %6.1f ns (%.1fx)\n",
+	       name, libc / BENCH_ROUNDS, fmt / BENCH_ROUNDS, libc / fmt);
+}
+
+int main(void)
+{
+	FMT_WriterTypeDef w;
+	uint32_t i;
+	double t0, t1, t2;
+
+	/* 8个字段的遥测行 */
+	t0 = Now();
+	for(i = 0U; i < BENCH_ROUNDS; i++)
+		Sink += (uint32_t)LibcPrint("$PSCX,%u,%d,%d,%d,%u,%u,%02X*%02X\r\n", i, -374512345 + (int)i, 1451234567 - (int)i,
+		                            12345, i & 1023U, i % 360U, i & 0xFFU, i & 0x7FU);
+	t1 = Now();
+	for(i = 0U; i < BENCH_ROUNDS; i++)
+	{
+		FMT_Init(&w, (uint8_t *)Text, sizeof(Text));
+		FMT_Print(&w, "$PSCX,%u,%d,%d,%d,%u,%u,%02X*%02X\r\n", i, -374512345 + (int)i, 1451234567 - (int)i,
+		          12345, i & 1023U, i % 360U, i & 0xFFU, i & 0x7FU);
+		Sink += w.Length;
+	}
+	t2 = Now();
+	Report("line", t1 - t0, t2 - t1);
+
+	/* 单个%u */
+	t0 = Now();
+	for(i = 0U; i < BENCH_ROUNDS; i++)
+		Sink += (uint32_t)LibcPrint("%u", i * 2654435761U);
+	t1 = Now();
+	for(i = 0U; i < BENCH_ROUNDS; i++)
+	{
+		FMT_Init(&w, (uint8_t *)Text, sizeof(Text));
+		FMT_Print(&w, "%u", i * 2654435761U);
+		Sink += w.Length;
+	}
+	t2 = Now();
+	Report("%u", t1 - t0, t2 - t1);
+
+	/* 1e-7度的经纬度，C库只能经由浮点输出 */
+	t0 = Now();
+	for(i = 0U; i < BENCH_ROUNDS; i++)
+		Sink += (uint32_t)LibcPrint("%.7f,%.7f", (-374512345 + (int)i) * 1e-7, (1451234567 - (int)i) * 1e-7);
+	t1 = Now();
+	for(i = 0U; i < BENCH_ROUNDS; i++)
+	{
+		FMT_Init(&w, (uint8_t *)Text, sizeof(Text));
+		FMT_Fixed(&w, -374512345 + (int32_t)i, 7U);
+		FMT_Char(&w, ',');
+		FMT_Fixed(&w, 1451234567 - (int32_t)i, 7U);
+		Sink += w.Length;
+	}
+	t2 = Now();
+	Report("lat/lon", t1 - t0, t2 - t1);
+
+	return 0;
+}
@@ -0,0 +1,75 @@
+/**
+  ******************************************************************************
+  * @file    bench_nmea.c
+  * @brief   nmea.c解码吞吐的主机端基准，输出每字节耗时
+  * @note    x86主机同时给出TSC周期数，TSC按标称频率计数，与睿频后的核心周期不完全相同。
+  *          目标板上的周期数需用DWT->CYCCNT另行测量，这里只用于比较改动前后的差异。
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "nmea.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_TSC			1
+#endif
+
+#define BENCH_SIZE			(1U << 20)
+#define BENCH_ROUNDS		50U
+
+static const char Mixed[] =
+	"$GPGGA,123519.00,4807.038,N,01131.000,E,1,08,0.9,545.4,M,-46.9,M,,*44\r\n"
+	"$GPRMC,123519,A,4807.038,N,01131.000,W,022.4,084.4,230394,003.1,W*78\r\n"
+	"$GPGSV,3,1,10,04,55,226,28,07,21,318,42,08,80,217,18,09,43,285,43,0*6D\r\n"
+	"$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K,A*25\r\n";
+
+static uint8_t Buffer[BENCH_SIZE];
+static NMEA_DecoderTypeDef Decoder;
+static volatile uint32_t Sink;
+
+static void Count(const NMEA_SentenceTypeDef *sentence)
+{
+	Sink += sentence->Type;
+}
+
+int main(void)
+{
+	uint32_t len = (uint32_t)strlen(Mixed);
+	uint32_t size = 0U, i;
+	struct timespec t0, t1;
+	double ns;
+#ifdef BENCH_TSC
+	unsigned long long c0, c1;
+#endif
+
+	while(size + len <= BENCH_SIZE)
+	{
+		memcpy(&Buffer[size], Mixed, len);
+		size += len;
+	}
+
+	NMEA_Init(&Decoder, Count);
+	(void)NMEA_Input(&Decoder, Buffer, size);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+#ifdef BENCH_TSC
+	c0 = __rdtsc();
+#endif
+	for(i = 0U; i < BENCH_ROUNDS; i++)
+		(void)NMEA_Input(&Decoder, Buffer, size);
+#ifdef BENCH_TSC
+	c1 = __rdtsc();
+#endif
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	ns = (double)(t1.tv_sec - t0.tv_sec) * 1e9 + (double)(t1.tv_nsec - t0.tv_nsec);
+	printf("bench_nmea: %u bytes x %u, %.2f ns/byte", size, BENCH_ROUNDS, ns / ((double)size * BENCH_ROUNDS));
+#ifdef BENCH_TSC
+	printf(", %.1f TSC cycles/byte", (double)(c1 - c0) / ((double)size * BENCH_ROUNDS));
+#endif
+	printf(", %u sentences, %u checksum errors\n", Decoder.Stats.Sentences, Decoder.Stats.ChecksumErrors);
+
+	return (Decoder.Stats.ChecksumErrors != 0U) || (Decoder.Stats.FormatErrors != 0U);
+}
@@ -0,0 +1,121 @@
+/**
+  ******************************************************************************
+  * @file    bench_scan.c
+  * @brief   scan.c扫描内核与逐字节实现的主机端对比基准，输出每次调用的耗时
+  * @note    主机上运行的是SWAR分支；DSP分支的耗时需在目标板上用DWT->CYCCNT测量。
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <time.h>
+#include "scan.h"
+
+#define BENCH_ROUNDS		2000000U
+#define LINE_SIZE			82U
+#define BLOCK_SIZE			1024U
+
+static uint8_t Line[LINE_SIZE];
+static uint8_t Block[BLOCK_SIZE];
+static volatile uint32_t Sink;
+
+/* 阻止编译器把循环不变的调用提到循环外 */
+#define BENCH_BARRIER()		__asm__ volatile("" : : "r"(Line), "r"(Block) : "memory")
+
+static uint32_t RefByte(const uint8_t *buf, uint32_t len, uint8_t c)
+{
+	uint32_t i;
+
+	for(i = 0U; (i < len) && (buf[i] != c); i++);
+	return i;
+}
+
+static uint32_t RefByte3(const uint8_t *buf, uint32_t len, uint8_t a, uint8_t b, uint8_t c)
+{
+	uint32_t i;
+
+	for(i = 0U; (i < len) && (buf[i] != a) && (buf[i] != b) && (buf[i] != c); i++);
+	return i;
+}
+
+static uint32_t RefText(const uint8_t *buf, uint32_t len, uint8_t stop)
+{
+	uint32_t i;
+
+	for(i = 0U; (i < len) && (buf[i] >= SCAN_TEXT_MIN) && (buf[i] <= SCAN_TEXT_MAX) && (buf[i] != stop); i++);
+	return i;
+}
+
+static uint8_t RefXor(const uint8_t *buf, uint32_t len)
+{
+	uint8_t sum = 0U;
+
+	while(len--)
+		sum ^= *buf++;
+	return sum;
+}
+
+static uint16_t RefFletcher(const uint8_t *buf, uint32_t len)
+{
+	uint8_t a = 0U, b = 0U;
+
+	while(len--)
+	{
+		a = (uint8_t)(a + *buf++);
+		b = (uint8_t)(b + a);
+	}
+	return (uint16_t)(a | (b << 8));
+}
+
+static double Now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+}
+
+#define BENCH(name, ref, scan)													\
+	do																			\
+	{																			\
+		double _t0, _t1, _t2;													\
+		uint32_t _i;															\
+		_t0 = Now();															\
+		for(_i = 0U; _i < BENCH_ROUNDS; _i++)									\
+		{																		\
+			Sink += (ref);														\
+			BENCH_BARRIER();													\
+		}																		\
+		_t1 = Now();															\
+		for(_i = 0U; _i < BENCH_ROUNDS; _i++)									\
+		{																		\
+			Sink += (scan);														\
+			BENCH_BARRIER();													\
+		}																		\
+		_t2 = Now();															\
+		printf("bench_scan: %-14s byte %6.1f ns, scan %6.1f ns (%.1fx)\n", (name),	\
+		       (_t1 - _t0) / BENCH_ROUNDS, (_t2 - _t1) / BENCH_ROUNDS, (_t1 - _t0) / (_t2 - _t1));	\
+	}while(0)
+
+int main(void)
+{
+	uint32_t i, seed = 7U;
+
+	/* 80字符的NMEA长度文本行，以及不含目标字节的二进制块 */
+	for(i = 0U; i < LINE_SIZE - 2U; i++)
+		Line[i] = (uint8_t)('A' + i % 26U);
+	Line[LINE_SIZE - 2U] = '\r';
+	Line[LINE_SIZE - 1U] = '\n';
+	for(i = 0U; i < BLOCK_SIZE; i++)
+	{
+		seed = seed * 1103515245U + 12345U;
+		Block[i] = (uint8_t)((seed >> 16) | 1U);
+	}
+
+	BENCH("text 80", RefText(Line, LINE_SIZE, '$'), SCAN_Text(Line, LINE_SIZE, '$'));
+	BENCH("xor 80", RefXor(Line, 80U), SCAN_Xor(Line, 80U));
+	BENCH("byte 1024", RefByte(Block, BLOCK_SIZE, 0U), SCAN_Byte(Block, BLOCK_SIZE, 0U));
+	BENCH("byte3 1024", RefByte3(Block, BLOCK_SIZE, 0x24U, 0xB4U, 0xD2U), SCAN_Byte3(Block, BLOCK_SIZE, 0x24U, 0xB4U, 0xD2U));
+	BENCH("fletcher 1024", RefFletcher(Block, BLOCK_SIZE), SCAN_Fletcher(Block, BLOCK_SIZE));
+
+	return 0;
+}
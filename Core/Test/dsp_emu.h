@@ -0,0 +1,103 @@
+/**
+  ******************************************************************************
+  * @file    dsp_emu.h
+  * @brief   Cortex-M7 DSP扩展指令的主机端逐字节模拟，用于在主机上测试scan.c的DSP分支
+  * @note    GE标志是全局状态，与指令相同，只在单线程测试中使用。
+  ******************************************************************************
+  */
+
+#ifndef __DSP_EMU_H
+#define __DSP_EMU_H
+
+#include <stdint.h>
+
+static uint8_t DSP_GE[4];
+
+static inline uint32_t __UADD8(uint32_t a, uint32_t b)
+{
+	uint32_t r = 0U, s, i;
+
+	for(i = 0U; i < 4U; i++)
+	{
+		s = ((a >> (8U * i)) & 0xFFU) + ((b >> (8U * i)) & 0xFFU);
+		DSP_GE[i] = (uint8_t)(s >= 0x100U);
+		r |= (s & 0xFFU) << (8U * i);
+	}
+	return r;
+}
+
+static inline uint32_t __USUB8(uint32_t a, uint32_t b)
+{
+	uint32_t r = 0U, i;
+	int32_t s;
+
+	for(i = 0U; i < 4U; i++)
+	{
+		s = (int32_t)((a >> (8U * i)) & 0xFFU) - (int32_t)((b >> (8U * i)) & 0xFFU);
+		DSP_GE[i] = (uint8_t)(s >= 0);
+		r |= ((uint32_t)s & 0xFFU) << (8U * i);
+	}
+	return r;
+}
+
+static inline uint32_t __SEL(uint32_t a, uint32_t b)
+{
+	uint32_t r = 0U, i;
+
+	for(i = 0U; i < 4U; i++)
+		r |= ((DSP_GE[i] != 0U) ? a : b) & (0xFFUL << (8U * i));
+	return r;
+}
+
+static inline uint32_t __USAD8(uint32_t a, uint32_t b)
+{
+	uint32_t s = 0U, i;
+	int32_t d;
+
+	for(i = 0U; i < 4U; i++)
+	{
+		d = (int32_t)((a >> (8U * i)) & 0xFFU) - (int32_t)((b >> (8U * i)) & 0xFFU);
+		s += (uint32_t)((d < 0) ? -d : d);
+	}
+	return s;
+}
+
+static inline uint32_t __UXTB16(uint32_t a)
+{
+	return a & 0x00FF00FFUL;
+}
+
+static inline uint32_t __SMUAD(uint32_t a, uint32_t b)
+{
+	return (uint32_t)((int32_t)(int16_t)a * (int16_t)b + (int32_t)(int16_t)(a >> 16) * (int16_t)(b >> 16));
+}
+
+static inline uint32_t __SMLAD(uint32_t a, uint32_t b, uint32_t c)
+{
+	return __SMUAD(a, b) + c;
+}
+
+static inline uint32_t __RBIT(uint32_t a)
+{
+	uint32_t r = 0U, i;
+
+	for(i = 0U; i < 32U; i++)
+	{
+		if((a & (1UL << i)) != 0U)
+			r |= 1UL << (31U - i);
+	}
+	return r;
+}
+
+static inline uint32_t __CLZ(uint32_t a)
+{
+	return (a != 0U) ? (uint32_t)__builtin_clz(a) : 32U;
+}
+
+static inline uint32_t __ROR(uint32_t a, uint32_t n)
+{
+	n &= 31U;
+	return (n != 0U) ? ((a >> n) | (a << (32U - n))) : a;
+}
+
+#endif /* __DSP_EMU_H */
@@ -0,0 +1,322 @@
+/**
+  ******************************************************************************
+  * @file    fatfs_ram.c
+  * @brief   主机测试用的内存FatFs，接口见Stub/fatfs.h
+  *           - 根目录中最多RAM_FILES个文件，内容放在堆上
+  *           - f_expand只在请求不超过RAM_Reset给定的连续空间时成功，
+  *             预分配的空间填0xFF，模拟卡上的旧数据
+  *           - 快速定位模式下文件不能变长，与FatFs相同
+  *           - 记录各操作的次数与不对齐的写入，供测试检查
+  ******************************************************************************
+  */
+
+#include <stdlib.h>
+#include <string.h>
+#include "fatfs.h"
+
+#define RAM_FILES			8
+#define RAM_SECTOR_SIZE		512U
+#define RAM_STALE			0xFFU
+
+typedef struct
+{
+	char Name[13];
+	uint8_t *Data;
+	uint32_t Size;
+	uint32_t Cap;
+}RAM_FileTypeDef;
+
+FATFS SDFatFS;
+char SDPath[4] = "0:/";
+RAM_StatsTypeDef RAM_Stats;
+
+static RAM_FileTypeDef RAM_Dir[RAM_FILES];
+static uint32_t RAM_Contiguous;
+static uint8_t RAM_ReadFail;
+
+/**
+  * @brief  RAM_Reset 删除全部文件并卸载
+  * @param  contiguous: 卡上最大的连续空闲空间，f_expand超过此值时返回FR_DENIED
+  */
+void RAM_Reset(uint32_t contiguous)
+{
+	int i;
+
+	for(i = 0; i < RAM_FILES; i++)
+		free(RAM_Dir[i].Data);
+	memset(RAM_Dir, 0, sizeof(RAM_Dir));
+	memset(&RAM_Stats, 0, sizeof(RAM_Stats));
+	SDFatFS.fs_type = 0U;
+	RAM_Contiguous = contiguous;
+	RAM_ReadFail = 0U;
+}
+
+/**
+  * @brief  RAM_File 读取文件内容
+  * @param  name: 不含盘符的文件名
+  * @param  size: 文件大小
+  * @retval 文件不存在时为NULL
+  */
+const uint8_t *RAM_File(const char *name, uint32_t *size)
+{
+	int i;
+
+	for(i = 0; i < RAM_FILES; i++)
+	{
+		if((RAM_Dir[i].Name[0] != '\0') && (strcmp(RAM_Dir[i].Name, name) == 0))
+		{
+			*size = RAM_Dir[i].Size;
+			return RAM_Dir[i].Data;
+		}
+	}
+	return NULL;
+}
+
+/**
+  * @brief  RAM_FailReads 之后的f_read都返回FR_DISK_ERR
+  */
+void RAM_FailReads(uint8_t fail)
+{
+	RAM_ReadFail = fail;
+}
+
+/**
+  * @brief  RAM_Resize 调整文件大小，新增部分填fill
+  */
+static void RAM_Resize(RAM_FileTypeDef *file, uint32_t size, uint8_t fill)
+{
+	if(size > file->Cap)
+	{
+		file->Cap = (size + 0xFFFFU) & ~0xFFFFU;
+		file->Data = realloc(file->Data, file->Cap);
+	}
+	if(size > file->Size)
+		memset(&file->Data[file->Size], fill, size - file->Size);
+	file->Size = size;
+}
+
+/**
+  * @brief  RAM_Name 去掉盘符与根目录
+  */
+static const char *RAM_Name(const char *path)
+{
+	if(strncmp(path, SDPath, strlen(SDPath)) == 0)
+		path += strlen(SDPath);
+	return path;
+}
+
+static FRESULT RAM_Check(FIL *fp)
+{
+	if((SDFatFS.fs_type == 0U) || (fp->obj.fs != &SDFatFS))
+		return FR_INVALID_OBJECT;
+	return FR_OK;
+}
+
+FRESULT f_mount(FATFS *fs, const char *path, BYTE opt)
+{
+	if(fs == NULL)
+	{
+		SDFatFS.fs_type = 0U;
+		RAM_Stats.Unmounts++;
+		return FR_OK;
+	}
+	fs->fs_type = 3U;
+	RAM_Stats.Mounts++;
+	return FR_OK;
+}
+
+FRESULT f_open(FIL *fp, const char *path, BYTE mode)
+{
+	const char *name = RAM_Name(path);
+	int i, id = -1;
+
+	memset(fp, 0, sizeof(*fp));
+	if(SDFatFS.fs_type == 0U)
+		return FR_NOT_ENABLED;
+
+	for(i = 0; i < RAM_FILES; i++)
+	{
+		if((RAM_Dir[i].Name[0] != '\0') && (strcmp(RAM_Dir[i].Name, name) == 0))
+			id = i;
+	}
+	if(id < 0)
+	{
+		if((mode & (FA_CREATE_ALWAYS | FA_CREATE_NEW | FA_OPEN_ALWAYS)) == 0U)
+			return FR_NO_FILE;
+		for(i = 0; (i < RAM_FILES) && (id < 0); i++)
+		{
+			if(RAM_Dir[i].Name[0] == '\0')
+				id = i;
+		}
+		if((id < 0) || (strlen(name) >= sizeof(RAM_Dir[0].Name)))
+			return FR_DENIED;
+		strcpy(RAM_Dir[id].Name, name);
+	}
+	if((mode & FA_CREATE_ALWAYS) != 0U)
+		RAM_Dir[id].Size = 0U;
+
+	fp->obj.fs = &SDFatFS;
+	fp->obj.objsize = RAM_Dir[id].Size;
+	fp->flag = mode;
+	fp->id = id;
+	RAM_Stats.Opens++;
+	return FR_OK;
+}
+
+FRESULT f_close(FIL *fp)
+{
+	if(RAM_Check(fp) != FR_OK)
+		return FR_INVALID_OBJECT;
+	fp->obj.fs = NULL;
+	RAM_Stats.Closes++;
+	return FR_OK;
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br)
+{
+	RAM_FileTypeDef *file = &RAM_Dir[fp->id];
+
+	*br = 0U;
+	if(RAM_Check(fp) != FR_OK)
+		return FR_INVALID_OBJECT;
+	if(RAM_ReadFail != 0U)
+		return FR_DISK_ERR;
+	if(fp->fptr >= fp->obj.objsize)
+		return FR_OK;
+	if(btr > fp->obj.objsize - fp->fptr)
+		btr = fp->obj.objsize - fp->fptr;
+	memcpy(buff, &file->Data[fp->fptr], btr);
+	fp->fptr += btr;
+	*br = btr;
+	RAM_Stats.ReadBytes += btr;
+	return FR_OK;
+}
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw)
+{
+	RAM_FileTypeDef *file = &RAM_Dir[fp->id];
+
+	*bw = 0U;
+	if(RAM_Check(fp) != FR_OK)
+		return FR_INVALID_OBJECT;
+	if((fp->flag & FA_WRITE) == 0U)
+		return FR_DENIED;
+
+	RAM_Stats.Writes++;
+	if(((fp->fptr % RAM_SECTOR_SIZE) != 0U) || ((btw % RAM_SECTOR_SIZE) != 0U))
+		RAM_Stats.Unaligned++;
+	if((fp->cltbl != NULL) && (fp->fptr + btw > fp->obj.objsize))
+	{
+		RAM_Stats.Overruns++;
+		return FR_DENIED;
+	}
+
+	if(fp->fptr + btw > file->Size)
+		RAM_Resize(file, fp->fptr + btw, 0U);
+	memcpy(&file->Data[fp->fptr], buff, btw);
+	fp->fptr += btw;
+	if(fp->fptr > fp->obj.objsize)
+		fp->obj.objsize = fp->fptr;
+	*bw = btw;
+	return FR_OK;
+}
+
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs)
+{
+	RAM_FileTypeDef *file = &RAM_Dir[fp->id];
+
+	if(RAM_Check(fp) != FR_OK)
+		return FR_INVALID_OBJECT;
+	if(ofs == CREATE_LINKMAP)
+	{
+		if(fp->cltbl == NULL)
+			return FR_INVALID_PARAMETER;
+		RAM_Stats.FastSeeks++;
+		return FR_OK;
+	}
+
+	/* 快速定位模式或只读时不能定位到文件结尾之外，可写时文件变长 */
+	if(ofs > fp->obj.objsize)
+	{
+		if((fp->cltbl != NULL) || ((fp->flag & FA_WRITE) == 0U))
+			ofs = fp->obj.objsize;
+		else
+		{
+			RAM_Resize(file, ofs, 0U);
+			fp->obj.objsize = ofs;
+		}
+	}
+	fp->fptr = ofs;
+	return FR_OK;
+}
+
+FRESULT f_expand(FIL *fp, FSIZE_t fsz, BYTE opt)
+{
+	RAM_FileTypeDef *file = &RAM_Dir[fp->id];
+
+	if(RAM_Check(fp) != FR_OK)
+		return FR_INVALID_OBJECT;
+	if(RAM_Stats.Expands < sizeof(RAM_Stats.ExpandSize) / sizeof(RAM_Stats.ExpandSize[0]))
+		RAM_Stats.ExpandSize[RAM_Stats.Expands] = fsz;
+	RAM_Stats.Expands++;
+
+	/* 只能为空文件分配，找不到足够大的连续空间时返回FR_DENIED */
+	if((fp->obj.objsize != 0U) || (fsz > RAM_Contiguous))
+		return FR_DENIED;
+	if(opt != 0U)
+	{
+		RAM_Resize(file, fsz, RAM_STALE);
+		fp->obj.objsize = fsz;
+	}
+	return FR_OK;
+}
+
+FRESULT f_sync(FIL *fp)
+{
+	if(RAM_Check(fp) != FR_OK)
+		return FR_INVALID_OBJECT;
+	RAM_Stats.Syncs++;
+	return FR_OK;
+}
+
+FRESULT f_truncate(FIL *fp)
+{
+	if(RAM_Check(fp) != FR_OK)
+		return FR_INVALID_OBJECT;
+	RAM_Dir[fp->id].Size = fp->fptr;
+	fp->obj.objsize = fp->fptr;
+	RAM_Stats.Truncates++;
+	return FR_OK;
+}
+
+FRESULT f_opendir(DIR *dp, const char *path)
+{
+	if(SDFatFS.fs_type == 0U)
+		return FR_NOT_ENABLED;
+	dp->obj.fs = &SDFatFS;
+	dp->index = 0U;
+	return FR_OK;
+}
+
+FRESULT f_readdir(DIR *dp, FILINFO *fno)
+{
+	memset(fno, 0, sizeof(*fno));
+	while(dp->index < RAM_FILES)
+	{
+		if(RAM_Dir[dp->index].Name[0] != '\0')
+		{
+			strcpy(fno->fname, RAM_Dir[dp->index].Name);
+			fno->fsize = RAM_Dir[dp->index].Size;
+			dp->index++;
+			return FR_OK;
+		}
+		dp->index++;
+	}
+	return FR_OK;
+}
+
+FRESULT f_closedir(DIR *dp)
+{
+	dp->obj.fs = NULL;
+	return FR_OK;
+}
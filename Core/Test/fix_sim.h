@@ -0,0 +1,125 @@
+/**
+  ******************************************************************************
+  * @file    fix_sim.h
+  * @brief   10Hz定位结果的模拟行驶，test_fix_codec.c与bench_fix_codec.c共用
+  * @note    加速、匀速、转弯、停车交替，位置、高度、速度与航向叠加接收机噪声，
+  *          HDOP与卫星数偶尔变化，约每600个历元有一个没有同历元RMC。
+  *          使用自带的伪随机数，各平台生成的序列相同。
+  ******************************************************************************
+  */
+
+#ifndef __FIX_SIM_H
+#define __FIX_SIM_H
+
+#include <math.h>
+#include <stdint.h>
+#include "fix_codec.h"
+
+#define SIM_DEG				1e7					/**< 度到1e-7度 */
+#define SIM_M_PER_DEG		111320.0
+#define SIM_KNOT			0.514444			/**< 1节，m/s */
+
+typedef struct
+{
+	uint32_t Seed;
+	uint32_t Epoch;
+	double Lat;									/**< 度 */
+	double Lon;
+	double Alt;									/**< 米 */
+	double Speed;								/**< m/s */
+	double Course;								/**< 度 */
+	double Target;								/**< 目标速度 */
+	double Turn;								/**< 转弯角速度，度/历元 */
+	uint32_t Phase;								/**< 当前阶段剩余的历元数 */
+	uint16_t Hdop;
+	uint8_t Satellites;
+}SIM_DriveTypeDef;
+
+static inline uint32_t SIM_Random(SIM_DriveTypeDef *s)
+{
+	s->Seed = s->Seed * 1103515245U + 12345U;
+	return s->Seed >> 8;
+}
+
+/* -1.0~1.0均匀分布 */
+static inline double SIM_Uniform(SIM_DriveTypeDef *s)
+{
+	return (double)(SIM_Random(s) & 0xFFFFU) / 32767.5 - 1.0;
+}
+
+static inline void SIM_Init(SIM_DriveTypeDef *s, uint32_t seed)
+{
+	s->Seed = seed;
+	s->Epoch = 0U;
+	s->Lat = 31.2304;
+	s->Lon = 121.4737;
+	s->Alt = 12.5;
+	s->Speed = 0.0;
+	s->Course = 90.0;
+	s->Target = 0.0;
+	s->Turn = 0.0;
+	s->Phase = 0U;
+	s->Hdop = 85U;
+	s->Satellites = 18U;
+}
+
+/**
+  * @brief  SIM_Next 推进一个历元(100ms)
+  * @param  fix: 输出的定位结果
+  * @retval 1:有同历元的RMC 0:没有，Speed与Course为FIX_INVALID
+  */
+static inline uint8_t SIM_Next(SIM_DriveTypeDef *s, FIX_RecordTypeDef *fix)
+{
+	double step, rad, course;
+	uint8_t matched;
+
+	/* 每个阶段随机选择停车、直行或转弯 */
+	if(s->Phase == 0U)
+	{
+		s->Phase = 50U + SIM_Random(s) % 300U;
+		switch(SIM_Random(s) % 4U)
+		{
+			case 0U:  s->Target = 0.0; s->Turn = 0.0; break;
+			case 1U:  s->Target = 8.0 + 6.0 * SIM_Uniform(s); s->Turn = 0.0; break;
+			default:  s->Target = 5.0 + 3.0 * SIM_Uniform(s); s->Turn = 1.5 * SIM_Uniform(s); break;
+		}
+	}
+	s->Phase--;
+
+	if(s->Speed < s->Target)
+		s->Speed = fmin(s->Target, s->Speed + 0.25);
+	else
+		s->Speed = fmax(s->Target, s->Speed - 0.4);
+	if(s->Speed > 0.0)
+		s->Course = fmod(s->Course + s->Turn + 360.0, 360.0);
+
+	step = s->Speed * 0.1;
+	rad = s->Course * M_PI / 180.0;
+	s->Lat += step * cos(rad) / SIM_M_PER_DEG;
+	s->Lon += step * sin(rad) / (SIM_M_PER_DEG * cos(s->Lat * M_PI / 180.0));
+	s->Alt += 0.02 * SIM_Uniform(s);
+
+	if((SIM_Random(s) % 500U) == 0U)
+		s->Hdop = (uint16_t)(60U + SIM_Random(s) % 80U);
+	if((SIM_Random(s) % 800U) == 0U)
+		s->Satellites = (uint8_t)(12U + SIM_Random(s) % 14U);
+
+	/* 静止时航向保持不变，只有位置噪声 */
+	course = s->Course + ((s->Speed > 0.0) ? 0.3 * SIM_Uniform(s) : 0.0);
+	matched = (uint8_t)((SIM_Random(s) % 600U) != 0U);
+
+	fix->Time = (36000000U + s->Epoch * 100U) % 86400000U;
+	fix->Latitude = (int32_t)lround((s->Lat + 3e-7 * SIM_Uniform(s)) * SIM_DEG);
+	fix->Longitude = (int32_t)lround((s->Lon + 3e-7 * SIM_Uniform(s)) * SIM_DEG);
+	fix->Altitude = (int32_t)lround((s->Alt + 0.01 * SIM_Uniform(s)) * 1000.0);
+	fix->Speed = matched ? (uint32_t)lround(fmax(0.0, s->Speed / SIM_KNOT + 0.02 * SIM_Uniform(s)) * 1000.0) : FIX_INVALID;
+	fix->Course = matched ? (uint32_t)lround(fmod(course + 360.0, 360.0) * 100.0) : FIX_INVALID;
+	fix->Hdop = s->Hdop;
+	fix->Quality = 4U;
+	fix->Satellites = s->Satellites;
+	s->Epoch++;
+
+	return matched;
+}
+
+#endif /* __FIX_SIM_H */
@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * @file    test.h
+  * @brief   主机端单元测试的断言宏，Core/Test与USB_DEVICE/Test共用
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __TEST_H
+#define __TEST_H
+
+#include <stdio.h>
+
+/* 每个测试程序只有一个翻译单元包含本文件 */
+static unsigned int Test_Checks;
+static unsigned int Test_Failures;
+
+#define CHECK(cond)																\
+	do																			\
+	{																			\
+		Test_Checks++;															\
+		if(!(cond))																\
+		{																		\
+			Test_Failures++;													\
+			printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);		\
+		}																		\
+	}while(0)
+
+#define CHECK_EQ(a, b)															\
+	do																			\
+	{																			\
+		long long _a = (long long)(a), _b = (long long)(b);						\
+		Test_Checks++;															\
+		if(_a != _b)															\
+		{																		\
+			Test_Failures++;													\
+			printf("%s:%d: %s == %lld, expected %lld\n", __FILE__, __LINE__, #a, _a, _b);	\
+		}																		\
+	}while(0)
+
+/* main()的返回值：全部通过返回0 */
+#define TEST_RESULT(name)														\
+	(printf("%s: %u checks, %u failed\n", (name), Test_Checks, Test_Failures), (Test_Failures != 0U))
+
+#endif /* __TEST_H */
@@ -0,0 +1,204 @@
+/**
+  ******************************************************************************
+  * @file    test_fix_codec.c
+  * @brief   fix_codec.c的主机端测试
+  *           - 模拟行驶的200k个定位结果按块编码后逐位还原
+  *           - 每FIX_KEY_INTERVAL个定位结果一个关键帧，从任一关键帧开始都能解码
+  *           - Speed、Course为FIX_INVALID与有效值交替时还原不变
+  *           - 字段取极值、差分按模2^32回绕时还原不变，编码长度不超过FIX_ENCODED_MAX
+  *           - 数据不完整、关键帧之前的差分帧、非法头与过长的变长整数返回0
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "fix_codec.h"
+#include "fix_sim.h"
+#include "test.h"
+
+#define SIM_FIXES			200000U
+
+static FIX_RecordTypeDef Fixes[SIM_FIXES];
+static uint8_t Stream[SIM_FIXES * FIX_ENCODED_MAX];
+static uint32_t Offset[SIM_FIXES + 1U];		/**< 各定位结果在Stream中的位置 */
+
+static uint8_t Same(const FIX_RecordTypeDef *a, const FIX_RecordTypeDef *b)
+{
+	return (uint8_t)((a->Time == b->Time) && (a->Latitude == b->Latitude) && (a->Longitude == b->Longitude)
+			&& (a->Altitude == b->Altitude) && (a->Speed == b->Speed) && (a->Course == b->Course)
+			&& (a->Hdop == b->Hdop) && (a->Quality == b->Quality) && (a->Satellites == b->Satellites));
+}
+
+/**
+  * @brief  EncodeAll 编码Fixes[0..count)，记录各定位结果的位置
+  */
+static void EncodeAll(uint32_t count)
+{
+	FIX_CodecTypeDef codec;
+	uint32_t i, n;
+
+	FIX_Reset(&codec);
+	Offset[0] = 0U;
+	for(i = 0U; i < count; i++)
+	{
+		CHECK_EQ(FIX_KEY_DUE(&codec), (i % FIX_KEY_INTERVAL) == 0U);
+		n = FIX_Encode(&codec, &Fixes[i], &Stream[Offset[i]]);
+		CHECK(n <= FIX_ENCODED_MAX);
+		/* 关键帧的头为FIX_HEADER_KEY，差分帧的头bit0为0 */
+		CHECK_EQ(Stream[Offset[i]] & FIX_HEADER_KEY, (i % FIX_KEY_INTERVAL) == 0U);
+		Offset[i + 1U] = Offset[i] + n;
+	}
+}
+
+/**
+  * @brief  DecodeFrom 从第first个定位结果所在的块开始解码到count
+  * @retval 与原值不一致的定位结果数
+  */
+static uint32_t DecodeFrom(uint32_t first, uint32_t count)
+{
+	FIX_CodecTypeDef codec;
+	FIX_RecordTypeDef fix;
+	uint32_t i, n, errors = 0U;
+
+	for(i = first; i < count; i++)
+	{
+		/* 每块用新的解码状态，与逐条读取FIX记录相同 */
+		if((i % FIX_KEY_INTERVAL) == 0U)
+			FIX_Reset(&codec);
+		memset(&fix, 0, sizeof(fix));
+		n = FIX_Decode(&codec, &Stream[Offset[i]], Offset[count] - Offset[i], &fix);
+		if((n != Offset[i + 1U] - Offset[i]) || (Same(&fix, &Fixes[i]) == 0U))
+			errors++;
+	}
+	return errors;
+}
+
+static void TestDrive(void)
+{
+	SIM_DriveTypeDef sim;
+	uint32_t i, invalid = 0U;
+
+	SIM_Init(&sim, 1U);
+	for(i = 0U; i < SIM_FIXES; i++)
+		invalid += (SIM_Next(&sim, &Fixes[i]) == 0U);
+	CHECK(invalid > 0U);
+
+	EncodeAll(SIM_FIXES);
+	CHECK_EQ(DecodeFrom(0U, SIM_FIXES), 0U);
+	/* 平均每个定位结果不超过10字节 */
+	CHECK(Offset[SIM_FIXES] < 10U * SIM_FIXES);
+
+	/* 从中间任一关键帧开始 */
+	CHECK_EQ(DecodeFrom(16U * 777U, SIM_FIXES), 0U);
+	CHECK_EQ(DecodeFrom(SIM_FIXES - FIX_KEY_INTERVAL, SIM_FIXES), 0U);
+}
+
+static void TestInvalid(void)
+{
+	uint32_t i;
+
+	/* 速度与航向在有效值与FIX_INVALID之间来回切换，跨越关键帧 */
+	memset(Fixes, 0, 64U * sizeof(Fixes[0]));
+	for(i = 0U; i < 64U; i++)
+	{
+		Fixes[i].Time = 1000U * i;
+		Fixes[i].Latitude = 312304000 + (int32_t)i;
+		Fixes[i].Longitude = 1214737000 - (int32_t)i;
+		Fixes[i].Altitude = 12500;
+		Fixes[i].Speed = ((i % 3U) == 0U) ? FIX_INVALID : 12000U + i;
+		Fixes[i].Course = ((i % 5U) < 2U) ? FIX_INVALID : 9000U;
+		Fixes[i].Hdop = 85U;
+		Fixes[i].Quality = 4U;
+		Fixes[i].Satellites = 18U;
+	}
+	EncodeAll(64U);
+	CHECK_EQ(DecodeFrom(0U, 64U), 0U);
+	CHECK_EQ(DecodeFrom(32U, 64U), 0U);
+}
+
+static void TestExtreme(void)
+{
+	static const int32_t Values[] = {0, 1, -1, 0x7FFFFFFF, (int32_t)0x80000000, 0x40000000, -0x40000000, 0x0FFFFFFF};
+	uint32_t i, n = sizeof(Values) / sizeof(Values[0]), max = 0U;
+
+	/* 各字段在极值之间跳变，线性外推的预测值与差分都会溢出回绕 */
+	for(i = 0U; i < 256U; i++)
+	{
+		Fixes[i].Time = (uint32_t)Values[i % n];
+		Fixes[i].Latitude = Values[(i + 1U) % n];
+		Fixes[i].Longitude = Values[(i * 3U) % n];
+		Fixes[i].Altitude = Values[(i * 5U + 2U) % n];
+		Fixes[i].Speed = (uint32_t)Values[(i * 7U + 3U) % n];
+		Fixes[i].Course = (i & 1U) ? FIX_INVALID : 0U;
+		Fixes[i].Hdop = (i & 1U) ? 0xFFFFU : 0U;
+		Fixes[i].Quality = (i & 1U) ? 0xFFU : 0U;
+		Fixes[i].Satellites = (i & 1U) ? 0xFFU : 0U;
+	}
+	EncodeAll(256U);
+	CHECK_EQ(DecodeFrom(0U, 256U), 0U);
+	for(i = 0U; i < 256U; i++)
+	{
+		if(Offset[i + 1U] - Offset[i] > max)
+			max = Offset[i + 1U] - Offset[i];
+	}
+	CHECK(max <= FIX_ENCODED_MAX);
+
+	/* 全部字段出现且32位字段的残差都需要5字节：头2字节，Hdop与Status各3字节 */
+	memset(Fixes, 0, 2U * sizeof(Fixes[0]));
+	Fixes[1].Time = 0x40000000U;
+	Fixes[1].Latitude = 0x40000000;
+	Fixes[1].Longitude = -0x40000001;
+	Fixes[1].Altitude = 0x40000000;
+	Fixes[1].Speed = 0x40000000U;
+	Fixes[1].Course = 0xC0000000U;
+	Fixes[1].Hdop = 0xFFFFU;
+	Fixes[1].Quality = 0xFFU;
+	Fixes[1].Satellites = 0xFFU;
+	EncodeAll(2U);
+	CHECK_EQ(Offset[1], 9U);
+	CHECK_EQ(Offset[2] - Offset[1], 2U + 6U * 5U + 3U + 3U);
+	CHECK_EQ(DecodeFrom(0U, 2U), 0U);
+}
+
+static void TestMalformed(void)
+{
+	static const uint8_t Long[] = {0x80U, 0x80U, 0x80U, 0x80U, 0x80U, 0x00U};
+	static const uint8_t Header[] = {0x80U, 0x04U};
+	FIX_CodecTypeDef codec;
+	FIX_RecordTypeDef fix;
+	uint32_t i, len;
+
+	for(i = 0U; i < 32U; i++)
+		Fixes[i] = Fixes[1];
+	Fixes[0].Time = 0U;
+	EncodeAll(32U);
+
+	/* 截断在任何位置都不解码 */
+	for(len = 0U; len < Offset[1]; len++)
+	{
+		FIX_Reset(&codec);
+		CHECK_EQ(FIX_Decode(&codec, Stream, len, &fix), 0U);
+		CHECK_EQ(codec.Synced, 0U);
+	}
+
+	/* 没有关键帧时差分帧不解码 */
+	FIX_Reset(&codec);
+	CHECK_EQ(FIX_Decode(&codec, &Stream[Offset[1]], Offset[2] - Offset[1], &fix), 0U);
+	FIX_Reset(&codec);
+	CHECK_EQ(FIX_Decode(&codec, Stream, Offset[32], &fix), Offset[1]);
+	CHECK_EQ(FIX_Decode(&codec, &Stream[Offset[1]], Offset[32] - Offset[1], &fix), Offset[2] - Offset[1]);
+
+	/* 头超过9位、变长整数超过5字节 */
+	FIX_Reset(&codec);
+	CHECK_EQ(FIX_Decode(&codec, Header, sizeof(Header), &fix), 0U);
+	CHECK_EQ(FIX_Decode(&codec, Long, sizeof(Long), &fix), 0U);
+}
+
+int main(void)
+{
+	TestDrive();
+	TestInvalid();
+	TestExtreme();
+	TestMalformed();
+
+	return TEST_RESULT("test_fix_codec");
+}
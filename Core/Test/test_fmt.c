@@ -0,0 +1,153 @@
+/**
+  ******************************************************************************
+  * @file    test_fmt.c
+  * @brief   fmt.c格式化输出的主机端测试
+  *           - 支持的说明符与标志、宽度、精度的组合，结果与C库snprintf逐字节相同
+  *           - 不支持的转换原样输出且不错位
+  *           - FMT_Fixed定点小数
+  *           - 环形队列回绕与超长输出
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fmt.h"
+#include "test.h"
+
+#define TEXT_SIZE			256U
+#define RANDOM_CASES		200000U
+
+static unsigned int Mismatch;
+
+/* 同一组参数分别交给FMT_Print与snprintf，比较输出 */
+#define SAME(...)																\
+	do																			\
+	{																			\
+		char _a[TEXT_SIZE], _b[TEXT_SIZE];										\
+		FMT_WriterTypeDef _w;													\
+		FMT_Init(&_w, (uint8_t *)_a, TEXT_SIZE - 1U);							\
+		FMT_Print(&_w, __VA_ARGS__);											\
+		_a[(_w.Length < TEXT_SIZE - 1U) ? _w.Length : TEXT_SIZE - 1U] = '\0';	\
+		(void)snprintf(_b, sizeof(_b), __VA_ARGS__);							\
+		Test_Checks++;															\
+		if(strcmp(_a, _b) != 0)													\
+		{																		\
+			Test_Failures++;													\
+			if(Mismatch++ < 10U)												\
+				printf("%s:%d: \"%s\" != \"%s\"\n", __FILE__, __LINE__, _a, _b);	\
+		}																		\
+	}while(0)
+
+static void TestSpecifiers(void)
+{
+	static const int32_t values[] = {0, 1, -1, 9, 10, 99, 100, -100, 12345, -98765, 2147483647, -2147483647 - 1};
+	uint32_t i;
+	int32_t v;
+
+	for(i = 0U; i < sizeof(values) / sizeof(values[0]); i++)
+	{
+		v = values[i];
+		SAME("%d|%i|%u|%x|%X", (int)v, (int)v, (unsigned)v, (unsigned)v, (unsigned)v);
+		SAME("[%5d][%-5d][%05d][%.3d][%8.3d][%-8.3d][%08X]", (int)v, (int)v, (int)v, (int)v, (int)v, (int)v, (unsigned)v);
+		SAME("[%*d][%-*u][%.*x][%.0d]", 6, (int)v, 7, (unsigned)v, 4, (unsigned)v, (int)v);
+	}
+	SAME("%s|%10s|%-10s|%.3s|%c|%3c|%%|%-3c|", "abc", "hi", "lo", "abcdef", 'x', 'y', 'z');
+	SAME("$GPGGA,%02u%02u%02u.%02u,%s*%02X\r\n", 12U, 3U, 4U, 50U, "abc", 0x5AU);
+	SAME("%lu %hu %hhu %zu", 4000000000UL, (unsigned short)65535U, (unsigned char)200U, (size_t)77U);
+}
+
+static void TestRandom(void)
+{
+	uint32_t i;
+	int v, w, p;
+
+	srand(1);
+	for(i = 0U; i < RANDOM_CASES; i++)
+	{
+		v = rand() - RAND_MAX / 2;
+		if((rand() & 1) != 0)
+			v >>= rand() % 31;
+		w = rand() % 12;
+		p = rand() % 12;
+		SAME("%*d|%-*d|%0*d|%.*d|%*.*u|%0*x|%*.*X", w, v, w, v, w, v, p, v, w, p, (unsigned)v, w, (unsigned)v, w, p, (unsigned)v);
+	}
+}
+
+static void TestUnsupported(void)
+{
+	char text[64];
+	FMT_WriterTypeDef w;
+
+	/* %f与%lld原样输出，其后的参数不错位 */
+	FMT_Init(&w, (uint8_t *)text, sizeof(text) - 1U);
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat"
+	FMT_Print(&w, "%f %d %lld %u", 1.5, 3, 5LL, 9U);
+#pragma GCC diagnostic pop
+	text[w.Length] = '\0';
+	CHECK(strcmp(text, "%f 3 %lld 9") == 0);
+}
+
+static void TestFixed(void)
+{
+	static const struct
+	{
+		int32_t Value;
+		uint8_t Decimals;
+		const char *Text;
+	}cases[] =
+	{
+		{-123456789, 7U, "-12.3456789"},
+		{5, 3U, "0.005"},
+		{-5, 3U, "-0.005"},
+		{0, 2U, "0.00"},
+		{123, 0U, "123"},
+		{-2147483647 - 1, 9U, "-2.147483648"},
+		{2147483647, 1U, "214748364.7"}
+	};
+	char text[32];
+	FMT_WriterTypeDef w;
+	uint32_t i;
+
+	for(i = 0U; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		FMT_Init(&w, (uint8_t *)text, sizeof(text) - 1U);
+		FMT_Fixed(&w, cases[i].Value, cases[i].Decimals);
+		text[w.Length] = '\0';
+		CHECK(strcmp(text, cases[i].Text) == 0);
+	}
+}
+
+static void TestRing(void)
+{
+	uint8_t ring[16];
+	FMT_WriterTypeDef w;
+
+	/* 写位置未取模，从12开始写10字节，回绕到开头 */
+	memset(ring, '.', sizeof(ring));
+	FMT_InitRing(&w, ring, sizeof(ring) - 1U, 1000U * sizeof(ring) + 12U, 10U);
+	FMT_Print(&w, "ABCDEFGH%d", 12);
+	CHECK_EQ(w.Length, 10U);
+	CHECK(!FMT_OVERFLOW(&w));
+	CHECK(memcmp(ring, "EFGH12......ABCD", sizeof(ring)) == 0);
+
+	/* 超出可写入的字节数时只写到末尾，Length照常累计 */
+	memset(ring, '.', sizeof(ring));
+	FMT_InitRing(&w, ring, sizeof(ring) - 1U, 12U, 8U);
+	FMT_Print(&w, "0123456789%s", "abcdefghij");
+	CHECK_EQ(w.Length, 20U);
+	CHECK(FMT_OVERFLOW(&w));
+	CHECK(memcmp(ring, "4567........0123", sizeof(ring)) == 0);
+}
+
+int main(void)
+{
+	TestSpecifiers();
+	TestRandom();
+	TestUnsupported();
+	TestFixed();
+	TestRing();
+
+	return TEST_RESULT("test_fmt");
+}
@@ -0,0 +1,191 @@
+/**
+  ******************************************************************************
+  * @file    test_gnss.c
+  * @brief   gnss.c解复用器的主机端测试
+  *           - CRC-24Q校验值
+  *           - NMEA、UBX、RTCM3帧与截断帧、随机字节交错，按1~64字节分段输入，
+  *             每个完整帧按顺序原样分发，截断帧不吞掉其后的完整帧
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "gnss.h"
+#include "test.h"
+
+#define STREAM_SIZE			(1U << 22)
+#define FRAME_NUM_MAX		0x10000U
+
+#define KIND_NMEA			0U
+#define KIND_UBX			1U
+#define KIND_RTCM			2U
+
+static const char Nmea[] = "$GPGSV,3,1,10,04,55,226,28,07,21,318,42,08,80,217,18,09,43,285,43,0*6D\r\n";
+static uint8_t Ubx[8U + 92U];
+static uint8_t Rtcm[6U + 200U];
+
+static uint8_t Stream[STREAM_SIZE];
+static uint32_t StreamLen;
+
+/* 期望的分发顺序 */
+static uint8_t Expected[FRAME_NUM_MAX];
+static uint32_t ExpectedNum;
+static uint32_t Received;
+static uint32_t Mismatch;
+
+static GNSS_DemuxTypeDef Demux;
+static uint32_t Seed = 1U;
+
+static uint32_t Rand(void)
+{
+	Seed = Seed * 1103515245U + 12345U;
+	return Seed >> 8;
+}
+
+static void Next(uint8_t kind)
+{
+	if((Received >= ExpectedNum) || (Expected[Received] != kind))
+		Mismatch++;
+	Received++;
+}
+
+static void OnNmea(const uint8_t *frame, uint32_t len)
+{
+	Next(KIND_NMEA);
+	if((len != sizeof(Nmea) - 1U) || (memcmp(frame, Nmea, len) != 0))
+		Mismatch++;
+}
+
+static void OnUbx(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len)
+{
+	Next(KIND_UBX);
+	if((cls != 0x01U) || (id != 0x07U) || (len != 92U) || (memcmp(payload, &Ubx[6], len) != 0))
+		Mismatch++;
+}
+
+static void OnRtcm(uint16_t type, const uint8_t *frame, uint32_t len)
+{
+	Next(KIND_RTCM);
+	if((type != 1077U) || (len != sizeof(Rtcm)) || (memcmp(frame, Rtcm, len) != 0))
+		Mismatch++;
+}
+
+static const GNSS_ItfTypeDef Itf =
+{
+	OnNmea,
+	OnUbx,
+	OnRtcm
+};
+
+static void Put(const void *data, uint32_t len)
+{
+	memcpy(&Stream[StreamLen], data, len);
+	StreamLen += len;
+}
+
+static void PutFrame(uint8_t kind, const void *data, uint32_t len)
+{
+	Put(data, len);
+	Expected[ExpectedNum++] = kind;
+}
+
+static void MakeFrames(void)
+{
+	uint8_t a = 0U, b = 0U;
+	uint32_t i, crc;
+
+	Ubx[0] = GNSS_UBX_SYNC1;
+	Ubx[1] = GNSS_UBX_SYNC2;
+	Ubx[2] = 0x01U;
+	Ubx[3] = 0x07U;
+	Ubx[4] = 92U;
+	Ubx[5] = 0U;
+	for(i = 0U; i < 92U; i++)
+		Ubx[6U + i] = (uint8_t)Rand();
+	for(i = 2U; i < 98U; i++)
+	{
+		a = (uint8_t)(a + Ubx[i]);
+		b = (uint8_t)(b + a);
+	}
+	Ubx[98] = a;
+	Ubx[99] = b;
+
+	Rtcm[0] = GNSS_RTCM_PREAMBLE;
+	Rtcm[1] = 0U;
+	Rtcm[2] = 200U;
+	for(i = 0U; i < 200U; i++)
+		Rtcm[3U + i] = (uint8_t)Rand();
+	/* 消息类型为负载的前12位 */
+	Rtcm[3] = (uint8_t)(1077U >> 4);
+	Rtcm[4] = (uint8_t)(((1077U & 0x0FU) << 4) | (Rtcm[4] & 0x0FU));
+	crc = GNSS_Crc24q(Rtcm, 203U);
+	Rtcm[203] = (uint8_t)(crc >> 16);
+	Rtcm[204] = (uint8_t)(crc >> 8);
+	Rtcm[205] = (uint8_t)crc;
+}
+
+static void TestCrc(void)
+{
+	CHECK_EQ(GNSS_Crc24q((const uint8_t *)"123456789", 9U), 0xCDE703U);
+	CHECK_EQ(GNSS_Crc24q(NULL, 0U), 0U);
+}
+
+static void TestMixed(void)
+{
+	uint8_t garbage[7];
+	uint32_t i, n, pos;
+
+	MakeFrames();
+	while((StreamLen + 0x400U < STREAM_SIZE) && (ExpectedNum < FRAME_NUM_MAX))
+	{
+		switch(Rand() % 4U)
+		{
+			case 0U:
+				PutFrame(KIND_NMEA, Nmea, sizeof(Nmea) - 1U);
+				break;
+			case 1U:
+				PutFrame(KIND_UBX, Ubx, sizeof(Ubx));
+				break;
+			case 2U:
+				PutFrame(KIND_RTCM, Rtcm, sizeof(Rtcm));
+				break;
+			default:
+				/* 随机字节或截断的帧，其后的完整帧仍须被找到 */
+				n = Rand() % 3U;
+				if(n == 0U)
+				{
+					for(i = 0U; i < sizeof(garbage); i++)
+						garbage[i] = (uint8_t)Rand();
+					Put(garbage, sizeof(garbage));
+				}
+				else if(n == 1U)
+					Put(Ubx, Rand() % (sizeof(Ubx) - 1U));
+				else
+					Put(Nmea, Rand() % (sizeof(Nmea) - 2U));
+				break;
+		}
+	}
+
+	GNSS_Init(&Demux, &Itf);
+	for(pos = 0U; pos < StreamLen; pos += n)
+	{
+		n = 1U + Rand() % 64U;
+		if(n > StreamLen - pos)
+			n = StreamLen - pos;
+		GNSS_Input(&Demux, &Stream[pos], n);
+	}
+
+	CHECK(ExpectedNum > 30000U);
+	CHECK_EQ(Received, ExpectedNum);
+	CHECK_EQ(Mismatch, 0U);
+	CHECK_EQ(Demux.Stats.Frames[GNSS_PROTOCOL_NMEA] + Demux.Stats.Frames[GNSS_PROTOCOL_UBX] +
+	         Demux.Stats.Frames[GNSS_PROTOCOL_RTCM], ExpectedNum);
+	CHECK(Demux.Stats.Garbage > 0U);
+}
+
+int main(void)
+{
+	TestCrc();
+	TestMixed();
+
+	return TEST_RESULT("test_gnss");
+}
@@ -0,0 +1,461 @@
+/**
+  ******************************************************************************
+  * @file    test_logger.c
+  * @brief   logger.c写入路径的主机端测试，SD卡由fatfs_ram.c代替
+  *           - 队列中的记录按序完整写入，不跨块，每块以INDEX记录开始，
+  *             文件序号、块号与块内第一条记录的Tick正确
+  *           - 写入位置与长度始终为扇区整数倍，整块写入
+  *           - f_expand逐次减半，都失败时不预分配并按最小大小切换文件
+  *           - 按周期同步前等待生产者交出暂存数据，生产者不应答时超时后同步
+  *           - 关闭文件时截掉预分配中未使用的部分
+  *           - 卡交给MSC后卸载，MSC访问结束后才重新挂载
+  ******************************************************************************
+  */
+
+#include <setjmp.h>
+#include <string.h>
+#include "test.h"
+
+/* 直接包含源文件，检查文件对象与状态 */
+#include "../Src/logger.c"
+
+#define MB					(1024UL * 1024UL)
+
+static uint32_t Now;
+static jmp_buf Stop;
+static uint8_t (*Hook)(void);
+static uint32_t Deadline;
+
+/* 生产者 */
+static uint32_t Seq;				/**< 已写入队列的记录数 */
+static uint32_t PerMs;				/**< 每ms写入的记录数 */
+static uint8_t Ack;					/**< 应答暂存数据的请求 */
+static uint32_t Acked;
+
+/* 解析 */
+static uint32_t Expect;				/**< 下一条记录的序号 */
+static uint32_t LastTick;
+
+uint32_t osKernelGetTickCount(void)
+{
+	return Now;
+}
+
+/* 记录任务空闲时其他任务运行，由Hook决定何时结束 */
+osStatus_t osDelay(uint32_t ticks)
+{
+	Now += ticks;
+	if((Hook() != 0U) || (Now >= Deadline))
+		longjmp(Stop, 1);
+	return osOK;
+}
+
+void Error_Handler(void)
+{
+	CHECK(0);
+}
+
+void DLOG_Write(uint32_t id, const uint32_t *args, uint32_t argc)
+{
+}
+
+/**
+  * @brief  Run 运行记录任务，直到hook返回1或超过ms
+  */
+static void Run(uint8_t (*hook)(void), uint32_t ms)
+{
+	Hook = hook;
+	Deadline = Now + ms;
+	if(setjmp(Stop) == 0)
+		Logger_Task();
+}
+
+static uint16_t Length(uint32_t seq)
+{
+	return (uint16_t)(4U + (seq * 37U) % 300U);
+}
+
+static uint8_t Pattern(uint32_t seq, uint32_t i)
+{
+	return (uint8_t)(seq * 7U + i);
+}
+
+/**
+  * @brief  Produce 写入一条按序号生成的记录
+  */
+static void Produce(void)
+{
+	uint8_t buf[304];
+	uint16_t len = Length(Seq);
+	uint32_t i;
+
+	Logger_Set32(buf, Seq);
+	for(i = 4U; i < len; i++)
+		buf[i] = Pattern(Seq, i);
+	CHECK_EQ(Logger_Write(LOGGER_TYPE_NMEA, buf, len), 0U);
+	Seq++;
+}
+
+/**
+  * @brief  Answer 按Ack应答暂存数据的请求，暂存的数据作为一条记录交出
+  */
+static void Answer(void)
+{
+	uint32_t req = Logger_FlushRequest();
+
+	if((Ack != 0U) && (req != Acked))
+	{
+		Produce();
+		Logger_FlushDone(req);
+		Acked = req;
+	}
+}
+
+/**
+  * @brief  Tick 每ms写入PerMs条记录并应答请求
+  */
+static void Tick(void)
+{
+	uint32_t i;
+
+	for(i = 0U; i < PerMs; i++)
+		Produce();
+	Answer();
+}
+
+static void Start(uint32_t contiguous, uint32_t per_ms)
+{
+	RAM_Reset(contiguous);
+	Logger_Init(NULL);
+	Now = 0U;
+	Seq = 0U;
+	PerMs = per_ms;
+	Ack = 1U;
+	Acked = 0U;
+	Expect = 0U;
+	LastTick = 0U;
+}
+
+/**
+  * @brief  Parse 检查文件中的记录，序号接续Expect
+  * @param  limit: 检查的长度，之后的内容不检查
+  * @retval 记录数
+  */
+static uint32_t Parse(const uint8_t *data, uint32_t limit, uint32_t file)
+{
+	uint32_t pos = 0U, end, size, seq, tick, i, count = 0U;
+	uint8_t ok;
+
+	while(pos < limit)
+	{
+		/* 每块以本文件的INDEX记录开始，Tick为下一条记录的Tick */
+		CHECK_EQ(pos % LOGGER_WRITE_SIZE, 0U);
+		CHECK_EQ(data[pos], LOGGER_SYNC);
+		CHECK_EQ(data[pos + 1U], LOGGER_TYPE_INDEX);
+		CHECK_EQ(Logger_Get32(&data[pos + LOGGER_HEADER_SIZE]), file);
+		CHECK_EQ(Logger_Get32(&data[pos + LOGGER_HEADER_SIZE + 4U]), pos / LOGGER_WRITE_SIZE);
+		CHECK_EQ(Logger_Get32(&data[pos + 4U]), Logger_Get32(&data[pos + LOGGER_HEADER_SIZE + LOGGER_INDEX_SIZE + 4U]));
+		if(data[pos] != LOGGER_SYNC)
+			return count;
+
+		end = pos + LOGGER_WRITE_SIZE;
+		if(end > limit)
+			end = limit;
+		pos += LOGGER_HEADER_SIZE + LOGGER_INDEX_SIZE;
+		while(pos < end)
+		{
+			if(data[pos] == 0U)
+			{
+				pos++;
+				continue;
+			}
+			if(data[pos] != LOGGER_SYNC)
+			{
+				CHECK(0);
+				return count;
+			}
+			size = LOGGER_HEADER_SIZE + ((uint32_t)data[pos + 2U] | ((uint32_t)data[pos + 3U] << 8));
+			CHECK(pos + size <= end);
+			CHECK_EQ(data[pos + 1U], LOGGER_TYPE_NMEA);
+
+			seq = Logger_Get32(&data[pos + LOGGER_HEADER_SIZE]);
+			tick = Logger_Get32(&data[pos + 4U]);
+			CHECK_EQ(seq, Expect);
+			CHECK_EQ(size, LOGGER_HEADER_SIZE + Length(seq));
+			CHECK(tick >= LastTick);
+			ok = 1U;
+			for(i = 4U; (i < size - LOGGER_HEADER_SIZE) && (pos + LOGGER_HEADER_SIZE + i < end); i++)
+			{
+				if(data[pos + LOGGER_HEADER_SIZE + i] != Pattern(seq, i))
+					ok = 0U;
+			}
+			CHECK(ok);
+
+			Expect = seq + 1U;
+			LastTick = tick;
+			count++;
+			pos += size;
+		}
+		pos = end;
+	}
+
+	return count;
+}
+
+static void CheckFile(uint32_t file, uint32_t max)
+{
+	char name[16];
+	const uint8_t *data;
+	uint32_t size = 0U;
+
+	Logger_Name(name, file);
+	data = RAM_File(name + strlen(SDPath), &size);
+	CHECK(data != NULL);
+	if(data == NULL)
+		return;
+	CHECK_EQ(size % LOGGER_SECTOR_SIZE, 0U);
+	CHECK(size <= max);
+	CHECK(Parse(data, size, file) > 0U);
+}
+
+/* 写入直到t=3000ms，之后把卡交出 */
+static uint8_t HookProduce(void)
+{
+	if(Now < 3000U)
+	{
+		Tick();
+		return 0U;
+	}
+	Logger_Release(1U);
+	return Logger_CardFree();
+}
+
+static void TestDrain(void)
+{
+	LOGGER_StatsTypeDef stats;
+	uint32_t size = 0U;
+	const uint8_t *data;
+
+	Start(4U * MB, 3U);
+	Run(HookProduce, 10000U);
+	Logger_GetStats(&stats);
+
+	CHECK_EQ(Logger_CardFree(), 1U);
+	CHECK_EQ(SDFatFS.fs_type, 0U);
+	CHECK_EQ(stats.Dropped, 0U);
+	CHECK_EQ(stats.Records, Seq);
+	CHECK_EQ(stats.QueueDepth, 0U);
+
+	/* 关闭时截掉预分配中未使用的部分 */
+	data = RAM_File("LOG00001.BIN", &size);
+	CHECK(data != NULL);
+	CHECK_EQ(size, stats.BytesWritten);
+	CHECK(size > 20U * LOGGER_WRITE_SIZE);
+	CHECK_EQ(Parse(data, size, 1U), Seq);
+	CHECK_EQ(Expect, Seq);
+	CHECK_EQ(RAM_Stats.Truncates, 1U);
+	CHECK_EQ(RAM_Stats.Opens, RAM_Stats.Closes);
+
+	/* 整块、扇区对齐写入，同步之外每块只写一次 */
+	CHECK_EQ(RAM_Stats.Unaligned, 0U);
+	CHECK_EQ(RAM_Stats.Overruns, 0U);
+	CHECK(RAM_Stats.Writes <= size / LOGGER_WRITE_SIZE + 2U * RAM_Stats.Syncs + 2U);
+}
+
+static uint32_t SyncAt;
+
+/* 第一次同步后停止 */
+static uint8_t HookSync(void)
+{
+	if(Now == 5U)
+		Tick();
+	else
+		Answer();
+	if(RAM_Stats.Syncs != 0U)
+	{
+		SyncAt = Now;
+		return 1U;
+	}
+	return 0U;
+}
+
+/* 写入一条记录，生产者不应答，第二次同步后停止 */
+static uint8_t HookNoAck(void)
+{
+	if(Now == SyncAt + 1U)
+		Produce();
+	return (uint8_t)(RAM_Stats.Syncs >= 2U);
+}
+
+static uint8_t HookRelease(void)
+{
+	Logger_Release(1U);
+	return Logger_CardFree();
+}
+
+static void TestSync(void)
+{
+	uint32_t size = 0U, pos;
+	const uint8_t *data;
+
+	Start(4U * MB, 2U);
+	Run(HookSync, 5000U);
+
+	/* 同步前等生产者交出暂存的记录，同步后写入位置在扇区边界 */
+	CHECK(SyncAt >= LOGGER_SYNC_MS);
+	CHECK(SyncAt <= LOGGER_SYNC_MS + 2U);
+	CHECK_EQ(Seq, 3U);
+	pos = (uint32_t)f_tell(&Logger_File);
+	CHECK_EQ(pos, LOGGER_SECTOR_SIZE);
+	data = RAM_File("LOG00001.BIN", &size);
+	CHECK_EQ(size, 4U * MB);
+	CHECK_EQ(Parse(data, pos, 1U), 3U);
+	CHECK_EQ(data[pos], 0xFFU);
+
+	/* 生产者不应答时等待LOGGER_FLUSH_WAIT_MS后同步 */
+	Ack = 0U;
+	Run(HookNoAck, 5000U);
+	CHECK(Now - SyncAt >= LOGGER_SYNC_MS + LOGGER_FLUSH_WAIT_MS);
+	CHECK(Now - SyncAt <= LOGGER_SYNC_MS + LOGGER_FLUSH_WAIT_MS + 2U);
+	CHECK_EQ(RAM_Stats.Syncs, 2U);
+
+	/* 同步后的记录从扇区边界接着写在同一块中，没有新的INDEX */
+	Tick();
+	Run(HookRelease, 1000U);
+	data = RAM_File("LOG00001.BIN", &size);
+	CHECK_EQ(Seq, 6U);
+	CHECK_EQ(size, 3U * LOGGER_SECTOR_SIZE);
+	Expect = 0U;
+	LastTick = 0U;
+	CHECK_EQ(Parse(data, size, 1U), Seq);
+}
+
+/* 写满两个文件后把卡交出 */
+static uint8_t HookRotate(void)
+{
+	if(Logger_Stats.FileIndex < 3U)
+	{
+		Tick();
+		return 0U;
+	}
+	Logger_Release(1U);
+	return Logger_CardFree();
+}
+
+static void TestExpand(void)
+{
+	LOGGER_StatsTypeDef stats;
+	uint32_t i;
+
+	/* 连续空间不足1MB：逐次减半直到LOGGER_FILE_SIZE_MIN，都失败时不预分配 */
+	Start(MB / 2U, 10U);
+	Run(HookRotate, 60000U);
+	CHECK_EQ(RAM_Stats.ExpandSize[0], LOGGER_FILE_SIZE);
+	for(i = 1U; i < 7U; i++)
+		CHECK_EQ(RAM_Stats.ExpandSize[i], RAM_Stats.ExpandSize[i - 1U] / 2U);
+	CHECK_EQ(RAM_Stats.ExpandSize[6], LOGGER_FILE_SIZE_MIN);
+	CHECK_EQ(RAM_Stats.Expands, 3U * 7U);
+	CHECK_EQ(RAM_Stats.FastSeeks, 0U);
+	CHECK_EQ(Logger_FileSize, LOGGER_FILE_SIZE_MIN);
+
+	/* 不预分配时按最小大小切换，记录在文件之间连续 */
+	CheckFile(1U, LOGGER_FILE_SIZE_MIN);
+	CheckFile(2U, LOGGER_FILE_SIZE_MIN);
+	CheckFile(3U, LOGGER_FILE_SIZE_MIN);
+	CHECK_EQ(Expect, Seq);
+	Logger_GetStats(&stats);
+	CHECK_EQ(stats.Dropped, 0U);
+	CHECK_EQ(stats.Files, 3U);
+	CHECK_EQ(RAM_Stats.Truncates, 3U);
+
+	/* 恰好有1MB连续空间：最后一次成功，开启快速定位，写入不超出预分配 */
+	Start(MB, 10U);
+	Run(HookRotate, 60000U);
+	CHECK_EQ(RAM_Stats.Expands, 3U * 7U);
+	CHECK_EQ(RAM_Stats.FastSeeks, 3U);
+	CHECK_EQ(RAM_Stats.Overruns, 0U);
+	CheckFile(1U, LOGGER_FILE_SIZE_MIN);
+	CheckFile(2U, LOGGER_FILE_SIZE_MIN);
+	CheckFile(3U, LOGGER_FILE_SIZE_MIN);
+	CHECK_EQ(Expect, Seq);
+
+	/* 8MB连续空间：第四次请求成功 */
+	Start(8U * MB, 1U);
+	Run(HookRelease, 1000U);
+	CHECK_EQ(RAM_Stats.Expands, 4U);
+	CHECK_EQ(RAM_Stats.ExpandSize[3], 8U * MB);
+	CHECK_EQ(Logger_FileSize, 8U * MB);
+}
+
+static uint32_t Until;
+
+/* 持续写入直到Until */
+static uint8_t HookWait(void)
+{
+	Tick();
+	return (uint8_t)(Now >= Until);
+}
+
+/* 持续写入直到重新挂载并打开文件 */
+static uint8_t HookRemount(void)
+{
+	Tick();
+	return (uint8_t)(Logger_State == LOGGER_STATE_OPEN);
+}
+
+static void TestRelease(void)
+{
+	LOGGER_StatsTypeDef stats;
+
+	Start(4U * MB, 1U);
+	Until = 100U;
+	Run(HookWait, 1000U);
+
+	/* 记录任务持有卡时MSC不能访问 */
+	CHECK(SDFatFS.fs_type != 0U);
+	CHECK_EQ(Logger_CardFree(), 0U);
+	CHECK_EQ(Logger_CardBegin(), 1U);
+
+	/* 交出：关闭文件并卸载 */
+	Logger_Release(1U);
+	Run(HookRelease, 1000U);
+	CHECK_EQ(Logger_CardFree(), 1U);
+	CHECK_EQ(SDFatFS.fs_type, 0U);
+	CHECK_EQ(RAM_Stats.Truncates, 1U);
+	CHECK_EQ(RAM_Stats.Opens, RAM_Stats.Closes);
+
+	/* MSC正在访问时收回请求要等访问结束 */
+	CHECK_EQ(Logger_CardBegin(), 0U);
+	Logger_Release(0U);
+	Until = Now + 50U;
+	Run(HookWait, 1000U);
+	CHECK_EQ(Logger_CardFree(), 1U);
+	CHECK_EQ(SDFatFS.fs_type, 0U);
+	CHECK_EQ(RAM_Stats.Mounts, 1U);
+
+	Logger_CardEnd();
+	Run(HookRemount, 1000U);
+	CHECK_EQ(Logger_CardFree(), 0U);
+	CHECK_EQ(Logger_CardBegin(), 1U);
+	CHECK_EQ(RAM_Stats.Mounts, 2U);
+	CHECK_EQ(Logger_Stats.FileIndex, 2U);
+
+	/* 交出期间的记录留在队列中，重新挂载后写入下一个文件 */
+	Run(HookRelease, 1000U);
+	CheckFile(1U, 4U * MB);
+	CheckFile(2U, 4U * MB);
+	CHECK_EQ(Expect, Seq);
+	Logger_GetStats(&stats);
+	CHECK_EQ(stats.Dropped, 0U);
+}
+
+int main(void)
+{
+	TestDrain();
+	TestSync();
+	TestExpand();
+	TestRelease();
+
+	RAM_Reset(0U);
+	return TEST_RESULT("test_logger");
+}
@@ -0,0 +1,447 @@
+/**
+  ******************************************************************************
+  * @file    test_logger_query.c
+  * @brief   logger.c区间查询的主机端测试，SD卡由fatfs_ram.c代替
+  *           - 按Tick区间过滤，结果按序、不含INDEX记录，END中的记录数正确
+  *           - 借助INDEX二分定位起始块，读取量与结果大小相当，与文件大小无关
+  *           - 查询当前文件先同步，能读到还在写缓冲中的记录
+  *           - 文件不存在、卡已交给MSC时返回NO_FILE，读取出错返回ERROR
+  *           - 输出阻塞时中止查询返回ABORTED，新命令先中止进行中的查询
+  *           - 格式错误或上一条命令未处理完时拒绝命令
+  ******************************************************************************
+  */
+
+#include <setjmp.h>
+#include <string.h>
+#include "test.h"
+
+/* 直接包含源文件，与写入路径测试使用同样的驱动方式 */
+#include "../Src/logger.c"
+
+#define MB					(1024UL * 1024UL)
+#define RECORDS_MAX			16000U
+#define NO_LIMIT			0xFFFFFFFFUL
+
+static uint32_t Now;
+static jmp_buf Stop;
+static uint8_t (*Hook)(void);
+static uint32_t Deadline;
+
+/* 生产者 */
+static uint32_t Seq;
+static uint32_t TickOf[RECORDS_MAX];
+static uint8_t Producing;
+
+/* 查询输出 */
+static uint32_t OutLimit;			/**< 接受的记录数上限，之后输出返回空间不足 */
+static uint32_t OutRecords;
+static uint32_t OutFirst;			/**< 第一条记录的序号 */
+static uint32_t OutLast;
+static uint32_t OutMinTick;
+static uint32_t OutMaxTick;
+static uint32_t OutErrors;			/**< 不连续、类型或长度错误的记录 */
+static uint8_t Ended;
+static uint8_t EndStatus;
+static uint32_t EndRecords;
+
+uint32_t osKernelGetTickCount(void)
+{
+	return Now;
+}
+
+osStatus_t osDelay(uint32_t ticks)
+{
+	Now += ticks;
+	if((Hook() != 0U) || (Now >= Deadline))
+		longjmp(Stop, 1);
+	return osOK;
+}
+
+void Error_Handler(void)
+{
+	CHECK(0);
+}
+
+void DLOG_Write(uint32_t id, const uint32_t *args, uint32_t argc)
+{
+}
+
+static void Run(uint8_t (*hook)(void), uint32_t ms)
+{
+	Hook = hook;
+	Deadline = Now + ms;
+	if(setjmp(Stop) == 0)
+		Logger_Task();
+}
+
+static uint16_t Length(uint32_t seq)
+{
+	return (uint16_t)(4U + (seq * 37U) % 300U);
+}
+
+/**
+  * @brief  Produce 每ms写入两条记录，负载以序号开头
+  */
+static void Produce(void)
+{
+	uint8_t buf[304];
+	uint32_t n;
+
+	memset(buf, 0x5A, sizeof(buf));
+	for(n = 0U; (n < 2U) && (Seq < RECORDS_MAX); n++)
+	{
+		Logger_Set32(buf, Seq);
+		TickOf[Seq] = Now;
+		CHECK_EQ(Logger_Write(LOGGER_TYPE_NMEA, buf, Length(Seq)), 0U);
+		Seq++;
+	}
+	Logger_FlushDone(Logger_FlushRequest());
+}
+
+/**
+  * @brief  Output 查询结果的输出函数，每次送出一条记录
+  * @note   收到END后不再接受输出，直到OutReset，模拟主机逐个取走结果
+  */
+static uint8_t Output(const uint8_t *buf, uint32_t len)
+{
+	uint32_t seq, tick;
+
+	if((Ended != 0U) || ((buf[1] != LOGGER_TYPE_END) && (OutRecords >= OutLimit)))
+		return 1U;
+	if(len < LOGGER_HEADER_SIZE)
+	{
+		OutErrors++;
+		return 0U;
+	}
+
+	tick = Logger_Get32(&buf[4]);
+	if(buf[1] == LOGGER_TYPE_END)
+	{
+		if(len != LOGGER_HEADER_SIZE + LOGGER_END_SIZE)
+			OutErrors++;
+		Ended = 1U;
+		EndStatus = buf[LOGGER_HEADER_SIZE];
+		EndRecords = Logger_Get32(&buf[LOGGER_HEADER_SIZE + 4U]);
+		return 0U;
+	}
+
+	seq = Logger_Get32(&buf[LOGGER_HEADER_SIZE]);
+	if((buf[1] != LOGGER_TYPE_NMEA) || (len != LOGGER_HEADER_SIZE + Length(seq))
+		|| ((OutRecords != 0U) && (seq != OutLast + 1U)) || (tick != TickOf[seq]))
+		OutErrors++;
+	if(OutRecords == 0U)
+	{
+		OutFirst = seq;
+		OutMinTick = tick;
+	}
+	OutLast = seq;
+	OutMaxTick = tick;
+	OutRecords++;
+	return 0U;
+}
+
+static void OutReset(uint32_t limit)
+{
+	OutLimit = limit;
+	OutRecords = 0U;
+	OutErrors = 0U;
+	Ended = 0U;
+	EndStatus = 0xFFU;
+	EndRecords = 0U;
+}
+
+static uint8_t Query(uint32_t file, uint32_t start, uint32_t stop)
+{
+	uint8_t cmd[LOGGER_CMD_SIZE];
+
+	cmd[0] = LOGGER_OP_QUERY;
+	Logger_Set32(&cmd[1], file);
+	Logger_Set32(&cmd[5], start);
+	Logger_Set32(&cmd[9], stop);
+	return Logger_Command(cmd, sizeof(cmd));
+}
+
+static uint8_t HookProduce(void)
+{
+	if(Producing != 0U)
+		Produce();
+	return 0U;
+}
+
+static uint8_t HookEnd(void)
+{
+	if(Producing != 0U)
+		Produce();
+	return Ended;
+}
+
+static uint8_t HookRelease(void)
+{
+	Logger_Release(1U);
+	return Logger_CardFree();
+}
+
+static uint8_t HookOpen(void)
+{
+	if(Producing != 0U)
+		Produce();
+	return (uint8_t)(Logger_State == LOGGER_STATE_OPEN);
+}
+
+/**
+  * @brief  Expected 序号区间内Tick在[start, stop]中的记录数
+  */
+static uint32_t Expected(uint32_t first, uint32_t last, uint32_t start, uint32_t stop, uint32_t *from)
+{
+	uint32_t seq, count = 0U;
+
+	for(seq = first; seq < last; seq++)
+	{
+		if((TickOf[seq] >= start) && (TickOf[seq] <= stop))
+		{
+			if(count == 0U)
+				*from = seq;
+			count++;
+		}
+	}
+	return count;
+}
+
+/* LOG00001写4s后切换到LOG00002，之后的查询在LOG00002记录期间进行 */
+static uint32_t File1Records;
+
+static void Setup(void)
+{
+	RAM_Reset(4U * MB);
+	Logger_Init(Output);
+	Now = 0U;
+	Seq = 0U;
+	Producing = 1U;
+	OutReset(NO_LIMIT);
+
+	Run(HookProduce, 4000U);
+	Run(HookRelease, 1000U);
+	File1Records = Seq;
+	Logger_Release(0U);
+	Run(HookOpen, 1000U);
+	CHECK_EQ(Logger_Stats.FileIndex, 2U);
+	Run(HookProduce, 100U);
+}
+
+static void TestFilter(void)
+{
+	uint32_t from = 0U, count, reads, size = 0U, result;
+
+	/* 已关闭的文件：结果恰为区间内的记录，按序，不含INDEX */
+	OutReset(NO_LIMIT);
+	count = Expected(0U, File1Records, 1000U, 1999U, &from);
+	CHECK(count > 1000U);
+	reads = RAM_Stats.ReadBytes;
+	CHECK_EQ(Query(1U, 1000U, 1999U), 0U);
+	Run(HookEnd, 1000U);
+	CHECK_EQ(Ended, 1U);
+	CHECK_EQ(EndStatus, LOGGER_QUERY_OK);
+	CHECK_EQ(EndRecords, count);
+	CHECK_EQ(OutRecords, count);
+	CHECK_EQ(OutFirst, from);
+	CHECK_EQ(OutLast, from + count - 1U);
+	CHECK(OutMinTick >= 1000U);
+	CHECK(OutMaxTick <= 1999U);
+	CHECK_EQ(OutErrors, 0U);
+
+	/* 读取量：起始块的前半部分、结果、结束处的一个读缓冲与二分查找的INDEX */
+	RAM_File("LOG00001.BIN", &size);
+	result = count * (LOGGER_HEADER_SIZE + 154U);
+	reads = RAM_Stats.ReadBytes - reads;
+	CHECK(reads <= result + result / 4U + LOGGER_WRITE_SIZE + LOGGER_QUERY_BUF_SIZE);
+	CHECK(reads < size / 2U);
+
+	/* 单个时间点：只读起始块附近，与文件大小无关 */
+	OutReset(NO_LIMIT);
+	count = Expected(0U, File1Records, 3000U, 3000U, &from);
+	CHECK_EQ(count, 2U);
+	reads = RAM_Stats.ReadBytes;
+	CHECK_EQ(Query(1U, 3000U, 3000U), 0U);
+	Run(HookEnd, 1000U);
+	reads = RAM_Stats.ReadBytes - reads;
+	CHECK_EQ(EndStatus, LOGGER_QUERY_OK);
+	CHECK_EQ(EndRecords, 2U);
+	CHECK_EQ(OutFirst, from);
+	CHECK_EQ(OutErrors, 0U);
+	CHECK(reads <= LOGGER_WRITE_SIZE + 2U * LOGGER_QUERY_BUF_SIZE);
+	CHECK(reads * 16U < size);
+
+	/* 区间在文件开始之前与结束之后 */
+	OutReset(NO_LIMIT);
+	CHECK_EQ(Query(1U, 0U, 0U), 0U);
+	Run(HookEnd, 1000U);
+	CHECK_EQ(EndStatus, LOGGER_QUERY_OK);
+	CHECK_EQ(EndRecords, 0U);
+	OutReset(NO_LIMIT);
+	CHECK_EQ(Query(1U, 100000U, 200000U), 0U);
+	Run(HookEnd, 1000U);
+	CHECK_EQ(EndStatus, LOGGER_QUERY_OK);
+	CHECK_EQ(EndRecords, 0U);
+	CHECK_EQ(OutErrors, 0U);
+
+	/* 整个文件 */
+	OutReset(NO_LIMIT);
+	CHECK_EQ(Query(1U, 0U, 0xFFFFFFFFUL), 0U);
+	Run(HookEnd, 5000U);
+	CHECK_EQ(EndStatus, LOGGER_QUERY_OK);
+	CHECK_EQ(EndRecords, File1Records);
+	CHECK_EQ(OutFirst, 0U);
+	CHECK_EQ(OutErrors, 0U);
+}
+
+static void TestCurrent(void)
+{
+	uint32_t from = 0U, count, last;
+
+	/* 当前文件：先同步，还在写缓冲中的记录也能查到 */
+	Producing = 0U;
+	Run(HookProduce, 5U);
+	CHECK(Logger_Fill != 0U);
+	last = Seq;
+	OutReset(NO_LIMIT);
+	count = Expected(File1Records, last, 0U, 0xFFFFFFFFUL, &from);
+	CHECK(count > 0U);
+	CHECK_EQ(Query(0U, 0U, 0xFFFFFFFFUL), 0U);
+	Run(HookEnd, 1000U);
+	CHECK_EQ(EndStatus, LOGGER_QUERY_OK);
+	CHECK_EQ(EndRecords, count);
+	CHECK_EQ(OutFirst, File1Records);
+	CHECK_EQ(OutLast, last - 1U);
+	CHECK_EQ(OutErrors, 0U);
+
+	/* 以序号指定当前文件与文件序号0相同，查询期间继续记录 */
+	Producing = 1U;
+	OutReset(NO_LIMIT);
+	CHECK_EQ(Query(2U, TickOf[last - 1U], TickOf[last - 1U]), 0U);
+	Run(HookEnd, 1000U);
+	CHECK_EQ(EndStatus, LOGGER_QUERY_OK);
+	CHECK(EndRecords >= 1U);
+	CHECK_EQ(OutLast, last - 1U);
+	CHECK_EQ(OutErrors, 0U);
+}
+
+static void TestStatus(void)
+{
+	/* 文件不存在 */
+	OutReset(NO_LIMIT);
+	CHECK_EQ(Query(99U, 0U, 0xFFFFFFFFUL), 0U);
+	Run(HookEnd, 1000U);
+	CHECK_EQ(EndStatus, LOGGER_QUERY_NO_FILE);
+	CHECK_EQ(EndRecords, 0U);
+
+	/* 读取出错 */
+	OutReset(NO_LIMIT);
+	RAM_FailReads(1U);
+	CHECK_EQ(Query(1U, 0U, 0xFFFFFFFFUL), 0U);
+	Run(HookEnd, 1000U);
+	RAM_FailReads(0U);
+	CHECK_EQ(EndStatus, LOGGER_QUERY_ERROR);
+	CHECK_EQ(EndRecords, 0U);
+
+	/* 卡交给MSC后文件不可读 */
+	Run(HookRelease, 1000U);
+	OutReset(NO_LIMIT);
+	CHECK_EQ(Query(1U, 0U, 0xFFFFFFFFUL), 0U);
+	Run(HookEnd, 1000U);
+	CHECK_EQ(EndStatus, LOGGER_QUERY_NO_FILE);
+	OutReset(NO_LIMIT);
+	CHECK_EQ(Query(0U, 0U, 0xFFFFFFFFUL), 0U);
+	Run(HookEnd, 1000U);
+	CHECK_EQ(EndStatus, LOGGER_QUERY_NO_FILE);
+
+	/* 交出卡时进行中的查询结束，返回NO_FILE */
+	Logger_Release(0U);
+	Run(HookOpen, 1000U);
+	OutReset(10U);
+	CHECK_EQ(Query(1U, 0U, 0xFFFFFFFFUL), 0U);
+	Run(HookProduce, 20U);
+	CHECK_EQ(OutRecords, 10U);
+	CHECK_EQ(Ended, 0U);
+	OutLimit = NO_LIMIT;
+	Logger_Release(1U);
+	Run(HookEnd, 1000U);
+	CHECK_EQ(EndStatus, LOGGER_QUERY_NO_FILE);
+	Logger_Release(0U);
+	Run(HookOpen, 1000U);
+}
+
+static void TestAbort(void)
+{
+	uint8_t cmd[LOGGER_CMD_SIZE];
+
+	/* 输出阻塞时中止，END中的记录数为已送出的记录 */
+	OutReset(10U);
+	CHECK_EQ(Query(1U, 0U, 0xFFFFFFFFUL), 0U);
+	Run(HookProduce, 20U);
+	CHECK_EQ(OutRecords, 10U);
+	CHECK_EQ(Ended, 0U);
+	cmd[0] = LOGGER_OP_ABORT;
+	CHECK_EQ(Logger_Command(cmd, 1U), 0U);
+	Run(HookEnd, 1000U);
+	CHECK_EQ(EndStatus, LOGGER_QUERY_ABORTED);
+	CHECK_EQ(EndRecords, 10U);
+	CHECK_EQ(OutRecords, 10U);
+
+	/* 空闲时中止只清除命令，不送出END */
+	OutReset(NO_LIMIT);
+	CHECK_EQ(Logger_Command(cmd, 1U), 0U);
+	Run(HookProduce, 20U);
+	CHECK_EQ(Ended, 0U);
+	CHECK_EQ(Logger_CmdPending, 0U);
+
+	/* 新的查询先中止进行中的查询，再从头执行 */
+	OutReset(10U);
+	CHECK_EQ(Query(1U, 0U, 0xFFFFFFFFUL), 0U);
+	Run(HookProduce, 20U);
+	CHECK_EQ(Query(1U, 3000U, 3000U), 0U);
+	OutLimit = NO_LIMIT;
+	Run(HookEnd, 1000U);
+	CHECK_EQ(EndStatus, LOGGER_QUERY_ABORTED);
+	CHECK_EQ(EndRecords, 10U);
+	OutReset(NO_LIMIT);
+	Run(HookEnd, 1000U);
+	CHECK_EQ(EndStatus, LOGGER_QUERY_OK);
+	CHECK_EQ(EndRecords, 2U);
+	CHECK_EQ(OutMinTick, 3000U);
+}
+
+static void TestCommand(void)
+{
+	uint8_t cmd[LOGGER_CMD_SIZE];
+
+	memset(cmd, 0, sizeof(cmd));
+	cmd[0] = LOGGER_OP_QUERY;
+	CHECK_EQ(Logger_Command(cmd, 0U), 1U);
+	CHECK_EQ(Logger_Command(cmd, LOGGER_CMD_SIZE - 1U), 1U);
+	cmd[0] = 0x12U;
+	CHECK_EQ(Logger_Command(cmd, LOGGER_CMD_SIZE), 1U);
+
+	/* 上一条命令未处理时拒绝 */
+	CHECK_EQ(Query(99U, 0U, 0U), 0U);
+	CHECK_EQ(Query(99U, 0U, 0U), 1U);
+	OutReset(NO_LIMIT);
+	Run(HookEnd, 1000U);
+	CHECK_EQ(EndStatus, LOGGER_QUERY_NO_FILE);
+
+	/* 没有输出函数时不接受命令 */
+	Logger_Init(NULL);
+	CHECK_EQ(Query(1U, 0U, 0U), 1U);
+}
+
+int main(void)
+{
+	Setup();
+	TestFilter();
+	TestCurrent();
+	TestStatus();
+	TestAbort();
+	TestCommand();
+
+	RAM_Reset(0U);
+	return TEST_RESULT("test_logger_query");
+}
@@ -0,0 +1,187 @@
+/**
+  ******************************************************************************
+  * @file    test_nmea.c
+  * @brief   nmea.c流式解码器的主机端测试
+  *           - 四种语句的定点换算结果
+  *           - 任意位置分段输入与整段输入结果一致
+  *           - 校验错误、截断与'$'重同步
+  *           - 超长小数部分按9位截断，不越界
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "nmea.h"
+#include "test.h"
+
+#define SENTENCE_MAX		16U
+
+static const char Mixed[] =
+	"$GPGGA,123519.00,4807.038,N,01131.000,E,1,08,0.9,545.4,M,-46.9,M,,*44\r\n"
+	"$GPRMC,123519,A,4807.038,N,01131.000,W,022.4,084.4,230394,003.1,W*78\r\n"
+	"$GPGSV,3,1,10,04,55,226,28,07,21,318,42,08,80,217,18,09,43,285,43,0*6D\r\n"
+	"$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K,A*25\r\n";
+
+static NMEA_DecoderTypeDef Decoder;
+static NMEA_SentenceTypeDef Out[SENTENCE_MAX];
+static uint32_t OutCount;
+
+static void Collect(const NMEA_SentenceTypeDef *sentence)
+{
+	if(OutCount < SENTENCE_MAX)
+		Out[OutCount] = *sentence;
+	OutCount++;
+}
+
+static void Feed(const char *text, uint32_t step)
+{
+	uint32_t len = (uint32_t)strlen(text);
+	uint32_t i, n;
+
+	for(i = 0U; i < len; i += n)
+	{
+		n = (len - i < step) ? len - i : step;
+		(void)NMEA_Input(&Decoder, (const uint8_t *)&text[i], n);
+	}
+}
+
+/* 给"$...*"补上校验与行尾 */
+static void Seal(char *text)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	uint8_t sum = 0U;
+	char *p;
+
+	for(p = text + 1; *p != '*'; p++)
+		sum ^= (uint8_t)*p;
+	p[1] = hex[sum >> 4];
+	p[2] = hex[sum & 0x0FU];
+	p[3] = '\r';
+	p[4] = '\n';
+	p[5] = '\0';
+}
+
+static void Reset(void)
+{
+	NMEA_Init(&Decoder, Collect);
+	memset(Out, 0, sizeof(Out));
+	OutCount = 0U;
+}
+
+static void TestFields(void)
+{
+	Reset();
+	Feed(Mixed, sizeof(Mixed));
+	CHECK_EQ(OutCount, 4U);
+	CHECK_EQ(Decoder.Stats.Sentences, 4U);
+	CHECK_EQ(Decoder.Stats.ChecksumErrors, 0U);
+	CHECK_EQ(Decoder.Stats.FormatErrors, 0U);
+
+	CHECK_EQ(Out[0].Type, NMEA_TYPE_GGA);
+	CHECK(memcmp(Out[0].Talker, "GP", 2U) == 0);
+	CHECK_EQ(Out[0].Gga.Time, 45319000U);
+	CHECK_EQ(Out[0].Gga.Latitude, 481173000);
+	CHECK_EQ(Out[0].Gga.Longitude, 115166666);
+	CHECK_EQ(Out[0].Gga.Quality, 1U);
+	CHECK_EQ(Out[0].Gga.Satellites, 8U);
+	CHECK_EQ(Out[0].Gga.Hdop, 90U);
+	CHECK_EQ(Out[0].Gga.Altitude, 545400);
+	CHECK_EQ(Out[0].Gga.GeoidSep, -46900);
+
+	CHECK_EQ(Out[1].Type, NMEA_TYPE_RMC);
+	CHECK_EQ(Out[1].Rmc.Valid, 1U);
+	CHECK_EQ(Out[1].Rmc.Day, 23U);
+	CHECK_EQ(Out[1].Rmc.Month, 3U);
+	CHECK_EQ(Out[1].Rmc.Year, 94U);
+	CHECK_EQ(Out[1].Rmc.Longitude, -115166666);
+	CHECK_EQ(Out[1].Rmc.Speed, 22400U);
+	CHECK_EQ(Out[1].Rmc.Course, 8440U);
+
+	CHECK_EQ(Out[2].Type, NMEA_TYPE_GSV);
+	CHECK_EQ(Out[2].Gsv.Total, 3U);
+	CHECK_EQ(Out[2].Gsv.Index, 1U);
+	CHECK_EQ(Out[2].Gsv.InView, 10U);
+	CHECK_EQ(Out[2].Gsv.Count, 4U);
+	CHECK_EQ(Out[2].Gsv.Sat[3].Prn, 9U);
+	CHECK_EQ(Out[2].Gsv.Sat[3].Azimuth, 285U);
+	CHECK_EQ(Out[2].Gsv.Sat[3].Snr, 43U);
+
+	CHECK_EQ(Out[3].Type, NMEA_TYPE_VTG);
+	CHECK_EQ(Out[3].Vtg.Course, 5470U);
+	CHECK_EQ(Out[3].Vtg.Speed, 5500U);
+	CHECK_EQ(Out[3].Vtg.SpeedKmh, 10200U);
+	CHECK_EQ(Out[3].Vtg.Mode, 'A');
+}
+
+static void TestSplit(void)
+{
+	NMEA_SentenceTypeDef whole[4];
+	uint32_t step;
+
+	Reset();
+	Feed(Mixed, sizeof(Mixed));
+	memcpy(whole, Out, sizeof(whole));
+
+	for(step = 1U; step < 80U; step++)
+	{
+		Reset();
+		Feed(Mixed, step);
+		CHECK_EQ(OutCount, 4U);
+		CHECK(memcmp(whole, Out, sizeof(whole)) == 0);
+	}
+}
+
+static void TestErrors(void)
+{
+	Reset();
+
+	/* 校验错误不调用回调 */
+	Feed("$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K,A*26\r\n", 64U);
+	CHECK_EQ(OutCount, 0U);
+	CHECK_EQ(Decoder.Stats.ChecksumErrors, 1U);
+
+	/* 语句中途出现'$'，丢弃前一条并从此处重新同步 */
+	Feed("$GPGGA,1235", 64U);
+	Feed(Mixed, 64U);
+	CHECK_EQ(OutCount, 4U);
+	CHECK_EQ(Decoder.Stats.FormatErrors, 1U);
+
+	/* 非法字符 */
+	Feed("$GPVTG,054.7,T\x01,034.4*00\r\n", 64U);
+	CHECK_EQ(OutCount, 4U);
+	CHECK_EQ(Decoder.Stats.FormatErrors, 2U);
+}
+
+static void TestLongFraction(void)
+{
+	char text[NMEA_MAX_LENGTH + 8U];
+
+	/* 小数部分远超NMEA_Pow10的范围，多余的位舍去 */
+	Reset();
+	strcpy(text, "$GPGGA,123519.000000000000000,4807.0380000000000000,N,01131.000,E,1,08,0.9,"
+	             "545.49999999999999,M,-46.9,M,,*");
+	Seal(text);
+	Feed(text, sizeof(text));
+	CHECK_EQ(OutCount, 1U);
+	CHECK_EQ(Out[0].Gga.Time, 45319000U);
+	CHECK_EQ(Out[0].Gga.Latitude, 481173000);
+	CHECK_EQ(Out[0].Gga.Altitude, 545499);
+
+	/* 全为0的小数部分不会因数值未增长而无限累计位数 */
+	Reset();
+	strcpy(text, "$GPVTG,0.00000000000000000000000000000000000000000000,T,,M,005.5,N,010.2,K,A*");
+	Seal(text);
+	Feed(text, 7U);
+	CHECK_EQ(OutCount, 1U);
+	CHECK_EQ(Out[0].Vtg.Course, 0U);
+	CHECK_EQ(Out[0].Vtg.Speed, 5500U);
+}
+
+int main(void)
+{
+	TestFields();
+	TestSplit();
+	TestErrors();
+	TestLongFraction();
+
+	return TEST_RESULT("test_nmea");
+}
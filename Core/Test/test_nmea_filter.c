@@ -0,0 +1,277 @@
+/**
+  ******************************************************************************
+  * @file    test_nmea_filter.c
+  * @brief   nmea_filter.c的主机端测试，配置命令按USB中断中的方式下发
+  *           - 命令排队，在下一条语句过滤前才应用
+  *           - 精确规则优先于通配规则，无规则匹配时执行默认动作
+  *           - 抽取与仅在变化时转发，计数与转发结果一致
+  *           - 删除、清空与计数清零，规则表满时拒绝新规则
+  *           - 格式错误与队列满的命令被拒绝
+  *           - 应答内容与所选规则一致，超出应答长度的部分填0
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "nmea_filter.h"
+#include "test.h"
+
+#define RESPONSE_BUF		64U
+
+static const uint8_t Gga[] = "$GPGGA,123519.00,4807.038,N,01131.000,E,1,08,0.9,545.4,M,-46.9,M,,*44\r\n";
+static const uint8_t GgaMoved[] = "$GPGGA,123520.00,4807.038,N,01131.000,E,1,08,0.9,545.4,M,-46.9,M,,*4E\r\n";
+static const uint8_t Rmc[] = "$GPRMC,123519,A,4807.038,N,01131.000,W,022.4,084.4,230394,003.1,W*78\r\n";
+static const uint8_t GnRmc[] = "$GNRMC,123519,A,4807.038,N,01131.000,W,022.4,084.4,230394,003.1,W*66\r\n";
+static const uint8_t Gsv[] = "$GPGSV,3,1,10,04,55,226,28,07,21,318,42,08,80,217,18,09,43,285,43,0*6D\r\n";
+
+static uint8_t Check(const uint8_t *frame, uint32_t size)
+{
+	return NMEA_Filter_Check(frame, size - 1U);
+}
+
+#define PASS(s)				Check((s), sizeof(s))
+
+/* 组一条配置命令并按USB中断的方式下发 */
+static uint8_t Set(const char *talker, const char *type, uint8_t action, uint8_t flags, uint16_t decimate)
+{
+	uint8_t cmd[10];
+
+	cmd[0] = NMEA_FILTER_OP_SET;
+	memcpy(&cmd[1], talker, 2U);
+	memcpy(&cmd[3], type, 3U);
+	cmd[6] = action;
+	cmd[7] = flags;
+	cmd[8] = (uint8_t)decimate;
+	cmd[9] = (uint8_t)(decimate >> 8);
+	return NMEA_Filter_Command(cmd, sizeof(cmd));
+}
+
+static uint8_t Delete(const char *talker, const char *type)
+{
+	uint8_t cmd[6];
+
+	cmd[0] = NMEA_FILTER_OP_DELETE;
+	memcpy(&cmd[1], talker, 2U);
+	memcpy(&cmd[3], type, 3U);
+	return NMEA_Filter_Command(cmd, sizeof(cmd));
+}
+
+static uint8_t Op(uint8_t op, uint8_t arg)
+{
+	uint8_t cmd[7] = {0};
+
+	cmd[0] = op;
+	cmd[1] = arg;
+	cmd[6] = arg;
+	return NMEA_Filter_Command(cmd, sizeof(cmd));
+}
+
+static uint32_t Read32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void TestQueued(void)
+{
+	NMEA_Filter_Init();
+	CHECK_EQ(PASS(Gga), 1U);
+
+	/* 命令在中断中只排队，过滤下一条语句时才生效 */
+	CHECK_EQ(Set("GP", "GGA", NMEA_FILTER_DENY, 0U, 0U), 0U);
+	CHECK_EQ(PASS(Gga), 0U);
+	CHECK_EQ(PASS(Rmc), 1U);
+
+	/* 过短的语句直接丢弃 */
+	CHECK_EQ(NMEA_Filter_Check((const uint8_t *)"$GPG", 4U), 0U);
+}
+
+static void TestMatch(void)
+{
+	NMEA_FilterCountTypeDef count;
+
+	NMEA_Filter_Init();
+	/* (任意, RMC)拒绝，(GN, RMC)允许，其余默认拒绝，(GP, 任意)允许 */
+	CHECK_EQ(Set("**", "RMC", NMEA_FILTER_DENY, 0U, 0U), 0U);
+	CHECK_EQ(Set("GN", "RMC", NMEA_FILTER_ALLOW, 0U, 0U), 0U);
+	CHECK_EQ(Op(NMEA_FILTER_OP_DEFAULT, NMEA_FILTER_DENY), 0U);
+	CHECK_EQ(PASS(GnRmc), 1U);
+	CHECK_EQ(PASS(Rmc), 0U);
+	CHECK_EQ(PASS(Gsv), 0U);
+
+	CHECK_EQ(Set("GP", "***", NMEA_FILTER_ALLOW, 0U, 0U), 0U);
+	CHECK_EQ(PASS(Gsv), 1U);
+	CHECK_EQ(PASS(Rmc), 0U);		/* (任意, 类型)先于(发送者, 任意) */
+
+	/* (任意, 任意)覆盖默认动作 */
+	CHECK_EQ(Set("**", "***", NMEA_FILTER_ALLOW, 0U, 0U), 0U);
+	CHECK_EQ(NMEA_Filter_Check((const uint8_t *)"$BDGSA,A,3*00\r\n", 15U), 1U);
+
+	NMEA_Filter_GetCount(&count);
+	CHECK_EQ(count.Passed, 3U);
+	CHECK_EQ(count.Denied, 3U);
+}
+
+static void TestDecimate(void)
+{
+	NMEA_FilterCountTypeDef count;
+	uint32_t i, passed = 0U;
+
+	NMEA_Filter_Init();
+	CHECK_EQ(Set("GP", "GSV", NMEA_FILTER_ALLOW, 0U, 5U), 0U);
+	for(i = 0U; i < 20U; i++)
+		passed += PASS(Gsv);
+	CHECK_EQ(passed, 4U);
+
+	/* 仅在变化时转发：内容不变的语句被丢弃 */
+	CHECK_EQ(Set("GP", "GGA", NMEA_FILTER_ALLOW, NMEA_FILTER_FLAG_ON_CHANGE, 0U), 0U);
+	CHECK_EQ(PASS(Gga), 1U);
+	CHECK_EQ(PASS(Gga), 0U);
+	CHECK_EQ(PASS(GgaMoved), 1U);
+	CHECK_EQ(PASS(GgaMoved), 0U);
+	CHECK_EQ(PASS(Gga), 1U);
+
+	/* 修改规则后抽取相位与上一条内容重新开始 */
+	CHECK_EQ(Set("GP", "GGA", NMEA_FILTER_ALLOW, NMEA_FILTER_FLAG_ON_CHANGE, 0U), 0U);
+	CHECK_EQ(PASS(Gga), 1U);
+
+	NMEA_Filter_GetCount(&count);
+	CHECK_EQ(count.Passed, 8U);
+	CHECK_EQ(count.Decimated, 16U);
+	CHECK_EQ(count.Unchanged, 2U);
+}
+
+static void TestDelete(void)
+{
+	NMEA_FilterCountTypeDef count;
+	NMEA_FilterRuleTypeDef rule;
+	char type[4];
+	uint32_t i;
+
+	NMEA_Filter_Init();
+	CHECK_EQ(Set("GP", "GGA", NMEA_FILTER_DENY, 0U, 0U), 0U);
+	CHECK_EQ(Set("GP", "RMC", NMEA_FILTER_DENY, 0U, 0U), 0U);
+	CHECK_EQ(PASS(Gga), 0U);
+	CHECK_EQ(PASS(Rmc), 0U);
+
+	/* 删除第一条规则，最后一条规则移入空位后仍能找到 */
+	CHECK_EQ(Delete("GP", "GGA"), 0U);
+	CHECK_EQ(PASS(Gga), 1U);
+	CHECK_EQ(PASS(Rmc), 0U);
+	CHECK_EQ(NMEA_Filter_DeleteRule("GP", "GGA"), 1U);
+
+	CHECK_EQ(Op(NMEA_FILTER_OP_RESET, 0U), 0U);
+	CHECK_EQ(PASS(Gsv), 1U);
+	NMEA_Filter_GetCount(&count);
+	CHECK_EQ(count.Passed, 1U);
+	CHECK_EQ(count.Denied, 0U);
+
+	CHECK_EQ(Op(NMEA_FILTER_OP_CLEAR, 0U), 0U);
+	CHECK_EQ(PASS(Rmc), 1U);
+
+	/* 规则表满 */
+	memcpy(rule.Talker, "GP", 2U);
+	rule.Action = NMEA_FILTER_DENY;
+	rule.Flags = 0U;
+	rule.Decimate = 0U;
+	for(i = 0U; i < NMEA_FILTER_RULE_MAX; i++)
+	{
+		type[0] = 'A';
+		type[1] = (char)('A' + i);
+		type[2] = 'Z';
+		memcpy(rule.Type, type, 3U);
+		CHECK_EQ(NMEA_Filter_SetRule(&rule), 0U);
+	}
+	memcpy(rule.Type, "GGA", 3U);
+	CHECK_EQ(NMEA_Filter_SetRule(&rule), 1U);
+	CHECK_EQ(PASS(Gga), 1U);
+	/* 已有的规则仍可修改 */
+	memcpy(rule.Type, "AAZ", 3U);
+	rule.Action = NMEA_FILTER_ALLOW;
+	CHECK_EQ(NMEA_Filter_SetRule(&rule), 0U);
+}
+
+static void TestRejected(void)
+{
+	uint32_t i;
+
+	NMEA_Filter_Init();
+	CHECK_EQ(NMEA_Filter_Command((const uint8_t *)"", 0U), 1U);
+	CHECK_EQ(Op(0x00U, 0U), 1U);
+	CHECK_EQ(Op(NMEA_FILTER_OP_SELECT + 1U, 0U), 1U);
+	CHECK_EQ(NMEA_Filter_Command((const uint8_t *)"\x06", 1U), 1U);
+
+	/* 任务未运行时队列只能容纳NMEA_FILTER_CMD_QUEUE条命令 */
+	for(i = 0U; i < NMEA_FILTER_CMD_QUEUE; i++)
+		CHECK_EQ(Op(NMEA_FILTER_OP_RESET, 0U), 0U);
+	CHECK_EQ(Op(NMEA_FILTER_OP_RESET, 0U), 1U);
+	/* SELECT不排队 */
+	CHECK_EQ(Op(NMEA_FILTER_OP_SELECT, 0U), 0U);
+	(void)PASS(Gga);
+	CHECK_EQ(Op(NMEA_FILTER_OP_RESET, 0U), 0U);
+
+	/* 短命令的其余字段按0处理：SET只给出类型时发送者为0，不会匹配 */
+	CHECK_EQ(NMEA_Filter_Command((const uint8_t *)"\x01GPGGA", 6U), 0U);
+	CHECK_EQ(PASS(Gga), 1U);
+}
+
+static void TestResponse(void)
+{
+	uint8_t buf[RESPONSE_BUF];
+	uint32_t i;
+
+	NMEA_Filter_Init();
+	CHECK_EQ(Set("GP", "GSV", NMEA_FILTER_ALLOW, NMEA_FILTER_FLAG_ON_CHANGE, 0x0102U), 0U);
+	CHECK_EQ(Op(NMEA_FILTER_OP_DEFAULT, NMEA_FILTER_DENY), 0U);
+	CHECK_EQ(PASS(Gsv), 1U);
+	CHECK_EQ(PASS(Rmc), 0U);
+	CHECK_EQ(PASS(Gga), 0U);
+
+	/* 汇总：主机请求的长度大于应答，多出的部分为0 */
+	memset(buf, 0xCC, sizeof(buf));
+	NMEA_Filter_Response(buf, RESPONSE_BUF);
+	CHECK_EQ(buf[0], 1U);
+	CHECK_EQ(buf[1], NMEA_FILTER_SELECT_TOTAL);
+	CHECK_EQ(buf[2], NMEA_FILTER_DENY);
+	CHECK_EQ(Read32(&buf[4]), 1U);
+	CHECK_EQ(Read32(&buf[8]), 2U);
+	for(i = 20U; i < RESPONSE_BUF; i++)
+		CHECK_EQ(buf[i], 0U);
+
+	/* 所选规则 */
+	CHECK_EQ(Op(NMEA_FILTER_OP_SELECT, 0U), 0U);
+	memset(buf, 0xCC, sizeof(buf));
+	NMEA_Filter_Response(buf, RESPONSE_BUF);
+	CHECK_EQ(buf[1], 0U);
+	CHECK_EQ(Read32(&buf[4]), 1U);
+	CHECK_EQ(Read32(&buf[8]), 0U);
+	CHECK(memcmp(&buf[20], "GPGSV", 5U) == 0);
+	CHECK_EQ(buf[25], NMEA_FILTER_ALLOW);
+	CHECK_EQ(buf[26], NMEA_FILTER_FLAG_ON_CHANGE);
+	CHECK_EQ(buf[27], 0x02U);
+	CHECK_EQ(buf[28], 0x01U);
+	CHECK_EQ(buf[NMEA_FILTER_RESPONSE_SIZE], 0U);
+
+	/* 请求长度小于应答时只写请求的长度 */
+	memset(buf, 0xCC, sizeof(buf));
+	NMEA_Filter_Response(buf, 4U);
+	CHECK_EQ(buf[0], 1U);
+	CHECK_EQ(buf[4], 0xCCU);
+
+	/* 所选规则被删除后回到汇总 */
+	CHECK_EQ(Op(NMEA_FILTER_OP_CLEAR, 0U), 0U);
+	(void)PASS(Gga);
+	NMEA_Filter_Response(buf, RESPONSE_BUF);
+	CHECK_EQ(buf[0], 0U);
+	CHECK_EQ(buf[1], NMEA_FILTER_SELECT_TOTAL);
+}
+
+int main(void)
+{
+	TestQueued();
+	TestMatch();
+	TestDecimate();
+	TestDelete();
+	TestRejected();
+	TestResponse();
+
+	return TEST_RESULT("test_nmea_filter");
+}
@@ -0,0 +1,159 @@
+/**
+  ******************************************************************************
+  * @file    test_scan.c
+  * @brief   scan.c扫描内核的主机端测试
+  *           - 随机长度、随机对齐、几种字节分布下与逐字节实现的结果逐一比较
+  *           - 编译两次：默认为SWAR分支，定义__ARM_FEATURE_DSP并包含dsp_emu.h
+  *             时为DSP分支
+  ******************************************************************************
+  */
+
+#include <stdlib.h>
+#include <string.h>
+#include "scan.h"
+#include "test.h"
+
+#define BUFFER_SIZE			600U
+#define RANDOM_CASES		400000U
+
+/* 分隔符、同步字节与文本边界附近的字节 */
+static const uint8_t Special[] = {'$', '*', ',', '\r', '\n', 0xB5U, 0xD3U, 0x7FU, 0x1FU, 0x20U, 0x7EU, 0x80U, 0xFFU, 0x00U};
+static const uint8_t Targets[] = {'$', '*', '\n', 0xB5U, 0xD3U, 0x00U, 0xFFU};
+
+static uint8_t Buffer[BUFFER_SIZE];
+static unsigned int Mismatch;
+
+static uint32_t RefByte(const uint8_t *buf, uint32_t len, uint8_t c)
+{
+	uint32_t i;
+
+	for(i = 0U; (i < len) && (buf[i] != c); i++);
+	return i;
+}
+
+static uint32_t RefByte3(const uint8_t *buf, uint32_t len, uint8_t a, uint8_t b, uint8_t c)
+{
+	uint32_t i;
+
+	for(i = 0U; (i < len) && (buf[i] != a) && (buf[i] != b) && (buf[i] != c); i++);
+	return i;
+}
+
+static uint32_t RefText(const uint8_t *buf, uint32_t len, uint8_t stop)
+{
+	uint32_t i;
+
+	for(i = 0U; (i < len) && (buf[i] >= SCAN_TEXT_MIN) && (buf[i] <= SCAN_TEXT_MAX) && (buf[i] != stop); i++);
+	return i;
+}
+
+static uint8_t RefXor(const uint8_t *buf, uint32_t len)
+{
+	uint8_t sum = 0U;
+
+	while(len--)
+		sum ^= *buf++;
+	return sum;
+}
+
+static uint16_t RefFletcher(const uint8_t *buf, uint32_t len)
+{
+	uint8_t a = 0U, b = 0U;
+
+	while(len--)
+	{
+		a = (uint8_t)(a + *buf++);
+		b = (uint8_t)(b + a);
+	}
+	return (uint16_t)(a | (b << 8));
+}
+
+/* 只打印前几个不一致，避免刷屏 */
+static void Compare(const char *name, uint32_t got, uint32_t expected, uint32_t len)
+{
+	Test_Checks++;
+	if(got != expected)
+	{
+		Test_Failures++;
+		if(Mismatch++ < 10U)
+			printf("%s: len %u, got %u, expected %u\n", name, len, got, expected);
+	}
+}
+
+static void TestRandom(void)
+{
+	uint32_t i, n, len, mode;
+	uint8_t *buf, c;
+
+	srand(7);
+	for(i = 0U; i < RANDOM_CASES; i++)
+	{
+		len = (uint32_t)rand() % 300U;
+		buf = &Buffer[rand() % 8];
+		mode = (uint32_t)rand() % 4U;
+		for(n = 0U; n < len; n++)
+		{
+			switch(mode)
+			{
+				case 0U:
+					buf[n] = (uint8_t)rand();
+					break;
+				case 1U:
+					buf[n] = (uint8_t)(SCAN_TEXT_MIN + rand() % (SCAN_TEXT_MAX - SCAN_TEXT_MIN + 1));
+					break;
+				case 2U:
+					buf[n] = Special[rand() % sizeof(Special)];
+					break;
+				default:
+					/* 长段文本中偶尔夹杂任意字节 */
+					buf[n] = (rand() % 40 != 0) ? (uint8_t)('A' + rand() % 26) : (uint8_t)rand();
+					break;
+			}
+		}
+		c = (mode == 2U) ? Targets[rand() % sizeof(Targets)] : (uint8_t)rand();
+
+		Compare("SCAN_Byte", SCAN_Byte(buf, len, c), RefByte(buf, len, c), len);
+		Compare("SCAN_Byte3", SCAN_Byte3(buf, len, '$', 0xB5U, c), RefByte3(buf, len, '$', 0xB5U, c), len);
+		Compare("SCAN_Text", SCAN_Text(buf, len, c), RefText(buf, len, c), len);
+		Compare("SCAN_Xor", SCAN_Xor(buf, len), RefXor(buf, len), len);
+		Compare("SCAN_Fletcher", SCAN_Fletcher(buf, len), RefFletcher(buf, len), len);
+	}
+}
+
+static void TestEdges(void)
+{
+	/* 每个位置上的唯一匹配，覆盖字内4个字节与双字循环的两半 */
+	uint32_t i;
+
+	memset(Buffer, 'A', sizeof(Buffer));
+	for(i = 0U; i < 64U; i++)
+	{
+		Buffer[i] = '$';
+		CHECK_EQ(SCAN_Byte(Buffer, 64U, '$'), i);
+		CHECK_EQ(SCAN_Byte3(Buffer, 64U, 0xB5U, '$', 0xD3U), i);
+		CHECK_EQ(SCAN_Text(Buffer, 64U, '$'), i);
+		Buffer[i] = 0x80U;
+		CHECK_EQ(SCAN_Text(Buffer, 64U, '$'), i);
+		Buffer[i] = 'A';
+	}
+
+	/* 没有匹配时返回len，且不读len之外的字节 */
+	Buffer[64] = '$';
+	CHECK_EQ(SCAN_Byte(Buffer, 64U, '$'), 64U);
+	CHECK_EQ(SCAN_Text(Buffer, 64U, '$'), 64U);
+	CHECK_EQ(SCAN_Byte(Buffer, 0U, 'A'), 0U);
+	CHECK_EQ(SCAN_Xor(Buffer, 0U), 0U);
+	CHECK_EQ(SCAN_Fletcher(Buffer, 0U), 0U);
+}
+
+int main(void)
+{
+	TestEdges();
+	TestRandom();
+
+#if defined(__ARM_FEATURE_DSP)
+	return TEST_RESULT("test_scan_dsp");
+#else
+	return TEST_RESULT("test_scan");
+#endif
+}
@@ -28,24 +28,137 @@ extern "C" {
 #include "usbd_def.h"
 #include "usbd_ioreq.h"
 
+/* CDC实例数量(1 ~ 3)，每个实例占用两个接口与三个端点 */
+#define COM_CDC_INSTANCE_NUM							1U
+/* CDC-NCM网络功能，占用两个接口与端点4、5，不能与CDC1同时使用 */
+#define COM_NCM_ENABLED									0U
+/* 厂商自定义批量接口，占用一个接口与端点6，不能与CDC2同时使用；需同时打开USBD_CLASS_BOS_ENABLED */
+#define COM_VENDOR_ENABLED								0U
+/* 同步输入数据流，占用一个接口(两个备用设置)与端点8，为定速传感器数据预留每帧带宽；需同时打开USBD_CLASS_BOS_ENABLED */
+#define COM_ISO_ENABLED									0U
+/* 通用HID接口，占用一个接口与端点7，中断端点每1ms查询，用于低延迟的状态与命令报告；不能与CDC2同时使用 */
+#define COM_HID_ENABLED									0U
+/* SOF帧调度：每个USB帧(1ms)执行一次登记的任务，用于替代分帧定时器与定时刷新；
+   打开后每毫秒多一次USB中断，默认关闭，CDC0分包仍由TIM6结束 */
+#define COM_SOF_ENABLED									0U
+#define COM_SOF_TASK_NUM								4U			/**< 可登记的帧任务数量 */
+
+/* 运行模式，切换须经USBD_DeInit与USBD_Init重新枚举 */
+#define COM_MODE_COMPOSITE								0U			/**< 功能表中的全部功能 */
+#define COM_MODE_MSC_ONLY								1U			/**< 只有MSC，FIFO全部给MSC的输入端点 */
+
 #define COM_CDC_IN_EP									0x81U		/**< 端点1，输入 */
 #define COM_CDC_OUT_EP									0x01U		/**< 端点1，输出 */
 #define COM_CDC_CMD_EP									0x82U		/**< 端点2，中断控制端点*/
 #define COM_MSC_IN_EP									0x83U		/**< 端点3，输入 */
 #define COM_MSC_OUT_EP									0x03U		/**< 端点3，输出 */
+#define COM_CDC1_IN_EP									0x84U		/**< 端点4，CDC1输入 */
+#define COM_CDC1_OUT_EP									0x04U		/**< 端点4，CDC1输出 */
+#define COM_CDC1_CMD_EP									0x85U		/**< 端点5，CDC1中断控制端点 */
+#define COM_CDC2_IN_EP									0x86U		/**< 端点6，CDC2输入 */
+#define COM_CDC2_OUT_EP									0x06U		/**< 端点6，CDC2输出 */
+#define COM_CDC2_CMD_EP									0x87U		/**< 端点7，CDC2中断控制端点 */
+#define COM_NCM_IN_EP									0x84U		/**< 端点4，NCM输入 */
+#define COM_NCM_OUT_EP									0x04U		/**< 端点4，NCM输出 */
+#define COM_NCM_NOTIFY_EP								0x85U		/**< 端点5，NCM通知端点 */
+#define COM_VENDOR_IN_EP								0x86U		/**< 端点6，厂商接口输入 */
+#define COM_VENDOR_OUT_EP								0x06U		/**< 端点6，厂商接口输出 */
+#define COM_ISO_IN_EP									0x88U		/**< 端点8，同步输入 */
+#define COM_HID_IN_EP									0x87U		/**< 端点7，HID输入 */
+#define COM_HID_OUT_EP									0x07U		/**< 端点7，HID输出 */
+
+/* 接口编号：CDC实例n占用接口2n与2n+1，MSC紧随其后 */
+#define COM_CDC_ITF_NBR(n)								((uint8_t)(2U * (n)))
+#define COM_MSC_ITF_NBR									(2U * COM_CDC_INSTANCE_NUM)
+#define COM_NCM_ITF_NBR									(COM_MSC_ITF_NBR + 1U)
+#define COM_VENDOR_ITF_NBR								(COM_NCM_ITF_NBR + 2U * COM_NCM_ENABLED)
+#define COM_ISO_ITF_NBR									(COM_VENDOR_ITF_NBR + COM_VENDOR_ENABLED)
+#define COM_HID_ITF_NBR									(COM_ISO_ITF_NBR + COM_ISO_ENABLED)
+#define COM_ITF_NUM										(COM_HID_ITF_NBR + COM_HID_ENABLED)
+
+#if (COM_CDC_INSTANCE_NUM < 1U) || (COM_CDC_INSTANCE_NUM > 3U)
+#error "COM_CDC_INSTANCE_NUM must be 1 ~ 3"
+#endif
+#if (COM_NCM_ENABLED == 1U) && (COM_CDC_INSTANCE_NUM > 1U)
+#error "CDC-NCM shares endpoints 4/5 with CDC1"
+#endif
+#if (COM_VENDOR_ENABLED == 1U) && (COM_CDC_INSTANCE_NUM > 2U)
+#error "Vendor interface shares endpoint 6 with CDC2"
+#endif
+#if (COM_VENDOR_ENABLED == 1U) && (USBD_CLASS_BOS_ENABLED != 1U)
+#error "Vendor interface needs USBD_CLASS_BOS_ENABLED for the MS OS 2.0 descriptors"
+#endif
+#if (COM_ISO_ENABLED == 1U) && (USBD_CLASS_BOS_ENABLED != 1U)
+#error "Isochronous interface needs USBD_CLASS_BOS_ENABLED for the MS OS 2.0 descriptors"
+#endif
+#if (COM_HID_ENABLED == 1U) && (COM_CDC_INSTANCE_NUM > 2U)
+#error "HID interface shares endpoint 7 with CDC2"
+#endif
+#if (COM_ITF_NUM > USBD_MAX_NUM_INTERFACES)
+#error "USBD_MAX_NUM_INTERFACES is too small for the configured interfaces"
+#endif
 
 /* 控制传输：高速模式的最大包长固定为64个字节；全速模式可在8、16、32、64字节中选择；低速模式的最大包长固定为8个字节。
    批量传输：高速模式固定为512个字节；全速模式最大包长可在8、16、32、64字节中选择；低速模式不支持批量传输。
    同步传输：高速模式的最大包长上限为1024个字节；全速模式的最大包长上限为1023个字节；低速模式不支持同步传输。
    中断传输：告诉模式的最大包长上限为1024个字节；全速模式最大包长上限为64个字节；低速模式最大最大包长上限为8个字节。 */
-#define COM_CDC_DATA_MAX_PACK_SIZE						0x40U		/**< 传输数据包大小 */
+
+/* 控制器可运行在高速(OTG_HS外接ULPI PHY)时为1，CDC包缓冲按高速批量包分配；内置全速PHY时为0 */
+#if (USBD_USE_OTG_HS == 1U) && (USBD_HS_ULPI_PHY == 1U)
+#define COM_HIGH_SPEED_ENABLED							1U
+#else
+#define COM_HIGH_SPEED_ENABLED							0U
+#endif
+
+#define COM_CDC_FS_DATA_PACK_SIZE						0x40U		/**< 全速批量包大小 */
+#define COM_CDC_HS_DATA_PACK_SIZE						0x200U		/**< 高速批量包大小 */
 #define COM_CDC_CMD_PACK_SIZE							0x08U		/**< 控制包大小 */
-#define COM_MSC_DATA_MAX_PACK_SIZE						0x40U		/**< MSC端点数据包大小 */
+#define COM_MSC_FS_DATA_PACK_SIZE						0x40U		/**< MSC全速批量包大小 */
+#define COM_MSC_HS_DATA_PACK_SIZE						0x200U		/**< MSC高速批量包大小 */
+
+/* 应用层单包缓冲的大小，取可能运行的最高速度下的批量包长 */
+#if (COM_HIGH_SPEED_ENABLED == 1U)
+#define COM_CDC_DATA_MAX_PACK_SIZE						COM_CDC_HS_DATA_PACK_SIZE
+#else
+#define COM_CDC_DATA_MAX_PACK_SIZE						COM_CDC_FS_DATA_PACK_SIZE
+#endif
 
+/* 中断端点查询间隔：全速以ms为单位；高速为2^(bInterval-1)个125us微帧，0x08即16ms */
 #define COM_CDC_FS_BINTERVAL							0x10U		/**< 控制端点查询时间 */
-#define COM_CDC_HS_BINTERVAL							0x10U		/**< 控制端点查询时间 */
+#define COM_CDC_HS_BINTERVAL							0x08U		/**< 控制端点查询时间 */
 
-#define USB_COM_COMFIG_DESC_SIZ							106U
+/* ----------------------------------------------------------------------------------------------------- */
+/* 描述符构造：各功能的配置描述符由以下宏拼成，长度由对应的SIZ宏得出 */
+#define USB_IAD_DESC_SIZ								8U
+#define USB_ITF_DESC_SIZ								9U
+#define USB_EP_DESC_SIZ									7U
+
+#define USBD_IAD_DESC(first, count, cls, subcls, proto, str)													\
+	0x08, USB_DESC_TYPE_IAD, (first), (count), (cls), (subcls), (proto), (str)
+
+#define USBD_ITF_DESC(nbr, alt, eps, cls, subcls, proto, str)													\
+	0x09, USB_DESC_TYPE_INTERFACE, (nbr), (alt), (eps), (cls), (subcls), (proto), (str)
+
+#define USBD_EP_DESC(addr, attr, size, interval)																\
+	0x07, USB_DESC_TYPE_ENDPOINT, (addr), (attr), LOBYTE(size), HIBYTE(size), (interval)
+
+/* IAD + 通信类接口(头、调用管理、抽象控制、联合功能描述符与命令端点) + 数据类接口(两个批量端点) */
+#define USB_CDC_DESC_SIZ								(USB_IAD_DESC_SIZ + 2U * USB_ITF_DESC_SIZ + 5U + 5U + 4U + 5U + 3U * USB_EP_DESC_SIZ)
+/* IAD + 接口 + 两个批量端点 */
+#define USB_MSC_DESC_SIZ								(USB_IAD_DESC_SIZ + USB_ITF_DESC_SIZ + 2U * USB_EP_DESC_SIZ)
+/* IAD + 通信类接口(头、联合、以太网、NCM功能描述符与通知端点) + 数据类接口两个备用设置 + 两个批量端点 */
+#define USB_NCM_DESC_SIZ								(USB_IAD_DESC_SIZ + 3U * USB_ITF_DESC_SIZ + 5U + 5U + 13U + 6U + 3U * USB_EP_DESC_SIZ)
+/* 接口 + 两个批量端点 */
+#define USB_VENDOR_DESC_SIZ								(USB_ITF_DESC_SIZ + 2U * USB_EP_DESC_SIZ)
+/* 接口设置0 + 接口设置1 + 同步端点 */
+#define USB_ISO_DESC_SIZ								(2U * USB_ITF_DESC_SIZ + USB_EP_DESC_SIZ)
+/* IAD + 接口 + HID类描述符 + 两个中断端点 */
+#define USB_HID_DESC_SIZ								(USB_IAD_DESC_SIZ + USB_ITF_DESC_SIZ + 9U + 2U * USB_EP_DESC_SIZ)
+#define USB_COM_COMFIG_DESC_SIZ							(9U + USB_CDC_DESC_SIZ * COM_CDC_INSTANCE_NUM + USB_MSC_DESC_SIZ + \
+														 USB_NCM_DESC_SIZ * COM_NCM_ENABLED + USB_VENDOR_DESC_SIZ * COM_VENDOR_ENABLED + \
+														 USB_ISO_DESC_SIZ * COM_ISO_ENABLED + USB_HID_DESC_SIZ * COM_HID_ENABLED)
+/* MSC单独模式：配置 + 接口 + 两个批量端点，只有一个功能，不需要IAD */
+#define USB_MSC_ONLY_CONFIG_DESC_SIZ					(9U + USB_ITF_DESC_SIZ + 2U * USB_EP_DESC_SIZ)
 
 /* ----------------------------------------------------------------------------------------------------- */
 #define CDC_REQ_MAX_DATA_SIZE							0x07U
@@ -191,7 +304,7 @@ typedef struct _USBD_CDC_Itf
 
 typedef struct
 {
-	uint32_t data[COM_CDC_DATA_MAX_PACK_SIZE / 4U];      /* 强制32位对齐 */
+	uint32_t data[USB_MAX_EP0_SIZE / 4U];      /* 类请求数据阶段缓冲，强制32位对齐 */
 	uint8_t  CmdOpCode;
 	uint8_t  CmdLength;
 	uint8_t  *RxBuffer;
@@ -201,8 +314,24 @@ typedef struct
 
 	__IO uint32_t TxState;
 	__IO uint32_t RxState;
+#if (USBD_DMA_ENABLED == 1U)
+	uint32_t TxOffset;                                         /* 经中转缓冲已发出的长度 */
+	uint32_t TxBounce[COM_CDC_DATA_MAX_PACK_SIZE / 4U];        /* DMA要求字对齐，未对齐的发送缓冲分段复制到这里 */
+#endif /* USBD_DMA_ENABLED */
 }USBD_CDC_HandleTypeDef;
 
+#if (COM_SOF_ENABLED == 1U)
+/* 帧任务，在SOF中断中执行，frame为上电以来的帧计数 */
+typedef void (* USBD_COM_SofTaskTypeDef)(USBD_HandleTypeDef *pdev, uint32_t frame);
+
+/* 按帧采样的总线统计 */
+typedef struct
+{
+	uint32_t Frames;									/**< 上电以来经过的帧数，仅在已配置状态下计数 */
+	uint32_t CdcTxBusy[COM_CDC_INSTANCE_NUM];			/**< 各CDC实例发送端点忙碌的帧数 */
+}USBD_COM_SofStatsTypeDef;
+#endif /* COM_SOF_ENABLED */
+
 /* ----------------------------------------------------------------------------------------------------- */
 typedef struct _SENSE_ITEM
 {
@@ -287,6 +416,19 @@ uint8_t USBD_CDC_SetTxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff, uint32_t
 uint8_t USBD_CDC_SetRxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff);
 uint8_t USBD_CDC_ReceivePacket(USBD_HandleTypeDef *pdev);
 uint8_t USBD_CDC_TransmitPacket(USBD_HandleTypeDef *pdev);
+uint8_t USBD_CDC_RegisterInterfaceEx(USBD_HandleTypeDef *pdev, uint8_t index, USBD_CDC_ItfTypeDef *fops);
+uint8_t USBD_CDC_SetTxBufferEx(USBD_HandleTypeDef *pdev, uint8_t index, uint8_t *pbuff, uint32_t length);
+uint8_t USBD_CDC_SetRxBufferEx(USBD_HandleTypeDef *pdev, uint8_t index, uint8_t *pbuff);
+uint8_t USBD_CDC_ReceivePacketEx(USBD_HandleTypeDef *pdev, uint8_t index);
+uint8_t USBD_CDC_TransmitPacketEx(USBD_HandleTypeDef *pdev, uint8_t index);
+
+#if (COM_SOF_ENABLED == 1U)
+uint8_t USBD_COMPOSITE_SofRegister(USBD_COM_SofTaskTypeDef task);
+void USBD_COMPOSITE_GetSofStats(USBD_COM_SofStatsTypeDef *stats);
+#endif /* COM_SOF_ENABLED */
+
+uint8_t USBD_COMPOSITE_SetMode(USBD_HandleTypeDef *pdev, uint8_t mode);
+uint8_t USBD_COMPOSITE_GetMode(void);
 
 /* ----------------------------------------------------------------------------------------------------- */
 
@@ -0,0 +1,101 @@
+/**
+  ******************************************************************************
+  * @file    usbd_hid.h
+  * @author  Sunshine Circuit
+  * @brief   usbd_hid.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_HID_H
+#define __USBD_HID_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_composite.h"
+
+/* 输入、输出报告长度相同，一个报告恰好一包；全速中断端点上限为64字节 */
+#define COM_HID_REPORT_SIZE								0x40U		/**< 报告长度 */
+/* 中断端点查询间隔1ms：全速以ms为单位；高速为2^(bInterval-1)个125us微帧 */
+#define COM_HID_FS_BINTERVAL							0x01U		/**< 全速查询间隔 */
+#define COM_HID_HS_BINTERVAL							0x04U		/**< 高速查询间隔 */
+
+#define HID_DESCRIPTOR_TYPE								0x21U
+#define HID_REPORT_DESC									0x22U
+#define HID_REPORT_DESC_SIZ								0x1BU		/**< 报告描述符长度 */
+
+#define HID_REQ_GET_REPORT								0x01U
+#define HID_REQ_GET_IDLE								0x02U
+#define HID_REQ_SET_REPORT								0x09U
+#define HID_REQ_SET_IDLE								0x0AU
+
+/* HID类描述符，共9字节，配置描述符与GET_DESCRIPTOR请求共用 */
+#define USBD_HID_CLASS_DESC																						\
+	0x09,										/* bLength */													\
+	HID_DESCRIPTOR_TYPE,						/* bDescriptorType: HID */										\
+	0x11, 0x01,									/* bcdHID: 1.11 */												\
+	0x00,										/* bCountryCode */												\
+	0x01,										/* bNumDescriptors */											\
+	HID_REPORT_DESC,							/* bDescriptorType: 报告描述符 */								\
+	LOBYTE(HID_REPORT_DESC_SIZ),				/* wItemLength */												\
+	HIBYTE(HID_REPORT_DESC_SIZ)
+
+/* HID接口描述符：IAD + 接口 + HID类描述符 + 中断输入、输出端点，共USB_HID_DESC_SIZ字节 */
+#define USBD_HID_CFG_DESC(itf, in_ep, out_ep, binterval)															\
+	/* 组合描述符：HID类，无子类，无协议 */																		\
+	USBD_IAD_DESC((itf), 0x01, 0x03, 0x00, 0x00, USBD_IDX_HID_IAD_STR),												\
+	USBD_ITF_DESC((itf), 0x00, 0x02, 0x03, 0x00, 0x00, USBD_IDX_HID_DATA_INTERFACE_STR),							\
+	USBD_HID_CLASS_DESC,																						\
+	USBD_EP_DESC((in_ep), 0x03, COM_HID_REPORT_SIZE, (binterval)),													\
+	USBD_EP_DESC((out_ep), 0x03, COM_HID_REPORT_SIZE, (binterval))
+
+/* ----------------------------------------------------------------------------------------------------- */
+
+/* 报告接口 */
+typedef struct _USBD_HID_Itf
+{
+	int8_t (* Init)(void);
+	int8_t (* DeInit)(void);
+	int8_t (* Receive)(uint8_t *Buf, uint32_t Len);		/**< 收到输出报告(中断端点或SET_REPORT)，在USB中断中调用 */
+}USBD_HID_ItfTypeDef;
+
+typedef struct
+{
+	uint32_t InReports;								/**< 主机取走的输入报告数 */
+	uint32_t OutReports;							/**< 收到的输出报告数 */
+	uint32_t Rejected;								/**< 已有报告排队、返回USBD_BUSY的提交数 */
+	uint32_t MaxLatency;							/**< 输入报告从提交到被主机取走的最长时间，单位ms */
+}USBD_HID_StatsTypeDef;
+
+/* ----------------------------------------------------------------------------------------------------- */
+
+uint8_t USBD_HID_RegisterInterface(USBD_HID_ItfTypeDef *fops);
+uint8_t USBD_HID_SendReport(USBD_HandleTypeDef *pdev, uint8_t *Report, uint16_t Len);
+uint8_t USBD_HID_IsTxBusy(void);
+void USBD_HID_GetStats(USBD_HID_StatsTypeDef *stats);
+
+uint8_t USBD_HID_Init(USBD_HandleTypeDef *pdev);
+uint8_t USBD_HID_DeInit(USBD_HandleTypeDef *pdev);
+uint8_t USBD_HID_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+uint8_t USBD_HID_EP0_RxReady(USBD_HandleTypeDef *pdev);
+uint8_t USBD_HID_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+uint8_t USBD_HID_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_HID_H */
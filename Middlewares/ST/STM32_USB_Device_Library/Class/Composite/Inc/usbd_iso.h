@@ -0,0 +1,80 @@
+/**
+  ******************************************************************************
+  * @file    usbd_iso.h
+  * @author  Sunshine Circuit
+  * @brief   usbd_iso.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_ISO_H
+#define __USBD_ISO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_composite.h"
+
+/* 每个(微)帧一包，包长即预留的带宽：全速每1ms一包，高速每125us一包 */
+#define COM_ISO_FS_PACK_SIZE							0x200U		/**< 全速同步包大小，上限1023 */
+#define COM_ISO_HS_PACK_SIZE							0x200U		/**< 高速同步包大小，上限1024 */
+#define COM_ISO_BINTERVAL								0x01U		/**< 每个(微)帧查询一次 */
+
+/* 同步数据流接口描述符：设置0没有端点、不占带宽；主机选择设置1时为端点预留每帧的带宽，共USB_ISO_DESC_SIZ字节 */
+#define USBD_ISO_CFG_DESC(itf, in_ep, pack_size)																\
+	USBD_ITF_DESC((itf), 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00),													\
+	USBD_ITF_DESC((itf), 0x01, 0x01, 0xFF, 0x00, 0x00, 0x00),													\
+	/* bmAttributes: 同步传输，异步类型，数据速率由传感器决定 */														\
+	USBD_EP_DESC((in_ep), 0x05, (pack_size), COM_ISO_BINTERVAL)
+
+/* ----------------------------------------------------------------------------------------------------- */
+
+/* 数据流接口 */
+typedef struct _USBD_ISO_Itf
+{
+	int8_t (* Init)(void);
+	int8_t (* DeInit)(void);
+	int8_t (* Start)(void);								/**< 主机选择设置1，开始按帧发送 */
+	int8_t (* Stop)(void);								/**< 主机选择设置0或设备断开 */
+	int8_t (* BufferDone)(uint8_t *Buf, uint32_t Len);	/**< 缓冲已发出或被丢弃，可重新填充，在USB中断中调用 */
+}USBD_ISO_ItfTypeDef;
+
+typedef struct
+{
+	uint32_t Packets;								/**< 交给端点的包数，含空包 */
+	uint32_t Bytes;									/**< 主机取走的字节数 */
+	uint32_t Underruns;								/**< 没有待发数据、发出空包的帧数 */
+	uint32_t Missed;								/**< 所在帧内未被主机取走而丢弃的包数 */
+	uint32_t Overruns;								/**< 两个缓冲都在等待时被拒绝的提交数 */
+}USBD_ISO_StatsTypeDef;
+
+/* ----------------------------------------------------------------------------------------------------- */
+
+uint8_t USBD_ISO_RegisterInterface(USBD_ISO_ItfTypeDef *fops);
+uint8_t USBD_ISO_Submit(uint8_t *Buf, uint32_t Len);
+uint8_t USBD_ISO_IsStreaming(void);
+void USBD_ISO_GetStats(USBD_ISO_StatsTypeDef *stats);
+
+uint8_t USBD_ISO_Init(USBD_HandleTypeDef *pdev);
+uint8_t USBD_ISO_DeInit(USBD_HandleTypeDef *pdev);
+uint8_t USBD_ISO_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+uint8_t USBD_ISO_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+uint8_t USBD_ISO_IsoINIncomplete(USBD_HandleTypeDef *pdev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_ISO_H */
@@ -0,0 +1,240 @@
+/**
+  ******************************************************************************
+  * @file    usbd_ncm.h
+  * @author  Sunshine Circuit
+  * @brief   usbd_ncm.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_NCM_H
+#define __USBD_NCM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_composite.h"
+
+#define COM_NCM_FS_DATA_PACK_SIZE						0x40U		/**< 全速数据端点包大小 */
+#define COM_NCM_HS_DATA_PACK_SIZE						0x200U		/**< 高速数据端点包大小 */
+#define COM_NCM_NOTIFY_PACK_SIZE						0x10U		/**< 通知端点包大小 */
+#define COM_NCM_FS_BINTERVAL							0x10U		/**< 通知端点查询时间 */
+#define COM_NCM_HS_BINTERVAL							0x08U		/**< 通知端点查询时间，2^(8-1)个微帧 */
+
+/* NTB缓冲区大小，即dwNtbInMaxSize与dwNtbOutMaxSize */
+#define NCM_NTB_IN_SIZE									0x1000U
+#define NCM_NTB_OUT_SIZE								0x1000U
+#define NCM_NTB_MIN_IN_SIZE								0x0800U		/**< 主机可设置的最小输入NTB */
+#define NCM_MAX_DATAGRAMS								16U			/**< 单个输入NTB最多容纳的帧数 */
+#define NCM_NDP_ALIGN									4U			/**< NDP与帧的对齐 */
+#define NCM_MAX_SEGMENT_SIZE							1514U		/**< 以太网帧最大长度(不含FCS) */
+#define NCM_FS_LINK_SPEED								12000000U	/**< 全速下上报给主机的链路速率 */
+#define NCM_HS_LINK_SPEED								480000000U	/**< 高速下上报给主机的链路速率 */
+
+/* ----------------------------------------------------------------------------------------------------- */
+/* NCM类请求 */
+#define NCM_SET_ETHERNET_PACKET_FILTER					0x43U
+#define NCM_GET_NTB_PARAMETERS							0x80U
+#define NCM_GET_NTB_FORMAT								0x83U
+#define NCM_SET_NTB_FORMAT								0x84U
+#define NCM_GET_NTB_INPUT_SIZE							0x85U
+#define NCM_SET_NTB_INPUT_SIZE							0x86U
+
+/* NCM通知 */
+#define NCM_NOTIFY_NETWORK_CONNECTION					0x00U
+#define NCM_NOTIFY_CONNECTION_SPEED_CHANGE				0x2AU
+
+/* ----------------------------------------------------------------------------------------------------- */
+/*******************************************************************************/
+/* NTB16结构                                                                    */
+/*-----------------------------------------------------------------------------*/
+/* NTH16: dwSignature "NCMH" | wHeaderLength 12 | wSequence | wBlockLength     */
+/*        | wNdpIndex                                                          */
+/* NDP16: dwSignature "NCM0" | wLength | wNextNdpIndex | {wIndex, wLength}...  */
+/*        以{0, 0}结束                                                         */
+/*******************************************************************************/
+#define NCM_NTH16_SIGNATURE								0x484D434EU
+#define NCM_NDP16_SIGNATURE								0x304D434EU
+#define NCM_NTH16_SIZE									12U
+#define NCM_NDP16_HEAD_SIZE								8U
+#define NCM_NDP16_ENTRY_SIZE							4U
+#define NCM_NTB_PARAMETERS_SIZE							28U
+
+/* CDC-NCM描述符：IAD + 通信类接口 + 数据类接口(备用设置0无端点，备用设置1两个端点)，共USB_NCM_DESC_SIZ字节 */
+#define USBD_NCM_CFG_DESC(itf, in_ep, out_ep, notify_ep, mac_str, pack_size, binterval)						\
+	/* 组合描述符 */																								\
+	0x08,										/* bLength */													\
+	USB_DESC_TYPE_IAD,							/* bDescriptorType: 组合描述符 */								\
+	(itf),										/* bFirstInterface */											\
+	0x02,										/* bInterfaceCount */											\
+	0x02,										/* bFunctionClass: CDC类 */										\
+	0x0D,										/* bFunctionSubClass: NCM */									\
+	0x00,										/* bFunctionProtocol */											\
+	0x00,										/* iFunction */													\
+																												\
+	/* 通信类接口描述符 */																							\
+	0x09,										/* bLength */													\
+	USB_DESC_TYPE_INTERFACE,					/* bDescriptorType */											\
+	(itf),										/* bInterfaceNumber */											\
+	0x00,										/* bAlternateSetting */											\
+	0x01,										/* bNumEndpoints: 通知端点 */									\
+	0x02,										/* bInterfaceClass: CDC类 */									\
+	0x0D,										/* bInterfaceSubClass: NCM */									\
+	0x00,										/* bInterfaceProtocol */										\
+	0x00,										/* iInterface */												\
+																												\
+	/* 功能描述符 */																								\
+	0x05,										/* bFunctionLength */											\
+	0x24,										/* bDescriptorType: CS_INTERFACE */								\
+	0x00,										/* bDescriptorSubtype: Header */								\
+	0x10,										/* bcdCDC: 1.10 */												\
+	0x01,																										\
+																												\
+	/* 联合函数描述符 */																							\
+	0x05,										/* bFunctionLength */											\
+	0x24,										/* bDescriptorType: CS_INTERFACE */								\
+	0x06,										/* bDescriptorSubtype: Union */									\
+	(itf),										/* bControlInterface */											\
+	(itf) + 1U,									/* bSubordinateInterface0 */									\
+																												\
+	/* 以太网功能描述符 */																							\
+	0x0D,										/* bFunctionLength */											\
+	0x24,										/* bDescriptorType: CS_INTERFACE */								\
+	0x0F,										/* bDescriptorSubtype: Ethernet Networking */					\
+	(mac_str),									/* iMACAddress: MAC地址字符串索引 */							\
+	0x00,										/* bmEthernetStatistics: 不支持统计 */							\
+	0x00,																										\
+	0x00,																										\
+	0x00,																										\
+	LOBYTE(NCM_MAX_SEGMENT_SIZE),				/* wMaxSegmentSize */											\
+	HIBYTE(NCM_MAX_SEGMENT_SIZE),																				\
+	0x00,										/* wNumberMCFilters */											\
+	0x00,																										\
+	0x00,										/* bNumberPowerFilters */										\
+																												\
+	/* NCM功能描述符 */																								\
+	0x06,										/* bFunctionLength */											\
+	0x24,										/* bDescriptorType: CS_INTERFACE */								\
+	0x1A,										/* bDescriptorSubtype: NCM */									\
+	0x00,										/* bcdNcmVersion: 1.00 */										\
+	0x01,																										\
+	0x00,										/* bmNetworkCapabilities */										\
+																												\
+	/* 通知端点描述符 */																							\
+	0x07,										/* bLength */													\
+	USB_DESC_TYPE_ENDPOINT,						/* bDescriptorType */											\
+	(notify_ep),								/* bEndpointAddress */											\
+	0x03,										/* bmAttributes: 中断传输 */									\
+	LOBYTE(COM_NCM_NOTIFY_PACK_SIZE),			/* wMaxPacketSize */											\
+	HIBYTE(COM_NCM_NOTIFY_PACK_SIZE),																			\
+	(binterval),								/* bInterval */													\
+																												\
+	/* 数据类接口描述符，备用设置0 */																				\
+	0x09,										/* bLength */													\
+	USB_DESC_TYPE_INTERFACE,					/* bDescriptorType */											\
+	(itf) + 1U,									/* bInterfaceNumber */											\
+	0x00,										/* bAlternateSetting */											\
+	0x00,										/* bNumEndpoints */												\
+	0x0A,										/* bInterfaceClass: CDC Data */									\
+	0x00,										/* bInterfaceSubClass */										\
+	0x01,										/* bInterfaceProtocol: NCM数据 */								\
+	0x00,										/* iInterface */												\
+																												\
+	/* 数据类接口描述符，备用设置1 */																				\
+	0x09,										/* bLength */													\
+	USB_DESC_TYPE_INTERFACE,					/* bDescriptorType */											\
+	(itf) + 1U,									/* bInterfaceNumber */											\
+	0x01,										/* bAlternateSetting */											\
+	0x02,										/* bNumEndpoints */												\
+	0x0A,										/* bInterfaceClass: CDC Data */									\
+	0x00,										/* bInterfaceSubClass */										\
+	0x01,										/* bInterfaceProtocol: NCM数据 */								\
+	0x00,										/* iInterface */												\
+																												\
+	/* 端点输入描述符 */																							\
+	0x07,										/* bLength */													\
+	USB_DESC_TYPE_ENDPOINT,						/* bDescriptorType */											\
+	(in_ep),									/* bEndpointAddress */											\
+	0x02,										/* bmAttributes: Bulk 批量传输 */								\
+	LOBYTE(pack_size),							/* wMaxPacketSize */											\
+	HIBYTE(pack_size),																							\
+	0x00,										/* bInterval */													\
+																												\
+	/* 端点输出描述符 */																							\
+	0x07,										/* bLength */													\
+	USB_DESC_TYPE_ENDPOINT,						/* bDescriptorType */											\
+	(out_ep),									/* bEndpointAddress */											\
+	0x02,										/* bmAttributes: Bulk 批量传输 */								\
+	LOBYTE(pack_size),							/* wMaxPacketSize */											\
+	HIBYTE(pack_size),																							\
+	0x00										/* bInterval */
+
+/* ----------------------------------------------------------------------------------------------------- */
+
+/* 网络协议栈接口 */
+typedef struct _USBD_NCM_Itf
+{
+	int8_t (* Init)(void);
+	int8_t (* DeInit)(void);
+	int8_t (* Receive)(uint8_t *Buf, uint16_t Len);		/**< 收到一个以太网帧，在USB中断中调用 */
+	int8_t (* LinkState)(uint8_t Up);					/**< 主机启用或停用数据接口 */
+}USBD_NCM_ItfTypeDef;
+
+/* 输入NTB构建器 */
+typedef struct
+{
+	uint8_t  *Buffer;
+	uint32_t Size;									/**< 缓冲区可用大小 */
+	uint32_t Length;								/**< 已写入长度 */
+	uint16_t Count;									/**< 已写入帧数 */
+	uint16_t Index[NCM_MAX_DATAGRAMS][2];			/**< 帧偏移与长度 */
+}USBD_NCM_NtbTypeDef;
+
+typedef void (* USBD_NCM_FrameCallback)(uint8_t *Buf, uint16_t Len);
+
+typedef struct
+{
+	uint32_t TxFrames;								/**< 已发送的帧数 */
+	uint32_t TxNtbs;								/**< 已发送的NTB数 */
+	uint32_t TxDropped;								/**< NTB已满被拒绝的帧数 */
+	uint32_t RxFrames;								/**< 已接收的帧数 */
+	uint32_t RxNtbs;								/**< 已接收的NTB数 */
+	uint32_t RxErrors;								/**< 格式错误的NTB数 */
+}USBD_NCM_StatsTypeDef;
+
+/* ----------------------------------------------------------------------------------------------------- */
+
+uint8_t USBD_NCM_RegisterInterface(USBD_NCM_ItfTypeDef *fops);
+uint8_t USBD_NCM_Transmit(USBD_HandleTypeDef *pdev, const uint8_t *Buf, uint16_t Len);
+void USBD_NCM_GetStats(USBD_NCM_StatsTypeDef *stats);
+
+uint8_t USBD_NCM_Init(USBD_HandleTypeDef *pdev);
+uint8_t USBD_NCM_DeInit(USBD_HandleTypeDef *pdev);
+uint8_t USBD_NCM_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+uint8_t USBD_NCM_EP0_RxReady(USBD_HandleTypeDef *pdev);
+uint8_t USBD_NCM_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+uint8_t USBD_NCM_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+
+/* NTB编解码，不依赖USB外设 */
+void USBD_NCM_NtbReset(USBD_NCM_NtbTypeDef *ntb, uint8_t *buf, uint32_t size);
+uint8_t USBD_NCM_NtbAppend(USBD_NCM_NtbTypeDef *ntb, const uint8_t *frame, uint16_t len);
+uint32_t USBD_NCM_NtbFinish(USBD_NCM_NtbTypeDef *ntb, uint16_t sequence);
+int32_t USBD_NCM_NtbParse(uint8_t *buf, uint32_t len, USBD_NCM_FrameCallback callback);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_NCM_H */
@@ -0,0 +1,104 @@
+/**
+  ******************************************************************************
+  * @file    usbd_vendor.h
+  * @author  Sunshine Circuit
+  * @brief   usbd_vendor.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_VENDOR_H
+#define __USBD_VENDOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_composite.h"
+
+/* 批量端点包大小取各速度下的上限 */
+#define COM_VENDOR_FS_MAX_PACK_SIZE						0x40U		/**< 全速批量包大小 */
+#define COM_VENDOR_HS_MAX_PACK_SIZE						0x200U		/**< 高速批量包大小 */
+
+/* 输出方向乒乓缓冲，单个缓冲越大，每次传输完成中断搬运的数据越多 */
+#define VENDOR_RX_BUFFER_SIZE							0x1000U
+
+/* 厂商接口描述符：单接口，两个批量端点，共USB_VENDOR_DESC_SIZ字节 */
+#define USBD_VENDOR_CFG_DESC(itf, in_ep, out_ep, pack_size)														\
+	/* 接口描述符 */																								\
+	0x09,										/* bLength */													\
+	USB_DESC_TYPE_INTERFACE,					/* bDescriptorType */											\
+	(itf),										/* bInterfaceNumber */											\
+	0x00,										/* bAlternateSetting */											\
+	0x02,										/* bNumEndpoints */												\
+	0xFF,										/* bInterfaceClass: 厂商自定义 */								\
+	0x00,										/* bInterfaceSubClass */										\
+	0x00,										/* bInterfaceProtocol */										\
+	0x00,										/* iInterface */												\
+																												\
+	/* 端点输入描述符 */																							\
+	0x07,										/* bLength */													\
+	USB_DESC_TYPE_ENDPOINT,						/* bDescriptorType */											\
+	(in_ep),									/* bEndpointAddress */											\
+	0x02,										/* bmAttributes: Bulk 批量传输 */								\
+	LOBYTE(pack_size),							/* wMaxPacketSize */											\
+	HIBYTE(pack_size),																							\
+	0x00,										/* bInterval */													\
+																												\
+	/* 端点输出描述符 */																							\
+	0x07,										/* bLength */													\
+	USB_DESC_TYPE_ENDPOINT,						/* bDescriptorType */											\
+	(out_ep),									/* bEndpointAddress */											\
+	0x02,										/* bmAttributes: Bulk 批量传输 */								\
+	LOBYTE(pack_size),							/* wMaxPacketSize */											\
+	HIBYTE(pack_size),																							\
+	0x00										/* bInterval */
+
+/* ----------------------------------------------------------------------------------------------------- */
+
+/* 数据流接口 */
+typedef struct _USBD_VENDOR_Itf
+{
+	int8_t (* Init)(void);
+	int8_t (* DeInit)(void);
+	int8_t (* Receive)(uint8_t *Buf, uint32_t Len);		/**< 收到一段数据，在USB中断中调用 */
+	int8_t (* TransmitCplt)(uint8_t *Buf, uint32_t Len);	/**< 发送完成，缓冲区可重新使用 */
+}USBD_VENDOR_ItfTypeDef;
+
+typedef struct
+{
+	uint32_t TxBytes;								/**< 已发送字节数 */
+	uint32_t RxBytes;								/**< 已接收字节数 */
+	uint32_t TxTransfers;							/**< 已完成的发送次数 */
+	uint32_t RxTransfers;							/**< 已完成的接收次数 */
+}USBD_VENDOR_StatsTypeDef;
+
+/* ----------------------------------------------------------------------------------------------------- */
+
+uint8_t USBD_VENDOR_RegisterInterface(USBD_VENDOR_ItfTypeDef *fops);
+uint8_t USBD_VENDOR_Transmit(USBD_HandleTypeDef *pdev, uint8_t *Buf, uint32_t Len);
+uint8_t USBD_VENDOR_IsTxBusy(void);
+void USBD_VENDOR_GetStats(USBD_VENDOR_StatsTypeDef *stats);
+
+uint8_t USBD_VENDOR_Init(USBD_HandleTypeDef *pdev);
+uint8_t USBD_VENDOR_DeInit(USBD_HandleTypeDef *pdev);
+uint8_t USBD_VENDOR_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+uint8_t USBD_VENDOR_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+uint8_t USBD_VENDOR_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_VENDOR_H */
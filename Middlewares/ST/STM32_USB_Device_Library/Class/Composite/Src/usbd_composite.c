@@ -49,6 +49,13 @@
   *           这个驱动程序实现了规范的以下方面:
   *             - 仅批量传输协议
   *             - 子类:SCSI透明命令集(参考:SCSI主命令-3 (SPC-3))
+  *          ===================================================================
+  *                                功能分派
+  *          ===================================================================
+  *           每个功能(CDC实例、MSC、NCM、厂商接口、同步数据流、HID)在USBD_COM_Func中有一项描述，
+  *           记录占用的接口、端点、数据句柄与回调。设置配置时由功能表生成端点与
+  *           接口查找表，之后每个数据包与类请求只需一次查表即可调用所属功能。
+  *           新增功能时在功能表中添加一项并实现其回调，分派代码不需要修改。
   *
   *  @endverbatim
   *
@@ -61,6 +68,18 @@
 #include "stm32h7xx.h"
 #include "usbd_composite.h"
 #include "usbd_composite_if.h"
+#if (COM_NCM_ENABLED == 1U)
+#include "usbd_ncm.h"
+#endif
+#if (COM_VENDOR_ENABLED == 1U)
+#include "usbd_vendor.h"
+#endif
+#if (COM_ISO_ENABLED == 1U)
+#include "usbd_iso.h"
+#endif
+#if (COM_HID_ENABLED == 1U)
+#include "usbd_hid.h"
+#endif
 
 /* ---------------------------------- Composite Funtion Declare ---------------------------------- */
 
@@ -70,6 +89,12 @@ static uint8_t USBD_COMPOSITE_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTyped
 static uint8_t USBD_COMPOSITE_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
 static uint8_t USBD_COMPOSITE_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
 static uint8_t USBD_COMPOSITE_EP0_RxReady(USBD_HandleTypeDef *pdev);
+#if (COM_SOF_ENABLED == 1U)
+static uint8_t USBD_COMPOSITE_SOF(USBD_HandleTypeDef *pdev);
+#endif /* COM_SOF_ENABLED */
+#if (COM_ISO_ENABLED == 1U)
+static uint8_t USBD_COMPOSITE_IsoINIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum);
+#endif /* COM_ISO_ENABLED */
 static uint8_t *USBD_COMPOSITE_GetFSCfgDesc(uint16_t *length);
 static uint8_t *USBD_COMPOSITE_GetHSCfgDesc(uint16_t *length);
 static uint8_t *USBD_COMPOSITE_GetOtherSpeedCfgDesc(uint16_t *length);
@@ -115,8 +140,16 @@ USBD_ClassTypeDef USBD_COMPOSITE =
 	USBD_COMPOSITE_EP0_RxReady,	/**< 端点0做接收使用 */
 	USBD_COMPOSITE_DataIn,
 	USBD_COMPOSITE_DataOut,
+#if (COM_SOF_ENABLED == 1U)
+	USBD_COMPOSITE_SOF,	/**< SOF 中断驱动帧调度 */
+#else
 	NULL,		/**< SOF 中断不做处理 */
+#endif /* COM_SOF_ENABLED */
+#if (COM_ISO_ENABLED == 1U)
+	USBD_COMPOSITE_IsoINIncomplete,	/**< IsoINIncomplete 同步数据流丢弃本帧未取走的包 */
+#else
 	NULL,		/**< IsoINIncomplete 同步传输发送未完成中断不做处理 */
+#endif /* COM_ISO_ENABLED */
 	NULL,		/**< IsoOUTIncomplete 同步传输接收未完成中断也不做处理 */
 	USBD_COMPOSITE_GetHSCfgDesc,		/**< 获取高速USB配置描述符 */
 	USBD_COMPOSITE_GetFSCfgDesc,		/**< 获取全速USB配置描述符 */
@@ -139,461 +172,1012 @@ __ALIGN_BEGIN static uint8_t USBD_COMPOSITE_DeviceQualifierDesc[USB_LEN_DEV_QUAL
 	0x00,										/**< bReserved: 保留 */
 };
 
-/* USB COMPOSITE设备配置描述符 */
-__ALIGN_BEGIN static uint8_t USBD_COMPOSITE_CfgDesc[USB_COM_COMFIG_DESC_SIZ] __ALIGN_END =
-{
-	/* 配置描述符 */
-	0x09,										/* bLength: 配置描述符大小 */
-	USB_DESC_TYPE_CONFIGURATION,				/* bDescriptorType: 配置描述符 */
-	USB_COM_COMFIG_DESC_SIZ,					/* wTotalLength: 长度 */
-	0x00,
-	0x03,										/* bNumInterfaces: 3个接口，*/
-	0x01,										/* bConfigurationValue: 配置值 */
-	0x00,										/* iConfiguration: 描述配置的字符串描述符的索引 */
+/* GET_STATUS与GET_INTERFACE的应答，数据阶段在请求返回后才发出，不能放在栈上 */
+__ALIGN_BEGIN static uint32_t USBD_COM_ZeroReply __ALIGN_END = 0U;
+/* MSC的GET_INTERFACE应答，同样要在数据阶段结束前保持有效 */
+__ALIGN_BEGIN static uint32_t USBD_COM_MscAltReply __ALIGN_END = 0U;
+
+/* 单个CDC实例的描述符：IAD + 通信类接口 + 数据类接口，共USB_CDC_DESC_SIZ字节 */
+#define USBD_CDC_CFG_DESC(itf, in_ep, out_ep, cmd_ep, pack_size, binterval)										\
+	/* 组合描述符：CDC类，抽象控制模型，AT常用命令 */																\
+	USBD_IAD_DESC((itf), 0x02, 0x02, 0x02, 0x01, 0x09),																\
+																												\
+	/* 通信类接口描述符：一个中断控制端点 */																		\
+	USBD_ITF_DESC((itf), 0x00, 0x01, 0x02, 0x02, 0x01, 0x05),														\
+																												\
+	/* 功能描述符 */																								\
+	0x05,										/* bLength: 端点描述符大小 */									\
+	0x24,										/* bDescriptorType: CS_INTERFACE描述符 */						\
+	0x00,										/* bDescriptorSubtype: 功能描述符 */							\
+	0x10,										/* bcdCDC: USB通信设备协议的版本号 */							\
+	0x01,																										\
+																												\
+	/* 调用管理功能描述符 */																						\
+	0x05,										/* bFunctionLength */											\
+	0x24,										/* bDescriptorType: CS_INTERFACE */								\
+	0x01,										/* bDescriptorSubtype: 调用管理功能描述符 */					\
+	0x00,										/* bmCapabilities: 设备自己不处理调用管理 */					\
+	(itf) + 1U,									/* bDataInterface: 数据类接口编号 */							\
+																												\
+	/* 抽象控制管理功能描述符 */																					\
+	0x04,										/* bFunctionLength */											\
+	0x24,										/* bDescriptorType: CS_INTERFACE */								\
+	0x02,										/* bDescriptorSubtype: 摘要控制管理描述符 */					\
+	0x02,										/* bmCapabilities: 支持Set_Line_Coding等请求与Serial_State通知 */\
+																												\
+	/* 联合函数描述符 */																							\
+	0x05,										/* bFunctionLength */											\
+	0x24,										/* bDescriptorType: CS_INTERFACE */								\
+	0x06,										/* bDescriptorSubtype: Union func desc */						\
+	(itf),										/* bMasterInterface: Communication class interface */			\
+	(itf) + 1U,									/* bSlaveInterface0: 数据类型接口编号 */						\
+																												\
+	/* 中断控制端点描述符 */																						\
+	USBD_EP_DESC((cmd_ep), 0x03, COM_CDC_CMD_PACK_SIZE, (binterval)),												\
+																												\
+	/* 数据类接口描述符：两个批量端点 */																			\
+	USBD_ITF_DESC((itf) + 1U, 0x00, 0x02, 0x0A, 0x00, 0x00, 0x06),													\
+	USBD_EP_DESC((in_ep), 0x02, (pack_size), 0x00),																	\
+	USBD_EP_DESC((out_ep), 0x02, (pack_size), 0x00)
+
+/* MSC的描述符：IAD + 接口 + 两个批量端点，共USB_MSC_DESC_SIZ字节 */
+#define USBD_MSC_CFG_DESC(itf, in_ep, out_ep, pack_size)															\
+	/* 组合描述符：MSC类，SCSI透明命令集，仅批量传输 */																\
+	USBD_IAD_DESC((itf), 0x01, 0x08, 0x06, 0x50, 0x0A),																\
+	USBD_ITF_DESC((itf), 0x00, 0x02, 0x08, 0x06, 0x50, 0x07),														\
+	USBD_EP_DESC((in_ep), 0x02, (pack_size), 0x00),																	\
+	USBD_EP_DESC((out_ep), 0x02, (pack_size), 0x00)
+
+/* 可选功能按配置展开为描述符或空，speed为FS或HS */
+#if (COM_CDC_INSTANCE_NUM > 1U)
+#define COM_CDC1_CFG_DESC(speed)						USBD_CDC_CFG_DESC(COM_CDC_ITF_NBR(1U), COM_CDC1_IN_EP, COM_CDC1_OUT_EP, COM_CDC1_CMD_EP, \
+														COM_CDC_##speed##_DATA_PACK_SIZE, COM_CDC_##speed##_BINTERVAL),
+#else
+#define COM_CDC1_CFG_DESC(speed)
+#endif
+#if (COM_CDC_INSTANCE_NUM > 2U)
+#define COM_CDC2_CFG_DESC(speed)						USBD_CDC_CFG_DESC(COM_CDC_ITF_NBR(2U), COM_CDC2_IN_EP, COM_CDC2_OUT_EP, COM_CDC2_CMD_EP, \
+														COM_CDC_##speed##_DATA_PACK_SIZE, COM_CDC_##speed##_BINTERVAL),
+#else
+#define COM_CDC2_CFG_DESC(speed)
+#endif
+#if (COM_NCM_ENABLED == 1U)
+#define COM_NCM_CFG_DESC(speed)							USBD_NCM_CFG_DESC(COM_NCM_ITF_NBR, COM_NCM_IN_EP, COM_NCM_OUT_EP, COM_NCM_NOTIFY_EP, USBD_IDX_NCM_MAC_STR, \
+														COM_NCM_##speed##_DATA_PACK_SIZE, COM_NCM_##speed##_BINTERVAL),
+#else
+#define COM_NCM_CFG_DESC(speed)
+#endif
+#if (COM_VENDOR_ENABLED == 1U)
+#define COM_VENDOR_CFG_DESC(speed)						USBD_VENDOR_CFG_DESC(COM_VENDOR_ITF_NBR, COM_VENDOR_IN_EP, COM_VENDOR_OUT_EP, \
+														COM_VENDOR_##speed##_MAX_PACK_SIZE),
+#else
+#define COM_VENDOR_CFG_DESC(speed)
+#endif
+#if (COM_ISO_ENABLED == 1U)
+#define COM_ISO_CFG_DESC(speed)							USBD_ISO_CFG_DESC(COM_ISO_ITF_NBR, COM_ISO_IN_EP, COM_ISO_##speed##_PACK_SIZE),
+#else
+#define COM_ISO_CFG_DESC(speed)
+#endif
+#if (COM_HID_ENABLED == 1U)
+#define COM_HID_CFG_DESC(speed)							USBD_HID_CFG_DESC(COM_HID_ITF_NBR, COM_HID_IN_EP, COM_HID_OUT_EP, COM_HID_##speed##_BINTERVAL),
+#else
+#define COM_HID_CFG_DESC(speed)
+#endif
+
 #if (USBD_SELF_POWERED == 1U)
-	0xC0,										/* bmAttributes: 总线根据用户配置上电 */
+#define COM_CFG_ATTRIBUTES								0xC0U		/**< 自供电 */
 #else
-	0x80,										/* bmAttributes: 总线根据用户配置上电 */
+#define COM_CFG_ATTRIBUTES								0x80U		/**< 总线供电 */
 #endif /* USBD_SELF_POWERED */
-	USBD_MAX_POWER,								/* MaxPower (mA) */
-
-	/*-------------- Communication Device Class (Virtual Port Com) --------------*/
-
-	/* 组合描述符 */
-	0x08,										/* bLength: 组合描述符*/
-	USB_DESC_TYPE_IAD,							/* bDescriptorTyppe: 组合描述符*/
-	0x00,										/* bFirstInterface: 首个接口编号 */
-	0x02,										/* bInterfaceCount: 接口数量 */
-	0x02,										/* bFunctionClass: CDC类 */
-	0x02,										/* bFunctionSubClass: 抽象控制模型 */
-	0x01,										/* bFunctionProtocol: AT常用命令 */
-	0x09,										/* iFunction: */
-
-	/* 接口描述符 */
-	0x09,										/* bLength: 接口描述符大小 */
-	USB_DESC_TYPE_INTERFACE,					/* bDescriptorType: 接口描述符 */
-	0x00,										/* bInterfaceNumber: 接口编号 */
-	0x00,										/* bAlternateSetting: 备用通道  */
-	0x01,										/* bNumEndpoints: 使用的一个端点？？？？？端点0？？？ */
-	0x02,										/* bInterfaceClass: CDC类 */
-	0x02,										/* bInterfaceSubClass: 抽象控制模型 */
-	0x01,										/* bInterfaceProtocol: AT常用命令 */
-	0x05,										/* iInterface */
-
-	/* 功能描述符 */
-	0x05,										/* bLength: 端点描述符大小 */
-	0x24,										/* bDescriptorType: CS_INTERFACE描述符 */
-	0x00,										/* bDescriptorSubtype: 功能描述符 */
-	0x10,										/* bcdCDC: 规格发布号，即USB通信设备协议的版本号 */
-	0x01,
-
-	/* 调用管理功能描述符 */
-	0x05,										/* bFunctionLength */
-	0x24,										/* bDescriptorType: CS_INTERFACE */
-	0x01,										/* bDescriptorSubtype: 调用管理功能描述符 */
-	0x00,										/* bmCapabilities: D0+D1 描述设备的能力，只有最低两位D0和D1有意义，其余
-													位为保留值0。D0为0，表示设备自己不处理调用管理，为1则表示自己处理。 */
-	0x01,										/* bDataInterface 表示选择用来做调用管理的数据类接口编号，由于不使用
-													数据类接口做调用管理，因而该字段设置为0 */
-
-	/* 抽象控制管理功能描述符 */
-	0x04,										/* bFunctionLength */
-	0x24,										/* bDescriptorType: CS_INTERFACE */
-	0x02,										/* bDescriptorSubtype: 摘要控制管理描述符 */
-	0x02,										/* bmCapabilities 其中D7-4位为保留位，设置为0，支持Set_Line_Coding、
-													Set_Control_Line_State、Get_Line_Coding请求和Serial_State通知
-													D0表示是否支持以下请求：Set_Comm_Feature、Clear_Comm_Feature、
-													Get_Comm_Feature,为1表示支持；D1位表示是否支持Set_Line_Coding、
-													Set_Control_Line_State、Get_Line_Coding请求和Serial_State通知，
-													为1表示支持；D2为表示是否支持Send_Break，为1表示支持；D3表示是否
-													支持Network_Connection通知，为1表示支持 */
-
-	/* 联合函数描述符 */
-	0x05,										/* bFunctionLength */
-	0x24,										/* bDescriptorType: CS_INTERFACE */
-	0x06,										/* bDescriptorSubtype: Union func desc */
-	0x00,										/* bMasterInterface: Communication class interface */
-	0x01,										/* bSlaveInterface0: 数据类型接口编号 */
-
-	/* 端点2描述符 */
-	0x07,										/* bLength: 端点描述符大小 */
-	USB_DESC_TYPE_ENDPOINT,						/* bDescriptorType: 端点描述符 */
-	COM_CDC_CMD_EP,								/* bEndpointAddress: 端点描述符地址 */
-	0x03,										/* bmAttributes: 中断控制传输 */
-	LOBYTE(COM_CDC_CMD_PACK_SIZE),				/* wMaxPacketSize: 端点支持的最大包长 */
-	HIBYTE(COM_CDC_CMD_PACK_SIZE),
-	COM_CDC_FS_BINTERVAL,						/* bInterval: 端点查询时间 */
-
-	/* 数据类接口描述符 */
-	0x09,										/* bLength: 接口描述符大小 */
-	USB_DESC_TYPE_INTERFACE,					/* bDescriptorType: 接口描述符 */
-	0x01,										/* bInterfaceNumber: 接口编号 */
-	0x00,										/* bAlternateSetting: 交替设置 */
-	0x02,										/* bNumEndpoints: 使用两个端点 */
-	0x0A,										/* bInterfaceClass: CDC */
-	0x00,										/* bInterfaceSubClass */
-	0x00,										/* bInterfaceProtocol */
-	0x06,										/* iInterface */
-
-	/* 端点输入描述符 */
-	0x07,										/* bLength: 端点描述符大小 */
-	USB_DESC_TYPE_ENDPOINT,						/* bDescriptorType: 端点描述符 */
-	COM_CDC_IN_EP,								/* bEndpointAddress: 端点1 */
-	0x02,										/* bmAttributes: Bulk 批量传输 */
-	LOBYTE(COM_CDC_DATA_MAX_PACK_SIZE),			/* wMaxPacketSize: 端点包大小 */
-	HIBYTE(COM_CDC_DATA_MAX_PACK_SIZE),
-	0x00,										/* bInterval: 端点查询时间 */
-
-	/* 端点输出描述符 */
-	0x07,										/* bLength: 端点描述符大小 */
-	USB_DESC_TYPE_ENDPOINT,						/* bDescriptorType: 端点描述符 */
-	COM_CDC_OUT_EP,								/* bEndpointAddress: 端点1 */
-	0x02,										/* bmAttributes: Bulk 批量传输 */
-	LOBYTE(COM_CDC_DATA_MAX_PACK_SIZE),			/* wMaxPacketSize: 端点包大小 */
-	HIBYTE(COM_CDC_DATA_MAX_PACK_SIZE),
-	0x00,										/* bInterval: 端点查询时间 */
-
-	/*--------------------------- Mass Storage Class ----------------------------*/
-
-	/* 关联接口描述符 */
-	0x08,										/* bLength: 组合描述符尺寸 */
-	USB_DESC_TYPE_IAD,							/* bDescriptorTyppe: 组合描述符*/
-	0x02,										/* bFirstInterface: 首个接口编号 */
-	0x01,										/* bInterfaceCount: 接口数量 */
-	0x08,										/* bFunctionClass: CDC类 */
-	0x06,										/* bFunctionSubClass: 抽象控制模型 */
-	0x50,										/* bFunctionProtocol: AT常用命令 */
-	0x0A,										/* iFunction: */
-
-	/* 接口描述符 */
-	0x09,										/* bLength: 接口描述符尺寸 */
-	USB_DESC_TYPE_INTERFACE,					/* bDescriptorType: 接口描述符 */
-	0x02,										/* bInterfaceNumber: 接口数量 */
-	0x00,										/* bAlternateSetting: 交替设置 */
-	0x02,										/* bNumEndpoints: 端点数量 */
-	0x08,										/* bInterfaceClass: MSC Class */
-	0x06,										/* bInterfaceSubClass: SCSI透明传输 */
-	0x50,										/* nInterfaceProtocol */
-	0x07,										/* iInterface: */
-
-	/* 端点描述符 */
-	0x07,										/* bLength: 端点描述符大小 */
-	USB_DESC_TYPE_ENDPOINT,						/* bDescriptorType: 端点描述符 */
-	COM_MSC_IN_EP,								/* bEndpointAddress: 端点3 */
-	0x02,										/* bmAttributes: Bulk 批量传输 */
-	LOBYTE(COM_MSC_DATA_MAX_PACK_SIZE),			/* wMaxPacketSize: 端点包大小 */
-	HIBYTE(COM_MSC_DATA_MAX_PACK_SIZE),
-	0x00,										/* bInterval: 轮询间隔(毫秒) */
-
-	0x07,										/* bLength: 端点描述符大小 */
-	USB_DESC_TYPE_ENDPOINT,						/* bDescriptorType: 端点描述符 */
-	COM_MSC_OUT_EP,								/* bEndpointAddress: 端点3 */
-	0x02,										/* bmAttributes: Bulk 批量传输 */
-	LOBYTE(COM_MSC_DATA_MAX_PACK_SIZE),			/* wMaxPacketSize: 端点包大小 */
-	HIBYTE(COM_MSC_DATA_MAX_PACK_SIZE),
-	0x00,										/* bInterval: 轮询间隔(毫秒) */
+
+/* USB COMPOSITE设备配置描述符，type为配置或其他速度配置，speed选择各端点的包长与查询间隔 */
+#define USBD_COMPOSITE_CFG_DESC(type, speed)																	\
+	/* 配置描述符 */																								\
+	0x09,										/* bLength: 配置描述符大小 */									\
+	(type),										/* bDescriptorType: 配置描述符 */								\
+	LOBYTE(USB_COM_COMFIG_DESC_SIZ),			/* wTotalLength: 长度 */										\
+	HIBYTE(USB_COM_COMFIG_DESC_SIZ),																			\
+	COM_ITF_NUM,								/* bNumInterfaces: 每个CDC两个接口，MSC一个接口 */				\
+	0x01,										/* bConfigurationValue: 配置值 */								\
+	0x00,										/* iConfiguration: 描述配置的字符串描述符的索引 */				\
+	COM_CFG_ATTRIBUTES,							/* bmAttributes: 供电方式 */									\
+	USBD_MAX_POWER,								/* MaxPower (mA) */												\
+																												\
+	/*-------------- Communication Device Class (Virtual Port Com) --------------*/								\
+	USBD_CDC_CFG_DESC(COM_CDC_ITF_NBR(0U), COM_CDC_IN_EP, COM_CDC_OUT_EP, COM_CDC_CMD_EP,						\
+					  COM_CDC_##speed##_DATA_PACK_SIZE, COM_CDC_##speed##_BINTERVAL),							\
+	COM_CDC1_CFG_DESC(speed)																					\
+	COM_CDC2_CFG_DESC(speed)																					\
+																												\
+	/*--------------------------- Mass Storage Class ----------------------------*/								\
+	USBD_MSC_CFG_DESC(COM_MSC_ITF_NBR, COM_MSC_IN_EP, COM_MSC_OUT_EP, COM_MSC_##speed##_DATA_PACK_SIZE),		\
+																												\
+	/*------------------------ Network Control Model ---------------------------*/								\
+	COM_NCM_CFG_DESC(speed)																						\
+																												\
+	/*---------------------------- Vendor Specific -----------------------------*/								\
+	COM_VENDOR_CFG_DESC(speed)																					\
+																												\
+	/*------------------------- Isochronous Streaming --------------------------*/								\
+	COM_ISO_CFG_DESC(speed)																						\
+																												\
+	/*------------------------- Human Interface Device -------------------------*/								\
+	COM_HID_CFG_DESC(speed)
+
+/* 全速配置描述符 */
+__ALIGN_BEGIN static uint8_t USBD_COMPOSITE_FSCfgDesc[] __ALIGN_END =
+{
+	USBD_COMPOSITE_CFG_DESC(USB_DESC_TYPE_CONFIGURATION, FS)
+};
+
+#if (COM_HIGH_SPEED_ENABLED == 1U)
+/* 高速配置描述符 */
+__ALIGN_BEGIN static uint8_t USBD_COMPOSITE_HSCfgDesc[] __ALIGN_END =
+{
+	USBD_COMPOSITE_CFG_DESC(USB_DESC_TYPE_CONFIGURATION, HS)
+};
+
+/* 高速运行时报告的全速配置 */
+__ALIGN_BEGIN static uint8_t USBD_COMPOSITE_OtherSpeedCfgDesc[] __ALIGN_END =
+{
+	USBD_COMPOSITE_CFG_DESC(USB_DESC_TYPE_OTHER_SPEED_CONFIGURATION, FS)
+};
+
+typedef char USBD_COMPOSITE_HSCfgDescSizeCheck[(sizeof(USBD_COMPOSITE_HSCfgDesc) == USB_COM_COMFIG_DESC_SIZ) ? 1 : -1];
+#endif /* COM_HIGH_SPEED_ENABLED */
+
+/* 描述符实际长度与USB_COM_COMFIG_DESC_SIZ不一致时编译失败，wTotalLength由后者得出 */
+typedef char USBD_COMPOSITE_FSCfgDescSizeCheck[(sizeof(USBD_COMPOSITE_FSCfgDesc) == USB_COM_COMFIG_DESC_SIZ) ? 1 : -1];
+
+/* MSC单独模式的配置描述符：MSC为接口0，端点与复合模式相同，设备类在设备描述符中为0 */
+#define USBD_MSC_ONLY_CFG_DESC(type, speed)																		\
+	0x09,										/* bLength: 配置描述符大小 */									\
+	(type),										/* bDescriptorType: 配置描述符 */								\
+	LOBYTE(USB_MSC_ONLY_CONFIG_DESC_SIZ),		/* wTotalLength: 长度 */										\
+	HIBYTE(USB_MSC_ONLY_CONFIG_DESC_SIZ),																		\
+	0x01,										/* bNumInterfaces: 只有MSC一个接口 */							\
+	0x01,										/* bConfigurationValue: 配置值 */								\
+	0x00,										/* iConfiguration: 描述配置的字符串描述符的索引 */				\
+	COM_CFG_ATTRIBUTES,							/* bmAttributes: 供电方式 */									\
+	USBD_MAX_POWER,								/* MaxPower (mA) */												\
+	USBD_ITF_DESC(0x00, 0x00, 0x02, 0x08, 0x06, 0x50, 0x07),													\
+	USBD_EP_DESC(COM_MSC_IN_EP, 0x02, COM_MSC_##speed##_DATA_PACK_SIZE, 0x00),									\
+	USBD_EP_DESC(COM_MSC_OUT_EP, 0x02, COM_MSC_##speed##_DATA_PACK_SIZE, 0x00)
+
+__ALIGN_BEGIN static uint8_t USBD_MSC_ONLY_FSCfgDesc[] __ALIGN_END =
+{
+	USBD_MSC_ONLY_CFG_DESC(USB_DESC_TYPE_CONFIGURATION, FS)
 };
 
+#if (COM_HIGH_SPEED_ENABLED == 1U)
+__ALIGN_BEGIN static uint8_t USBD_MSC_ONLY_HSCfgDesc[] __ALIGN_END =
+{
+	USBD_MSC_ONLY_CFG_DESC(USB_DESC_TYPE_CONFIGURATION, HS)
+};
+
+__ALIGN_BEGIN static uint8_t USBD_MSC_ONLY_OtherSpeedCfgDesc[] __ALIGN_END =
+{
+	USBD_MSC_ONLY_CFG_DESC(USB_DESC_TYPE_OTHER_SPEED_CONFIGURATION, FS)
+};
+#endif /* COM_HIGH_SPEED_ENABLED */
+
+typedef char USBD_MSC_ONLY_FSCfgDescSizeCheck[(sizeof(USBD_MSC_ONLY_FSCfgDesc) == USB_MSC_ONLY_CONFIG_DESC_SIZ) ? 1 : -1];
+
 /* ----------------------------------- Composite Class Funtion ----------------------------------- */
 
+/* 单个功能占用的端点上限 */
+#define COM_FUNC_EP_NUM									3U
+
+typedef struct _USBD_COM_Func USBD_COM_FuncTypeDef;
+
+/* 复合设备中的一个功能：占用连续的接口与若干端点，回调直接拿到所属的功能描述 */
+struct _USBD_COM_Func
+{
+	uint8_t ItfNbr;								/**< 第一个接口编号 */
+	uint8_t ItfNum;								/**< 占用的接口数量 */
+	uint8_t Ep[COM_FUNC_EP_NUM];				/**< 端点地址，0为未使用；CDC依次为输入、输出、命令端点 */
+	uint8_t Index;								/**< 同类功能中的实例编号 */
+	void *Handle;								/**< 数据句柄 */
+	void *Fops;									/**< 操作接口 */
+
+	uint8_t (* Init)(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+	uint8_t (* DeInit)(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+	uint8_t (* Setup)(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, USBD_SetupReqTypedef *req);
+	uint8_t (* EP0_RxReady)(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+	uint8_t (* DataIn)(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum);
+	uint8_t (* DataOut)(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum);
+};
+
+static uint8_t USBD_COM_CDC_Init(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+static uint8_t USBD_COM_CDC_DeInit(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+static uint8_t USBD_COM_CDC_Setup(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, USBD_SetupReqTypedef *req);
+static uint8_t USBD_COM_CDC_EP0_RxReady(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+static uint8_t USBD_COM_CDC_DataIn(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum);
+static uint8_t USBD_COM_CDC_DataOut(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum);
+static uint8_t USBD_COM_MSC_Init(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+static uint8_t USBD_COM_MSC_DeInit(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+static uint8_t USBD_COM_MSC_Setup(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, USBD_SetupReqTypedef *req);
+static uint8_t USBD_COM_MSC_DataIn(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum);
+static uint8_t USBD_COM_MSC_DataOut(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum);
+#if (COM_NCM_ENABLED == 1U)
+static uint8_t USBD_COM_NCM_Init(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+static uint8_t USBD_COM_NCM_DeInit(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+static uint8_t USBD_COM_NCM_Setup(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, USBD_SetupReqTypedef *req);
+static uint8_t USBD_COM_NCM_EP0_RxReady(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+static uint8_t USBD_COM_NCM_DataIn(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum);
+static uint8_t USBD_COM_NCM_DataOut(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum);
+#endif
+#if (COM_VENDOR_ENABLED == 1U)
+static uint8_t USBD_COM_VENDOR_Init(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+static uint8_t USBD_COM_VENDOR_DeInit(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+static uint8_t USBD_COM_VENDOR_Setup(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, USBD_SetupReqTypedef *req);
+static uint8_t USBD_COM_VENDOR_DataIn(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum);
+static uint8_t USBD_COM_VENDOR_DataOut(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum);
+#endif
+#if (COM_ISO_ENABLED == 1U)
+static uint8_t USBD_COM_ISO_Init(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+static uint8_t USBD_COM_ISO_DeInit(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+static uint8_t USBD_COM_ISO_Setup(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, USBD_SetupReqTypedef *req);
+static uint8_t USBD_COM_ISO_DataIn(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum);
+#endif
+#if (COM_HID_ENABLED == 1U)
+static uint8_t USBD_COM_HID_Init(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+static uint8_t USBD_COM_HID_DeInit(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+static uint8_t USBD_COM_HID_Setup(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, USBD_SetupReqTypedef *req);
+static uint8_t USBD_COM_HID_EP0_RxReady(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func);
+static uint8_t USBD_COM_HID_DataIn(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum);
+static uint8_t USBD_COM_HID_DataOut(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum);
+#endif
+
+/* 各功能的数据句柄，静态分配 */
+static USBD_CDC_HandleTypeDef USBD_CDC_Handle[COM_CDC_INSTANCE_NUM];
+static USBD_MSC_BOT_HandleTypeDef USBD_MSC_Handle;
+
+#define COM_FUNC_CDC(n, in, out, cmd, fops) \
+	{COM_CDC_ITF_NBR(n), 2U, {(in), (out), (cmd)}, (n), &USBD_CDC_Handle[n], (fops), \
+	 USBD_COM_CDC_Init, USBD_COM_CDC_DeInit, USBD_COM_CDC_Setup, USBD_COM_CDC_EP0_RxReady, USBD_COM_CDC_DataIn, USBD_COM_CDC_DataOut}
+
+/* 功能表：CDC实例必须位于最前，表中下标即CDC实例编号；新增功能只需在此添加一项 */
+static USBD_COM_FuncTypeDef USBD_COM_Func[] =
+{
+	COM_FUNC_CDC(0U, COM_CDC_IN_EP,  COM_CDC_OUT_EP,  COM_CDC_CMD_EP,  &USBD_CDC_Interface_fops_FS),
+#if (COM_CDC_INSTANCE_NUM > 1U)
+	COM_FUNC_CDC(1U, COM_CDC1_IN_EP, COM_CDC1_OUT_EP, COM_CDC1_CMD_EP, &USBD_CDC1_Interface_fops_FS),
+#endif
+#if (COM_CDC_INSTANCE_NUM > 2U)
+	COM_FUNC_CDC(2U, COM_CDC2_IN_EP, COM_CDC2_OUT_EP, COM_CDC2_CMD_EP, &USBD_CDC2_Interface_fops_FS),
+#endif
+	{COM_MSC_ITF_NBR, 1U, {COM_MSC_IN_EP, COM_MSC_OUT_EP, 0U}, 0U, &USBD_MSC_Handle, &USBD_MSC_Interface_fops_FS,
+	 USBD_COM_MSC_Init, USBD_COM_MSC_DeInit, USBD_COM_MSC_Setup, NULL, USBD_COM_MSC_DataIn, USBD_COM_MSC_DataOut},
+#if (COM_NCM_ENABLED == 1U)
+	{COM_NCM_ITF_NBR, 2U, {COM_NCM_IN_EP, COM_NCM_OUT_EP, COM_NCM_NOTIFY_EP}, 0U, NULL, NULL,
+	 USBD_COM_NCM_Init, USBD_COM_NCM_DeInit, USBD_COM_NCM_Setup, USBD_COM_NCM_EP0_RxReady, USBD_COM_NCM_DataIn, USBD_COM_NCM_DataOut},
+#endif
+#if (COM_VENDOR_ENABLED == 1U)
+	{COM_VENDOR_ITF_NBR, 1U, {COM_VENDOR_IN_EP, COM_VENDOR_OUT_EP, 0U}, 0U, NULL, NULL,
+	 USBD_COM_VENDOR_Init, USBD_COM_VENDOR_DeInit, USBD_COM_VENDOR_Setup, NULL, USBD_COM_VENDOR_DataIn, USBD_COM_VENDOR_DataOut},
+#endif
+#if (COM_ISO_ENABLED == 1U)
+	{COM_ISO_ITF_NBR, 1U, {COM_ISO_IN_EP, 0U, 0U}, 0U, NULL, NULL,
+	 USBD_COM_ISO_Init, USBD_COM_ISO_DeInit, USBD_COM_ISO_Setup, NULL, USBD_COM_ISO_DataIn, NULL},
+#endif
+#if (COM_HID_ENABLED == 1U)
+	{COM_HID_ITF_NBR, 1U, {COM_HID_IN_EP, COM_HID_OUT_EP, 0U}, 0U, NULL, NULL,
+	 USBD_COM_HID_Init, USBD_COM_HID_DeInit, USBD_COM_HID_Setup, USBD_COM_HID_EP0_RxReady, USBD_COM_HID_DataIn, USBD_COM_HID_DataOut},
+#endif
+};
+
+#define COM_FUNC_NUM									(sizeof(USBD_COM_Func) / sizeof(USBD_COM_Func[0]))
+#define COM_FUNC_MSC									COM_CDC_INSTANCE_NUM		/**< MSC在功能表中的下标 */
+
+/* 当前运行模式，只在设备未连接时由USBD_COMPOSITE_SetMode修改 */
+static uint8_t USBD_COM_Mode = COM_MODE_COMPOSITE;
+
+/* 功能是否参与当前模式：MSC单独模式下只有MSC */
+#define COM_FUNC_ACTIVE(i)								((USBD_COM_Mode == COM_MODE_COMPOSITE) || ((i) == COM_FUNC_MSC))
+
+/* 端点与接口到功能的查找表，保存功能表下标加1，0表示不属于任何功能 */
+static uint8_t USBD_COM_EpInMap[16];
+static uint8_t USBD_COM_EpOutMap[16];
+static uint8_t USBD_COM_ItfMap[USBD_MAX_NUM_INTERFACES];
+
 /**
-  * @brief  USBD_CDC_MALLOC 申请CDC静态内存
-  * @retval 内存地址
+  * @brief  USBD_COM_BuildMap 由功能表生成端点与接口查找表
+  * @note   在设置配置时调用一次，之后每个数据包只需一次查表。
+  *         MSC单独模式下只登记MSC，其接口编号为0。
   */
-static USBD_CDC_HandleTypeDef * USBD_CDC_MALLOC(void)
+static void USBD_COM_BuildMap(void)
 {
-	static USBD_CDC_HandleTypeDef USBD_CDC_Handle;
-	return &USBD_CDC_Handle;
+	uint8_t i, j, ep, itf;
+
+	(void)USBD_memset(USBD_COM_EpInMap, 0, sizeof(USBD_COM_EpInMap));
+	(void)USBD_memset(USBD_COM_EpOutMap, 0, sizeof(USBD_COM_EpOutMap));
+	(void)USBD_memset(USBD_COM_ItfMap, 0, sizeof(USBD_COM_ItfMap));
+
+	for(i = 0U; i < COM_FUNC_NUM; i++)
+	{
+		if(!COM_FUNC_ACTIVE(i))
+			continue;
+		for(j = 0U; j < COM_FUNC_EP_NUM; j++)
+		{
+			ep = USBD_COM_Func[i].Ep[j];
+			if(ep == 0U)
+				continue;
+			if((ep & 0x80U) != 0U)
+				USBD_COM_EpInMap[ep & 0x0FU] = i + 1U;
+			else
+				USBD_COM_EpOutMap[ep & 0x0FU] = i + 1U;
+		}
+		itf = (USBD_COM_Mode == COM_MODE_COMPOSITE) ? USBD_COM_Func[i].ItfNbr : 0U;
+		for(j = 0U; j < USBD_COM_Func[i].ItfNum; j++)
+			USBD_COM_ItfMap[itf + j] = i + 1U;
+	}
 }
 
 /**
-  * @brief  USBD_MSC_MALLOC 申请MSC静态内存
-  * @retval 内存地址
+  * @brief  USBD_COM_FindEp 查找端点所属的功能
+  * @param  epaddr: 端点地址
+  * @retval 功能描述，不属于任何功能时返回NULL
   */
-static USBD_MSC_BOT_HandleTypeDef * USBD_MSC_MALLOC(void)
+static inline USBD_COM_FuncTypeDef * USBD_COM_FindEp(uint8_t epaddr)
 {
-	static USBD_MSC_BOT_HandleTypeDef USBD_MSC_Handle;
-	return &USBD_MSC_Handle;
+	uint8_t slot = ((epaddr & 0x80U) != 0U) ? USBD_COM_EpInMap[epaddr & 0x0FU] : USBD_COM_EpOutMap[epaddr & 0x0FU];
+
+	return (slot != 0U) ? &USBD_COM_Func[slot - 1U] : NULL;
 }
 
 /**
-  * @brief  USBD_CDC_FREE 释放CDC内存
-  * @retval 释放结果，若释放完成，则为NULL，否则为原地址
+  * @brief  USBD_COM_FindReq 查找请求所属的功能
+  * @note   端点请求的wIndex为端点地址，其余请求的wIndex低字节为接口编号。
+  * @param  req: USB请求
+  * @retval 功能描述，未知接口或端点返回NULL
   */
-static void * USBD_CDC_FREE(void * p)
+static USBD_COM_FuncTypeDef * USBD_COM_FindReq(USBD_SetupReqTypedef *req)
 {
-	return NULL;
+	uint8_t itf = LOBYTE(req->wIndex);
+
+	if((req->bmRequest & USB_REQ_RECIPIENT_MASK) == USB_REQ_RECIPIENT_ENDPOINT)
+		return USBD_COM_FindEp(itf);
+
+	if((itf >= USBD_MAX_NUM_INTERFACES) || (USBD_COM_ItfMap[itf] == 0U))
+		return NULL;
+	return &USBD_COM_Func[USBD_COM_ItfMap[itf] - 1U];
 }
 
 /**
-  * @brief  USBD_MSC_FREE 释放MSC内存
-  * @retval 释放结果，若释放完成，则为NULL，否则为原地址
+  * @brief  USBD_COM_Bind 让设备实例的类句柄指向指定功能
+  * @note   MSC的BOT与SCSI层经pdev->pClassDataCmsit与pUserData取句柄，进入这些函数前需绑定；
+  *         句柄未变化时不重复写入。CDC等功能直接使用功能描述中的句柄，不需要绑定。
   */
-static void * USBD_MSC_FREE(void * p)
+static inline void USBD_COM_Bind(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
 {
-	return NULL;
+	if((pdev->pClassDataCmsit[pdev->classId] != func->Handle) || (pdev->pUserData[pdev->classId] != func->Fops))
+	{
+		pdev->pUserData[pdev->classId] = func->Fops;
+		pdev->pClassDataCmsit[pdev->classId] = func->Handle;
+	}
 }
 
 /**
-  * @brief  USBD_COMPOSITE_Init 初始化CDC与MSC接口
+  * @brief  USBD_COMPOSITE_Init 初始化功能表中的全部功能
   * @note   当设备收到设置配置请求时，会调用此回调；在此函数中类接口使用的端点打开。
-  * @param  pdev: 设备的实例
+  * @param  pDev: 设备的实例
   * @param  cfgidx: 配置指标
   * @retval 状态
   */
- static uint8_t USBD_COMPOSITE_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
- {
+static uint8_t USBD_COMPOSITE_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
 	UNUSED(cfgidx);
 
-	/* 获取类数据句柄 */
-	USBD_CDC_HandleTypeDef *hcdc = USBD_CDC_MALLOC();
-	USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_MALLOC();
+	uint8_t i;
+	uint8_t ret;
+
+	USBD_COM_BuildMap();
+
+	for(i = 0U; i < COM_FUNC_NUM; i++)
+	{
+		if(!COM_FUNC_ACTIVE(i))
+			continue;
+		ret = USBD_COM_Func[i].Init(pdev, &USBD_COM_Func[i]);
+		if(ret != (uint8_t)USBD_OK)
+			return ret;
+	}
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_DeInit 去初始化COMPOSITE层
+  * @note   当收到清除配置请求时，会调用此回调；此函数会关闭类接口使用的端点。
+  * @param  pdev: 设备实例
+  * @param  cfgidx: 配置指标
+  * @retval 状态
+  */
+static uint8_t USBD_COMPOSITE_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+	UNUSED(cfgidx);
+
+	uint8_t i;
+
+	for(i = 0U; i < COM_FUNC_NUM; i++)
+	{
+		if(COM_FUNC_ACTIVE(i))
+			(void)USBD_COM_Func[i].DeInit(pdev, &USBD_COM_Func[i]);
+	}
+
+	pdev->pClassDataCmsit[pdev->classId] = NULL;
+	pdev->pClassData = NULL;
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_Setup 把请求分派到接口或端点所属的功能
+  * @param  pdev: 设备实例
+  * @param  req: USB请求
+  * @retval 状态
+  */
+static uint8_t USBD_COMPOSITE_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+	USBD_COM_FuncTypeDef *func = USBD_COM_FindReq(req);
+
+	if(func == NULL)
+		return (uint8_t)USBD_FAIL;
+
+	return func->Setup(pdev, func, req);
+}
+
+/**
+  * @brief  USBD_COMPOSITE_DataIn 非控制输入端点发送的数据
+  * @param  pdev: 设备实例
+  * @param  epnum: 端点号
+  * @retval 状态
+  */
+static uint8_t USBD_COMPOSITE_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+	USBD_COM_FuncTypeDef *func = USBD_COM_FindEp(epnum | 0x80U);
+
+	if(func == NULL)
+		return (uint8_t)USBD_OK;
+
+	return func->DataIn(pdev, func, epnum);
+}
+
+/**
+  * @brief  USBD_COMPOSITE_DataOut 非控制输出端点接收的数据
+  * @param  pdev: 设备实例
+  * @param  epnum: 端点号
+  * @retval 状态
+  */
+static uint8_t USBD_COMPOSITE_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+	USBD_COM_FuncTypeDef *func = USBD_COM_FindEp(epnum & 0x0FU);
+
+	if(func == NULL)
+		return (uint8_t)USBD_OK;
+
+	return func->DataOut(pdev, func, epnum);
+}
+
+/**
+  * @brief  USBD_COMPOSITE_EP0_RxReady 处理EP0 Rx读事件
+  * @param  pdev: 设备的实例
+  * @retval 状态
+  */
+static uint8_t USBD_COMPOSITE_EP0_RxReady(USBD_HandleTypeDef *pdev)
+{
+	USBD_COM_FuncTypeDef *func = USBD_COM_FindReq(&pdev->request);
+
+	if((func == NULL) || (func->EP0_RxReady == NULL))
+		return (uint8_t)USBD_OK;
+
+	return func->EP0_RxReady(pdev, func);
+}
+
+/**
+  * @brief  USBD_COMPOSITE_SetMode 选择下次枚举使用的运行模式
+  * @note   描述符、功能表与FIFO规划都随模式变化，只能在USBD_DeInit之后、
+  *         USBD_Init之前调用，已配置时返回USBD_BUSY。
+  * @param  pdev: 设备实例
+  * @param  mode: COM_MODE_COMPOSITE或COM_MODE_MSC_ONLY
+  * @retval 状态
+  */
+uint8_t USBD_COMPOSITE_SetMode(USBD_HandleTypeDef *pdev, uint8_t mode)
+{
+	if(mode > COM_MODE_MSC_ONLY)
+		return (uint8_t)USBD_FAIL;
+	if(pdev->dev_state == USBD_STATE_CONFIGURED)
+		return (uint8_t)USBD_BUSY;
+
+	USBD_COM_Mode = mode;
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_GetMode 读取当前运行模式
+  * @retval COM_MODE_COMPOSITE或COM_MODE_MSC_ONLY
+  */
+uint8_t USBD_COMPOSITE_GetMode(void)
+{
+	return USBD_COM_Mode;
+}
+
+#if (COM_SOF_ENABLED == 1U)
+/* ---------------------------------------- SOF Function ---------------------------------------- */
+
+/* 高速时SOF按125us微帧到来，每8个微帧为一帧 */
+#define COM_SOF_MICROFRAMES								8U
+
+static USBD_COM_SofTaskTypeDef USBD_COM_SofTask[COM_SOF_TASK_NUM];
+static USBD_COM_SofStatsTypeDef USBD_COM_SofStats;
+static uint8_t USBD_COM_SofMicro;
+
+/**
+  * @brief  USBD_COMPOSITE_SOF 每帧采样统计并执行登记的帧任务
+  * @note   仅在已配置状态下由内核调用，运行于USB中断。
+  * @param  pdev: 设备实例
+  * @retval 状态
+  */
+static uint8_t USBD_COMPOSITE_SOF(USBD_HandleTypeDef *pdev)
+{
+	uint32_t frame;
+	uint8_t i;
+
+	if(pdev->dev_speed == USBD_SPEED_HIGH)
+	{
+		if(++USBD_COM_SofMicro < COM_SOF_MICROFRAMES)
+			return (uint8_t)USBD_OK;
+		USBD_COM_SofMicro = 0U;
+	}
+
+	frame = ++USBD_COM_SofStats.Frames;
+	/* 登记的帧任务都服务于CDC，MSC单独模式下只计帧数 */
+	if(USBD_COM_Mode != COM_MODE_COMPOSITE)
+		return (uint8_t)USBD_OK;
+
+	for(i = 0U; i < COM_CDC_INSTANCE_NUM; i++)
+	{
+		if(USBD_CDC_Handle[i].TxState != 0U)
+			USBD_COM_SofStats.CdcTxBusy[i]++;
+	}
+
+	for(i = 0U; i < COM_SOF_TASK_NUM; i++)
+	{
+		if(USBD_COM_SofTask[i] != NULL)
+			USBD_COM_SofTask[i](pdev, frame);
+	}
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_SofRegister 登记帧任务
+  * @note   同一任务重复登记只保留一份，任务一经登记不再移除。
+  * @param  task: 帧任务
+  * @retval USBD_OK，任务表已满时返回USBD_FAIL
+  */
+uint8_t USBD_COMPOSITE_SofRegister(USBD_COM_SofTaskTypeDef task)
+{
+	uint32_t primask;
+	uint8_t i, ret = (uint8_t)USBD_FAIL;
+
+	if(task == NULL)
+		return (uint8_t)USBD_FAIL;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	for(i = 0U; i < COM_SOF_TASK_NUM; i++)
+	{
+		if(USBD_COM_SofTask[i] == task)
+		{
+			ret = (uint8_t)USBD_OK;
+			break;
+		}
+		if(USBD_COM_SofTask[i] == NULL)
+		{
+			USBD_COM_SofTask[i] = task;
+			ret = (uint8_t)USBD_OK;
+			break;
+		}
+	}
+
+	__set_PRIMASK(primask);
+
+	return ret;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_GetSofStats 读取按帧采样的统计
+  * @param  stats: 统计的副本
+  */
+void USBD_COMPOSITE_GetSofStats(USBD_COM_SofStatsTypeDef *stats)
+{
+	uint32_t primask;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	*stats = USBD_COM_SofStats;
+	__set_PRIMASK(primask);
+}
+#endif /* COM_SOF_ENABLED */
+
+/* ---------------------------------------- CDC Function ---------------------------------------- */
+
+/**
+  * @brief  USBD_COM_CDC_Init 打开CDC实例的端点并初始化物理接口
+  * @param  pdev: 设备实例
+  * @param  func: 功能描述
+  * @retval 状态
+  */
+static uint8_t USBD_COM_CDC_Init(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
+{
+	USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef *)func->Handle;
+	uint8_t in = func->Ep[0], out = func->Ep[1], cmd = func->Ep[2];
+	uint8_t high = (pdev->dev_speed == USBD_SPEED_HIGH) ? 1U : 0U;
+	uint16_t pack_size = (high == 1U) ? COM_CDC_HS_DATA_PACK_SIZE : COM_CDC_FS_DATA_PACK_SIZE;
+
+	(void)USBD_memset(hcdc, 0, sizeof(USBD_CDC_HandleTypeDef));
+
+	/* Open EP IN */
+	(void)USBD_LL_OpenEP(pdev, in, USBD_EP_TYPE_BULK, pack_size);
+	pdev->ep_in[in & 0x0FU].is_used = 1U;
+	pdev->ep_in[in & 0x0FU].maxpacket = pack_size;
+
+	/* Open EP OUT */
+	(void)USBD_LL_OpenEP(pdev, out, USBD_EP_TYPE_BULK, pack_size);
+	pdev->ep_out[out & 0x0FU].is_used = 1U;
+	pdev->ep_out[out & 0x0FU].maxpacket = pack_size;
+
+	/* 为CDC CMD端点设置bInterval */
+	pdev->ep_in[cmd & 0x0FU].bInterval = (high == 1U) ? COM_CDC_HS_BINTERVAL : COM_CDC_FS_BINTERVAL;
+	/* Open Command IN EP */
+	(void)USBD_LL_OpenEP(pdev, cmd, USBD_EP_TYPE_INTR, COM_CDC_CMD_PACK_SIZE);
+	pdev->ep_in[cmd & 0x0FU].is_used = 1U;
+	pdev->ep_in[cmd & 0x0FU].maxpacket = COM_CDC_CMD_PACK_SIZE;
+
+	hcdc->RxBuffer = NULL;
+
+	/* 初始化物理接口 */
+	((USBD_CDC_ItfTypeDef *)func->Fops)->Init();
+
+	/* 初始化Xfer状态 */
+	hcdc->TxState = 0U;
+	hcdc->RxState = 0U;
+
+	if(hcdc->RxBuffer == NULL)
+		return (uint8_t)USBD_EMEM;
+
+	/* 准备Out端点以接收下一个数据包 */
+	(void)USBD_LL_PrepareReceive(pdev, out, hcdc->RxBuffer, pack_size);
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_COM_CDC_DeInit 关闭CDC实例的端点并去初始化物理接口
+  * @param  pdev: 设备实例
+  * @param  func: 功能描述
+  * @retval 状态
+  */
+static uint8_t USBD_COM_CDC_DeInit(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
+{
+	uint8_t in = func->Ep[0], out = func->Ep[1], cmd = func->Ep[2];
+
+	/* Close EP IN */
+	(void)USBD_LL_CloseEP(pdev, in);
+	pdev->ep_in[in & 0xFU].is_used = 0U;
+
+	/* Close EP OUT */
+	(void)USBD_LL_CloseEP(pdev, out);
+	pdev->ep_out[out & 0xFU].is_used = 0U;
+
+	/* Close Command IN EP */
+	(void)USBD_LL_CloseEP(pdev, cmd);
+	pdev->ep_in[cmd & 0xFU].is_used = 0U;
+	pdev->ep_in[cmd & 0xFU].bInterval = 0U;
+
+	/* 去初始化物理接口组件 */
+	((USBD_CDC_ItfTypeDef *)func->Fops)->DeInit();
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_COM_CDC_Setup 处理CDC实例的类请求与标准请求
+  * @param  pdev: 设备实例
+  * @param  func: 功能描述
+  * @param  req: USB请求
+  * @retval 状态
+  */
+static uint8_t USBD_COM_CDC_Setup(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, USBD_SetupReqTypedef *req)
+{
+	USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef *)func->Handle;
+	USBD_CDC_ItfTypeDef *fops = (USBD_CDC_ItfTypeDef *)func->Fops;
+	uint16_t len;
+	USBD_StatusTypeDef ret = USBD_OK;
+
+	switch (req->bmRequest & USB_REQ_TYPE_MASK)
+	{
+		case USB_REQ_TYPE_CLASS:
+			if (req->wLength != 0U)
+			{
+				if ((req->bmRequest & 0x80U) != 0U)
+				{
+					/* 封装应答可达整个数据缓冲，其余请求的应答不超过行编码长度；
+					   应用只填写实际发出的长度，不会越过数据缓冲 */
+					if (req->bRequest == CDC_GET_ENCAPSULATED_RESPONSE)
+						len = (uint16_t)MIN(sizeof(hcdc->data), req->wLength);
+					else
+						len = MIN(CDC_REQ_MAX_DATA_SIZE, req->wLength);
+					fops->Control(req->bRequest, (uint8_t *)hcdc->data, len);
+					(void)USBD_CtlSendData(pdev, (uint8_t *)hcdc->data, len);
+				}
+				else
+				{
+					hcdc->CmdOpCode = req->bRequest;
+					hcdc->CmdLength = (uint8_t)MIN(req->wLength, USB_MAX_EP0_SIZE);
+
+					(void)USBD_CtlPrepareRx(pdev, (uint8_t *)hcdc->data, hcdc->CmdLength);
+				}
+			}
+			else
+			{
+				fops->Control(req->bRequest, (uint8_t *)req, 0U);
+			}
+			break;
+
+		case USB_REQ_TYPE_STANDARD:
+			switch (req->bRequest)
+			{
+				case USB_REQ_GET_STATUS:
+					if (pdev->dev_state == USBD_STATE_CONFIGURED)
+						(void)USBD_CtlSendData(pdev, (uint8_t *)&USBD_COM_ZeroReply, 2U);
+					else
+					{
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
+					}
+					break;
+
+				case USB_REQ_GET_INTERFACE:
+					if (pdev->dev_state == USBD_STATE_CONFIGURED)
+					{
+						(void)USBD_CtlSendData(pdev, (uint8_t *)&USBD_COM_ZeroReply, 1U);
+					}
+					else
+					{
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
+					}
+					break;
+
+				case USB_REQ_SET_INTERFACE:
+					if (pdev->dev_state != USBD_STATE_CONFIGURED)
+					{
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
+					}
+					break;
+
+				case USB_REQ_CLEAR_FEATURE:
+					break;
+
+				default:
+					USBD_CtlError(pdev, req);
+					ret = USBD_FAIL;
+					break;
+			}
+			break;
+
+		default:
+			USBD_CtlError(pdev, req);
+			ret = USBD_FAIL;
+			break;
+	}
+
+	return (uint8_t)ret;
+}
+
+/**
+  * @brief  USBD_COM_CDC_EP0_RxReady 类请求数据阶段完成，交给物理接口处理
+  * @param  pdev: 设备实例
+  * @param  func: 功能描述
+  * @retval 状态
+  */
+static uint8_t USBD_COM_CDC_EP0_RxReady(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
+{
+	USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef *)func->Handle;
+
+	UNUSED(pdev);
+
+	if((func->Fops != NULL) && (hcdc->CmdOpCode != 0xFFU))
+	{
+		((USBD_CDC_ItfTypeDef *)func->Fops)->Control(hcdc->CmdOpCode, (uint8_t *)hcdc->data, (uint16_t)hcdc->CmdLength);
+		hcdc->CmdOpCode = 0xFFU;
+	}
+
+	return (uint8_t)USBD_OK;
+}
+
+#if (USBD_DMA_ENABLED == 1U)
+/**
+  * @brief  USBD_COM_CDC_TxBounce 把未对齐发送缓冲的下一段复制到中转缓冲并发送
+  * @note   除最后一段外每段都是整包，主机看到的包序列与直接发送相同。
+  * @param  pdev: 设备实例
+  * @param  hcdc: CDC句柄
+  * @param  in: 输入端点地址
+  */
+static void USBD_COM_CDC_TxBounce(USBD_HandleTypeDef *pdev, USBD_CDC_HandleTypeDef *hcdc, uint8_t in)
+{
+	uint32_t len = MIN(hcdc->TxLength - hcdc->TxOffset, sizeof(hcdc->TxBounce));
+
+	(void)USBD_memcpy(hcdc->TxBounce, hcdc->TxBuffer + hcdc->TxOffset, len);
+	hcdc->TxOffset += len;
+	(void)USBD_LL_Transmit(pdev, in, (uint8_t *)hcdc->TxBounce, len);
+}
+#endif /* USBD_DMA_ENABLED */
+
+/**
+  * @brief  USBD_COM_CDC_DataIn CDC数据输入端点发送完成
+  * @note   命令端点没有发送完成处理。
+  * @param  pdev: 设备实例
+  * @param  func: 功能描述
+  * @param  epnum: 端点号
+  * @retval 状态
+  */
+static uint8_t USBD_COM_CDC_DataIn(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum)
+{
+	USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef *)func->Handle;
+	USBD_CDC_ItfTypeDef *fops = (USBD_CDC_ItfTypeDef *)func->Fops;
+	PCD_HandleTypeDef *hpcd = (PCD_HandleTypeDef *)pdev->pData;
+
+	if ((epnum | 0x80U) != func->Ep[0])
+		return (uint8_t)USBD_OK;
+
+#if (USBD_DMA_ENABLED == 1U)
+	if (hcdc->TxOffset < hcdc->TxLength)
+	{
+		USBD_COM_CDC_TxBounce(pdev, hcdc, func->Ep[0]);
+		return (uint8_t)USBD_OK;
+	}
+#endif /* USBD_DMA_ENABLED */
+
+	if ((pdev->ep_in[epnum & 0xFU].total_length > 0U) && ((pdev->ep_in[epnum & 0xFU].total_length % hpcd->IN_ep[epnum & 0xFU].maxpacket) == 0U))
+	{
+		/* 更新数据包总长度 */
+		pdev->ep_in[epnum & 0xFU].total_length = 0U;
+
+		/* 发送ZLP */
+		(void)USBD_LL_Transmit(pdev, epnum, NULL, 0U);
+	}
+	else
+	{
+		hcdc->TxState = 0U;
+
+		if (fops->TransmitCplt != NULL)
+			fops->TransmitCplt(hcdc->TxBuffer, &hcdc->TxLength, epnum);
+	}
+
+	return (uint8_t)USBD_OK;
+}
 
-	/* ------------------------------------- CDC Init ------------------------------------- */
-	/* 判断申请是否成功，用于动态申请 */
-	if(hcdc == NULL)
-	{
-		pdev->pClassDataCmsit[pdev->classId] = NULL;
-		return (uint8_t)USBD_EMEM;
-	}
-	(void)USBD_memset(hcdc, 0, sizeof(USBD_CDC_HandleTypeDef));
-	/* 转换操作句柄与数据句柄 */
-	pdev->pUserData[pdev->classId] = &USBD_CDC_Interface_fops_FS;
-	pdev->pClassDataCmsit[pdev->classId] = (void *)hcdc;
-	pdev->pClassData = pdev->pClassDataCmsit[pdev->classId];
-	/* Open EP IN */
-	(void)USBD_LL_OpenEP(pdev, COM_CDC_IN_EP, USBD_EP_TYPE_BULK, COM_CDC_DATA_MAX_PACK_SIZE);
-	pdev->ep_in[COM_CDC_IN_EP & 0x0FU].is_used = 1U;
-	pdev->ep_in[COM_CDC_IN_EP & 0x0FU].maxpacket = COM_CDC_DATA_MAX_PACK_SIZE;
+/**
+  * @brief  USBD_COM_CDC_DataOut CDC数据输出端点收到数据
+  * @param  pdev: 设备实例
+  * @param  func: 功能描述
+  * @param  epnum: 端点号
+  * @retval 状态
+  */
+static uint8_t USBD_COM_CDC_DataOut(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum)
+{
+	USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef *)func->Handle;
 
-	/* Open EP OUT */
-	(void)USBD_LL_OpenEP(pdev, COM_CDC_OUT_EP, USBD_EP_TYPE_BULK, COM_CDC_DATA_MAX_PACK_SIZE);
-	pdev->ep_out[COM_CDC_OUT_EP & 0x0FU].is_used = 1U;
-	pdev->ep_out[COM_CDC_OUT_EP & 0x0FU].maxpacket = COM_CDC_DATA_MAX_PACK_SIZE;
+	/* 获取接收的数据长度 */
+	hcdc->RxLength = USBD_LL_GetRxDataSize(pdev, epnum);
 
-	/* 为CDC CMD端点设置bInterval */
-	pdev->ep_in[COM_CDC_CMD_EP & 0x0FU].bInterval = COM_CDC_FS_BINTERVAL;
-	/* Open Command IN EP */
-	(void)USBD_LL_OpenEP(pdev, COM_CDC_CMD_EP, USBD_EP_TYPE_INTR, COM_CDC_CMD_PACK_SIZE);
-	pdev->ep_in[COM_CDC_CMD_EP & 0x0FU].is_used = 1U;
-	pdev->ep_in[COM_CDC_CMD_EP & 0x0FU].maxpacket = COM_CDC_CMD_PACK_SIZE;
+	/* USB数据将被立即处理，这允许下一个USB流量被裸直到应用程序Xfer结束 */
+	((USBD_CDC_ItfTypeDef *)func->Fops)->Receive(hcdc->RxBuffer, &hcdc->RxLength);
 
-	hcdc->RxBuffer = NULL;
+	return (uint8_t)USBD_OK;
+}
 
-	/* 初始化物理接口 */
-	((USBD_CDC_ItfTypeDef *)pdev->pUserData[pdev->classId])->Init();
+/* ---------------------------------------- MSC Function ---------------------------------------- */
 
-	/* 初始化Xfer状态 */
-	hcdc->TxState = 0U;
-	hcdc->RxState = 0U;
+/**
+  * @brief  USBD_COM_MSC_Init 打开MSC的端点并初始化BOT层
+  * @param  pdev: 设备实例
+  * @param  func: 功能描述
+  * @retval 状态
+  */
+static uint8_t USBD_COM_MSC_Init(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
+{
+	uint16_t pack_size = (pdev->dev_speed == USBD_SPEED_HIGH) ? COM_MSC_HS_DATA_PACK_SIZE : COM_MSC_FS_DATA_PACK_SIZE;
 
-	if(hcdc->RxBuffer == NULL)
-	{
-		return (uint8_t)USBD_EMEM;
-	}
-	/* 准备Out端点以接收下一个数据包 */
-    (void)USBD_LL_PrepareReceive(pdev, COM_CDC_OUT_EP, hcdc->RxBuffer, COM_CDC_DATA_MAX_PACK_SIZE);
+	USBD_COM_Bind(pdev, func);
+	pdev->pClassData = func->Handle;
 
-	/* ------------------------------------- MSC Init ------------------------------------- */
-	/* 判断申请是否成功，用于动态申请 */
-	if(hmsc == NULL)
-	{
-		pdev->pClassDataCmsit[pdev->classId] = NULL;
-		return (uint8_t)USBD_EMEM;
-	}
-	/* 转换操作句柄与数据句柄 */
-	pdev->pUserData[pdev->classId] = &USBD_MSC_Interface_fops_FS;
-	pdev->pClassDataCmsit[pdev->classId] = (void *)hmsc;
-	pdev->pClassData = pdev->pClassDataCmsit[pdev->classId];
 	/* Open EP IN*/
-	(void)USBD_LL_OpenEP(pdev, COM_MSC_IN_EP, USBD_EP_TYPE_BULK, COM_MSC_DATA_MAX_PACK_SIZE);
+	(void)USBD_LL_OpenEP(pdev, COM_MSC_IN_EP, USBD_EP_TYPE_BULK, pack_size);
 	pdev->ep_in[COM_MSC_IN_EP & 0x0FU].is_used = 1U;
-	pdev->ep_in[COM_MSC_IN_EP & 0x0FU].maxpacket = COM_MSC_DATA_MAX_PACK_SIZE;
+	pdev->ep_in[COM_MSC_IN_EP & 0x0FU].maxpacket = pack_size;
 
 	/* Open EP OUT */
-	(void)USBD_LL_OpenEP(pdev, COM_MSC_OUT_EP, USBD_EP_TYPE_BULK, COM_MSC_DATA_MAX_PACK_SIZE);
+	(void)USBD_LL_OpenEP(pdev, COM_MSC_OUT_EP, USBD_EP_TYPE_BULK, pack_size);
 	pdev->ep_out[COM_MSC_OUT_EP & 0x0FU].is_used = 1U;
-	pdev->ep_out[COM_MSC_OUT_EP & 0x0FU].maxpacket = COM_MSC_DATA_MAX_PACK_SIZE;
+	pdev->ep_out[COM_MSC_OUT_EP & 0x0FU].maxpacket = pack_size;
 
 	/* 初始化BOT层 */
 	MSC_BOT_Init(pdev);
 
 	return (uint8_t)USBD_OK;
- }
+}
 
- /**
-  * @brief  USBD_COMPOSITE_DeInit 去初始化COMPOSITE层
-  * @note   当收到清除配置请求时，会调用此回调；此函数会关闭类接口使用的端点。
+/**
+  * @brief  USBD_COM_MSC_DeInit 关闭MSC的端点并去初始化BOT层
   * @param  pdev: 设备实例
-  * @param  cfgidx: 配置指标
+  * @param  func: 功能描述
   * @retval 状态
   */
-static uint8_t USBD_COMPOSITE_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+static uint8_t USBD_COM_MSC_DeInit(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
 {
-	UNUSED(cfgidx);
-
-	/* 获取类数据句柄 */
-	USBD_CDC_HandleTypeDef *hcdc = USBD_CDC_MALLOC();
-	USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_MALLOC();
-
-	/* ------------------------------------ CDC DeInit ------------------------------------ */
-	/* 转换操作句柄与数据句柄 */
-	pdev->pUserData[pdev->classId] = &USBD_CDC_Interface_fops_FS;
-	pdev->pClassDataCmsit[pdev->classId] = (void *)hcdc;
-	
-	/* Malloc检查 */
-	if (pdev->pClassDataCmsit[pdev->classId] == NULL)
-		return (uint8_t)USBD_FAIL;
-
-	/* Close EP IN */
-	(void)USBD_LL_CloseEP(pdev, COM_CDC_IN_EP);
-	pdev->ep_in[COM_CDC_IN_EP & 0xFU].is_used = 0U;
-
-	/* Close EP OUT */
-	(void)USBD_LL_CloseEP(pdev, COM_CDC_OUT_EP);
-	pdev->ep_out[COM_CDC_OUT_EP & 0xFU].is_used = 0U;
-
-	/* Close Command IN EP */
-	(void)USBD_LL_CloseEP(pdev, COM_CDC_CMD_EP);
-	pdev->ep_in[COM_CDC_CMD_EP & 0xFU].is_used = 0U;
-	pdev->ep_in[COM_CDC_CMD_EP & 0xFU].bInterval = 0U;
-
-	/* 去初始化物理接口组件 */
-	if (pdev->pClassDataCmsit[pdev->classId] != NULL)
-	{
-		((USBD_CDC_ItfTypeDef *)pdev->pUserData[pdev->classId])->DeInit();
-		(void)USBD_CDC_FREE(pdev->pClassDataCmsit[pdev->classId]);
-		pdev->pClassDataCmsit[pdev->classId] = NULL;
-		pdev->pClassData = NULL;
-	}
-
-	/* ------------------------------------ MSC DeInit ------------------------------------ */
-	/* 转换操作句柄与数据句柄 */
-	pdev->pUserData[pdev->classId] = &USBD_MSC_Interface_fops_FS;
-	pdev->pClassDataCmsit[pdev->classId] = (void *)hmsc;
-
-	/* Malloc检查 */
-	if (pdev->pClassDataCmsit[pdev->classId] == NULL)
-		return (uint8_t)USBD_FAIL;
+	USBD_COM_Bind(pdev, func);
 
 	/* Close EP IN */
 	(void)USBD_LL_CloseEP(pdev, COM_MSC_IN_EP);
-	pdev->ep_out[COM_MSC_IN_EP & 0xFU].is_used = 0U;
+	pdev->ep_in[COM_MSC_IN_EP & 0xFU].is_used = 0U;
 
 	/* Close EP OUT */
 	(void)USBD_LL_CloseEP(pdev, COM_MSC_OUT_EP);
-	pdev->ep_in[COM_MSC_OUT_EP & 0xFU].is_used = 0U;
+	pdev->ep_out[COM_MSC_OUT_EP & 0xFU].is_used = 0U;
+
+	/* 去初始化BOT层 */
+	MSC_BOT_DeInit(pdev);
 
-	/* 释放MSC类资源 */
-	if (pdev->pClassDataCmsit[pdev->classId] != NULL)
-	{
-		/* 去初始化BOT层 */
-		MSC_BOT_DeInit(pdev);
-		(void)USBD_MSC_FREE(pdev->pClassDataCmsit[pdev->classId]);
-		pdev->pClassDataCmsit[pdev->classId]  = NULL;
-		pdev->pClassData = NULL;
-	}
-	
 	return (uint8_t)USBD_OK;
 }
 
 /**
-  * @brief  USBD_COMPOSITE_Setup 处理COMPOSITE特定的请求
-  * @note   调用此回调可处理特定类设置请求。
+  * @brief  USBD_COM_MSC_Setup 处理MSC的类请求与标准请求
   * @param  pdev: 设备实例
+  * @param  func: 功能描述
   * @param  req: USB请求
   * @retval 状态
   */
-static uint8_t USBD_COMPOSITE_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+static uint8_t USBD_COM_MSC_Setup(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, USBD_SetupReqTypedef *req)
 {
-	/* 获取类数据句柄 */
-	USBD_CDC_HandleTypeDef *hcdc = USBD_CDC_MALLOC();
-	USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_MALLOC();
-	
-	uint16_t len;
-	uint8_t ifalt = 0U;
-	uint16_t status_info = 0U;
+	USBD_MSC_BOT_HandleTypeDef *hmsc = (USBD_MSC_BOT_HandleTypeDef *)func->Handle;
 	USBD_StatusTypeDef ret = USBD_OK;
-	/* wIndex是接口编号 */
-	switch(req->wIndex)
+
+	USBD_COM_Bind(pdev, func);
+
+	switch (req->bmRequest & USB_REQ_TYPE_MASK)
 	{
-		/* 第一个IAD组 */
-		case 0:
-		case 1:
-			/* 转换操作句柄与数据句柄 */
-			pdev->pUserData[pdev->classId] = &USBD_CDC_Interface_fops_FS;
-			pdev->pClassDataCmsit[pdev->classId] = (void *)hcdc;
-			/* Malloc检查 */
-			if (hmsc == NULL)
-				return (uint8_t)USBD_FAIL;
-
-			switch (req->bmRequest & USB_REQ_TYPE_MASK)
+		/* Class request */
+		case USB_REQ_TYPE_CLASS:
+			switch (req->bRequest)
 			{
-				case USB_REQ_TYPE_CLASS:
-					if (req->wLength != 0U)
+				case BOT_GET_MAX_LUN:
+					if ((req->wValue  == 0U) && (req->wLength == 1U) && ((req->bmRequest & 0x80U) == 0x80U))
 					{
-						if ((req->bmRequest & 0x80U) != 0U)
-						{
-							((USBD_CDC_ItfTypeDef *)pdev->pUserData[pdev->classId])->Control(req->bRequest, (uint8_t *)hcdc->data, req->wLength);
-
-							len = MIN(CDC_REQ_MAX_DATA_SIZE, req->wLength);
-							(void)USBD_CtlSendData(pdev, (uint8_t *)hcdc->data, len);
-						}
-						else
-						{
-							hcdc->CmdOpCode = req->bRequest;
-							hcdc->CmdLength = (uint8_t)MIN(req->wLength, USB_MAX_EP0_SIZE);
-
-							(void)USBD_CtlPrepareRx(pdev, (uint8_t *)hcdc->data, hcdc->CmdLength);
-						}
+						hmsc->max_lun = (uint32_t)((USBD_StorageTypeDef *)func->Fops)->GetMaxLun();
+						(void)USBD_CtlSendData(pdev, (uint8_t *)&hmsc->max_lun, 1U);
 					}
 					else
 					{
-						((USBD_CDC_ItfTypeDef *)pdev->pUserData[pdev->classId])->Control(req->bRequest,
-																						(uint8_t *)req, 0U);
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
 					}
 					break;
 
-				case USB_REQ_TYPE_STANDARD:
-					switch (req->bRequest)
+				case BOT_RESET :
+					if ((req->wValue  == 0U) && (req->wLength == 0U) && ((req->bmRequest & 0x80U) != 0x80U))
+						MSC_BOT_Reset(pdev);
+					else
 					{
-						case USB_REQ_GET_STATUS:
-							if (pdev->dev_state == USBD_STATE_CONFIGURED)
-								(void)USBD_CtlSendData(pdev, (uint8_t *)&status_info, 2U);
-							else
-							{
-								USBD_CtlError(pdev, req);
-								ret = USBD_FAIL;
-							}
-							break;
-
-						case USB_REQ_GET_INTERFACE:
-							if (pdev->dev_state == USBD_STATE_CONFIGURED)
-							{
-								(void)USBD_CtlSendData(pdev, &ifalt, 1U);
-							}
-							else
-							{
-								USBD_CtlError(pdev, req);
-								ret = USBD_FAIL;
-							}
-							break;
-
-						case USB_REQ_SET_INTERFACE:
-							if (pdev->dev_state != USBD_STATE_CONFIGURED)
-							{
-								USBD_CtlError(pdev, req);
-								ret = USBD_FAIL;
-							}
-							break;
-
-						case USB_REQ_CLEAR_FEATURE:
-							break;
-
-						default:
-							USBD_CtlError(pdev, req);
-							ret = USBD_FAIL;
-							break;
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
 					}
 					break;
 
@@ -602,104 +1186,55 @@ static uint8_t USBD_COMPOSITE_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTyped
 					ret = USBD_FAIL;
 					break;
 			}
-
-			return (uint8_t)ret;
-		/* 第二个IAD组 */
-		case 2:
-			/* 转换操作句柄与数据句柄 */
-			pdev->pUserData[pdev->classId] = &USBD_MSC_Interface_fops_FS;
-			pdev->pClassDataCmsit[pdev->classId] = (void *)hmsc;
-			/* Malloc检查 */
-			if (hmsc == NULL)
-				return (uint8_t)USBD_FAIL;
-
-			switch (req->bmRequest & USB_REQ_TYPE_MASK)
+			break;
+		/* Interface & Endpoint request */
+		case USB_REQ_TYPE_STANDARD:
+			switch (req->bRequest)
 			{
-				/* Class request */
-				case USB_REQ_TYPE_CLASS:
-					switch (req->bRequest)
+				case USB_REQ_GET_STATUS:
+					if (pdev->dev_state == USBD_STATE_CONFIGURED)
+						(void)USBD_CtlSendData(pdev, (uint8_t *)&USBD_COM_ZeroReply, 2U);
+					else
+					{
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
+					}
+					break;
+
+				case USB_REQ_GET_INTERFACE:
+					if (pdev->dev_state == USBD_STATE_CONFIGURED)
+					{
+						USBD_COM_MscAltReply = hmsc->interface;
+						(void)USBD_CtlSendData(pdev, (uint8_t *)&USBD_COM_MscAltReply, 1U);
+					}
+					else
+					{
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
+					}
+					break;
+
+				case USB_REQ_SET_INTERFACE:
+					if (pdev->dev_state == USBD_STATE_CONFIGURED)
+						hmsc->interface = (uint8_t)(req->wValue);
+					else
 					{
-						case BOT_GET_MAX_LUN:
-							if ((req->wValue  == 0U) && (req->wLength == 1U) && ((req->bmRequest & 0x80U) == 0x80U))
-							{
-								hmsc->max_lun = (uint32_t)((USBD_StorageTypeDef *)pdev->pUserData[pdev->classId])->GetMaxLun();
-								(void)USBD_CtlSendData(pdev, (uint8_t *)&hmsc->max_lun, 1U);
-							}
-							else
-							{
-								USBD_CtlError(pdev, req);
-								ret = USBD_FAIL;
-							}
-							break;
-
-						case BOT_RESET :
-							if ((req->wValue  == 0U) && (req->wLength == 0U) && ((req->bmRequest & 0x80U) != 0x80U))
-								MSC_BOT_Reset(pdev);
-							else
-							{
-								USBD_CtlError(pdev, req);
-								ret = USBD_FAIL;
-							}
-							break;
-
-						default:
-							USBD_CtlError(pdev, req);
-							ret = USBD_FAIL;
-							break;
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
 					}
 					break;
-				/* Interface & Endpoint request */
-				case USB_REQ_TYPE_STANDARD:
-					switch (req->bRequest)
+
+				case USB_REQ_CLEAR_FEATURE:
+					if (pdev->dev_state == USBD_STATE_CONFIGURED)
 					{
-						case USB_REQ_GET_STATUS:
-							if (pdev->dev_state == USBD_STATE_CONFIGURED)
-								(void)USBD_CtlSendData(pdev, (uint8_t *)&status_info, 2U);
-							else
-							{
-								USBD_CtlError(pdev, req);
-								ret = USBD_FAIL;
-							}
-							break;
-
-						case USB_REQ_GET_INTERFACE:
-							if (pdev->dev_state == USBD_STATE_CONFIGURED)
-								(void)USBD_CtlSendData(pdev, (uint8_t *)&hmsc->interface, 1U);
-							else
-							{
-								USBD_CtlError(pdev, req);
-								ret = USBD_FAIL;
-							}
-							break;
-
-						case USB_REQ_SET_INTERFACE:
-							if (pdev->dev_state == USBD_STATE_CONFIGURED)
-								hmsc->interface = (uint8_t)(req->wValue);
-							else
-							{
-								USBD_CtlError(pdev, req);
-								ret = USBD_FAIL;
-							}
-							break;
-
-						case USB_REQ_CLEAR_FEATURE:
-							if (pdev->dev_state == USBD_STATE_CONFIGURED)
-							{
-								if (req->wValue == USB_FEATURE_EP_HALT)
-								{
-									/* Flush the FIFO */
-									(void)USBD_LL_FlushEP(pdev, (uint8_t)req->wIndex);
-
-									/* Handle BOT error */
-									MSC_BOT_CplClrFeature(pdev, (uint8_t)req->wIndex);
-								}
-							}
-							break;
-
-						default:
-							USBD_CtlError(pdev, req);
-							ret = USBD_FAIL;
-							break;
+						if (req->wValue == USB_FEATURE_EP_HALT)
+						{
+							/* Flush the FIFO */
+							(void)USBD_LL_FlushEP(pdev, (uint8_t)req->wIndex);
+
+							/* Handle BOT error */
+							MSC_BOT_CplClrFeature(pdev, (uint8_t)req->wIndex);
+						}
 					}
 					break;
 
@@ -708,159 +1243,206 @@ static uint8_t USBD_COMPOSITE_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTyped
 					ret = USBD_FAIL;
 					break;
 			}
+			break;
 
-			return (uint8_t)ret;
 		default:
-			return USBD_FAIL;
+			USBD_CtlError(pdev, req);
+			ret = USBD_FAIL;
+			break;
 	}
+
+	return (uint8_t)ret;
 }
 
 /**
-  * @brief  USBD_COMPOSITE_DataIn 非控制输入端点发送的数据
+  * @brief  USBD_COM_MSC_DataIn MSC输入端点发送完成
   * @param  pdev: 设备实例
+  * @param  func: 功能描述
   * @param  epnum: 端点号
   * @retval 状态
   */
-static uint8_t USBD_COMPOSITE_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+static uint8_t USBD_COM_MSC_DataIn(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum)
 {
-	/* 获取类数据句柄 */
-	USBD_CDC_HandleTypeDef *hcdc = USBD_CDC_MALLOC();
-	USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_MALLOC();
-	
-	switch(epnum | 0x80)
-	{
-		case COM_CDC_IN_EP:
-			/* 转换操作句柄与数据句柄 */
-			pdev->pUserData[pdev->classId] = &USBD_CDC_Interface_fops_FS;
-			pdev->pClassDataCmsit[pdev->classId] = (void *)hcdc;
-			
-			PCD_HandleTypeDef *hpcd = (PCD_HandleTypeDef *)pdev->pData;
-			/* Malloc检查 */
-			if (pdev->pClassDataCmsit[pdev->classId] == NULL)
-				return (uint8_t)USBD_FAIL;
-
-			if ((pdev->ep_in[epnum & 0xFU].total_length > 0U) && ((pdev->ep_in[epnum & 0xFU].total_length % hpcd->IN_ep[epnum & 0xFU].maxpacket) == 0U))
-			{
-				/* 更新数据包总长度 */
-				pdev->ep_in[epnum & 0xFU].total_length = 0U;
-
-				/* 发送ZLP */
-				(void)USBD_LL_Transmit(pdev, epnum, NULL, 0U);
-			}
-			else
-			{
-				hcdc->TxState = 0U;
-
-				if (((USBD_CDC_ItfTypeDef *)pdev->pUserData[pdev->classId])->TransmitCplt != NULL)
-					((USBD_CDC_ItfTypeDef *)pdev->pUserData[pdev->classId])->TransmitCplt(hcdc->TxBuffer, &hcdc->TxLength, epnum);
-			}
-
-			break;
-
-		case COM_MSC_IN_EP:
-			/* 转换操作句柄与数据句柄 */
-			pdev->pUserData[pdev->classId] = &USBD_MSC_Interface_fops_FS;
-			pdev->pClassDataCmsit[pdev->classId] = (void *)hmsc;
-			
-			/* Malloc检查 */
-			if (pdev->pClassDataCmsit[pdev->classId] == NULL)
-				return (uint8_t)USBD_FAIL;
+	USBD_COM_Bind(pdev, func);
+	MSC_BOT_DataIn(pdev, epnum);
 
-			MSC_BOT_DataIn(pdev, epnum);
-			break;
-	}
-
-  return (uint8_t)USBD_OK;
+	return (uint8_t)USBD_OK;
 }
 
 /**
-  * @brief  USBD_COMPOSITE_DataOut 非控制输出端点接收的数据
+  * @brief  USBD_COM_MSC_DataOut MSC输出端点收到数据
   * @param  pdev: 设备实例
+  * @param  func: 功能描述
   * @param  epnum: 端点号
   * @retval 状态
   */
-static uint8_t USBD_COMPOSITE_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+static uint8_t USBD_COM_MSC_DataOut(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum)
 {
-	/* 获取类数据句柄 */
-	USBD_CDC_HandleTypeDef *hcdc = USBD_CDC_MALLOC();
-	USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_MALLOC();
-	
-	switch(epnum)
-	{
-		case COM_CDC_OUT_EP:
-			/* 转换操作句柄与数据句柄 */
-			pdev->pUserData[pdev->classId] = &USBD_CDC_Interface_fops_FS;
-			pdev->pClassDataCmsit[pdev->classId] = (void *)hcdc;
+	USBD_COM_Bind(pdev, func);
+	MSC_BOT_DataOut(pdev, epnum);
 
-			/* Malloc检查 */
-			if (pdev->pClassDataCmsit[pdev->classId] == NULL)
-				return (uint8_t)USBD_FAIL;
+	return (uint8_t)USBD_OK;
+}
 
-			/* 获取接收的数据长度 */
-			hcdc->RxLength = USBD_LL_GetRxDataSize(pdev, epnum);
+#if (COM_NCM_ENABLED == 1U)
+/* ---------------------------------------- NCM Function ---------------------------------------- */
 
-			/* USB数据将被立即处理，这允许下一个USB流量被裸直到应用程序Xfer结束 */
-			((USBD_CDC_ItfTypeDef *)pdev->pUserData[pdev->classId])->Receive(hcdc->RxBuffer, &hcdc->RxLength);
+/* NCM与厂商接口自行管理句柄，以下只做签名转换 */
+static uint8_t USBD_COM_NCM_Init(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
+{
+	UNUSED(func);
+	return USBD_NCM_Init(pdev);
+}
 
-			break;
+static uint8_t USBD_COM_NCM_DeInit(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
+{
+	UNUSED(func);
+	return USBD_NCM_DeInit(pdev);
+}
 
-		case COM_MSC_OUT_EP:
-			/* 转换操作句柄与数据句柄 */
-			pdev->pUserData[pdev->classId] = &USBD_MSC_Interface_fops_FS;
-			pdev->pClassDataCmsit[pdev->classId] = (void *)hmsc;
+static uint8_t USBD_COM_NCM_Setup(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, USBD_SetupReqTypedef *req)
+{
+	UNUSED(func);
+	return USBD_NCM_Setup(pdev, req);
+}
 
-			/* Malloc检查 */
-			if (pdev->pClassDataCmsit[pdev->classId] == NULL)
-				return (uint8_t)USBD_FAIL;
-			
-			MSC_BOT_DataOut(pdev, epnum);
-			break;
-	}
+static uint8_t USBD_COM_NCM_EP0_RxReady(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
+{
+	UNUSED(func);
+	return USBD_NCM_EP0_RxReady(pdev);
+}
 
-	return (uint8_t)USBD_OK;
+static uint8_t USBD_COM_NCM_DataIn(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum)
+{
+	UNUSED(func);
+	return USBD_NCM_DataIn(pdev, epnum);
+}
+
+static uint8_t USBD_COM_NCM_DataOut(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum)
+{
+	UNUSED(func);
+	return USBD_NCM_DataOut(pdev, epnum);
+}
+#endif /* COM_NCM_ENABLED */
+
+#if (COM_VENDOR_ENABLED == 1U)
+/* -------------------------------------- Vendor Function --------------------------------------- */
+
+static uint8_t USBD_COM_VENDOR_Init(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
+{
+	UNUSED(func);
+	return USBD_VENDOR_Init(pdev);
+}
+
+static uint8_t USBD_COM_VENDOR_DeInit(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
+{
+	UNUSED(func);
+	return USBD_VENDOR_DeInit(pdev);
+}
+
+static uint8_t USBD_COM_VENDOR_Setup(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, USBD_SetupReqTypedef *req)
+{
+	UNUSED(func);
+	return USBD_VENDOR_Setup(pdev, req);
+}
+
+static uint8_t USBD_COM_VENDOR_DataIn(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum)
+{
+	UNUSED(func);
+	return USBD_VENDOR_DataIn(pdev, epnum);
+}
+
+static uint8_t USBD_COM_VENDOR_DataOut(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum)
+{
+	UNUSED(func);
+	return USBD_VENDOR_DataOut(pdev, epnum);
+}
+#endif /* COM_VENDOR_ENABLED */
+
+#if (COM_ISO_ENABLED == 1U)
+/* ---------------------------------------- ISO Function ---------------------------------------- */
+
+static uint8_t USBD_COM_ISO_Init(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
+{
+	UNUSED(func);
+	return USBD_ISO_Init(pdev);
+}
+
+static uint8_t USBD_COM_ISO_DeInit(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
+{
+	UNUSED(func);
+	return USBD_ISO_DeInit(pdev);
+}
+
+static uint8_t USBD_COM_ISO_Setup(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, USBD_SetupReqTypedef *req)
+{
+	UNUSED(func);
+	return USBD_ISO_Setup(pdev, req);
+}
+
+static uint8_t USBD_COM_ISO_DataIn(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum)
+{
+	UNUSED(func);
+	return USBD_ISO_DataIn(pdev, epnum);
 }
 
 /**
-  * @brief  USBD_COMPOSITE_EP0_RxReady 处理EP0 Rx读事件
-  * @param  pdev: 设备的实例
+  * @brief  USBD_COMPOSITE_IsoINIncomplete 同步输入端点本帧的包未被取走
+  * @note   部分HAL版本传入的端点号不可靠，复合设备中只有一个同步端点，直接交给同步数据流。
+  * @param  pdev: 设备实例
+  * @param  epnum: 端点号
   * @retval 状态
   */
-static uint8_t USBD_COMPOSITE_EP0_RxReady(USBD_HandleTypeDef *pdev)
+static uint8_t USBD_COMPOSITE_IsoINIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum)
 {
-	/* 获取类数据句柄 */
-	USBD_CDC_HandleTypeDef *hcdc = USBD_CDC_MALLOC();
-	USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_MALLOC();
+	UNUSED(epnum);
 
-	switch(pdev->request.wIndex)
-	{
-		case 0:
-		case 1:
-			/* 转换操作句柄与数据句柄 */
-			pdev->pUserData[pdev->classId] = &USBD_CDC_Interface_fops_FS;
-			pdev->pClassDataCmsit[pdev->classId] = (void *)hcdc;
-			/* Malloc检查 */
-			if(pdev->pClassDataCmsit[pdev->classId] == NULL)
-				return (uint8_t)USBD_FAIL;
-
-			if((pdev->pUserData[pdev->classId] != NULL) && (hcdc->CmdOpCode != 0xFFU))
-			{
-				((USBD_CDC_ItfTypeDef *)pdev->pUserData[pdev->classId])->Control(hcdc->CmdOpCode, (uint8_t *)hcdc->data, (uint16_t)hcdc->CmdLength);
-				hcdc->CmdOpCode = 0xFFU;
-			}
-			break;
+	if(USBD_COM_Mode != COM_MODE_COMPOSITE)
+		return (uint8_t)USBD_OK;
 
-		case 2:
-			/* 转换操作句柄与数据句柄 */
-			pdev->pUserData[pdev->classId] = &USBD_MSC_Interface_fops_FS;
-			pdev->pClassDataCmsit[pdev->classId] = (void *)hmsc;
-			/* Malloc检查 */
-			if (pdev->pClassDataCmsit[pdev->classId] == NULL)
-				return (uint8_t)USBD_FAIL;
-			break;
-	}
+	return USBD_ISO_IsoINIncomplete(pdev);
+}
+#endif /* COM_ISO_ENABLED */
 
-	return (uint8_t)USBD_OK;
+#if (COM_HID_ENABLED == 1U)
+/* ---------------------------------------- HID Function ---------------------------------------- */
+
+static uint8_t USBD_COM_HID_Init(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
+{
+	UNUSED(func);
+	return USBD_HID_Init(pdev);
+}
+
+static uint8_t USBD_COM_HID_DeInit(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
+{
+	UNUSED(func);
+	return USBD_HID_DeInit(pdev);
+}
+
+static uint8_t USBD_COM_HID_Setup(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, USBD_SetupReqTypedef *req)
+{
+	UNUSED(func);
+	return USBD_HID_Setup(pdev, req);
+}
+
+static uint8_t USBD_COM_HID_EP0_RxReady(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func)
+{
+	UNUSED(func);
+	return USBD_HID_EP0_RxReady(pdev);
+}
+
+static uint8_t USBD_COM_HID_DataIn(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum)
+{
+	UNUSED(func);
+	return USBD_HID_DataIn(pdev, epnum);
+}
+
+static uint8_t USBD_COM_HID_DataOut(USBD_HandleTypeDef *pdev, USBD_COM_FuncTypeDef *func, uint8_t epnum)
+{
+	UNUSED(func);
+	return USBD_HID_DataOut(pdev, epnum);
 }
+#endif /* COM_HID_ENABLED */
 
 /**
   * @brief  USBD_COMPOSITE_GetFSCfgDesc 返回配置描述符
@@ -869,8 +1451,13 @@ static uint8_t USBD_COMPOSITE_EP0_RxReady(USBD_HandleTypeDef *pdev)
   */
 static uint8_t *USBD_COMPOSITE_GetFSCfgDesc(uint16_t *length)
 {
-	*length = (uint16_t)sizeof(USBD_COMPOSITE_CfgDesc);
-	return USBD_COMPOSITE_CfgDesc;
+	if(USBD_COM_Mode == COM_MODE_MSC_ONLY)
+	{
+		*length = (uint16_t)sizeof(USBD_MSC_ONLY_FSCfgDesc);
+		return USBD_MSC_ONLY_FSCfgDesc;
+	}
+	*length = (uint16_t)sizeof(USBD_COMPOSITE_FSCfgDesc);
+	return USBD_COMPOSITE_FSCfgDesc;
 }
 
 /**
@@ -880,8 +1467,18 @@ static uint8_t *USBD_COMPOSITE_GetFSCfgDesc(uint16_t *length)
   */
 static uint8_t *USBD_COMPOSITE_GetHSCfgDesc(uint16_t *length)
 {
-	*length = (uint16_t)sizeof(USBD_COMPOSITE_CfgDesc);
-	return USBD_COMPOSITE_CfgDesc;
+#if (COM_HIGH_SPEED_ENABLED == 1U)
+	if(USBD_COM_Mode == COM_MODE_MSC_ONLY)
+	{
+		*length = (uint16_t)sizeof(USBD_MSC_ONLY_HSCfgDesc);
+		return USBD_MSC_ONLY_HSCfgDesc;
+	}
+	*length = (uint16_t)sizeof(USBD_COMPOSITE_HSCfgDesc);
+	return USBD_COMPOSITE_HSCfgDesc;
+#else
+	/* 只运行在全速，不会以高速枚举 */
+	return USBD_COMPOSITE_GetFSCfgDesc(length);
+#endif
 }
 
 /**
@@ -891,8 +1488,17 @@ static uint8_t *USBD_COMPOSITE_GetHSCfgDesc(uint16_t *length)
   */
 static uint8_t *USBD_COMPOSITE_GetOtherSpeedCfgDesc(uint16_t *length)
 {
-	*length = (uint16_t)sizeof(USBD_COMPOSITE_CfgDesc);
-	return USBD_COMPOSITE_CfgDesc;
+#if (COM_HIGH_SPEED_ENABLED == 1U)
+	if(USBD_COM_Mode == COM_MODE_MSC_ONLY)
+	{
+		*length = (uint16_t)sizeof(USBD_MSC_ONLY_OtherSpeedCfgDesc);
+		return USBD_MSC_ONLY_OtherSpeedCfgDesc;
+	}
+	*length = (uint16_t)sizeof(USBD_COMPOSITE_OtherSpeedCfgDesc);
+	return USBD_COMPOSITE_OtherSpeedCfgDesc;
+#else
+	return USBD_COMPOSITE_GetFSCfgDesc(length);
+#endif
 }
 
 /**
@@ -914,13 +1520,24 @@ uint8_t *USBD_COMPOSITE_GetDeviceQualifierDescriptor(uint16_t *length)
   */
 uint8_t USBD_CDC_RegisterInterface(USBD_HandleTypeDef *pdev, USBD_CDC_ItfTypeDef *fops)
 {
-	USBD_CDC_HandleTypeDef *hcdc = USBD_CDC_MALLOC();
-	pdev->pClassDataCmsit[pdev->classId] = hcdc;
+	return USBD_CDC_RegisterInterfaceEx(pdev, 0U, fops);
+}
 
-	if(fops == NULL)
+/**
+  * @brief  USBD_CDC_RegisterInterfaceEx 指定CDC实例的接口注册操作
+  * @param  pdev: 设备实例
+  * @param  index: CDC实例编号
+  * @param  fops: CD接口回调
+  * @retval 状态
+  */
+uint8_t USBD_CDC_RegisterInterfaceEx(USBD_HandleTypeDef *pdev, uint8_t index, USBD_CDC_ItfTypeDef *fops)
+{
+	if((fops == NULL) || (index >= COM_CDC_INSTANCE_NUM))
 		return (uint8_t)USBD_FAIL;
 
-	pdev->pUserData[pdev->classId] = fops;
+	UNUSED(pdev);
+
+	USBD_COM_Func[index].Fops = fops;
 
 	return (uint8_t)USBD_OK;
 }
@@ -933,13 +1550,11 @@ uint8_t USBD_CDC_RegisterInterface(USBD_HandleTypeDef *pdev, USBD_CDC_ItfTypeDef
   */
 uint8_t USBD_MSC_RegisterInterface(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef *fops)
 {
-	USBD_MSC_BOT_HandleTypeDef *hmsc = USBD_MSC_MALLOC();
-	pdev->pClassDataCmsit[pdev->classId] = (void *)hmsc;
-
 	if(fops == NULL)
 		return (uint8_t)USBD_FAIL;
 
-	pdev->pUserData[pdev->classId] = fops;
+	USBD_COM_Func[COM_FUNC_MSC].Fops = fops;
+	USBD_COM_Bind(pdev, &USBD_COM_Func[COM_FUNC_MSC]);
 
 	return (uint8_t)USBD_OK;
 }
@@ -947,7 +1562,7 @@ uint8_t USBD_MSC_RegisterInterface(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef
 /* -------------------------------------- CDC Class Funtion -------------------------------------- */
 
 /**
-  * @brief  USBD_CDC_SetTxBuffer
+  * @brief  USBD_CDC_SetTxBuffer 设置CDC0的发送缓冲
   * @param  pdev: 设备实例
   * @param  pbuff: Tx缓冲
   * @param  length: Tx缓冲长度
@@ -955,10 +1570,55 @@ uint8_t USBD_MSC_RegisterInterface(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef
   */
 uint8_t USBD_CDC_SetTxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff, uint32_t length)
 {
-	USBD_CDC_HandleTypeDef *hcdc = USBD_CDC_MALLOC();
-	/* Malloc检查 */
-	if (hcdc == NULL)
+	return USBD_CDC_SetTxBufferEx(pdev, 0U, pbuff, length);
+}
+
+/**
+  * @brief  USBD_CDC_SetRxBuffer 设置CDC0的接收缓冲
+  * @param  pdev: 设备实例
+  * @param  pbuff: Rx缓冲
+  * @retval 状态
+  */
+uint8_t USBD_CDC_SetRxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff)
+{
+	return USBD_CDC_SetRxBufferEx(pdev, 0U, pbuff);
+}
+
+/**
+  * @brief  USBD_CDC_TransmitPacket CDC0输入端点发送数据包
+  * @param  pdev: 设备实例
+  * @retval 状态
+  */
+uint8_t USBD_CDC_TransmitPacket(USBD_HandleTypeDef *pdev)
+{
+	return USBD_CDC_TransmitPacketEx(pdev, 0U);
+}
+
+/**
+  * @brief  USBD_CDC_ReceivePacket CDC0输出端点接收数据包
+  * @param  pdev: 设备实例
+  * @retval 状态
+  */
+uint8_t USBD_CDC_ReceivePacket(USBD_HandleTypeDef *pdev)
+{
+	return USBD_CDC_ReceivePacketEx(pdev, 0U);
+}
+
+/**
+  * @brief  USBD_CDC_SetTxBufferEx
+  * @param  pdev: 设备实例
+  * @param  index: CDC实例编号
+  * @param  pbuff: Tx缓冲
+  * @param  length: Tx缓冲长度
+  * @retval 状态
+  */
+uint8_t USBD_CDC_SetTxBufferEx(USBD_HandleTypeDef *pdev, uint8_t index, uint8_t *pbuff, uint32_t length)
+{
+	USBD_CDC_HandleTypeDef *hcdc;
+
+	if (index >= COM_CDC_INSTANCE_NUM)
 		return (uint8_t)USBD_FAIL;
+	hcdc = (USBD_CDC_HandleTypeDef *)USBD_COM_Func[index].Handle;
 
 	hcdc->TxBuffer = pbuff;
 	hcdc->TxLength = length;
@@ -967,17 +1627,19 @@ uint8_t USBD_CDC_SetTxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff, uint32_t
 }
 
 /**
-  * @brief  USBD_CDC_SetRxBuffer
+  * @brief  USBD_CDC_SetRxBufferEx
   * @param  pdev: 设备实例
+  * @param  index: CDC实例编号
   * @param  pbuff: Rx缓冲
   * @retval 状态
   */
-uint8_t USBD_CDC_SetRxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff)
+uint8_t USBD_CDC_SetRxBufferEx(USBD_HandleTypeDef *pdev, uint8_t index, uint8_t *pbuff)
 {
-	USBD_CDC_HandleTypeDef *hcdc = USBD_CDC_MALLOC();
-	/* Malloc检查 */
-	if (hcdc == NULL)
+	USBD_CDC_HandleTypeDef *hcdc;
+
+	if (index >= COM_CDC_INSTANCE_NUM)
 		return (uint8_t)USBD_FAIL;
+	hcdc = (USBD_CDC_HandleTypeDef *)USBD_COM_Func[index].Handle;
 
 	hcdc->RxBuffer = pbuff;
 
@@ -985,20 +1647,22 @@ uint8_t USBD_CDC_SetRxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff)
 }
 
 /**
-  * @brief  USBD_CDC_TransmitPacket 输入端点发送数据包
+  * @brief  USBD_CDC_TransmitPacketEx 输入端点发送数据包
   * @param  pdev: 设备实例
+  * @param  index: CDC实例编号
   * @retval 状态
   */
-uint8_t USBD_CDC_TransmitPacket(USBD_HandleTypeDef *pdev)
+uint8_t USBD_CDC_TransmitPacketEx(USBD_HandleTypeDef *pdev, uint8_t index)
 {
 	USBD_StatusTypeDef ret = USBD_BUSY;
-	USBD_CDC_HandleTypeDef *hcdc = USBD_CDC_MALLOC();
-	
-	pdev->pUserData[pdev->classId] = &USBD_CDC_Interface_fops_FS;
-	pdev->pClassDataCmsit[pdev->classId] = (void *)hcdc;
-	
-	if (pdev->pClassDataCmsit[pdev->classId] == NULL)
+	USBD_CDC_HandleTypeDef *hcdc;
+	uint8_t in;
+
+	/* MSC单独模式下CDC端点未打开 */
+	if ((index >= COM_CDC_INSTANCE_NUM) || (USBD_COM_Mode != COM_MODE_COMPOSITE))
 		return (uint8_t)USBD_FAIL;
+	hcdc = (USBD_CDC_HandleTypeDef *)USBD_COM_Func[index].Handle;
+	in = USBD_COM_Func[index].Ep[0];
 
 	if (hcdc->TxState == 0U)
 	{
@@ -1006,10 +1670,21 @@ uint8_t USBD_CDC_TransmitPacket(USBD_HandleTypeDef *pdev)
 		hcdc->TxState = 1U;
 
 		/* 更新数据包总长度 */
-		pdev->ep_in[COM_CDC_IN_EP & 0xFU].total_length = hcdc->TxLength;
+		pdev->ep_in[in & 0xFU].total_length = hcdc->TxLength;
+
+#if (USBD_DMA_ENABLED == 1U)
+		/* DMA只接受字对齐的地址 */
+		if (((uint32_t)(uintptr_t)hcdc->TxBuffer & 0x3U) != 0U)
+		{
+			hcdc->TxOffset = 0U;
+			USBD_COM_CDC_TxBounce(pdev, hcdc, in);
+			return (uint8_t)USBD_OK;
+		}
+		hcdc->TxOffset = hcdc->TxLength;
+#endif /* USBD_DMA_ENABLED */
 
 		/* 发送下一个数据包 */
-		(void)USBD_LL_Transmit(pdev, COM_CDC_IN_EP, hcdc->TxBuffer, hcdc->TxLength);
+		(void)USBD_LL_Transmit(pdev, in, hcdc->TxBuffer, hcdc->TxLength);
 
 		ret = USBD_OK;
 	}
@@ -1018,26 +1693,23 @@ uint8_t USBD_CDC_TransmitPacket(USBD_HandleTypeDef *pdev)
 }
 
 /**
-  * @brief  USBD_CDC_ReceivePacket 输出端点接收数据包
+  * @brief  USBD_CDC_ReceivePacketEx 输出端点接收数据包
   * @param  pdev: 设备实例
+  * @param  index: CDC实例编号
   * @retval 状态
   */
-uint8_t USBD_CDC_ReceivePacket(USBD_HandleTypeDef *pdev)
+uint8_t USBD_CDC_ReceivePacketEx(USBD_HandleTypeDef *pdev, uint8_t index)
 {
-	USBD_CDC_HandleTypeDef *hcdc = USBD_CDC_MALLOC();
-	
-	pdev->pUserData[pdev->classId] = &USBD_CDC_Interface_fops_FS;
-	pdev->pClassDataCmsit[pdev->classId] = (void *)hcdc;
-	/* Malloc检查 */
-	if(pdev->pClassDataCmsit[pdev->classId] == NULL)
+	USBD_CDC_HandleTypeDef *hcdc;
+	uint8_t out;
+
+	if((index >= COM_CDC_INSTANCE_NUM) || (USBD_COM_Mode != COM_MODE_COMPOSITE))
 		return (uint8_t)USBD_FAIL;
+	hcdc = (USBD_CDC_HandleTypeDef *)USBD_COM_Func[index].Handle;
 
-	if (pdev->dev_speed == USBD_SPEED_HIGH)
-		/* 准备Out端点以接收下一个数据包 */
-		(void)USBD_LL_PrepareReceive(pdev, COM_CDC_OUT_EP, hcdc->RxBuffer, COM_CDC_DATA_MAX_PACK_SIZE);
-	else
-		/* 准备Out端点以接收下一个数据包 */
-		(void)USBD_LL_PrepareReceive(pdev, COM_CDC_OUT_EP, hcdc->RxBuffer, COM_CDC_DATA_MAX_PACK_SIZE);
+	/* 准备Out端点以接收下一个数据包，长度为当前速度下的包长 */
+	out = USBD_COM_Func[index].Ep[1];
+	(void)USBD_LL_PrepareReceive(pdev, out, hcdc->RxBuffer, pdev->ep_out[out & 0xFU].maxpacket);
 
 	return (uint8_t)USBD_OK;
 }
@@ -0,0 +1,438 @@
+/**
+  ******************************************************************************
+  * @file    usbd_hid.c
+  * @author  Sunshine Circuit
+  * @brief   该文件提供COMPOSITE设备中通用HID接口的实现:
+  *           - 输入、输出各一个中断端点，每1ms查询一次，承载小块状态与命令报告
+  *           - 输入报告复制后发送，一个报告在端点上时可再排队一个
+  *           - 输出报告可经中断端点或SET_REPORT下发，统一交给应用
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                HID接口描述
+  *          ===================================================================
+  *           1. 报告描述符为厂商自定义用途页，输入、输出报告各COM_HID_REPORT_SIZE
+  *              字节，不带报告ID。各系统自带HID驱动，主机程序用hidapi等直接读写。
+  *           2. 中断端点的带宽在枚举时预留，每帧最多一包，不受CDC缓冲与MSC批量
+  *              传输负载的影响：输入报告提交后最迟一个查询间隔被主机取走，
+  *              命令往返在两个查询间隔内完成。
+  *           3. 已有报告排队时再提交返回USBD_BUSY，由应用决定丢弃或下一周期
+  *              重发；报告不会被静默覆盖。端点每个查询间隔只能取走一个报告，
+  *              遥测周期不短于两个查询间隔时，命令应答总能排队。被拒绝的
+  *              次数与提交到取走的最长时间记入统计。
+  *           4. 不支持按空闲速率重复发送，SET_IDLE只记录设置值。
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32h7xx.h"
+#include "usbd_hid.h"
+#include "usbd_composite_if.h"
+
+#if (COM_HID_ENABLED == 1U)
+
+/* Typedef -------------------------------------------------------------------*/
+typedef struct
+{
+	__IO uint8_t Ready;								/**< 端点已打开 */
+	__IO uint8_t TxBusy;
+	__IO uint8_t TxPending;							/**< 另一个缓冲中有等待发送的报告 */
+	uint8_t  TxIndex;								/**< 正在发送或最近发出的缓冲 */
+	uint8_t  RxIndex;								/**< 正在接收的缓冲 */
+	uint8_t  IdleRate;
+	uint16_t TxLength[2];
+	uint32_t TxTick[2];								/**< 报告提交的时刻 */
+	uint32_t CtrlLength;							/**< SET_REPORT数据阶段的长度 */
+	USBD_HID_StatsTypeDef Stats;
+}USBD_HID_HandleTypeDef;
+
+/* Variables -----------------------------------------------------------------*/
+static USBD_HID_HandleTypeDef USBD_HID_Handle;
+static USBD_HID_ItfTypeDef *USBD_HID_Fops = &USBD_HID_Interface_fops_FS;
+
+__ALIGN_BEGIN static uint8_t USBD_HID_TxBuffer[2][COM_HID_REPORT_SIZE] __ALIGN_END;
+__ALIGN_BEGIN static uint8_t USBD_HID_RxBuffer[2][COM_HID_REPORT_SIZE] __ALIGN_END;
+__ALIGN_BEGIN static uint8_t USBD_HID_CtrlBuffer[COM_HID_REPORT_SIZE] __ALIGN_END;
+
+/* GET_STATUS与GET_INTERFACE的应答，数据阶段在请求返回后才发出，不能放在栈上 */
+__ALIGN_BEGIN static uint16_t USBD_HID_StatusReply __ALIGN_END = 0U;
+/* GET_IDLE的应答：句柄中的设置值只按字节对齐，复制到这里再交给EP0发送 */
+__ALIGN_BEGIN static uint16_t USBD_HID_IdleReply __ALIGN_END = 0U;
+
+/* HID类描述符 */
+__ALIGN_BEGIN static uint8_t USBD_HID_Desc[] __ALIGN_END =
+{
+	USBD_HID_CLASS_DESC
+};
+
+/* 报告描述符：厂商自定义用途页，输入、输出报告各COM_HID_REPORT_SIZE字节 */
+__ALIGN_BEGIN static uint8_t USBD_HID_ReportDesc[] __ALIGN_END =
+{
+	0x06, 0x00, 0xFF,							/* Usage Page: Vendor Defined 0xFF00 */
+	0x09, 0x01,									/* Usage: 0x01 */
+	0xA1, 0x01,									/* Collection: Application */
+	0x15, 0x00,									/*   Logical Minimum: 0 */
+	0x26, 0xFF, 0x00,							/*   Logical Maximum: 255 */
+	0x75, 0x08,									/*   Report Size: 8 */
+	0x95, COM_HID_REPORT_SIZE,					/*   Report Count */
+	0x09, 0x02,									/*   Usage: 0x02 */
+	0x81, 0x02,									/*   Input: Data, Var, Abs */
+	0x95, COM_HID_REPORT_SIZE,					/*   Report Count */
+	0x09, 0x03,									/*   Usage: 0x03 */
+	0x91, 0x02,									/*   Output: Data, Var, Abs */
+	0xC0,										/* End Collection */
+};
+
+typedef char USBD_HID_ReportDescSizeCheck[(sizeof(USBD_HID_ReportDesc) == HID_REPORT_DESC_SIZ) ? 1 : -1];
+
+/* ------------------------------------- HID Class Funtion ------------------------------------- */
+
+/**
+  * @brief  USBD_HID_Init 打开HID接口使用的端点
+  * @param  pdev: 设备实例
+  * @retval 状态
+  */
+uint8_t USBD_HID_Init(USBD_HandleTypeDef *pdev)
+{
+	USBD_HID_HandleTypeDef *hhid = &USBD_HID_Handle;
+
+	(void)USBD_memset(hhid, 0, sizeof(USBD_HID_HandleTypeDef));
+
+	/* Open EP IN */
+	(void)USBD_LL_OpenEP(pdev, COM_HID_IN_EP, USBD_EP_TYPE_INTR, COM_HID_REPORT_SIZE);
+	pdev->ep_in[COM_HID_IN_EP & 0x0FU].is_used = 1U;
+	pdev->ep_in[COM_HID_IN_EP & 0x0FU].maxpacket = COM_HID_REPORT_SIZE;
+
+	/* Open EP OUT */
+	(void)USBD_LL_OpenEP(pdev, COM_HID_OUT_EP, USBD_EP_TYPE_INTR, COM_HID_REPORT_SIZE);
+	pdev->ep_out[COM_HID_OUT_EP & 0x0FU].is_used = 1U;
+	pdev->ep_out[COM_HID_OUT_EP & 0x0FU].maxpacket = COM_HID_REPORT_SIZE;
+
+	if(USBD_HID_Fops->Init != NULL)
+		USBD_HID_Fops->Init();
+
+	/* 准备Out端点以接收第一个报告 */
+	(void)USBD_LL_PrepareReceive(pdev, COM_HID_OUT_EP, USBD_HID_RxBuffer[0], COM_HID_REPORT_SIZE);
+	hhid->Ready = 1U;
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_DeInit 关闭HID接口使用的端点
+  * @param  pdev: 设备实例
+  * @retval 状态
+  */
+uint8_t USBD_HID_DeInit(USBD_HandleTypeDef *pdev)
+{
+	USBD_HID_Handle.Ready = 0U;
+
+	(void)USBD_LL_CloseEP(pdev, COM_HID_IN_EP);
+	pdev->ep_in[COM_HID_IN_EP & 0xFU].is_used = 0U;
+
+	(void)USBD_LL_CloseEP(pdev, COM_HID_OUT_EP);
+	pdev->ep_out[COM_HID_OUT_EP & 0xFU].is_used = 0U;
+
+	USBD_HID_Handle.TxBusy = 0U;
+	USBD_HID_Handle.TxPending = 0U;
+	if(USBD_HID_Fops->DeInit != NULL)
+		USBD_HID_Fops->DeInit();
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_Setup 处理HID接口的请求
+  * @note   类请求支持GET_REPORT、SET_REPORT与GET_IDLE、SET_IDLE；
+  *         标准请求额外应答HID类描述符与报告描述符。
+  * @param  pdev: 设备实例
+  * @param  req: USB请求
+  * @retval 状态
+  */
+uint8_t USBD_HID_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+	USBD_HID_HandleTypeDef *hhid = &USBD_HID_Handle;
+	USBD_StatusTypeDef ret = USBD_OK;
+	uint8_t *pbuf = NULL;
+	uint16_t len = 0U;
+
+	switch (req->bmRequest & USB_REQ_TYPE_MASK)
+	{
+		case USB_REQ_TYPE_CLASS:
+			switch (req->bRequest)
+			{
+				case HID_REQ_GET_REPORT:
+					/* 返回最近提交的输入报告 */
+					len = MIN(hhid->TxLength[hhid->TxIndex ^ hhid->TxPending], req->wLength);
+					(void)USBD_CtlSendData(pdev, USBD_HID_TxBuffer[hhid->TxIndex ^ hhid->TxPending], len);
+					break;
+
+				case HID_REQ_SET_REPORT:
+					if ((req->wLength == 0U) || (req->wLength > COM_HID_REPORT_SIZE))
+					{
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
+					}
+					else
+					{
+						hhid->CtrlLength = req->wLength;
+						(void)USBD_CtlPrepareRx(pdev, USBD_HID_CtrlBuffer, req->wLength);
+					}
+					break;
+
+				case HID_REQ_GET_IDLE:
+					USBD_HID_IdleReply = hhid->IdleRate;
+					(void)USBD_CtlSendData(pdev, (uint8_t *)&USBD_HID_IdleReply, 1U);
+					break;
+
+				case HID_REQ_SET_IDLE:
+					hhid->IdleRate = HIBYTE(req->wValue);
+					break;
+
+				default:
+					USBD_CtlError(pdev, req);
+					ret = USBD_FAIL;
+					break;
+			}
+			break;
+
+		case USB_REQ_TYPE_STANDARD:
+			switch (req->bRequest)
+			{
+				case USB_REQ_GET_STATUS:
+					if (pdev->dev_state == USBD_STATE_CONFIGURED)
+						(void)USBD_CtlSendData(pdev, (uint8_t *)&USBD_HID_StatusReply, 2U);
+					else
+					{
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
+					}
+					break;
+
+				case USB_REQ_GET_DESCRIPTOR:
+					if (HIBYTE(req->wValue) == HID_REPORT_DESC)
+					{
+						pbuf = USBD_HID_ReportDesc;
+						len = MIN((uint16_t)sizeof(USBD_HID_ReportDesc), req->wLength);
+					}
+					else if (HIBYTE(req->wValue) == HID_DESCRIPTOR_TYPE)
+					{
+						pbuf = USBD_HID_Desc;
+						len = MIN((uint16_t)sizeof(USBD_HID_Desc), req->wLength);
+					}
+
+					if (pbuf != NULL)
+						(void)USBD_CtlSendData(pdev, pbuf, len);
+					else
+					{
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
+					}
+					break;
+
+				case USB_REQ_GET_INTERFACE:
+					if (pdev->dev_state == USBD_STATE_CONFIGURED)
+						(void)USBD_CtlSendData(pdev, (uint8_t *)&USBD_HID_StatusReply, 1U);
+					else
+					{
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
+					}
+					break;
+
+				case USB_REQ_SET_INTERFACE:
+					if ((pdev->dev_state != USBD_STATE_CONFIGURED) || (req->wValue != 0U))
+					{
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
+					}
+					break;
+
+				case USB_REQ_CLEAR_FEATURE:
+					break;
+
+				default:
+					USBD_CtlError(pdev, req);
+					ret = USBD_FAIL;
+					break;
+			}
+			break;
+
+		default:
+			USBD_CtlError(pdev, req);
+			ret = USBD_FAIL;
+			break;
+	}
+
+	return (uint8_t)ret;
+}
+
+/**
+  * @brief  USBD_HID_EP0_RxReady SET_REPORT的数据阶段完成
+  * @param  pdev: 设备实例
+  * @retval 状态
+  */
+uint8_t USBD_HID_EP0_RxReady(USBD_HandleTypeDef *pdev)
+{
+	USBD_HID_HandleTypeDef *hhid = &USBD_HID_Handle;
+
+	if (pdev->request.bRequest != HID_REQ_SET_REPORT)
+		return (uint8_t)USBD_OK;
+
+	hhid->Stats.OutReports++;
+	if (USBD_HID_Fops->Receive != NULL)
+		USBD_HID_Fops->Receive(USBD_HID_CtrlBuffer, hhid->CtrlLength);
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_DataIn 输入报告已被主机取走，发出等待中的报告
+  * @param  pdev: 设备实例
+  * @param  epnum: 端点号
+  * @retval 状态
+  */
+uint8_t USBD_HID_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+	USBD_HID_HandleTypeDef *hhid = &USBD_HID_Handle;
+	uint32_t latency = HAL_GetTick() - hhid->TxTick[hhid->TxIndex];
+
+	UNUSED(epnum);
+
+	hhid->Stats.InReports++;
+	if (latency > hhid->Stats.MaxLatency)
+		hhid->Stats.MaxLatency = latency;
+
+	/* SendReport只在关中断时修改等待标志，这里运行于USB中断或USB任务，不会被其打断 */
+	if (hhid->TxPending != 0U)
+	{
+		hhid->TxIndex ^= 1U;
+		hhid->TxPending = 0U;
+		(void)USBD_LL_Transmit(pdev, COM_HID_IN_EP, USBD_HID_TxBuffer[hhid->TxIndex], hhid->TxLength[hhid->TxIndex]);
+	}
+	else
+		hhid->TxBusy = 0U;
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_DataOut 收到中断端点上的输出报告
+  * @note   先在另一个缓冲上重新启动接收，再把收到的报告交给应用。
+  * @param  pdev: 设备实例
+  * @param  epnum: 端点号
+  * @retval 状态
+  */
+uint8_t USBD_HID_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+	USBD_HID_HandleTypeDef *hhid = &USBD_HID_Handle;
+	uint32_t length = USBD_LL_GetRxDataSize(pdev, epnum);
+	uint8_t *buf = USBD_HID_RxBuffer[hhid->RxIndex];
+
+	hhid->RxIndex ^= 1U;
+	(void)USBD_LL_PrepareReceive(pdev, COM_HID_OUT_EP, USBD_HID_RxBuffer[hhid->RxIndex], COM_HID_REPORT_SIZE);
+
+	hhid->Stats.OutReports++;
+	if (USBD_HID_Fops->Receive != NULL)
+		USBD_HID_Fops->Receive(buf, length);
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_RegisterInterface 注册报告接口
+  * @param  fops: 应用回调
+  * @retval 状态
+  */
+uint8_t USBD_HID_RegisterInterface(USBD_HID_ItfTypeDef *fops)
+{
+	if (fops == NULL)
+		return (uint8_t)USBD_FAIL;
+
+	USBD_HID_Fops = fops;
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_SendReport 提交一个输入报告
+  * @note   报告被复制，返回后缓冲即可重用；可在任务或中断中调用。
+  *         端点空闲时立即交给端点，否则排队，在当前报告被取走后发出。
+  * @param  pdev: 设备实例
+  * @param  Report: 报告数据
+  * @param  Len: 报告长度，不超过COM_HID_REPORT_SIZE
+  * @retval USBD_OK，已有报告排队返回USBD_BUSY，未枚举或长度无效返回USBD_FAIL
+  */
+uint8_t USBD_HID_SendReport(USBD_HandleTypeDef *pdev, uint8_t *Report, uint16_t Len)
+{
+	USBD_HID_HandleTypeDef *hhid = &USBD_HID_Handle;
+	uint32_t primask;
+	uint8_t idx;
+
+	if ((pdev->dev_state != USBD_STATE_CONFIGURED) || (hhid->Ready == 0U))
+		return (uint8_t)USBD_FAIL;
+	if ((Len == 0U) || (Len > COM_HID_REPORT_SIZE))
+		return (uint8_t)USBD_FAIL;
+
+	/* 报告不超过一包，复制期间关中断的时间很短 */
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if (hhid->TxPending != 0U)
+	{
+		hhid->Stats.Rejected++;
+		__set_PRIMASK(primask);
+		return (uint8_t)USBD_BUSY;
+	}
+	idx = hhid->TxIndex ^ hhid->TxBusy;
+	(void)USBD_memcpy(USBD_HID_TxBuffer[idx], Report, Len);
+	hhid->TxLength[idx] = Len;
+	hhid->TxTick[idx] = HAL_GetTick();
+	if (hhid->TxBusy != 0U)
+	{
+		/* 排队的报告由DataIn发出 */
+		hhid->TxPending = 1U;
+		__set_PRIMASK(primask);
+		return (uint8_t)USBD_OK;
+	}
+	hhid->TxBusy = 1U;
+	__set_PRIMASK(primask);
+
+	(void)USBD_LL_Transmit(pdev, COM_HID_IN_EP, USBD_HID_TxBuffer[idx], Len);
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_IsTxBusy 查询端点上是否有报告未被取走
+  * @retval 1为忙
+  */
+uint8_t USBD_HID_IsTxBusy(void)
+{
+	return USBD_HID_Handle.TxBusy;
+}
+
+/**
+  * @brief  USBD_HID_GetStats 读取HID接口统计
+  * @param  stats: 输出的统计数据
+  */
+void USBD_HID_GetStats(USBD_HID_StatsTypeDef *stats)
+{
+	*stats = USBD_HID_Handle.Stats;
+}
+
+#endif /* COM_HID_ENABLED */
@@ -0,0 +1,440 @@
+/**
+  ******************************************************************************
+  * @file    usbd_iso.c
+  * @author  Sunshine Circuit
+  * @brief   该文件提供COMPOSITE设备中同步输入数据流的实现:
+  *           - 一个同步输入端点，每个(微)帧发送一包，带宽在枚举时预留
+  *           - 双缓冲提交，DMA半满/满中断或任务交替提交两块数据，零拷贝
+  *           - 未取走的包按帧丢弃，数据流保持固定速率，并统计丢包与欠载
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                同步数据流描述
+  *          ===================================================================
+  *           1. 接口类为0xFF，设置0没有端点。主机打开数据流时选择设置1，
+  *              总线调度器为端点保留每帧的带宽，MSC等批量传输再多也不会挤占。
+  *           2. 每次只向端点提交一包，传输完成后立即提交下一包；没有数据时
+  *              提交空包，端点每帧都在运行，数据到达后最迟一帧发出。
+  *           3. 主机在某帧没有取走数据时产生同步输入未完成中断，该包被丢弃，
+  *              清空FIFO后提交下一包，不重传，后续数据的时序不受影响。
+  *           4. 缓冲区的数据全部发出或被丢弃后经BufferDone交还，期间不得改动。
+  *              开启USBD_DMA_ENABLED时缓冲区须字对齐。
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32h7xx.h"
+#include "usbd_iso.h"
+#include "usbd_composite_if.h"
+
+#if (COM_ISO_ENABLED == 1U)
+
+/* Define --------------------------------------------------------------------*/
+#define ISO_SLOT_NUM					2U
+
+/* Typedef -------------------------------------------------------------------*/
+typedef struct
+{
+	uint8_t  *Buf;
+	uint32_t Len;
+}USBD_ISO_SlotTypeDef;
+
+typedef struct
+{
+	USBD_ISO_SlotTypeDef Slot[ISO_SLOT_NUM];		/**< 提交的缓冲，Head为正在发送的一块 */
+	uint8_t  Head;
+	__IO uint8_t Count;								/**< 等待发送的缓冲数，含正在发送的一块 */
+	uint32_t Offset;								/**< 正在发送的缓冲中已交给端点的长度 */
+	uint32_t Armed;									/**< 端点上这一包的长度 */
+	uint16_t MaxPacket;								/**< 当前速度下的包大小 */
+	uint8_t  AltSetting;
+	__IO uint8_t Streaming;							/**< 已选择设置1 */
+	USBD_ISO_StatsTypeDef Stats;
+}USBD_ISO_HandleTypeDef;
+
+/* Variables -----------------------------------------------------------------*/
+static USBD_ISO_HandleTypeDef USBD_ISO_Handle;
+static USBD_ISO_ItfTypeDef *USBD_ISO_Fops = &USBD_ISO_Interface_fops_FS;
+
+/* GET_STATUS与GET_INTERFACE的应答，数据阶段在请求返回后才发出，不能放在栈上 */
+__ALIGN_BEGIN static uint16_t USBD_ISO_StatusReply __ALIGN_END = 0U;
+__ALIGN_BEGIN static uint16_t USBD_ISO_AltReply __ALIGN_END = 0U;		/**< 句柄中的AltSetting不保证字对齐 */
+
+/* ------------------------------------- ISO Class Funtion ------------------------------------- */
+
+/**
+  * @brief  USBD_ISO_Arm 向端点提交下一包
+  * @note   在USB中断或USB任务中调用；没有待发数据时提交空包。
+  * @param  pdev: 设备实例
+  */
+static void USBD_ISO_Arm(USBD_HandleTypeDef *pdev)
+{
+	USBD_ISO_HandleTypeDef *hiso = &USBD_ISO_Handle;
+	USBD_ISO_SlotTypeDef *slot;
+	uint8_t *buf = NULL;
+	uint32_t len = 0U;
+
+	if(hiso->Count != 0U)
+	{
+		slot = &hiso->Slot[hiso->Head];
+		buf = slot->Buf + hiso->Offset;
+		len = slot->Len - hiso->Offset;
+		if(len > hiso->MaxPacket)
+			len = hiso->MaxPacket;
+	}
+	else
+		hiso->Stats.Underruns++;
+
+	hiso->Armed = len;
+	hiso->Stats.Packets++;
+	(void)USBD_LL_Transmit(pdev, COM_ISO_IN_EP, buf, len);
+}
+
+/**
+  * @brief  USBD_ISO_Advance 端点上的一包已结束，发出或丢弃都从缓冲中移除
+  * @note   缓冲全部移除后交还应用。
+  */
+static void USBD_ISO_Advance(void)
+{
+	USBD_ISO_HandleTypeDef *hiso = &USBD_ISO_Handle;
+	USBD_ISO_SlotTypeDef done = {NULL, 0U};
+	uint32_t primask;
+
+	if(hiso->Armed == 0U)
+		return;
+
+	/* Submit可能在DMA中断中调用，队列的修改需与之互斥 */
+	primask = __get_PRIMASK();
+	__disable_irq();
+	hiso->Offset += hiso->Armed;
+	if(hiso->Offset >= hiso->Slot[hiso->Head].Len)
+	{
+		done = hiso->Slot[hiso->Head];
+		hiso->Head = (uint8_t)((hiso->Head + 1U) % ISO_SLOT_NUM);
+		hiso->Count--;
+		hiso->Offset = 0U;
+	}
+	__set_PRIMASK(primask);
+
+	if((done.Buf != NULL) && (USBD_ISO_Fops->BufferDone != NULL))
+		USBD_ISO_Fops->BufferDone(done.Buf, done.Len);
+}
+
+/**
+  * @brief  USBD_ISO_Flush 交还全部等待中的缓冲
+  */
+static void USBD_ISO_Flush(void)
+{
+	USBD_ISO_HandleTypeDef *hiso = &USBD_ISO_Handle;
+	USBD_ISO_SlotTypeDef done;
+	uint32_t primask;
+
+	for(;;)
+	{
+		primask = __get_PRIMASK();
+		__disable_irq();
+		if(hiso->Count == 0U)
+		{
+			__set_PRIMASK(primask);
+			break;
+		}
+		done = hiso->Slot[hiso->Head];
+		hiso->Head = (uint8_t)((hiso->Head + 1U) % ISO_SLOT_NUM);
+		hiso->Count--;
+		__set_PRIMASK(primask);
+
+		if(USBD_ISO_Fops->BufferDone != NULL)
+			USBD_ISO_Fops->BufferDone(done.Buf, done.Len);
+	}
+	hiso->Offset = 0U;
+	hiso->Armed = 0U;
+}
+
+/**
+  * @brief  USBD_ISO_Start 打开同步端点并开始按帧发送
+  * @param  pdev: 设备实例
+  */
+static void USBD_ISO_Start(USBD_HandleTypeDef *pdev)
+{
+	USBD_ISO_HandleTypeDef *hiso = &USBD_ISO_Handle;
+
+	(void)USBD_LL_OpenEP(pdev, COM_ISO_IN_EP, USBD_EP_TYPE_ISOC, hiso->MaxPacket);
+	pdev->ep_in[COM_ISO_IN_EP & 0x0FU].is_used = 1U;
+	pdev->ep_in[COM_ISO_IN_EP & 0x0FU].maxpacket = hiso->MaxPacket;
+
+	hiso->Offset = 0U;
+	hiso->Streaming = 1U;
+	if(USBD_ISO_Fops->Start != NULL)
+		USBD_ISO_Fops->Start();
+
+	USBD_ISO_Arm(pdev);
+}
+
+/**
+  * @brief  USBD_ISO_Stop 关闭同步端点，释放预留的带宽
+  * @note   未发出的缓冲同样经BufferDone交还。
+  * @param  pdev: 设备实例
+  */
+static void USBD_ISO_Stop(USBD_HandleTypeDef *pdev)
+{
+	USBD_ISO_HandleTypeDef *hiso = &USBD_ISO_Handle;
+
+	if(hiso->Streaming == 0U)
+		return;
+	hiso->Streaming = 0U;
+
+	(void)USBD_LL_CloseEP(pdev, COM_ISO_IN_EP);
+	(void)USBD_LL_FlushEP(pdev, COM_ISO_IN_EP);
+	pdev->ep_in[COM_ISO_IN_EP & 0x0FU].is_used = 0U;
+
+	USBD_ISO_Flush();
+	if(USBD_ISO_Fops->Stop != NULL)
+		USBD_ISO_Fops->Stop();
+}
+
+/**
+  * @brief  USBD_ISO_Init 初始化同步数据流，设置0没有端点，不打开端点
+  * @param  pdev: 设备实例
+  * @retval 状态
+  */
+uint8_t USBD_ISO_Init(USBD_HandleTypeDef *pdev)
+{
+	USBD_ISO_HandleTypeDef *hiso = &USBD_ISO_Handle;
+
+	(void)USBD_memset(hiso, 0, sizeof(USBD_ISO_HandleTypeDef));
+	hiso->MaxPacket = (pdev->dev_speed == USBD_SPEED_HIGH) ? COM_ISO_HS_PACK_SIZE : COM_ISO_FS_PACK_SIZE;
+
+	if(USBD_ISO_Fops->Init != NULL)
+		USBD_ISO_Fops->Init();
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_ISO_DeInit 停止数据流
+  * @param  pdev: 设备实例
+  * @retval 状态
+  */
+uint8_t USBD_ISO_DeInit(USBD_HandleTypeDef *pdev)
+{
+	USBD_ISO_Stop(pdev);
+	USBD_ISO_Handle.AltSetting = 0U;
+
+	if(USBD_ISO_Fops->DeInit != NULL)
+		USBD_ISO_Fops->DeInit();
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_ISO_Setup 处理同步数据流接口的请求
+  * @note   接口上没有类请求，SET_INTERFACE在设置0与设置1之间切换。
+  * @param  pdev: 设备实例
+  * @param  req: USB请求
+  * @retval 状态
+  */
+uint8_t USBD_ISO_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+	USBD_ISO_HandleTypeDef *hiso = &USBD_ISO_Handle;
+	USBD_StatusTypeDef ret = USBD_OK;
+
+	if ((req->bmRequest & USB_REQ_TYPE_MASK) != USB_REQ_TYPE_STANDARD)
+	{
+		USBD_CtlError(pdev, req);
+		return (uint8_t)USBD_FAIL;
+	}
+
+	switch (req->bRequest)
+	{
+		case USB_REQ_GET_STATUS:
+			if (pdev->dev_state == USBD_STATE_CONFIGURED)
+				(void)USBD_CtlSendData(pdev, (uint8_t *)&USBD_ISO_StatusReply, 2U);
+			else
+			{
+				USBD_CtlError(pdev, req);
+				ret = USBD_FAIL;
+			}
+			break;
+
+		case USB_REQ_GET_INTERFACE:
+			if (pdev->dev_state == USBD_STATE_CONFIGURED)
+			{
+				USBD_ISO_AltReply = hiso->AltSetting;
+				(void)USBD_CtlSendData(pdev, (uint8_t *)&USBD_ISO_AltReply, 1U);
+			}
+			else
+			{
+				USBD_CtlError(pdev, req);
+				ret = USBD_FAIL;
+			}
+			break;
+
+		case USB_REQ_SET_INTERFACE:
+			if ((pdev->dev_state != USBD_STATE_CONFIGURED) || (req->wValue > 1U))
+			{
+				USBD_CtlError(pdev, req);
+				ret = USBD_FAIL;
+			}
+			else if ((uint8_t)req->wValue != hiso->AltSetting)
+			{
+				hiso->AltSetting = (uint8_t)req->wValue;
+				if (hiso->AltSetting == 1U)
+					USBD_ISO_Start(pdev);
+				else
+					USBD_ISO_Stop(pdev);
+			}
+			break;
+
+		case USB_REQ_CLEAR_FEATURE:
+			break;
+
+		default:
+			USBD_CtlError(pdev, req);
+			ret = USBD_FAIL;
+			break;
+	}
+
+	return (uint8_t)ret;
+}
+
+/**
+  * @brief  USBD_ISO_DataIn 一包已被主机取走，提交下一包
+  * @param  pdev: 设备实例
+  * @param  epnum: 端点号
+  * @retval 状态
+  */
+uint8_t USBD_ISO_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+	USBD_ISO_HandleTypeDef *hiso = &USBD_ISO_Handle;
+
+	UNUSED(epnum);
+
+	if (hiso->Streaming == 0U)
+		return (uint8_t)USBD_OK;
+
+	hiso->Stats.Bytes += hiso->Armed;
+	USBD_ISO_Advance();
+	USBD_ISO_Arm(pdev);
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_ISO_IsoINIncomplete 本帧的包未被主机取走
+  * @note   PCD已停止端点上的传输，清空FIFO中的旧包后提交下一包；丢弃的数据不重传。
+  * @param  pdev: 设备实例
+  * @retval 状态
+  */
+uint8_t USBD_ISO_IsoINIncomplete(USBD_HandleTypeDef *pdev)
+{
+	USBD_ISO_HandleTypeDef *hiso = &USBD_ISO_Handle;
+
+	if (hiso->Streaming == 0U)
+		return (uint8_t)USBD_OK;
+
+	hiso->Stats.Missed++;
+	(void)USBD_LL_FlushEP(pdev, COM_ISO_IN_EP);
+	USBD_ISO_Advance();
+	USBD_ISO_Arm(pdev);
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_ISO_RegisterInterface 注册数据流接口
+  * @param  fops: 应用回调
+  * @retval 状态
+  */
+uint8_t USBD_ISO_RegisterInterface(USBD_ISO_ItfTypeDef *fops)
+{
+	if (fops == NULL)
+		return (uint8_t)USBD_FAIL;
+
+	USBD_ISO_Fops = fops;
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_ISO_Submit 提交一块待发送的数据
+  * @note   可在DMA中断或任务中调用。数据直接由端点取走，不复制，经BufferDone交还前不得改动；
+  *         最多两块同时等待，正在发送的一块发完后无缝接上另一块。
+  * @param  Buf: 数据
+  * @param  Len: 数据长度
+  * @retval USBD_OK，两块都在等待返回USBD_BUSY，数据流未打开或参数无效返回USBD_FAIL
+  */
+uint8_t USBD_ISO_Submit(uint8_t *Buf, uint32_t Len)
+{
+	USBD_ISO_HandleTypeDef *hiso = &USBD_ISO_Handle;
+	USBD_ISO_SlotTypeDef *slot;
+	uint32_t primask;
+
+	if ((Buf == NULL) || (Len == 0U))
+		return (uint8_t)USBD_FAIL;
+#if (USBD_DMA_ENABLED == 1U)
+	/* DMA只接受字对齐的地址，包长为4的倍数，每包的起始地址同样对齐 */
+	if (((uint32_t)Buf & 0x3U) != 0U)
+		return (uint8_t)USBD_FAIL;
+#endif /* USBD_DMA_ENABLED */
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if (hiso->Streaming == 0U)
+	{
+		__set_PRIMASK(primask);
+		return (uint8_t)USBD_FAIL;
+	}
+	if (hiso->Count >= ISO_SLOT_NUM)
+	{
+		hiso->Stats.Overruns++;
+		__set_PRIMASK(primask);
+		return (uint8_t)USBD_BUSY;
+	}
+	slot = &hiso->Slot[(hiso->Head + hiso->Count) % ISO_SLOT_NUM];
+	slot->Buf = Buf;
+	slot->Len = Len;
+	hiso->Count++;
+	__set_PRIMASK(primask);
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_ISO_IsStreaming 查询主机是否已打开数据流
+  * @retval 1为已打开
+  */
+uint8_t USBD_ISO_IsStreaming(void)
+{
+	return USBD_ISO_Handle.Streaming;
+}
+
+/**
+  * @brief  USBD_ISO_GetStats 读取同步数据流统计
+  * @param  stats: 统计的副本
+  */
+void USBD_ISO_GetStats(USBD_ISO_StatsTypeDef *stats)
+{
+	uint32_t primask;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	*stats = USBD_ISO_Handle.Stats;
+	__set_PRIMASK(primask);
+}
+
+#endif /* COM_ISO_ENABLED */
@@ -0,0 +1,722 @@
+/**
+  ******************************************************************************
+  * @file    usbd_ncm.c
+  * @author  Sunshine Circuit
+  * @brief   该文件提供COMPOSITE设备中CDC-NCM网络功能的实现:
+  *           - NCM类请求与数据接口备用设置管理
+  *           - 输入方向将多个以太网帧合并为一个NTB16传输
+  *           - 输出方向拆解NTB16并逐帧交给网络协议栈
+  *           - 网络连接与链路速率通知
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                NCM类驱动描述
+  *          ===================================================================
+  *           此驱动按照“通用串行总线通信类网络控制模型(NCM)子类规范修订版1.0”实现:
+  *             - 仅支持NTB16格式
+  *             - 端点忙时新帧追加到正在填充的NTB，端点空闲时立即发出，
+  *               由此在负载高时自动批量、负载低时保持低延迟
+  *             - 不支持多播过滤、电源过滤与以太网统计
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32h7xx.h"
+#include "usbd_ncm.h"
+#include "usbd_composite_if.h"
+
+/* Define --------------------------------------------------------------------*/
+#define NCM_NOTIFY_IDLE									0U
+#define NCM_NOTIFY_CONNECTION							1U
+#define NCM_NOTIFY_SPEED								2U
+
+#define NCM_ALIGN(x)									(((x) + (NCM_NDP_ALIGN - 1U)) & ~(NCM_NDP_ALIGN - 1U))
+
+#if (COM_NCM_ENABLED == 1U)
+
+/* Typedef -------------------------------------------------------------------*/
+typedef struct
+{
+	uint32_t data[USB_MAX_EP0_SIZE / 4U];			/* 控制请求数据，强制32位对齐 */
+	uint8_t  CmdOpCode;
+	uint8_t  CmdLength;
+	uint8_t  AltSetting;							/**< 数据接口备用设置 */
+	uint8_t  NotifyState;							/**< 待发送的通知 */
+	uint32_t NtbInSize;								/**< 主机设置的输入NTB大小 */
+	uint16_t TxSequence;
+	__IO uint8_t TxBusy;
+	uint8_t  Fill;									/**< 正在填充的NTB */
+	USBD_NCM_NtbTypeDef Ntb[2];
+	USBD_NCM_StatsTypeDef Stats;
+}USBD_NCM_HandleTypeDef;
+
+/* Variables -----------------------------------------------------------------*/
+static USBD_NCM_HandleTypeDef USBD_NCM_Handle;
+static USBD_NCM_ItfTypeDef *USBD_NCM_Fops = &USBD_NCM_Interface_fops_FS;
+
+/* 双缓冲输入NTB：一个正在发送，一个正在填充 */
+__ALIGN_BEGIN static uint8_t USBD_NCM_NtbInBuffer[2][NCM_NTB_IN_SIZE] __ALIGN_END;
+__ALIGN_BEGIN static uint8_t USBD_NCM_NtbOutBuffer[NCM_NTB_OUT_SIZE] __ALIGN_END;
+__ALIGN_BEGIN static uint8_t USBD_NCM_NotifyBuffer[COM_NCM_NOTIFY_PACK_SIZE] __ALIGN_END;
+/* GET_STATUS的应答在Setup返回后才由EP0发出，不能取栈上变量的地址 */
+__ALIGN_BEGIN static uint16_t USBD_NCM_StatusReply __ALIGN_END = 0U;
+__ALIGN_BEGIN static uint16_t USBD_NCM_AltReply __ALIGN_END = 0U;
+
+/* NTB参数 */
+__ALIGN_BEGIN static const uint8_t USBD_NCM_NtbParameters[NCM_NTB_PARAMETERS_SIZE] __ALIGN_END =
+{
+	LOBYTE(NCM_NTB_PARAMETERS_SIZE), HIBYTE(NCM_NTB_PARAMETERS_SIZE),		/* wLength */
+	0x01, 0x00,																/* bmNtbFormatsSupported: NTB16 */
+	(uint8_t)(NCM_NTB_IN_SIZE), (uint8_t)(NCM_NTB_IN_SIZE >> 8),			/* dwNtbInMaxSize */
+	(uint8_t)(NCM_NTB_IN_SIZE >> 16), (uint8_t)(NCM_NTB_IN_SIZE >> 24),
+	NCM_NDP_ALIGN, 0x00,													/* wNdpInDivisor */
+	0x00, 0x00,																/* wNdpInPayloadRemainder */
+	NCM_NDP_ALIGN, 0x00,													/* wNdpInAlignment */
+	0x00, 0x00,																/* wReserved */
+	(uint8_t)(NCM_NTB_OUT_SIZE), (uint8_t)(NCM_NTB_OUT_SIZE >> 8),			/* dwNtbOutMaxSize */
+	(uint8_t)(NCM_NTB_OUT_SIZE >> 16), (uint8_t)(NCM_NTB_OUT_SIZE >> 24),
+	NCM_NDP_ALIGN, 0x00,													/* wNdpOutDivisor */
+	0x00, 0x00,																/* wNdpOutPayloadRemainder */
+	NCM_NDP_ALIGN, 0x00,													/* wNdpOutAlignment */
+	0x00, 0x00,																/* wNtbOutMaxDatagrams: 不限 */
+};
+
+#endif /* COM_NCM_ENABLED */
+
+/* ---------------------------------------- NTB Funtion ----------------------------------------- */
+
+static void NCM_Put16(uint8_t *p, uint16_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void NCM_Put32(uint8_t *p, uint32_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t NCM_Get16(const uint8_t *p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t NCM_Get32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+  * @brief  USBD_NCM_NtbReset 开始构建新的输入NTB
+  * @param  ntb: NTB构建器
+  * @param  buf: NTB缓冲区
+  * @param  size: NTB最大长度
+  */
+void USBD_NCM_NtbReset(USBD_NCM_NtbTypeDef *ntb, uint8_t *buf, uint32_t size)
+{
+	ntb->Buffer = buf;
+	ntb->Size = size;
+	ntb->Length = NCM_NTH16_SIZE;
+	ntb->Count = 0U;
+}
+
+/**
+  * @brief  USBD_NCM_NtbAppend 向NTB追加一个以太网帧
+  * @note   NDP放在所有帧之后，追加时预留NDP及结束项的空间。
+  * @param  ntb: NTB构建器
+  * @param  frame: 以太网帧
+  * @param  len: 帧长
+  * @retval USBD_OK，空间不足时返回USBD_BUSY
+  */
+uint8_t USBD_NCM_NtbAppend(USBD_NCM_NtbTypeDef *ntb, const uint8_t *frame, uint16_t len)
+{
+	uint32_t offset = NCM_ALIGN(ntb->Length);
+	uint32_t ndp = NCM_ALIGN(offset + len);
+
+	if(ntb->Count >= NCM_MAX_DATAGRAMS)
+		return USBD_BUSY;
+	if(ndp + NCM_NDP16_HEAD_SIZE + NCM_NDP16_ENTRY_SIZE * (ntb->Count + 2U) > ntb->Size)
+		return USBD_BUSY;
+
+	/* 对齐填充清零，保证NTB内容确定 */
+	memset(&ntb->Buffer[ntb->Length], 0, offset - ntb->Length);
+	memcpy(&ntb->Buffer[offset], frame, len);
+	ntb->Index[ntb->Count][0] = (uint16_t)offset;
+	ntb->Index[ntb->Count][1] = len;
+	ntb->Count++;
+	ntb->Length = offset + len;
+
+	return USBD_OK;
+}
+
+/**
+  * @brief  USBD_NCM_NtbFinish 写入NTH16与NDP16，完成NTB
+  * @param  ntb: NTB构建器
+  * @param  sequence: NTB序号
+  * @retval NTB总长度，没有帧时返回0
+  */
+uint32_t USBD_NCM_NtbFinish(USBD_NCM_NtbTypeDef *ntb, uint16_t sequence)
+{
+	uint8_t *p = ntb->Buffer;
+	uint32_t ndp = NCM_ALIGN(ntb->Length);
+	uint32_t ndp_len = NCM_NDP16_HEAD_SIZE + NCM_NDP16_ENTRY_SIZE * (ntb->Count + 1U);
+	uint32_t block = ndp + ndp_len;
+	uint16_t i;
+
+	if(ntb->Count == 0U)
+		return 0U;
+
+	memset(&p[ntb->Length], 0, ndp - ntb->Length);
+
+	/* NDP16 */
+	NCM_Put32(&p[ndp], NCM_NDP16_SIGNATURE);
+	NCM_Put16(&p[ndp + 4U], (uint16_t)ndp_len);
+	NCM_Put16(&p[ndp + 6U], 0U);
+	for(i = 0U; i < ntb->Count; i++)
+	{
+		NCM_Put16(&p[ndp + 8U + 4U * i], ntb->Index[i][0]);
+		NCM_Put16(&p[ndp + 10U + 4U * i], ntb->Index[i][1]);
+	}
+	NCM_Put32(&p[ndp + 8U + 4U * i], 0U);
+
+	/* NTH16 */
+	NCM_Put32(&p[0], NCM_NTH16_SIGNATURE);
+	NCM_Put16(&p[4], NCM_NTH16_SIZE);
+	NCM_Put16(&p[6], sequence);
+	NCM_Put16(&p[8], (uint16_t)block);
+	NCM_Put16(&p[10], (uint16_t)ndp);
+
+	return block;
+}
+
+/**
+  * @brief  USBD_NCM_NtbParse 解析输出NTB16，逐帧回调
+  * @note   所有偏移都做越界检查，NDP链最多跟随8级，防止主机构造的环路。
+  * @param  buf: NTB数据
+  * @param  len: 接收长度
+  * @param  callback: 帧回调
+  * @retval 帧数量，格式错误时返回-1
+  */
+int32_t USBD_NCM_NtbParse(uint8_t *buf, uint32_t len, USBD_NCM_FrameCallback callback)
+{
+	uint32_t block, ndp, ndp_len, entry, index, length;
+	uint32_t signature;
+	int32_t count = 0;
+	uint8_t depth;
+
+	if(len < NCM_NTH16_SIZE)
+		return -1;
+	if((NCM_Get32(&buf[0]) != NCM_NTH16_SIGNATURE) || (NCM_Get16(&buf[4]) != NCM_NTH16_SIZE))
+		return -1;
+
+	block = NCM_Get16(&buf[8]);
+	if((block < NCM_NTH16_SIZE) || (block > len))
+		return -1;
+	ndp = NCM_Get16(&buf[10]);
+
+	for(depth = 0U; (ndp != 0U) && (depth < 8U); depth++)
+	{
+		if((ndp < NCM_NTH16_SIZE) || ((ndp & 0x03U) != 0U) || (ndp + NCM_NDP16_HEAD_SIZE > block))
+			return -1;
+
+		/* "NCM0"不带CRC，"NCM1"的CRC不做校验 */
+		signature = NCM_Get32(&buf[ndp]) & 0x00FFFFFFU;
+		if(signature != (NCM_NDP16_SIGNATURE & 0x00FFFFFFU))
+			return -1;
+		ndp_len = NCM_Get16(&buf[ndp + 4U]);
+		if((ndp_len < NCM_NDP16_HEAD_SIZE + 2U * NCM_NDP16_ENTRY_SIZE) || (ndp + ndp_len > block))
+			return -1;
+
+		for(entry = ndp + NCM_NDP16_HEAD_SIZE; entry + NCM_NDP16_ENTRY_SIZE <= ndp + ndp_len; entry += NCM_NDP16_ENTRY_SIZE)
+		{
+			index = NCM_Get16(&buf[entry]);
+			length = NCM_Get16(&buf[entry + 2U]);
+			if((index == 0U) || (length == 0U))
+				break;
+			if(index + length > block)
+				return -1;
+			if(callback != NULL)
+				callback(&buf[index], (uint16_t)length);
+			count++;
+		}
+
+		ndp = NCM_Get16(&buf[ndp + 6U]);
+	}
+
+	return count;
+}
+
+#if (COM_NCM_ENABLED == 1U)
+
+/* -------------------------------------- NCM Class Funtion ------------------------------------- */
+
+/**
+  * @brief  USBD_NCM_SendNotify 发送下一个待发通知
+  * @param  pdev: 设备实例
+  */
+static void USBD_NCM_SendNotify(USBD_HandleTypeDef *pdev)
+{
+	USBD_NCM_HandleTypeDef *hncm = &USBD_NCM_Handle;
+	uint8_t *p = USBD_NCM_NotifyBuffer;
+	uint32_t speed = (pdev->dev_speed == USBD_SPEED_HIGH) ? NCM_HS_LINK_SPEED : NCM_FS_LINK_SPEED;
+
+	p[0] = 0xA1U;									/* bmRequestType */
+	NCM_Put16(&p[4], COM_NCM_ITF_NBR);				/* wIndex: 通信类接口 */
+
+	switch(hncm->NotifyState)
+	{
+		case NCM_NOTIFY_CONNECTION:
+			p[1] = NCM_NOTIFY_NETWORK_CONNECTION;
+			NCM_Put16(&p[2], (hncm->AltSetting != 0U) ? 1U : 0U);
+			NCM_Put16(&p[6], 0U);
+			hncm->NotifyState = (hncm->AltSetting != 0U) ? NCM_NOTIFY_SPEED : NCM_NOTIFY_IDLE;
+			(void)USBD_LL_Transmit(pdev, COM_NCM_NOTIFY_EP, p, 8U);
+			break;
+
+		case NCM_NOTIFY_SPEED:
+			p[1] = NCM_NOTIFY_CONNECTION_SPEED_CHANGE;
+			NCM_Put16(&p[2], 0U);
+			NCM_Put16(&p[6], 8U);
+			NCM_Put32(&p[8], speed);				/* DLBitRate */
+			NCM_Put32(&p[12], speed);				/* ULBitRate */
+			hncm->NotifyState = NCM_NOTIFY_IDLE;
+			(void)USBD_LL_Transmit(pdev, COM_NCM_NOTIFY_EP, p, 16U);
+			break;
+
+		default:
+			break;
+	}
+}
+
+/**
+  * @brief  USBD_NCM_Kick 端点空闲时发出正在填充的NTB
+  * @note   调用者须已关闭中断或处于USB中断中。
+  * @param  pdev: 设备实例
+  */
+static void USBD_NCM_Kick(USBD_HandleTypeDef *pdev)
+{
+	USBD_NCM_HandleTypeDef *hncm = &USBD_NCM_Handle;
+	USBD_NCM_NtbTypeDef *ntb = &hncm->Ntb[hncm->Fill];
+	uint32_t length;
+
+	if((hncm->TxBusy != 0U) || (hncm->AltSetting == 0U) || (ntb->Count == 0U))
+		return;
+
+	length = USBD_NCM_NtbFinish(ntb, hncm->TxSequence++);
+	hncm->Stats.TxNtbs++;
+	hncm->TxBusy = 1U;
+
+	pdev->ep_in[COM_NCM_IN_EP & 0xFU].total_length = length;
+	(void)USBD_LL_Transmit(pdev, COM_NCM_IN_EP, ntb->Buffer, length);
+
+	/* 切换到另一个缓冲继续填充 */
+	hncm->Fill ^= 1U;
+	USBD_NCM_NtbReset(&hncm->Ntb[hncm->Fill], USBD_NCM_NtbInBuffer[hncm->Fill], hncm->NtbInSize);
+}
+
+/**
+  * @brief  USBD_NCM_Reset 复位NTB状态
+  */
+static void USBD_NCM_Reset(void)
+{
+	USBD_NCM_HandleTypeDef *hncm = &USBD_NCM_Handle;
+
+	hncm->TxBusy = 0U;
+	hncm->Fill = 0U;
+	USBD_NCM_NtbReset(&hncm->Ntb[0], USBD_NCM_NtbInBuffer[0], hncm->NtbInSize);
+	USBD_NCM_NtbReset(&hncm->Ntb[1], USBD_NCM_NtbInBuffer[1], hncm->NtbInSize);
+}
+
+/**
+  * @brief  USBD_NCM_RxFrame NTB解析回调，将帧交给网络协议栈
+  * @param  Buf: 以太网帧
+  * @param  Len: 帧长
+  */
+static void USBD_NCM_RxFrame(uint8_t *Buf, uint16_t Len)
+{
+	USBD_NCM_Handle.Stats.RxFrames++;
+	if(USBD_NCM_Fops->Receive != NULL)
+		USBD_NCM_Fops->Receive(Buf, Len);
+}
+
+/**
+  * @brief  USBD_NCM_Init 打开NCM使用的端点
+  * @param  pdev: 设备实例
+  * @retval 状态
+  */
+uint8_t USBD_NCM_Init(USBD_HandleTypeDef *pdev)
+{
+	USBD_NCM_HandleTypeDef *hncm = &USBD_NCM_Handle;
+	uint16_t pack_size = (pdev->dev_speed == USBD_SPEED_HIGH) ? COM_NCM_HS_DATA_PACK_SIZE : COM_NCM_FS_DATA_PACK_SIZE;
+
+	(void)USBD_memset(hncm, 0, sizeof(USBD_NCM_HandleTypeDef));
+	hncm->CmdOpCode = 0xFFU;
+	hncm->NtbInSize = NCM_NTB_IN_SIZE;
+	USBD_NCM_Reset();
+
+	/* Open EP IN */
+	(void)USBD_LL_OpenEP(pdev, COM_NCM_IN_EP, USBD_EP_TYPE_BULK, pack_size);
+	pdev->ep_in[COM_NCM_IN_EP & 0x0FU].is_used = 1U;
+	pdev->ep_in[COM_NCM_IN_EP & 0x0FU].maxpacket = pack_size;
+
+	/* Open EP OUT */
+	(void)USBD_LL_OpenEP(pdev, COM_NCM_OUT_EP, USBD_EP_TYPE_BULK, pack_size);
+	pdev->ep_out[COM_NCM_OUT_EP & 0x0FU].is_used = 1U;
+	pdev->ep_out[COM_NCM_OUT_EP & 0x0FU].maxpacket = pack_size;
+
+	/* Open Notify IN EP */
+	pdev->ep_in[COM_NCM_NOTIFY_EP & 0x0FU].bInterval = (pdev->dev_speed == USBD_SPEED_HIGH) ? COM_NCM_HS_BINTERVAL : COM_NCM_FS_BINTERVAL;
+	(void)USBD_LL_OpenEP(pdev, COM_NCM_NOTIFY_EP, USBD_EP_TYPE_INTR, COM_NCM_NOTIFY_PACK_SIZE);
+	pdev->ep_in[COM_NCM_NOTIFY_EP & 0x0FU].is_used = 1U;
+	pdev->ep_in[COM_NCM_NOTIFY_EP & 0x0FU].maxpacket = COM_NCM_NOTIFY_PACK_SIZE;
+
+	if(USBD_NCM_Fops->Init != NULL)
+		USBD_NCM_Fops->Init();
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_NCM_DeInit 关闭NCM使用的端点
+  * @param  pdev: 设备实例
+  * @retval 状态
+  */
+uint8_t USBD_NCM_DeInit(USBD_HandleTypeDef *pdev)
+{
+	(void)USBD_LL_CloseEP(pdev, COM_NCM_IN_EP);
+	pdev->ep_in[COM_NCM_IN_EP & 0xFU].is_used = 0U;
+
+	(void)USBD_LL_CloseEP(pdev, COM_NCM_OUT_EP);
+	pdev->ep_out[COM_NCM_OUT_EP & 0xFU].is_used = 0U;
+
+	(void)USBD_LL_CloseEP(pdev, COM_NCM_NOTIFY_EP);
+	pdev->ep_in[COM_NCM_NOTIFY_EP & 0xFU].is_used = 0U;
+	pdev->ep_in[COM_NCM_NOTIFY_EP & 0xFU].bInterval = 0U;
+
+	if(USBD_NCM_Handle.AltSetting != 0U)
+	{
+		USBD_NCM_Handle.AltSetting = 0U;
+		if(USBD_NCM_Fops->LinkState != NULL)
+			USBD_NCM_Fops->LinkState(0U);
+	}
+	if(USBD_NCM_Fops->DeInit != NULL)
+		USBD_NCM_Fops->DeInit();
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_NCM_SetAlt 切换数据接口备用设置
+  * @note   备用设置1启用数据端点并上报连接，备用设置0停止收发。
+  * @param  pdev: 设备实例
+  * @param  alt: 备用设置
+  */
+static void USBD_NCM_SetAlt(USBD_HandleTypeDef *pdev, uint8_t alt)
+{
+	USBD_NCM_HandleTypeDef *hncm = &USBD_NCM_Handle;
+
+	(void)USBD_LL_FlushEP(pdev, COM_NCM_IN_EP);
+	(void)USBD_LL_FlushEP(pdev, COM_NCM_OUT_EP);
+	hncm->AltSetting = alt;
+	USBD_NCM_Reset();
+
+	if(alt != 0U)
+		(void)USBD_LL_PrepareReceive(pdev, COM_NCM_OUT_EP, USBD_NCM_NtbOutBuffer, NCM_NTB_OUT_SIZE);
+
+	if(USBD_NCM_Fops->LinkState != NULL)
+		USBD_NCM_Fops->LinkState(alt);
+
+	hncm->NotifyState = NCM_NOTIFY_CONNECTION;
+	USBD_NCM_SendNotify(pdev);
+}
+
+/**
+  * @brief  USBD_NCM_Setup 处理NCM接口的请求
+  * @param  pdev: 设备实例
+  * @param  req: USB请求
+  * @retval 状态
+  */
+uint8_t USBD_NCM_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+	USBD_NCM_HandleTypeDef *hncm = &USBD_NCM_Handle;
+	uint8_t itf = LOBYTE(req->wIndex);
+	uint8_t ifalt;
+	USBD_StatusTypeDef ret = USBD_OK;
+
+	switch (req->bmRequest & USB_REQ_TYPE_MASK)
+	{
+		case USB_REQ_TYPE_CLASS:
+			switch (req->bRequest)
+			{
+				case NCM_GET_NTB_PARAMETERS:
+					(void)USBD_CtlSendData(pdev, (uint8_t *)USBD_NCM_NtbParameters, MIN(NCM_NTB_PARAMETERS_SIZE, req->wLength));
+					break;
+
+				case NCM_GET_NTB_FORMAT:
+					NCM_Put16((uint8_t *)hncm->data, 0U);
+					(void)USBD_CtlSendData(pdev, (uint8_t *)hncm->data, MIN(2U, req->wLength));
+					break;
+
+				case NCM_SET_NTB_FORMAT:
+					/* 只支持NTB16 */
+					if (req->wValue != 0U)
+					{
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
+					}
+					break;
+
+				case NCM_GET_NTB_INPUT_SIZE:
+					NCM_Put32((uint8_t *)hncm->data, hncm->NtbInSize);
+					(void)USBD_CtlSendData(pdev, (uint8_t *)hncm->data, MIN(4U, req->wLength));
+					break;
+
+				case NCM_SET_NTB_INPUT_SIZE:
+					if ((req->wLength >= 4U) && (req->wLength <= USB_MAX_EP0_SIZE))
+					{
+						hncm->CmdOpCode = req->bRequest;
+						hncm->CmdLength = (uint8_t)req->wLength;
+						(void)USBD_CtlPrepareRx(pdev, (uint8_t *)hncm->data, hncm->CmdLength);
+					}
+					else
+					{
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
+					}
+					break;
+
+				case NCM_SET_ETHERNET_PACKET_FILTER:
+					break;
+
+				default:
+					USBD_CtlError(pdev, req);
+					ret = USBD_FAIL;
+					break;
+			}
+			break;
+
+		case USB_REQ_TYPE_STANDARD:
+			switch (req->bRequest)
+			{
+				case USB_REQ_GET_STATUS:
+					if (pdev->dev_state == USBD_STATE_CONFIGURED)
+						(void)USBD_CtlSendData(pdev, (uint8_t *)&USBD_NCM_StatusReply, 2U);
+					else
+					{
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
+					}
+					break;
+
+				case USB_REQ_GET_INTERFACE:
+					if (pdev->dev_state == USBD_STATE_CONFIGURED)
+					{
+						ifalt = (itf == COM_NCM_ITF_NBR + 1U) ? hncm->AltSetting : 0U;
+						USBD_NCM_AltReply = ifalt;
+						(void)USBD_CtlSendData(pdev, (uint8_t *)&USBD_NCM_AltReply, 1U);
+					}
+					else
+					{
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
+					}
+					break;
+
+				case USB_REQ_SET_INTERFACE:
+					if ((pdev->dev_state == USBD_STATE_CONFIGURED) && (itf == COM_NCM_ITF_NBR + 1U) && (req->wValue <= 1U))
+						USBD_NCM_SetAlt(pdev, (uint8_t)req->wValue);
+					else if ((pdev->dev_state != USBD_STATE_CONFIGURED) || (req->wValue != 0U))
+					{
+						USBD_CtlError(pdev, req);
+						ret = USBD_FAIL;
+					}
+					break;
+
+				case USB_REQ_CLEAR_FEATURE:
+					break;
+
+				default:
+					USBD_CtlError(pdev, req);
+					ret = USBD_FAIL;
+					break;
+			}
+			break;
+
+		default:
+			USBD_CtlError(pdev, req);
+			ret = USBD_FAIL;
+			break;
+	}
+
+	return (uint8_t)ret;
+}
+
+/**
+  * @brief  USBD_NCM_EP0_RxReady 处理带数据阶段的NCM类请求
+  * @param  pdev: 设备实例
+  * @retval 状态
+  */
+uint8_t USBD_NCM_EP0_RxReady(USBD_HandleTypeDef *pdev)
+{
+	USBD_NCM_HandleTypeDef *hncm = &USBD_NCM_Handle;
+	uint32_t size;
+	uint32_t primask;
+
+	if (hncm->CmdOpCode == NCM_SET_NTB_INPUT_SIZE)
+	{
+		size = NCM_Get32((uint8_t *)hncm->data);
+		size = MAX(size, NCM_NTB_MIN_IN_SIZE);
+		size = MIN(size, NCM_NTB_IN_SIZE);
+
+		primask = __get_PRIMASK();
+		__disable_irq();
+		hncm->NtbInSize = size;
+		/* 只影响尚未写入数据的缓冲 */
+		if (hncm->Ntb[hncm->Fill].Count == 0U)
+			hncm->Ntb[hncm->Fill].Size = size;
+		__set_PRIMASK(primask);
+	}
+	hncm->CmdOpCode = 0xFFU;
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_NCM_DataIn NCM输入端点传输完成
+  * @param  pdev: 设备实例
+  * @param  epnum: 端点号
+  * @retval 状态
+  */
+uint8_t USBD_NCM_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+	USBD_NCM_HandleTypeDef *hncm = &USBD_NCM_Handle;
+	PCD_HandleTypeDef *hpcd = (PCD_HandleTypeDef *)pdev->pData;
+
+	if ((epnum | 0x80U) == COM_NCM_NOTIFY_EP)
+	{
+		USBD_NCM_SendNotify(pdev);
+		return (uint8_t)USBD_OK;
+	}
+
+	if ((pdev->ep_in[epnum & 0xFU].total_length > 0U) && ((pdev->ep_in[epnum & 0xFU].total_length % hpcd->IN_ep[epnum & 0xFU].maxpacket) == 0U))
+	{
+		/* 更新数据包总长度 */
+		pdev->ep_in[epnum & 0xFU].total_length = 0U;
+
+		/* 发送ZLP */
+		(void)USBD_LL_Transmit(pdev, epnum, NULL, 0U);
+	}
+	else
+	{
+		hncm->TxBusy = 0U;
+		USBD_NCM_Kick(pdev);
+	}
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_NCM_DataOut NCM输出端点收到一个NTB
+  * @param  pdev: 设备实例
+  * @param  epnum: 端点号
+  * @retval 状态
+  */
+uint8_t USBD_NCM_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+	USBD_NCM_HandleTypeDef *hncm = &USBD_NCM_Handle;
+	uint32_t length = USBD_LL_GetRxDataSize(pdev, epnum);
+
+	if (USBD_NCM_NtbParse(USBD_NCM_NtbOutBuffer, length, USBD_NCM_RxFrame) < 0)
+		hncm->Stats.RxErrors++;
+	else
+		hncm->Stats.RxNtbs++;
+
+	if (hncm->AltSetting != 0U)
+		(void)USBD_LL_PrepareReceive(pdev, COM_NCM_OUT_EP, USBD_NCM_NtbOutBuffer, NCM_NTB_OUT_SIZE);
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_NCM_RegisterInterface 注册网络协议栈接口
+  * @param  fops: 协议栈回调
+  * @retval 状态
+  */
+uint8_t USBD_NCM_RegisterInterface(USBD_NCM_ItfTypeDef *fops)
+{
+	if (fops == NULL)
+		return (uint8_t)USBD_FAIL;
+
+	USBD_NCM_Fops = fops;
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_NCM_Transmit 发送一个以太网帧
+  * @note   帧被复制进正在填充的NTB；端点空闲时立即发出，否则等上一个NTB完成后与其它帧一并发出。
+  * @param  pdev: 设备实例
+  * @param  Buf: 以太网帧
+  * @param  Len: 帧长
+  * @retval USBD_OK，NTB已满返回USBD_BUSY，链路未建立返回USBD_FAIL
+  */
+uint8_t USBD_NCM_Transmit(USBD_HandleTypeDef *pdev, const uint8_t *Buf, uint16_t Len)
+{
+	USBD_NCM_HandleTypeDef *hncm = &USBD_NCM_Handle;
+	uint32_t primask;
+	uint8_t ret;
+
+	if ((Len == 0U) || (Len > NCM_MAX_SEGMENT_SIZE))
+		return (uint8_t)USBD_FAIL;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	if ((pdev->dev_state != USBD_STATE_CONFIGURED) || (hncm->AltSetting == 0U))
+	{
+		__set_PRIMASK(primask);
+		return (uint8_t)USBD_FAIL;
+	}
+
+	ret = USBD_NCM_NtbAppend(&hncm->Ntb[hncm->Fill], Buf, Len);
+	if (ret == USBD_OK)
+	{
+		hncm->Stats.TxFrames++;
+		USBD_NCM_Kick(pdev);
+	}
+	else
+		hncm->Stats.TxDropped++;
+
+	__set_PRIMASK(primask);
+
+	return ret;
+}
+
+/**
+  * @brief  USBD_NCM_GetStats 读取NCM统计
+  * @param  stats: 输出的统计数据
+  */
+void USBD_NCM_GetStats(USBD_NCM_StatsTypeDef *stats)
+{
+	*stats = USBD_NCM_Handle.Stats;
+}
+
+#endif /* COM_NCM_ENABLED */
@@ -0,0 +1,303 @@
+/**
+  ******************************************************************************
+  * @file    usbd_vendor.c
+  * @author  Sunshine Circuit
+  * @brief   该文件提供COMPOSITE设备中厂商自定义批量接口的实现:
+  *           - 不带帧结构的原始数据流，输入输出各一个批量端点
+  *           - 输入方向零拷贝，整块数据一次提交给端点
+  *           - 输出方向乒乓缓冲，一个缓冲交给应用时另一个已在接收
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                厂商接口描述
+  *          ===================================================================
+  *           接口类为0xFF，Windows通过MS OS 2.0描述符集合自动加载WinUSB，
+  *           其它系统直接用libusb访问。端点上没有任何协议，传输边界由
+  *           短包决定：长度为包大小整数倍的发送以零长度包结束。
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32h7xx.h"
+#include "usbd_vendor.h"
+#include "usbd_composite_if.h"
+
+#if (COM_VENDOR_ENABLED == 1U)
+
+/* Typedef -------------------------------------------------------------------*/
+typedef struct
+{
+	uint16_t MaxPacket;								/**< 当前速度下的包大小 */
+	__IO uint8_t TxBusy;
+	uint8_t  RxIndex;								/**< 正在接收的缓冲 */
+	uint8_t  *TxBuffer;
+	uint32_t TxLength;
+	USBD_VENDOR_StatsTypeDef Stats;
+}USBD_VENDOR_HandleTypeDef;
+
+/* Variables -----------------------------------------------------------------*/
+static USBD_VENDOR_HandleTypeDef USBD_VENDOR_Handle;
+static USBD_VENDOR_ItfTypeDef *USBD_VENDOR_Fops = &USBD_VENDOR_Interface_fops_FS;
+
+__ALIGN_BEGIN static uint8_t USBD_VENDOR_RxBuffer[2][VENDOR_RX_BUFFER_SIZE] __ALIGN_END;
+/* GET_STATUS与GET_INTERFACE都应答0；EP0在Setup返回后才发送，应答须在静态区 */
+__ALIGN_BEGIN static uint16_t USBD_VENDOR_ZeroReply __ALIGN_END = 0U;
+
+/* ------------------------------------ Vendor Class Funtion ------------------------------------ */
+
+/**
+  * @brief  USBD_VENDOR_Init 打开厂商接口使用的端点
+  * @param  pdev: 设备实例
+  * @retval 状态
+  */
+uint8_t USBD_VENDOR_Init(USBD_HandleTypeDef *pdev)
+{
+	USBD_VENDOR_HandleTypeDef *hven = &USBD_VENDOR_Handle;
+
+	(void)USBD_memset(hven, 0, sizeof(USBD_VENDOR_HandleTypeDef));
+	hven->MaxPacket = (pdev->dev_speed == USBD_SPEED_HIGH) ? COM_VENDOR_HS_MAX_PACK_SIZE : COM_VENDOR_FS_MAX_PACK_SIZE;
+
+	/* Open EP IN */
+	(void)USBD_LL_OpenEP(pdev, COM_VENDOR_IN_EP, USBD_EP_TYPE_BULK, hven->MaxPacket);
+	pdev->ep_in[COM_VENDOR_IN_EP & 0x0FU].is_used = 1U;
+	pdev->ep_in[COM_VENDOR_IN_EP & 0x0FU].maxpacket = hven->MaxPacket;
+
+	/* Open EP OUT */
+	(void)USBD_LL_OpenEP(pdev, COM_VENDOR_OUT_EP, USBD_EP_TYPE_BULK, hven->MaxPacket);
+	pdev->ep_out[COM_VENDOR_OUT_EP & 0x0FU].is_used = 1U;
+	pdev->ep_out[COM_VENDOR_OUT_EP & 0x0FU].maxpacket = hven->MaxPacket;
+
+	if(USBD_VENDOR_Fops->Init != NULL)
+		USBD_VENDOR_Fops->Init();
+
+	/* 准备Out端点以接收第一段数据 */
+	(void)USBD_LL_PrepareReceive(pdev, COM_VENDOR_OUT_EP, USBD_VENDOR_RxBuffer[0], VENDOR_RX_BUFFER_SIZE);
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_DeInit 关闭厂商接口使用的端点
+  * @param  pdev: 设备实例
+  * @retval 状态
+  */
+uint8_t USBD_VENDOR_DeInit(USBD_HandleTypeDef *pdev)
+{
+	(void)USBD_LL_CloseEP(pdev, COM_VENDOR_IN_EP);
+	pdev->ep_in[COM_VENDOR_IN_EP & 0xFU].is_used = 0U;
+
+	(void)USBD_LL_CloseEP(pdev, COM_VENDOR_OUT_EP);
+	pdev->ep_out[COM_VENDOR_OUT_EP & 0xFU].is_used = 0U;
+
+	USBD_VENDOR_Handle.TxBusy = 0U;
+	if(USBD_VENDOR_Fops->DeInit != NULL)
+		USBD_VENDOR_Fops->DeInit();
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_Setup 处理厂商接口的请求
+  * @note   接口上没有类请求，只应答标准请求。
+  * @param  pdev: 设备实例
+  * @param  req: USB请求
+  * @retval 状态
+  */
+uint8_t USBD_VENDOR_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+	USBD_StatusTypeDef ret = USBD_OK;
+
+	if ((req->bmRequest & USB_REQ_TYPE_MASK) != USB_REQ_TYPE_STANDARD)
+	{
+		USBD_CtlError(pdev, req);
+		return (uint8_t)USBD_FAIL;
+	}
+
+	switch (req->bRequest)
+	{
+		case USB_REQ_GET_STATUS:
+			if (pdev->dev_state == USBD_STATE_CONFIGURED)
+				(void)USBD_CtlSendData(pdev, (uint8_t *)&USBD_VENDOR_ZeroReply, 2U);
+			else
+			{
+				USBD_CtlError(pdev, req);
+				ret = USBD_FAIL;
+			}
+			break;
+
+		case USB_REQ_GET_INTERFACE:
+			if (pdev->dev_state == USBD_STATE_CONFIGURED)
+				(void)USBD_CtlSendData(pdev, (uint8_t *)&USBD_VENDOR_ZeroReply, 1U);
+			else
+			{
+				USBD_CtlError(pdev, req);
+				ret = USBD_FAIL;
+			}
+			break;
+
+		case USB_REQ_SET_INTERFACE:
+			if ((pdev->dev_state != USBD_STATE_CONFIGURED) || (req->wValue != 0U))
+			{
+				USBD_CtlError(pdev, req);
+				ret = USBD_FAIL;
+			}
+			break;
+
+		case USB_REQ_CLEAR_FEATURE:
+			break;
+
+		default:
+			USBD_CtlError(pdev, req);
+			ret = USBD_FAIL;
+			break;
+	}
+
+	return (uint8_t)ret;
+}
+
+/**
+  * @brief  USBD_VENDOR_DataIn 厂商接口输入端点传输完成
+  * @param  pdev: 设备实例
+  * @param  epnum: 端点号
+  * @retval 状态
+  */
+uint8_t USBD_VENDOR_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+	USBD_VENDOR_HandleTypeDef *hven = &USBD_VENDOR_Handle;
+
+	if ((pdev->ep_in[epnum & 0xFU].total_length > 0U) && ((pdev->ep_in[epnum & 0xFU].total_length % hven->MaxPacket) == 0U))
+	{
+		/* 更新数据包总长度 */
+		pdev->ep_in[epnum & 0xFU].total_length = 0U;
+
+		/* 发送ZLP */
+		(void)USBD_LL_Transmit(pdev, epnum, NULL, 0U);
+	}
+	else
+	{
+		hven->Stats.TxBytes += hven->TxLength;
+		hven->Stats.TxTransfers++;
+		hven->TxBusy = 0U;
+
+		if (USBD_VENDOR_Fops->TransmitCplt != NULL)
+			USBD_VENDOR_Fops->TransmitCplt(hven->TxBuffer, hven->TxLength);
+	}
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_DataOut 厂商接口输出端点收到数据
+  * @note   先在另一个缓冲上重新启动接收，再把收到的缓冲交给应用，端点不会因应用处理而停顿。
+  *         应用须在另一个缓冲收满之前处理完数据。
+  * @param  pdev: 设备实例
+  * @param  epnum: 端点号
+  * @retval 状态
+  */
+uint8_t USBD_VENDOR_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+	USBD_VENDOR_HandleTypeDef *hven = &USBD_VENDOR_Handle;
+	uint32_t length = USBD_LL_GetRxDataSize(pdev, epnum);
+	uint8_t *buf = USBD_VENDOR_RxBuffer[hven->RxIndex];
+
+	hven->RxIndex ^= 1U;
+	(void)USBD_LL_PrepareReceive(pdev, COM_VENDOR_OUT_EP, USBD_VENDOR_RxBuffer[hven->RxIndex], VENDOR_RX_BUFFER_SIZE);
+
+	hven->Stats.RxBytes += length;
+	hven->Stats.RxTransfers++;
+	if (USBD_VENDOR_Fops->Receive != NULL)
+		USBD_VENDOR_Fops->Receive(buf, length);
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_RegisterInterface 注册数据流接口
+  * @param  fops: 应用回调
+  * @retval 状态
+  */
+uint8_t USBD_VENDOR_RegisterInterface(USBD_VENDOR_ItfTypeDef *fops)
+{
+	if (fops == NULL)
+		return (uint8_t)USBD_FAIL;
+
+	USBD_VENDOR_Fops = fops;
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_Transmit 发送一块数据
+  * @note   数据直接由端点取走，不复制；在TransmitCplt回调之前缓冲区不得改动。
+  *         一次提交的数据越多，传输间的空闲越少，吞吐越接近总线上限。
+  * @param  pdev: 设备实例
+  * @param  Buf: 数据
+  * @param  Len: 数据长度
+  * @retval USBD_OK，上一次发送未完成返回USBD_BUSY，未枚举或端点启动失败返回USBD_FAIL
+  */
+uint8_t USBD_VENDOR_Transmit(USBD_HandleTypeDef *pdev, uint8_t *Buf, uint32_t Len)
+{
+	USBD_VENDOR_HandleTypeDef *hven = &USBD_VENDOR_Handle;
+	uint32_t primask;
+
+	if (pdev->dev_state != USBD_STATE_CONFIGURED)
+		return (uint8_t)USBD_FAIL;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if (hven->TxBusy != 0U)
+	{
+		__set_PRIMASK(primask);
+		return (uint8_t)USBD_BUSY;
+	}
+	hven->TxBusy = 1U;
+	__set_PRIMASK(primask);
+
+	hven->TxBuffer = Buf;
+	hven->TxLength = Len;
+	pdev->ep_in[COM_VENDOR_IN_EP & 0xFU].total_length = Len;
+	if (USBD_LL_Transmit(pdev, COM_VENDOR_IN_EP, Buf, Len) != USBD_OK)
+	{
+		/* 端点未启动，不会有完成回调，在这里释放 */
+		pdev->ep_in[COM_VENDOR_IN_EP & 0xFU].total_length = 0U;
+		hven->TxBusy = 0U;
+		return (uint8_t)USBD_FAIL;
+	}
+
+	return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_IsTxBusy 查询发送是否在进行
+  * @retval 1为忙
+  */
+uint8_t USBD_VENDOR_IsTxBusy(void)
+{
+	return USBD_VENDOR_Handle.TxBusy;
+}
+
+/**
+  * @brief  USBD_VENDOR_GetStats 读取厂商接口统计
+  * @param  stats: 输出的统计数据
+  */
+void USBD_VENDOR_GetStats(USBD_VENDOR_StatsTypeDef *stats)
+{
+	*stats = USBD_VENDOR_Handle.Stats;
+}
+
+#endif /* COM_VENDOR_ENABLED */
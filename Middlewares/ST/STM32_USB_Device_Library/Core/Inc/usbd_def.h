@@ -74,6 +74,10 @@ extern "C" {
 #define USBD_LPM_ENABLED                                0U
 #endif /* USBD_LPM_ENABLED */
 
+#ifndef USBD_CLASS_BOS_ENABLED
+#define USBD_CLASS_BOS_ENABLED                          0U
+#endif /* USBD_CLASS_BOS_ENABLED */
+
 #ifndef USBD_SELF_POWERED
 #define USBD_SELF_POWERED                               1U
 #endif /*USBD_SELF_POWERED */
@@ -111,6 +115,7 @@ extern "C" {
 #define  USBD_IDX_CDC_IAD_STR							0x09U
 #define  USBD_IDX_MSC_IAD_STR							0x0AU
 #define  USBD_IDX_HID_IAD_STR							0x0BU
+#define  USBD_IDX_NCM_MAC_STR							0x0CU
 
 
 
@@ -136,6 +141,10 @@ extern "C" {
 #define  USB_REQ_SET_INTERFACE                          0x0BU
 #define  USB_REQ_SYNCH_FRAME                            0x0CU
 
+/* MS OS 2.0：主机以厂商请求读取描述符集合，请求码由BOS平台能力描述符给出 */
+#define  USB_REQ_MS_OS_20_VENDOR_CODE                   0x20U
+#define  USB_MS_OS_20_DESCRIPTOR_INDEX                  0x07U
+
 #define  USB_DESC_TYPE_DEVICE                           0x01U
 #define  USB_DESC_TYPE_CONFIGURATION                    0x02U
 #define  USB_DESC_TYPE_STRING                           0x03U
@@ -308,11 +317,13 @@ typedef struct
 	uint8_t *(*GetCDCIADStrDescriptor)(USBD_SpeedTypeDef speed, uint16_t *length);
 	uint8_t *(*GetMSCIADStrDescriptor)(USBD_SpeedTypeDef speed, uint16_t *length);
 	uint8_t *(*GetHIDIADStrDescriptor)(USBD_SpeedTypeDef speed, uint16_t *length);
+	uint8_t *(*GetNCMMacStrDescriptor)(USBD_SpeedTypeDef speed, uint16_t *length);
 #if (USBD_CLASS_USER_STRING_DESC == 1)
 	uint8_t *(*GetUserStrDescriptor)(USBD_SpeedTypeDef speed, uint8_t idx, uint16_t *length);
 #endif /* USBD_CLASS_USER_STRING_DESC */
 #if ((USBD_LPM_ENABLED == 1U) || (USBD_CLASS_BOS_ENABLED == 1))
 	uint8_t *(*GetBOSDescriptor)(USBD_SpeedTypeDef speed, uint16_t *length);
+	uint8_t *(*GetMSOS20Descriptor)(USBD_SpeedTypeDef speed, uint16_t *length);
 #endif /* (USBD_LPM_ENABLED == 1U) || (USBD_CLASS_BOS_ENABLED == 1) */
 }USBD_DescriptorsTypeDef;
 
@@ -105,8 +105,33 @@ USBD_StatusTypeDef USBD_StdDevReq(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef
 
   switch (req->bmRequest & USB_REQ_TYPE_MASK)
   {
-    case USB_REQ_TYPE_CLASS:
     case USB_REQ_TYPE_VENDOR:
+#if (USBD_CLASS_BOS_ENABLED == 1U)
+      /* MS OS 2.0描述符集合，Windows据此自动绑定WinUSB */
+      if ((req->bRequest == USB_REQ_MS_OS_20_VENDOR_CODE) &&
+          (req->wIndex == USB_MS_OS_20_DESCRIPTOR_INDEX) &&
+          ((req->bmRequest & 0x80U) != 0U))
+      {
+        uint8_t *pbuf;
+        uint16_t len;
+
+        if ((pdev->pDesc->GetMSOS20Descriptor != NULL) && (req->wLength != 0U))
+        {
+          pbuf = pdev->pDesc->GetMSOS20Descriptor(pdev->dev_speed, &len);
+          len = MIN(len, req->wLength);
+          (void)USBD_CtlSendData(pdev, pbuf, len);
+        }
+        else
+        {
+          USBD_CtlError(pdev, req);
+        }
+        break;
+      }
+#endif /* USBD_CLASS_BOS_ENABLED */
+      ret = (USBD_StatusTypeDef)pdev->pClass[pdev->classId]->Setup(pdev, req);
+      break;
+
+    case USB_REQ_TYPE_CLASS:
       ret = (USBD_StatusTypeDef)pdev->pClass[pdev->classId]->Setup(pdev, req);
       break;
 
@@ -626,6 +651,18 @@ static void USBD_GetDescriptor(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *r
           }
           break;
 
+        case USBD_IDX_NCM_MAC_STR:
+          if (pdev->pDesc->GetNCMMacStrDescriptor != NULL)
+          {
+            pbuf = pdev->pDesc->GetNCMMacStrDescriptor(pdev->dev_speed, &len);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            err++;
+          }
+          break;
+
         default:
 #if (USBD_SUPPORT_USER_STRING_DESC == 1U)
           pbuf = NULL;
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+cdcmux.py - CDC复用器(USB_DEVICE/App/usbd_cdc_mux.c)的主机端解复用模块
+
+dlog.py等工具共用本模块，从CDC数据流中按帧头重同步并分离各通道的负载。
+只依赖Python标准库。
+
+用法:
+    cdcmux.py /dev/ttyACM0                     统计各通道的帧数、字节数与丢帧
+    cdcmux.py capture.bin --channel 0 > out    导出一个通道的负载
+"""
+
+import argparse
+import sys
+
+# 与usbd_cdc_mux.h保持一致
+CDC_MUX_SYNC = 0xA5
+CDC_MUX_HEAD_SIZE = 4
+CDC_MUX_CH_CMD = 0
+CDC_MUX_CH_TELEMETRY = 1
+CDC_MUX_CH_LOG = 2
+CDC_MUX_CH_BULK = 3
+CDC_MUX_CH_MAX = 16
+
+CHANNEL_NAMES = {
+    CDC_MUX_CH_CMD: "cmd",
+    CDC_MUX_CH_TELEMETRY: "telemetry",
+    CDC_MUX_CH_LOG: "log",
+    CDC_MUX_CH_BULK: "bulk",
+}
+
+
+class Demux(object):
+    """增量解复用器，feed()返回已完整到达的(通道号, 负载)"""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.seq = [None] * CDC_MUX_CH_MAX
+        self.frames = [0] * CDC_MUX_CH_MAX
+        self.bytes = [0] * CDC_MUX_CH_MAX
+        self.lost = [0] * CDC_MUX_CH_MAX
+        self.skipped = 0
+
+    def feed(self, data):
+        buf = self.buf
+        buf += data
+        out = []
+        pos = 0
+        while len(buf) - pos >= CDC_MUX_HEAD_SIZE:
+            if buf[pos] != CDC_MUX_SYNC or buf[pos + 3] != (buf[pos + 1] ^ buf[pos + 2] ^ CDC_MUX_SYNC):
+                pos += 1
+                self.skipped += 1
+                continue
+            end = pos + CDC_MUX_HEAD_SIZE + buf[pos + 2]
+            if len(buf) < end:
+                break
+            ch = buf[pos + 1] >> 4
+            seq = buf[pos + 1] & 0x0F
+            # 序号只有4位，相邻两帧之间丢失16的整数倍帧时无法发现
+            if self.seq[ch] is not None:
+                self.lost[ch] += (seq - self.seq[ch] - 1) & 0x0F
+            self.seq[ch] = seq
+            self.frames[ch] += 1
+            self.bytes[ch] += end - pos - CDC_MUX_HEAD_SIZE
+            out.append((ch, bytes(buf[pos + CDC_MUX_HEAD_SIZE:end])))
+            pos = end
+        del buf[:pos]
+        return out
+
+
+def read_chunks(stream):
+    """从串口或文件逐块读取，流结束时返回"""
+    while True:
+        chunk = stream.read1(4096) if hasattr(stream, "read1") else stream.read(4096)
+        if not chunk:
+            return
+        yield chunk
+
+
+def channel(stream, ch, demux=None):
+    """生成一个通道的负载，其余通道丢弃"""
+    demux = demux if demux is not None else Demux()
+    for chunk in read_chunks(stream):
+        for c, payload in demux.feed(chunk):
+            if c == ch:
+                yield payload
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Split the CDC multiplexer stream into channels")
+    parser.add_argument("input", nargs="?", default="-", help="serial device or capture file, - for stdin")
+    parser.add_argument("--channel", type=int, help="write the payload of this channel to stdout")
+    opts = parser.parse_args()
+
+    stream = sys.stdin.buffer if opts.input == "-" else open(opts.input, "rb", buffering=0)
+    demux = Demux()
+    try:
+        if opts.channel is not None:
+            for payload in channel(stream, opts.channel, demux):
+                sys.stdout.buffer.write(payload)
+                sys.stdout.buffer.flush()
+        else:
+            for chunk in read_chunks(stream):
+                demux.feed(chunk)
+    except KeyboardInterrupt:
+        pass
+
+    for ch in range(CDC_MUX_CH_MAX):
+        if demux.frames[ch]:
+            sys.stderr.write("%-10s frames %8d  bytes %10d  lost %6d\n" % (
+                CHANNEL_NAMES.get(ch, str(ch)), demux.frames[ch], demux.bytes[ch], demux.lost[ch]))
+    sys.stderr.write("resync skipped %d bytes\n" % demux.skipped)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
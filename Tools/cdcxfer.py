@@ -0,0 +1,401 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+cdcxfer.py - CDC文件传输服务(USB_DEVICE/App/usbd_cdc_xfer.c)的主机端工具
+
+设备的文件传输通道是一个独立的CDC串口，帧结构见usbd_cdc_xfer.h。
+只依赖Python标准库(串口经termios设为原始模式，仅支持类Unix系统)。
+
+用法:
+    cdcxfer.py /dev/ttyACM1 list 0:/                          列出目录
+    cdcxfer.py /dev/ttyACM1 get 0:/LOG00012.BIN out.bin       读取整个文件
+    cdcxfer.py /dev/ttyACM1 get 0:/LOG00012.BIN out.bin --offset 4096 --length 65536
+    cdcxfer.py /dev/ttyACM1 put cfg.txt 0:/CONFIG.TXT --truncate
+"""
+
+import argparse
+import os
+import select
+import struct
+import sys
+import termios
+import time
+import tty
+import zlib
+
+# 与usbd_cdc_xfer.h保持一致
+SYNC = 0x5A
+HEAD = struct.Struct("<BBHHBBII")
+HEAD_SIZE = 16
+CRC_SIZE = 4
+CHUNK_SIZE = 0x800
+WINDOW_MAX = 32
+
+OP_LIST = 0x01
+OP_GET = 0x02
+OP_PUT = 0x03
+OP_ACK = 0x04
+OP_NAK = 0x05
+OP_ABORT = 0x06
+OP_DATA = 0x10
+OP_ENTRY = 0x11
+OP_INFO = 0x12
+OP_END = 0x13
+
+PUT_TRUNCATE = 0x01
+
+STATUS = {
+    0: "OK",
+    1: "NO_CARD",
+    2: "NOT_FOUND",
+    3: "LOCKED",
+    4: "BAD_REQUEST",
+    5: "IO_ERROR",
+    6: "ABORTED",
+}
+
+# 主机端重发间隔与放弃等待的时间，s
+RESEND_S = 0.5
+IDLE_S = 5.0
+
+
+class XferError(Exception):
+    pass
+
+
+class Frame:
+    __slots__ = ("op", "seq", "status", "window", "offset", "arg", "payload")
+
+    def __init__(self, op, seq, status, window, offset, arg, payload):
+        self.op = op
+        self.seq = seq
+        self.status = status
+        self.window = window
+        self.offset = offset
+        self.arg = arg
+        self.payload = payload
+
+
+class Link:
+    """帧的收发，负责同步、长度与CRC检查"""
+
+    def __init__(self, path):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        self.saved = None
+        if os.isatty(self.fd):
+            self.saved = termios.tcgetattr(self.fd)
+            tty.setraw(self.fd)
+            termios.tcflush(self.fd, termios.TCIOFLUSH)
+        self.buf = bytearray()
+        self.crc_errors = 0
+        self.resyncs = 0
+
+    def close(self):
+        if self.saved is not None:
+            termios.tcsetattr(self.fd, termios.TCSADRAIN, self.saved)
+        os.close(self.fd)
+
+    def send(self, op, seq=0, status=0, window=0, offset=0, arg=0, payload=b""):
+        frame = HEAD.pack(SYNC, op, seq & 0xFFFF, len(payload), status, window,
+                          offset & 0xFFFFFFFF, arg & 0xFFFFFFFF) + payload
+        frame += struct.pack("<I", zlib.crc32(frame) & 0xFFFFFFFF)
+        view = memoryview(frame)
+        while view:
+            n = os.write(self.fd, view)
+            view = view[n:]
+
+    def recv(self, timeout):
+        """返回一个帧，超时返回None"""
+        deadline = time.monotonic() + timeout
+        while True:
+            frame = self._parse()
+            if frame is not None:
+                return frame
+            remain = deadline - time.monotonic()
+            if remain <= 0:
+                return None
+            ready, _, _ = select.select([self.fd], [], [], remain)
+            if ready:
+                data = os.read(self.fd, 65536)
+                if not data:
+                    raise XferError("port closed")
+                self.buf += data
+
+    def _parse(self):
+        buf = self.buf
+        while len(buf) >= HEAD_SIZE:
+            if buf[0] != SYNC:
+                self.resyncs += 1
+                del buf[0]
+                continue
+            _, op, seq, length, status, window, offset, arg = HEAD.unpack_from(buf)
+            if length > CHUNK_SIZE:
+                self.resyncs += 1
+                del buf[0]
+                continue
+            total = HEAD_SIZE + length + CRC_SIZE
+            if len(buf) < total:
+                return None
+            crc, = struct.unpack_from("<I", buf, HEAD_SIZE + length)
+            if zlib.crc32(bytes(buf[:HEAD_SIZE + length])) & 0xFFFFFFFF != crc:
+                self.crc_errors += 1
+                del buf[0]
+                continue
+            payload = bytes(buf[HEAD_SIZE:HEAD_SIZE + length])
+            del buf[:total]
+            return Frame(op, seq, status, window, offset, arg, payload)
+        return None
+
+
+def chunk_offset(start, end, index):
+    """数据块index的文件偏移，与设备端CDC_Xfer_ChunkOffset一致"""
+    if index == 0:
+        return start
+    return min((start & ~(CHUNK_SIZE - 1)) + index * CHUNK_SIZE, end)
+
+
+def chunk_count(start, end):
+    if end <= start:
+        return 0
+    return (end - (start & ~(CHUNK_SIZE - 1)) + CHUNK_SIZE - 1) // CHUNK_SIZE
+
+
+def unwrap(seq, base):
+    """16位序号还原为块号"""
+    diff = (seq - base) & 0xFFFF
+    if diff >= 0x8000:
+        diff -= 0x10000
+    return base + diff
+
+
+def failed(frame):
+    return XferError("failed: %s (%d)" % (STATUS.get(frame.status, frame.status), frame.offset))
+
+
+def request(link, ops, op, **kw):
+    """发送请求并等待指定的应答，请求或应答丢失时重发请求，END按错误处理"""
+    deadline = time.monotonic() + IDLE_S
+    while time.monotonic() < deadline:
+        link.send(op, **kw)
+        until = time.monotonic() + RESEND_S * 2
+        while True:
+            frame = link.recv(max(until - time.monotonic(), 0))
+            if frame is None:
+                break
+            if frame.op == OP_END and OP_END not in ops:
+                raise failed(frame)
+            if frame.op in ops:
+                return frame
+    raise XferError("no response")
+
+
+def fmt_time(fdate, ftime):
+    return "%04d-%02d-%02d %02d:%02d:%02d" % (
+        1980 + (fdate >> 9), (fdate >> 5) & 0x0F, fdate & 0x1F,
+        ftime >> 11, (ftime >> 5) & 0x3F, (ftime & 0x1F) * 2)
+
+
+def do_list(link, path, attempts=3):
+    # 目录项不重发，缺项时重新列出整个目录
+    for _ in range(attempts):
+        entries = []
+        frame = request(link, (OP_ENTRY, OP_END), OP_LIST, payload=path.encode())
+        while frame is not None and frame.op == OP_ENTRY and frame.seq == len(entries) & 0xFFFF:
+            entries.append(frame)
+            frame = link.recv(RESEND_S * 2)
+            while frame is not None and frame.op not in (OP_ENTRY, OP_END):
+                frame = link.recv(RESEND_S * 2)
+        if frame is None or frame.op != OP_END:
+            continue
+        if frame.status != 0:
+            raise failed(frame)
+        if frame.arg != len(entries):
+            continue
+        for e in entries:
+            name = e.payload.decode("ascii", "replace")
+            if e.status & 0x10:
+                name += "/"
+            print("%s %10d  %s" % (fmt_time(e.offset >> 16, e.offset & 0xFFFF), e.arg, name))
+        print("%d entries" % len(entries))
+        return
+    raise XferError("directory listing incomplete")
+
+
+def do_get(link, remote, local, offset, length, window):
+    info = request(link, (OP_INFO,), OP_GET, window=window, offset=offset, arg=length, payload=remote.encode())
+    size = info.arg
+    start = info.offset
+    end = size if length > size - start else start + length
+    chunks = chunk_count(start, end)
+
+    base = 0
+    received = set()
+    nak = -1
+    started = heard = time.monotonic()
+    with open(local, "r+b" if os.path.exists(local) else "wb") as out:
+        while True:
+            frame = link.recv(RESEND_S)
+            if frame is None:
+                # 设备超时后会自行重发，这里再确认一次进度；全部收到后ACK使设备重发丢失的END
+                link.send(OP_ACK, seq=base, arg=bitmap(received, base))
+                if time.monotonic() - heard > IDLE_S:
+                    raise XferError("transfer stalled at chunk %d/%d" % (base, chunks))
+                continue
+            heard = time.monotonic()
+            if frame.op == OP_END:
+                if frame.status != 0:
+                    raise failed(frame)
+                break
+            if frame.op != OP_DATA:
+                continue
+            index = unwrap(frame.seq, base)
+            if base <= index < chunks and index not in received:
+                if frame.offset != chunk_offset(start, end, index) or \
+                        len(frame.payload) != chunk_offset(start, end, index + 1) - frame.offset:
+                    raise XferError("chunk %d has unexpected offset or length" % index)
+                out.seek(frame.offset - start)
+                out.write(frame.payload)
+                received.add(index)
+                while base in received:
+                    received.discard(base)
+                    base += 1
+            # 后面的块先到，说明base丢失或校验错误，请求重发一次
+            if received and nak != base:
+                nak = base
+                link.send(OP_NAK, seq=base)
+            link.send(OP_ACK, seq=base, arg=bitmap(received, base))
+            progress(base, chunks)
+        out.truncate(end - start)
+    report(end - start, started)
+
+
+def do_put(link, local, remote, offset, truncate, window):
+    with open(local, "rb") as f:
+        data = f.read()
+    start = offset
+    end = offset + len(data)
+    chunks = chunk_count(start, end)
+
+    info = request(link, (OP_INFO,), OP_PUT, status=PUT_TRUNCATE if truncate else 0, window=window,
+                   offset=start, arg=len(data), payload=remote.encode())
+    window = min(info.window, WINDOW_MAX) or 1
+
+    def send(index):
+        lo = chunk_offset(start, end, index)
+        hi = chunk_offset(start, end, index + 1)
+        link.send(OP_DATA, seq=index, offset=lo, payload=data[lo - start:hi - start])
+
+    base = 0
+    nxt = 0
+    acked = set()
+    sent = {}
+    started = heard = time.monotonic()
+    while True:
+        now = time.monotonic()
+        for index in range(base, nxt):
+            if index not in acked and now - sent[index] >= RESEND_S * 2:
+                send(index)
+                sent[index] = now
+        while nxt < chunks and nxt - base < window:
+            send(nxt)
+            sent[nxt] = time.monotonic()
+            nxt += 1
+
+        frame = link.recv(RESEND_S)
+        if frame is None:
+            if time.monotonic() - heard > IDLE_S:
+                raise XferError("transfer stalled at chunk %d/%d" % (base, chunks))
+            if base >= chunks:
+                # 全部确认后未收到END，ACK使设备重发END
+                link.send(OP_ACK)
+            continue
+        heard = time.monotonic()
+        if frame.op == OP_END:
+            if frame.status != 0:
+                raise failed(frame)
+            break
+        if frame.op == OP_ACK:
+            index = unwrap(frame.seq, base)
+            if base <= index <= nxt:
+                base = index
+                acked = {i for i in acked if i >= base}
+                for i in range(WINDOW_MAX):
+                    if frame.arg & (1 << i):
+                        acked.add(base + 1 + i)
+            progress(base, chunks)
+        elif frame.op == OP_NAK:
+            index = unwrap(frame.seq, base)
+            if base <= index < nxt and index not in acked:
+                send(index)
+                sent[index] = time.monotonic()
+    report(len(data), started)
+
+
+def bitmap(received, base):
+    value = 0
+    for index in received:
+        if base < index <= base + WINDOW_MAX:
+            value |= 1 << (index - base - 1)
+    return value
+
+
+def progress(done, total):
+    if sys.stderr.isatty():
+        sys.stderr.write("\r%d/%d chunks" % (done, total))
+        sys.stderr.flush()
+
+
+def report(size, started):
+    elapsed = max(time.monotonic() - started, 1e-6)
+    if sys.stderr.isatty():
+        sys.stderr.write("\n")
+    print("%d bytes in %.2f s, %.1f KiB/s" % (size, elapsed, size / elapsed / 1024))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="File transfer over the device's CDC transfer port")
+    parser.add_argument("port", help="serial device of the transfer CDC instance")
+    sub = parser.add_subparsers(dest="command")
+    p = sub.add_parser("list", help="list a directory")
+    p.add_argument("path", nargs="?", default="0:/")
+    p = sub.add_parser("get", help="read a file or a byte range of it")
+    p.add_argument("remote")
+    p.add_argument("local")
+    p.add_argument("--offset", type=int, default=0)
+    p.add_argument("--length", type=int, default=0xFFFFFFFF)
+    p.add_argument("--window", type=int, default=0, help="0 for the device default")
+    p = sub.add_parser("put", help="write a file")
+    p.add_argument("local")
+    p.add_argument("remote")
+    p.add_argument("--offset", type=int, default=0)
+    p.add_argument("--truncate", action="store_true", help="create or truncate the remote file")
+    p.add_argument("--window", type=int, default=0, help="0 for the device default")
+    opts = parser.parse_args()
+
+    if opts.command is None:
+        parser.print_help()
+        return 1
+
+    link = Link(opts.port)
+    try:
+        if opts.command == "list":
+            do_list(link, opts.path)
+        elif opts.command == "get":
+            do_get(link, opts.remote, opts.local, opts.offset, opts.length, opts.window)
+        else:
+            do_put(link, opts.local, opts.remote, opts.offset, opts.truncate, opts.window)
+    except KeyboardInterrupt:
+        link.send(OP_ABORT)
+        return 130
+    except XferError as e:
+        sys.stderr.write("cdcxfer: %s\n" % e)
+        return 1
+    finally:
+        if link.crc_errors or link.resyncs:
+            sys.stderr.write("cdcxfer: %d crc errors, %d bytes skipped\n" % (link.crc_errors, link.resyncs))
+        link.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
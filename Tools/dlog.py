@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+dlog.py - 延迟格式化日志(Core/Src/dlog.c)的主机端解码工具
+
+格式字符串只保存在固件中，本工具从编译生成的ELF文件(Keil的.axf或GCC的.elf)
+读取格式字符串，把设备经CDC复用器LOG通道发来的二进制记录渲染为文本。
+只依赖Python标准库，复用帧由同目录的cdcmux.py解复用。
+
+用法:
+    dlog.py table firmware.axf                 列出全部格式字符串(JSON)
+    dlog.py decode firmware.axf /dev/ttyACM0   解码串口或抓包文件
+    dlog.py decode firmware.axf capture.bin --raw
+                                               输入已是LOG通道的数据，不含复用帧
+
+ELF文件必须与设备上运行的固件一致，格式ID是格式字符串的地址。
+"""
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+import cdcmux
+
+# 与dlog.h保持一致
+DLOG_HEAD = 0xF8
+DLOG_HEAD_MASK = 0xF8
+DLOG_HEADER_SIZE = 9
+DLOG_ARG_MAX = 4
+DLOG_SYMBOL = "DLOG_Fmt"
+
+SHT_SYMTAB = 2
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+
+
+class Elf(object):
+    """只读取32位小端ELF的分配段与符号表"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        d = self.data
+        if d[:4] != b"\x7fELF" or d[4] != 1 or d[5] != 1:
+            raise ValueError("%s: not a 32-bit little-endian ELF file" % path)
+        shoff, = struct.unpack_from("<I", d, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", d, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            self.sections.append(struct.unpack_from("<IIIIIIIIII", d, shoff + i * shentsize))
+
+    def read_string(self, addr):
+        """按地址从已分配的段中取以0结尾的字符串，找不到返回None"""
+        for name, stype, flags, vaddr, offset, size, link, info, align, entsize in self.sections:
+            if stype == SHT_NOBITS or (flags & SHF_ALLOC) == 0:
+                continue
+            if vaddr <= addr < vaddr + size:
+                start = offset + addr - vaddr
+                end = self.data.find(b"\x00", start, offset + size)
+                if end < 0:
+                    end = offset + size
+                return self.data[start:end].decode("utf-8", "replace")
+        return None
+
+    def symbols(self):
+        """生成(名称, 地址)"""
+        for name, stype, flags, vaddr, offset, size, link, info, align, entsize in self.sections:
+            if stype != SHT_SYMTAB:
+                continue
+            strtab = self.sections[link]
+            for i in range(size // 16):
+                st_name, st_value = struct.unpack_from("<II", self.data, offset + i * 16)
+                start = strtab[4] + st_name
+                end = self.data.find(b"\x00", start)
+                yield self.data[start:end].decode("ascii", "replace"), st_value
+
+
+def build_table(elf):
+    """格式ID到格式字符串的表，符号名形如DLOG_Fmt.12(GCC)或func.DLOG_Fmt(armclang)"""
+    table = {}
+    for name, addr in elf.symbols():
+        if DLOG_SYMBOL in name:
+            text = elf.read_string(addr)
+            if text is not None:
+                table[addr] = text
+    return table
+
+
+SPEC = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(?:hh|h|ll|l|z|j|t)?([diouxXcfFeEgGsp%])")
+
+
+def render(fmt, args, elf):
+    """按printf规则用32位参数原值渲染格式字符串"""
+    args = list(args)
+    out = []
+    pos = 0
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if not args:
+            out.append("<missing>")
+            continue
+        raw = args.pop(0)
+        spec = "%" + flags + width + ("." + prec if prec is not None else "")
+        if conv in "di":
+            value = raw - (1 << 32) if raw & 0x80000000 else raw
+            out.append((spec + "d") % value)
+        elif conv in "uoxX":
+            out.append((spec + conv.replace("u", "d")) % raw)
+        elif conv == "c":
+            out.append((spec + "c") % chr(raw & 0xFF))
+        elif conv in "fFeEgG":
+            out.append((spec + conv) % struct.unpack("<f", struct.pack("<I", raw))[0])
+        elif conv == "s":
+            text = elf.read_string(raw)
+            out.append((spec + "s") % (text if text is not None else "<0x%08x>" % raw))
+        else:
+            out.append("0x%08x" % raw)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def decode(chunks, elf, table, write):
+    """LOG通道字节流中混有usb_printf文本与DLOG记录，逐行输出"""
+    buf = bytearray()
+    text = bytearray()
+    for chunk in chunks:
+        buf += chunk
+        while buf:
+            if (buf[0] & DLOG_HEAD_MASK) != DLOG_HEAD:
+                text.append(buf.pop(0))
+                if text.endswith(b"\n"):
+                    write(text.decode("utf-8", "replace"))
+                    text.clear()
+                continue
+            argc = buf[0] & 0x07
+            length = DLOG_HEADER_SIZE + 4 * argc
+            if argc > DLOG_ARG_MAX:
+                del buf[0]
+                continue
+            if len(buf) < length:
+                break
+            fid, tick = struct.unpack_from("<II", buf, 1)
+            args = struct.unpack_from("<%dI" % argc, buf, DLOG_HEADER_SIZE)
+            del buf[:length]
+            fmt = table.get(fid)
+            if fmt is None:
+                fmt = elf.read_string(fid)
+                if fmt is None:
+                    fmt = "<unknown format 0x%08x>" % fid + " %x" * argc
+                table[fid] = fmt
+            line = "[%10.3f] %s" % (tick / 1000.0, render(fmt, args, elf))
+            write(line if line.endswith("\n") else line + "\n")
+    if text:
+        write(text.decode("utf-8", "replace"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode deferred binary logs from the device")
+    sub = parser.add_subparsers(dest="command")
+    p = sub.add_parser("table", help="dump the format string table as JSON")
+    p.add_argument("elf")
+    p = sub.add_parser("decode", help="render log records from a serial port or capture file")
+    p.add_argument("elf")
+    p.add_argument("input", nargs="?", default="-", help="serial device or capture file, - for stdin")
+    p.add_argument("--raw", action="store_true", help="input is LOG channel data without mux frames")
+    opts = parser.parse_args()
+
+    if opts.command is None:
+        parser.print_help()
+        return 1
+
+    elf = Elf(opts.elf)
+    table = build_table(elf)
+    if opts.command == "table":
+        json.dump({"0x%08x" % k: v for k, v in sorted(table.items())}, sys.stdout, indent=2, ensure_ascii=False)
+        sys.stdout.write("\n")
+        return 0
+
+    stream = sys.stdin.buffer if opts.input == "-" else open(opts.input, "rb", buffering=0)
+    chunks = cdcmux.read_chunks(stream) if opts.raw else cdcmux.channel(stream, cdcmux.CDC_MUX_CH_LOG)
+
+    def write(s):
+        sys.stdout.write(s)
+        sys.stdout.flush()
+
+    try:
+        decode(chunks, elf, table, write)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
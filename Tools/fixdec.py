@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+fixdec.py - 记录文件中FIX定位结果(Core/Src/fix_codec.c)的主机端解码工具
+
+读取SD卡上的记录文件(LOGnnnnn.BIN，经MSC拷出或由cdcxfer.py读取)或区间查询
+输出的记录流，把LOGGER_TYPE_FIX记录中的编码块还原为逐历元的定位结果，输出CSV。
+每条FIX记录以关键帧开始，可以独立解码。只依赖Python标准库。
+
+用法:
+    fixdec.py LOG00012.BIN > fixes.csv          全部定位结果
+    fixdec.py query.bin --stats                 只统计记录数、定位结果数与编码长度
+
+CSV各列: tick(ms), time(UTC), lat, lon(度), alt(m), speed(节), course(度),
+hdop, quality, sats；没有同历元RMC时speed与course为空。
+"""
+
+import argparse
+import collections
+import struct
+import sys
+
+# 与logger.h保持一致
+LOGGER_SYNC = 0xA5
+LOGGER_HEADER = struct.Struct("<BBHI")
+LOGGER_HEADER_SIZE = 8
+LOGGER_RECORD_MAX = 0x408
+LOGGER_TYPE_FIX = 0x04
+LOGGER_TYPE_INDEX = 0x7F
+
+# 与fix_codec.h保持一致
+FIX_KEY_INTERVAL = 16
+FIX_FIELD_NUM = 8
+FIX_FIELD_LINEAR = 4
+FIX_HEADER_KEY = 0x01
+FIX_INVALID = 0xFFFFFFFF
+
+MASK32 = 0xFFFFFFFF
+
+Fix = collections.namedtuple(
+    "Fix", "time latitude longitude altitude speed course hdop quality satellites")
+
+
+def records(data):
+    """按logger.h的记录格式逐条返回(type, tick, payload, offset)
+
+    跳过记录之间的0x00；遇到其他字节、不完整的记录或文件号与第一个INDEX
+    不同的INDEX记录(掉电后预分配空间中的旧数据)即为数据结尾，与
+    Logger_QueryRead的判断相同。
+    """
+    pos = 0
+    size = len(data)
+    file_index = None
+    while pos < size:
+        if data[pos] == 0:
+            pos += 1
+            continue
+        if data[pos] != LOGGER_SYNC or pos + LOGGER_HEADER_SIZE > size:
+            return
+        _, rtype, length, tick = LOGGER_HEADER.unpack_from(data, pos)
+        end = pos + LOGGER_HEADER_SIZE + length
+        if length > LOGGER_RECORD_MAX or end > size:
+            return
+        payload = bytes(data[pos + LOGGER_HEADER_SIZE:end])
+        if rtype == LOGGER_TYPE_INDEX:
+            if length < 8:
+                return
+            index = struct.unpack_from("<I", payload)[0]
+            if file_index is None:
+                file_index = index
+            if index != file_index:
+                return
+        else:
+            yield rtype, tick, payload, pos
+        pos = end
+
+
+def get_varint(buf, pos):
+    """读取LEB128变长整数，返回(值, 新位置)；不完整或超过5字节返回None"""
+    value = 0
+    for n in range(5):
+        if pos + n >= len(buf):
+            return None
+        byte = buf[pos + n]
+        value |= (byte & 0x7F) << (7 * n)
+        if byte & 0x80 == 0:
+            return value & MASK32, pos + n + 1
+    return None
+
+
+def unzigzag(value):
+    return (value >> 1) ^ (-(value & 1) & MASK32)
+
+
+def signed(value):
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+class FixDecoder(object):
+    """与fix_codec.c的FIX_Decode相同的解码状态"""
+
+    def __init__(self):
+        self.reset()
+
+    def reset(self):
+        self.last = [0] * FIX_FIELD_NUM
+        self.step = [0] * FIX_FIELD_LINEAR
+        self.synced = False
+
+    def predict(self, i):
+        if i < FIX_FIELD_LINEAR:
+            return (self.last[i] + self.step[i]) & MASK32
+        return self.last[i]
+
+    def decode(self, buf, pos):
+        """解码一个定位结果，返回(Fix, 新位置)；无法解码返回None"""
+        got = get_varint(buf, pos)
+        if got is None or got[0] > 0x1FF:
+            return None
+        header, pos = got
+        key = header & FIX_HEADER_KEY
+        if not key and not self.synced:
+            return None
+
+        field = []
+        for i in range(FIX_FIELD_NUM):
+            value = 0
+            if key or header & (2 << i):
+                got = get_varint(buf, pos)
+                if got is None:
+                    return None
+                value, pos = unzigzag(got[0]), got[1]
+            field.append(value if key else (self.predict(i) + value) & MASK32)
+
+        for i in range(FIX_FIELD_LINEAR):
+            self.step[i] = 0 if key else (field[i] - self.last[i]) & MASK32
+        self.last = field
+        self.synced = True
+
+        status = field[7]
+        fix = Fix(field[0], signed(field[1]), signed(field[2]), signed(field[3]),
+                  field[4], field[5], field[6] & 0xFFFF, (status >> 8) & 0xFF, status & 0xFF)
+        return fix, pos
+
+
+def decode_block(payload):
+    """解码一条FIX记录的负载，返回(定位结果列表, 未能解码的字节数)"""
+    decoder = FixDecoder()
+    fixes = []
+    pos = 0
+    while pos < len(payload):
+        got = decoder.decode(payload, pos)
+        if got is None:
+            break
+        fixes.append(got[0])
+        pos = got[1]
+    return fixes, len(payload) - pos
+
+
+def format_fix(tick, fix):
+    """一个定位结果的CSV行"""
+    ms = fix.time
+    text = "%u,%02u:%02u:%02u.%03u,%.7f,%.7f,%.3f," % (
+        tick, ms // 3600000, ms // 60000 % 60, ms // 1000 % 60, ms % 1000,
+        fix.latitude / 1e7, fix.longitude / 1e7, fix.altitude / 1000.0)
+    if fix.speed != FIX_INVALID:
+        text += "%.3f," % (fix.speed / 1000.0)
+    else:
+        text += ","
+    if fix.course != FIX_INVALID:
+        text += "%.2f," % (fix.course / 100.0)
+    else:
+        text += ","
+    return text + "%.2f,%u,%u" % (fix.hdop / 100.0, fix.quality, fix.satellites)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="解码记录文件中的FIX定位结果")
+    parser.add_argument("input", help="记录文件或区间查询输出的记录流，'-'为标准输入")
+    parser.add_argument("--stats", action="store_true", help="只输出统计")
+    args = parser.parse_args()
+
+    if args.input == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.input, "rb") as f:
+            data = f.read()
+
+    blocks = fixes = encoded = bad = 0
+    if not args.stats:
+        print("tick,time,lat,lon,alt,speed,course,hdop,quality,sats")
+    for rtype, tick, payload, offset in records(data):
+        if rtype != LOGGER_TYPE_FIX:
+            continue
+        decoded, left = decode_block(payload)
+        blocks += 1
+        fixes += len(decoded)
+        encoded += len(payload) - left
+        if left:
+            bad += 1
+            sys.stderr.write("offset %u: %u bytes not decoded\n" % (offset, left))
+        if not args.stats:
+            # 编码块在下一个定位结果到来(或同步)时写入，块内各历元的Tick
+            # 按定位时间从记录的Tick倒推
+            for fix in decoded:
+                delta = (decoded[-1].time - fix.time) % 86400000
+                print(format_fix((tick - delta) & MASK32, fix))
+
+    if args.stats:
+        print("%u FIX records, %u fixes, %.2f bytes/fix, %u records with undecoded bytes" % (
+            blocks, fixes, float(encoded) / fixes if fixes else 0.0, bad))
+    return 1 if bad else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+test_cdcmux.py - cdcmux.py解复用器的测试
+
+按usbd_cdc_mux.h的帧结构构造数据流，检查:
+    - 各通道负载按原顺序分离，帧在任意位置被分块送入时结果不变
+    - 帧间的噪声与头校验错误的伪帧被跳过并计数
+    - 各通道的帧序号跳变计为丢帧
+    - 最长负载(255字节)与空负载
+
+用法:
+    python3 Tools/test_cdcmux.py
+"""
+
+import random
+import sys
+import unittest
+
+import cdcmux
+
+
+def frame(ch, seq, payload):
+    """按usbd_cdc_mux.c的方式组帧"""
+    chseq = ((ch & 0x0F) << 4) | (seq & 0x0F)
+    length = len(payload)
+    return bytes([cdcmux.CDC_MUX_SYNC, chseq, length, chseq ^ length ^ cdcmux.CDC_MUX_SYNC]) + payload
+
+
+def stream(rng, count, payload_max):
+    """随机通道与长度的帧序列，返回(数据流, 期望的(通道, 负载)列表)"""
+    seq = [0] * cdcmux.CDC_MUX_CH_MAX
+    data = bytearray()
+    expect = []
+    for _ in range(count):
+        ch = rng.randrange(4)
+        payload = bytes(rng.randrange(256) for _ in range(rng.randrange(payload_max + 1)))
+        data += frame(ch, seq[ch], payload)
+        expect.append((ch, payload))
+        seq[ch] += 1
+    return bytes(data), expect
+
+
+class DemuxTest(unittest.TestCase):
+
+    def test_split(self):
+        rng = random.Random(1)
+        data, expect = stream(rng, 2000, 59)
+        demux = cdcmux.Demux()
+        out = []
+        pos = 0
+        while pos < len(data):
+            step = rng.randrange(1, 200)
+            out += demux.feed(data[pos:pos + step])
+            pos += step
+        self.assertEqual(out, expect)
+        self.assertEqual(demux.skipped, 0)
+        self.assertEqual(sum(demux.lost), 0)
+        self.assertEqual(sum(demux.frames), len(expect))
+
+    def test_bytewise(self):
+        data, expect = stream(random.Random(2), 200, 59)
+        demux = cdcmux.Demux()
+        out = []
+        for b in data:
+            out += demux.feed(bytes([b]))
+        self.assertEqual(out, expect)
+
+    def test_resync(self):
+        demux = cdcmux.Demux()
+        good = frame(cdcmux.CDC_MUX_CH_LOG, 0, b"hello")
+        bad = bytearray(frame(cdcmux.CDC_MUX_CH_CMD, 0, b"xx"))
+        bad[3] ^= 0x01
+        noise = b"\x00\x11\xA5\x22"
+        out = demux.feed(noise + bytes(bad) + good)
+        self.assertEqual(out, [(cdcmux.CDC_MUX_CH_LOG, b"hello")])
+        self.assertEqual(demux.skipped, len(noise) + len(bad))
+
+    def test_lost(self):
+        demux = cdcmux.Demux()
+        data = frame(1, 14, b"a") + frame(1, 15, b"b") + frame(1, 3, b"c") + frame(2, 5, b"d")
+        out = demux.feed(data)
+        self.assertEqual([p for _, p in out], [b"a", b"b", b"c", b"d"])
+        # 15之后的0、1、2丢失，序号回绕
+        self.assertEqual(demux.lost[1], 3)
+        self.assertEqual(demux.lost[2], 0)
+
+    def test_length_limits(self):
+        demux = cdcmux.Demux()
+        longest = bytes(range(256))[:255]
+        out = demux.feed(frame(3, 0, longest) + frame(0, 0, b""))
+        self.assertEqual(out, [(3, longest), (0, b"")])
+        # 不完整的帧保留到后续数据到达
+        partial = frame(2, 0, b"tail")
+        self.assertEqual(demux.feed(partial[:-1]), [])
+        self.assertEqual(demux.feed(partial[-1:]), [(2, b"tail")])
+
+
+if __name__ == "__main__":
+    sys.exit(0 if unittest.main(exit=False).result.wasSuccessful() else 1)
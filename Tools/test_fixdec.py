@@ -0,0 +1,253 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+test_fixdec.py - fixdec.py解码器的测试
+
+检查:
+    - fix_codec.c编码的数据(模拟行驶，含一个没有同历元RMC的历元)逐字段还原
+    - 按fix_codec.h格式的参考编码器编码的随机数据往返不变，每16个一个关键帧，
+      含FIX_INVALID与取极值、差分回绕的字段
+    - 记录之间的0x00被跳过，文件号不同的INDEX与非同步字节视为数据结尾
+    - 截断、关键帧之前的差分帧、非法头与过长的变长整数不解码
+
+用法:
+    python3 Tools/test_fixdec.py
+"""
+
+import random
+import struct
+import sys
+import unittest
+
+import fixdec
+
+MASK32 = fixdec.MASK32
+
+# fix_codec.c的输出：关键帧加15个差分帧为一块，之后是下一块的关键帧与一个差分帧。
+# 第6个历元的Speed与Course为FIX_INVALID
+STREAM = bytes.fromhex(
+    "018097b922a0b2e9a90296a5bc860988c301a48a01e6b701a8019810"
+    "7ec80123500d20a002"
+    "74070b1aca01"
+    "7c0104182be801"
+    "7c0202130dda02"
+    "780b1aa58a0193c001"
+    "7c01083ac68a01dac301"
+    "7c0209250cd401"
+    "7c0b04371dda02"
+    "7c0a06420df001"
+    "7c03072d01a601"
+    "7c0f0b1801be02"
+    "7c100c250eec01"
+    "6c07032eb002"
+    "78033c0d8c01"
+    "7c02010b0eb802"
+    "0180b0b922fcabe9a902beaebc8609ccc301988a01a6d701a8019810"
+    "7ec8013b3e131aee01"
+)
+BLOCK_SPLIT = 137
+
+EXPECT = [
+    (36120000, 312290448, 1214744907, 12484, 8850, 11763, 84, 4, 12),
+    (36120100, 312290430, 1214744947, 12477, 8866, 11907, 84, 4, 12),
+    (36120200, 312290408, 1214744987, 12464, 8879, 12008, 84, 4, 12),
+    (36120300, 312290385, 1214745029, 12463, 8857, 12124, 84, 4, 12),
+    (36120400, 312290363, 1214745072, 12452, 8850, 12297, 84, 4, 12),
+    (36120500, 312290341, 1214745109, 12454, 4294967295, 4294967295, 84, 4, 12),
+    (36120600, 312290318, 1214745150, 12485, 8866, 12524, 84, 4, 12),
+    (36120700, 312290296, 1214745186, 12497, 8872, 12630, 84, 4, 12),
+    (36120800, 312290268, 1214745224, 12481, 8857, 12803, 84, 4, 12),
+    (36120900, 312290245, 1214745265, 12498, 8850, 12923, 84, 4, 12),
+    (36121000, 312290220, 1214745302, 12492, 8849, 13006, 84, 4, 12),
+    (36121100, 312290187, 1214745333, 12498, 8848, 13165, 84, 4, 12),
+    (36121200, 312290162, 1214745370, 12485, 8855, 13283, 84, 4, 12),
+    (36121300, 312290133, 1214745405, 12472, 8878, 13435, 84, 4, 12),
+    (36121400, 312290104, 1214745438, 12489, 8871, 13505, 84, 4, 12),
+    (36121500, 312290076, 1214745470, 12500, 8878, 13661, 84, 4, 12),
+    (36121600, 312290046, 1214745503, 12518, 8844, 13779, 84, 4, 12),
+    (36121700, 312290016, 1214745534, 12508, 8857, 13898, 84, 4, 12),
+]
+
+
+def put_varint(value):
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def zigzag(value):
+    value &= MASK32
+    return ((value << 1) ^ (MASK32 if value & 0x80000000 else 0)) & MASK32
+
+
+def fields(fix):
+    return [fix.time & MASK32, fix.latitude & MASK32, fix.longitude & MASK32, fix.altitude & MASK32,
+            fix.speed, fix.course, fix.hdop, (fix.quality << 8) | fix.satellites]
+
+
+class Encoder(object):
+    """按fix_codec.h描述的格式编码，与FIX_Encode无关的另一份实现"""
+
+    def __init__(self):
+        self.count = 0
+        self.last = [0] * fixdec.FIX_FIELD_NUM
+        self.step = [0] * fixdec.FIX_FIELD_LINEAR
+
+    def encode(self, fix):
+        field = fields(fix)
+        key = self.count % fixdec.FIX_KEY_INTERVAL == 0
+        body = bytearray()
+        if key:
+            header = fixdec.FIX_HEADER_KEY
+            for value in field:
+                body += put_varint(zigzag(value))
+        else:
+            header = 0
+            for i, value in enumerate(field):
+                predict = self.last[i]
+                if i < fixdec.FIX_FIELD_LINEAR:
+                    predict = (predict + self.step[i]) & MASK32
+                if value != predict:
+                    header |= 2 << i
+                    body += put_varint(zigzag(value - predict))
+        for i in range(fixdec.FIX_FIELD_LINEAR):
+            self.step[i] = 0 if key else (field[i] - self.last[i]) & MASK32
+        self.last = field
+        self.count += 1
+        return put_varint(header) + bytes(body)
+
+
+def record(rtype, tick, payload):
+    return struct.pack("<BBHI", fixdec.LOGGER_SYNC, rtype, len(payload), tick) + payload
+
+
+def index(file_index, block, tick):
+    return record(fixdec.LOGGER_TYPE_INDEX, tick, struct.pack("<II", file_index, block))
+
+
+class TestGolden(unittest.TestCase):
+
+    def test_blocks(self):
+        fixes, left = fixdec.decode_block(STREAM[:BLOCK_SPLIT])
+        self.assertEqual(left, 0)
+        self.assertEqual([tuple(f) for f in fixes], EXPECT[:16])
+        fixes, left = fixdec.decode_block(STREAM[BLOCK_SPLIT:])
+        self.assertEqual(left, 0)
+        self.assertEqual([tuple(f) for f in fixes], EXPECT[16:])
+
+    def test_reference_encoder(self):
+        # 参考编码器对同样的定位结果输出相同的字节
+        data = bytearray()
+        for block in (EXPECT[:16], EXPECT[16:]):
+            encoder = Encoder()
+            for fix in block:
+                data += encoder.encode(fixdec.Fix(*fix))
+        self.assertEqual(bytes(data), STREAM)
+
+    def test_csv(self):
+        fix = fixdec.Fix(*EXPECT[5])
+        self.assertEqual(fixdec.format_fix(1000, fix),
+                         "1000,10:02:00.500,31.2290341,121.4745109,12.454,,,0.84,4,12")
+        fix = fixdec.Fix(*EXPECT[0])
+        self.assertEqual(fixdec.format_fix(0, fix),
+                         "0,10:02:00.000,31.2290448,121.4744907,12.484,8.850,117.63,0.84,4,12")
+
+
+class TestRoundTrip(unittest.TestCase):
+
+    def random_fix(self, rng, last):
+        extreme = [0, 1, -1, 0x7FFFFFFF, -0x80000000, 0x40000000, -0x40000000]
+        if rng.random() < 0.2:
+            value = lambda: rng.choice(extreme)
+        else:
+            value = lambda: last + rng.randrange(-2000, 2000)
+        invalid = rng.random() < 0.1
+        return fixdec.Fix(
+            value() & MASK32, value(), value(), value(),
+            fixdec.FIX_INVALID if invalid else value() & MASK32,
+            fixdec.FIX_INVALID if invalid else rng.choice([0, 35999, MASK32 - 1]),
+            rng.choice([0, 85, 0xFFFF]), rng.choice([0, 4, 0xFF]), rng.choice([0, 18, 0xFF]))
+
+    def test_random(self):
+        rng = random.Random(36)
+        fixes = []
+        data = bytearray()
+        encoder = Encoder()
+        for n in range(4000):
+            fixes.append(self.random_fix(rng, 100000 * n))
+            data += encoder.encode(fixes[-1])
+
+        # 整个数据流用一个解码状态，关键帧处重新开始
+        decoder = fixdec.FixDecoder()
+        pos = 0
+        for n, fix in enumerate(fixes):
+            got = decoder.decode(data, pos)
+            self.assertIsNotNone(got, "fix %d" % n)
+            self.assertEqual(tuple(got[0]), tuple(fix), "fix %d" % n)
+            pos = got[1]
+        self.assertEqual(pos, len(data))
+
+    def test_extreme_delta(self):
+        # 全部字段出现且残差取最大宽度：头2字节，6个32位字段各5字节，Hdop与Status各3字节
+        zero = fixdec.Fix(0, 0, 0, 0, 0, 0, 0, 0, 0)
+        wide = fixdec.Fix(0x40000000, 0x40000000, -0x40000001, 0x40000000,
+                          0x40000000, 0xC0000000, 0xFFFF, 0xFF, 0xFF)
+        encoder = Encoder()
+        key = encoder.encode(zero)
+        delta = encoder.encode(wide)
+        self.assertEqual(len(key), 9)
+        self.assertEqual(len(delta), 2 + 6 * 5 + 3 + 3)
+        fixes, left = fixdec.decode_block(key + delta)
+        self.assertEqual(left, 0)
+        self.assertEqual([tuple(f) for f in fixes], [tuple(zero), tuple(wide)])
+
+
+class TestRecords(unittest.TestCase):
+
+    def test_padding_and_index(self):
+        first = STREAM[:BLOCK_SPLIT]
+        second = STREAM[BLOCK_SPLIT:]
+        data = (index(12, 0, 100) + record(fixdec.LOGGER_TYPE_FIX, 1700, first) + b"\0" * 13
+                + record(0x01, 1710, b"$GNGGA") + index(12, 1, 1720)
+                + record(fixdec.LOGGER_TYPE_FIX, 1900, second) + b"\0" * 40
+                # 掉电后预分配空间中上一个文件的旧数据
+                + index(11, 2, 5) + record(fixdec.LOGGER_TYPE_FIX, 5, first))
+        got = [(rtype, tick, payload) for rtype, tick, payload, _ in fixdec.records(data)]
+        self.assertEqual(got, [(fixdec.LOGGER_TYPE_FIX, 1700, first), (0x01, 1710, b"$GNGGA"),
+                               (fixdec.LOGGER_TYPE_FIX, 1900, second)])
+
+    def test_end_of_data(self):
+        fix = record(fixdec.LOGGER_TYPE_FIX, 1, STREAM[:BLOCK_SPLIT])
+        self.assertEqual(len(list(fixdec.records(fix + b"\xff" + fix))), 1)
+        self.assertEqual(len(list(fixdec.records(fix + fix[:-1]))), 1)
+        self.assertEqual(len(list(fixdec.records(fix + fix[:5]))), 1)
+
+
+class TestMalformed(unittest.TestCase):
+
+    def test_truncated(self):
+        key_len = 28
+        for n in range(key_len):
+            fixes, left = fixdec.decode_block(STREAM[:n])
+            self.assertEqual(fixes, [])
+            self.assertEqual(left, n)
+        # 块中间截断时已解码的定位结果保留
+        fixes, left = fixdec.decode_block(STREAM[:key_len + 5])
+        self.assertEqual(len(fixes), 1)
+        self.assertEqual(left, 5)
+
+    def test_delta_before_key(self):
+        fixes, left = fixdec.decode_block(STREAM[28:BLOCK_SPLIT])
+        self.assertEqual(fixes, [])
+
+    def test_header_and_varint(self):
+        self.assertIsNone(fixdec.FixDecoder().decode(b"\x80\x04", 0))
+        self.assertIsNone(fixdec.FixDecoder().decode(b"\x80\x80\x80\x80\x80\x00", 0))
+        self.assertIsNone(fixdec.get_varint(b"\x80\x80", 0))
+
+
+if __name__ == "__main__":
+    sys.exit(0 if unittest.main(exit=False).result.wasSuccessful() else 1)
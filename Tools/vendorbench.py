@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+vendorbench.py - 厂商批量接口(usbd_vendor.c)的主机端吞吐测试
+
+用libusb异步传输让多个请求同时排队，端点在两次传输之间不会空闲，
+测得的是设备与总线的上限，而不是主机单次往返的延迟。
+依赖python-libusb1(pip install libusb1)；Windows上接口由MS OS 2.0描述符
+自动绑定WinUSB，Linux上需要对设备有访问权限。
+
+用法:
+    vendorbench.py out                  主机发送，设备VENDOR_Receive_FS丢弃
+    vendorbench.py in                   主机接收，固件需打开VENDOR_BENCH_SOURCE
+    vendorbench.py in --seconds 30 --queue 16 --size 65536
+"""
+
+import argparse
+import sys
+import time
+
+import usb1
+
+# 与usbd_desc.c保持一致
+USBD_VID = 0x8888
+USBD_PID = 0x0000
+VENDOR_CLASS = 0xFF
+
+
+def find_interface(handle):
+    """在当前配置中找厂商接口，返回(接口号, IN端点, OUT端点)"""
+    config = handle.getDevice()[0]
+    for interface in config:
+        for setting in interface:
+            if setting.getClass() != VENDOR_CLASS or setting.getNumEndpoints() != 2:
+                continue
+            ep_in = ep_out = None
+            for endpoint in setting:
+                address = endpoint.getAddress()
+                if address & 0x80:
+                    ep_in = address
+                else:
+                    ep_out = address
+            if ep_in is not None and ep_out is not None:
+                return setting.getNumber(), ep_in, ep_out
+    raise RuntimeError("no vendor interface in the active configuration")
+
+
+class Bench(object):
+    """保持queue个传输在途，统计完成的字节数"""
+
+    def __init__(self, context, handle, endpoint, size, queue, seconds):
+        self.context = context
+        self.handle = handle
+        self.endpoint = endpoint
+        self.size = size
+        self.seconds = seconds
+        self.bytes = 0
+        self.transfers = 0
+        self.errors = 0
+        self.pending = 0
+        self.stop = False
+        self.payload = bytes(bytearray(i & 0xFF for i in range(size)))
+        self.list = [handle.getTransfer() for _ in range(queue)]
+
+    def callback(self, transfer):
+        status = transfer.getStatus()
+        if status == usb1.TRANSFER_COMPLETED:
+            self.bytes += transfer.getActualLength()
+            self.transfers += 1
+        elif status != usb1.TRANSFER_CANCELLED:
+            self.errors += 1
+        if self.stop:
+            self.pending -= 1
+        else:
+            transfer.submit()
+
+    def run(self):
+        for transfer in self.list:
+            if self.endpoint & 0x80:
+                transfer.setBulk(self.endpoint, self.size, self.callback, timeout=1000)
+            else:
+                transfer.setBulk(self.endpoint, self.payload, self.callback, timeout=1000)
+            transfer.submit()
+            self.pending += 1
+
+        # 第一秒作为预热，不计入结果
+        start = time.monotonic()
+        while time.monotonic() - start < 1.0:
+            self.context.handleEventsTimeout(0.1)
+        self.bytes = self.transfers = 0
+        start = time.monotonic()
+        while time.monotonic() - start < self.seconds:
+            self.context.handleEventsTimeout(0.1)
+        elapsed = time.monotonic() - start
+
+        self.stop = True
+        for transfer in self.list:
+            try:
+                transfer.cancel()
+            except usb1.USBError:
+                pass
+        while self.pending > 0:
+            self.context.handleEventsTimeout(0.1)
+        return elapsed
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Measure bulk throughput of the vendor interface")
+    parser.add_argument("direction", choices=("in", "out"))
+    parser.add_argument("--seconds", type=float, default=10.0)
+    parser.add_argument("--queue", type=int, default=8, help="transfers kept in flight")
+    parser.add_argument("--size", type=int, default=16384, help="bytes per transfer")
+    parser.add_argument("--vid", type=lambda x: int(x, 0), default=USBD_VID)
+    parser.add_argument("--pid", type=lambda x: int(x, 0), default=USBD_PID)
+    opts = parser.parse_args()
+
+    with usb1.USBContext() as context:
+        handle = context.openByVendorIDAndProductID(opts.vid, opts.pid)
+        if handle is None:
+            sys.stderr.write("vendorbench: device %04x:%04x not found\n" % (opts.vid, opts.pid))
+            return 1
+        number, ep_in, ep_out = find_interface(handle)
+        handle.setAutoDetachKernelDriver(True)
+        with handle.claimInterface(number):
+            if opts.direction == "in":
+                # 非空输出数据启动设备端数据源，空包停止
+                handle.bulkWrite(ep_out, b"\x01", timeout=1000)
+                bench = Bench(context, handle, ep_in, opts.size, opts.queue, opts.seconds)
+            else:
+                bench = Bench(context, handle, ep_out, opts.size, opts.queue, opts.seconds)
+            elapsed = bench.run()
+            if opts.direction == "in":
+                handle.bulkWrite(ep_out, b"", timeout=1000)
+        speed = handle.getDevice().getDeviceSpeed()
+    print("%s: %d bytes in %.2f s, %.2f MB/s, %d transfers, %d errors (%s speed)" % (
+        opts.direction, bench.bytes, elapsed, bench.bytes / elapsed / 1e6, bench.transfers, bench.errors,
+        {usb1.SPEED_FULL: "full", usb1.SPEED_HIGH: "high"}.get(speed, "unknown")))
+    return 0 if bench.errors == 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
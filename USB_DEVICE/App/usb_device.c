@@ -26,6 +26,12 @@
 #include "usbd_composite_if.h"
 
 /* USER CODE BEGIN Includes */
+#include "usart.h"
+#include "usbd_cdc_bridge.h"
+#include "usbd_cdc_xfer.h"
+#include "usbd_event.h"
+#include "logger.h"
+#include "cmsis_os.h"
 
 /* USER CODE END Includes */
 
@@ -39,13 +45,19 @@
 
 /* USER CODE END PFP */
 
-/* USB Device Core handle declaration. */
+/* USB Device Core handle declaration. 使用OTG_HS时沿用此名，端口由USBD_PORT_ID决定 */
 USBD_HandleTypeDef hUsbDeviceFS;
 
 /*
  * -- Insert your variables declaration here --
  */
 /* USER CODE BEGIN 0 */
+#define USB_DEVICE_DETACH_MS		100U		/**< 切换模式时保持断开的时间，主机据此确认设备拔出 */
+#define USB_DEVICE_RELEASE_MS		3000U		/**< 等待记录任务关闭文件、卸载卡的最长时间 */
+#define USB_DEVICE_MODE_NONE		0xFFU
+
+static __IO uint8_t USB_Device_ModeRequest = USB_DEVICE_MODE_NONE;	/**< 等待切换的模式 */
+__IO uint8_t USB_Device_Online = 1U;
 
 /* USER CODE END 0 */
 
@@ -54,6 +66,111 @@ USBD_HandleTypeDef hUsbDeviceFS;
  */
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief  USB_Device_Start 按指定模式初始化并启动协议栈
+  * @param  mode: COM_MODE_COMPOSITE或COM_MODE_MSC_ONLY
+  * @retval USBD_OK，失败时协议栈保持未初始化，返回USBD_FAIL
+  */
+static uint8_t USB_Device_Start(uint8_t mode)
+{
+	if(USBD_COMPOSITE_SetMode(&hUsbDeviceFS, mode) != USBD_OK)
+		return USBD_FAIL;
+	if(USBD_Init(&hUsbDeviceFS, &FS_Desc, USBD_PORT_ID) != USBD_OK)
+		return USBD_FAIL;
+	if((USBD_RegisterClass(&hUsbDeviceFS, &USBD_COMPOSITE) != USBD_OK) || (USBD_Start(&hUsbDeviceFS) != USBD_OK))
+	{
+		(void)USBD_DeInit(&hUsbDeviceFS);
+		return USBD_FAIL;
+	}
+
+	return USBD_OK;
+}
+
+/**
+  * @brief  USB_Device_ReleaseCard 要求记录任务关闭文件并卸载卡，等待其完成
+  * @note   超时后照常切换，卡交出之前MSC报告介质未就绪。
+  */
+static void USB_Device_ReleaseCard(void)
+{
+	uint32_t wait;
+
+	Logger_Release(1U);
+	for(wait = 0U; (Logger_CardFree() == 0U) && (wait < USB_DEVICE_RELEASE_MS); wait += LOGGER_RELEASE_POLL_MS)
+		osDelay(LOGGER_RELEASE_POLL_MS);
+}
+
+/**
+  * @brief  USB_Device_SwitchMode 以新的运行模式重新枚举
+  * @note   只能在任务中调用，不能在USB回调中调用。先清除USB_Device_Online，之后SDCrad、
+  *         FatFs与传输任务的CDC写入只进入队列，不再访问协议栈；USBD_DeInit关闭全部端点、
+  *         断开上拉并释放PCD，保持断开一段时间后按新模式的描述符与FIFO规划重新初始化。
+  *         CDC操作接口登记在功能表中，重新初始化后仍然有效，桥接与传输不需要重新挂接；
+  *         字符串描述符与USB任务也不重建。
+  *         新模式启动失败时退回复合模式，复合模式也无法启动时设备保持断开。
+  *         进入MSC单独模式前先让记录任务关闭文件、卸载卡，主机拿到的是完整的
+  *         文件系统；回到复合模式(含退回)或设备断开时把卡交还记录任务，由它
+  *         重新挂载并新建文件。
+  * @param  mode: COM_MODE_COMPOSITE或COM_MODE_MSC_ONLY
+  * @retval USBD_OK，模式无效或切换失败时返回USBD_FAIL
+  */
+uint8_t USB_Device_SwitchMode(uint8_t mode)
+{
+	uint8_t result;
+
+	if(mode > COM_MODE_MSC_ONLY)
+		return USBD_FAIL;
+	if(mode == USBD_COMPOSITE_GetMode())
+		return USBD_OK;
+
+	if(mode == COM_MODE_MSC_ONLY)
+		USB_Device_ReleaseCard();
+
+	/* 调用者在关中断状态下检查，写入后任何任务都不会再进入协议栈 */
+	USB_Device_Online = 0U;
+
+	result = (USBD_DeInit(&hUsbDeviceFS) == USBD_OK) ? USBD_OK : USBD_FAIL;
+	osDelay(USB_DEVICE_DETACH_MS);
+
+	if(result == USBD_OK)
+		result = USB_Device_Start(mode);
+	/* 主机不再以MSC单独模式访问卡 */
+	if((mode != COM_MODE_MSC_ONLY) || (result != USBD_OK))
+		Logger_Release(0U);
+	/* 退回复合模式，仍返回USBD_FAIL */
+	if((result != USBD_OK) && (USB_Device_Start(COM_MODE_COMPOSITE) != USBD_OK))
+		return USBD_FAIL;
+
+	USB_Device_Online = 1U;
+	return result;
+}
+
+/**
+  * @brief  USB_Device_RequestMode 登记一次模式切换，由USB_Device_Poll执行
+  * @note   供CDC封装命令等USB回调使用，回调返回后控制传输才能完成。
+  * @param  mode: COM_MODE_COMPOSITE或COM_MODE_MSC_ONLY
+  */
+void USB_Device_RequestMode(uint8_t mode)
+{
+	USB_Device_ModeRequest = mode;
+}
+
+/**
+  * @brief  USB_Device_Poll 执行登记的模式切换与串口桥接的线路编码，在任务中周期调用
+  */
+void USB_Device_Poll(void)
+{
+	uint8_t mode = USB_Device_ModeRequest;
+
+	if(mode != USB_DEVICE_MODE_NONE)
+	{
+		USB_Device_ModeRequest = USB_DEVICE_MODE_NONE;
+		(void)USB_Device_SwitchMode(mode);
+	}
+#if (CDC_BRIDGE_ENABLED == 1U)
+	CDC_Bridge_Poll();
+#endif
+}
+
 /* USER CODE END 1 */
 
 /**
@@ -63,11 +180,16 @@ USBD_HandleTypeDef hUsbDeviceFS;
 void MX_USB_DEVICE_Init(void)
 {
 	/* USER CODE BEGIN USB_DEVICE_Init_PreTreatment */
+	USBD_FS_DescInit();
+#if (USBD_DEFERRED_EVENTS == 1U)
+	/* USB任务须在USBD_Start打开中断之前就绪 */
+	USBD_Event_Init(&hUsbDeviceFS);
+#endif
 
 	/* USER CODE END USB_DEVICE_Init_PreTreatment */
 
 	/* Init Device Library, add supported class and start the library. */
-	if (USBD_Init(&hUsbDeviceFS, &FS_Desc, DEVICE_FS) != USBD_OK)
+	if (USBD_Init(&hUsbDeviceFS, &FS_Desc, USBD_PORT_ID) != USBD_OK)
 		Error_Handler();
 	if (USBD_RegisterClass(&hUsbDeviceFS, &USBD_COMPOSITE) != USBD_OK)
 		Error_Handler();
@@ -76,6 +198,14 @@ void MX_USB_DEVICE_Init(void)
 
 	/* USER CODE BEGIN USB_DEVICE_Init_PostTreatment */
 	HAL_PWREx_EnableUSBVoltageDetector();
+#if (CDC_BRIDGE_ENABLED == 1U)
+	if (CDC_Bridge_Attach(&hUsbDeviceFS, &CDC_Bridge_Uart2) != USBD_OK)
+		Error_Handler();
+#endif
+#if (CDC_XFER_ENABLED == 1U)
+	if (CDC_Xfer_Attach(&hUsbDeviceFS) != USBD_OK)
+		Error_Handler();
+#endif
 
 	/* USER CODE END USB_DEVICE_Init_PostTreatment */
 }
@@ -63,6 +63,9 @@
  * -- Insert your variables declaration here --
  */
 /* USER CODE BEGIN VARIABLES */
+/* 协议栈可用时为1，模式切换期间为0。任务与串口中断调用CDC收发接口前，
+   须在关中断状态下与dev_state一同检查，切换中的USBD_DeInit不会与之交叠 */
+extern __IO uint8_t USB_Device_Online;
 
 /* USER CODE END VARIABLES */
 /**
@@ -81,6 +84,12 @@ void MX_USB_DEVICE_Init(void);
  * -- Insert functions declaration here --
  */
 /* USER CODE BEGIN FD */
+/* 封装命令：切换USB运行模式，Op后跟1字节COM_MODE_xxx；操作码与nmea_filter.h、logger.h共用编号空间 */
+#define USB_DEVICE_OP_MODE			0x20U
+
+uint8_t USB_Device_SwitchMode(uint8_t mode);
+void USB_Device_RequestMode(uint8_t mode);
+void USB_Device_Poll(void);
 
 /* USER CODE END FD */
 /**
@@ -0,0 +1,500 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_cdc_bridge.c
+  * @version        : V1.0
+  * @brief          : CDC与串口之间的透传桥
+  *                   - 主机的SET_LINE_CODING登记后由任务在串口发送空闲时执行
+  *                   - 串口接收由循环DMA写入缓冲，复制到单独的包缓冲后由USB输入端点发送
+  *                   - USB输出数据进入发送队列，由DMA整段发往串口
+  *                   - 发送队列满时暂停输出端点(NAK)，主机DTR无效时不向主机发送
+  *                   - 打开帧调度时每帧读取一次DMA位置，未触发空闲事件的数据也在1ms内发出
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_cdc_bridge.h"
+#include "usb_device.h"
+#include "stm32h7xx.h"
+#include "main.h"
+
+#if (CDC_BRIDGE_ENABLED == 1U)
+
+/* Define --------------------------------------------------------------------*/
+#define CDC_BRIDGE_RX_MASK			(CDC_BRIDGE_UART_RX_SIZE - 1U)
+#define CDC_BRIDGE_TX_MASK			(CDC_BRIDGE_UART_TX_SIZE - 1U)
+#define CDC_BRIDGE_LINE_DTR			0x01U
+
+/* Typedef -------------------------------------------------------------------*/
+typedef struct
+{
+	USBD_HandleTypeDef *pdev;
+	const CDC_BRIDGE_UartTypeDef *Uart;
+	USBD_CDC_LineCodingTypeDef LineCoding;
+	USBD_CDC_LineCodingTypeDef PendingCoding;	/**< 主机设置、尚未作用于串口的线路编码 */
+	__IO uint8_t ConfigPending;		/**< PendingCoding有效，串口发送暂停，等待CDC_Bridge_Poll */
+	__IO uint8_t Reconfig;			/**< 串口正在重新配置，忽略串口事件 */
+	uint8_t LineState;				/**< 主机控制线状态，bit0为DTR */
+
+	/* 串口 -> USB */
+	uint32_t RxHead;				/**< DMA已写入的累计字节数 */
+	uint32_t RxTail;				/**< 已交给USB的累计字节数 */
+	uint32_t RxLastPos;				/**< 上次事件时DMA在缓冲中的位置 */
+	uint32_t InLength;				/**< 正在发送的USB传输长度 */
+	__IO uint8_t InBusy;
+
+	/* USB -> 串口 */
+	uint32_t TxHead;
+	uint32_t TxTail;
+	uint32_t UartTxLength;			/**< 正在发送的DMA长度 */
+	__IO uint8_t UartTxBusy;
+	uint8_t OutPaused;
+
+	CDC_BRIDGE_StatsTypeDef Stats;
+}CDC_BRIDGE_HandleTypeDef;
+
+/* Variables -----------------------------------------------------------------*/
+static CDC_BRIDGE_HandleTypeDef CDC_Bridge;
+
+/* 串口收发缓冲由DMA1访问，CDC_Bridge_Attach检查其地址 */
+__ALIGN_BEGIN static uint8_t CDC_BridgeRxBuffer[CDC_BRIDGE_UART_RX_SIZE] __ALIGN_END;
+__ALIGN_BEGIN static uint8_t CDC_BridgeTxBuffer[CDC_BRIDGE_UART_TX_SIZE] __ALIGN_END;
+__ALIGN_BEGIN static uint8_t CDC_BridgeOutPacket[COM_CDC_DATA_MAX_PACK_SIZE] __ALIGN_END;
+/* 输入传输的数据复制到此，DMA继续写接收缓冲不会改动正在发送的内容 */
+__ALIGN_BEGIN static uint8_t CDC_BridgeInPacket[CDC_BRIDGE_USB_CHUNK] __ALIGN_END;
+
+/* CDC操作接口静态函数 */
+static int8_t CDC_Bridge_Init(void);
+static int8_t CDC_Bridge_DeInit(void);
+static int8_t CDC_Bridge_Control(uint8_t cmd, uint8_t* pbuf, uint16_t length);
+static int8_t CDC_Bridge_Receive(uint8_t* Buf, uint32_t *Len);
+static int8_t CDC_Bridge_TransmitCplt(uint8_t *Buf, uint32_t *Len, uint8_t epnum);
+#if (COM_SOF_ENABLED == 1U)
+static void CDC_Bridge_Sof(USBD_HandleTypeDef *pdev, uint32_t frame);
+#endif
+
+static USBD_CDC_ItfTypeDef CDC_Bridge_fops =
+{
+	CDC_Bridge_Init,
+	CDC_Bridge_DeInit,
+	CDC_Bridge_Control,
+	CDC_Bridge_Receive,
+	CDC_Bridge_TransmitCplt,
+};
+
+/* --------------------------------------- Bridge Funtion --------------------------------------- */
+
+/**
+  * @brief  CDC_Bridge_InKick USB输入端点空闲时发送串口收到的数据
+  * @note   从DMA缓冲复制最多CDC_BRIDGE_USB_CHUNK字节后立即推进读位置。调用者须已关闭中断。
+  */
+static void CDC_Bridge_InKick(void)
+{
+	CDC_BRIDGE_HandleTypeDef *hbr = &CDC_Bridge;
+	uint32_t avail, len, tail, first;
+
+	if((hbr->InBusy != 0U) || (hbr->pdev == NULL) || (USB_Device_Online == 0U) || (hbr->pdev->dev_state != USBD_STATE_CONFIGURED))
+		return;
+
+	avail = hbr->RxHead - hbr->RxTail;
+	if((hbr->LineState & CDC_BRIDGE_LINE_DTR) == 0U)
+	{
+		/* 主机未打开端口，数据无人接收 */
+		hbr->Stats.RxOverrun += avail;
+		hbr->RxTail = hbr->RxHead;
+		return;
+	}
+	if(avail > CDC_BRIDGE_UART_RX_SIZE / 2U)
+	{
+		/* 未读数据即将被DMA覆盖，丢弃最旧的部分 */
+		hbr->Stats.RxOverrun += avail - CDC_BRIDGE_UART_RX_SIZE / 2U;
+		hbr->RxTail = hbr->RxHead - CDC_BRIDGE_UART_RX_SIZE / 2U;
+		avail = CDC_BRIDGE_UART_RX_SIZE / 2U;
+	}
+	if(avail == 0U)
+		return;
+
+	len = MIN(avail, CDC_BRIDGE_USB_CHUNK);
+	tail = hbr->RxTail & CDC_BRIDGE_RX_MASK;
+	first = MIN(len, CDC_BRIDGE_UART_RX_SIZE - tail);
+	memcpy(CDC_BridgeInPacket, &CDC_BridgeRxBuffer[tail], first);
+	memcpy(&CDC_BridgeInPacket[first], CDC_BridgeRxBuffer, len - first);
+	hbr->RxTail += len;
+
+	hbr->InBusy = 1U;
+	hbr->InLength = len;
+	USBD_CDC_SetTxBufferEx(hbr->pdev, CDC_BRIDGE_PORT, CDC_BridgeInPacket, len);
+	if(USBD_CDC_TransmitPacketEx(hbr->pdev, CDC_BRIDGE_PORT) != USBD_OK)
+		hbr->InBusy = 0U;
+}
+
+/**
+  * @brief  CDC_Bridge_UartKick 串口发送空闲时发送队列中的数据
+  * @note   有待执行的线路编码时不再启动，让正在发送的数据发完。调用者须已关闭中断。
+  */
+static void CDC_Bridge_UartKick(void)
+{
+	CDC_BRIDGE_HandleTypeDef *hbr = &CDC_Bridge;
+	uint32_t len;
+
+	if((hbr->UartTxBusy != 0U) || (hbr->ConfigPending != 0U) || (hbr->TxHead == hbr->TxTail))
+		return;
+
+	len = MIN(hbr->TxHead - hbr->TxTail, CDC_BRIDGE_UART_TX_SIZE - (hbr->TxTail & CDC_BRIDGE_TX_MASK));
+	hbr->UartTxBusy = 1U;
+	hbr->UartTxLength = len;
+	hbr->Uart->TxStart(&CDC_BridgeTxBuffer[hbr->TxTail & CDC_BRIDGE_TX_MASK], len);
+}
+
+/**
+  * @brief  CDC_Bridge_RxRestart 重新启动串口接收
+  * @note   DMA从缓冲起点重新写入，未复制的数据丢弃；正在发送的输入传输已是副本，不受影响。
+  */
+static void CDC_Bridge_RxRestart(void)
+{
+	CDC_BRIDGE_HandleTypeDef *hbr = &CDC_Bridge;
+
+	hbr->RxHead = 0U;
+	hbr->RxTail = 0U;
+	hbr->RxLastPos = 0U;
+	hbr->Uart->RxStart(CDC_BridgeRxBuffer, CDC_BRIDGE_UART_RX_SIZE);
+}
+
+/**
+  * @brief  CDC_Bridge_Attach 将串口绑定到桥接CDC实例
+  * @note   在USBD_Start之后、主机配置设备之前调用。
+  * @param  pdev: 设备实例
+  * @param  uart: 串口硬件操作
+  * @retval USBD_OK，uart为空或收发缓冲不在DMA可访问的内存中时返回USBD_FAIL
+  */
+uint8_t CDC_Bridge_Attach(USBD_HandleTypeDef *pdev, const CDC_BRIDGE_UartTypeDef *uart)
+{
+	CDC_BRIDGE_HandleTypeDef *hbr = &CDC_Bridge;
+
+	if((uart == NULL) || !DMA_BUFFER_OK(CDC_BridgeRxBuffer) || !DMA_BUFFER_OK(CDC_BridgeTxBuffer))
+		return USBD_FAIL;
+
+	(void)memset(hbr, 0, sizeof(CDC_BRIDGE_HandleTypeDef));
+	hbr->pdev = pdev;
+	hbr->Uart = uart;
+	hbr->LineCoding.bitrate = 9600U;
+	hbr->LineCoding.datatype = 0x08U;
+
+	CDC_Bridge_RxRestart();
+#if (COM_SOF_ENABLED == 1U)
+	if(uart->RxPos != NULL)
+		(void)USBD_COMPOSITE_SofRegister(CDC_Bridge_Sof);
+#endif
+
+	return USBD_CDC_RegisterInterfaceEx(pdev, CDC_BRIDGE_PORT, &CDC_Bridge_fops);
+}
+
+#if (COM_SOF_ENABLED == 1U)
+/**
+  * @brief  CDC_Bridge_Sof 帧任务，按DMA当前位置推进接收
+  * @note   持续接收时空闲事件迟迟不来，半满事件前的数据由此每帧发出。
+  *         读取位置与推进须在同一临界区内，否则串口事件插入后会把旧位置当作绕回。
+  * @param  pdev: 设备实例
+  * @param  frame: 帧计数
+  */
+static void CDC_Bridge_Sof(USBD_HandleTypeDef *pdev, uint32_t frame)
+{
+	uint32_t primask;
+
+	UNUSED(pdev);
+	UNUSED(frame);
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	CDC_Bridge_UartRxEvent(CDC_Bridge.Uart->RxPos());
+	__set_PRIMASK(primask);
+}
+#endif
+
+/**
+  * @brief  CDC_Bridge_UartRxEvent 串口接收事件，在串口或DMA中断中调用
+  * @note   空闲、半满、全满时都会触发，两次事件间DMA写入量不超过半个缓冲。
+  * @param  pos: DMA在接收缓冲中的当前位置
+  */
+void CDC_Bridge_UartRxEvent(uint32_t pos)
+{
+	CDC_BRIDGE_HandleTypeDef *hbr = &CDC_Bridge;
+	uint32_t primask;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if(hbr->Reconfig != 0U)
+	{
+		/* 接收即将从缓冲起点重新开始 */
+		__set_PRIMASK(primask);
+		return;
+	}
+
+	pos &= CDC_BRIDGE_RX_MASK;
+	hbr->RxHead += (pos - hbr->RxLastPos) & CDC_BRIDGE_RX_MASK;
+	hbr->RxLastPos = pos;
+	CDC_Bridge_InKick();
+
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief  CDC_Bridge_UartTxCplt 串口DMA发送完成，在串口中断中调用
+  */
+void CDC_Bridge_UartTxCplt(void)
+{
+	CDC_BRIDGE_HandleTypeDef *hbr = &CDC_Bridge;
+	uint32_t primask;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	hbr->TxTail += hbr->UartTxLength;
+	hbr->UartTxBusy = 0U;
+	CDC_Bridge_UartKick();
+
+	/* 队列腾出一个包的空间后恢复输出端点 */
+	if((hbr->OutPaused != 0U) && (USB_Device_Online != 0U) && (CDC_BRIDGE_UART_TX_SIZE - (hbr->TxHead - hbr->TxTail) >= COM_CDC_DATA_MAX_PACK_SIZE))
+	{
+		hbr->OutPaused = 0U;
+		USBD_CDC_ReceivePacketEx(hbr->pdev, CDC_BRIDGE_PORT);
+	}
+
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief  CDC_Bridge_UartError 串口错误，在串口中断中调用
+  * @note   HAL在溢出等错误后会停止DMA接收，此处重新启动。
+  */
+void CDC_Bridge_UartError(void)
+{
+	uint32_t primask;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	CDC_Bridge.Stats.UartErrors++;
+	/* 重新配置中的中止也会报告错误，由CDC_Bridge_Poll重新启动接收 */
+	if(CDC_Bridge.Reconfig == 0U)
+		CDC_Bridge_RxRestart();
+
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief  CDC_Bridge_Poll 执行主机设置的线路编码，在任务中周期调用
+  * @note   串口重新配置要中止DMA并等待外设，不能在USB中断或临界区内进行。
+  *         等串口发送空闲后再执行，已发出的数据不会重发，队列中的数据按新编码发出。
+  */
+void CDC_Bridge_Poll(void)
+{
+	CDC_BRIDGE_HandleTypeDef *hbr = &CDC_Bridge;
+	USBD_CDC_LineCodingTypeDef coding;
+	uint32_t primask;
+	uint8_t ret;
+
+	if(hbr->Uart == NULL)
+		return;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if((hbr->ConfigPending == 0U) || (hbr->UartTxBusy != 0U))
+	{
+		__set_PRIMASK(primask);
+		return;
+	}
+	coding = hbr->PendingCoding;
+	hbr->Reconfig = 1U;
+	__set_PRIMASK(primask);
+
+	ret = hbr->Uart->Config(&coding);
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if(ret == 0U)
+		hbr->LineCoding = coding;
+	/* 主机在配置期间再次设置时保留新的请求 */
+	if((hbr->PendingCoding.bitrate == coding.bitrate) && (hbr->PendingCoding.format == coding.format) &&
+	   (hbr->PendingCoding.paritytype == coding.paritytype) && (hbr->PendingCoding.datatype == coding.datatype))
+		hbr->ConfigPending = 0U;
+	__set_PRIMASK(primask);
+
+	/* 配置成功时DMA已被中止，接收从缓冲起点重新开始；不支持的编码不会改动串口 */
+	if(ret == 0U)
+		CDC_Bridge_RxRestart();
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	hbr->Reconfig = 0U;
+	CDC_Bridge_UartKick();
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief  CDC_Bridge_GetStats 读取桥接统计
+  * @param  stats: 输出的统计数据
+  */
+void CDC_Bridge_GetStats(CDC_BRIDGE_StatsTypeDef *stats)
+{
+	if(stats != NULL)
+		*stats = CDC_Bridge.Stats;
+}
+
+/* ------------------------------------ CDC Interface Funtion ----------------------------------- */
+
+/**
+  * @brief  CDC_Bridge_Init 桥接CDC实例初始化
+  * @retval USBD_OK
+  */
+static int8_t CDC_Bridge_Init(void)
+{
+	CDC_BRIDGE_HandleTypeDef *hbr = &CDC_Bridge;
+
+	hbr->InBusy = 0U;
+	hbr->OutPaused = 0U;
+	hbr->LineState = 0U;
+	USBD_CDC_SetTxBufferEx(hbr->pdev, CDC_BRIDGE_PORT, CDC_BridgeInPacket, 0U);
+	USBD_CDC_SetRxBufferEx(hbr->pdev, CDC_BRIDGE_PORT, CDC_BridgeOutPacket);
+
+	return (USBD_OK);
+}
+
+/**
+  * @brief  CDC_Bridge_DeInit 桥接CDC实例去初始化
+  * @retval USBD_OK
+  */
+static int8_t CDC_Bridge_DeInit(void)
+{
+	CDC_Bridge.InBusy = 0U;
+	CDC_Bridge.LineState = 0U;
+
+	return (USBD_OK);
+}
+
+/**
+  * @brief  CDC_Bridge_Control 桥接CDC实例的类请求
+  * @note   线路编码只登记，由CDC_Bridge_Poll在任务中作用于串口；执行前GET_LINE_CODING返回登记的编码，
+  *         执行后返回实际配置，串口不支持的编码不生效。
+  * @param  cmd: 命令代码
+  * @param  pbuf: 缓冲区包含命令数据(请求参数)
+  * @param  length: 数据长度
+  * @retval USBD_OK
+  */
+static int8_t CDC_Bridge_Control(uint8_t cmd, uint8_t* pbuf, uint16_t length)
+{
+	CDC_BRIDGE_HandleTypeDef *hbr = &CDC_Bridge;
+	const USBD_CDC_LineCodingTypeDef *coding;
+	uint32_t primask;
+
+	UNUSED(length);
+
+	switch(cmd)
+	{
+		case CDC_SET_LINE_CODING:
+			primask = __get_PRIMASK();
+			__disable_irq();
+			hbr->PendingCoding.bitrate    = (uint32_t)(pbuf[0] | (pbuf[1] << 8) | (pbuf[2] << 16) | (pbuf[3] << 24));
+			hbr->PendingCoding.format     = pbuf[4];
+			hbr->PendingCoding.paritytype = pbuf[5];
+			hbr->PendingCoding.datatype   = pbuf[6];
+			hbr->ConfigPending = 1U;
+			__set_PRIMASK(primask);
+			break;
+
+		case CDC_GET_LINE_CODING:
+			coding = (hbr->ConfigPending != 0U) ? &hbr->PendingCoding : &hbr->LineCoding;
+			pbuf[0] = (uint8_t)(coding->bitrate);
+			pbuf[1] = (uint8_t)(coding->bitrate >> 8);
+			pbuf[2] = (uint8_t)(coding->bitrate >> 16);
+			pbuf[3] = (uint8_t)(coding->bitrate >> 24);
+			pbuf[4] = coding->format;
+			pbuf[5] = coding->paritytype;
+			pbuf[6] = coding->datatype;
+			break;
+
+		case CDC_SET_CONTROL_LINE_STATE:
+			/* 无数据阶段，pbuf指向请求本身，wValue位于偏移2 */
+			primask = __get_PRIMASK();
+			__disable_irq();
+			hbr->LineState = pbuf[2];
+			/* 端口刚打开时丢弃积压的旧数据 */
+			hbr->RxTail = hbr->RxHead;
+			CDC_Bridge_InKick();
+			__set_PRIMASK(primask);
+			break;
+
+		default:
+			break;
+	}
+
+	return (USBD_OK);
+}
+
+/**
+  * @brief  CDC_Bridge_Receive 主机数据写入串口发送队列，在USB中断中调用
+  * @note   剩余空间不足一个包时不再准备接收，主机被NAK，直到串口发送腾出空间。
+  * @param  Buf: 收到的数据
+  * @param  Len: 数据长度
+  * @retval USBD_OK
+  */
+static int8_t CDC_Bridge_Receive(uint8_t* Buf, uint32_t *Len)
+{
+	CDC_BRIDGE_HandleTypeDef *hbr = &CDC_Bridge;
+	uint32_t head = hbr->TxHead;
+	uint32_t first = MIN(*Len, CDC_BRIDGE_UART_TX_SIZE - (head & CDC_BRIDGE_TX_MASK));
+	uint32_t primask;
+
+	memcpy(&CDC_BridgeTxBuffer[head & CDC_BRIDGE_TX_MASK], Buf, first);
+	memcpy(CDC_BridgeTxBuffer, Buf + first, *Len - first);
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	hbr->TxHead = head + *Len;
+	hbr->Stats.UsbToUart += *Len;
+	CDC_Bridge_UartKick();
+
+	if(CDC_BRIDGE_UART_TX_SIZE - (hbr->TxHead - hbr->TxTail) >= COM_CDC_DATA_MAX_PACK_SIZE)
+		USBD_CDC_ReceivePacketEx(hbr->pdev, CDC_BRIDGE_PORT);
+	else
+	{
+		hbr->OutPaused = 1U;
+		hbr->Stats.OutPaused++;
+	}
+	__set_PRIMASK(primask);
+
+	return (USBD_OK);
+}
+
+/**
+  * @brief  CDC_Bridge_TransmitCplt USB输入传输完成，在USB中断中调用
+  * @param  Buf: 已发送的数据
+  * @param  Len: 数据长度
+  * @param  epnum: 端点号
+  * @retval USBD_OK
+  */
+static int8_t CDC_Bridge_TransmitCplt(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
+{
+	CDC_BRIDGE_HandleTypeDef *hbr = &CDC_Bridge;
+
+	UNUSED(Buf);
+	UNUSED(Len);
+	UNUSED(epnum);
+
+	hbr->Stats.UartToUsb += hbr->InLength;
+	hbr->InBusy = 0U;
+	CDC_Bridge_InKick();
+
+	return (USBD_OK);
+}
+
+#endif /* CDC_BRIDGE_ENABLED */
@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_cdc_bridge.h
+  * @version        : V1.0
+  * @brief          : usbd_cdc_bridge.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_CDC_BRIDGE_H__
+#define __USBD_CDC_BRIDGE_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "usbd_composite.h"
+
+/* 桥接开关，打开后CDC_BRIDGE_PORT对应的CDC实例成为串口透传通道 */
+#define CDC_BRIDGE_ENABLED			0U
+/* 桥接使用的CDC实例，CDC0保留给控制台 */
+#define CDC_BRIDGE_PORT				(COM_CDC_INSTANCE_NUM - 1U)
+
+/* 串口接收DMA循环缓冲与串口发送队列大小，必须为2的幂 */
+#define CDC_BRIDGE_UART_RX_SIZE		0x800U
+#define CDC_BRIDGE_UART_TX_SIZE		0x800U
+/* 单次USB输入传输的上限，不超过接收缓冲的一半 */
+#define CDC_BRIDGE_USB_CHUNK		0x200U
+
+#if (CDC_BRIDGE_ENABLED == 1U) && (COM_CDC_INSTANCE_NUM < 2U)
+#error "CDC bridge needs a dedicated CDC instance, set COM_CDC_INSTANCE_NUM >= 2"
+#endif
+/* USART2_RX(PA3)与OTG_HS的ULPI_D0是同一个引脚 */
+#if (CDC_BRIDGE_ENABLED == 1U) && (USBD_USE_OTG_HS == 1U) && (USBD_HS_ULPI_PHY == 1U)
+#error "CDC bridge on USART2 (PA2/PA3) conflicts with the OTG_HS ULPI pins"
+#endif
+
+/* 串口硬件操作，由外设驱动提供；主机测试时可替换为桩函数 */
+typedef struct
+{
+	uint8_t (* Config)(const USBD_CDC_LineCodingTypeDef *coding);	/**< 按线路编码重新配置串口，在任务中调用，不支持时返回非0 */
+	void (* RxStart)(uint8_t *buf, uint32_t size);				/**< 启动循环DMA接收 */
+	void (* TxStart)(const uint8_t *buf, uint32_t len);			/**< 启动一次DMA发送 */
+	uint32_t (* RxPos)(void);									/**< 读取DMA在接收缓冲中的当前位置，可为NULL */
+}CDC_BRIDGE_UartTypeDef;
+
+typedef struct
+{
+	uint32_t UsbToUart;		/**< 主机发往串口的字节数 */
+	uint32_t UartToUsb;		/**< 串口发往主机的字节数 */
+	uint32_t RxOverrun;		/**< 主机未及时读取，被DMA覆盖而丢弃的字节数 */
+	uint32_t UartErrors;	/**< 串口硬件错误次数(溢出、帧错误、噪声) */
+	uint32_t OutPaused;		/**< 串口发送队列满，暂停USB输出端点的次数 */
+}CDC_BRIDGE_StatsTypeDef;
+
+uint8_t CDC_Bridge_Attach(USBD_HandleTypeDef *pdev, const CDC_BRIDGE_UartTypeDef *uart);
+void CDC_Bridge_UartRxEvent(uint32_t pos);
+void CDC_Bridge_UartTxCplt(void);
+void CDC_Bridge_UartError(void);
+void CDC_Bridge_Poll(void);
+void CDC_Bridge_GetStats(CDC_BRIDGE_StatsTypeDef *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_CDC_BRIDGE_H__ */
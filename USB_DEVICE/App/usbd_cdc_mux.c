@@ -0,0 +1,297 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_cdc_mux.c
+  * @version        : V1.0
+  * @brief          : CDC数据端点上的多通道复用器
+  *                   - 每个逻辑通道拥有独立的发送队列与优先级
+  *                   - IN端点以数据包为粒度在通道间调度，高优先级通道的等待
+  *                     时间不超过一个数据包
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_cdc_mux.h"
+#include "usbd_composite_if.h"
+#include "usb_device.h"
+#include "stm32h7xx.h"
+
+/* Typedef -------------------------------------------------------------------*/
+typedef struct
+{
+	uint8_t *Buffer;				/**< 队列存储区 */
+	uint32_t Mask;					/**< 队列大小减一 */
+	__IO uint32_t Head;				/**< 写位置，仅由生产者修改 */
+	__IO uint32_t Tail;				/**< 读位置，仅由USB中断修改 */
+	uint8_t Priority;				/**< 优先级，数值越小越优先 */
+	uint8_t Seq;					/**< 帧序号 */
+	uint8_t Starve;					/**< 连续让出的包数 */
+	uint32_t TxBytes;
+	uint32_t TxFrames;
+	uint32_t Dropped;
+}CDC_MUX_ChannelTypeDef;
+
+/* Variables -----------------------------------------------------------------*/
+static uint8_t CDC_MUX_CmdQueue[CDC_MUX_CMD_QUEUE_SIZE];
+static uint8_t CDC_MUX_TelemetryQueue[CDC_MUX_TELEMETRY_QUEUE_SIZE];
+static uint8_t CDC_MUX_LogQueue[CDC_MUX_LOG_QUEUE_SIZE];
+static uint8_t CDC_MUX_BulkQueue[CDC_MUX_BULK_QUEUE_SIZE];
+
+static CDC_MUX_ChannelTypeDef CDC_MUX_Channel[CDC_MUX_CH_NUM] =
+{
+	{CDC_MUX_CmdQueue,       CDC_MUX_CMD_QUEUE_SIZE - 1U,       0U, 0U, 0U},
+	{CDC_MUX_TelemetryQueue, CDC_MUX_TELEMETRY_QUEUE_SIZE - 1U, 0U, 0U, 1U},
+	{CDC_MUX_LogQueue,       CDC_MUX_LOG_QUEUE_SIZE - 1U,       0U, 0U, 2U},
+	{CDC_MUX_BulkQueue,      CDC_MUX_BULK_QUEUE_SIZE - 1U,      0U, 0U, 3U},
+};
+
+/* 当前正在发送的帧，在传输完成前不得改动 */
+__ALIGN_BEGIN static uint8_t CDC_MUX_Packet[COM_CDC_DATA_MAX_PACK_SIZE] __ALIGN_END;
+static __IO uint8_t CDC_MUX_Busy = 0U;
+
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+/**
+  * @brief  CDC_MUX_Pick 选出下一个发送的通道
+  * @note   优先级最高的非空通道胜出；让出次数达到上限的通道被提升为最高优先级。
+  * @retval 通道号，无数据时返回CDC_MUX_CH_NUM
+  */
+static uint8_t CDC_MUX_Pick(void)
+{
+	uint8_t ch;
+	uint8_t best = CDC_MUX_CH_NUM;
+
+	for(ch = 0U; ch < CDC_MUX_CH_NUM; ch++)
+	{
+		CDC_MUX_ChannelTypeDef *pch = &CDC_MUX_Channel[ch];
+
+		if(pch->Head == pch->Tail)
+			continue;
+		if(pch->Starve >= CDC_MUX_STARVE_LIMIT)
+			return ch;
+		if((best == CDC_MUX_CH_NUM) || (pch->Priority < CDC_MUX_Channel[best].Priority))
+			best = ch;
+	}
+
+	/* 未被选中的非空通道累计让出次数 */
+	for(ch = 0U; ch < CDC_MUX_CH_NUM; ch++)
+	{
+		CDC_MUX_ChannelTypeDef *pch = &CDC_MUX_Channel[ch];
+
+		if((ch != best) && (pch->Head != pch->Tail))
+			pch->Starve++;
+	}
+
+	return best;
+}
+
+/**
+  * @brief  CDC_MUX_Reset 复位发送状态
+  * @note   在CDC接口初始化时调用，队列中尚未发送的数据保留，待枚举完成后继续发送。
+  */
+void CDC_MUX_Reset(void)
+{
+	CDC_MUX_Busy = 0U;
+}
+
+/**
+  * @brief  CDC_MUX_Write 向通道写入数据
+  * @note   每个通道只允许一个生产者；写入为全有或全无，不会拆散一条消息。
+  * @param  ch: 通道号
+  * @param  buf: 数据
+  * @param  len: 数据长度
+  * @retval USBD_OK，空间不足时返回USBD_BUSY，参数错误返回USBD_FAIL
+  */
+uint8_t CDC_MUX_Write(uint8_t ch, const uint8_t *buf, uint32_t len)
+{
+	CDC_MUX_ChannelTypeDef *pch;
+	uint32_t head, first;
+
+	if((ch >= CDC_MUX_CH_NUM) || (buf == NULL))
+		return USBD_FAIL;
+
+	pch = &CDC_MUX_Channel[ch];
+	if(len > CDC_MUX_Free(ch))
+	{
+		pch->Dropped++;
+		return USBD_BUSY;
+	}
+
+	head = pch->Head;
+	first = MIN(len, pch->Mask + 1U - (head & pch->Mask));
+	memcpy(&pch->Buffer[head & pch->Mask], buf, first);
+	memcpy(pch->Buffer, buf + first, len - first);
+	/* 数据写入完成后再发布新的写位置 */
+	__DMB();
+	pch->Head = head + len;
+
+	CDC_MUX_Kick();
+
+	return USBD_OK;
+}
+
+/**
+  * @brief  CDC_MUX_Reserve 取得通道队列的空闲空间，供调用者直接写入
+  * @note   与CDC_MUX_Write相同，每个通道只允许一个生产者；写入后调用
+  *         CDC_MUX_Commit发布，期间不得再写入该通道。
+  * @param  ch: 通道号
+  * @param  span: 输出的空闲空间
+  * @retval USBD_OK，参数错误返回USBD_FAIL
+  */
+uint8_t CDC_MUX_Reserve(uint8_t ch, CDC_MUX_SpanTypeDef *span)
+{
+	CDC_MUX_ChannelTypeDef *pch;
+
+	if((ch >= CDC_MUX_CH_NUM) || (span == NULL))
+		return USBD_FAIL;
+
+	pch = &CDC_MUX_Channel[ch];
+	span->Buffer = pch->Buffer;
+	span->Mask = pch->Mask;
+	span->Head = pch->Head;
+	span->Free = CDC_MUX_Free(ch);
+
+	return USBD_OK;
+}
+
+/**
+  * @brief  CDC_MUX_Commit 发布CDC_MUX_Reserve之后直接写入的数据
+  * @param  ch: 通道号
+  * @param  len: 写入的字节数，超过空闲空间时整条丢弃
+  * @retval USBD_OK，空间不足时返回USBD_BUSY，参数错误返回USBD_FAIL
+  */
+uint8_t CDC_MUX_Commit(uint8_t ch, uint32_t len)
+{
+	CDC_MUX_ChannelTypeDef *pch;
+
+	if(ch >= CDC_MUX_CH_NUM)
+		return USBD_FAIL;
+
+	pch = &CDC_MUX_Channel[ch];
+	if(len > CDC_MUX_Free(ch))
+	{
+		pch->Dropped++;
+		return USBD_BUSY;
+	}
+
+	__DMB();
+	pch->Head += len;
+
+	CDC_MUX_Kick();
+
+	return USBD_OK;
+}
+
+/**
+  * @brief  CDC_MUX_Free 通道剩余空间
+  * @param  ch: 通道号
+  * @retval 可写入的字节数
+  */
+uint32_t CDC_MUX_Free(uint8_t ch)
+{
+	CDC_MUX_ChannelTypeDef *pch = &CDC_MUX_Channel[ch];
+
+	return pch->Mask + 1U - (pch->Head - pch->Tail);
+}
+
+/**
+  * @brief  CDC_MUX_SetPriority 设置通道优先级
+  * @param  ch: 通道号
+  * @param  priority: 优先级，数值越小越优先
+  */
+void CDC_MUX_SetPriority(uint8_t ch, uint8_t priority)
+{
+	if(ch < CDC_MUX_CH_NUM)
+		CDC_MUX_Channel[ch].Priority = priority;
+}
+
+/**
+  * @brief  CDC_MUX_Kick 端点空闲时发送下一帧
+  * @note   任务与USB中断都会调用，以关中断保护"检查空闲-启动传输"这一段。
+  *         USB中断优先级高于FreeRTOS可屏蔽范围，因此不能用临界区代替。
+  */
+void CDC_MUX_Kick(void)
+{
+	uint32_t primask;
+	uint32_t tail, len, first;
+	uint8_t ch;
+	CDC_MUX_ChannelTypeDef *pch;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	if((CDC_MUX_Busy != 0U) || (USB_Device_Online == 0U) || (hUsbDeviceFS.dev_state != USBD_STATE_CONFIGURED))
+	{
+		__set_PRIMASK(primask);
+		return;
+	}
+
+	ch = CDC_MUX_Pick();
+	if(ch == CDC_MUX_CH_NUM)
+	{
+		__set_PRIMASK(primask);
+		return;
+	}
+	CDC_MUX_Busy = 1U;
+
+	pch = &CDC_MUX_Channel[ch];
+	pch->Starve = 0U;
+	tail = pch->Tail;
+	len = MIN(pch->Head - tail, CDC_MUX_PAYLOAD_MAX(hUsbDeviceFS.ep_in[COM_CDC_IN_EP & 0x0FU].maxpacket));
+
+	CDC_MUX_Packet[0] = CDC_MUX_SYNC;
+	CDC_MUX_Packet[1] = (uint8_t)((ch << 4) | (pch->Seq++ & 0x0FU));
+	CDC_MUX_Packet[2] = (uint8_t)len;
+	CDC_MUX_Packet[3] = CDC_MUX_HEAD_CHECK(CDC_MUX_Packet[1], CDC_MUX_Packet[2]);
+
+	first = MIN(len, pch->Mask + 1U - (tail & pch->Mask));
+	memcpy(&CDC_MUX_Packet[CDC_MUX_HEAD_SIZE], &pch->Buffer[tail & pch->Mask], first);
+	memcpy(&CDC_MUX_Packet[CDC_MUX_HEAD_SIZE + first], pch->Buffer, len - first);
+	pch->Tail = tail + len;
+
+	pch->TxBytes += len;
+	pch->TxFrames++;
+
+	USBD_CDC_SetTxBuffer(&hUsbDeviceFS, CDC_MUX_Packet, len + CDC_MUX_HEAD_SIZE);
+	if(USBD_CDC_TransmitPacket(&hUsbDeviceFS) != USBD_OK)
+		CDC_MUX_Busy = 0U;
+
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief  CDC_MUX_TxCplt IN传输完成回调，在USB中断中调用
+  */
+void CDC_MUX_TxCplt(void)
+{
+	CDC_MUX_Busy = 0U;
+	CDC_MUX_Kick();
+}
+
+/**
+  * @brief  CDC_MUX_GetStats 读取通道统计
+  * @param  ch: 通道号
+  * @param  stats: 输出的统计数据
+  */
+void CDC_MUX_GetStats(uint8_t ch, CDC_MUX_StatsTypeDef *stats)
+{
+	CDC_MUX_ChannelTypeDef *pch;
+
+	if((ch >= CDC_MUX_CH_NUM) || (stats == NULL))
+		return;
+
+	pch = &CDC_MUX_Channel[ch];
+	stats->TxBytes = pch->TxBytes;
+	stats->TxFrames = pch->TxFrames;
+	stats->Dropped = pch->Dropped;
+	stats->Pending = pch->Head - pch->Tail;
+}
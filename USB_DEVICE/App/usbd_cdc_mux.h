@@ -0,0 +1,99 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_cdc_mux.h
+  * @version        : V1.0
+  * @brief          : usbd_cdc_mux.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_CDC_MUX_H__
+#define __USBD_CDC_MUX_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "usbd_composite.h"
+
+/* 复用器开关，关闭后CDC输出恢复为原始字节流 */
+#define CDC_MUX_ENABLED				1U
+
+/* 逻辑通道，编号越小默认优先级越高 */
+#define CDC_MUX_CH_CMD				0U			/**< 命令应答，记录查询结果，生产者为FatFs_Task */
+#define CDC_MUX_CH_TELEMETRY		1U			/**< 遥测数据 */
+#define CDC_MUX_CH_LOG				2U			/**< 日志 */
+#define CDC_MUX_CH_BULK				3U			/**< 大块数据，生产者为CDC_Transmit_FS的调用者 */
+#define CDC_MUX_CH_NUM				4U
+
+/* 各通道发送队列大小，必须为2的幂；命令应答队列须能容纳一条最长的查询记录 */
+#define CDC_MUX_CMD_QUEUE_SIZE		0x800U
+#define CDC_MUX_TELEMETRY_QUEUE_SIZE	0x200U
+#define CDC_MUX_LOG_QUEUE_SIZE		0x800U
+#define CDC_MUX_BULK_QUEUE_SIZE		0x800U
+
+/* 低优先级通道连续让出的包数上限，超过后强制发送一包，防止饿死 */
+#define CDC_MUX_STARVE_LIMIT		8U
+
+/*******************************************************************************/
+/* 帧结构，每个USB数据包恰好承载一帧                                            */
+/*-----------------------------------------------------------------------------*/
+/* Offset | Field    | Size | Description                                      */
+/* 0      | Sync     |  1   | 固定为CDC_MUX_SYNC                               */
+/* 1      | ChSeq    |  1   | 高4位通道号，低4位该通道的帧序号                 */
+/* 2      | Length   |  1   | 负载长度，0 ~ CDC_MUX_PAYLOAD_MAX(mps)           */
+/* 3      | HeadChk  |  1   | ChSeq ^ Length ^ CDC_MUX_SYNC，用于主机重同步     */
+/* 4      | Payload  |  n   | 通道数据                                         */
+/*******************************************************************************/
+#define CDC_MUX_SYNC				0xA5U
+#define CDC_MUX_HEAD_SIZE			4U
+#define CDC_MUX_LENGTH_MAX			0xFFU		/**< Length字段只有一个字节 */
+/* 帧长比包长少一个字节，避免整包传输后额外发送ZLP。mps取枚举后IN端点的包长，
+   高速构建在全速下枚举时为64字节而不是COM_CDC_DATA_MAX_PACK_SIZE */
+#define CDC_MUX_FRAME_MAX(mps)		((uint32_t)(mps) - 1U)
+#define CDC_MUX_PAYLOAD_MAX(mps)	MIN(CDC_MUX_FRAME_MAX(mps) - CDC_MUX_HEAD_SIZE, CDC_MUX_LENGTH_MAX)
+
+#define CDC_MUX_HEAD_CHECK(chseq, len)	((uint8_t)((chseq) ^ (len) ^ CDC_MUX_SYNC))
+
+typedef struct
+{
+	uint32_t TxBytes;		/**< 已发送的负载字节数 */
+	uint32_t TxFrames;		/**< 已发送的帧数 */
+	uint32_t Dropped;		/**< 队列空间不足被拒绝的写入次数 */
+	uint32_t Pending;		/**< 队列中等待发送的字节数 */
+}CDC_MUX_StatsTypeDef;
+
+/* 通道队列中可直接写入的一段空间，见CDC_MUX_Reserve */
+typedef struct
+{
+	uint8_t *Buffer;		/**< 队列存储区 */
+	uint32_t Mask;			/**< 队列大小减一 */
+	uint32_t Head;			/**< 写位置，未取模 */
+	uint32_t Free;			/**< 可写入的字节数 */
+}CDC_MUX_SpanTypeDef;
+
+void CDC_MUX_Reset(void);
+uint8_t CDC_MUX_Write(uint8_t ch, const uint8_t *buf, uint32_t len);
+uint8_t CDC_MUX_Reserve(uint8_t ch, CDC_MUX_SpanTypeDef *span);
+uint8_t CDC_MUX_Commit(uint8_t ch, uint32_t len);
+uint32_t CDC_MUX_Free(uint8_t ch);
+void CDC_MUX_SetPriority(uint8_t ch, uint8_t priority);
+void CDC_MUX_Kick(void);
+void CDC_MUX_TxCplt(void);
+void CDC_MUX_GetStats(uint8_t ch, CDC_MUX_StatsTypeDef *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_CDC_MUX_H__ */
@@ -0,0 +1,1051 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_cdc_xfer.c
+  * @version        : V1.0
+  * @brief          : CDC上的文件传输服务
+  *                   - 目录列表、按区间读取(GET)与写入(PUT)单个文件
+  *                   - 滑动窗口，每个数据块带CRC-32，按块选择性重发
+  *                   - 读取时f_read直接写入发送槽，USB输入端点从发送槽发送
+  *                   - 文件系统始终由固件挂载，不需要经MSC把整张卡交给主机
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                设计说明
+  *          ===================================================================
+  *           USB中断只做两件事：收到的数据包追加到接收队列，队列剩余空间
+  *           不足一个包时暂停输出端点；发送完成后启动下一个已填充的发送槽。
+  *           帧解析与全部FatFs操作在CDC_Xfer_Poll中执行，由Empty_Task循环
+  *           调用。卡由记录器挂载，FatFs开启了可重入，两个任务可同时访问。
+  *
+  *           GET时每个发送槽为帧头 + 数据块 + CRC，f_read直接读到帧头之后，
+  *           再把整个槽交给USB发送；重发的块重新从文件读取，不保存副本。
+  *           窗口内没有进展超过CDC_XFER_TIMEOUT_MS时重发所有未确认的块，
+  *           主机发现校验错误或缺块时用NAK请求立即重发单个块。
+  *
+  *           除第一个块外，块边界按CDC_XFER_CHUNK_SIZE对齐到文件偏移，
+  *           读写都是整扇区，FatFs直接在用户缓冲与卡之间传输。
+  *
+  *          ===================================================================
+  *                                注意
+  *          ===================================================================
+  *           1. 发送槽与写缓冲由SDMMC1的IDMA直接访问，CDC_Xfer_Attach检查其地址
+  *           2. 正在记录的文件被记录器以写方式打开，GET返回LOCKED，
+  *              读取当前文件用记录器的区间查询
+  *           3. PUT的数据在接收队列中不一定按字对齐，先拷入写缓冲再f_write
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_cdc_xfer.h"
+#include "usb_device.h"
+#include "stm32h7xx.h"
+#include "main.h"
+#include "cmsis_os.h"
+#include "fatfs.h"
+#include "scan.h"
+#include "string.h"
+
+#if (CDC_XFER_ENABLED == 1U)
+
+/* Define --------------------------------------------------------------------*/
+#define CDC_XFER_RX_MASK			(CDC_XFER_RX_SIZE - 1U)
+/* 发送槽按32字节对齐，数据块从槽内偏移CDC_XFER_HEAD_SIZE开始，保持字对齐 */
+#define CDC_XFER_SLOT_SIZE			((CDC_XFER_FRAME_MAX + 31U) & ~31UL)
+
+#define CDC_XFER_STATE_IDLE			0U
+#define CDC_XFER_STATE_LIST			1U
+#define CDC_XFER_STATE_GET			2U
+#define CDC_XFER_STATE_PUT			3U
+#define CDC_XFER_STATE_END			4U		/**< 等待发送END */
+
+/* Typedef -------------------------------------------------------------------*/
+typedef struct
+{
+	USBD_HandleTypeDef *pdev;
+
+	/* USB -> 任务 */
+	__IO uint32_t RxHead;			/**< 接收队列写位置，仅由USB中断修改 */
+	__IO uint32_t RxTail;			/**< 接收队列读位置，仅由任务修改 */
+	__IO uint8_t OutPaused;			/**< 队列空间不足，暂停接收 */
+	__IO uint8_t Reset;				/**< 重新枚举，任务须放弃当前操作 */
+
+	/* 任务 -> USB */
+	uint32_t TxHead;				/**< 已填充的发送槽累计数，仅由任务修改 */
+	__IO uint32_t TxTail;			/**< 已发送完成的发送槽累计数，仅由USB中断修改 */
+	__IO uint8_t InBusy;
+	uint32_t TxLength[CDC_XFER_SLOT_NUM];
+
+	/* 当前操作 */
+	uint8_t State;
+	uint8_t Window;					/**< 实际窗口大小 */
+	uint8_t AckDue;					/**< PUT：需要发送ACK */
+	uint8_t NakDue;					/**< PUT：需要为Base发送NAK */
+	uint8_t Finished;				/**< 已发送END，收到该操作的ACK、NAK或DATA时重发 */
+	uint8_t EndStatus;
+	uint32_t EndOffset;
+	uint32_t EndArg;
+	FIL File;
+	DIR Dir;
+	uint32_t Start;					/**< 起始偏移 */
+	uint32_t End;					/**< 结束偏移 */
+	uint32_t Chunks;				/**< 数据块总数 */
+	uint32_t Base;					/**< 最小的未确认(GET)或未收到(PUT)的块 */
+	uint32_t Next;					/**< GET：下一个首次发送的块 */
+	uint32_t Done;					/**< bit i：块Base+i已确认或已写入 */
+	uint32_t Resend;				/**< GET：bit i为块Base+i待重发 */
+	uint32_t NakIndex;				/**< PUT：最近一次NAK的块 */
+	uint32_t Count;					/**< LIST：已发送的目录项数 */
+	uint32_t Tick;					/**< 最近一次有进展的时刻 */
+
+	CDC_XFER_StatsTypeDef Stats;
+}CDC_XFER_HandleTypeDef;
+
+/* Variables -----------------------------------------------------------------*/
+static CDC_XFER_HandleTypeDef CDC_Xfer;
+
+static uint8_t CDC_XferRxBuffer[CDC_XFER_RX_SIZE];
+__ALIGN_BEGIN static uint8_t CDC_XferOutPacket[COM_CDC_DATA_MAX_PACK_SIZE] __ALIGN_END;
+static uint8_t CDC_XferSlot[CDC_XFER_SLOT_NUM][CDC_XFER_SLOT_SIZE] __attribute__((aligned(32)));
+static uint8_t CDC_XferWriteBuffer[CDC_XFER_CHUNK_SIZE] __attribute__((aligned(32)));
+
+/* CRC-32多项式0x04C11DB7(反射0xEDB88320)的按字节查表 */
+static const uint32_t CDC_XferCrcTable[256] =
+{
+	0x00000000U, 0x77073096U, 0xEE0E612CU, 0x990951BAU, 0x076DC419U, 0x706AF48FU, 0xE963A535U, 0x9E6495A3U,
+	0x0EDB8832U, 0x79DCB8A4U, 0xE0D5E91EU, 0x97D2D988U, 0x09B64C2BU, 0x7EB17CBDU, 0xE7B82D07U, 0x90BF1D91U,
+	0x1DB71064U, 0x6AB020F2U, 0xF3B97148U, 0x84BE41DEU, 0x1ADAD47DU, 0x6DDDE4EBU, 0xF4D4B551U, 0x83D385C7U,
+	0x136C9856U, 0x646BA8C0U, 0xFD62F97AU, 0x8A65C9ECU, 0x14015C4FU, 0x63066CD9U, 0xFA0F3D63U, 0x8D080DF5U,
+	0x3B6E20C8U, 0x4C69105EU, 0xD56041E4U, 0xA2677172U, 0x3C03E4D1U, 0x4B04D447U, 0xD20D85FDU, 0xA50AB56BU,
+	0x35B5A8FAU, 0x42B2986CU, 0xDBBBC9D6U, 0xACBCF940U, 0x32D86CE3U, 0x45DF5C75U, 0xDCD60DCFU, 0xABD13D59U,
+	0x26D930ACU, 0x51DE003AU, 0xC8D75180U, 0xBFD06116U, 0x21B4F4B5U, 0x56B3C423U, 0xCFBA9599U, 0xB8BDA50FU,
+	0x2802B89EU, 0x5F058808U, 0xC60CD9B2U, 0xB10BE924U, 0x2F6F7C87U, 0x58684C11U, 0xC1611DABU, 0xB6662D3DU,
+	0x76DC4190U, 0x01DB7106U, 0x98D220BCU, 0xEFD5102AU, 0x71B18589U, 0x06B6B51FU, 0x9FBFE4A5U, 0xE8B8D433U,
+	0x7807C9A2U, 0x0F00F934U, 0x9609A88EU, 0xE10E9818U, 0x7F6A0DBBU, 0x086D3D2DU, 0x91646C97U, 0xE6635C01U,
+	0x6B6B51F4U, 0x1C6C6162U, 0x856530D8U, 0xF262004EU, 0x6C0695EDU, 0x1B01A57BU, 0x8208F4C1U, 0xF50FC457U,
+	0x65B0D9C6U, 0x12B7E950U, 0x8BBEB8EAU, 0xFCB9887CU, 0x62DD1DDFU, 0x15DA2D49U, 0x8CD37CF3U, 0xFBD44C65U,
+	0x4DB26158U, 0x3AB551CEU, 0xA3BC0074U, 0xD4BB30E2U, 0x4ADFA541U, 0x3DD895D7U, 0xA4D1C46DU, 0xD3D6F4FBU,
+	0x4369E96AU, 0x346ED9FCU, 0xAD678846U, 0xDA60B8D0U, 0x44042D73U, 0x33031DE5U, 0xAA0A4C5FU, 0xDD0D7CC9U,
+	0x5005713CU, 0x270241AAU, 0xBE0B1010U, 0xC90C2086U, 0x5768B525U, 0x206F85B3U, 0xB966D409U, 0xCE61E49FU,
+	0x5EDEF90EU, 0x29D9C998U, 0xB0D09822U, 0xC7D7A8B4U, 0x59B33D17U, 0x2EB40D81U, 0xB7BD5C3BU, 0xC0BA6CADU,
+	0xEDB88320U, 0x9ABFB3B6U, 0x03B6E20CU, 0x74B1D29AU, 0xEAD54739U, 0x9DD277AFU, 0x04DB2615U, 0x73DC1683U,
+	0xE3630B12U, 0x94643B84U, 0x0D6D6A3EU, 0x7A6A5AA8U, 0xE40ECF0BU, 0x9309FF9DU, 0x0A00AE27U, 0x7D079EB1U,
+	0xF00F9344U, 0x8708A3D2U, 0x1E01F268U, 0x6906C2FEU, 0xF762575DU, 0x806567CBU, 0x196C3671U, 0x6E6B06E7U,
+	0xFED41B76U, 0x89D32BE0U, 0x10DA7A5AU, 0x67DD4ACCU, 0xF9B9DF6FU, 0x8EBEEFF9U, 0x17B7BE43U, 0x60B08ED5U,
+	0xD6D6A3E8U, 0xA1D1937EU, 0x38D8C2C4U, 0x4FDFF252U, 0xD1BB67F1U, 0xA6BC5767U, 0x3FB506DDU, 0x48B2364BU,
+	0xD80D2BDAU, 0xAF0A1B4CU, 0x36034AF6U, 0x41047A60U, 0xDF60EFC3U, 0xA867DF55U, 0x316E8EEFU, 0x4669BE79U,
+	0xCB61B38CU, 0xBC66831AU, 0x256FD2A0U, 0x5268E236U, 0xCC0C7795U, 0xBB0B4703U, 0x220216B9U, 0x5505262FU,
+	0xC5BA3BBEU, 0xB2BD0B28U, 0x2BB45A92U, 0x5CB36A04U, 0xC2D7FFA7U, 0xB5D0CF31U, 0x2CD99E8BU, 0x5BDEAE1DU,
+	0x9B64C2B0U, 0xEC63F226U, 0x756AA39CU, 0x026D930AU, 0x9C0906A9U, 0xEB0E363FU, 0x72076785U, 0x05005713U,
+	0x95BF4A82U, 0xE2B87A14U, 0x7BB12BAEU, 0x0CB61B38U, 0x92D28E9BU, 0xE5D5BE0DU, 0x7CDCEFB7U, 0x0BDBDF21U,
+	0x86D3D2D4U, 0xF1D4E242U, 0x68DDB3F8U, 0x1FDA836EU, 0x81BE16CDU, 0xF6B9265BU, 0x6FB077E1U, 0x18B74777U,
+	0x88085AE6U, 0xFF0F6A70U, 0x66063BCAU, 0x11010B5CU, 0x8F659EFFU, 0xF862AE69U, 0x616BFFD3U, 0x166CCF45U,
+	0xA00AE278U, 0xD70DD2EEU, 0x4E048354U, 0x3903B3C2U, 0xA7672661U, 0xD06016F7U, 0x4969474DU, 0x3E6E77DBU,
+	0xAED16A4AU, 0xD9D65ADCU, 0x40DF0B66U, 0x37D83BF0U, 0xA9BCAE53U, 0xDEBB9EC5U, 0x47B2CF7FU, 0x30B5FFE9U,
+	0xBDBDF21CU, 0xCABAC28AU, 0x53B39330U, 0x24B4A3A6U, 0xBAD03605U, 0xCDD70693U, 0x54DE5729U, 0x23D967BFU,
+	0xB3667A2EU, 0xC4614AB8U, 0x5D681B02U, 0x2A6F2B94U, 0xB40BBE37U, 0xC30C8EA1U, 0x5A05DF1BU, 0x2D02EF8DU
+};
+
+/* CDC操作接口静态函数 */
+static int8_t CDC_Xfer_Init(void);
+static int8_t CDC_Xfer_DeInit(void);
+static int8_t CDC_Xfer_Control(uint8_t cmd, uint8_t* pbuf, uint16_t length);
+static int8_t CDC_Xfer_Receive(uint8_t* Buf, uint32_t *Len);
+static int8_t CDC_Xfer_TransmitCplt(uint8_t *Buf, uint32_t *Len, uint8_t epnum);
+
+static USBD_CDC_ItfTypeDef CDC_Xfer_fops =
+{
+	CDC_Xfer_Init,
+	CDC_Xfer_DeInit,
+	CDC_Xfer_Control,
+	CDC_Xfer_Receive,
+	CDC_Xfer_TransmitCplt,
+};
+
+/* ---------------------------------------- Frame Funtion ---------------------------------------- */
+
+/**
+  * @brief  CDC_Xfer_Crc 累计CRC-32，初值与结果都不取反
+  */
+static uint32_t CDC_Xfer_Crc(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+	while(len-- != 0U)
+		crc = CDC_XferCrcTable[(crc ^ *buf++) & 0xFFU] ^ (crc >> 8);
+
+	return crc;
+}
+
+static void CDC_Xfer_Set16(uint8_t *p, uint16_t value)
+{
+	p[0] = (uint8_t)value;
+	p[1] = (uint8_t)(value >> 8);
+}
+
+static void CDC_Xfer_Set32(uint8_t *p, uint32_t value)
+{
+	p[0] = (uint8_t)value;
+	p[1] = (uint8_t)(value >> 8);
+	p[2] = (uint8_t)(value >> 16);
+	p[3] = (uint8_t)(value >> 24);
+}
+
+/**
+  * @brief  CDC_Xfer_RxByte 读取接收队列中距读位置pos处的字节
+  */
+static uint8_t CDC_Xfer_RxByte(uint32_t pos)
+{
+	return CDC_XferRxBuffer[(CDC_Xfer.RxTail + pos) & CDC_XFER_RX_MASK];
+}
+
+static uint32_t CDC_Xfer_RxGet(uint32_t pos, uint32_t size)
+{
+	uint32_t value = 0U;
+
+	while(size-- != 0U)
+		value = (value << 8) | CDC_Xfer_RxByte(pos + size);
+
+	return value;
+}
+
+/**
+  * @brief  CDC_Xfer_RxCopy 从接收队列拷出数据，不移动读位置
+  */
+static void CDC_Xfer_RxCopy(uint32_t pos, uint8_t *buf, uint32_t len)
+{
+	uint32_t index = (CDC_Xfer.RxTail + pos) & CDC_XFER_RX_MASK;
+	uint32_t first = MIN(len, CDC_XFER_RX_SIZE - index);
+
+	memcpy(buf, &CDC_XferRxBuffer[index], first);
+	memcpy(buf + first, CDC_XferRxBuffer, len - first);
+}
+
+/**
+  * @brief  CDC_Xfer_RxCrc 计算接收队列中一段数据的CRC-32
+  */
+static uint32_t CDC_Xfer_RxCrc(uint32_t pos, uint32_t len)
+{
+	uint32_t index = (CDC_Xfer.RxTail + pos) & CDC_XFER_RX_MASK;
+	uint32_t first = MIN(len, CDC_XFER_RX_SIZE - index);
+	uint32_t crc;
+
+	crc = CDC_Xfer_Crc(0xFFFFFFFFUL, &CDC_XferRxBuffer[index], first);
+	crc = CDC_Xfer_Crc(crc, CDC_XferRxBuffer, len - first);
+
+	return crc ^ 0xFFFFFFFFUL;
+}
+
+/**
+  * @brief  CDC_Xfer_RxSkip 读位置处不是有效帧时，到下一个同步字节为止要丢弃的字节数
+  * @param  avail: 接收队列中的数据量
+  */
+static uint32_t CDC_Xfer_RxSkip(uint32_t avail)
+{
+	uint32_t index = (CDC_Xfer.RxTail + 1U) & CDC_XFER_RX_MASK;
+	uint32_t first = MIN(avail - 1U, CDC_XFER_RX_SIZE - index);
+	uint32_t skip = SCAN_Byte(&CDC_XferRxBuffer[index], first, CDC_XFER_SYNC);
+
+	if(skip == first)
+		skip += SCAN_Byte(CDC_XferRxBuffer, avail - 1U - first, CDC_XFER_SYNC);
+
+	return 1U + skip;
+}
+
+/**
+  * @brief  CDC_Xfer_RxRelease 移动读位置，腾出足够空间后恢复接收
+  */
+static void CDC_Xfer_RxRelease(uint32_t len)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	uint32_t primask;
+
+	hx->RxTail += len;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if((hx->OutPaused != 0U) && (USB_Device_Online != 0U) && (CDC_XFER_RX_SIZE - (hx->RxHead - hx->RxTail) >= COM_CDC_DATA_MAX_PACK_SIZE))
+	{
+		hx->OutPaused = 0U;
+		USBD_CDC_ReceivePacketEx(hx->pdev, CDC_XFER_PORT);
+	}
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief  CDC_Xfer_InKick USB输入端点空闲时发送下一个已填充的发送槽
+  * @note   调用者须已关闭中断。
+  */
+static void CDC_Xfer_InKick(void)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	uint32_t slot;
+
+	if((hx->InBusy != 0U) || (hx->TxTail == hx->TxHead) || (USB_Device_Online == 0U) ||
+	   (hx->pdev->dev_state != USBD_STATE_CONFIGURED))
+		return;
+
+	slot = hx->TxTail % CDC_XFER_SLOT_NUM;
+	hx->InBusy = 1U;
+	USBD_CDC_SetTxBufferEx(hx->pdev, CDC_XFER_PORT, CDC_XferSlot[slot], hx->TxLength[slot]);
+	if(USBD_CDC_TransmitPacketEx(hx->pdev, CDC_XFER_PORT) != USBD_OK)
+		hx->InBusy = 0U;
+}
+
+/**
+  * @brief  CDC_Xfer_Slot 取得下一个空闲的发送槽
+  * @retval 发送槽，没有空闲时返回NULL
+  */
+static uint8_t *CDC_Xfer_Slot(void)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+
+	if(hx->TxHead - hx->TxTail >= CDC_XFER_SLOT_NUM)
+		return NULL;
+
+	return CDC_XferSlot[hx->TxHead % CDC_XFER_SLOT_NUM];
+}
+
+/**
+  * @brief  CDC_Xfer_Send 填写帧头与CRC并发送CDC_Xfer_Slot取得的发送槽
+  * @param  slot: 发送槽，负载已位于CDC_XFER_HEAD_SIZE处
+  */
+static void CDC_Xfer_Send(uint8_t *slot, uint8_t op, uint32_t seq, uint32_t len,
+						  uint8_t status, uint32_t offset, uint32_t arg)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	uint32_t crc, primask;
+
+	slot[0] = CDC_XFER_SYNC;
+	slot[1] = op;
+	CDC_Xfer_Set16(&slot[2], (uint16_t)seq);
+	CDC_Xfer_Set16(&slot[4], (uint16_t)len);
+	slot[6] = status;
+	slot[7] = hx->Window;
+	CDC_Xfer_Set32(&slot[8], offset);
+	CDC_Xfer_Set32(&slot[12], arg);
+	crc = CDC_Xfer_Crc(0xFFFFFFFFUL, slot, CDC_XFER_HEAD_SIZE + len) ^ 0xFFFFFFFFUL;
+	CDC_Xfer_Set32(&slot[CDC_XFER_HEAD_SIZE + len], crc);
+	hx->TxLength[hx->TxHead % CDC_XFER_SLOT_NUM] = CDC_XFER_HEAD_SIZE + len + CDC_XFER_CRC_SIZE;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	hx->TxHead++;
+	CDC_Xfer_InKick();
+	__set_PRIMASK(primask);
+}
+
+/* --------------------------------------- Transfer Funtion --------------------------------------- */
+
+/**
+  * @brief  CDC_Xfer_ChunkOffset 数据块k的文件偏移
+  */
+static uint32_t CDC_Xfer_ChunkOffset(uint32_t index)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	uint32_t offset;
+
+	if(index == 0U)
+		return hx->Start;
+	offset = (hx->Start & ~(CDC_XFER_CHUNK_SIZE - 1U)) + index * CDC_XFER_CHUNK_SIZE;
+
+	return MIN(offset, hx->End);
+}
+
+/**
+  * @brief  CDC_Xfer_Range 设置传输区间并计算数据块数
+  */
+static void CDC_Xfer_Range(uint32_t start, uint32_t end, uint8_t window)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	uint32_t aligned = start & ~(CDC_XFER_CHUNK_SIZE - 1U);
+
+	hx->Start = start;
+	hx->End = end;
+	hx->Chunks = (end > start) ? (end - aligned + CDC_XFER_CHUNK_SIZE - 1U) / CDC_XFER_CHUNK_SIZE : 0U;
+	hx->Window = ((window == 0U) || (window > CDC_XFER_WINDOW)) ? CDC_XFER_WINDOW : window;
+	hx->Base = 0U;
+	hx->Next = 0U;
+	hx->Done = 0U;
+	hx->Resend = 0U;
+	hx->NakIndex = 0xFFFFFFFFUL;
+	hx->AckDue = 0U;
+	hx->NakDue = 0U;
+	hx->Tick = osKernelGetTickCount();
+}
+
+/**
+  * @brief  CDC_Xfer_Unwrap 把帧中的16位序号还原为块号
+  * @retval 块号，不在窗口附近时返回0xFFFFFFFF
+  */
+static uint32_t CDC_Xfer_Unwrap(uint32_t seq)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	int16_t diff = (int16_t)(uint16_t)(seq - hx->Base);
+
+	if((diff < -(int16_t)CDC_XFER_WINDOW) || (diff > (int16_t)CDC_XFER_WINDOW))
+		return 0xFFFFFFFFUL;
+
+	return hx->Base + (uint32_t)(int32_t)diff;
+}
+
+/**
+  * @brief  CDC_Xfer_Advance 块Base之后连续完成的块移出窗口
+  */
+static void CDC_Xfer_Advance(uint32_t count)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+
+	if(count == 0U)
+		return;
+	hx->Done = (count >= 32U) ? 0U : hx->Done >> count;
+	hx->Resend = (count >= 32U) ? 0U : hx->Resend >> count;
+	hx->Base += count;
+	hx->Tick = osKernelGetTickCount();
+}
+
+/**
+  * @brief  CDC_Xfer_End 结束当前操作，END在有空闲发送槽时发出
+  * @param  status: CDC_XFER_xxx
+  * @param  offset: IO_ERROR时为FRESULT
+  * @param  arg: 项数或字节数
+  */
+static void CDC_Xfer_End(uint8_t status, uint32_t offset, uint32_t arg)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+
+	if(hx->State == CDC_XFER_STATE_LIST)
+		f_closedir(&hx->Dir);
+	else if((hx->State == CDC_XFER_STATE_GET) || (hx->State == CDC_XFER_STATE_PUT))
+		f_close(&hx->File);
+
+	if((status != CDC_XFER_OK) && (status != CDC_XFER_ABORTED))
+		hx->Stats.Errors++;
+	hx->EndStatus = status;
+	hx->EndOffset = offset;
+	hx->EndArg = arg;
+	hx->State = CDC_XFER_STATE_END;
+}
+
+/**
+  * @brief  CDC_Xfer_Result FatFs返回值转为状态
+  */
+static uint8_t CDC_Xfer_Result(FRESULT res)
+{
+	switch(res)
+	{
+		case FR_OK:
+			return CDC_XFER_OK;
+		case FR_NO_FILE:
+		case FR_NO_PATH:
+			return CDC_XFER_NOT_FOUND;
+		case FR_LOCKED:
+		case FR_DENIED:
+			return CDC_XFER_LOCKED;
+		case FR_INVALID_NAME:
+			return CDC_XFER_BAD_REQUEST;
+		case FR_NOT_ENABLED:
+		case FR_NOT_READY:
+		case FR_NO_FILESYSTEM:
+			return CDC_XFER_NO_CARD;
+		default:
+			return CDC_XFER_IO_ERROR;
+	}
+}
+
+/**
+  * @brief  CDC_Xfer_Request 处理LIST、GET、PUT请求，已确认有空闲发送槽
+  * @param  len: 负载长度，负载为路径
+  */
+static void CDC_Xfer_Request(uint8_t op, uint32_t len, uint8_t flags, uint8_t window, uint32_t offset, uint32_t arg)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	char path[CDC_XFER_PATH_MAX];
+	FRESULT res;
+	uint32_t size;
+
+	hx->Stats.Requests++;
+	hx->Finished = 0U;
+	/* 新请求中止正在进行的操作，不再为其发送END */
+	if(hx->State != CDC_XFER_STATE_IDLE)
+	{
+		CDC_Xfer_End(CDC_XFER_ABORTED, 0U, 0U);
+		hx->State = CDC_XFER_STATE_IDLE;
+	}
+
+	if((len == 0U) || (len >= CDC_XFER_PATH_MAX))
+	{
+		CDC_Xfer_End(CDC_XFER_BAD_REQUEST, 0U, 0U);
+		return;
+	}
+	CDC_Xfer_RxCopy(CDC_XFER_HEAD_SIZE, (uint8_t *)path, len);
+	path[len] = '\0';
+
+	if(SDFatFS.fs_type == 0U)
+	{
+		CDC_Xfer_End(CDC_XFER_NO_CARD, 0U, 0U);
+		return;
+	}
+
+	switch(op)
+	{
+		case CDC_XFER_OP_LIST:
+			res = f_opendir(&hx->Dir, path);
+			if(res != FR_OK)
+			{
+				CDC_Xfer_End(CDC_Xfer_Result(res), res, 0U);
+				return;
+			}
+			hx->Count = 0U;
+			hx->State = CDC_XFER_STATE_LIST;
+			break;
+
+		case CDC_XFER_OP_GET:
+			res = f_open(&hx->File, path, FA_READ);
+			if(res != FR_OK)
+			{
+				CDC_Xfer_End(CDC_Xfer_Result(res), res, 0U);
+				return;
+			}
+			hx->State = CDC_XFER_STATE_GET;
+			size = f_size(&hx->File);
+			if(offset > size)
+			{
+				CDC_Xfer_End(CDC_XFER_BAD_REQUEST, 0U, 0U);
+				return;
+			}
+			CDC_Xfer_Range(offset, (arg > size - offset) ? size : offset + arg, window);
+			CDC_Xfer_Send(CDC_Xfer_Slot(), CDC_XFER_OP_INFO, 0U, 0U, CDC_XFER_OK, offset, size);
+			break;
+
+		case CDC_XFER_OP_PUT:
+			if(arg > 0xFFFFFFFFUL - offset)
+			{
+				CDC_Xfer_End(CDC_XFER_BAD_REQUEST, 0U, 0U);
+				return;
+			}
+			res = f_open(&hx->File, path, FA_WRITE | (((flags & CDC_XFER_PUT_TRUNCATE) != 0U) ? FA_CREATE_ALWAYS : FA_OPEN_ALWAYS));
+			if(res != FR_OK)
+			{
+				CDC_Xfer_End(CDC_Xfer_Result(res), res, 0U);
+				return;
+			}
+			hx->State = CDC_XFER_STATE_PUT;
+			CDC_Xfer_Range(offset, offset + arg, window);
+			CDC_Xfer_Send(CDC_Xfer_Slot(), CDC_XFER_OP_INFO, 0U, 0U, CDC_XFER_OK, offset, arg);
+			break;
+
+		default:
+			break;
+	}
+}
+
+/**
+  * @brief  CDC_Xfer_Ack GET中主机的确认
+  * @param  seq: 主机下一个期望的块
+  * @param  bitmap: bit i为块seq+1+i已收到
+  */
+static void CDC_Xfer_Ack(uint32_t seq, uint32_t bitmap)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	uint32_t index = CDC_Xfer_Unwrap(seq);
+
+	if((index == 0xFFFFFFFFUL) || (index < hx->Base) || (index > hx->Next))
+		return;
+
+	CDC_Xfer_Advance(index - hx->Base);
+	hx->Done |= bitmap << 1;
+	hx->Resend &= ~hx->Done;
+}
+
+/**
+  * @brief  CDC_Xfer_Nak GET中主机请求重发一个块
+  */
+static void CDC_Xfer_Nak(uint32_t seq)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	uint32_t index = CDC_Xfer_Unwrap(seq);
+
+	if((index == 0xFFFFFFFFUL) || (index < hx->Base) || (index >= hx->Next))
+		return;
+	if((hx->Done & (1UL << (index - hx->Base))) == 0U)
+		hx->Resend |= 1UL << (index - hx->Base);
+}
+
+/**
+  * @brief  CDC_Xfer_Data PUT中收到一个数据块，写入文件
+  * @param  len: 负载长度
+  */
+static void CDC_Xfer_Data(uint32_t seq, uint32_t len, uint32_t offset)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	uint32_t index = CDC_Xfer_Unwrap(seq);
+	uint32_t bit, count;
+	FRESULT res;
+	UINT written;
+
+	hx->AckDue = 1U;
+	/* 重复或窗口外的块只回复ACK，让主机知道当前进度 */
+	if((index == 0xFFFFFFFFUL) || (index < hx->Base) || (index >= hx->Base + hx->Window) || (index >= hx->Chunks))
+		return;
+	bit = index - hx->Base;
+	if((hx->Done & (1UL << bit)) != 0U)
+		return;
+
+	if((offset != CDC_Xfer_ChunkOffset(index)) || (len != CDC_Xfer_ChunkOffset(index + 1U) - offset))
+	{
+		CDC_Xfer_End(CDC_XFER_BAD_REQUEST, 0U, 0U);
+		return;
+	}
+
+	CDC_Xfer_RxCopy(CDC_XFER_HEAD_SIZE, CDC_XferWriteBuffer, len);
+	res = FR_OK;
+	if(f_tell(&hx->File) != offset)
+		res = f_lseek(&hx->File, offset);
+	if(res == FR_OK)
+		res = f_write(&hx->File, CDC_XferWriteBuffer, len, &written);
+	if((res == FR_OK) && (written != len))
+		res = FR_DENIED;
+	if(res != FR_OK)
+	{
+		CDC_Xfer_End(CDC_Xfer_Result(res), res, 0U);
+		return;
+	}
+	hx->Stats.RxBytes += len;
+
+	hx->Done |= 1UL << bit;
+	for(count = 0U; (count < 32U) && ((hx->Done & (1UL << count)) != 0U); count++)
+		;
+	CDC_Xfer_Advance(count);
+
+	/* 后面的块先到而Base仍未收到，请求重发Base，每个块只请求一次 */
+	if((hx->Done != 0U) && (hx->NakIndex != hx->Base))
+	{
+		hx->NakIndex = hx->Base;
+		hx->NakDue = 1U;
+	}
+}
+
+/**
+  * @brief  CDC_Xfer_Frame 处理接收队列读位置处一个完整且校验正确的帧
+  */
+static void CDC_Xfer_Frame(uint32_t len)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	uint8_t op = CDC_Xfer_RxByte(1U);
+	uint32_t seq = CDC_Xfer_RxGet(2U, 2U);
+	uint8_t status = CDC_Xfer_RxByte(6U);
+	uint8_t window = CDC_Xfer_RxByte(7U);
+	uint32_t offset = CDC_Xfer_RxGet(8U, 4U);
+	uint32_t arg = CDC_Xfer_RxGet(12U, 4U);
+
+	switch(op)
+	{
+		case CDC_XFER_OP_LIST:
+		case CDC_XFER_OP_GET:
+		case CDC_XFER_OP_PUT:
+			CDC_Xfer_Request(op, len, status, window, offset, arg);
+			break;
+
+		case CDC_XFER_OP_ABORT:
+			if(hx->State != CDC_XFER_STATE_END)
+				CDC_Xfer_End(CDC_XFER_ABORTED, 0U, 0U);
+			break;
+
+		case CDC_XFER_OP_ACK:
+			if(hx->State == CDC_XFER_STATE_GET)
+				CDC_Xfer_Ack(seq, arg);
+			else if(hx->Finished != 0U)
+				hx->State = CDC_XFER_STATE_END;
+			break;
+
+		case CDC_XFER_OP_NAK:
+			if(hx->State == CDC_XFER_STATE_GET)
+				CDC_Xfer_Nak(seq);
+			else if(hx->Finished != 0U)
+				hx->State = CDC_XFER_STATE_END;
+			break;
+
+		case CDC_XFER_OP_DATA:
+			if(hx->State == CDC_XFER_STATE_PUT)
+				CDC_Xfer_Data(seq, len, offset);
+			else if(hx->Finished != 0U)
+				hx->State = CDC_XFER_STATE_END;
+			break;
+
+		default:
+			break;
+	}
+}
+
+/**
+  * @brief  CDC_Xfer_Parse 从接收队列中取出并处理完整的帧
+  * @note   每个帧的应答至多需要一个发送槽，没有空闲槽时帧留在队列中。
+  */
+static void CDC_Xfer_Parse(void)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	uint32_t avail, len, total, skip;
+
+	while((avail = hx->RxHead - hx->RxTail) >= CDC_XFER_HEAD_SIZE)
+	{
+		len = CDC_Xfer_RxGet(4U, 2U);
+		if((CDC_Xfer_RxByte(0U) != CDC_XFER_SYNC) || (len > CDC_XFER_CHUNK_SIZE))
+		{
+			skip = CDC_Xfer_RxSkip(avail);
+			hx->Stats.Resyncs += skip;
+			CDC_Xfer_RxRelease(skip);
+			continue;
+		}
+		total = CDC_XFER_HEAD_SIZE + len + CDC_XFER_CRC_SIZE;
+		if(avail < total)
+			break;
+		if(CDC_Xfer_RxCrc(0U, CDC_XFER_HEAD_SIZE + len) != CDC_Xfer_RxGet(CDC_XFER_HEAD_SIZE + len, 4U))
+		{
+			/* 同步字节本身不计入Resyncs */
+			skip = CDC_Xfer_RxSkip(avail);
+			hx->Stats.CrcErrors++;
+			hx->Stats.Resyncs += skip - 1U;
+			CDC_Xfer_RxRelease(skip);
+			continue;
+		}
+		if(CDC_Xfer_Slot() == NULL)
+			break;
+
+		CDC_Xfer_Frame(len);
+		CDC_Xfer_RxRelease(total);
+	}
+}
+
+/**
+  * @brief  CDC_Xfer_ListPoll 每个空闲发送槽发送一个目录项
+  */
+static void CDC_Xfer_ListPoll(void)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	FILINFO info;
+	FRESULT res;
+	uint8_t *slot;
+	uint32_t len;
+
+	while((hx->State == CDC_XFER_STATE_LIST) && ((slot = CDC_Xfer_Slot()) != NULL))
+	{
+		res = f_readdir(&hx->Dir, &info);
+		if(res != FR_OK)
+			CDC_Xfer_End(CDC_Xfer_Result(res), res, hx->Count);
+		else if(info.fname[0] == '\0')
+			CDC_Xfer_End(CDC_XFER_OK, 0U, hx->Count);
+		else
+		{
+			len = strlen(info.fname);
+			memcpy(&slot[CDC_XFER_HEAD_SIZE], info.fname, len);
+			CDC_Xfer_Send(slot, CDC_XFER_OP_ENTRY, hx->Count++, len, info.fattrib,
+						  ((uint32_t)info.fdate << 16) | info.ftime, info.fsize);
+		}
+	}
+}
+
+/**
+  * @brief  CDC_Xfer_GetPoll 按窗口发送数据块，f_read直接读入发送槽
+  */
+static void CDC_Xfer_GetPoll(void)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	uint32_t index, offset, len, inflight;
+	uint8_t *slot;
+	FRESULT res;
+	UINT read;
+
+	if(hx->Base >= hx->Chunks)
+	{
+		CDC_Xfer_End(CDC_XFER_OK, 0U, hx->End - hx->Start);
+		return;
+	}
+
+	/* 超时未有进展，重发窗口内全部未确认的块 */
+	if(osKernelGetTickCount() - hx->Tick >= CDC_XFER_TIMEOUT_MS)
+	{
+		inflight = hx->Next - hx->Base;
+		hx->Resend |= ((inflight >= 32U) ? 0xFFFFFFFFUL : ((1UL << inflight) - 1U)) & ~hx->Done;
+		hx->Tick = osKernelGetTickCount();
+	}
+
+	while((slot = CDC_Xfer_Slot()) != NULL)
+	{
+		if(hx->Resend != 0U)
+		{
+			index = __CLZ(__RBIT(hx->Resend));
+			hx->Resend &= ~(1UL << index);
+			index += hx->Base;
+			hx->Stats.Retransmits++;
+		}
+		else if((hx->Next < hx->Chunks) && (hx->Next - hx->Base < hx->Window))
+			index = hx->Next++;
+		else
+			break;
+
+		offset = CDC_Xfer_ChunkOffset(index);
+		len = CDC_Xfer_ChunkOffset(index + 1U) - offset;
+		res = FR_OK;
+		if(f_tell(&hx->File) != offset)
+			res = f_lseek(&hx->File, offset);
+		if(res == FR_OK)
+			res = f_read(&hx->File, &slot[CDC_XFER_HEAD_SIZE], len, &read);
+		if((res == FR_OK) && (read != len))
+			res = FR_INT_ERR;
+		if(res != FR_OK)
+		{
+			CDC_Xfer_End(CDC_XFER_IO_ERROR, res, 0U);
+			return;
+		}
+
+		CDC_Xfer_Send(slot, CDC_XFER_OP_DATA, index, len, CDC_XFER_OK, offset, 0U);
+		hx->Stats.TxBytes += len;
+	}
+}
+
+/**
+  * @brief  CDC_Xfer_PutPoll 发送ACK与NAK，全部块写入后关闭文件
+  */
+static void CDC_Xfer_PutPoll(void)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	uint8_t *slot;
+	FRESULT res;
+
+	/* 超时未有进展，重发ACK与NAK提醒主机 */
+	if(osKernelGetTickCount() - hx->Tick >= CDC_XFER_TIMEOUT_MS)
+	{
+		hx->AckDue = 1U;
+		hx->NakDue = (hx->Base < hx->Chunks) ? 1U : 0U;
+		hx->NakIndex = hx->Base;
+		hx->Tick = osKernelGetTickCount();
+	}
+
+	if((hx->AckDue != 0U) && ((slot = CDC_Xfer_Slot()) != NULL))
+	{
+		hx->AckDue = 0U;
+		CDC_Xfer_Send(slot, CDC_XFER_OP_ACK, hx->Base, 0U, CDC_XFER_OK, 0U, hx->Done >> 1);
+	}
+	if((hx->NakDue != 0U) && ((slot = CDC_Xfer_Slot()) != NULL))
+	{
+		hx->NakDue = 0U;
+		CDC_Xfer_Send(slot, CDC_XFER_OP_NAK, hx->Base, 0U, CDC_XFER_OK, 0U, 0U);
+	}
+
+	if((hx->Base >= hx->Chunks) && (hx->AckDue == 0U))
+	{
+		res = f_sync(&hx->File);
+		CDC_Xfer_End(CDC_Xfer_Result(res), res, hx->End - hx->Start);
+	}
+}
+
+/**
+  * @brief  CDC_Xfer_Poll 处理请求并推进当前操作，在Empty_Task中循环调用
+  */
+void CDC_Xfer_Poll(void)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	uint32_t primask;
+	uint8_t *slot;
+
+	/* 重新枚举后丢弃旧的请求与未发送的帧 */
+	if(hx->Reset != 0U)
+	{
+		if((hx->State != CDC_XFER_STATE_IDLE) && (hx->State != CDC_XFER_STATE_END))
+			CDC_Xfer_End(CDC_XFER_ABORTED, 0U, 0U);
+		hx->State = CDC_XFER_STATE_IDLE;
+		hx->Finished = 0U;
+		primask = __get_PRIMASK();
+		__disable_irq();
+		hx->Reset = 0U;
+		hx->RxTail = hx->RxHead;
+		hx->TxHead = hx->TxTail;
+		__set_PRIMASK(primask);
+	}
+
+	CDC_Xfer_Parse();
+
+	switch(hx->State)
+	{
+		case CDC_XFER_STATE_LIST:
+			CDC_Xfer_ListPoll();
+			break;
+
+		case CDC_XFER_STATE_GET:
+			CDC_Xfer_GetPoll();
+			break;
+
+		case CDC_XFER_STATE_PUT:
+			CDC_Xfer_PutPoll();
+			break;
+
+		default:
+			break;
+	}
+
+	if((hx->State == CDC_XFER_STATE_END) && ((slot = CDC_Xfer_Slot()) != NULL))
+	{
+		CDC_Xfer_Send(slot, CDC_XFER_OP_END, 0U, 0U, hx->EndStatus, hx->EndOffset, hx->EndArg);
+		hx->State = CDC_XFER_STATE_IDLE;
+		hx->Finished = 1U;
+	}
+}
+
+/**
+  * @brief  CDC_Xfer_Task 文件传输服务循环，不返回
+  * @note   空闲时每毫秒检查一次；传输中发送槽全满时同样让出，等待USB发送完成。
+  */
+void CDC_Xfer_Task(void)
+{
+	for(;;)
+	{
+		CDC_Xfer_Poll();
+		osDelay(1);
+	}
+}
+
+/**
+  * @brief  CDC_Xfer_Attach 将文件传输服务绑定到CDC实例
+  * @note   在USBD_Start之后、主机配置设备之前调用。
+  * @param  pdev: 设备实例
+  * @retval USBD_OK，缓冲不在DMA可访问的内存中时返回USBD_FAIL
+  */
+uint8_t CDC_Xfer_Attach(USBD_HandleTypeDef *pdev)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+
+	if(!DMA_BUFFER_OK(CDC_XferSlot) || !DMA_BUFFER_OK(CDC_XferWriteBuffer))
+		return USBD_FAIL;
+
+	(void)memset(hx, 0, sizeof(CDC_XFER_HandleTypeDef));
+	hx->pdev = pdev;
+	hx->Window = CDC_XFER_WINDOW;
+
+	return USBD_CDC_RegisterInterfaceEx(pdev, CDC_XFER_PORT, &CDC_Xfer_fops);
+}
+
+/**
+  * @brief  CDC_Xfer_GetStats 读取文件传输统计
+  * @param  stats: 输出的统计数据
+  */
+void CDC_Xfer_GetStats(CDC_XFER_StatsTypeDef *stats)
+{
+	if(stats != NULL)
+		*stats = CDC_Xfer.Stats;
+}
+
+/* ------------------------------------ CDC Interface Funtion ----------------------------------- */
+
+/**
+  * @brief  CDC_Xfer_Init 文件传输CDC实例初始化，在USB中断中调用
+  * @retval USBD_OK
+  */
+static int8_t CDC_Xfer_Init(void)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+
+	hx->InBusy = 0U;
+	hx->OutPaused = 0U;
+	hx->Reset = 1U;
+	USBD_CDC_SetTxBufferEx(hx->pdev, CDC_XFER_PORT, CDC_XferSlot[0], 0U);
+	USBD_CDC_SetRxBufferEx(hx->pdev, CDC_XFER_PORT, CDC_XferOutPacket);
+
+	return (USBD_OK);
+}
+
+/**
+  * @brief  CDC_Xfer_DeInit 文件传输CDC实例去初始化
+  * @retval USBD_OK
+  */
+static int8_t CDC_Xfer_DeInit(void)
+{
+	CDC_Xfer.InBusy = 0U;
+	CDC_Xfer.Reset = 1U;
+
+	return (USBD_OK);
+}
+
+/**
+  * @brief  CDC_Xfer_Control 文件传输CDC实例的类请求，线路编码不起作用
+  * @retval USBD_OK
+  */
+static int8_t CDC_Xfer_Control(uint8_t cmd, uint8_t* pbuf, uint16_t length)
+{
+	UNUSED(length);
+
+	if(cmd == CDC_GET_LINE_CODING)
+	{
+		/* 回报固定的115200 8N1，满足只认串口的主机程序 */
+		pbuf[0] = 0x00U;
+		pbuf[1] = 0xC2U;
+		pbuf[2] = 0x01U;
+		pbuf[3] = 0x00U;
+		pbuf[4] = 0x00U;
+		pbuf[5] = 0x00U;
+		pbuf[6] = 0x08U;
+	}
+
+	return (USBD_OK);
+}
+
+/**
+  * @brief  CDC_Xfer_Receive 主机数据追加到接收队列，在USB中断中调用
+  * @note   剩余空间不足一个包时不再准备接收，主机被NAK，直到任务处理完队列中的帧。
+  * @param  Buf: 收到的数据
+  * @param  Len: 数据长度
+  * @retval USBD_OK
+  */
+static int8_t CDC_Xfer_Receive(uint8_t* Buf, uint32_t *Len)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+	uint32_t head = hx->RxHead;
+	uint32_t first = MIN(*Len, CDC_XFER_RX_SIZE - (head & CDC_XFER_RX_MASK));
+	uint32_t primask;
+
+	memcpy(&CDC_XferRxBuffer[head & CDC_XFER_RX_MASK], Buf, first);
+	memcpy(CDC_XferRxBuffer, Buf + first, *Len - first);
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	hx->RxHead = head + *Len;
+	if(CDC_XFER_RX_SIZE - (hx->RxHead - hx->RxTail) >= COM_CDC_DATA_MAX_PACK_SIZE)
+		USBD_CDC_ReceivePacketEx(hx->pdev, CDC_XFER_PORT);
+	else
+		hx->OutPaused = 1U;
+	__set_PRIMASK(primask);
+
+	return (USBD_OK);
+}
+
+/**
+  * @brief  CDC_Xfer_TransmitCplt USB输入传输完成，在USB中断中调用
+  * @retval USBD_OK
+  */
+static int8_t CDC_Xfer_TransmitCplt(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
+{
+	CDC_XFER_HandleTypeDef *hx = &CDC_Xfer;
+
+	UNUSED(Buf);
+	UNUSED(Len);
+	UNUSED(epnum);
+
+	hx->TxTail++;
+	hx->InBusy = 0U;
+	CDC_Xfer_InKick();
+
+	return (USBD_OK);
+}
+
+#endif /* CDC_XFER_ENABLED */
@@ -0,0 +1,143 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_cdc_xfer.h
+  * @version        : V1.0
+  * @brief          : usbd_cdc_xfer.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_CDC_XFER_H__
+#define __USBD_CDC_XFER_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "usbd_composite.h"
+#include "usbd_cdc_bridge.h"
+
+/* 文件传输开关，打开后CDC_XFER_PORT对应的CDC实例成为文件传输通道 */
+#define CDC_XFER_ENABLED			0U
+/* 文件传输使用的CDC实例，CDC0保留给控制台 */
+#define CDC_XFER_PORT				1U
+
+/* 每个数据块的负载上限，必须为扇区大小的整数倍；块边界按此对齐到文件偏移 */
+#define CDC_XFER_CHUNK_SIZE			0x800U
+/* 发送槽数量，一个在发送时其余的由f_read填充 */
+#define CDC_XFER_SLOT_NUM			3U
+/* 未确认数据块的上限，ACK中的位图为32位，不超过32 */
+#define CDC_XFER_WINDOW				16U
+/* 接收队列大小，必须为2的幂，至少容纳一个完整帧与一个数据包 */
+#define CDC_XFER_RX_SIZE			0x2000U
+/* 窗口内没有进展时重发未确认数据块的间隔，ms */
+#define CDC_XFER_TIMEOUT_MS			500U
+/* 路径长度上限，含盘符 */
+#define CDC_XFER_PATH_MAX			64U
+
+#if (CDC_XFER_ENABLED == 1U) && (COM_CDC_INSTANCE_NUM < 2U)
+#error "CDC file transfer needs a dedicated CDC instance, set COM_CDC_INSTANCE_NUM >= 2"
+#endif
+#if (CDC_XFER_ENABLED == 1U) && (CDC_BRIDGE_ENABLED == 1U) && (CDC_XFER_PORT == CDC_BRIDGE_PORT)
+#error "CDC file transfer and CDC bridge cannot share a CDC instance"
+#endif
+#if (CDC_XFER_WINDOW > 32U)
+#error "CDC_XFER_WINDOW must not exceed 32"
+#endif
+#if (CDC_XFER_RX_SIZE & (CDC_XFER_RX_SIZE - 1U)) != 0U
+#error "CDC_XFER_RX_SIZE must be a power of 2"
+#endif
+
+/*******************************************************************************/
+/* 帧结构，两个方向相同，小端                                                  */
+/*-----------------------------------------------------------------------------*/
+/* Offset | Field    | Size | Description                                      */
+/* 0      | Sync     |  1   | CDC_XFER_SYNC                                    */
+/* 1      | Op       |  1   | CDC_XFER_OP_xxx                                  */
+/* 2      | Seq      |  2   | 数据块序号，ENTRY为目录项序号                    */
+/* 4      | Length   |  2   | 负载长度，不超过CDC_XFER_CHUNK_SIZE              */
+/* 6      | Status   |  1   | 状态或标志                                       */
+/* 7      | Window   |  1   | 窗口大小，只在GET、PUT与INFO中有意义             */
+/* 8      | Offset   |  4   | 文件偏移                                         */
+/* 12     | Arg      |  4   | 长度、位图等，见各操作                           */
+/* 16     | Payload  |  N   |                                                  */
+/* 16+N   | Crc      |  4   | CRC-32(IEEE 802.3)，覆盖Sync至Payload            */
+/*-----------------------------------------------------------------------------*/
+/* LIST  主机 | Payload为目录路径                                              */
+/*       设备 | 每项一个ENTRY：Status属性，Offset为fdate<<16|ftime，           */
+/*            | Arg为文件大小，Payload为名称；最后是END，Arg为项数             */
+/* GET   主机 | Payload为路径，Offset起始偏移，Arg长度(0xFFFFFFFF到文件尾)，   */
+/*            | Window为期望窗口(0为默认)                                      */
+/*       设备 | INFO：Arg为文件大小，Offset为起始偏移，Window为实际窗口；      */
+/*            | 随后发送DATA，全部确认后发送END，Arg为字节数                   */
+/* PUT   主机 | Payload为路径，Offset起始偏移，Arg总长度，Status bit0为1时     */
+/*            | 新建或截断文件；收到INFO后发送DATA                             */
+/*       设备 | INFO：Arg为总长度，Window为实际窗口；每收到DATA回复ACK，       */
+/*            | 全部写入后发送END                                              */
+/* ACK        | Seq为下一个期望的块号(之前的全部收到)，Arg的bit i表示块       */
+/*            | Seq+1+i已收到                                                  */
+/* NAK        | 请求立即重发Seq块：GET中由主机发出，PUT中设备发现缺块时发出    */
+/* ABORT      | 主机中止当前操作，设备以END(ABORTED)应答                       */
+/* END        | 操作结束后再收到ACK、NAK或DATA时重发，主机丢失END时用于恢复    */
+/*-----------------------------------------------------------------------------*/
+/* 数据块k的偏移：k为0时为起始偏移，否则为起始偏移按CDC_XFER_CHUNK_SIZE向下    */
+/* 对齐后加k*CDC_XFER_CHUNK_SIZE，使后续块都落在扇区边界上。                   */
+/* 同一时间只进行一个操作，新的LIST、GET、PUT会中止正在进行的操作。            */
+/*******************************************************************************/
+#define CDC_XFER_SYNC				0x5AU
+#define CDC_XFER_HEAD_SIZE			16U
+#define CDC_XFER_CRC_SIZE			4U
+#define CDC_XFER_FRAME_MAX			(CDC_XFER_HEAD_SIZE + CDC_XFER_CHUNK_SIZE + CDC_XFER_CRC_SIZE)
+
+#define CDC_XFER_OP_LIST			0x01U
+#define CDC_XFER_OP_GET				0x02U
+#define CDC_XFER_OP_PUT				0x03U
+#define CDC_XFER_OP_ACK				0x04U
+#define CDC_XFER_OP_NAK				0x05U
+#define CDC_XFER_OP_ABORT			0x06U
+#define CDC_XFER_OP_DATA			0x10U
+#define CDC_XFER_OP_ENTRY			0x11U
+#define CDC_XFER_OP_INFO			0x12U
+#define CDC_XFER_OP_END				0x13U
+
+#define CDC_XFER_PUT_TRUNCATE		0x01U
+
+#define CDC_XFER_OK					0x00U
+#define CDC_XFER_NO_CARD			0x01U		/**< 卡未挂载 */
+#define CDC_XFER_NOT_FOUND			0x02U		/**< 文件或目录不存在 */
+#define CDC_XFER_LOCKED				0x03U		/**< 文件正被记录器写入 */
+#define CDC_XFER_BAD_REQUEST		0x04U		/**< 参数错误 */
+#define CDC_XFER_IO_ERROR			0x05U		/**< FatFs返回错误，Offset为FRESULT */
+#define CDC_XFER_ABORTED			0x06U
+
+typedef struct
+{
+	uint32_t Requests;		/**< 收到的LIST、GET、PUT请求数 */
+	uint32_t TxBytes;		/**< 发送的文件数据字节数，含重发 */
+	uint32_t RxBytes;		/**< 写入的文件数据字节数 */
+	uint32_t Retransmits;	/**< 重发的数据块数 */
+	uint32_t CrcErrors;		/**< 校验错误的帧数 */
+	uint32_t Resyncs;		/**< 为寻找帧头丢弃的字节数 */
+	uint32_t Errors;		/**< 以错误状态结束的操作数 */
+}CDC_XFER_StatsTypeDef;
+
+uint8_t CDC_Xfer_Attach(USBD_HandleTypeDef *pdev);
+void CDC_Xfer_Poll(void);
+void CDC_Xfer_Task(void);
+void CDC_Xfer_GetStats(CDC_XFER_StatsTypeDef *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_CDC_XFER_H__ */
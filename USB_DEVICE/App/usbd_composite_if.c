@@ -19,6 +19,12 @@
 /* Includes ------------------------------------------------------------------*/
 #include "usbd_composite.h"
 #include "usbd_composite_if.h"
+#include "usb_device.h"
+#include "usbd_cdc_mux.h"
+#include "nmea_filter.h"
+#include "logger.h"
+#include "dlog.h"
+#include "fmt.h"
 #include "stdarg.h"
 #include "stm32h7xx.h"
 #include "sdmmc.h"
@@ -28,11 +34,32 @@
 #include "freertos.h"
 
 /* Typedef -------------------------------------------------------------------*/
+#if (COM_CDC_INSTANCE_NUM > 1U)
+/* 附加CDC实例的应用层数据 */
+typedef struct
+{
+	USBD_CDC_LineCodingTypeDef LineCoding;		/**< 行编码 */
+	uint8_t RxBuffer[CDC_PORT_RX_SIZE];			/**< 接收队列 */
+	uint8_t TxBuffer[CDC_PORT_TX_SIZE];			/**< 发送缓冲，传输完成前不得改动 */
+	__IO uint32_t RxHead;						/**< 接收队列写位置，仅由USB中断修改 */
+	__IO uint32_t RxTail;						/**< 接收队列读位置，仅由读取者修改 */
+	__IO uint8_t RxPaused;						/**< 队列空间不足，暂停接收 */
+	__IO uint8_t TxBusy;						/**< 正在发送 */
+}CDC_PortTypeDef;
+#endif
 
 /* Define --------------------------------------------------------------------*/
 #define STORAGE_LUN_NBR			1			/**< 盘符数量 */
 #define STORAGE_BLK_NBR			0x10000		/**< 扇区数量 */
 #define STORAGE_BLK_SIZ			0x200		/**< 扇区大小 */
+#if (COM_SOF_ENABLED == 1U)
+#define CDC_RX_FRAME_TIMEOUT	10U			/**< 分包超时的帧数，与原TIM6的10ms一致 */
+#endif
+#if (COM_VENDOR_ENABLED == 1U)
+/* 1: 厂商接口作为测试数据源，供Tools/vendorbench.py测量输入方向吞吐 */
+#define VENDOR_BENCH_SOURCE		0U
+#define VENDOR_BENCH_BLOCK_SIZE	0x4000U		/**< 每次提交的发送长度 */
+#endif
 /* Macro ---------------------------------------------------------------------*/
 /* CDC操作接口静态函数 */
 static int8_t CDC_Init_FS(void);
@@ -40,6 +67,36 @@ static int8_t CDC_DeInit_FS(void);
 static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length);
 static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len);
 static int8_t CDC_TransmitCplt_FS(uint8_t *pbuf, uint32_t *Len, uint8_t epnum);
+#if (COM_SOF_ENABLED == 1U)
+static void CDC_RxFrameSof(USBD_HandleTypeDef *pdev, uint32_t frame);
+#endif
+
+#if (COM_CDC_INSTANCE_NUM > 1U)
+/* 附加CDC实例的通用实现 */
+static int8_t CDC_Port_Init(uint8_t index);
+static int8_t CDC_Port_Control(uint8_t index, uint8_t cmd, uint8_t* pbuf, uint16_t length);
+static int8_t CDC_Port_Receive(uint8_t index, uint8_t* Buf, uint32_t *Len);
+static int8_t CDC_Port_TransmitCplt(uint8_t index);
+
+/* 为CDC实例n生成操作接口，回调转发至通用实现 */
+#define CDC_PORT_FOPS(n)																		\
+static int8_t CDC##n##_Init_FS(void) { return CDC_Port_Init(n); }								\
+static int8_t CDC##n##_DeInit_FS(void) { return (USBD_OK); }									\
+static int8_t CDC##n##_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length)				\
+{ return CDC_Port_Control(n, cmd, pbuf, length); }												\
+static int8_t CDC##n##_Receive_FS(uint8_t* Buf, uint32_t *Len)								\
+{ return CDC_Port_Receive(n, Buf, Len); }														\
+static int8_t CDC##n##_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)			\
+{ UNUSED(Buf); UNUSED(Len); UNUSED(epnum); return CDC_Port_TransmitCplt(n); }					\
+USBD_CDC_ItfTypeDef USBD_CDC##n##_Interface_fops_FS =											\
+{																								\
+	CDC##n##_Init_FS,																			\
+	CDC##n##_DeInit_FS,																			\
+	CDC##n##_Control_FS,																		\
+	CDC##n##_Receive_FS,																		\
+	CDC##n##_TransmitCplt_FS,																	\
+};
+#endif
 
 /* MSC操作接口静态函数 */
 static int8_t STORAGE_Init_FS(uint8_t lun);
@@ -50,6 +107,38 @@ static int8_t STORAGE_Read_FS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint
 static int8_t STORAGE_Write_FS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
 static int8_t STORAGE_GetMaxLun_FS(void);
 
+#if (COM_NCM_ENABLED == 1U)
+/* NCM操作接口静态函数 */
+static int8_t NCM_Init_FS(void);
+static int8_t NCM_DeInit_FS(void);
+static int8_t NCM_Receive_FS(uint8_t *Buf, uint16_t Len);
+static int8_t NCM_LinkState_FS(uint8_t Up);
+#endif
+
+#if (COM_VENDOR_ENABLED == 1U)
+/* 厂商接口操作静态函数 */
+static int8_t VENDOR_Init_FS(void);
+static int8_t VENDOR_DeInit_FS(void);
+static int8_t VENDOR_Receive_FS(uint8_t *Buf, uint32_t Len);
+static int8_t VENDOR_TransmitCplt_FS(uint8_t *Buf, uint32_t Len);
+#endif
+
+#if (COM_ISO_ENABLED == 1U)
+/* 同步数据流操作静态函数 */
+static int8_t ISO_Init_FS(void);
+static int8_t ISO_DeInit_FS(void);
+static int8_t ISO_Start_FS(void);
+static int8_t ISO_Stop_FS(void);
+static int8_t ISO_BufferDone_FS(uint8_t *Buf, uint32_t Len);
+#endif
+
+#if (COM_HID_ENABLED == 1U)
+/* HID报告操作静态函数 */
+static int8_t HID_Init_FS(void);
+static int8_t HID_DeInit_FS(void);
+static int8_t HID_Receive_FS(uint8_t *Buf, uint32_t Len);
+#endif
+
 /* Variables -----------------------------------------------------------------*/
 const int8_t STORAGE_Inquirydata_FS[] = {/* 36 */
 	/* LUN 0 */
@@ -90,6 +179,50 @@ USBD_StorageTypeDef USBD_MSC_Interface_fops_FS =
 	(int8_t *)STORAGE_Inquirydata_FS,
 };
 
+#if (COM_NCM_ENABLED == 1U)
+/* NCM操作函数接口，接入网络协议栈时可用USBD_NCM_RegisterInterface替换 */
+USBD_NCM_ItfTypeDef USBD_NCM_Interface_fops_FS =
+{
+	NCM_Init_FS,
+	NCM_DeInit_FS,
+	NCM_Receive_FS,
+	NCM_LinkState_FS,
+};
+#endif
+
+#if (COM_VENDOR_ENABLED == 1U)
+/* 厂商接口操作函数接口，应用可用USBD_VENDOR_RegisterInterface替换 */
+USBD_VENDOR_ItfTypeDef USBD_VENDOR_Interface_fops_FS =
+{
+	VENDOR_Init_FS,
+	VENDOR_DeInit_FS,
+	VENDOR_Receive_FS,
+	VENDOR_TransmitCplt_FS,
+};
+#endif
+
+#if (COM_ISO_ENABLED == 1U)
+/* 同步数据流操作函数接口，应用可用USBD_ISO_RegisterInterface替换 */
+USBD_ISO_ItfTypeDef USBD_ISO_Interface_fops_FS =
+{
+	ISO_Init_FS,
+	ISO_DeInit_FS,
+	ISO_Start_FS,
+	ISO_Stop_FS,
+	ISO_BufferDone_FS,
+};
+#endif
+
+#if (COM_HID_ENABLED == 1U)
+/* HID报告操作函数接口，应用可用USBD_HID_RegisterInterface替换 */
+USBD_HID_ItfTypeDef USBD_HID_Interface_fops_FS =
+{
+	HID_Init_FS,
+	HID_DeInit_FS,
+	HID_Receive_FS,
+};
+#endif
+
 /* CDC特有类 */
 USBD_CDC_LineCodingTypeDef linecoding =
 {
@@ -99,17 +232,41 @@ USBD_CDC_LineCodingTypeDef linecoding =
 	0x08    /* nb. of bits 8*/
 };
 
+#if (COM_VENDOR_ENABLED == 1U) && (VENDOR_BENCH_SOURCE == 1U)
+__ALIGN_BEGIN static uint8_t VendorBenchBlock[VENDOR_BENCH_BLOCK_SIZE] __ALIGN_END;
+static __IO uint8_t VendorBenchRun = 0U;	/**< 主机发来非空数据后开始连续发送，空包停止 */
+#endif
+
 bool Recive_State = Recive_UnFinish;	/**< 接收状态 */
 bool Tag = New_Package;					/**< 下一个包状态 */
 uint16_t Length = 0U;					/**< 包长 */
-static uint8_t Buffer[COM_CDC_DATA_MAX_PACK_SIZE];	/**< 接收单包使用的缓存 */
+__ALIGN_BEGIN static uint8_t Buffer[COM_CDC_DATA_MAX_PACK_SIZE] __ALIGN_END;	/**< 接收单包使用的缓存 */
+#if (COM_SOF_ENABLED == 1U)
+static __IO uint8_t RxFrameTimeout = 0U;	/**< 分包超时剩余帧数，0为未计时 */
+#endif
 
 /* 为接收和传输创建缓冲区，这取决于用户重新定义和/或删除这些定义 */
 /* 通过USB接收的数据被存储在这个缓冲区中 */
 uint8_t UserRxBufferFS[APP_RX_DATA_SIZE];
 
 /* 通过USB CDC发送的数据存储在这个缓冲区中 */
-uint8_t UserTxBufferFS[APP_TX_DATA_SIZE];
+__ALIGN_BEGIN uint8_t UserTxBufferFS[APP_TX_DATA_SIZE] __ALIGN_END;
+
+/* CDC0接收字节流，不依赖TIM6分包，由CDC_Port_Read(0, ...)读取 */
+static uint8_t UserRxStreamFS[APP_RX_STREAM_SIZE];
+static __IO uint32_t RxStreamHead = 0U;		/**< 写位置，仅由USB中断修改 */
+static __IO uint32_t RxStreamTail = 0U;		/**< 读位置，仅由读取者修改 */
+static uint32_t RxStreamDropped = 0U;		/**< 队列满被丢弃的字节数 */
+
+#if (COM_CDC_INSTANCE_NUM > 1U)
+static CDC_PortTypeDef CDC_Port[COM_CDC_INSTANCE_NUM - 1U];
+__ALIGN_BEGIN static uint8_t CDC_PortRxPacket[COM_CDC_INSTANCE_NUM - 1U][COM_CDC_DATA_MAX_PACK_SIZE] __ALIGN_END;	/**< 接收单包使用的缓存 */
+
+CDC_PORT_FOPS(1)
+#if (COM_CDC_INSTANCE_NUM > 2U)
+CDC_PORT_FOPS(2)
+#endif
+#endif
 
 
 extern USBD_HandleTypeDef hUsbDeviceFS;
@@ -125,6 +282,14 @@ static int8_t CDC_Init_FS(void)
 	/* 设置应用程序缓冲区 */
 	USBD_CDC_SetTxBuffer(&hUsbDeviceFS, UserTxBufferFS, 0);
 	USBD_CDC_SetRxBuffer(&hUsbDeviceFS, Buffer);
+	RxStreamTail = RxStreamHead;
+#if (CDC_MUX_ENABLED == 1U)
+	CDC_MUX_Reset();
+#endif
+#if (COM_SOF_ENABLED == 1U)
+	RxFrameTimeout = 0U;
+	(void)USBD_COMPOSITE_SofRegister(CDC_RxFrameSof);
+#endif
 	return (USBD_OK);
 }
 
@@ -150,12 +315,18 @@ static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
 {
 	switch(cmd)
 	{
+		/* 封装命令用于配置NMEA过滤器、查询SD卡记录与切换USB模式，格式见nmea_filter.h、logger.h与usb_device.h */
 		case CDC_SEND_ENCAPSULATED_COMMAND:
-
+			if((length >= 2U) && (pbuf[0] == USB_DEVICE_OP_MODE))
+				USB_Device_RequestMode(pbuf[1]);
+			else if((length != 0U) && (pbuf[0] >= LOGGER_OP_QUERY))
+				(void)Logger_Command(pbuf, length);
+			else
+				(void)NMEA_Filter_Command(pbuf, length);
 			break;
 
 		case CDC_GET_ENCAPSULATED_RESPONSE:
-
+			NMEA_Filter_Response(pbuf, length);
 			break;
 
 		case CDC_SET_COMM_FEATURE:
@@ -192,6 +363,8 @@ static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
 			linecoding.format     = pbuf[4];
 			linecoding.paritytype = pbuf[5];
 			linecoding.datatype   = pbuf[6];
+			DLOG("cdc0: line coding %u %u%c%u", linecoding.bitrate, linecoding.datatype,
+				"NOEMS"[linecoding.paritytype % 5U], linecoding.format);
 			break;
 
 		case CDC_GET_LINE_CODING:
@@ -205,7 +378,7 @@ static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
 			break;
 
 		case CDC_SET_CONTROL_LINE_STATE:
-
+			DLOG("cdc0: control line state 0x%x", ((USBD_SetupReqTypedef *)pbuf)->wValue);
 			break;
 
 		case CDC_SEND_BREAK:
@@ -234,19 +407,38 @@ static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
   */
 static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len)
 {
+	uint32_t head = RxStreamHead;
+	uint32_t first;
+
+	/* 字节流队列不暂停端点，空间不足时丢弃整包，保持TIM6分包的原有时序 */
+	if(APP_RX_STREAM_SIZE - (head - RxStreamTail) >= *Len)
+	{
+		first = MIN(*Len, APP_RX_STREAM_SIZE - (head & (APP_RX_STREAM_SIZE - 1U)));
+		memcpy(&UserRxStreamFS[head & (APP_RX_STREAM_SIZE - 1U)], Buffer, first);
+		memcpy(UserRxStreamFS, Buffer + first, *Len - first);
+		RxStreamHead = head + *Len;
+	}
+	else
+		RxStreamDropped += *Len;
+
+#if (COM_SOF_ENABLED == 1U)
+	RxFrameTimeout = 0U;
+#else
 	if(Old_Package == Tag)
 	{
 		//Stop Time
 		__HAL_TIM_DISABLE_IT(&htim6, TIM_IT_UPDATE);
 		__HAL_TIM_DISABLE(&htim6);
 	}		
+#endif
 	memcpy(UserRxBufferFS + Length, Buffer, *Len);
 	Length += *Len;
-	if(COM_CDC_DATA_MAX_PACK_SIZE == *Len)
+	/* 满包说明后面还有数据，包长取当前速度下端点的包长 */
+	if(hUsbDeviceFS.ep_out[COM_CDC_OUT_EP & 0x0FU].maxpacket == *Len)
 	{
 		if(Old_Package != Tag)
 			/* 新包 */
-			Length = COM_CDC_DATA_MAX_PACK_SIZE;
+			Length = *Len;
 		Tag = Old_Package;
 		Recive_State = Recive_UnFinish;
 	}
@@ -260,9 +452,14 @@ static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len)
 	}
 	if(Old_Package == Tag)
 	{
+#if (COM_SOF_ENABLED == 1U)
+		/* 满包后若干帧内没有后续数据，由帧任务结束分包 */
+		RxFrameTimeout = CDC_RX_FRAME_TIMEOUT;
+#else
 		//Start Time
 		__HAL_TIM_ENABLE_IT(&htim6, TIM_IT_UPDATE);
 		__HAL_TIM_ENABLE(&htim6);
+#endif
 	}
 	USBD_CDC_SetRxBuffer(&hUsbDeviceFS, Buffer);
 	USBD_CDC_ReceivePacket(&hUsbDeviceFS);
@@ -270,6 +467,25 @@ static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len)
 	return (USBD_OK);
 }
 
+#if (COM_SOF_ENABLED == 1U)
+/**
+  * @brief  CDC0分包超时的帧任务，代替TIM6中断结束以满包收尾的包
+  * @param  pdev: 设备实例
+  * @param  frame: 帧计数
+  */
+static void CDC_RxFrameSof(USBD_HandleTypeDef *pdev, uint32_t frame)
+{
+	UNUSED(pdev);
+	UNUSED(frame);
+
+	if((RxFrameTimeout != 0U) && (--RxFrameTimeout == 0U))
+	{
+		Tag = New_Package;
+		Recive_State = Recive_Finish;
+	}
+}
+#endif
+
 /**
   * @brief  通过USB IN端点发送的数据通过CDC接口发送。
   *         
@@ -282,28 +498,29 @@ static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len)
   */
 uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len)
 {
-	uint8_t result = USBD_OK;
-	uint32_t TimeStart = HAL_GetTick();
-	USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef*)hUsbDeviceFS.pClassData;
-
-	while(hcdc->TxState)
+#if (CDC_MUX_ENABLED == 1U)
+	/* 复用器开启时数据经大块数据通道发送 */
+	return CDC_MUX_Write(CDC_MUX_CH_BULK, Buf, Len);
+#else
+	uint8_t result;
+	uint32_t primask;
+
+	/* pClassData随模式与功能切换，不能用来判断CDC是否空闲；端点忙时发送返回USBD_BUSY */
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if((USB_Device_Online == 0U) || (hUsbDeviceFS.dev_state != USBD_STATE_CONFIGURED))
 	{
-		if(HAL_GetTick() - TimeStart > 10)
-			return USBD_BUSY;
-		else
-			break;
+		result = USBD_FAIL;
 	}
-	USBD_CDC_SetTxBuffer(&hUsbDeviceFS, Buf, Len);
-	result = USBD_CDC_TransmitPacket(&hUsbDeviceFS);
-	while(hcdc->TxState)
+	else
 	{
-		if(HAL_GetTick() - TimeStart > 10)
-			return USBD_BUSY;
-		else
-			break;
+		USBD_CDC_SetTxBuffer(&hUsbDeviceFS, Buf, Len);
+		result = USBD_CDC_TransmitPacket(&hUsbDeviceFS);
 	}
+	__set_PRIMASK(primask);
 
 	return result;
+#endif
 }
 
 /**
@@ -324,12 +541,18 @@ static int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
 
 	UNUSED(Buf);
 	UNUSED(Len);
+	UNUSED(epnum);
+
+#if (CDC_MUX_ENABLED == 1U)
+	CDC_MUX_TxCplt();
+#endif
 
 	return result;
 }
 
 /**
   * @brief  usb打印函数
+  * @note   格式化由fmt.c完成，支持的说明符见fmt.h，不支持浮点。
   * @param  format: 字符串指针，可带不定长度变量
   * @return 操作状态
   * @retval USBD_OK，如果所有操作都是OK，否则USBD_FAIL
@@ -338,38 +561,475 @@ uint8_t usb_printf(const char *format, ...)
 {
 	va_list args;
 	uint8_t result = USBD_OK;
-	uint32_t length;
+#if (CDC_MUX_ENABLED == 0U)
+	FMT_WriterTypeDef writer;
+#endif
 
 	va_start(args, format);
-	length = vsnprintf((char *)UserTxBufferFS, APP_TX_DATA_SIZE, (char *)format, args);
+#if (CDC_MUX_ENABLED == 1U)
+	/* 格式化后整条写入LOG通道的发送队列 */
+	result = DLOG_VPrint(format, args);
+#else
+	FMT_Init(&writer, UserTxBufferFS, APP_TX_DATA_SIZE);
+	FMT_VPrint(&writer, format, args);
+	result = CDC_Transmit_FS(UserTxBufferFS, (uint16_t)MIN(writer.Length, APP_TX_DATA_SIZE));
+#endif
 	va_end(args);
-	result = CDC_Transmit_FS(UserTxBufferFS, length);
 
 	return (uint8_t)result;
 }
 
+/* ---------------------------------- CDC Port ----------------------------------------- */
+
 /**
-  * @brief  usb打印函数
-  * @param  format: 字符串指针，可带不定长度变量
-  * @return 操作状态
-  * @retval USBD_OK，如果所有操作都是OK，否则USBD_FAIL
+  * @brief  CDC_Port_GetLineCoding 获取CDC实例的行编码
+  * @param  index: CDC实例编号
+  * @retval 行编码，实例不存在时返回NULL
   */
-uint8_t usb_scanf(const char *format, ...)
+USBD_CDC_LineCodingTypeDef *CDC_Port_GetLineCoding(uint8_t index)
 {
-    va_list args;
-    uint8_t result;
+	if(index == 0U)
+		return &linecoding;
+#if (COM_CDC_INSTANCE_NUM > 1U)
+	if(index < COM_CDC_INSTANCE_NUM)
+		return &CDC_Port[index - 1U].LineCoding;
+#endif
+	return NULL;
+}
+
+/**
+  * @brief  CDC_Stream_Read 从CDC0接收字节流读取数据
+  * @param  Buf: 数据缓冲区
+  * @param  Len: 缓冲区长度
+  * @retval 实际读取的字节数
+  */
+static uint32_t CDC_Stream_Read(uint8_t *Buf, uint32_t Len)
+{
+	uint32_t tail = RxStreamTail;
+	uint32_t first;
+
+	Len = MIN(Len, RxStreamHead - tail);
+	first = MIN(Len, APP_RX_STREAM_SIZE - (tail & (APP_RX_STREAM_SIZE - 1U)));
+	memcpy(Buf, &UserRxStreamFS[tail & (APP_RX_STREAM_SIZE - 1U)], first);
+	memcpy(Buf + first, UserRxStreamFS, Len - first);
+	RxStreamTail = tail + Len;
+
+	return Len;
+}
 
-    va_start(args, format);
-	while((Recive_Finish != Recive_State) || (New_Package != Tag))
-		osDelay(10);
-    result = vsscanf((char *)UserRxBufferFS, format, args);
-	Recive_State = Recive_UnFinish;
-	Length = 0U;
-    va_end(args);
+/**
+  * @brief  CDC_Port_Read 从CDC实例读取数据
+  * @note   CDC0读取的是接收字节流，与TIM6分包得到的UserRxBufferFS互不影响。
+  * @param  index: CDC实例编号
+  * @param  Buf: 数据缓冲区
+  * @param  Len: 缓冲区长度
+  * @retval 实际读取的字节数
+  */
+uint32_t CDC_Port_Read(uint8_t index, uint8_t *Buf, uint32_t Len)
+{
+#if (COM_CDC_INSTANCE_NUM > 1U)
+	CDC_PortTypeDef *port;
+	uint32_t tail, first, primask;
+
+	if(index == 0U)
+		return CDC_Stream_Read(Buf, Len);
+	if(index >= COM_CDC_INSTANCE_NUM)
+		return 0U;
+
+	port = &CDC_Port[index - 1U];
+	tail = port->RxTail;
+	Len = MIN(Len, port->RxHead - tail);
+	first = MIN(Len, CDC_PORT_RX_SIZE - (tail & (CDC_PORT_RX_SIZE - 1U)));
+	memcpy(Buf, &port->RxBuffer[tail & (CDC_PORT_RX_SIZE - 1U)], first);
+	memcpy(Buf + first, port->RxBuffer, Len - first);
+	port->RxTail = tail + Len;
+
+	/* 腾出足够空间后恢复接收 */
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if((port->RxPaused != 0U) && (USB_Device_Online != 0U) && (CDC_PORT_RX_SIZE - (port->RxHead - port->RxTail) >= COM_CDC_DATA_MAX_PACK_SIZE))
+	{
+		port->RxPaused = 0U;
+		USBD_CDC_ReceivePacketEx(&hUsbDeviceFS, index);
+	}
+	__set_PRIMASK(primask);
+
+	return Len;
+#else
+	if(index == 0U)
+		return CDC_Stream_Read(Buf, Len);
 
-    return result;
+	return 0U;
+#endif
 }
 
+/**
+  * @brief  CDC_Port_Write 通过附加CDC实例发送数据
+  * @param  index: CDC实例编号
+  * @param  Buf: 要发送的数据
+  * @param  Len: 数据长度，不超过CDC_PORT_TX_SIZE
+  * @retval USBD_OK，上一次发送未完成时返回USBD_BUSY，否则USBD_FAIL
+  */
+uint8_t CDC_Port_Write(uint8_t index, const uint8_t *Buf, uint16_t Len)
+{
+#if (COM_CDC_INSTANCE_NUM > 1U)
+	CDC_PortTypeDef *port;
+	uint32_t primask;
+	uint8_t result;
+
+	if((index == 0U) || (index >= COM_CDC_INSTANCE_NUM) || (Len > CDC_PORT_TX_SIZE))
+		return USBD_FAIL;
+
+	port = &CDC_Port[index - 1U];
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if((USB_Device_Online == 0U) || (hUsbDeviceFS.dev_state != USBD_STATE_CONFIGURED))
+	{
+		__set_PRIMASK(primask);
+		return USBD_FAIL;
+	}
+	if(port->TxBusy != 0U)
+	{
+		__set_PRIMASK(primask);
+		return USBD_BUSY;
+	}
+	port->TxBusy = 1U;
+	__set_PRIMASK(primask);
+
+	memcpy(port->TxBuffer, Buf, Len);
+
+	/* 复制期间可能开始切换模式，启动传输前再检查一次 */
+	__disable_irq();
+	if(USB_Device_Online == 0U)
+	{
+		port->TxBusy = 0U;
+		__set_PRIMASK(primask);
+		return USBD_FAIL;
+	}
+	USBD_CDC_SetTxBufferEx(&hUsbDeviceFS, index, port->TxBuffer, Len);
+	result = USBD_CDC_TransmitPacketEx(&hUsbDeviceFS, index);
+	if(result != USBD_OK)
+		port->TxBusy = 0U;
+	__set_PRIMASK(primask);
+
+	return result;
+#else
+	UNUSED(index);
+	UNUSED(Buf);
+	UNUSED(Len);
+
+	return USBD_FAIL;
+#endif
+}
+
+#if (COM_CDC_INSTANCE_NUM > 1U)
+/**
+  * @brief  CDC_Port_Init 初始化附加CDC实例
+  * @param  index: CDC实例编号
+  * @retval USBD_OK
+  */
+static int8_t CDC_Port_Init(uint8_t index)
+{
+	CDC_PortTypeDef *port = &CDC_Port[index - 1U];
+
+	if(port->LineCoding.bitrate == 0U)
+	{
+		port->LineCoding.bitrate = 115200U;
+		port->LineCoding.datatype = 0x08U;
+	}
+	port->RxHead = 0U;
+	port->RxTail = 0U;
+	port->RxPaused = 0U;
+	port->TxBusy = 0U;
+	USBD_CDC_SetTxBufferEx(&hUsbDeviceFS, index, port->TxBuffer, 0U);
+	USBD_CDC_SetRxBufferEx(&hUsbDeviceFS, index, CDC_PortRxPacket[index - 1U]);
+
+	return (USBD_OK);
+}
+
+/**
+  * @brief  CDC_Port_Control 附加CDC实例的类请求
+  * @param  index: CDC实例编号
+  * @param  cmd: 命令代码
+  * @param  pbuf: 缓冲区包含命令数据(请求参数)
+  * @param  length: 数据长度
+  * @retval USBD_OK
+  */
+static int8_t CDC_Port_Control(uint8_t index, uint8_t cmd, uint8_t* pbuf, uint16_t length)
+{
+	USBD_CDC_LineCodingTypeDef *coding = &CDC_Port[index - 1U].LineCoding;
+
+	UNUSED(length);
+
+	switch(cmd)
+	{
+		case CDC_SET_LINE_CODING:
+			coding->bitrate    = (uint32_t)(pbuf[0] | (pbuf[1] << 8) | (pbuf[2] << 16) | (pbuf[3] << 24));
+			coding->format     = pbuf[4];
+			coding->paritytype = pbuf[5];
+			coding->datatype   = pbuf[6];
+			break;
+
+		case CDC_GET_LINE_CODING:
+			pbuf[0] = (uint8_t)(coding->bitrate);
+			pbuf[1] = (uint8_t)(coding->bitrate >> 8);
+			pbuf[2] = (uint8_t)(coding->bitrate >> 16);
+			pbuf[3] = (uint8_t)(coding->bitrate >> 24);
+			pbuf[4] = coding->format;
+			pbuf[5] = coding->paritytype;
+			pbuf[6] = coding->datatype;
+			break;
+
+		default:
+			break;
+	}
+
+	return (USBD_OK);
+}
+
+/**
+  * @brief  CDC_Port_Receive 附加CDC实例收到数据包，在USB中断中调用
+  * @note   数据存入接收队列；剩余空间不足一个包时暂停接收，由CDC_Port_Read恢复。
+  * @param  index: CDC实例编号
+  * @param  Buf: 收到的数据
+  * @param  Len: 数据长度
+  * @retval USBD_OK
+  */
+static int8_t CDC_Port_Receive(uint8_t index, uint8_t* Buf, uint32_t *Len)
+{
+	CDC_PortTypeDef *port = &CDC_Port[index - 1U];
+	uint32_t head = port->RxHead;
+	uint32_t first = MIN(*Len, CDC_PORT_RX_SIZE - (head & (CDC_PORT_RX_SIZE - 1U)));
+
+	memcpy(&port->RxBuffer[head & (CDC_PORT_RX_SIZE - 1U)], Buf, first);
+	memcpy(port->RxBuffer, Buf + first, *Len - first);
+	port->RxHead = head + *Len;
+
+	if(CDC_PORT_RX_SIZE - (port->RxHead - port->RxTail) >= COM_CDC_DATA_MAX_PACK_SIZE)
+		USBD_CDC_ReceivePacketEx(&hUsbDeviceFS, index);
+	else
+		port->RxPaused = 1U;
+
+	return (USBD_OK);
+}
+
+/**
+  * @brief  CDC_Port_TransmitCplt 附加CDC实例发送完成，在USB中断中调用
+  * @param  index: CDC实例编号
+  * @retval USBD_OK
+  */
+static int8_t CDC_Port_TransmitCplt(uint8_t index)
+{
+	CDC_Port[index - 1U].TxBusy = 0U;
+
+	return (USBD_OK);
+}
+#endif
+
+#if (COM_NCM_ENABLED == 1U)
+/* ------------------------------------- NCM -------------------------------------------- */
+
+/**
+  * @brief  NCM_Init_FS 初始化网络接口
+  * @retval USBD_OK
+  */
+static int8_t NCM_Init_FS(void)
+{
+	return (USBD_OK);
+}
+
+/**
+  * @brief  NCM_DeInit_FS 去初始化网络接口
+  * @retval USBD_OK
+  */
+static int8_t NCM_DeInit_FS(void)
+{
+	return (USBD_OK);
+}
+
+/**
+  * @brief  NCM_Receive_FS 收到主机发送的以太网帧，在USB中断中调用
+  * @note   缓冲区在函数返回后即被下一个NTB覆盖，协议栈须在此复制数据。
+  * @param  Buf: 以太网帧
+  * @param  Len: 帧长
+  * @retval USBD_OK
+  */
+static int8_t NCM_Receive_FS(uint8_t *Buf, uint16_t Len)
+{
+	UNUSED(Buf);
+	UNUSED(Len);
+	/* 未接入协议栈时丢弃 */
+
+	return (USBD_OK);
+}
+
+/**
+  * @brief  NCM_LinkState_FS 主机启用或停用网络数据接口
+  * @param  Up: 1为连接，0为断开
+  * @retval USBD_OK
+  */
+static int8_t NCM_LinkState_FS(uint8_t Up)
+{
+	UNUSED(Up);
+
+	return (USBD_OK);
+}
+#endif
+
+#if (COM_VENDOR_ENABLED == 1U)
+/* ------------------------------------ Vendor ------------------------------------------ */
+
+/**
+  * @brief  VENDOR_Init_FS 初始化厂商接口
+  * @retval USBD_OK
+  */
+static int8_t VENDOR_Init_FS(void)
+{
+	return (USBD_OK);
+}
+
+/**
+  * @brief  VENDOR_DeInit_FS 去初始化厂商接口
+  * @retval USBD_OK
+  */
+static int8_t VENDOR_DeInit_FS(void)
+{
+	return (USBD_OK);
+}
+
+/**
+  * @brief  VENDOR_Receive_FS 收到主机下发的数据，在USB中断中调用
+  * @note   缓冲区在下一段数据收满后被重新使用。
+  * @param  Buf: 数据
+  * @param  Len: 数据长度
+  * @retval USBD_OK
+  */
+static int8_t VENDOR_Receive_FS(uint8_t *Buf, uint32_t Len)
+{
+	UNUSED(Buf);
+	UNUSED(Len);
+
+#if (VENDOR_BENCH_SOURCE == 1U)
+	VendorBenchRun = (Len != 0U) ? 1U : 0U;
+	if(VendorBenchRun != 0U)
+		(void)USBD_VENDOR_Transmit(&hUsbDeviceFS, VendorBenchBlock, sizeof(VendorBenchBlock));
+#endif
+
+	return (USBD_OK);
+}
+
+/**
+  * @brief  VENDOR_TransmitCplt_FS 一块数据发送完成，在USB中断中调用
+  * @param  Buf: 已发送的数据
+  * @param  Len: 数据长度
+  * @retval USBD_OK
+  */
+static int8_t VENDOR_TransmitCplt_FS(uint8_t *Buf, uint32_t Len)
+{
+	UNUSED(Buf);
+	UNUSED(Len);
+
+#if (VENDOR_BENCH_SOURCE == 1U)
+	if(VendorBenchRun != 0U)
+		(void)USBD_VENDOR_Transmit(&hUsbDeviceFS, VendorBenchBlock, sizeof(VendorBenchBlock));
+#endif
+
+	return (USBD_OK);
+}
+#endif
+
+#if (COM_ISO_ENABLED == 1U)
+/* ------------------------------------ Isochronous ------------------------------------- */
+
+/**
+  * @brief  ISO_Init_FS 初始化同步数据流
+  * @retval USBD_OK
+  */
+static int8_t ISO_Init_FS(void)
+{
+	return (USBD_OK);
+}
+
+/**
+  * @brief  ISO_DeInit_FS 去初始化同步数据流
+  * @retval USBD_OK
+  */
+static int8_t ISO_DeInit_FS(void)
+{
+	return (USBD_OK);
+}
+
+/**
+  * @brief  ISO_Start_FS 主机打开数据流，此后可经USBD_ISO_Submit提交数据
+  * @retval USBD_OK
+  */
+static int8_t ISO_Start_FS(void)
+{
+	return (USBD_OK);
+}
+
+/**
+  * @brief  ISO_Stop_FS 主机关闭数据流，未发出的缓冲已全部交还
+  * @retval USBD_OK
+  */
+static int8_t ISO_Stop_FS(void)
+{
+	return (USBD_OK);
+}
+
+/**
+  * @brief  ISO_BufferDone_FS 一块数据已发出或被丢弃，在USB中断中调用
+  * @param  Buf: 交还的缓冲
+  * @param  Len: 数据长度
+  * @retval USBD_OK
+  */
+static int8_t ISO_BufferDone_FS(uint8_t *Buf, uint32_t Len)
+{
+	UNUSED(Buf);
+	UNUSED(Len);
+
+	return (USBD_OK);
+}
+#endif
+
+#if (COM_HID_ENABLED == 1U)
+/* ------------------------------------ HID ------------------------------------------- */
+
+/**
+  * @brief  HID_Init_FS 初始化HID接口
+  * @retval USBD_OK
+  */
+static int8_t HID_Init_FS(void)
+{
+	return (USBD_OK);
+}
+
+/**
+  * @brief  HID_DeInit_FS 去初始化HID接口
+  * @retval USBD_OK
+  */
+static int8_t HID_DeInit_FS(void)
+{
+	return (USBD_OK);
+}
+
+/**
+  * @brief  HID_Receive_FS 收到主机下发的输出报告，在USB中断中调用
+  * @note   默认丢弃报告。应用在这里处理命令，或用USBD_HID_RegisterInterface
+  *         注册自己的接口；应答用USBD_HID_SendReport提交。
+  * @param  Buf: 报告数据
+  * @param  Len: 报告长度
+  * @retval USBD_OK
+  */
+static int8_t HID_Receive_FS(uint8_t *Buf, uint32_t Len)
+{
+	UNUSED(Buf);
+	UNUSED(Len);
+
+	return (USBD_OK);
+}
+#endif
+
 /* ------------------------------------- MSC -------------------------------------------- */
 
 /**
@@ -397,20 +1057,27 @@ int8_t STORAGE_GetCapacity_FS(uint8_t lun, uint32_t *block_num, uint16_t *block_
 {
 	UNUSED(lun);
 	HAL_SD_CardInfoTypeDef info;
+	int8_t ret = USBD_FAIL;
+
+	/* 卡由记录任务使用时不访问SDMMC1 */
+	if(Logger_CardBegin() != 0U)
+		return (USBD_FAIL);
 
 	if(HAL_SD_GetCardState(&hsd1) == HAL_SD_CARD_TRANSFER)
 	{
 		HAL_SD_GetCardInfo(&hsd1, &info);
 		*block_num  = info.LogBlockNbr;
 		*block_size = info.LogBlockSize;
-		return (USBD_OK);
+		ret = USBD_OK;
 	}
+	Logger_CardEnd();
 
-	return (USBD_FAIL);
+	return ret;
 }
 
 /**
   * @brief  检查介质是否准备好
+  * @note   卡由记录任务挂载期间报告未就绪，Logger_Release交出后才就绪
   * @param  lun: 逻辑单元号
   * @return 操作状态
   * @retval USBD_OK，如果所有操作都是OK，否则USBD_FAIL
@@ -419,7 +1086,7 @@ int8_t STORAGE_IsReady_FS(uint8_t lun)
 {
 	UNUSED(lun);
 
-	return (USBD_OK);
+	return (Logger_CardFree() != 0U) ? USBD_OK : USBD_FAIL;
 }
 
 /**
@@ -452,6 +1119,9 @@ int8_t STORAGE_Read_FS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t bl
 	UNUSED(blk_len);
 	int8_t ret = USBD_FAIL;
 
+	if(Logger_CardBegin() != 0U)
+		return (USBD_FAIL);
+
 	if(HAL_SD_ReadBlocks(&hsd1, buf, blk_addr, blk_len, HAL_MAX_DELAY) == HAL_OK)
 	{
 		ret = USBD_OK;
@@ -459,6 +1129,7 @@ int8_t STORAGE_Read_FS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t bl
 		while(HAL_SD_GetState(&hsd1) == HAL_SD_STATE_BUSY);
 		while(HAL_SD_GetCardState(&hsd1) != HAL_SD_CARD_TRANSFER);    
 	}
+	Logger_CardEnd();
 
 	return ret;
 }
@@ -480,6 +1151,9 @@ int8_t STORAGE_Write_FS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t b
 	UNUSED(blk_len);
 	int8_t ret = USBD_FAIL;
 
+	if(Logger_CardBegin() != 0U)
+		return (USBD_FAIL);
+
 	if(HAL_SD_WriteBlocks(&hsd1, buf, blk_addr, blk_len, HAL_MAX_DELAY) == HAL_OK)
 	{
 		ret = USBD_OK;
@@ -487,8 +1161,9 @@ int8_t STORAGE_Write_FS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t b
 		while(HAL_SD_GetState(&hsd1) == HAL_SD_STATE_BUSY);
 		while(HAL_SD_GetCardState(&hsd1) != HAL_SD_CARD_TRANSFER);    
 	}
+	Logger_CardEnd();
 
-	return (USBD_OK);
+	return ret;
 }
 
 /**
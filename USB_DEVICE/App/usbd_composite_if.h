@@ -25,11 +25,21 @@
 #endif
 
 #include "usbd_composite.h"
+#include "usbd_ncm.h"
+#include "usbd_vendor.h"
+#include "usbd_iso.h"
+#include "usbd_hid.h"
 #include "stdbool.h"
+#include "fmt.h"
 
 /* 定义CDC上接收和传输缓冲区的大小 */
 #define APP_RX_DATA_SIZE	0x800
 #define APP_TX_DATA_SIZE	0x800
+/* CDC0接收字节流队列大小，必须为2的幂，供流式解析按字节读取 */
+#define APP_RX_STREAM_SIZE	0x800
+/* 附加CDC实例(CDC1、CDC2)的缓冲区大小，接收缓冲必须为2的幂 */
+#define CDC_PORT_RX_SIZE	0x400
+#define CDC_PORT_TX_SIZE	0x200
 #define Recive_Finish		true
 #define Recive_UnFinish		false
 #define New_Package			true
@@ -44,11 +54,31 @@ extern uint8_t UserTxBufferFS[APP_TX_DATA_SIZE];
 /* 操作接口句柄 */
 extern USBD_CDC_ItfTypeDef USBD_CDC_Interface_fops_FS;
 extern USBD_StorageTypeDef USBD_MSC_Interface_fops_FS;
+#if (COM_CDC_INSTANCE_NUM > 1U)
+extern USBD_CDC_ItfTypeDef USBD_CDC1_Interface_fops_FS;
+#endif
+#if (COM_CDC_INSTANCE_NUM > 2U)
+extern USBD_CDC_ItfTypeDef USBD_CDC2_Interface_fops_FS;
+#endif
+#if (COM_NCM_ENABLED == 1U)
+extern USBD_NCM_ItfTypeDef USBD_NCM_Interface_fops_FS;
+#endif
+#if (COM_VENDOR_ENABLED == 1U)
+extern USBD_VENDOR_ItfTypeDef USBD_VENDOR_Interface_fops_FS;
+#endif
+#if (COM_ISO_ENABLED == 1U)
+extern USBD_ISO_ItfTypeDef USBD_ISO_Interface_fops_FS;
+#endif
+#if (COM_HID_ENABLED == 1U)
+extern USBD_HID_ItfTypeDef USBD_HID_Interface_fops_FS;
+#endif
 
 /* 外部函数 */
 uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len);
-uint8_t usb_printf(const char *format, ...);
-uint8_t usb_scanf(const char *format, ...);
+uint8_t usb_printf(const char *format, ...) FMT_PRINTF_CHECK(1, 2);
+uint32_t CDC_Port_Read(uint8_t index, uint8_t *Buf, uint32_t Len);
+uint8_t CDC_Port_Write(uint8_t index, const uint8_t *Buf, uint16_t Len);
+USBD_CDC_LineCodingTypeDef *CDC_Port_GetLineCoding(uint8_t index);
 
 #ifdef __cplusplus
 }
@@ -24,6 +24,7 @@
 #include "usbd_conf.h"
 
 /* USER CODE BEGIN INCLUDE */
+#include "usbd_composite.h"
 
 /* USER CODE END INCLUDE */
 
@@ -66,6 +67,7 @@
 #define USBD_LANGID_STRING						0x1404
 #define USBD_MANUFACTURER_STRING				"Sunshine Circuit"
 #define USBD_PID_FS								0x0000
+#define USBD_PID_MSC_ONLY_FS					0x0001		/**< MSC单独模式换用另一PID，主机按新设备绑定驱动 */
 #define USBD_PRODUCT_STRING_FS					"Vital Sign Monitoring"
 #define USBD_CONFIGURATION_STRING_FS			"Composite Config"
 #define USBD_CDC_CONTROL_INTERFACE_STRING_FS	"CDC Control Interface"
@@ -107,6 +109,7 @@
   */
 
 static void Get_SerialNum(void);
+static void Get_NCMMac(void);
 static void IntToUnicode(uint32_t value, uint8_t * pbuf, uint8_t len);
 
 /**
@@ -131,6 +134,11 @@ uint8_t * USBD_FS_HIDDataInterfaceStrDescriptor(USBD_SpeedTypeDef speed, uint16_
 uint8_t * USBD_FS_CDCIADStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
 uint8_t * USBD_FS_MSCIADStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
 uint8_t * USBD_FS_HIDIADStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
+uint8_t * USBD_FS_NCMMacStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
+#if (USBD_CLASS_BOS_ENABLED == 1U)
+uint8_t * USBD_FS_BOSDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
+uint8_t * USBD_FS_MSOS20Descriptor(USBD_SpeedTypeDef speed, uint16_t *length);
+#endif /* USBD_CLASS_BOS_ENABLED */
 
 
 /**
@@ -157,6 +165,11 @@ USBD_DescriptorsTypeDef FS_Desc =
 	USBD_FS_CDCIADStrDescriptor,
 	USBD_FS_MSCIADStrDescriptor,
 	USBD_FS_HIDIADStrDescriptor,
+	USBD_FS_NCMMacStrDescriptor,
+#if (USBD_CLASS_BOS_ENABLED == 1U)
+	USBD_FS_BOSDescriptor,
+	USBD_FS_MSOS20Descriptor,
+#endif /* USBD_CLASS_BOS_ENABLED */
 };
 
 #if defined ( __ICCARM__ ) /* IAR Compiler */
@@ -167,7 +180,11 @@ __ALIGN_BEGIN uint8_t USBD_FS_DeviceDesc[USB_LEN_DEV_DESC] __ALIGN_END =
 {
   0x12,                       /*bLength */
   USB_DESC_TYPE_DEVICE,       /*bDescriptorType*/
+#if (USBD_CLASS_BOS_ENABLED == 1U)
+  0x01,                       /*bcdUSB: 2.01，主机才会读取BOS描述符 */
+#else
   0x00,                       /*bcdUSB */
+#endif /* USBD_CLASS_BOS_ENABLED */
   0x02,
   0xEF,                       /*bDeviceClass*/
   0x02,                       /*bDeviceSubClass*/
@@ -185,8 +202,125 @@ __ALIGN_BEGIN uint8_t USBD_FS_DeviceDesc[USB_LEN_DEV_DESC] __ALIGN_END =
   USBD_MAX_NUM_CONFIGURATION  /*bNumConfigurations*/
 };
 
+#if defined ( __ICCARM__ ) /* IAR Compiler */
+  #pragma data_alignment=4
+#endif /* defined ( __ICCARM__ ) */
+/** MSC单独模式的设备描述符，类在接口中声明；不提供BOS，bcdUSB固定为2.00 */
+__ALIGN_BEGIN uint8_t USBD_FS_MscOnlyDeviceDesc[USB_LEN_DEV_DESC] __ALIGN_END =
+{
+  0x12,                       /*bLength */
+  USB_DESC_TYPE_DEVICE,       /*bDescriptorType*/
+  0x00,                       /*bcdUSB */
+  0x02,
+  0x00,                       /*bDeviceClass*/
+  0x00,                       /*bDeviceSubClass*/
+  0x00,                       /*bDeviceProtocol*/
+  USB_MAX_EP0_SIZE,           /*bMaxPacketSize*/
+  LOBYTE(USBD_VID),           /*idVendor*/
+  HIBYTE(USBD_VID),           /*idVendor*/
+  LOBYTE(USBD_PID_MSC_ONLY_FS), /*idProduct*/
+  HIBYTE(USBD_PID_MSC_ONLY_FS), /*idProduct*/
+  0x00,                       /*bcdDevice rel. 2.00*/
+  0x02,
+  USBD_IDX_MFC_STR,           /*Index of manufacturer  string*/
+  USBD_IDX_PRODUCT_STR,       /*Index of product string*/
+  USBD_IDX_SERIAL_STR,        /*Index of serial number string*/
+  USBD_MAX_NUM_CONFIGURATION  /*bNumConfigurations*/
+};
+
 /* USB_DeviceDescriptor */
 
+#if (USBD_CLASS_BOS_ENABLED == 1U)
+#if defined ( __ICCARM__ ) /* IAR Compiler */
+  #pragma data_alignment=4
+#endif /* defined ( __ICCARM__ ) */
+/** BOS描述符，平台能力描述符告知Windows读取MS OS 2.0描述符集合 */
+__ALIGN_BEGIN uint8_t USBD_FS_BOSDesc[USB_LEN_BOS_DESC] __ALIGN_END =
+{
+	0x05,										/* bLength */
+	USB_DESC_TYPE_BOS,							/* bDescriptorType */
+	LOBYTE(USB_LEN_BOS_DESC),					/* wTotalLength */
+	HIBYTE(USB_LEN_BOS_DESC),
+	0x01,										/* bNumDeviceCaps */
+
+	/* 平台能力描述符 */
+	0x1C,										/* bLength */
+	0x10,										/* bDescriptorType: DEVICE CAPABILITY */
+	0x05,										/* bDevCapabilityType: PLATFORM */
+	0x00,										/* bReserved */
+	0xDF, 0x60, 0xDD, 0xD8, 0x89, 0x45, 0xC7, 0x4C,	/* PlatformCapabilityUUID: MS OS 2.0 */
+	0x9C, 0xD2, 0x65, 0x9D, 0x9E, 0x64, 0x8A, 0x9F,
+	0x00, 0x00, 0x03, 0x06,						/* dwWindowsVersion: Windows 8.1 */
+	LOBYTE(USB_LEN_MS_OS_20_DESC),				/* wMSOSDescriptorSetTotalLength */
+	HIBYTE(USB_LEN_MS_OS_20_DESC),
+	USB_REQ_MS_OS_20_VENDOR_CODE,				/* bMS_VendorCode */
+	0x00,										/* bAltEnumCode */
+};
+
+/* MS OS 2.0功能子集：声明WinUSB兼容ID与DeviceInterfaceGUIDs，共USB_LEN_MS_OS_20_FUNC字节；
+   各功能的GUID只有最后一位不同，主机程序按GUID区分接口 */
+#define USBD_MSOS20_WINUSB_FUNC(itf, guid_last)																\
+	/* 功能子集头 */																							\
+	0x08, 0x00,									/* wLength */													\
+	0x02, 0x00,									/* wDescriptorType: MS_OS_20_SUBSET_HEADER_FUNCTION */			\
+	(itf),										/* bFirstInterface */											\
+	0x00,										/* bReserved */													\
+	LOBYTE(USB_LEN_MS_OS_20_FUNC),				/* wSubsetLength */												\
+	HIBYTE(USB_LEN_MS_OS_20_FUNC),																				\
+																												\
+	/* 兼容ID描述符 */																							\
+	0x14, 0x00,									/* wLength */													\
+	0x03, 0x00,									/* wDescriptorType: MS_OS_20_FEATURE_COMPATBLE_ID */			\
+	'W', 'I', 'N', 'U', 'S', 'B', 0x00, 0x00,	/* CompatibleID */												\
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	/* SubCompatibleID */										\
+																												\
+	/* 注册表属性描述符：DeviceInterfaceGUIDs，供主机程序枚举设备 */													\
+	0x84, 0x00,									/* wLength */													\
+	0x04, 0x00,									/* wDescriptorType: MS_OS_20_FEATURE_REG_PROPERTY */			\
+	0x07, 0x00,									/* wPropertyDataType: REG_MULTI_SZ */							\
+	0x2A, 0x00,									/* wPropertyNameLength */										\
+	'D', 0x00, 'e', 0x00, 'v', 0x00, 'i', 0x00, 'c', 0x00, 'e', 0x00, 'I', 0x00, 'n', 0x00,						\
+	't', 0x00, 'e', 0x00, 'r', 0x00, 'f', 0x00, 'a', 0x00, 'c', 0x00, 'e', 0x00, 'G', 0x00,						\
+	'U', 0x00, 'I', 0x00, 'D', 0x00, 's', 0x00,																	\
+	0x00, 0x00,																									\
+	0x50, 0x00,									/* wPropertyDataLength */										\
+	'{', 0x00, '8', 0x00, 'C', 0x00, '3', 0x00, 'F', 0x00, '1', 0x00, 'A', 0x00, '6', 0x00,						\
+	'2', 0x00, '-', 0x00, '5', 0x00, 'D', 0x00, '4', 0x00, 'E', 0x00, '-', 0x00, '4', 0x00,						\
+	'B', 0x00, '7', 0x00, 'A', 0x00, '-', 0x00, '9', 0x00, 'E', 0x00, '2', 0x00, '1', 0x00,						\
+	'-', 0x00, '3', 0x00, 'F', 0x00, '6', 0x00, 'D', 0x00, '0', 0x00, 'C', 0x00, '8', 0x00,						\
+	'B', 0x00, '5', 0x00, 'A', 0x00, '4', 0x00, (guid_last), 0x00, '}', 0x00,									\
+	0x00, 0x00, 0x00, 0x00
+
+#if defined ( __ICCARM__ ) /* IAR Compiler */
+  #pragma data_alignment=4
+#endif /* defined ( __ICCARM__ ) */
+/** MS OS 2.0描述符集合，只对厂商接口与同步数据流接口声明WinUSB兼容ID，其余接口仍由系统类驱动加载 */
+__ALIGN_BEGIN uint8_t USBD_FS_MSOS20Desc[USB_LEN_MS_OS_20_DESC] __ALIGN_END =
+{
+	/* 描述符集合头 */
+	0x0A, 0x00,									/* wLength */
+	0x00, 0x00,									/* wDescriptorType: MS_OS_20_SET_HEADER_DESCRIPTOR */
+	0x00, 0x00, 0x03, 0x06,						/* dwWindowsVersion */
+	LOBYTE(USB_LEN_MS_OS_20_DESC),				/* wTotalLength */
+	HIBYTE(USB_LEN_MS_OS_20_DESC),
+
+	/* 配置子集头 */
+	0x08, 0x00,									/* wLength */
+	0x01, 0x00,									/* wDescriptorType: MS_OS_20_SUBSET_HEADER_CONFIGURATION */
+	0x00,										/* bConfigurationValue: 配置索引 */
+	0x00,										/* bReserved */
+	LOBYTE(USB_LEN_MS_OS_20_DESC - 0x0A),		/* wTotalLength */
+	HIBYTE(USB_LEN_MS_OS_20_DESC - 0x0A),
+
+#if (COM_VENDOR_ENABLED == 1U)
+	USBD_MSOS20_WINUSB_FUNC(COM_VENDOR_ITF_NBR, '7'),
+#endif
+#if (COM_ISO_ENABLED == 1U)
+	USBD_MSOS20_WINUSB_FUNC(COM_ISO_ITF_NBR, '8'),
+#endif
+};
+#endif /* USBD_CLASS_BOS_ENABLED */
+
 /**
   * @}
   */
@@ -209,11 +343,69 @@ __ALIGN_BEGIN uint8_t USBD_LangIDDesc[USB_LEN_LANGID_STR_DESC] __ALIGN_END =
      HIBYTE(USBD_LANGID_STRING)
 };
 
+/* 字符串描述符在USBD_FS_DescInit中一次转换为UTF-16，请求时直接返回；
+   长度为2字节描述符头加每字符2字节，sizeof含结束符恰好抵消 */
+#define USBD_STR_DESC_SIZ(str)		(2U * sizeof(str))
+
+#if defined ( __ICCARM__ ) /* IAR Compiler */
+  #pragma data_alignment=4
+#endif /* defined ( __ICCARM__ ) */
+__ALIGN_BEGIN static uint8_t USBD_ManufacturerStrDesc[USBD_STR_DESC_SIZ(USBD_MANUFACTURER_STRING)] __ALIGN_END;
+#if defined ( __ICCARM__ ) /* IAR Compiler */
+  #pragma data_alignment=4
+#endif /* defined ( __ICCARM__ ) */
+__ALIGN_BEGIN static uint8_t USBD_ProductStrDesc[USBD_STR_DESC_SIZ(USBD_PRODUCT_STRING_FS)] __ALIGN_END;
+#if defined ( __ICCARM__ ) /* IAR Compiler */
+  #pragma data_alignment=4
+#endif /* defined ( __ICCARM__ ) */
+__ALIGN_BEGIN static uint8_t USBD_ConfigStrDesc[USBD_STR_DESC_SIZ(USBD_CONFIGURATION_STRING_FS)] __ALIGN_END;
+#if defined ( __ICCARM__ ) /* IAR Compiler */
+  #pragma data_alignment=4
+#endif /* defined ( __ICCARM__ ) */
+__ALIGN_BEGIN static uint8_t USBD_CDCControlStrDesc[USBD_STR_DESC_SIZ(USBD_CDC_CONTROL_INTERFACE_STRING_FS)] __ALIGN_END;
+#if defined ( __ICCARM__ ) /* IAR Compiler */
+  #pragma data_alignment=4
+#endif /* defined ( __ICCARM__ ) */
+__ALIGN_BEGIN static uint8_t USBD_CDCDataStrDesc[USBD_STR_DESC_SIZ(USBD_CDC_DATA_INTERFACE_STRING_FS)] __ALIGN_END;
+#if defined ( __ICCARM__ ) /* IAR Compiler */
+  #pragma data_alignment=4
+#endif /* defined ( __ICCARM__ ) */
+__ALIGN_BEGIN static uint8_t USBD_MSCDataStrDesc[USBD_STR_DESC_SIZ(USBD_MSC_DATA_INTERFACE_STRING_FS)] __ALIGN_END;
+#if defined ( __ICCARM__ ) /* IAR Compiler */
+  #pragma data_alignment=4
+#endif /* defined ( __ICCARM__ ) */
+__ALIGN_BEGIN static uint8_t USBD_HIDDataStrDesc[USBD_STR_DESC_SIZ(USBD_HID_DATA_INTERFACE_STRING_FS)] __ALIGN_END;
 #if defined ( __ICCARM__ ) /* IAR Compiler */
   #pragma data_alignment=4
 #endif /* defined ( __ICCARM__ ) */
-/* Internal string descriptor. */
-__ALIGN_BEGIN uint8_t USBD_StrDesc[USBD_MAX_STR_DESC_SIZ] __ALIGN_END;
+__ALIGN_BEGIN static uint8_t USBD_CDCIADStrDesc[USBD_STR_DESC_SIZ(USBD_CDC_IAD_STRING_FS)] __ALIGN_END;
+#if defined ( __ICCARM__ ) /* IAR Compiler */
+  #pragma data_alignment=4
+#endif /* defined ( __ICCARM__ ) */
+__ALIGN_BEGIN static uint8_t USBD_MSCIADStrDesc[USBD_STR_DESC_SIZ(USBD_MSC_IAD_STRING_FS)] __ALIGN_END;
+#if defined ( __ICCARM__ ) /* IAR Compiler */
+  #pragma data_alignment=4
+#endif /* defined ( __ICCARM__ ) */
+__ALIGN_BEGIN static uint8_t USBD_HIDIADStrDesc[USBD_STR_DESC_SIZ(UABD_HID_IAD_STRING_FS)] __ALIGN_END;
+
+/* 需要转换的字符串与对应的描述符缓冲 */
+static const struct
+{
+  const char *Str;
+  uint8_t *Desc;
+} USBD_StrDescInit[] =
+{
+  {USBD_MANUFACTURER_STRING,             USBD_ManufacturerStrDesc},
+  {USBD_PRODUCT_STRING_FS,               USBD_ProductStrDesc},
+  {USBD_CONFIGURATION_STRING_FS,         USBD_ConfigStrDesc},
+  {USBD_CDC_CONTROL_INTERFACE_STRING_FS, USBD_CDCControlStrDesc},
+  {USBD_CDC_DATA_INTERFACE_STRING_FS,    USBD_CDCDataStrDesc},
+  {USBD_MSC_DATA_INTERFACE_STRING_FS,    USBD_MSCDataStrDesc},
+  {USBD_HID_DATA_INTERFACE_STRING_FS,    USBD_HIDDataStrDesc},
+  {USBD_CDC_IAD_STRING_FS,               USBD_CDCIADStrDesc},
+  {USBD_MSC_IAD_STRING_FS,               USBD_MSCIADStrDesc},
+  {UABD_HID_IAD_STRING_FS,               USBD_HIDIADStrDesc},
+};
 
 #if defined ( __ICCARM__ ) /*!< IAR Compiler */
   #pragma data_alignment=4
@@ -223,6 +415,14 @@ __ALIGN_BEGIN uint8_t USBD_StringSerial[USB_SIZ_STRING_SERIAL] __ALIGN_END = {
   USB_DESC_TYPE_STRING,
 };
 
+#if defined ( __ICCARM__ ) /*!< IAR Compiler */
+  #pragma data_alignment=4
+#endif
+__ALIGN_BEGIN uint8_t USBD_StringNCMMac[USB_SIZ_STRING_NCM_MAC] __ALIGN_END = {
+  USB_SIZ_STRING_NCM_MAC,
+  USB_DESC_TYPE_STRING,
+};
+
 /**
   * @}
   */
@@ -241,6 +441,11 @@ __ALIGN_BEGIN uint8_t USBD_StringSerial[USB_SIZ_STRING_SERIAL] __ALIGN_END = {
 uint8_t * USBD_FS_DeviceDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
   UNUSED(speed);
+  if (USBD_COMPOSITE_GetMode() == COM_MODE_MSC_ONLY)
+  {
+    *length = sizeof(USBD_FS_MscOnlyDeviceDesc);
+    return USBD_FS_MscOnlyDeviceDesc;
+  }
   *length = sizeof(USBD_FS_DeviceDesc);
   return USBD_FS_DeviceDesc;
 }
@@ -266,15 +471,9 @@ uint8_t * USBD_FS_LangIDStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
   */
 uint8_t * USBD_FS_ProductStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
-  if(speed == 0)
-  {
-    USBD_GetString((uint8_t *)USBD_PRODUCT_STRING_FS, USBD_StrDesc, length);
-  }
-  else
-  {
-    USBD_GetString((uint8_t *)USBD_PRODUCT_STRING_FS, USBD_StrDesc, length);
-  }
-  return USBD_StrDesc;
+  UNUSED(speed);
+  *length = sizeof(USBD_ProductStrDesc);
+  return USBD_ProductStrDesc;
 }
 
 /**
@@ -286,8 +485,8 @@ uint8_t * USBD_FS_ProductStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length
 uint8_t * USBD_FS_ManufacturerStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
   UNUSED(speed);
-  USBD_GetString((uint8_t *)USBD_MANUFACTURER_STRING, USBD_StrDesc, length);
-  return USBD_StrDesc;
+  *length = sizeof(USBD_ManufacturerStrDesc);
+  return USBD_ManufacturerStrDesc;
 }
 
 /**
@@ -301,9 +500,7 @@ uint8_t * USBD_FS_SerialStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
   UNUSED(speed);
   *length = USB_SIZ_STRING_SERIAL;
 
-  /* Update the serial number string descriptor with the data from the unique
-   * ID */
-  Get_SerialNum();
+  /* 序列号已在USBD_FS_DescInit中由唯一ID生成 */
   /* USER CODE BEGIN USBD_FS_SerialStrDescriptor */
 
   /* USER CODE END USBD_FS_SerialStrDescriptor */
@@ -318,15 +515,9 @@ uint8_t * USBD_FS_SerialStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
   */
 uint8_t * USBD_FS_ConfigStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
-  if(speed == USBD_SPEED_HIGH)
-  {
-    USBD_GetString((uint8_t *)USBD_CONFIGURATION_STRING_FS, USBD_StrDesc, length);
-  }
-  else
-  {
-    USBD_GetString((uint8_t *)USBD_CONFIGURATION_STRING_FS, USBD_StrDesc, length);
-  }
-  return USBD_StrDesc;
+  UNUSED(speed);
+  *length = sizeof(USBD_ConfigStrDesc);
+  return USBD_ConfigStrDesc;
 }
 
 /**
@@ -337,15 +528,9 @@ uint8_t * USBD_FS_ConfigStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
   */
 uint8_t * USBD_FS_CDCControlInterfaceStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
-  if(speed == 0)
-  {
-    USBD_GetString((uint8_t *)USBD_CDC_CONTROL_INTERFACE_STRING_FS, USBD_StrDesc, length);
-  }
-  else
-  {
-    USBD_GetString((uint8_t *)USBD_CDC_CONTROL_INTERFACE_STRING_FS, USBD_StrDesc, length);
-  }
-  return USBD_StrDesc;
+  UNUSED(speed);
+  *length = sizeof(USBD_CDCControlStrDesc);
+  return USBD_CDCControlStrDesc;
 }
 
 /**
@@ -356,8 +541,9 @@ uint8_t * USBD_FS_CDCControlInterfaceStrDescriptor(USBD_SpeedTypeDef speed, uint
   */
 uint8_t * USBD_FS_CDCDataInterfaceStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
-	USBD_GetString((uint8_t *)USBD_CDC_DATA_INTERFACE_STRING_FS, USBD_StrDesc, length);
-	return USBD_StrDesc;
+	UNUSED(speed);
+	*length = sizeof(USBD_CDCDataStrDesc);
+	return USBD_CDCDataStrDesc;
 }
 
 /**
@@ -368,8 +554,9 @@ uint8_t * USBD_FS_CDCDataInterfaceStrDescriptor(USBD_SpeedTypeDef speed, uint16_
   */
 uint8_t * USBD_FS_MSCDataInterfaceStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
-	USBD_GetString((uint8_t *)USBD_MSC_DATA_INTERFACE_STRING_FS, USBD_StrDesc, length);
-	return USBD_StrDesc;
+	UNUSED(speed);
+	*length = sizeof(USBD_MSCDataStrDesc);
+	return USBD_MSCDataStrDesc;
 }
 
 /**
@@ -380,8 +567,9 @@ uint8_t * USBD_FS_MSCDataInterfaceStrDescriptor(USBD_SpeedTypeDef speed, uint16_
   */
 uint8_t * USBD_FS_HIDDataInterfaceStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
-	USBD_GetString((uint8_t *)USBD_HID_DATA_INTERFACE_STRING_FS, USBD_StrDesc, length);
-	return USBD_StrDesc;
+	UNUSED(speed);
+	*length = sizeof(USBD_HIDDataStrDesc);
+	return USBD_HIDDataStrDesc;
 }
 
 /**
@@ -392,8 +580,9 @@ uint8_t * USBD_FS_HIDDataInterfaceStrDescriptor(USBD_SpeedTypeDef speed, uint16_
   */
 uint8_t * USBD_FS_CDCIADStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
-	USBD_GetString((uint8_t *)USBD_CDC_IAD_STRING_FS, USBD_StrDesc, length);
-	return USBD_StrDesc;
+	UNUSED(speed);
+	*length = sizeof(USBD_CDCIADStrDesc);
+	return USBD_CDCIADStrDesc;
 }
 
 /**
@@ -404,8 +593,9 @@ uint8_t * USBD_FS_CDCIADStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
   */
 uint8_t * USBD_FS_MSCIADStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
-	USBD_GetString((uint8_t *)USBD_MSC_IAD_STRING_FS, USBD_StrDesc, length);
-	return USBD_StrDesc;
+	UNUSED(speed);
+	*length = sizeof(USBD_MSCIADStrDesc);
+	return USBD_MSCIADStrDesc;
 }
 
 /**
@@ -416,8 +606,67 @@ uint8_t * USBD_FS_MSCIADStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
   */
 uint8_t * USBD_FS_HIDIADStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
-	USBD_GetString((uint8_t *)UABD_HID_IAD_STRING_FS, USBD_StrDesc, length);
-	return USBD_StrDesc;
+	UNUSED(speed);
+	*length = sizeof(USBD_HIDIADStrDesc);
+	return USBD_HIDIADStrDesc;
+}
+
+/**
+  * @brief  Return the NCM MAC address string descriptor
+  * @note   主机端网卡使用的MAC地址：首字节0x02为本地管理的单播地址，其余5字节取自芯片唯一ID。
+  * @param  speed : Current device speed
+  * @param  length : Pointer to data length variable
+  * @retval Pointer to descriptor buffer
+  */
+uint8_t * USBD_FS_NCMMacStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
+{
+	UNUSED(speed);
+	*length = USB_SIZ_STRING_NCM_MAC;
+	return USBD_StringNCMMac;
+}
+
+#if (USBD_CLASS_BOS_ENABLED == 1U)
+/**
+  * @brief  Return the BOS descriptor
+  * @param  speed : Current device speed
+  * @param  length : Pointer to data length variable
+  * @retval Pointer to descriptor buffer
+  */
+uint8_t * USBD_FS_BOSDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
+{
+	UNUSED(speed);
+	*length = sizeof(USBD_FS_BOSDesc);
+	return USBD_FS_BOSDesc;
+}
+
+/**
+  * @brief  Return the MS OS 2.0 descriptor set
+  * @param  speed : Current device speed
+  * @param  length : Pointer to data length variable
+  * @retval Pointer to descriptor buffer
+  */
+uint8_t * USBD_FS_MSOS20Descriptor(USBD_SpeedTypeDef speed, uint16_t *length)
+{
+	UNUSED(speed);
+	*length = sizeof(USBD_FS_MSOS20Desc);
+	return USBD_FS_MSOS20Desc;
+}
+#endif /* USBD_CLASS_BOS_ENABLED */
+
+/**
+  * @brief  USBD_FS_DescInit 生成全部字符串描述符
+  * @note   在USBD_Init之前调用一次，此后字符串请求不再做任何转换。
+  */
+void USBD_FS_DescInit(void)
+{
+	uint16_t len;
+	uint32_t i;
+
+	for(i = 0U; i < sizeof(USBD_StrDescInit) / sizeof(USBD_StrDescInit[0]); i++)
+		USBD_GetString((uint8_t *)USBD_StrDescInit[i].Str, USBD_StrDescInit[i].Desc, &len);
+
+	Get_SerialNum();
+	Get_NCMMac();
 }
 
 /**
@@ -442,6 +691,24 @@ static void Get_SerialNum(void)
   }
 }
 
+/**
+  * @brief  Get_NCMMac 生成NCM的MAC地址字符串描述符
+  * @note   首字节0x02为本地管理的单播地址，其余5字节取自芯片唯一ID。
+  */
+static void Get_NCMMac(void)
+{
+	uint32_t deviceserial0, deviceserial1, deviceserial2;
+
+	deviceserial0 = *(uint32_t *) DEVICE_ID1;
+	deviceserial1 = *(uint32_t *) DEVICE_ID2;
+	deviceserial2 = *(uint32_t *) DEVICE_ID3;
+
+	/* 最低字节取反，设备侧协议栈可使用未取反的地址，避免两端MAC相同 */
+	IntToUnicode(0x02000000U, &USBD_StringNCMMac[2], 2);
+	IntToUnicode(deviceserial0 + deviceserial2, &USBD_StringNCMMac[6], 8);
+	IntToUnicode(~deviceserial1 << 24, &USBD_StringNCMMac[22], 2);
+}
+
 /**
   * @brief  Convert Hex 32Bits value into char
   * @param  value: value to convert
@@ -50,6 +50,11 @@
 #define         DEVICE_ID3          (UID_BASE + 0x8)
 
 #define  USB_SIZ_STRING_SERIAL       0x1A
+#define  USB_SIZ_STRING_NCM_MAC      0x1A
+#define  USB_LEN_BOS_DESC            0x21
+#define  USB_LEN_MS_OS_20_FUNC       0xA0
+/* 集合头与配置子集头，加上每个WinUSB功能一个子集，仅在包含usbd_composite.h的文件中使用 */
+#define  USB_LEN_MS_OS_20_DESC       (0x12 + USB_LEN_MS_OS_20_FUNC * (COM_VENDOR_ENABLED + COM_ISO_ENABLED))
 
 /* USER CODE BEGIN EXPORTED_CONSTANTS */
 
@@ -120,6 +125,7 @@ extern USBD_DescriptorsTypeDef FS_Desc;
   */
 
 /* USER CODE BEGIN EXPORTED_FUNCTIONS */
+void USBD_FS_DescInit(void);
 
 /* USER CODE END EXPORTED_FUNCTIONS */
 
@@ -26,19 +26,81 @@
 #include "usbd_composite.h"
 
 /* USER CODE BEGIN Includes */
+#include "main.h"
+#include "usbd_fifo.h"
+#include "usbd_event.h"
 
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+/* OTG_FS与OTG_HS各有4KB的FIFO RAM */
+#define USBD_LL_FIFO_WORDS          1024U
+/* DMA模式下控制器把各端点的DMA地址保存在FIFO RAM末尾，每个端点的每个方向预留1字 */
+#define USBD_LL_FIFO_DMA_RESERVE    (2U * USBD_FIFO_TX_NUM)
+/* 复合类使用帧调度时打开SOF中断 */
+#if (COM_SOF_ENABLED == 1U)
+#define USBD_LL_SOF_ENABLE          ENABLE
+#else
+#define USBD_LL_SOF_ENABLE          DISABLE
+#endif /* COM_SOF_ENABLED */
+#if (USBD_DEFERRED_EVENTS == 1U)
+/* 中断中要通知USB任务，优先级不能高于configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY */
+#define USBD_LL_IRQ_PRIORITY        5U
+#define USBD_LL_EP1_IRQ_PRIORITY    5U
+/* LL接口可能在USB任务或应用任务中调用，期间屏蔽USB中断 */
+#define USBD_LL_LOCK()              USBD_Event_Lock()
+#define USBD_LL_UNLOCK()            USBD_Event_Unlock()
+#else
+#define USBD_LL_IRQ_PRIORITY        4U
+#define USBD_LL_EP1_IRQ_PRIORITY    3U
+#define USBD_LL_LOCK()
+#define USBD_LL_UNLOCK()
+#endif /* USBD_DEFERRED_EVENTS */
 /* Private macro -------------------------------------------------------------*/
 
 /* USER CODE BEGIN PV */
 /* Private variables ---------------------------------------------------------*/
+/* 输入端点的FIFO提示{包数, 优先级}，未列出的端点批量缓存2个包、其余1个包，优先级最低；
+   全速下都能满足，高速下空间不足时先满足MSC与NCM */
+static const USBD_FIFO_HintTypeDef USBD_LL_FifoHint[USBD_FIFO_TX_NUM] =
+{
+  [COM_MSC_IN_EP & 0x0FU] = {4U, 2U},
+  [COM_CDC_IN_EP & 0x0FU] = {4U, 1U},
+#if (COM_NCM_ENABLED == 1U)
+  /* NCM以NTB为单位连续发送 */
+  [COM_NCM_IN_EP & 0x0FU] = {8U, 2U},
+#elif (COM_CDC_INSTANCE_NUM > 1U)
+  [COM_CDC1_IN_EP & 0x0FU] = {4U, 1U},
+#endif
+#if (COM_CDC_INSTANCE_NUM > 2U)
+  [COM_CDC2_IN_EP & 0x0FU] = {4U, 1U},
+#elif (COM_VENDOR_ENABLED == 1U)
+  /* 厂商接口连续发送大块数据 */
+  [COM_VENDOR_IN_EP & 0x0FU] = {8U, 1U},
+#endif
+#if (COM_ISO_ENABLED == 1U)
+  /* 同步端点同时只挂一个包，一包空间即可，优先级高于批量端点以保证每帧带宽 */
+  [COM_ISO_IN_EP & 0x0FU] = {1U, 3U},
+#endif
+#if (COM_HID_ENABLED == 1U)
+  /* HID报告不超过一包，同样优先分配，报告不因FIFO不足而推迟 */
+  [COM_HID_IN_EP & 0x0FU] = {1U, 3U},
+#endif
+};
+
+/* MSC单独模式只有MSC一个输入端点，其余编号只占16字，发送FIFO尽量给MSC */
+static const USBD_FIFO_HintTypeDef USBD_LL_MscOnlyFifoHint[USBD_FIFO_TX_NUM] =
+{
+  [COM_MSC_IN_EP & 0x0FU] = {8U, 2U},
+};
 
 /* USER CODE END PV */
 
 PCD_HandleTypeDef hpcd_USB_OTG_FS;
+#if (USBD_USE_OTG_HS == 1U)
+PCD_HandleTypeDef hpcd_USB_OTG_HS;
+#endif /* USBD_USE_OTG_HS */
 void Error_Handler(void);
 
 /* External functions --------------------------------------------------------*/
@@ -50,6 +112,7 @@ void Error_Handler(void);
 /* USER CODE BEGIN PFP */
 /* Private function prototypes -----------------------------------------------*/
 USBD_StatusTypeDef USBD_Get_USB_Status(HAL_StatusTypeDef hal_status);
+static void USBD_LL_FifoInit(PCD_HandleTypeDef *hpcd, uint16_t budget);
 
 /* USER CODE END PFP */
 
@@ -102,16 +165,99 @@ void HAL_PCD_MspInit(PCD_HandleTypeDef* pcdHandle)
     __HAL_RCC_USB_OTG_FS_CLK_ENABLE();
 
     /* Peripheral interrupt init */
-    HAL_NVIC_SetPriority(OTG_FS_EP1_OUT_IRQn, 3, 0);
+    HAL_NVIC_SetPriority(OTG_FS_EP1_OUT_IRQn, USBD_LL_EP1_IRQ_PRIORITY, 0);
     HAL_NVIC_EnableIRQ(OTG_FS_EP1_OUT_IRQn);
-    HAL_NVIC_SetPriority(OTG_FS_EP1_IN_IRQn, 3, 0);
+    HAL_NVIC_SetPriority(OTG_FS_EP1_IN_IRQn, USBD_LL_EP1_IRQ_PRIORITY, 0);
     HAL_NVIC_EnableIRQ(OTG_FS_EP1_IN_IRQn);
-    HAL_NVIC_SetPriority(OTG_FS_IRQn, 4, 0);
+    HAL_NVIC_SetPriority(OTG_FS_IRQn, USBD_LL_IRQ_PRIORITY, 0);
     HAL_NVIC_EnableIRQ(OTG_FS_IRQn);
   /* USER CODE BEGIN USB_OTG_FS_MspInit 1 */
 
   /* USER CODE END USB_OTG_FS_MspInit 1 */
   }
+#if (USBD_USE_OTG_HS == 1U)
+  else if(pcdHandle->Instance==USB_OTG_HS)
+  {
+  /* USER CODE BEGIN USB_OTG_HS_MspInit 0 */
+
+  /* USER CODE END USB_OTG_HS_MspInit 0 */
+
+  /** Initializes the peripherals clock
+  */
+    PeriphClkInitStruct.PeriphClockSelection = RCC_PERIPHCLK_USB;
+    PeriphClkInitStruct.UsbClockSelection = RCC_USBCLKSOURCE_HSI48;
+    if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInitStruct) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+  /** Enable USB Voltage detector
+  */
+    HAL_PWREx_EnableUSBVoltageDetector();
+
+#if (USBD_HS_ULPI_PHY == 1U)
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    __HAL_RCC_GPIOC_CLK_ENABLE();
+    /**USB_OTG_HS GPIO Configuration
+    PA3      ------> USB_OTG_HS_ULPI_D0
+    PA5      ------> USB_OTG_HS_ULPI_CK
+    PB0      ------> USB_OTG_HS_ULPI_D1
+    PB1      ------> USB_OTG_HS_ULPI_D2
+    PB10     ------> USB_OTG_HS_ULPI_D3
+    PB11     ------> USB_OTG_HS_ULPI_D4
+    PB12     ------> USB_OTG_HS_ULPI_D5
+    PB13     ------> USB_OTG_HS_ULPI_D6
+    PB5      ------> USB_OTG_HS_ULPI_D7
+    PC0      ------> USB_OTG_HS_ULPI_STP
+    PC2_C    ------> USB_OTG_HS_ULPI_DIR
+    PC3_C    ------> USB_OTG_HS_ULPI_NXT
+    */
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    GPIO_InitStruct.Alternate = GPIO_AF10_OTG2_HS;
+    GPIO_InitStruct.Pin = GPIO_PIN_3|GPIO_PIN_5;
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+    GPIO_InitStruct.Pin = GPIO_PIN_0|GPIO_PIN_1|GPIO_PIN_5|GPIO_PIN_10|GPIO_PIN_11|GPIO_PIN_12|GPIO_PIN_13;
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+    GPIO_InitStruct.Pin = GPIO_PIN_0|GPIO_PIN_2|GPIO_PIN_3;
+    HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
+
+    /* Peripheral clock enable */
+    __HAL_RCC_USB_OTG_HS_CLK_ENABLE();
+    __HAL_RCC_USB_OTG_HS_ULPI_CLK_ENABLE();
+#else
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    /**USB_OTG_HS GPIO Configuration
+    PB14     ------> USB_OTG_HS_DM
+    PB15     ------> USB_OTG_HS_DP
+    */
+    GPIO_InitStruct.Pin = GPIO_PIN_14|GPIO_PIN_15;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    GPIO_InitStruct.Alternate = GPIO_AF12_OTG2_FS;
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+
+    /* Peripheral clock enable */
+    __HAL_RCC_USB_OTG_HS_CLK_ENABLE();
+    /* 使用内置PHY时ULPI时钟在睡眠模式下保持开启会使控制器停止工作 */
+    __HAL_RCC_USB_OTG_HS_ULPI_CLK_SLEEP_DISABLE();
+#endif /* USBD_HS_ULPI_PHY */
+
+    /* Peripheral interrupt init */
+    HAL_NVIC_SetPriority(OTG_HS_EP1_OUT_IRQn, USBD_LL_EP1_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(OTG_HS_EP1_OUT_IRQn);
+    HAL_NVIC_SetPriority(OTG_HS_EP1_IN_IRQn, USBD_LL_EP1_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(OTG_HS_EP1_IN_IRQn);
+    HAL_NVIC_SetPriority(OTG_HS_IRQn, USBD_LL_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(OTG_HS_IRQn);
+  /* USER CODE BEGIN USB_OTG_HS_MspInit 1 */
+
+  /* USER CODE END USB_OTG_HS_MspInit 1 */
+  }
+#endif /* USBD_USE_OTG_HS */
 }
 
 void HAL_PCD_MspDeInit(PCD_HandleTypeDef* pcdHandle)
@@ -141,6 +287,36 @@ void HAL_PCD_MspDeInit(PCD_HandleTypeDef* pcdHandle)
 
   /* USER CODE END USB_OTG_FS_MspDeInit 1 */
   }
+#if (USBD_USE_OTG_HS == 1U)
+  else if(pcdHandle->Instance==USB_OTG_HS)
+  {
+  /* USER CODE BEGIN USB_OTG_HS_MspDeInit 0 */
+
+  /* USER CODE END USB_OTG_HS_MspDeInit 0 */
+    /* Peripheral clock disable */
+    __HAL_RCC_USB_OTG_HS_CLK_DISABLE();
+#if (USBD_HS_ULPI_PHY == 1U)
+    __HAL_RCC_USB_OTG_HS_ULPI_CLK_DISABLE();
+
+    HAL_GPIO_DeInit(GPIOA, GPIO_PIN_3|GPIO_PIN_5);
+    HAL_GPIO_DeInit(GPIOB, GPIO_PIN_0|GPIO_PIN_1|GPIO_PIN_5|GPIO_PIN_10|GPIO_PIN_11|GPIO_PIN_12|GPIO_PIN_13);
+    HAL_GPIO_DeInit(GPIOC, GPIO_PIN_0|GPIO_PIN_2|GPIO_PIN_3);
+#else
+    HAL_GPIO_DeInit(GPIOB, GPIO_PIN_14|GPIO_PIN_15);
+#endif /* USBD_HS_ULPI_PHY */
+
+    /* Peripheral interrupt Deinit*/
+    HAL_NVIC_DisableIRQ(OTG_HS_EP1_OUT_IRQn);
+
+    HAL_NVIC_DisableIRQ(OTG_HS_EP1_IN_IRQn);
+
+    HAL_NVIC_DisableIRQ(OTG_HS_IRQn);
+
+  /* USER CODE BEGIN USB_OTG_HS_MspDeInit 1 */
+
+  /* USER CODE END USB_OTG_HS_MspDeInit 1 */
+  }
+#endif /* USBD_USE_OTG_HS */
 }
 
 /**
@@ -154,7 +330,11 @@ static void PCD_SetupStageCallback(PCD_HandleTypeDef *hpcd)
 void HAL_PCD_SetupStageCallback(PCD_HandleTypeDef *hpcd)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
+#if (USBD_DEFERRED_EVENTS == 1U)
+  USBD_Event_Post(USBD_EVENT_SETUP, 0U, (uint8_t *)hpcd->Setup);
+#else
   USBD_LL_SetupStage((USBD_HandleTypeDef*)hpcd->pData, (uint8_t *)hpcd->Setup);
+#endif /* USBD_DEFERRED_EVENTS */
 }
 
 /**
@@ -169,7 +349,11 @@ static void PCD_DataOutStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
 void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
+#if (USBD_DEFERRED_EVENTS == 1U)
+  USBD_Event_Post(USBD_EVENT_DATA_OUT, epnum, NULL);
+#else
   USBD_LL_DataOutStage((USBD_HandleTypeDef*)hpcd->pData, epnum, hpcd->OUT_ep[epnum].xfer_buff);
+#endif /* USBD_DEFERRED_EVENTS */
 }
 
 /**
@@ -184,7 +368,11 @@ static void PCD_DataInStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
 void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
+#if (USBD_DEFERRED_EVENTS == 1U)
+  USBD_Event_Post(USBD_EVENT_DATA_IN, epnum, NULL);
+#else
   USBD_LL_DataInStage((USBD_HandleTypeDef*)hpcd->pData, epnum, hpcd->IN_ep[epnum].xfer_buff);
+#endif /* USBD_DEFERRED_EVENTS */
 }
 
 /**
@@ -198,7 +386,11 @@ static void PCD_SOFCallback(PCD_HandleTypeDef *hpcd)
 void HAL_PCD_SOFCallback(PCD_HandleTypeDef *hpcd)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
+#if (USBD_DEFERRED_EVENTS == 1U)
+  USBD_Event_PostSof();
+#else
   USBD_LL_SOF((USBD_HandleTypeDef*)hpcd->pData);
+#endif /* USBD_DEFERRED_EVENTS */
 }
 
 /**
@@ -226,11 +418,15 @@ void HAL_PCD_ResetCallback(PCD_HandleTypeDef *hpcd)
   {
     Error_Handler();
   }
+#if (USBD_DEFERRED_EVENTS == 1U)
+  USBD_Event_Post(USBD_EVENT_RESET, (uint8_t)speed, NULL);
+#else
     /* Set Speed. */
   USBD_LL_SetSpeed((USBD_HandleTypeDef*)hpcd->pData, speed);
 
   /* Reset Device. */
   USBD_LL_Reset((USBD_HandleTypeDef*)hpcd->pData);
+#endif /* USBD_DEFERRED_EVENTS */
 }
 
 /**
@@ -246,8 +442,13 @@ void HAL_PCD_SuspendCallback(PCD_HandleTypeDef *hpcd)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
   /* Inform USB library that core enters in suspend Mode. */
+#if (USBD_DEFERRED_EVENTS == 1U)
+  /* PHY clock is gated by the USB task once the stack has handled the suspend */
+  USBD_Event_Post(USBD_EVENT_SUSPEND, 0U, NULL);
+#else
   USBD_LL_Suspend((USBD_HandleTypeDef*)hpcd->pData);
   __HAL_PCD_GATE_PHYCLOCK(hpcd);
+#endif /* USBD_DEFERRED_EVENTS */
   /* Enter in STOP mode. */
   /* USER CODE BEGIN 2 */
   if (hpcd->Init.low_power_enable)
@@ -273,7 +474,11 @@ void HAL_PCD_ResumeCallback(PCD_HandleTypeDef *hpcd)
   /* USER CODE BEGIN 3 */
 
   /* USER CODE END 3 */
+#if (USBD_DEFERRED_EVENTS == 1U)
+  USBD_Event_Post(USBD_EVENT_RESUME, 0U, NULL);
+#else
   USBD_LL_Resume((USBD_HandleTypeDef*)hpcd->pData);
+#endif /* USBD_DEFERRED_EVENTS */
 }
 
 /**
@@ -288,7 +493,11 @@ static void PCD_ISOOUTIncompleteCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
 void HAL_PCD_ISOOUTIncompleteCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
+#if (USBD_DEFERRED_EVENTS == 1U)
+  USBD_Event_Post(USBD_EVENT_ISO_OUT_INCPLT, epnum, NULL);
+#else
   USBD_LL_IsoOUTIncomplete((USBD_HandleTypeDef*)hpcd->pData, epnum);
+#endif /* USBD_DEFERRED_EVENTS */
 }
 
 /**
@@ -303,7 +512,11 @@ static void PCD_ISOINIncompleteCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
 void HAL_PCD_ISOINIncompleteCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
+#if (USBD_DEFERRED_EVENTS == 1U)
+  USBD_Event_Post(USBD_EVENT_ISO_IN_INCPLT, epnum, NULL);
+#else
   USBD_LL_IsoINIncomplete((USBD_HandleTypeDef*)hpcd->pData, epnum);
+#endif /* USBD_DEFERRED_EVENTS */
 }
 
 /**
@@ -317,7 +530,11 @@ static void PCD_ConnectCallback(PCD_HandleTypeDef *hpcd)
 void HAL_PCD_ConnectCallback(PCD_HandleTypeDef *hpcd)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
+#if (USBD_DEFERRED_EVENTS == 1U)
+  USBD_Event_Post(USBD_EVENT_CONNECT, 0U, NULL);
+#else
   USBD_LL_DevConnected((USBD_HandleTypeDef*)hpcd->pData);
+#endif /* USBD_DEFERRED_EVENTS */
 }
 
 /**
@@ -331,7 +548,11 @@ static void PCD_DisconnectCallback(PCD_HandleTypeDef *hpcd)
 void HAL_PCD_DisconnectCallback(PCD_HandleTypeDef *hpcd)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
+#if (USBD_DEFERRED_EVENTS == 1U)
+  USBD_Event_Post(USBD_EVENT_DISCONNECT, 0U, NULL);
+#else
   USBD_LL_DevDisconnected((USBD_HandleTypeDef*)hpcd->pData);
+#endif /* USBD_DEFERRED_EVENTS */
 }
 
 /*******************************************************************************
@@ -352,11 +573,11 @@ USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
   pdev->pData = &hpcd_USB_OTG_FS;
 
   hpcd_USB_OTG_FS.Instance = USB_OTG_FS;
-  hpcd_USB_OTG_FS.Init.dev_endpoints = 4;
+  hpcd_USB_OTG_FS.Init.dev_endpoints = 9;
   hpcd_USB_OTG_FS.Init.speed = PCD_SPEED_FULL;
   hpcd_USB_OTG_FS.Init.dma_enable = DISABLE;
   hpcd_USB_OTG_FS.Init.phy_itface = PCD_PHY_EMBEDDED;
-  hpcd_USB_OTG_FS.Init.Sof_enable = DISABLE;
+  hpcd_USB_OTG_FS.Init.Sof_enable = USBD_LL_SOF_ENABLE;
   hpcd_USB_OTG_FS.Init.low_power_enable = DISABLE;
   hpcd_USB_OTG_FS.Init.lpm_enable = DISABLE;
   hpcd_USB_OTG_FS.Init.battery_charging_enable = DISABLE;
@@ -383,15 +604,91 @@ USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
   HAL_PCD_RegisterIsoInIncpltCallback(&hpcd_USB_OTG_FS, PCD_ISOINIncompleteCallback);
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
   /* USER CODE BEGIN TxRx_Configuration */
-  HAL_PCDEx_SetRxFiFo(&hpcd_USB_OTG_FS, 0x200);
-  HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_FS, 0, 0x40);
-  HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_FS, 1, 0x40);
-  HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_FS, 3, 0x40);
+  USBD_LL_FifoInit(&hpcd_USB_OTG_FS, USBD_LL_FIFO_WORDS);
   /* USER CODE END TxRx_Configuration */
   }
+#if (USBD_USE_OTG_HS == 1U)
+  if (pdev->id == DEVICE_HS) {
+  /* Link the driver to the stack. */
+  hpcd_USB_OTG_HS.pData = pdev;
+  pdev->pData = &hpcd_USB_OTG_HS;
+
+  hpcd_USB_OTG_HS.Instance = USB_OTG_HS;
+  hpcd_USB_OTG_HS.Init.dev_endpoints = 9;
+#if (USBD_HS_ULPI_PHY == 1U)
+  hpcd_USB_OTG_HS.Init.speed = PCD_SPEED_HIGH;
+  hpcd_USB_OTG_HS.Init.phy_itface = PCD_PHY_ULPI;
+#else
+  hpcd_USB_OTG_HS.Init.speed = PCD_SPEED_FULL;
+  hpcd_USB_OTG_HS.Init.phy_itface = PCD_PHY_EMBEDDED;
+#endif /* USBD_HS_ULPI_PHY */
+  /* 内部DMA直接读写端点缓冲，USBD_LL_Transmit/USBD_LL_PrepareReceive检查其地址 */
+  hpcd_USB_OTG_HS.Init.dma_enable = ENABLE;
+  hpcd_USB_OTG_HS.Init.Sof_enable = USBD_LL_SOF_ENABLE;
+  hpcd_USB_OTG_HS.Init.low_power_enable = DISABLE;
+  hpcd_USB_OTG_HS.Init.lpm_enable = DISABLE;
+  hpcd_USB_OTG_HS.Init.battery_charging_enable = DISABLE;
+  hpcd_USB_OTG_HS.Init.vbus_sensing_enable = DISABLE;
+  hpcd_USB_OTG_HS.Init.use_dedicated_ep1 = DISABLE;
+  hpcd_USB_OTG_HS.Init.use_external_vbus = DISABLE;
+  if (HAL_PCD_Init(&hpcd_USB_OTG_HS) != HAL_OK)
+  {
+    Error_Handler( );
+  }
+
+#if (USE_HAL_PCD_REGISTER_CALLBACKS == 1U)
+  /* Register USB PCD CallBacks */
+  HAL_PCD_RegisterCallback(&hpcd_USB_OTG_HS, HAL_PCD_SOF_CB_ID, PCD_SOFCallback);
+  HAL_PCD_RegisterCallback(&hpcd_USB_OTG_HS, HAL_PCD_SETUPSTAGE_CB_ID, PCD_SetupStageCallback);
+  HAL_PCD_RegisterCallback(&hpcd_USB_OTG_HS, HAL_PCD_RESET_CB_ID, PCD_ResetCallback);
+  HAL_PCD_RegisterCallback(&hpcd_USB_OTG_HS, HAL_PCD_SUSPEND_CB_ID, PCD_SuspendCallback);
+  HAL_PCD_RegisterCallback(&hpcd_USB_OTG_HS, HAL_PCD_RESUME_CB_ID, PCD_ResumeCallback);
+  HAL_PCD_RegisterCallback(&hpcd_USB_OTG_HS, HAL_PCD_CONNECT_CB_ID, PCD_ConnectCallback);
+  HAL_PCD_RegisterCallback(&hpcd_USB_OTG_HS, HAL_PCD_DISCONNECT_CB_ID, PCD_DisconnectCallback);
+
+  HAL_PCD_RegisterDataOutStageCallback(&hpcd_USB_OTG_HS, PCD_DataOutStageCallback);
+  HAL_PCD_RegisterDataInStageCallback(&hpcd_USB_OTG_HS, PCD_DataInStageCallback);
+  HAL_PCD_RegisterIsoOutIncpltCallback(&hpcd_USB_OTG_HS, PCD_ISOOUTIncompleteCallback);
+  HAL_PCD_RegisterIsoInIncpltCallback(&hpcd_USB_OTG_HS, PCD_ISOINIncompleteCallback);
+#endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
+  /* USER CODE BEGIN TxRx_HS_Configuration */
+  USBD_LL_FifoInit(&hpcd_USB_OTG_HS, USBD_LL_FIFO_WORDS - USBD_LL_FIFO_DMA_RESERVE);
+  /* USER CODE END TxRx_HS_Configuration */
+  }
+#endif /* USBD_USE_OTG_HS */
   return USBD_OK;
 }
 
+/**
+  * @brief  Sizes the RX and TX FIFOs from the configuration descriptor.
+  * @param  hpcd: PCD handle
+  * @param  budget: FIFO RAM available, in words
+  * @retval None
+  */
+static void USBD_LL_FifoInit(PCD_HandleTypeDef *hpcd, uint16_t budget)
+{
+  USBD_FIFO_PlanTypeDef plan;
+  const USBD_FIFO_HintTypeDef *hint;
+  uint16_t len;
+  uint8_t *desc;
+  uint8_t i;
+
+  /* 按可能运行的最高速度规划，只运行在全速时得到的是全速描述符；描述符随运行模式变化 */
+  desc = USBD_COMPOSITE.GetHSConfigDescriptor(&len);
+  hint = (USBD_COMPOSITE_GetMode() == COM_MODE_MSC_ONLY) ? USBD_LL_MscOnlyFifoHint : USBD_LL_FifoHint;
+  if (USBD_FIFO_Plan(desc, len, hint, budget, &plan) != USBD_FIFO_OK)
+  {
+    Error_Handler();
+  }
+
+  /* 发送FIFO的起始地址按编号顺序累加，必须从0开始依次设置 */
+  HAL_PCDEx_SetRxFiFo(hpcd, plan.Rx);
+  for (i = 0U; i < plan.TxNum; i++)
+  {
+    HAL_PCDEx_SetTxFiFo(hpcd, i, plan.Tx[i]);
+  }
+}
+
 /**
   * @brief  De-Initializes the low level portion of the device driver.
   * @param  pdev: Device handle
@@ -456,7 +753,9 @@ USBD_StatusTypeDef USBD_LL_OpenEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uin
   HAL_StatusTypeDef hal_status = HAL_OK;
   USBD_StatusTypeDef usb_status = USBD_OK;
 
+  USBD_LL_LOCK();
   hal_status = HAL_PCD_EP_Open(pdev->pData, ep_addr, ep_mps, ep_type);
+  USBD_LL_UNLOCK();
 
   usb_status =  USBD_Get_USB_Status(hal_status);
 
@@ -474,7 +773,9 @@ USBD_StatusTypeDef USBD_LL_CloseEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
   HAL_StatusTypeDef hal_status = HAL_OK;
   USBD_StatusTypeDef usb_status = USBD_OK;
 
+  USBD_LL_LOCK();
   hal_status = HAL_PCD_EP_Close(pdev->pData, ep_addr);
+  USBD_LL_UNLOCK();
 
   usb_status =  USBD_Get_USB_Status(hal_status);
 
@@ -492,7 +793,9 @@ USBD_StatusTypeDef USBD_LL_FlushEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
   HAL_StatusTypeDef hal_status = HAL_OK;
   USBD_StatusTypeDef usb_status = USBD_OK;
 
+  USBD_LL_LOCK();
   hal_status = HAL_PCD_EP_Flush(pdev->pData, ep_addr);
+  USBD_LL_UNLOCK();
 
   usb_status =  USBD_Get_USB_Status(hal_status);
 
@@ -510,7 +813,9 @@ USBD_StatusTypeDef USBD_LL_StallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
   HAL_StatusTypeDef hal_status = HAL_OK;
   USBD_StatusTypeDef usb_status = USBD_OK;
 
+  USBD_LL_LOCK();
   hal_status = HAL_PCD_EP_SetStall(pdev->pData, ep_addr);
+  USBD_LL_UNLOCK();
 
   usb_status =  USBD_Get_USB_Status(hal_status);
 
@@ -528,7 +833,9 @@ USBD_StatusTypeDef USBD_LL_ClearStallEP(USBD_HandleTypeDef *pdev, uint8_t ep_add
   HAL_StatusTypeDef hal_status = HAL_OK;
   USBD_StatusTypeDef usb_status = USBD_OK;
 
+  USBD_LL_LOCK();
   hal_status = HAL_PCD_EP_ClrStall(pdev->pData, ep_addr);
+  USBD_LL_UNLOCK();
 
   usb_status =  USBD_Get_USB_Status(hal_status);
 
@@ -566,7 +873,9 @@ USBD_StatusTypeDef USBD_LL_SetUSBAddress(USBD_HandleTypeDef *pdev, uint8_t dev_a
   HAL_StatusTypeDef hal_status = HAL_OK;
   USBD_StatusTypeDef usb_status = USBD_OK;
 
+  USBD_LL_LOCK();
   hal_status = HAL_PCD_SetAddress(pdev->pData, dev_addr);
+  USBD_LL_UNLOCK();
 
   usb_status =  USBD_Get_USB_Status(hal_status);
 
@@ -586,7 +895,17 @@ USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev, uint8_t ep_addr, u
   HAL_StatusTypeDef hal_status = HAL_OK;
   USBD_StatusTypeDef usb_status = USBD_OK;
 
+#if (USBD_DMA_ENABLED == 1U)
+  /* DMA地址寄存器只接受字对齐的地址，未对齐时DMA会从错误的位置取数 */
+  if (!USBD_DMA_BUFFER_OK(pbuf, size))
+  {
+    return USBD_FAIL;
+  }
+#endif /* USBD_DMA_ENABLED */
+
+  USBD_LL_LOCK();
   hal_status = HAL_PCD_EP_Transmit(pdev->pData, ep_addr, pbuf, size);
+  USBD_LL_UNLOCK();
 
   usb_status =  USBD_Get_USB_Status(hal_status);
 
@@ -606,7 +925,16 @@ USBD_StatusTypeDef USBD_LL_PrepareReceive(USBD_HandleTypeDef *pdev, uint8_t ep_a
   HAL_StatusTypeDef hal_status = HAL_OK;
   USBD_StatusTypeDef usb_status = USBD_OK;
 
+#if (USBD_DMA_ENABLED == 1U)
+  if (!USBD_DMA_BUFFER_OK(pbuf, size))
+  {
+    return USBD_FAIL;
+  }
+#endif /* USBD_DMA_ENABLED */
+
+  USBD_LL_LOCK();
   hal_status = HAL_PCD_EP_Receive(pdev->pData, ep_addr, pbuf, size);
+  USBD_LL_UNLOCK();
 
   usb_status =  USBD_Get_USB_Status(hal_status);
 
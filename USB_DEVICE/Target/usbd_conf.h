@@ -63,7 +63,7 @@
   */
 
 /*---------- -----------*/
-#define USBD_MAX_NUM_INTERFACES     3U
+#define USBD_MAX_NUM_INTERFACES     7U
 /*---------- -----------*/
 #define USBD_MAX_NUM_CONFIGURATION     1U
 /*---------- -----------*/
@@ -73,6 +73,8 @@
 /*---------- -----------*/
 #define USBD_LPM_ENABLED     0U
 /*---------- -----------*/
+#define USBD_CLASS_BOS_ENABLED     0U
+/*---------- -----------*/
 #define USBD_SELF_POWERED     1U
 /*---------- -----------*/
 #define MSC_MEDIA_PACKET     32768U
@@ -82,6 +84,26 @@
 #define DEVICE_FS 		0
 #define DEVICE_HS 		1
 
+/*---------- 端口选择：0为OTG_FS(PA11/PA12)，1为带内部DMA的OTG_HS -----------*/
+#define USBD_USE_OTG_HS     0U
+/*---------- OTG_HS的PHY：1为外部ULPI PHY(480Mbit/s)，0为内置全速PHY(PB14/PB15) -----------*/
+#define USBD_HS_ULPI_PHY     1U
+
+/*---------- 1为PCD回调只投递事件，协议栈与功能回调在USB任务中运行 -----------*/
+#define USBD_DEFERRED_EVENTS     0U
+
+#if (USBD_USE_OTG_HS == 1U)
+#define USBD_PORT_ID        DEVICE_HS
+#define USBD_DMA_ENABLED    1U
+#else
+#define USBD_PORT_ID        DEVICE_FS
+#define USBD_DMA_ENABLED    0U
+#endif /* USBD_USE_OTG_HS */
+
+/* 可直接交给OTG_HS内部DMA的缓冲：字对齐且DMA能访问。ZLP不访问缓冲，类驱动传入NULL */
+#define USBD_DMA_BUFFER_OK(p, size)  (((size) == 0U) || \
+                                      ((((uint32_t)(uintptr_t)(p) & 0x3U) == 0U) && DMA_BUFFER_OK(p)))
+
 /**
   * @}
   */
@@ -0,0 +1,330 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_event.c
+  * @version        : V1.0
+  * @brief          : USB事件延后处理
+  *                   - PCD回调只把事件写入无锁队列，中断执行时间短且固定
+  *                   - 高优先级任务取出事件，调用协议栈与各功能的回调
+  *                   - 任务与其他上下文调用LL接口时屏蔽USB中断，保护PCD状态
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                使用说明
+  *          ===================================================================
+  *           1. usbd_conf.h中打开USBD_DEFERRED_EVENTS，USB中断优先级随之降为
+  *              configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY，以便通知任务。
+  *           2. 队列只有USB中断一个写者、USB任务一个读者，不需要关中断。
+  *              SETUP包在中断中复制，其余事件只记录端点号，数据长度与缓冲
+  *              在任务中从PCD句柄读取，端点重新使能前不会变化。
+  *           3. SOF在中断中只累加计数，下一个事件投递时先作为一项补入队列，
+  *              队列为空时任务直接取走计数，SOF与其他事件的先后顺序不变。
+  *           4. 端点只在任务中重新使能，每个端点每个方向最多一个完成事件
+  *              等待处理，加上SETUP与总线事件，每项前最多再有一项SOF，
+  *              64项足够。连续重复的总线事件与ISO未完成事件合并。队列满
+  *              说明任务长时间没有运行，事件已无法补回，按错误处理。
+  *           5. 原先在中断中运行的功能代码(SD卡读写、CDC复制)改在任务中
+  *              运行，任务优先级高于所有应用任务，与应用任务的互斥关系不变。
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_event.h"
+#include "usbd_core.h"
+#include "cmsis_os.h"
+#include "string.h"
+
+#if (USBD_DEFERRED_EVENTS == 1U)
+
+/* Define --------------------------------------------------------------------*/
+#define USBD_EVENT_QUEUE_MASK		(USBD_EVENT_QUEUE_SIZE - 1U)
+#define USBD_EVENT_FLAG				0x01U
+
+#if (USBD_USE_OTG_HS == 1U)
+#define USBD_EVENT_IRQn				OTG_HS_IRQn
+#else
+#define USBD_EVENT_IRQn				OTG_FS_IRQn
+#endif /* USBD_USE_OTG_HS */
+
+/* Typedef -------------------------------------------------------------------*/
+typedef struct
+{
+	uint8_t Type;
+	uint8_t Param;			/**< 端点号或速度 */
+	uint8_t Setup[8];		/**< SETUP包 */
+	uint32_t Count;			/**< SOF数 */
+}USBD_EventTypeDef;
+
+/* Variables -----------------------------------------------------------------*/
+static USBD_HandleTypeDef *USBD_Event_Dev;
+static USBD_EventTypeDef USBD_Event_Queue[USBD_EVENT_QUEUE_SIZE];
+static __IO uint32_t USBD_Event_Head = 0U;		/**< 写位置，仅由USB中断修改 */
+static __IO uint32_t USBD_Event_Tail = 0U;		/**< 读位置，仅由USB任务修改 */
+static __IO uint32_t USBD_Event_Sof = 0U;		/**< 未处理的SOF数 */
+static uint32_t USBD_Event_LockDepth = 0U;
+static USBD_EventStatsTypeDef USBD_Event_Stats;
+
+static osThreadId_t USBD_Event_TaskHandle;
+static const osThreadAttr_t USBD_Event_Task_attributes = {
+	.name = "USB_Task",
+	.stack_size = 512 * 4,
+	.priority = (osPriority_t) osPriorityRealtime,
+};
+
+static void USBD_Event_Task(void *argument);
+
+/* ---------------------------------------- Event Funtion ---------------------------------------- */
+
+/**
+  * @brief  USBD_Event_Init 创建USB任务
+  * @note   在USBD_Start之前调用，此后PCD回调产生的事件都由该任务处理。
+  * @param  pdev: 设备实例
+  */
+void USBD_Event_Init(USBD_HandleTypeDef *pdev)
+{
+	USBD_Event_Dev = pdev;
+	USBD_Event_Head = 0U;
+	USBD_Event_Tail = 0U;
+	USBD_Event_Sof = 0U;
+	(void)memset(&USBD_Event_Stats, 0, sizeof(USBD_EventStatsTypeDef));
+
+	USBD_Event_TaskHandle = osThreadNew(USBD_Event_Task, NULL, &USBD_Event_Task_attributes);
+	if(USBD_Event_TaskHandle == NULL)
+		Error_Handler();
+}
+
+/**
+  * @brief  USBD_Event_Put 写入一项，在USB中断中调用
+  * @param  type: 事件类型
+  * @param  param: 端点号或速度
+  * @param  setup: SETUP包，其他事件为NULL
+  * @param  count: SOF数
+  */
+static void USBD_Event_Put(uint8_t type, uint8_t param, const uint8_t *setup, uint32_t count)
+{
+	uint32_t head = USBD_Event_Head;
+	uint32_t depth = head - USBD_Event_Tail;
+	USBD_EventTypeDef *ev;
+
+	if(depth >= USBD_EVENT_QUEUE_SIZE)
+		Error_Handler();
+
+	ev = &USBD_Event_Queue[head & USBD_EVENT_QUEUE_MASK];
+	ev->Type = type;
+	ev->Param = param;
+	ev->Count = count;
+	if(setup != NULL)
+		memcpy(ev->Setup, setup, sizeof(ev->Setup));
+	/* 事件内容写完后才移动写位置 */
+	__DMB();
+	USBD_Event_Head = head + 1U;
+
+	if(depth + 1U > USBD_Event_Stats.MaxDepth)
+		USBD_Event_Stats.MaxDepth = depth + 1U;
+}
+
+/**
+  * @brief  USBD_Event_Post 投递一个事件，在USB中断中调用
+  * @param  type: 事件类型
+  * @param  param: 端点号或速度
+  * @param  setup: SETUP包，其他事件为NULL
+  */
+void USBD_Event_Post(uint8_t type, uint8_t param, const uint8_t *setup)
+{
+	uint32_t head = USBD_Event_Head;
+	USBD_EventTypeDef *last;
+
+	if(USBD_Event_Sof != 0U)
+	{
+		/* 此前累计的SOF排在本事件之前 */
+		USBD_Event_Put(USBD_EVENT_SOF, 0U, NULL, USBD_Event_Sof);
+		USBD_Event_Sof = 0U;
+	}
+	else if((type != USBD_EVENT_SETUP) && (type != USBD_EVENT_DATA_OUT) && (type != USBD_EVENT_DATA_IN) &&
+	        (head - USBD_Event_Tail >= 2U))
+	{
+		/* 任务可能正在复制读位置上的一项，只与其后的项合并 */
+		last = &USBD_Event_Queue[(head - 1U) & USBD_EVENT_QUEUE_MASK];
+		if((last->Type == type) && (last->Param == param))
+		{
+			USBD_Event_Stats.Merged++;
+			return;
+		}
+	}
+
+	USBD_Event_Put(type, param, setup, 0U);
+	USBD_Event_Stats.Posted++;
+	(void)osThreadFlagsSet(USBD_Event_TaskHandle, USBD_EVENT_FLAG);
+}
+
+/**
+  * @brief  USBD_Event_PostSof 记录一次SOF，在USB中断中调用
+  */
+void USBD_Event_PostSof(void)
+{
+	if(USBD_Event_Sof++ == 0U)
+		(void)osThreadFlagsSet(USBD_Event_TaskHandle, USBD_EVENT_FLAG);
+}
+
+/**
+  * @brief  USBD_Event_Lock 屏蔽USB中断，可嵌套
+  * @note   LL接口修改PCD句柄与端点寄存器，不能与PCD中断交叠。
+  */
+void USBD_Event_Lock(void)
+{
+	uint32_t primask;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if(USBD_Event_LockDepth++ == 0U)
+		HAL_NVIC_DisableIRQ(USBD_EVENT_IRQn);
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief  USBD_Event_Unlock 恢复USB中断
+  */
+void USBD_Event_Unlock(void)
+{
+	uint32_t primask;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if(--USBD_Event_LockDepth == 0U)
+		HAL_NVIC_EnableIRQ(USBD_EVENT_IRQn);
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief  USBD_Event_GetStats 读取事件统计
+  * @param  stats: 统计的副本
+  */
+void USBD_Event_GetStats(USBD_EventStatsTypeDef *stats)
+{
+	USBD_Event_Lock();
+	*stats = USBD_Event_Stats;
+	USBD_Event_Unlock();
+}
+
+/**
+  * @brief  USBD_Event_DispatchSof 把累计的SOF交给协议栈
+  * @param  pdev: 设备实例
+  * @param  count: SOF数
+  */
+static void USBD_Event_DispatchSof(USBD_HandleTypeDef *pdev, uint32_t count)
+{
+	USBD_Event_Stats.Sof += count;
+	while(count-- != 0U)
+		(void)USBD_LL_SOF(pdev);
+}
+
+/**
+  * @brief  USBD_Event_Dispatch 把一个事件交给协议栈
+  * @param  pdev: 设备实例
+  * @param  ev: 事件
+  */
+static void USBD_Event_Dispatch(USBD_HandleTypeDef *pdev, USBD_EventTypeDef *ev)
+{
+	PCD_HandleTypeDef *hpcd = (PCD_HandleTypeDef *)pdev->pData;
+
+	switch(ev->Type)
+	{
+		case USBD_EVENT_SETUP:
+			(void)USBD_LL_SetupStage(pdev, ev->Setup);
+			break;
+		case USBD_EVENT_DATA_OUT:
+			(void)USBD_LL_DataOutStage(pdev, ev->Param, hpcd->OUT_ep[ev->Param].xfer_buff);
+			break;
+		case USBD_EVENT_DATA_IN:
+			(void)USBD_LL_DataInStage(pdev, ev->Param, hpcd->IN_ep[ev->Param].xfer_buff);
+			break;
+		case USBD_EVENT_RESET:
+			(void)USBD_LL_SetSpeed(pdev, (USBD_SpeedTypeDef)ev->Param);
+			(void)USBD_LL_Reset(pdev);
+			break;
+		case USBD_EVENT_SUSPEND:
+			(void)USBD_LL_Suspend(pdev);
+			/* 协议栈处理完挂起后再停PHY时钟，其后已有事件排队(如唤醒)时不停 */
+			USBD_Event_Lock();
+			if(USBD_Event_Tail == USBD_Event_Head)
+				__HAL_PCD_GATE_PHYCLOCK(hpcd);
+			USBD_Event_Unlock();
+			break;
+		case USBD_EVENT_RESUME:
+			(void)USBD_LL_Resume(pdev);
+			break;
+		case USBD_EVENT_ISO_OUT_INCPLT:
+			(void)USBD_LL_IsoOUTIncomplete(pdev, ev->Param);
+			break;
+		case USBD_EVENT_ISO_IN_INCPLT:
+			(void)USBD_LL_IsoINIncomplete(pdev, ev->Param);
+			break;
+		case USBD_EVENT_CONNECT:
+			(void)USBD_LL_DevConnected(pdev);
+			break;
+		case USBD_EVENT_DISCONNECT:
+			(void)USBD_LL_DevDisconnected(pdev);
+			break;
+		case USBD_EVENT_SOF:
+			USBD_Event_DispatchSof(pdev, ev->Count);
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+  * @brief  USBD_Event_Task USB任务，按投递顺序处理队列中的事件与SOF
+  * @param  argument: 未使用
+  */
+static void USBD_Event_Task(void *argument)
+{
+	USBD_EventTypeDef ev;
+	uint32_t tail, sof;
+
+	UNUSED(argument);
+
+	for(;;)
+	{
+		(void)osThreadFlagsWait(USBD_EVENT_FLAG, osFlagsWaitAny, osWaitForever);
+
+		tail = USBD_Event_Tail;
+		for(;;)
+		{
+			while(tail != USBD_Event_Head)
+			{
+				/* 复制出事件后立即释放队列位置 */
+				__DMB();
+				ev = USBD_Event_Queue[tail & USBD_EVENT_QUEUE_MASK];
+				USBD_Event_Tail = ++tail;
+				USBD_Event_Dispatch(USBD_Event_Dev, &ev);
+			}
+
+			/* 队列为空时才取走SOF计数，之后投递的事件都在这些SOF之后 */
+			USBD_Event_Lock();
+			if(tail == USBD_Event_Head)
+				break;
+			USBD_Event_Unlock();
+		}
+		sof = USBD_Event_Sof;
+		USBD_Event_Sof = 0U;
+		USBD_Event_Unlock();
+
+		USBD_Event_DispatchSof(USBD_Event_Dev, sof);
+	}
+}
+
+#endif /* USBD_DEFERRED_EVENTS */
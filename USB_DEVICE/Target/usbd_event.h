@@ -0,0 +1,67 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_event.h
+  * @version        : V1.0
+  * @brief          : usbd_event.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_EVENT_H__
+#define __USBD_EVENT_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "usbd_def.h"
+
+#if (USBD_DEFERRED_EVENTS == 1U)
+
+#define USBD_EVENT_QUEUE_SIZE		64U			/**< 事件队列深度，必须为2的幂，取值见usbd_event.c说明 */
+
+/* 由PCD回调投递的事件类型 */
+#define USBD_EVENT_SETUP			0x01U		/**< SETUP包，内容随事件保存 */
+#define USBD_EVENT_DATA_OUT			0x02U		/**< 输出端点传输完成，参数为端点号 */
+#define USBD_EVENT_DATA_IN			0x03U		/**< 输入端点传输完成，参数为端点号 */
+#define USBD_EVENT_RESET			0x04U		/**< 总线复位，参数为USBD_SpeedTypeDef */
+#define USBD_EVENT_SUSPEND			0x05U
+#define USBD_EVENT_RESUME			0x06U
+#define USBD_EVENT_ISO_OUT_INCPLT	0x07U		/**< 参数为端点号 */
+#define USBD_EVENT_ISO_IN_INCPLT	0x08U		/**< 参数为端点号 */
+#define USBD_EVENT_CONNECT			0x09U
+#define USBD_EVENT_DISCONNECT		0x0AU
+#define USBD_EVENT_SOF				0x0BU		/**< 累计的SOF，由下一个事件投递时补入队列 */
+
+typedef struct
+{
+	uint32_t Posted;		/**< 投递的事件数，不含SOF */
+	uint32_t Merged;		/**< 与前一个相同而合并的事件数 */
+	uint32_t MaxDepth;		/**< 队列中同时等待的最大事件数 */
+	uint32_t Sof;			/**< 交给协议栈的SOF数 */
+}USBD_EventStatsTypeDef;
+
+void USBD_Event_Init(USBD_HandleTypeDef *pdev);
+void USBD_Event_Post(uint8_t type, uint8_t param, const uint8_t *setup);
+void USBD_Event_PostSof(void);
+void USBD_Event_Lock(void);
+void USBD_Event_Unlock(void);
+void USBD_Event_GetStats(USBD_EventStatsTypeDef *stats);
+
+#endif /* USBD_DEFERRED_EVENTS */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_EVENT_H__ */
@@ -0,0 +1,157 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_fifo.c
+  * @version        : V1.0
+  * @brief          : USB OTG FIFO规划
+  *                   - 根据配置描述符中的端点计算接收FIFO与各发送FIFO的深度
+  *                   - 按端点提示的包数与优先级分配剩余空间
+  *                   - 不访问硬件，可在主机上测试，由USBD_LL_Init应用结果
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *  @verbatim
+  *
+  *          ===================================================================
+  *                                规划步骤
+  *          ===================================================================
+  *           1. 遍历描述符，记录每个输入端点的包长与类型、输出端点个数和最大
+  *              输出包长；高速同步/中断端点的包长乘以每微帧的事务数。
+  *           2. 先满足最低要求：接收FIFO按参考手册的公式容纳一个最大包，
+  *              端点0与每个输入端点各一个包，至少16字；比最高输入端点号小的
+  *              空闲端点也分配16字占位，因为后续FIFO的起始地址按顺序累加。
+  *           3. 剩余空间先让接收FIFO多容纳一个最大包，再按优先级把输入端点
+  *              扩展到提示的包数，放不下时逐包减少。
+  *           4. 最后剩下的空间全部给接收FIFO。
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_fifo.h"
+#include "string.h"
+
+/* Define --------------------------------------------------------------------*/
+#define USBD_FIFO_DESC_ENDPOINT		0x05U
+#define USBD_FIFO_EP_BULK			0x02U
+
+#define USBD_FIFO_WORDS(bytes)		(((uint32_t)(bytes) + 3U) / 4U)
+#define USBD_FIFO_MAX(a, b)			(((a) > (b)) ? (a) : (b))
+
+/* ---------------------------------------- Plan Funtion ---------------------------------------- */
+
+/**
+  * @brief  USBD_FIFO_Plan 由配置描述符规划FIFO
+  * @param  desc: 配置描述符，应取可能运行的最高速度下的描述符
+  * @param  len: 描述符总长度
+  * @param  hint: 按输入端点号索引的提示，共USBD_FIFO_TX_NUM项，可为NULL
+  * @param  budget: 可用的FIFO RAM，单位为字
+  * @param  plan: 规划结果
+  * @retval USBD_FIFO_OK或错误码
+  */
+uint8_t USBD_FIFO_Plan(const uint8_t *desc, uint16_t len, const USBD_FIFO_HintTypeDef *hint, uint16_t budget, USBD_FIFO_PlanTypeDef *plan)
+{
+	uint16_t in_size[USBD_FIFO_TX_NUM] = {0U};
+	uint8_t in_bulk[USBD_FIFO_TX_NUM] = {0U};
+	uint16_t want[USBD_FIFO_TX_NUM] = {0U};
+	uint32_t largest = USBD_FIFO_EP0_SIZE, out_num = 1U;
+	uint32_t rx_want, used, step, extra, packets;
+	uint32_t i = 0U, num, best, done = 0U;
+	uint16_t wmps;
+	uint8_t addr;
+
+	(void)memset(plan, 0, sizeof(USBD_FIFO_PlanTypeDef));
+
+	while(i < len)
+	{
+		if((desc[i] < 2U) || (i + desc[i] > len))
+			return USBD_FIFO_ERR_DESC;
+		if((desc[i + 1U] == USBD_FIFO_DESC_ENDPOINT) && (desc[i] >= 7U))
+		{
+			addr = desc[i + 2U];
+			num = addr & 0x0FU;
+			wmps = (uint16_t)(desc[i + 4U] | (desc[i + 5U] << 8));
+			/* 低11位为包长，bit12:11为高速下每微帧额外的事务数 */
+			step = (wmps & 0x7FFU) * (((wmps >> 11) & 0x3U) + 1U);
+			if((num == 0U) || (num >= USBD_FIFO_TX_NUM))
+				return USBD_FIFO_ERR_DESC;
+			if((addr & 0x80U) != 0U)
+			{
+				in_size[num] = (uint16_t)USBD_FIFO_MAX(in_size[num], step);
+				in_bulk[num] = ((desc[i + 3U] & 0x03U) == USBD_FIFO_EP_BULK) ? 1U : 0U;
+				if(num >= plan->TxNum)
+					plan->TxNum = (uint8_t)(num + 1U);
+			}
+			else
+			{
+				out_num++;
+				largest = USBD_FIFO_MAX(largest, step);
+			}
+		}
+		i += desc[i];
+	}
+
+	/* 接收FIFO：一个控制端点的SETUP包5*1+8字，最大包加1字状态，每个输出端点2字，全局NAK 1字 */
+	plan->Rx = (uint16_t)(13U + USBD_FIFO_WORDS(largest) + 1U + 2U * out_num + 1U);
+	rx_want = plan->Rx + USBD_FIFO_WORDS(largest) + 1U;
+
+	if(plan->TxNum == 0U)
+		plan->TxNum = 1U;
+	plan->Tx[0] = (uint16_t)USBD_FIFO_MAX(USBD_FIFO_MIN_WORDS, USBD_FIFO_WORDS(USBD_FIFO_EP0_SIZE));
+	used = plan->Rx + plan->Tx[0];
+	for(num = 1U; num < plan->TxNum; num++)
+	{
+		step = USBD_FIFO_WORDS(in_size[num]);
+		packets = ((hint != NULL) && (hint[num].Packets != 0U)) ? hint[num].Packets : ((in_bulk[num] != 0U) ? 2U : 1U);
+		plan->Tx[num] = (uint16_t)USBD_FIFO_MAX(USBD_FIFO_MIN_WORDS, step);
+		want[num] = (uint16_t)USBD_FIFO_MAX(USBD_FIFO_MIN_WORDS, step * packets);
+		used += plan->Tx[num];
+	}
+	if(used > budget)
+		return USBD_FIFO_ERR_SPACE;
+
+	/* 接收FIFO由所有输出端点共用，优先让它多容纳一个包 */
+	if(used + (rx_want - plan->Rx) <= budget)
+	{
+		used += rx_want - plan->Rx;
+		plan->Rx = (uint16_t)rx_want;
+	}
+
+	/* 按优先级扩展输入端点，放不下全部时逐包减少 */
+	for(;;)
+	{
+		best = 0U;
+		for(num = 1U; num < plan->TxNum; num++)
+		{
+			if(((done >> num) & 1U) || (want[num] <= plan->Tx[num]))
+				continue;
+			if((best == 0U) || ((hint != NULL) && (hint[num].Priority > hint[best].Priority)))
+				best = num;
+		}
+		if(best == 0U)
+			break;
+		done |= 1UL << best;
+
+		step = USBD_FIFO_WORDS(in_size[best]);
+		extra = want[best] - plan->Tx[best];
+		while((extra != 0U) && (used + extra > budget))
+			extra = (extra > step) ? extra - step : 0U;
+		plan->Tx[best] += (uint16_t)extra;
+		used += extra;
+	}
+
+	/* 剩余空间给接收FIFO */
+	plan->Rx += (uint16_t)(budget - used);
+	plan->Used = budget;
+
+	return USBD_FIFO_OK;
+}
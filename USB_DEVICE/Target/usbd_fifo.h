@@ -0,0 +1,59 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_fifo.h
+  * @version        : V1.0
+  * @brief          : usbd_fifo.c的头文件
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 Sunshine Circuit.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_FIFO_H__
+#define __USBD_FIFO_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define USBD_FIFO_TX_NUM			9U			/**< 发送FIFO个数，与dev_endpoints一致 */
+#define USBD_FIFO_MIN_WORDS			16U			/**< 每个发送FIFO的最小深度 */
+#define USBD_FIFO_EP0_SIZE			64U			/**< 端点0包长 */
+
+/* 规划结果 */
+#define USBD_FIFO_OK				0U
+#define USBD_FIFO_ERR_DESC			1U			/**< 描述符格式错误或端点号超出范围 */
+#define USBD_FIFO_ERR_SPACE			2U			/**< 每个端点一个包也放不下 */
+
+/* 单个输入端点的规划提示，按端点号索引 */
+typedef struct
+{
+	uint8_t Packets;		/**< 希望缓存的包数，0按类型取默认值：批量2个，其余1个 */
+	uint8_t Priority;		/**< 空间不足时数值大的先分配，相同时端点号小的先分配 */
+}USBD_FIFO_HintTypeDef;
+
+typedef struct
+{
+	uint16_t Rx;							/**< 接收FIFO，单位为字 */
+	uint16_t Tx[USBD_FIFO_TX_NUM];			/**< 各发送FIFO，单位为字 */
+	uint8_t  TxNum;							/**< 需要设置的发送FIFO个数，中间空闲的端点也要占位 */
+	uint16_t Used;							/**< 分配的总字数 */
+}USBD_FIFO_PlanTypeDef;
+
+uint8_t USBD_FIFO_Plan(const uint8_t *desc, uint16_t len, const USBD_FIFO_HintTypeDef *hint, uint16_t budget, USBD_FIFO_PlanTypeDef *plan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_FIFO_H__ */
@@ -0,0 +1,28 @@
+/**
+  ******************************************************************************
+  * @file    stm32h7xx.h
+  * @brief   主机测试用的CMSIS替身，只提供被测代码用到的定义
+  ******************************************************************************
+  */
+
+#ifndef __STM32H7XX_H
+#define __STM32H7XX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define __IO							volatile
+#define __I								volatile const
+#define __STATIC_INLINE					static inline
+#define __PACKED						__attribute__((packed))
+#define UNUSED(x)						((void)(x))
+
+/* 主机上单线程运行，关中断与内存屏障都是空操作 */
+static inline uint32_t __get_PRIMASK(void) { return 0U; }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+static inline void __DMB(void) {}
+static inline void __DSB(void) {}
+
+#endif /* __STM32H7XX_H */
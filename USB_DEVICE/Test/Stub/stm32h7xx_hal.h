@@ -0,0 +1,37 @@
+/**
+  ******************************************************************************
+  * @file    stm32h7xx_hal.h
+  * @brief   主机测试用的HAL替身，只提供被测代码用到的定义
+  ******************************************************************************
+  */
+
+#ifndef __STM32H7XX_HAL_H
+#define __STM32H7XX_HAL_H
+
+#include "stm32h7xx.h"
+
+typedef enum
+{
+	HAL_OK = 0x00U,
+	HAL_ERROR = 0x01U,
+	HAL_BUSY = 0x02U,
+	HAL_TIMEOUT = 0x03U
+}HAL_StatusTypeDef;
+
+/* PCD句柄只保留类驱动读取的端点包长 */
+typedef struct
+{
+	uint32_t maxpacket;
+}PCD_EPTypeDef;
+
+typedef struct
+{
+	PCD_EPTypeDef IN_ep[16];
+	PCD_EPTypeDef OUT_ep[16];
+}PCD_HandleTypeDef;
+
+/* 由测试程序实现 */
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+#endif /* __STM32H7XX_HAL_H */
@@ -0,0 +1,140 @@
+/**
+  ******************************************************************************
+  * @file    bench_desc.c
+  * @brief   字符串描述符的主机端基准：重放一次枚举的16个字符串请求，对比每次
+  *          请求时转换(改动前的做法)与初始化时一次生成，均包含复制到EP0缓冲
+  * @note    只反映设备侧的CPU时间，枚举总时间取决于主机与总线。
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static uint32_t TestUid[3] = {0x00380024U, 0x3431510AU, 0x32363830U};
+#define UID_BASE			((uintptr_t)TestUid)
+#include "../App/usbd_desc.c"
+
+#define BENCH_ROUNDS		1000000U
+#define REQUEST_NUM			16U
+
+typedef uint8_t *(*DescFuncTypeDef)(USBD_SpeedTypeDef speed, uint16_t *length);
+
+typedef struct
+{
+	DescFuncTypeDef Func;
+	const char *Str;		/**< 改动前每次请求转换的字符串，NULL为LANGID、序列号或MAC */
+}RequestTypeDef;
+
+/* 与test_desc.c相同的请求顺序 */
+static const RequestTypeDef Requests[REQUEST_NUM] =
+{
+	{USBD_FS_LangIDStrDescriptor,             NULL},
+	{USBD_FS_ProductStrDescriptor,            USBD_PRODUCT_STRING_FS},
+	{USBD_FS_SerialStrDescriptor,             NULL},
+	{USBD_FS_LangIDStrDescriptor,             NULL},
+	{USBD_FS_ProductStrDescriptor,            USBD_PRODUCT_STRING_FS},
+	{USBD_FS_SerialStrDescriptor,             NULL},
+	{USBD_FS_ManufacturerStrDescriptor,       USBD_MANUFACTURER_STRING},
+	{USBD_FS_ConfigStrDescriptor,             USBD_CONFIGURATION_STRING_FS},
+	{USBD_FS_CDCControlInterfaceStrDescriptor, USBD_CDC_CONTROL_INTERFACE_STRING_FS},
+	{USBD_FS_CDCDataInterfaceStrDescriptor,   USBD_CDC_DATA_INTERFACE_STRING_FS},
+	{USBD_FS_MSCDataInterfaceStrDescriptor,   USBD_MSC_DATA_INTERFACE_STRING_FS},
+	{USBD_FS_HIDDataInterfaceStrDescriptor,   USBD_HID_DATA_INTERFACE_STRING_FS},
+	{USBD_FS_CDCIADStrDescriptor,             USBD_CDC_IAD_STRING_FS},
+	{USBD_FS_MSCIADStrDescriptor,             USBD_MSC_IAD_STRING_FS},
+	{USBD_FS_HIDIADStrDescriptor,             UABD_HID_IAD_STRING_FS},
+	{USBD_FS_NCMMacStrDescriptor,             NULL},
+};
+
+static uint8_t SharedDesc[USBD_MAX_STR_DESC_SIZ];	/**< 改动前共用的USBD_StrDesc */
+static uint8_t Ep0Buf[USBD_MAX_STR_DESC_SIZ];
+static volatile uint32_t Sink;
+
+/* 阻止编译器把循环不变的调用提到循环外 */
+#define BENCH_BARRIER()		__asm__ volatile("" : : "r"(Ep0Buf), "r"(SharedDesc) : "memory")
+
+/* 与usbd_ctlreq.c中的实现相同 */
+void USBD_GetString(uint8_t *desc, uint8_t *unicode, uint16_t *len)
+{
+	uint8_t idx = 0U;
+
+	if(desc == NULL)
+		return;
+	*len = (uint16_t)(strlen((const char *)desc) * 2U + 2U);
+	unicode[idx++] = (uint8_t)*len;
+	unicode[idx++] = USB_DESC_TYPE_STRING;
+	while(*desc != '\0')
+	{
+		unicode[idx++] = *desc++;
+		unicode[idx++] = 0U;
+	}
+}
+
+uint8_t USBD_COMPOSITE_GetMode(void)
+{
+	return COM_MODE_COMPOSITE;
+}
+
+/* 改动前的回调：字符串每次转换到共用缓冲，序列号与MAC每次由唯一ID重新生成 */
+static uint8_t *OldRequest(const RequestTypeDef *req, uint16_t *len)
+{
+	if(req->Str != NULL)
+	{
+		USBD_GetString((uint8_t *)req->Str, SharedDesc, len);
+		return SharedDesc;
+	}
+	if(req->Func == USBD_FS_SerialStrDescriptor)
+		Get_SerialNum();
+	else if(req->Func == USBD_FS_NCMMacStrDescriptor)
+		Get_NCMMac();
+	return req->Func(USBD_SPEED_FULL, len);
+}
+
+static double Now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+}
+
+int main(void)
+{
+	uint32_t i, n;
+	uint16_t len;
+	uint8_t *desc;
+	double t0, t1, t2;
+
+	USBD_FS_DescInit();
+
+	t0 = Now();
+	for(i = 0U; i < BENCH_ROUNDS; i++)
+	{
+		for(n = 0U; n < REQUEST_NUM; n++)
+		{
+			desc = OldRequest(&Requests[n], &len);
+			memcpy(Ep0Buf, desc, len);
+			Sink += len;
+		}
+		BENCH_BARRIER();
+	}
+	t1 = Now();
+	for(i = 0U; i < BENCH_ROUNDS; i++)
+	{
+		for(n = 0U; n < REQUEST_NUM; n++)
+		{
+			desc = Requests[n].Func(USBD_SPEED_FULL, &len);
+			memcpy(Ep0Buf, desc, len);
+			Sink += len;
+		}
+		BENCH_BARRIER();
+	}
+	t2 = Now();
+
+	printf("bench_desc: %u requests per enumeration, convert %6.1f ns, prebuilt %6.1f ns (%.1fx)\n", REQUEST_NUM,
+	       (t1 - t0) / BENCH_ROUNDS, (t2 - t1) / BENCH_ROUNDS, (t1 - t0) / (t2 - t1));
+
+	return 0;
+}
@@ -0,0 +1,382 @@
+/**
+  ******************************************************************************
+  * @file    test_bridge.c
+  * @brief   usbd_cdc_bridge.c的主机端测试，串口与CDC端点由桩函数代替
+  *           - 输入传输在途时DMA继续写入并绕回，主机收到的数据不被改动
+  *           - 主机来不及读取时丢弃最旧的数据并计数
+  *           - 线路编码在任务中、串口发送空闲后执行，串口不会收到重复数据
+  *           - 发送队列满时暂停输出端点，串口发送腾出空间后恢复
+  *           - 模式切换期间不启动输入传输，数据保留到协议栈恢复后发送
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "usbd_composite.h"
+#include "test.h"
+
+/* 桥接需要第二个CDC实例，默认配置下模块不参与编译，这里直接包含源文件 */
+#undef COM_CDC_INSTANCE_NUM
+#define COM_CDC_INSTANCE_NUM		2U
+#include "usbd_cdc_bridge.h"
+#undef CDC_BRIDGE_ENABLED
+#define CDC_BRIDGE_ENABLED			1U
+#include "../App/usbd_cdc_bridge.c"
+
+#define STREAM_SIZE			0x10000U
+
+__IO uint8_t USB_Device_Online = 1U;
+
+static USBD_HandleTypeDef Dev;
+static USBD_CDC_ItfTypeDef *Fops;
+
+/* 串口桩：接收DMA循环写入，发送由测试显式完成 */
+static uint8_t *RxBuf;
+static uint32_t RxSize;
+static uint32_t RxPos;
+static uint32_t RxStarts;
+static const uint8_t *TxBuf;
+static uint32_t TxLen;
+static uint32_t TxStarts;
+static uint32_t Configs;
+static uint32_t ConfigDuringTx;
+static uint32_t Baud;
+
+/* USB桩：输入传输完成时才读取缓冲，模拟控制器在传输期间访问内存 */
+static uint8_t *InBuf;
+static uint32_t InLen;
+static uint32_t InSubmits;
+static uint32_t OutArms;
+
+/* 两个方向的数据流 */
+static uint8_t UartStream[STREAM_SIZE];
+static uint32_t UartFed;
+static uint8_t HostIn[STREAM_SIZE];
+static uint32_t HostInLen;
+static uint8_t HostOut[STREAM_SIZE];
+static uint32_t HostOutLen;
+static uint8_t UartOut[STREAM_SIZE];
+static uint32_t UartOutLen;
+
+static uint8_t StubConfig(const USBD_CDC_LineCodingTypeDef *coding)
+{
+	Configs++;
+	if(TxLen != 0U)
+		ConfigDuringTx++;
+	if(coding->bitrate == 0U)
+		return 1U;
+	Baud = coding->bitrate;
+	/* 与HAL_UART_Abort相同，在途的DMA发送被丢弃 */
+	TxLen = 0U;
+	return 0U;
+}
+
+static void StubRxStart(uint8_t *buf, uint32_t size)
+{
+	RxBuf = buf;
+	RxSize = size;
+	RxPos = 0U;
+	RxStarts++;
+}
+
+static void StubTxStart(const uint8_t *buf, uint32_t len)
+{
+	TxBuf = buf;
+	TxLen = len;
+	TxStarts++;
+}
+
+static const CDC_BRIDGE_UartTypeDef StubUart =
+{
+	StubConfig,
+	StubRxStart,
+	StubTxStart,
+	NULL
+};
+
+uint8_t USBD_CDC_RegisterInterfaceEx(USBD_HandleTypeDef *pdev, uint8_t index, USBD_CDC_ItfTypeDef *fops)
+{
+	Fops = fops;
+	return USBD_OK;
+}
+
+uint8_t USBD_CDC_SetTxBufferEx(USBD_HandleTypeDef *pdev, uint8_t index, uint8_t *pbuff, uint32_t length)
+{
+	InBuf = pbuff;
+	InLen = length;
+	return USBD_OK;
+}
+
+uint8_t USBD_CDC_SetRxBufferEx(USBD_HandleTypeDef *pdev, uint8_t index, uint8_t *pbuff)
+{
+	return USBD_OK;
+}
+
+uint8_t USBD_CDC_ReceivePacketEx(USBD_HandleTypeDef *pdev, uint8_t index)
+{
+	OutArms++;
+	return USBD_OK;
+}
+
+uint8_t USBD_CDC_TransmitPacketEx(USBD_HandleTypeDef *pdev, uint8_t index)
+{
+	InSubmits++;
+	return USBD_OK;
+}
+
+#if (COM_SOF_ENABLED == 1U)
+uint8_t USBD_COMPOSITE_SofRegister(USBD_COM_SofTaskTypeDef task)
+{
+	return USBD_OK;
+}
+#endif
+
+static void Reset(void)
+{
+	uint32_t i, seed = 1U;
+
+	RxStarts = TxStarts = Configs = ConfigDuringTx = 0U;
+	TxLen = 0U;
+	InSubmits = OutArms = 0U;
+	UartFed = HostInLen = HostOutLen = UartOutLen = 0U;
+	for(i = 0U; i < STREAM_SIZE; i++)
+	{
+		seed = seed * 1103515245U + 12345U;
+		UartStream[i] = (uint8_t)(seed >> 16);
+		HostOut[i] = (uint8_t)(seed >> 8);
+	}
+
+	memset(&Dev, 0, sizeof(Dev));
+	Dev.dev_state = USBD_STATE_CONFIGURED;
+	CHECK_EQ(CDC_Bridge_Attach(&Dev, &StubUart), USBD_OK);
+	Fops->Init();
+}
+
+static void SetDtr(uint8_t dtr)
+{
+	uint8_t req[8] = {0x21U, CDC_SET_CONTROL_LINE_STATE, dtr, 0U, 0U, 0U, 0U, 0U};
+
+	Fops->Control(CDC_SET_CONTROL_LINE_STATE, req, 0U);
+}
+
+/* 串口收到len字节，DMA写入循环缓冲后产生一次接收事件 */
+static void UartFeed(uint32_t len)
+{
+	uint32_t i;
+
+	for(i = 0U; i < len; i++)
+	{
+		RxBuf[RxPos] = UartStream[UartFed++ % STREAM_SIZE];
+		RxPos = (RxPos + 1U) % RxSize;
+	}
+	CDC_Bridge_UartRxEvent(RxPos);
+}
+
+/* 主机取走在途的输入传输 */
+static uint8_t HostRead(void)
+{
+	uint32_t submits = InSubmits;
+
+	if(CDC_Bridge.InBusy == 0U)
+		return 0U;
+	memcpy(&HostIn[HostInLen], InBuf, InLen);
+	HostInLen += InLen;
+	Fops->TransmitCplt(InBuf, &InLen, CDC_BRIDGE_PORT);
+	return (uint8_t)(InSubmits != submits);
+}
+
+/* 主机发出一个输出包 */
+static void HostWrite(uint32_t len)
+{
+	Fops->Receive(&HostOut[HostOutLen], &len);
+	HostOutLen += len;
+}
+
+/* 串口发完在途的DMA */
+static uint8_t UartComplete(void)
+{
+	if(TxLen == 0U)
+		return 0U;
+	memcpy(&UartOut[UartOutLen], TxBuf, TxLen);
+	UartOutLen += TxLen;
+	TxLen = 0U;
+	CDC_Bridge_UartTxCplt();
+	return 1U;
+}
+
+static void SetLineCoding(uint32_t bitrate)
+{
+	uint8_t buf[7] = {(uint8_t)bitrate, (uint8_t)(bitrate >> 8), (uint8_t)(bitrate >> 16), (uint8_t)(bitrate >> 24), 0U, 0U, 8U};
+
+	Fops->Control(CDC_SET_LINE_CODING, buf, sizeof(buf));
+}
+
+static uint32_t GetBitrate(void)
+{
+	uint8_t buf[7];
+
+	Fops->Control(CDC_GET_LINE_CODING, buf, sizeof(buf));
+	return (uint32_t)(buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24));
+}
+
+static void TestInIntegrity(void)
+{
+	uint32_t i, seed = 7U;
+
+	Reset();
+	SetDtr(1U);
+
+	/* 每轮先写入一段、发起传输，传输在途时DMA再写入一段，最后主机才读取；总量不超过STREAM_SIZE */
+	for(i = 0U; i < 200U; i++)
+	{
+		seed = seed * 1103515245U + 12345U;
+		UartFeed(1U + (seed >> 8) % (CDC_BRIDGE_UART_RX_SIZE / 8U));
+		seed = seed * 1103515245U + 12345U;
+		UartFeed((seed >> 8) % (CDC_BRIDGE_UART_RX_SIZE / 8U));
+		(void)HostRead();
+	}
+	while(HostRead() != 0U)
+		;
+
+	CHECK_EQ(CDC_Bridge.Stats.RxOverrun, 0);
+	CHECK_EQ(HostInLen, UartFed);
+	CHECK_EQ(CDC_Bridge.Stats.UartToUsb, UartFed);
+	CHECK(memcmp(HostIn, UartStream, HostInLen) == 0);
+}
+
+static void TestOverrun(void)
+{
+	uint32_t i;
+
+	Reset();
+	SetDtr(1U);
+
+	/* 第一次传输后主机停止读取，DMA写满两圈 */
+	for(i = 0U; i < 8U; i++)
+		UartFeed(CDC_BRIDGE_UART_RX_SIZE / 4U);
+	while(HostRead() != 0U)
+		;
+
+	CHECK(CDC_Bridge.Stats.RxOverrun > 0U);
+	CHECK_EQ(CDC_Bridge.Stats.UartToUsb + CDC_Bridge.Stats.RxOverrun, UartFed);
+	CHECK_EQ(HostInLen, CDC_Bridge.Stats.UartToUsb);
+	/* 第一次传输是最早的数据，其余是最新的数据 */
+	CHECK(memcmp(HostIn, UartStream, CDC_BRIDGE_USB_CHUNK) == 0);
+	CHECK(memcmp(&HostIn[CDC_BRIDGE_USB_CHUNK], &UartStream[UartFed - (HostInLen - CDC_BRIDGE_USB_CHUNK)],
+	             HostInLen - CDC_BRIDGE_USB_CHUNK) == 0);
+
+	/* DTR无效时数据全部丢弃 */
+	SetDtr(0U);
+	UartFeed(100U);
+	CHECK_EQ(CDC_Bridge.Stats.UartToUsb + CDC_Bridge.Stats.RxOverrun, UartFed);
+	CHECK_EQ(HostRead(), 0U);
+}
+
+static void TestDeferredConfig(void)
+{
+	uint32_t starts, rxstarts;
+
+	Reset();
+	SetDtr(1U);
+	HostWrite(COM_CDC_DATA_MAX_PACK_SIZE);
+	CHECK_EQ(TxStarts, 1U);
+
+	/* 请求只登记，GET_LINE_CODING立即反映新值 */
+	SetLineCoding(115200U);
+	CHECK_EQ(Configs, 0U);
+	CHECK_EQ(GetBitrate(), 115200U);
+
+	/* 串口发送未完成时不执行，新数据也不再启动发送 */
+	CDC_Bridge_Poll();
+	CHECK_EQ(Configs, 0U);
+	HostWrite(COM_CDC_DATA_MAX_PACK_SIZE);
+	starts = TxStarts;
+	CHECK_EQ(UartComplete(), 1U);
+	CHECK_EQ(TxStarts, starts);
+
+	rxstarts = RxStarts;
+	CDC_Bridge_Poll();
+	CHECK_EQ(Configs, 1U);
+	CHECK_EQ(ConfigDuringTx, 0U);
+	CHECK_EQ(Baud, 115200U);
+	CHECK_EQ(RxStarts, rxstarts + 1U);
+	CHECK_EQ(TxStarts, starts + 1U);
+	CDC_Bridge_Poll();
+	CHECK_EQ(Configs, 1U);
+
+	/* 不支持的编码不生效，接收不重新启动 */
+	SetLineCoding(0U);
+	while(UartComplete() != 0U)
+		;
+	rxstarts = RxStarts;
+	CDC_Bridge_Poll();
+	CHECK_EQ(Configs, 2U);
+	CHECK_EQ(RxStarts, rxstarts);
+	CHECK_EQ(GetBitrate(), 115200U);
+
+	/* 串口收到的数据与主机发出的完全一致，没有重复 */
+	CHECK_EQ(UartOutLen, HostOutLen);
+	CHECK(memcmp(UartOut, HostOut, UartOutLen) == 0);
+
+	/* 重新配置后接收从缓冲起点开始 */
+	UartFeed(10U);
+	CHECK_EQ(HostRead(), 0U);
+	CHECK_EQ(HostInLen, 10U);
+	CHECK(memcmp(HostIn, UartStream, 10U) == 0);
+}
+
+static void TestOutPause(void)
+{
+	uint32_t arms;
+
+	Reset();
+
+	/* 串口不发送，队列逐包填满 */
+	arms = OutArms;
+	while(CDC_Bridge.OutPaused == 0U)
+		HostWrite(COM_CDC_DATA_MAX_PACK_SIZE);
+	CHECK_EQ(CDC_Bridge.Stats.OutPaused, 1U);
+	CHECK_EQ(OutArms - arms, HostOutLen / COM_CDC_DATA_MAX_PACK_SIZE - 1U);
+	CHECK(CDC_BRIDGE_UART_TX_SIZE - HostOutLen < COM_CDC_DATA_MAX_PACK_SIZE);
+
+	/* 串口发完一段后恢复 */
+	arms = OutArms;
+	CHECK_EQ(UartComplete(), 1U);
+	CHECK_EQ(CDC_Bridge.OutPaused, 0U);
+	CHECK_EQ(OutArms, arms + 1U);
+
+	while(UartComplete() != 0U)
+		;
+	CHECK_EQ(UartOutLen, HostOutLen);
+	CHECK(memcmp(UartOut, HostOut, UartOutLen) == 0);
+	CHECK_EQ(CDC_Bridge.Stats.UsbToUart, HostOutLen);
+}
+
+static void TestOffline(void)
+{
+	Reset();
+	SetDtr(1U);
+
+	/* USB_Device_SwitchMode清除标志后，串口中断不再进入协议栈 */
+	USB_Device_Online = 0U;
+	UartFeed(10U);
+	CHECK_EQ(InSubmits, 0U);
+	CHECK_EQ(HostRead(), 0U);
+
+	USB_Device_Online = 1U;
+	UartFeed(10U);
+	CHECK_EQ(InSubmits, 1U);
+	CHECK_EQ(HostRead(), 0U);
+	CHECK_EQ(HostInLen, 20U);
+	CHECK(memcmp(HostIn, UartStream, 20U) == 0);
+}
+
+int main(void)
+{
+	TestInIntegrity();
+	TestOverrun();
+	TestDeferredConfig();
+	TestOutPause();
+	TestOffline();
+
+	return TEST_RESULT("test_bridge");
+}
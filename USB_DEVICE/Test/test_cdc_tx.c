@@ -0,0 +1,283 @@
+/**
+  ******************************************************************************
+  * @file    test_cdc_tx.c
+  * @brief   usbd_composite.c在OTG_HS内部DMA下的CDC发送路径的主机端测试
+  *           - 64与512字节包长下，0~2100字节的每种长度，主机看到的包序列与
+  *             直接发送相同，整包结尾时有ZLP
+  *           - 字对齐的缓冲直接发送，未对齐的缓冲经中转缓冲分段发送
+  *           - 每次传输都满足USBD_DMA_BUFFER_OK，即usbd_conf.c对DMA缓冲的检查；
+  *             ZLP的缓冲为NULL，也能通过
+  *           - 发送完成回调只调用一次，参数为原缓冲与长度
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "usbd_conf.h"
+#include "test.h"
+
+/* 按带ULPI PHY的OTG_HS配置编译类驱动，中转缓冲为一个高速包 */
+#undef USBD_USE_OTG_HS
+#define USBD_USE_OTG_HS				1U
+#undef USBD_DMA_ENABLED
+#define USBD_DMA_ENABLED			1U
+/* 地址0在ITCM中，目标板上的检查同样不接受NULL */
+#undef DMA_BUFFER_OK
+#define DMA_BUFFER_OK(p)			((p) != NULL)
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/Composite/Src/usbd_composite.c"
+
+#define LENGTH_MAX			2100U
+#define PACKET_MAX			(LENGTH_MAX / 64U + 2U)
+
+USBD_HandleTypeDef hUsbDeviceFS;
+static PCD_HandleTypeDef Pcd;
+
+/* 发送端点桩：一次传输按包长拆成包，记录数据与各包长度 */
+static uint8_t Received[LENGTH_MAX];
+static uint32_t ReceivedLen;
+static uint32_t Packets[PACKET_MAX];
+static uint32_t PacketNum;
+static uint8_t *LastBuf;
+static uint8_t Armed;
+static uint32_t Rejected;
+
+/* 发送完成回调的记录 */
+static uint8_t *CpltBuf;
+static uint32_t CpltLen;
+static uint32_t Cplts;
+
+static __ALIGN_BEGIN uint8_t RxBuffer[COM_CDC_HS_DATA_PACK_SIZE] __ALIGN_END;
+static __ALIGN_BEGIN uint8_t Source[LENGTH_MAX + 4U] __ALIGN_END;
+
+uint32_t HAL_GetTick(void)
+{
+	return 0U;
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+}
+
+void Error_Handler(void)
+{
+	CHECK(0);
+}
+
+USBD_StatusTypeDef USBD_LL_OpenEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t ep_type, uint16_t ep_mps)
+{
+	return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_CloseEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+	return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_FlushEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+	return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_StallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+	return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_ClearStallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+	return USBD_OK;
+}
+
+/* 与usbd_conf.c相同，DMA不能使用的缓冲在启动传输前被拒绝 */
+USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *pbuf, uint32_t size)
+{
+	uint32_t mps = Pcd.IN_ep[ep_addr & 0xFU].maxpacket, n;
+
+	if(!USBD_DMA_BUFFER_OK(pbuf, size))
+	{
+		Rejected++;
+		return USBD_FAIL;
+	}
+	CHECK_EQ(Armed, 0U);
+	CHECK(ReceivedLen + size <= LENGTH_MAX);
+	if(ReceivedLen + size > LENGTH_MAX)
+		return USBD_FAIL;
+
+	if(size != 0U)
+		memcpy(&Received[ReceivedLen], pbuf, size);
+	ReceivedLen += size;
+	/* 空传输为一个ZLP，其余按包长拆分，最后一包可以不满 */
+	do
+	{
+		n = (size < mps) ? size : mps;
+		if(PacketNum < PACKET_MAX)
+			Packets[PacketNum] = n;
+		PacketNum++;
+		size -= n;
+	}while(size != 0U);
+
+	LastBuf = pbuf;
+	Armed = 1U;
+	return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_PrepareReceive(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *pbuf, uint32_t size)
+{
+	if(!USBD_DMA_BUFFER_OK(pbuf, size))
+	{
+		Rejected++;
+		return USBD_FAIL;
+	}
+	return USBD_OK;
+}
+
+uint32_t USBD_LL_GetRxDataSize(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+	return 0U;
+}
+
+USBD_StatusTypeDef USBD_CtlSendData(USBD_HandleTypeDef *pdev, uint8_t *pbuf, uint32_t len)
+{
+	return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_CtlPrepareRx(USBD_HandleTypeDef *pdev, uint8_t *pbuf, uint32_t len)
+{
+	return USBD_OK;
+}
+
+void USBD_CtlError(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+}
+
+static int8_t CdcInit(void)
+{
+	(void)USBD_CDC_SetRxBuffer(&hUsbDeviceFS, RxBuffer);
+	return USBD_OK;
+}
+
+static int8_t CdcDeInit(void)
+{
+	return USBD_OK;
+}
+
+static int8_t CdcControl(uint8_t cmd, uint8_t *pbuf, uint16_t length)
+{
+	return USBD_OK;
+}
+
+static int8_t CdcReceive(uint8_t *Buf, uint32_t *Len)
+{
+	return USBD_OK;
+}
+
+static int8_t CdcTransmitCplt(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
+{
+	CpltBuf = Buf;
+	CpltLen = *Len;
+	Cplts++;
+	return USBD_OK;
+}
+
+/* 替代usbd_composite_if.c中的接口 */
+USBD_CDC_ItfTypeDef USBD_CDC_Interface_fops_FS = {CdcInit, CdcDeInit, CdcControl, CdcReceive, CdcTransmitCplt};
+USBD_StorageTypeDef USBD_MSC_Interface_fops_FS;
+
+/**
+  * @brief  Start 按给定速度打开CDC0
+  */
+static void Start(uint8_t speed, uint32_t mps)
+{
+	memset(&hUsbDeviceFS, 0, sizeof(hUsbDeviceFS));
+	memset(&Pcd, 0, sizeof(Pcd));
+	hUsbDeviceFS.pData = &Pcd;
+	hUsbDeviceFS.dev_speed = speed;
+	hUsbDeviceFS.dev_state = USBD_STATE_CONFIGURED;
+	Pcd.IN_ep[COM_CDC_IN_EP & 0xFU].maxpacket = mps;
+
+	USBD_COM_BuildMap();
+	CHECK_EQ(USBD_COM_Func[0].Init(&hUsbDeviceFS, &USBD_COM_Func[0]), USBD_OK);
+	CHECK_EQ(hUsbDeviceFS.ep_in[COM_CDC_IN_EP & 0xFU].maxpacket, mps);
+}
+
+/**
+  * @brief  Send 发送一次，端点每完成一次传输就调用DataIn，直到发送完成回调
+  * @retval 与直接发送的包序列不一致的次数
+  */
+static uint32_t Send(uint8_t *buf, uint32_t len, uint32_t mps)
+{
+	uint32_t errors = 0U, expect, i, rounds;
+
+	ReceivedLen = 0U;
+	PacketNum = 0U;
+	Armed = 0U;
+	Cplts = 0U;
+
+	CHECK_EQ(USBD_CDC_SetTxBuffer(&hUsbDeviceFS, buf, len), USBD_OK);
+	CHECK_EQ(USBD_CDC_TransmitPacket(&hUsbDeviceFS), USBD_OK);
+	for(rounds = 0U; (Cplts == 0U) && (rounds < PACKET_MAX + 2U); rounds++)
+	{
+		CHECK_EQ(Armed, 1U);
+		/* 未对齐的缓冲不会直接交给DMA */
+		if(((uintptr_t)buf & 0x3U) != 0U)
+			CHECK(LastBuf != buf);
+		Armed = 0U;
+		(void)USBD_COMPOSITE_DataIn(&hUsbDeviceFS, COM_CDC_IN_EP & 0xFU);
+	}
+
+	CHECK_EQ(Cplts, 1U);
+	CHECK(CpltBuf == buf);
+	CHECK_EQ(CpltLen, len);
+	CHECK_EQ(USBD_CDC_Handle[0].TxState, 0U);
+	CHECK_EQ(Armed, 0U);
+
+	/* 直接发送时主机看到的包：整包、不满的最后一包，整包结尾或空传输时一个ZLP */
+	expect = len / mps + 1U;
+	if(ReceivedLen != len || memcmp(Received, buf, len) != 0 || PacketNum != expect)
+		return 1U;
+	for(i = 0U; i < expect; i++)
+	{
+		if(Packets[i] != ((i + 1U < expect) ? mps : len % mps))
+			errors++;
+	}
+	return (errors != 0U) ? 1U : 0U;
+}
+
+static void TestSpeed(uint8_t speed, uint32_t mps)
+{
+	uint32_t offset, len, errors;
+
+	Start(speed, mps);
+	for(offset = 0U; offset < 4U; offset++)
+	{
+		errors = 0U;
+		for(len = 0U; len <= LENGTH_MAX - 4U; len++)
+			errors += Send(&Source[offset], len, mps);
+		CHECK_EQ(errors, 0U);
+	}
+	CHECK_EQ(Rejected, 0U);
+}
+
+static void TestCheck(void)
+{
+	/* ZLP不访问缓冲，NULL也能发送；有数据时缓冲必须对齐且DMA能访问 */
+	CHECK(USBD_DMA_BUFFER_OK(NULL, 0U));
+	CHECK(USBD_DMA_BUFFER_OK(&Source[1], 0U));
+	CHECK(USBD_DMA_BUFFER_OK(&Source[0], 64U));
+	CHECK(!USBD_DMA_BUFFER_OK(NULL, 64U));
+	CHECK(!USBD_DMA_BUFFER_OK(&Source[1], 64U));
+	CHECK(!USBD_DMA_BUFFER_OK(&Source[2], 512U));
+}
+
+int main(void)
+{
+	uint32_t i;
+
+	for(i = 0U; i < sizeof(Source); i++)
+		Source[i] = (uint8_t)(i * 7U + (i >> 8));
+
+	TestCheck();
+	TestSpeed(USBD_SPEED_HIGH, COM_CDC_HS_DATA_PACK_SIZE);
+	TestSpeed(USBD_SPEED_FULL, COM_CDC_FS_DATA_PACK_SIZE);
+
+	return TEST_RESULT("test_cdc_tx");
+}
@@ -0,0 +1,177 @@
+/**
+  ******************************************************************************
+  * @file    test_desc.c
+  * @brief   usbd_desc.c字符串描述符的主机端测试
+  *           - 按Windows枚举的顺序重放16个字符串请求，返回内容与逐次转换的
+  *             结果逐字节相同
+  *           - 每个描述符缓冲按字对齐，后一个请求不改写前一个请求的返回内容
+  *           - 序列号与NCM的MAC地址字符串由唯一ID生成
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+
+/* 唯一ID寄存器由数组代替，直接包含源文件以使用其中的字符串定义 */
+static uint32_t TestUid[3] = {0x00380024U, 0x3431510AU, 0x32363830U};
+#define UID_BASE			((uintptr_t)TestUid)
+#include "../App/usbd_desc.c"
+
+#define REQUEST_NUM			16U
+
+typedef uint8_t *(*DescFuncTypeDef)(USBD_SpeedTypeDef speed, uint16_t *length);
+
+typedef struct
+{
+	DescFuncTypeDef Func;
+	const char *Str;		/**< 为NULL时由Expect按请求生成 */
+	const char *Name;
+}RequestTypeDef;
+
+/* LANGID、产品与序列号各请求两次，其后是配置、接口与IAD字符串 */
+static const RequestTypeDef Requests[REQUEST_NUM] =
+{
+	{USBD_FS_LangIDStrDescriptor,             NULL,                                 "langid"},
+	{USBD_FS_ProductStrDescriptor,            USBD_PRODUCT_STRING_FS,               "product"},
+	{USBD_FS_SerialStrDescriptor,             NULL,                                 "serial"},
+	{USBD_FS_LangIDStrDescriptor,             NULL,                                 "langid"},
+	{USBD_FS_ProductStrDescriptor,            USBD_PRODUCT_STRING_FS,               "product"},
+	{USBD_FS_SerialStrDescriptor,             NULL,                                 "serial"},
+	{USBD_FS_ManufacturerStrDescriptor,       USBD_MANUFACTURER_STRING,             "manufacturer"},
+	{USBD_FS_ConfigStrDescriptor,             USBD_CONFIGURATION_STRING_FS,         "config"},
+	{USBD_FS_CDCControlInterfaceStrDescriptor, USBD_CDC_CONTROL_INTERFACE_STRING_FS, "cdc control"},
+	{USBD_FS_CDCDataInterfaceStrDescriptor,   USBD_CDC_DATA_INTERFACE_STRING_FS,    "cdc data"},
+	{USBD_FS_MSCDataInterfaceStrDescriptor,   USBD_MSC_DATA_INTERFACE_STRING_FS,    "msc data"},
+	{USBD_FS_HIDDataInterfaceStrDescriptor,   USBD_HID_DATA_INTERFACE_STRING_FS,    "hid data"},
+	{USBD_FS_CDCIADStrDescriptor,             USBD_CDC_IAD_STRING_FS,               "cdc iad"},
+	{USBD_FS_MSCIADStrDescriptor,             USBD_MSC_IAD_STRING_FS,               "msc iad"},
+	{USBD_FS_HIDIADStrDescriptor,             UABD_HID_IAD_STRING_FS,               "hid iad"},
+	{USBD_FS_NCMMacStrDescriptor,             NULL,                                 "ncm mac"},
+};
+
+static uint8_t Mode = COM_MODE_COMPOSITE;
+static uint8_t Expected[USBD_MAX_STR_DESC_SIZ];
+static uint8_t Saved[USBD_MAX_STR_DESC_SIZ];
+
+/* 与usbd_ctlreq.c中的实现相同，即改动前每次请求执行的转换 */
+void USBD_GetString(uint8_t *desc, uint8_t *unicode, uint16_t *len)
+{
+	uint8_t idx = 0U;
+
+	if(desc == NULL)
+		return;
+	*len = (uint16_t)(strlen((const char *)desc) * 2U + 2U);
+	unicode[idx++] = (uint8_t)*len;
+	unicode[idx++] = USB_DESC_TYPE_STRING;
+	while(*desc != '\0')
+	{
+		unicode[idx++] = *desc++;
+		unicode[idx++] = 0U;
+	}
+}
+
+uint8_t USBD_COMPOSITE_GetMode(void)
+{
+	return Mode;
+}
+
+/* 按请求生成期望的描述符，返回长度 */
+static uint16_t Expect(const RequestTypeDef *req)
+{
+	char text[32];
+	uint32_t serial = TestUid[0] + TestUid[2];
+	uint16_t len = 0U;
+
+	if(req->Str != NULL)
+	{
+		USBD_GetString((uint8_t *)req->Str, Expected, &len);
+		return len;
+	}
+	if(req->Func == USBD_FS_LangIDStrDescriptor)
+	{
+		Expected[0] = 4U;
+		Expected[1] = USB_DESC_TYPE_STRING;
+		Expected[2] = LOBYTE(USBD_LANGID_STRING);
+		Expected[3] = HIBYTE(USBD_LANGID_STRING);
+		return 4U;
+	}
+	if(req->Func == USBD_FS_SerialStrDescriptor)
+		(void)snprintf(text, sizeof(text), "%08X%04X", serial, TestUid[1] >> 16);
+	else
+		(void)snprintf(text, sizeof(text), "02%08X%02X", serial, ~TestUid[1] & 0xFFU);
+	USBD_GetString((uint8_t *)text, Expected, &len);
+	return len;
+}
+
+static void TestSequence(void)
+{
+	const RequestTypeDef *req;
+	uint16_t len, expected;
+	uint8_t *desc;
+	uint32_t i;
+
+	USBD_FS_DescInit();
+
+	for(i = 0U; i < REQUEST_NUM; i++)
+	{
+		req = &Requests[i];
+		len = 0U;
+		desc = req->Func(USBD_SPEED_FULL, &len);
+		expected = Expect(req);
+
+		CHECK_EQ(len, expected);
+		CHECK_EQ(desc[0], expected);
+		CHECK_EQ((uintptr_t)desc & 3U, 0U);
+		if(memcmp(desc, Expected, expected) != 0)
+		{
+			printf("%s: descriptor differs\n", req->Name);
+			CHECK(0);
+		}
+	}
+}
+
+static void TestNoSharedBuffer(void)
+{
+	uint16_t len, other;
+	uint8_t *desc;
+	uint32_t i, n;
+
+	/* 每个请求的返回内容在其后所有请求之后仍不变 */
+	for(i = 0U; i < REQUEST_NUM; i++)
+	{
+		desc = Requests[i].Func(USBD_SPEED_FULL, &len);
+		memcpy(Saved, desc, len);
+		for(n = 0U; n < REQUEST_NUM; n++)
+			(void)Requests[n].Func(USBD_SPEED_HIGH, &other);
+		CHECK(memcmp(desc, Saved, len) == 0);
+	}
+
+	/* 再次初始化结果不变 */
+	desc = USBD_FS_ProductStrDescriptor(USBD_SPEED_FULL, &len);
+	memcpy(Saved, desc, len);
+	USBD_FS_DescInit();
+	CHECK(memcmp(USBD_FS_ProductStrDescriptor(USBD_SPEED_FULL, &len), Saved, len) == 0);
+}
+
+static void TestDeviceDesc(void)
+{
+	uint16_t len;
+
+	Mode = COM_MODE_COMPOSITE;
+	CHECK(USBD_FS_DeviceDescriptor(USBD_SPEED_FULL, &len) == USBD_FS_DeviceDesc);
+	Mode = COM_MODE_MSC_ONLY;
+	CHECK(USBD_FS_DeviceDescriptor(USBD_SPEED_FULL, &len) == USBD_FS_MscOnlyDeviceDesc);
+	CHECK_EQ(len, USB_LEN_DEV_DESC);
+	Mode = COM_MODE_COMPOSITE;
+}
+
+int main(void)
+{
+	TestSequence();
+	TestNoSharedBuffer();
+	TestDeviceDesc();
+
+	return TEST_RESULT("test_desc");
+}
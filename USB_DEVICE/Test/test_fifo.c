@@ -0,0 +1,227 @@
+/**
+  ******************************************************************************
+  * @file    test_fifo.c
+  * @brief   usbd_fifo.c中FIFO规划的主机端测试
+  *           - 全速与高速配置的规划结果逐项核对
+  *           - 空间不足时按优先级与端点号扩展，逐包减少
+  *           - 高速高带宽端点按每微帧事务数计算包长
+  *           - 错误的描述符与放不下的配置被拒绝
+  *           - 随机配置下各FIFO之和等于预算，且每个端点至少容纳一个包
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "usbd_fifo.h"
+#include "test.h"
+
+#define DESC_SIZE			256U
+#define RANDOM_CASES		20000U
+
+#define EP_ISOC				0x01U
+#define EP_BULK				0x02U
+#define EP_INTR				0x03U
+
+static uint8_t Desc[DESC_SIZE];
+static uint16_t DescLen;
+static USBD_FIFO_PlanTypeDef Plan;
+
+/* 配置描述符头与一个接口描述符，之后由AddEp追加端点 */
+static void Begin(void)
+{
+	static const uint8_t head[] =
+	{
+		0x09, 0x02, 0x00, 0x00, 0x01, 0x01, 0x00, 0xC0, 0x32,
+		0x09, 0x04, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00
+	};
+
+	memcpy(Desc, head, sizeof(head));
+	DescLen = sizeof(head);
+}
+
+static void AddEp(uint8_t addr, uint8_t type, uint16_t wmps)
+{
+	uint8_t *p = &Desc[DescLen];
+
+	p[0] = 0x07U;
+	p[1] = 0x05U;
+	p[2] = addr;
+	p[3] = type;
+	p[4] = (uint8_t)wmps;
+	p[5] = (uint8_t)(wmps >> 8);
+	p[6] = 0x00U;
+	DescLen += 7U;
+	Desc[2] = (uint8_t)DescLen;
+}
+
+static uint32_t Sum(const USBD_FIFO_PlanTypeDef *plan)
+{
+	uint32_t i, sum = plan->Rx;
+
+	for(i = 0U; i < plan->TxNum; i++)
+		sum += plan->Tx[i];
+	return sum;
+}
+
+static void TestFullSpeed(void)
+{
+	/* CDC：批量输入64字节，中断通知8字节，批量输出64字节 */
+	Begin();
+	AddEp(0x82U, EP_INTR, 8U);
+	AddEp(0x81U, EP_BULK, 64U);
+	AddEp(0x01U, EP_BULK, 64U);
+
+	CHECK_EQ(USBD_FIFO_Plan(Desc, DescLen, NULL, 1024U, &Plan), USBD_FIFO_OK);
+	CHECK_EQ(Plan.TxNum, 3U);
+	CHECK_EQ(Plan.Tx[0], 16U);
+	CHECK_EQ(Plan.Tx[1], 32U);		/* 批量端点默认两个包 */
+	CHECK_EQ(Plan.Tx[2], 16U);
+	CHECK_EQ(Plan.Rx, 960U);
+	CHECK_EQ(Plan.Used, 1024U);
+	CHECK_EQ(Sum(&Plan), 1024U);
+}
+
+static void TestGap(void)
+{
+	/* 只有端点3，端点1、2也要占位 */
+	Begin();
+	AddEp(0x83U, EP_INTR, 8U);
+
+	CHECK_EQ(USBD_FIFO_Plan(Desc, DescLen, NULL, 1024U, &Plan), USBD_FIFO_OK);
+	CHECK_EQ(Plan.TxNum, 4U);
+	CHECK_EQ(Plan.Tx[1], USBD_FIFO_MIN_WORDS);
+	CHECK_EQ(Plan.Tx[2], USBD_FIFO_MIN_WORDS);
+	CHECK_EQ(Plan.Tx[3], USBD_FIFO_MIN_WORDS);
+	CHECK_EQ(Plan.Rx, 960U);
+	CHECK_EQ(Sum(&Plan), 1024U);
+}
+
+static void TestPriority(void)
+{
+	USBD_FIFO_HintTypeDef hint[USBD_FIFO_TX_NUM];
+
+	/* 高速：两个512字节批量输入各希望4个包，800字只够其中一个扩展一个包 */
+	Begin();
+	AddEp(0x81U, EP_BULK, 512U);
+	AddEp(0x82U, EP_BULK, 512U);
+	AddEp(0x01U, EP_BULK, 512U);
+	memset(hint, 0, sizeof(hint));
+	hint[1].Packets = 4U;
+	hint[1].Priority = 1U;
+	hint[2].Packets = 4U;
+	hint[2].Priority = 2U;
+
+	CHECK_EQ(USBD_FIFO_Plan(Desc, DescLen, hint, 800U, &Plan), USBD_FIFO_OK);
+	CHECK_EQ(Plan.Tx[1], 128U);
+	CHECK_EQ(Plan.Tx[2], 256U);
+	CHECK_EQ(Plan.Rx, 400U);
+	CHECK_EQ(Sum(&Plan), 800U);
+
+	/* 优先级相同时端点号小的先分配 */
+	hint[2].Priority = 1U;
+	CHECK_EQ(USBD_FIFO_Plan(Desc, DescLen, hint, 800U, &Plan), USBD_FIFO_OK);
+	CHECK_EQ(Plan.Tx[1], 256U);
+	CHECK_EQ(Plan.Tx[2], 128U);
+	CHECK_EQ(Sum(&Plan), 800U);
+
+	/* 空间充足时都扩展到提示的包数 */
+	CHECK_EQ(USBD_FIFO_Plan(Desc, DescLen, hint, 4096U, &Plan), USBD_FIFO_OK);
+	CHECK_EQ(Plan.Tx[1], 512U);
+	CHECK_EQ(Plan.Tx[2], 512U);
+	CHECK_EQ(Sum(&Plan), 4096U);
+}
+
+static void TestHighBandwidth(void)
+{
+	/* 1024字节，每微帧3个事务 */
+	Begin();
+	AddEp(0x81U, EP_ISOC, 0x1400U);
+
+	CHECK_EQ(USBD_FIFO_Plan(Desc, DescLen, NULL, 1024U, &Plan), USBD_FIFO_OK);
+	CHECK_EQ(Plan.Tx[1], 768U);
+	CHECK_EQ(Plan.Rx, 240U);
+	CHECK_EQ(Sum(&Plan), 1024U);
+
+	/* 一个包也放不下 */
+	CHECK_EQ(USBD_FIFO_Plan(Desc, DescLen, NULL, 800U, &Plan), USBD_FIFO_ERR_SPACE);
+}
+
+static void TestErrors(void)
+{
+	/* 端点号超出发送FIFO个数 */
+	Begin();
+	AddEp(0x8AU, EP_BULK, 64U);
+	CHECK_EQ(USBD_FIFO_Plan(Desc, DescLen, NULL, 1024U, &Plan), USBD_FIFO_ERR_DESC);
+
+	/* 端点0不应出现在配置描述符中 */
+	Begin();
+	AddEp(0x00U, EP_BULK, 64U);
+	CHECK_EQ(USBD_FIFO_Plan(Desc, DescLen, NULL, 1024U, &Plan), USBD_FIFO_ERR_DESC);
+
+	/* 截断的端点描述符 */
+	Begin();
+	AddEp(0x81U, EP_BULK, 64U);
+	CHECK_EQ(USBD_FIFO_Plan(Desc, (uint16_t)(DescLen - 2U), NULL, 1024U, &Plan), USBD_FIFO_ERR_DESC);
+
+	/* 长度为0的描述符不会造成死循环 */
+	Begin();
+	Desc[DescLen++] = 0x00U;
+	Desc[DescLen++] = 0x05U;
+	CHECK_EQ(USBD_FIFO_Plan(Desc, DescLen, NULL, 1024U, &Plan), USBD_FIFO_ERR_DESC);
+}
+
+static void TestRandom(void)
+{
+	USBD_FIFO_HintTypeDef hint[USBD_FIFO_TX_NUM];
+	uint16_t in_size[USBD_FIFO_TX_NUM];
+	uint32_t i, n, num, words, seed = 1U, bad = 0U;
+	uint16_t budget, wmps;
+	uint8_t type;
+
+	for(i = 0U; i < RANDOM_CASES; i++)
+	{
+		Begin();
+		memset(in_size, 0, sizeof(in_size));
+		for(n = 0U; n < USBD_FIFO_TX_NUM; n++)
+		{
+			seed = seed * 1103515245U + 12345U;
+			hint[n].Packets = (uint8_t)((seed >> 8) % 5U);
+			hint[n].Priority = (uint8_t)((seed >> 12) % 3U);
+		}
+		for(n = (seed >> 16) % 8U; n != 0U; n--)
+		{
+			seed = seed * 1103515245U + 12345U;
+			num = 1U + (seed >> 8) % (USBD_FIFO_TX_NUM - 1U);
+			type = (uint8_t)(1U + (seed >> 12) % 3U);
+			wmps = (uint16_t)(8U << ((seed >> 16) % 7U));
+			AddEp((uint8_t)(((seed & 0x100U) != 0U) ? (0x80U | num) : num), type, wmps);
+			if((seed & 0x100U) != 0U)
+				in_size[num] = (wmps > in_size[num]) ? wmps : in_size[num];
+		}
+		seed = seed * 1103515245U + 12345U;
+		budget = (uint16_t)(256U + (seed >> 8) % 3840U);
+
+		if(USBD_FIFO_Plan(Desc, DescLen, hint, budget, &Plan) != USBD_FIFO_OK)
+			continue;
+		if((Sum(&Plan) != budget) || (Plan.Used != budget) || (Plan.Tx[0] < USBD_FIFO_MIN_WORDS))
+			bad++;
+		for(num = 1U; num < Plan.TxNum; num++)
+		{
+			words = (in_size[num] + 3U) / 4U;
+			if((Plan.Tx[num] < USBD_FIFO_MIN_WORDS) || (Plan.Tx[num] < words))
+				bad++;
+		}
+	}
+	CHECK_EQ(bad, 0U);
+}
+
+int main(void)
+{
+	TestFullSpeed();
+	TestGap();
+	TestPriority();
+	TestHighBandwidth();
+	TestErrors();
+	TestRandom();
+
+	return TEST_RESULT("test_fifo");
+}
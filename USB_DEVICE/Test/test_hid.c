@@ -0,0 +1,310 @@
+/**
+  ******************************************************************************
+  * @file    test_hid.c
+  * @brief   usbd_hid.c的主机端测试，按1ms帧模拟主机对中断端点的查询
+  *           - 默认接口丢弃输出报告，不产生应答
+  *           - 应用注册的回显接口下，命令往返不超过两个查询间隔
+  *           - 遥测周期为两个查询间隔时，命令应答总能排队，往返不超过三个
+  *             查询间隔，没有命令丢失
+  *           - 遥测每个查询间隔提交一次时，端点饱和，应答被拒绝并计数
+  *           - 报告在端点上时不会再次启动发送
+  *           - GET_IDLE的应答缓冲按字对齐，内容为SET_IDLE的设置值
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "usbd_composite.h"
+#include "test.h"
+
+/* HID接口默认不参与编译，这里直接包含源文件 */
+#undef COM_HID_ENABLED
+#define COM_HID_ENABLED				1U
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/Composite/Src/usbd_hid.c"
+
+#define SIM_FRAMES			200000U
+#define SIM_STEP_US			50U
+#define CMD_TAG				0xC0U
+#define TELEMETRY_TAG		0xEEU
+#define CMD_TIMEOUT_US		20000U
+
+USBD_HandleTypeDef hUsbDeviceFS;
+
+static uint32_t NowUs;
+static uint32_t Seed;
+
+/* 中断端点桩：输入报告由主机在帧内查询时取走 */
+static uint8_t *InBuf;
+static uint8_t InArmed;
+static uint32_t DoubleArms;
+static uint8_t *OutBuf;
+static uint8_t OutArmed;
+static uint32_t OutLen;
+
+/* EP0桩：记录最近一次数据阶段的缓冲 */
+static uint8_t *CtlBuf;
+static uint32_t CtlLen;
+
+/* 模拟结果 */
+static uint32_t Commands;
+static uint32_t Answered;
+static uint32_t Lost;
+static uint32_t MaxRtt;
+
+uint32_t HAL_GetTick(void)
+{
+	return NowUs / 1000U;
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+	NowUs += Delay * 1000U;
+}
+
+void Error_Handler(void)
+{
+	CHECK(0);
+}
+
+USBD_StatusTypeDef USBD_LL_OpenEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t ep_type, uint16_t ep_mps)
+{
+	return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_CloseEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+	return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *pbuf, uint32_t size)
+{
+	if(InArmed != 0U)
+		DoubleArms++;
+	InBuf = pbuf;
+	InArmed = 1U;
+	return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_PrepareReceive(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *pbuf, uint32_t size)
+{
+	OutBuf = pbuf;
+	OutArmed = 1U;
+	return USBD_OK;
+}
+
+uint32_t USBD_LL_GetRxDataSize(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+	return OutLen;
+}
+
+USBD_StatusTypeDef USBD_CtlSendData(USBD_HandleTypeDef *pdev, uint8_t *pbuf, uint32_t len)
+{
+	CtlBuf = pbuf;
+	CtlLen = len;
+	return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_CtlPrepareRx(USBD_HandleTypeDef *pdev, uint8_t *pbuf, uint32_t len)
+{
+	return USBD_OK;
+}
+
+void USBD_CtlError(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+}
+
+static int8_t Nop(void)
+{
+	return USBD_OK;
+}
+
+static int8_t Discard(uint8_t *Buf, uint32_t Len)
+{
+	return USBD_OK;
+}
+
+/* 替代usbd_composite_if.c中的默认接口，收到的报告被丢弃 */
+USBD_HID_ItfTypeDef USBD_HID_Interface_fops_FS = {Nop, Nop, Discard};
+
+/* 测试注册的应用接口：把命令原样作为应答提交 */
+static int8_t Echo(uint8_t *Buf, uint32_t Len)
+{
+	(void)USBD_HID_SendReport(&hUsbDeviceFS, Buf, (uint16_t)Len);
+	return USBD_OK;
+}
+
+static USBD_HID_ItfTypeDef EchoFops = {Nop, Nop, Echo};
+
+static uint32_t Random(void)
+{
+	Seed = Seed * 1103515245U + 12345U;
+	return Seed >> 16;
+}
+
+static void Start(void)
+{
+	InArmed = 0U;
+	OutArmed = 0U;
+	DoubleArms = 0U;
+	Commands = 0U;
+	Answered = 0U;
+	Lost = 0U;
+	MaxRtt = 0U;
+	Seed = 1U;
+	NowUs = 0U;
+	hUsbDeviceFS.dev_state = USBD_STATE_CONFIGURED;
+	(void)USBD_HID_Init(&hUsbDeviceFS);
+}
+
+/*
+ * 每帧内应用按遥测周期提交报告，主机在随机时刻发出命令；帧开始时周期调度
+ * 先于批量传输，主机先下发输出报告，随后在同一帧内查询输入端点。
+ * 往返时间从命令发出到应答被取走，按查询间隔向上取整。
+ */
+static void Simulate(uint32_t telemetry_us)
+{
+	uint8_t report[COM_HID_REPORT_SIZE];
+	uint32_t frame, start, sent = 0U, seq = 0U, next = 0U, rtt;
+	uint8_t waiting = 0U;
+	uint8_t *buf;
+
+	Start();
+	for(frame = 0U; frame < SIM_FRAMES; frame++)
+	{
+		start = frame * 1000U;
+		for(NowUs = start; NowUs < start + 1000U; NowUs += SIM_STEP_US)
+		{
+			if((telemetry_us != 0U) && (NowUs >= next))
+			{
+				memset(report, 0, sizeof(report));
+				report[0] = TELEMETRY_TAG;
+				(void)USBD_HID_SendReport(&hUsbDeviceFS, report, COM_HID_REPORT_SIZE);
+				next += telemetry_us;
+			}
+			if((waiting == 0U) && (Random() % 40U == 0U))
+			{
+				waiting = 1U;
+				sent = NowUs;
+				seq++;
+				Commands++;
+			}
+		}
+
+		NowUs = start + 1000U;
+		if((waiting == 1U) && (OutArmed != 0U))
+		{
+			memset(OutBuf, 0, COM_HID_REPORT_SIZE);
+			OutBuf[0] = CMD_TAG;
+			memcpy(&OutBuf[1], &seq, sizeof(seq));
+			OutLen = COM_HID_REPORT_SIZE;
+			OutArmed = 0U;
+			waiting = 2U;
+			(void)USBD_HID_DataOut(&hUsbDeviceFS, COM_HID_OUT_EP);
+		}
+		if((waiting == 2U) && (NowUs - sent > CMD_TIMEOUT_US))
+		{
+			Lost++;
+			waiting = 0U;
+		}
+
+		NowUs += 100U;
+		if(InArmed != 0U)
+		{
+			buf = InBuf;
+			InArmed = 0U;
+			if((waiting == 2U) && (buf[0] == CMD_TAG) && (memcmp(&buf[1], &seq, sizeof(seq)) == 0))
+			{
+				rtt = (NowUs - sent + 999U) / 1000U;
+				if(rtt > MaxRtt)
+					MaxRtt = rtt;
+				Answered++;
+				waiting = 0U;
+			}
+			(void)USBD_HID_DataIn(&hUsbDeviceFS, COM_HID_IN_EP);
+		}
+	}
+}
+
+static void TestDefaultDiscards(void)
+{
+	USBD_HID_StatsTypeDef stats;
+
+	/* 未注册应用接口时收到的命令不产生应答 */
+	USBD_HID_Fops = &USBD_HID_Interface_fops_FS;
+	Simulate(0U);
+	USBD_HID_GetStats(&stats);
+	CHECK(Commands > 0U);
+	CHECK_EQ(Answered, 0U);
+	CHECK(stats.OutReports > 0U);
+	CHECK_EQ(stats.InReports, 0U);
+}
+
+static void TestEcho(void)
+{
+	USBD_HID_StatsTypeDef stats;
+
+	CHECK_EQ(USBD_HID_RegisterInterface(NULL), USBD_FAIL);
+	CHECK_EQ(USBD_HID_RegisterInterface(&EchoFops), USBD_OK);
+
+	Simulate(0U);
+	USBD_HID_GetStats(&stats);
+	CHECK(Answered > 1000U);
+	CHECK_EQ(Lost, 0U);
+	CHECK(MaxRtt <= 2U);
+	CHECK_EQ(stats.Rejected, 0U);
+	CHECK_EQ(DoubleArms, 0U);
+}
+
+static void TestTelemetry(void)
+{
+	USBD_HID_StatsTypeDef stats;
+
+	/* 遥测周期为两个查询间隔 */
+	Simulate(2000U);
+	USBD_HID_GetStats(&stats);
+	CHECK(Answered > 1000U);
+	CHECK_EQ(Lost, 0U);
+	CHECK(MaxRtt <= 3U);
+	CHECK_EQ(stats.Rejected, 0U);
+	CHECK(stats.MaxLatency <= 2U);
+	CHECK_EQ(DoubleArms, 0U);
+
+	/* 每个查询间隔一个遥测报告，端点饱和，应答被拒绝而不是覆盖排队的报告 */
+	Simulate(1000U);
+	USBD_HID_GetStats(&stats);
+	CHECK(stats.Rejected > 0U);
+	CHECK(Lost > 0U);
+	CHECK_EQ(DoubleArms, 0U);
+}
+
+static void TestIdle(void)
+{
+	USBD_SetupReqTypedef req;
+
+	Start();
+	memset(&req, 0, sizeof(req));
+	req.bmRequest = USB_REQ_TYPE_CLASS | USB_REQ_RECIPIENT_INTERFACE;
+	req.bRequest = HID_REQ_SET_IDLE;
+	req.wValue = 0x7D00U;
+	CHECK_EQ(USBD_HID_Setup(&hUsbDeviceFS, &req), USBD_OK);
+
+	req.bmRequest = 0x80U | USB_REQ_TYPE_CLASS | USB_REQ_RECIPIENT_INTERFACE;
+	req.bRequest = HID_REQ_GET_IDLE;
+	req.wValue = 0U;
+	req.wLength = 1U;
+	CtlBuf = NULL;
+	CHECK_EQ(USBD_HID_Setup(&hUsbDeviceFS, &req), USBD_OK);
+	CHECK(CtlBuf != NULL);
+	CHECK_EQ((uintptr_t)CtlBuf & 3U, 0U);
+	CHECK_EQ(CtlLen, 1U);
+	CHECK_EQ(CtlBuf[0], 0x7DU);
+}
+
+int main(void)
+{
+	TestDefaultDiscards();
+	TestEcho();
+	TestTelemetry();
+	TestIdle();
+
+	return TEST_RESULT("test_hid");
+}
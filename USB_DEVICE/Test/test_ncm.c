@@ -0,0 +1,204 @@
+/**
+  ******************************************************************************
+  * @file    test_ncm.c
+  * @brief   usbd_ncm.c中NTB16编码与解析的主机端测试
+  *           - 编码结果按NCM规范逐字段核对
+  *           - 编码再解析得到原帧
+  *           - 越界偏移、NDP环路与截断的NTB被拒绝
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "usbd_ncm.h"
+#include "test.h"
+
+#define FRAME_NUM_MAX		32U
+
+static uint8_t Ntb[NCM_NTB_IN_SIZE];
+static uint8_t Frames[FRAME_NUM_MAX][NCM_MAX_SEGMENT_SIZE];
+static uint16_t FrameLen[FRAME_NUM_MAX];
+
+/* 解析回调收到的帧 */
+static uint32_t RxCount;
+static uint8_t RxMatch;
+
+static uint16_t Get16(const uint8_t *p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t Get32(const uint8_t *p)
+{
+	return (uint32_t)Get16(p) | ((uint32_t)Get16(p + 2) << 16);
+}
+
+static void Put16(uint8_t *p, uint16_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void RxFrame(uint8_t *Buf, uint16_t Len)
+{
+	if((RxCount >= FRAME_NUM_MAX) || (Len != FrameLen[RxCount]) || (memcmp(Buf, Frames[RxCount], Len) != 0))
+		RxMatch = 0U;
+	RxCount++;
+}
+
+static void MakeFrames(uint32_t seed)
+{
+	uint32_t i, j;
+
+	for(i = 0U; i < FRAME_NUM_MAX; i++)
+	{
+		seed = seed * 1103515245U + 12345U;
+		FrameLen[i] = (uint16_t)(14U + (seed >> 8) % (NCM_MAX_SEGMENT_SIZE - 13U));
+		for(j = 0U; j < FrameLen[i]; j++)
+		{
+			seed = seed * 1103515245U + 12345U;
+			Frames[i][j] = (uint8_t)(seed >> 16);
+		}
+	}
+}
+
+/* 编码结果的各字段符合NTB16格式 */
+static void TestEncodeLayout(void)
+{
+	USBD_NCM_NtbTypeDef ntb;
+	uint32_t length, ndp, i;
+
+	MakeFrames(1U);
+	FrameLen[0] = 60U;
+	FrameLen[1] = 61U;
+	FrameLen[2] = 1514U;
+
+	USBD_NCM_NtbReset(&ntb, Ntb, sizeof(Ntb));
+	CHECK_EQ(USBD_NCM_NtbFinish(&ntb, 0U), 0U);
+	for(i = 0U; i < 3U; i++)
+		CHECK_EQ(USBD_NCM_NtbAppend(&ntb, Frames[i], FrameLen[i]), USBD_OK);
+	length = USBD_NCM_NtbFinish(&ntb, 0x1234U);
+
+	CHECK_EQ(Get32(&Ntb[0]), NCM_NTH16_SIGNATURE);
+	CHECK_EQ(Get16(&Ntb[4]), NCM_NTH16_SIZE);
+	CHECK_EQ(Get16(&Ntb[6]), 0x1234U);
+	CHECK_EQ(Get16(&Ntb[8]), length);
+	ndp = Get16(&Ntb[10]);
+	CHECK_EQ(ndp % NCM_NDP_ALIGN, 0U);
+	CHECK_EQ(Get32(&Ntb[ndp]), NCM_NDP16_SIGNATURE);
+	CHECK_EQ(Get16(&Ntb[ndp + 4U]), NCM_NDP16_HEAD_SIZE + 4U * NCM_NDP16_ENTRY_SIZE);
+	CHECK_EQ(Get16(&Ntb[ndp + 6U]), 0U);
+	CHECK_EQ(ndp + Get16(&Ntb[ndp + 4U]), length);
+
+	for(i = 0U; i < 3U; i++)
+	{
+		uint16_t index = Get16(&Ntb[ndp + 8U + 4U * i]);
+
+		CHECK_EQ(index % NCM_NDP_ALIGN, 0U);
+		CHECK_EQ(Get16(&Ntb[ndp + 10U + 4U * i]), FrameLen[i]);
+		CHECK(memcmp(&Ntb[index], Frames[i], FrameLen[i]) == 0);
+	}
+	/* 结束项 */
+	CHECK_EQ(Get32(&Ntb[ndp + 8U + 4U * 3U]), 0U);
+	/* 61字节的帧之后有3字节对齐填充，填充为0 */
+	CHECK_EQ(Ntb[NCM_NTH16_SIZE + 60U + 61U], 0U);
+	CHECK_EQ(Ntb[NCM_NTH16_SIZE + 60U + 63U], 0U);
+}
+
+/* 随机长度的帧编码后解析，帧内容与顺序不变；缓冲区满时拒绝追加 */
+static void TestRoundTrip(void)
+{
+	USBD_NCM_NtbTypeDef ntb;
+	uint32_t seed, length, count;
+
+	for(seed = 1U; seed <= 200U; seed++)
+	{
+		MakeFrames(seed);
+		USBD_NCM_NtbReset(&ntb, Ntb, 0x800U + (seed % 3U) * 0x400U);
+		for(count = 0U; count < FRAME_NUM_MAX; count++)
+		{
+			if(USBD_NCM_NtbAppend(&ntb, Frames[count], FrameLen[count]) != USBD_OK)
+				break;
+		}
+		CHECK(count >= 1U);
+		CHECK(count <= NCM_MAX_DATAGRAMS);
+		length = USBD_NCM_NtbFinish(&ntb, (uint16_t)seed);
+		CHECK(length <= ntb.Size);
+
+		RxCount = 0U;
+		RxMatch = 1U;
+		CHECK_EQ(USBD_NCM_NtbParse(Ntb, length, RxFrame), count);
+		CHECK_EQ(RxCount, count);
+		CHECK(RxMatch);
+	}
+}
+
+/* 帧数达到NCM_MAX_DATAGRAMS后拒绝追加 */
+static void TestDatagramLimit(void)
+{
+	USBD_NCM_NtbTypeDef ntb;
+	uint8_t frame[14] = {0};
+	uint32_t i;
+
+	USBD_NCM_NtbReset(&ntb, Ntb, sizeof(Ntb));
+	for(i = 0U; i < NCM_MAX_DATAGRAMS; i++)
+		CHECK_EQ(USBD_NCM_NtbAppend(&ntb, frame, sizeof(frame)), USBD_OK);
+	CHECK_EQ(USBD_NCM_NtbAppend(&ntb, frame, sizeof(frame)), USBD_BUSY);
+}
+
+/* 主机构造的错误NTB */
+static void TestMalformed(void)
+{
+	USBD_NCM_NtbTypeDef ntb;
+	uint32_t length, ndp, cut;
+	static uint8_t bad[NCM_NTB_IN_SIZE];
+
+	MakeFrames(7U);
+	USBD_NCM_NtbReset(&ntb, Ntb, sizeof(Ntb));
+	(void)USBD_NCM_NtbAppend(&ntb, Frames[0], 100U);
+	(void)USBD_NCM_NtbAppend(&ntb, Frames[1], 200U);
+	length = USBD_NCM_NtbFinish(&ntb, 1U);
+	ndp = Get16(&Ntb[10]);
+
+	/* 任意截断都不会越界读取 */
+	for(cut = 0U; cut < length; cut++)
+		CHECK_EQ(USBD_NCM_NtbParse(Ntb, cut, NULL), -1);
+
+	/* 签名错误 */
+	memcpy(bad, Ntb, length);
+	bad[0] ^= 1U;
+	CHECK_EQ(USBD_NCM_NtbParse(bad, length, NULL), -1);
+	memcpy(bad, Ntb, length);
+	bad[ndp] ^= 1U;
+	CHECK_EQ(USBD_NCM_NtbParse(bad, length, NULL), -1);
+
+	/* 帧超出块长度 */
+	memcpy(bad, Ntb, length);
+	Put16(&bad[ndp + 10U], (uint16_t)length);
+	CHECK_EQ(USBD_NCM_NtbParse(bad, length, NULL), -1);
+
+	/* NDP未对齐 */
+	memcpy(bad, Ntb, length);
+	Put16(&bad[10], (uint16_t)(ndp + 2U));
+	CHECK_EQ(USBD_NCM_NtbParse(bad, length, NULL), -1);
+
+	/* NDP指向自身形成环路，最多跟随8级 */
+	memcpy(bad, Ntb, length);
+	Put16(&bad[ndp + 6U], (uint16_t)ndp);
+	RxCount = 0U;
+	CHECK_EQ(USBD_NCM_NtbParse(bad, length, NULL), 2 * 8);
+
+	/* "NCM1"签名同样接受 */
+	memcpy(bad, Ntb, length);
+	bad[ndp + 3U] = '1';
+	CHECK_EQ(USBD_NCM_NtbParse(bad, length, NULL), 2);
+}
+
+int main(void)
+{
+	TestEncodeLayout();
+	TestRoundTrip();
+	TestDatagramLimit();
+	TestMalformed();
+
+	return TEST_RESULT("test_ncm");
+}